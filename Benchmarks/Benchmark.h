@@ -0,0 +1,202 @@
+﻿/**
+* \brief Вспомогательные средства замеров производительности
+* \details Замеры выполняются на headless-бэкенде (см. wquery::HeadlessBackend), поэтому результаты не зависят
+* от оконной системы и воспроизводимы на любой платформе
+*/
+
+#pragma once
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <chrono>
+#include <cstdio>
+
+namespace benchmarks
+{
+	/**
+	* \brief Записать результат замера в отчет (\see benchmarks::WriteReport)
+	* \param name Наименование замера
+	* \param value Значение
+	* \param unit Единица измерения (напр. "ns/iteration", "GB/s")
+	* \param iterations Кол-во повторений (0 - не применимо)
+	*/
+	void Report(const char* name, double value, const char* unit, size_t iterations = 0);
+
+	/**
+	* \brief Записать отчет в файл в формате JSON
+	* \details Результаты идут в порядке выполнения замеров, наименования замеров стабильны между версиями,
+	* поэтому отчеты разных версий можно сравнивать построчно
+	* \param path Путь к файлу
+	* \return Удалось ли записать файл
+	*/
+	bool WriteReport(const char* path);
+
+	/**
+	* \brief Выполнить замер
+	* \details Функция вызывается iterations раз, результат (среднее время одного вызова) выводится в консоль
+	* \param name Наименование замера
+	* \param iterations Кол-во повторений
+	* \param function Замеряемая функция (принимает номер повторения)
+	* \return Среднее время одного вызова в наносекундах
+	*/
+	template <typename F>
+	double Measure(const char* name, size_t iterations, F function)
+	{
+		// Прогрев (кеши, ленивые выделения памяти)
+		function(static_cast<size_t>(0));
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++) function(i);
+		const auto end = std::chrono::steady_clock::now();
+
+		const double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+		printf("%-32s %10zu iterations %14.1f ns/iteration\n", name, iterations, nanoseconds);
+		Report(name, nanoseconds, "ns/iteration", iterations);
+		return nanoseconds;
+	}
+
+	/**
+	* \brief Выполнить замер пропускной способности
+	* \details Как Measure, но результат выводится в гигабайтах (10^9 байт) входных данных в секунду
+	* \param name Наименование замера
+	* \param iterations Кол-во повторений
+	* \param bytes Объем входных данных одного вызова в байтах
+	* \param function Замеряемая функция (принимает номер повторения)
+	* \return Пропускная способность в ГБ/с
+	*/
+	template <typename F>
+	double MeasureThroughput(const char* name, size_t iterations, size_t bytes, F function)
+	{
+		function(static_cast<size_t>(0));
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++) function(i);
+		const auto end = std::chrono::steady_clock::now();
+
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		const double gigabytesPerSecond = static_cast<double>(bytes) * static_cast<double>(iterations) / seconds / 1e9;
+		printf("%-32s %10zu iterations %14.2f GB/s\n", name, iterations, gigabytesPerSecond);
+		Report(name, gigabytesPerSecond, "GB/s", iterations);
+		return gigabytesPerSecond;
+	}
+
+	/**
+	* \brief Выполнить замер скорости обработки пикселей
+	* \details Как Measure, но результат выводится в мегапикселях (10^6 пикселей) в секунду
+	* \param name Наименование замера
+	* \param iterations Кол-во повторений
+	* \param pixels Кол-во пикселей, обрабатываемых одним вызовом
+	* \param function Замеряемая функция (принимает номер повторения)
+	* \return Скорость в Мп/с
+	*/
+	template <typename F>
+	double MeasurePixels(const char* name, size_t iterations, size_t pixels, F function)
+	{
+		function(static_cast<size_t>(0));
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++) function(i);
+		const auto end = std::chrono::steady_clock::now();
+
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		const double megapixelsPerSecond = static_cast<double>(pixels) * static_cast<double>(iterations) / seconds / 1e6;
+		printf("%-32s %10zu iterations %14.1f MP/s\n", name, iterations, megapixelsPerSecond);
+		Report(name, megapixelsPerSecond, "MP/s", iterations);
+		return megapixelsPerSecond;
+	}
+
+	/**
+	* \brief Замеры пересчета раскладки и поиска элемента по точке (10 000 элементов)
+	*/
+	void RunLayoutBenchmarks();
+
+	/**
+	* \brief Замеры кеша графических объектов (200 элементов с одинаковым шрифтом, перерисовка фона)
+	*/
+	void RunGdiBenchmarks();
+
+	/**
+	* \brief Замеры перекодирования UTF-8 <-> UTF-16 (ГБ/с) для каждого поддерживаемого набора инструкций
+	* и функций преобразования строк интерфейса (StrToWide, WideToStr, CharToWide)
+	*/
+	void RunTextBenchmarks();
+
+	/**
+	* \brief Замеры колеса таймеров (запуск, отмена и срабатывание 10 000 таймеров)
+	*/
+	void RunTimerBenchmarks();
+
+	/**
+	* \brief Замеры передачи задач в поток основного цикла (1, 4 и 16 потоков-производителей)
+	*/
+	void RunPostBenchmarks();
+
+	/**
+	* \brief Замеры сопрограмм (10 000 задач, ожидание вложенной задачи и следующей итерации цикла)
+	*/
+	void RunCoroutineBenchmarks();
+
+	/**
+	* \brief Замеры сигналов событий (вызов, подписка и отписка, занимаемая элементами память)
+	*/
+	void RunEventBenchmarks();
+
+	/**
+	* \brief Замеры доставки движений мыши (10 000 движений, обработчик 5 мкс, по одному и с объединением)
+	*/
+	void RunInputBenchmarks();
+
+	/**
+	* \brief Замеры холста (примитивы на 1280x720, полная и частичная перерисовка окна через onPaint)
+	*/
+	void RunCanvasBenchmarks();
+
+	/**
+	* \brief Замеры растровых функций (Мп/с) для каждого поддерживаемого набора инструкций
+	*/
+	void RunRasterBenchmarks();
+
+	/**
+	* \brief Замеры рисования текста через кеш символов (перерисовка неизменных надписей, разложение, растеризация)
+	*/
+	void RunGlyphBenchmarks();
+
+	/**
+	* \brief Замеры создания формы с 1000 элементов (загрузка бинарного описания против создания кодом)
+	*/
+	void RunFormBenchmarks();
+
+	/**
+	* \brief Замеры запуска окна с 1000 элементов (отложенное создание системных объектов против немедленного)
+	*/
+	void RunStartupBenchmarks();
+
+	/**
+	* \brief Замеры окна с 10 000 элементов (элементы без системного окна против обычных)
+	*/
+	void RunWindowlessBenchmarks();
+
+	/**
+	* \brief Замеры прокрутки таблицы с 10 000 000 строк (время кадра: прокрутка и перерисовка окна)
+	*/
+	void RunGridBenchmarks();
+
+	/**
+	* \brief Замеры правки документа на 50 МБ (поле ввода в режиме документа против системного поля ввода)
+	*/
+	void RunDocumentBenchmarks();
+
+	/**
+	* \brief Замеры потокового журнала (скорость приема строк из фоновых потоков, перерисовки и потолок памяти)
+	*/
+	void RunLogBenchmarks();
+
+	/**
+	* \brief Замеры инструментирования (цена обработки сообщения, записи в гистограмму и замера участка)
+	*/
+	void RunInstrumentationBenchmarks();
+
+	/**
+	* \brief Замеры обработки сообщений (WM_COMMAND, вызов обработчиков событий, цена итерации основного цикла)
+	*/
+	void RunDispatchBenchmarks();
+}
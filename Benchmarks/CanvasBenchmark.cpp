@@ -0,0 +1,87 @@
+﻿/**
+* \brief Замеры программного холста и вывода заднего буфера окна
+*/
+
+#include "Benchmark.h"
+
+#define CANVAS_WIDTH 1280
+#define CANVAS_HEIGHT 720
+#define CANVAS_RECTS 1000
+
+namespace benchmarks
+{
+	/**
+	* \brief Замеры холста (примитивы на 1280x720, полная и частичная перерисовка окна через onPaint)
+	*/
+	void RunCanvasBenchmarks()
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+
+		wquery::Canvas canvas;
+		canvas.Resize({ CANVAS_WIDTH, CANVAS_HEIGHT });
+
+		// Заливка всего холста (пропускная способность записи в буфер)
+		MeasureThroughput("canvas/clear", 1000, CANVAS_WIDTH * CANVAS_HEIGHT * sizeof(std::uint32_t), [&](size_t i)
+		{
+			canvas.Clear(wquery::ColorRGB(static_cast<unsigned char>(i), 0, 0));
+		});
+
+		// Мелкие прямоугольники (типичное содержимое окна: фоны элементов, рамки)
+		Measure("canvas/fill-rects", 1000, [&](size_t i)
+		{
+			for (int r = 0; r < CANVAS_RECTS; r++)
+			{
+				const int x = (r * 97 + static_cast<int>(i)) % (CANVAS_WIDTH - 64);
+				const int y = (r * 53) % (CANVAS_HEIGHT - 32);
+				canvas.FillRect({ x, y, x + 64, y + 32 }, wquery::ColorRGB(static_cast<unsigned char>(r), 128, 64));
+			}
+		});
+
+		// Наклонные отрезки
+		Measure("canvas/lines", 1000, [&](size_t i)
+		{
+			for (int r = 0; r < CANVAS_RECTS; r++) {
+				canvas.DrawLine({ r % CANVAS_WIDTH, 0 }, { (r * 7 + static_cast<int>(i)) % CANVAS_WIDTH, CANVAS_HEIGHT - 1 }, wquery::ColorRGB(0, 0, 0));
+			}
+		});
+
+		wquery::Window window;
+		window.SetSize({ CANVAS_WIDTH, CANVAS_HEIGHT }, true);
+		window.Show();
+
+		size_t painted = 0;
+		window.events.onPaint.Connect([&](wquery::Canvas& target, const wquery::DirtyRegion&)
+		{
+			for (int r = 0; r < CANVAS_RECTS; r++)
+			{
+				const int x = (r * 97) % (CANVAS_WIDTH - 64);
+				const int y = (r * 53) % (CANVAS_HEIGHT - 32);
+				target.FillRect({ x, y, x + 64, y + 32 }, wquery::ColorRGB(static_cast<unsigned char>(r), 128, 64));
+			}
+			painted++;
+		});
+
+		window.Invalidate();
+		wquery::Window::FlushPaint();
+		const std::uint32_t* buffer = window.GetCanvas().GetPixels();
+
+		// Перерисовка всего окна: стирание фона, рисование и вывод буфера одним копированием
+		Measure("canvas/window-full-paint", 1000, [&](size_t)
+		{
+			window.Invalidate();
+			wquery::Window::FlushPaint();
+		});
+
+		// Перерисовка небольшой области: стирается и выводится только она, рисование вне ее отсекается
+		Measure("canvas/window-partial-paint", 1000, [&](size_t i)
+		{
+			const int x = static_cast<int>(i % 32) * 32;
+			window.Invalidate({ x, 100, x + 32, 132 });
+			wquery::Window::FlushPaint();
+		});
+
+		const wquery::HeadlessBackend::Node* node = backend.FindNode(window.GetNativeHandle());
+		printf("(paints %zu, presents %u, back buffer reallocated %s)\n",
+			painted, node ? node->presents : 0, buffer == window.GetCanvas().GetPixels() ? "no" : "yes");
+	}
+}
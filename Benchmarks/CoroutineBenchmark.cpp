@@ -0,0 +1,61 @@
+﻿/**
+* \brief Замеры сопрограмм (создание задач, продолжение на следующей итерации цикла)
+*/
+
+#include "Benchmark.h"
+
+#define COROUTINE_COUNT 10000
+
+namespace benchmarks
+{
+	/**
+	* \brief Вложенная задача (кадр выделяется из пула при каждом вызове)
+	* \param value Значение
+	* \return Задача
+	*/
+	static wquery::Task<int> Increment(int value)
+	{
+		co_return value + 1;
+	}
+
+	/**
+	* \brief Задача, ожидающая вложенную задачу
+	* \param counter Счетчик
+	* \return Задача
+	*/
+	static wquery::Task<> Accumulate(size_t& counter)
+	{
+		counter += static_cast<size_t>(co_await Increment(0));
+	}
+
+	/**
+	* \brief Задача, ожидающая следующую итерацию цикла заданное кол-во раз
+	* \param frames Кол-во итераций
+	* \param counter Счетчик
+	* \return Задача
+	*/
+	static wquery::Task<> WaitFrames(unsigned int frames, size_t& counter)
+	{
+		for (unsigned int i = 0; i < frames; i++) co_await wquery::NextFrame();
+		counter++;
+	}
+
+	/**
+	* \brief Замеры сопрограмм (10 000 задач, ожидание вложенной задачи и следующей итерации цикла)
+	*/
+	void RunCoroutineBenchmarks()
+	{
+		size_t counter = 0;
+
+		Measure("coroutine/spawn-await", 100, [&](size_t)
+		{
+			for (size_t i = 0; i < COROUTINE_COUNT; i++) wquery::Spawn(Accumulate(counter));
+		});
+
+		Measure("coroutine/next-frame", 100, [&](size_t)
+		{
+			for (size_t i = 0; i < COROUTINE_COUNT; i++) wquery::Spawn(WaitFrames(4, counter));
+			while (wquery::HasPendingCoroutines(true)) wquery::ResumePendingCoroutines(true);
+		});
+	}
+}
@@ -0,0 +1,94 @@
+﻿/**
+* \brief Замеры обработки сообщений (WM_COMMAND, вызов обработчиков событий, цена итерации основного цикла)
+*/
+
+#include "Benchmark.h"
+
+#define DISPATCH_ITERATIONS 1000000
+#define LOOP_ITERATIONS 1000000
+
+namespace benchmarks
+{
+	/**
+	* \brief Замерить итерации основного цикла
+	* \param name Наименование замера
+	* \param loopType Тип цикла
+	* \param postMessage Передавать ли сообщение окну на каждой итерации (иначе блокирующий цикл уснет)
+	*/
+	static void MeasureLoop(const char* name, wquery::MainLoopType loopType, bool postMessage)
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+		wquery::Window window;
+		const HWND hWnd = window.GetNativeHandle();
+		size_t iterations = 0;
+
+		if (postMessage) backend.Post(hWnd, WM_NULL, 0, 0);
+
+		const auto start = std::chrono::steady_clock::now();
+		wquery::End(loopType, [&](wquery::Window*)
+		{
+			if (++iterations == LOOP_ITERATIONS) backend.PostQuit(0);
+			else if (postMessage) backend.Post(hWnd, WM_NULL, 0, 0);
+		});
+		const auto end = std::chrono::steady_clock::now();
+
+		const double nanoseconds = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+		printf("%-32s %10zu iterations %14.1f ns/iteration\n", name, iterations, nanoseconds);
+		Report(name, nanoseconds, "ns/iteration", iterations);
+	}
+
+	/**
+	* \brief Замеры обработки сообщений (WM_COMMAND, вызов обработчиков событий, цена итерации основного цикла)
+	*/
+	void RunDispatchBenchmarks()
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+		wquery::Window window;
+		wquery::Button button(&window);
+		const HWND hWnd = window.GetNativeHandle();
+		const LPARAM buttonHandle = reinterpret_cast<LPARAM>(button.GetNativeHandle());
+
+		size_t clicks = 0;
+		button.events.onClicked.Connect([&clicks]() { clicks++; });
+
+		// Уведомление элемента: оконная процедура -> поиск обработчика по коду и типу элемента -> сигнал
+		Measure("dispatch/wm-command-send", DISPATCH_ITERATIONS, [&](size_t)
+		{
+			backend.Send(hWnd, WM_COMMAND, MAKEWPARAM(0, BN_CLICKED), buttonHandle);
+		});
+
+		// То же через очередь сообщений (постановка, извлечение, передача)
+		MSG msg = {};
+		Measure("dispatch/wm-command-posted", DISPATCH_ITERATIONS, [&](size_t)
+		{
+			backend.Post(hWnd, WM_COMMAND, MAKEWPARAM(0, BN_CLICKED), buttonHandle);
+			while (backend.PeekNextMessage(&msg)) backend.Dispatch(&msg);
+		});
+
+		// Вызов обработчиков события окна (разница с замером без обработчиков - цена вызова)
+		size_t keys = 0;
+		Measure("dispatch/keydown-0-handlers", DISPATCH_ITERATIONS, [&](size_t)
+		{
+			backend.Send(hWnd, WM_KEYDOWN, 'A', 0);
+		});
+
+		window.events.onKeyDown.Connect([&keys](WPARAM) { keys++; });
+		Measure("dispatch/keydown-1-handler", DISPATCH_ITERATIONS, [&](size_t)
+		{
+			backend.Send(hWnd, WM_KEYDOWN, 'A', 0);
+		});
+
+		for (int i = 1; i < 8; i++) window.events.onKeyDown.Connect([&keys](WPARAM) { keys++; });
+		Measure("dispatch/keydown-8-handlers", DISPATCH_ITERATIONS, [&](size_t)
+		{
+			backend.Send(hWnd, WM_KEYDOWN, 'A', 0);
+		});
+
+		printf("(clicks %zu, key handler calls %zu)\n", clicks, keys);
+
+		// Цена итерации основного цикла (без сообщений и с одним сообщением на итерацию)
+		MeasureLoop("loop/peek-idle-iteration", wquery::MainLoopType::PEEK_MSG, false);
+		MeasureLoop("loop/peek-message-iteration", wquery::MainLoopType::PEEK_MSG, true);
+		MeasureLoop("loop/get-message-iteration", wquery::MainLoopType::GET_MSG, true);
+	}
+}
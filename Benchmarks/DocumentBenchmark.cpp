@@ -0,0 +1,146 @@
+﻿/**
+* \brief Замеры правки документа на 50 МБ (поле ввода в режиме документа против системного поля ввода)
+*/
+
+#include "Benchmark.h"
+#include <random>
+
+#define DOCUMENT_LINES 1000000
+#define DOCUMENT_EDITS 10000
+#define DOCUMENT_COPY_EDITS 20
+
+namespace benchmarks
+{
+	/**
+	* \brief Обработать очередь сообщений
+	*/
+	static void DispatchPending()
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+
+		MSG msg;
+		while (backend.PeekNextMessage(&msg)) backend.Dispatch(&msg);
+	}
+
+	/**
+	* \brief Нажать клавишу и обработать очередь сообщений
+	* \param window Окно
+	* \param code Код клавиши
+	* \param symbol Символ (0 - клавиша без символа)
+	*/
+	static void PressKey(wquery::Window& window, unsigned int code, char symbol)
+	{
+		static_cast<wquery::HeadlessBackend&>(wquery::GetBackend()).SimulateKey(window.GetNativeHandle(), code, symbol);
+		DispatchPending();
+	}
+
+	/**
+	* \brief Сформировать текст документа (строки журнала по ~50 байт)
+	* \return Текст
+	*/
+	static std::string MakeDocumentText()
+	{
+		std::string text;
+		text.reserve(static_cast<size_t>(DOCUMENT_LINES) * 56);
+
+		char buffer[64];
+		for (size_t i = 0; i < DOCUMENT_LINES; i++)
+		{
+			const int length = snprintf(buffer, sizeof(buffer), "%08zu INFO  worker-%02zu processed request %06zu\r\n", i, i % 16, (i * 7919) % 1000000);
+			text.append(buffer, static_cast<size_t>(length));
+		}
+
+		return text;
+	}
+
+	/**
+	* \brief Замеры правки документа на 50 МБ (поле ввода в режиме документа против системного поля ввода)
+	*/
+	void RunDocumentBenchmarks()
+	{
+		wquery::Window window;
+		window.SetSize({ 1280, 800 }, true);
+
+		wquery::ControlState state;
+		state.size = { 1280, 800 };
+
+		const std::string source = MakeDocumentText();
+		printf("document/size %zu bytes, %d lines\n", source.length(), DOCUMENT_LINES);
+
+		// Подписчик оповещений читает только правку (как подсветка синтаксиса или счетчик изменений)
+		size_t changed = 0;
+		size_t edited = 0;
+
+		{
+			wquery::TextBox document(&window, state, wquery::TextBoxMode::DOCUMENT);
+			document.events.onChanged.Connect([&changed]() { changed++; });
+			document.events.onEdited.Connect([&edited](const wquery::TextEdit& edit) { edited += edit.inserted + edit.erased; });
+
+			window.Show();
+			wquery::Window::FlushPaint();
+
+			Measure("document/load", 1, [&](size_t)
+			{
+				document.LoadText(std::string(source));
+			});
+
+			// Набор текста с клавиатуры в середине документа: символ и перерисовка (строка на кадр, перевод строки -
+			// каждые 64 символа, он перерисовывает строки до конца поля)
+			auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+			backend.SimulateMouse(window.GetNativeHandle(), WM_MOUSEMOVE, 10, 10);
+			backend.SimulateMouse(window.GetNativeHandle(), WM_LBUTTONDOWN, 10, 10);
+			backend.SimulateMouse(window.GetNativeHandle(), WM_LBUTTONUP, 10, 10);
+			DispatchPending();
+
+			document.SetCaret(document.GetDocument()->GetLineStart(DOCUMENT_LINES / 2));
+			wquery::Window::FlushPaint();
+
+			Measure("document/type-middle", DOCUMENT_EDITS, [&](size_t i)
+			{
+				if ((i % 64) == 63) PressKey(window, VK_RETURN, '\r');
+				else PressKey(window, 'X', 'x');
+				wquery::Window::FlushPaint();
+			});
+
+			Measure("document/backspace-middle", DOCUMENT_EDITS, [&](size_t)
+			{
+				PressKey(window, VK_BACK, '\b');
+				wquery::Window::FlushPaint();
+			});
+
+			// Вставки в случайные места (каждая - новый фрагмент таблицы)
+			std::mt19937_64 random(42);
+			Measure("document/insert-random", DOCUMENT_EDITS, [&](size_t)
+			{
+				document.InsertText(static_cast<size_t>(random() % document.GetTextLength()), "inserted\r\n");
+			});
+
+			Measure("document/append-line", DOCUMENT_EDITS, [&](size_t)
+			{
+				document.AppendText("00000000 INFO  appended line\r\n");
+			});
+
+			// Кадр после перехода в случайное место документа (извлекаются только видимые строки)
+			Measure("document/viewport-jump", DOCUMENT_EDITS / 10, [&](size_t)
+			{
+				document.SetFirstLine(static_cast<size_t>(random() % DOCUMENT_LINES));
+				wquery::Window::FlushPaint();
+			});
+
+			printf("document/pieces %zu, notifications %zu, edited bytes %zu\n", document.GetDocument()->GetPieceCount(), changed, edited);
+		}
+
+		// Системное поле ввода: правка - это чтение и запись всего текста
+		{
+			wquery::TextBox edit(&window, state);
+			edit.events.onChanged.Connect([&changed]() { changed++; });
+			edit.SetText(source);
+
+			const size_t middle = source.length() / 2;
+			Measure("edit/type-middle", DOCUMENT_COPY_EDITS, [&](size_t i)
+			{
+				edit.InsertText(middle + i, "x");
+			});
+		}
+	}
+}
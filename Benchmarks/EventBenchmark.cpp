@@ -0,0 +1,80 @@
+﻿/**
+* \brief Замеры сигналов событий (вызов, подписка и отписка, занимаемая элементами память)
+*/
+
+#include "Benchmark.h"
+
+#define EVENT_EMIT_COUNT 100000
+#define EVENT_CONNECTION_COUNT 10000
+#define EVENT_FORM_CONTROLS 5000
+
+namespace benchmarks
+{
+	/**
+	* \brief Вывести размер объекта с сигналами и размер того же объекта, если бы события хранились в std::function
+	* \param name Наименование
+	* \param size Размер объекта
+	* \param events Размер набора сигналов объекта
+	* \param eventCount Кол-во событий в наборе
+	*/
+	static void PrintFootprint(const char* name, size_t size, size_t events, size_t eventCount)
+	{
+		const size_t before = size - events + eventCount * sizeof(std::function<void()>);
+		printf("%-32s %10zu bytes (std::function events: %zu bytes)\n", name, size, before);
+		Report(name, static_cast<double>(size), "bytes");
+	}
+
+	/**
+	* \brief Замеры сигналов событий (вызов, подписка и отписка, занимаемая элементами память)
+	*/
+	void RunEventBenchmarks()
+	{
+		wquery::Button* button = nullptr;
+		wquery::TextBox* textBox = nullptr;
+		wquery::Window* window = nullptr;
+
+		// Память на элемент без подписчиков (пустой сигнал - один указатель, std::function - 32 байта в libstdc++ и 64 в MSVC)
+		PrintFootprint("events/window-footprint", sizeof(*window), sizeof(window->events), 9);
+		PrintFootprint("events/button-footprint", sizeof(*button), sizeof(button->events), 1);
+		PrintFootprint("events/textbox-footprint", sizeof(*textBox), sizeof(textBox->events), 2);
+
+		const size_t form = EVENT_FORM_CONTROLS * (sizeof(*button) + sizeof(*textBox));
+		const size_t formEvents = EVENT_FORM_CONTROLS * (sizeof(button->events) + sizeof(textBox->events));
+		PrintFootprint("events/form-5k-buttons-textboxes", form, formEvents, EVENT_FORM_CONTROLS * 3);
+
+		size_t counter = 0;
+		wquery::Signal<void(int)> signal;
+		std::function<void(int)> function = [&counter](int value) { counter += static_cast<size_t>(value); };
+
+		Measure("events/std-function-emit-100k", 100, [&](size_t)
+		{
+			for (int i = 0; i < EVENT_EMIT_COUNT; i++) function(i);
+		});
+
+		signal.Connect([&counter](int value) { counter += static_cast<size_t>(value); });
+		Measure("events/signal-1-emit-100k", 100, [&](size_t)
+		{
+			for (int i = 0; i < EVENT_EMIT_COUNT; i++) signal(i);
+		});
+
+		for (int s = 1; s < 8; s++) signal.Connect([&counter](int value) { counter += static_cast<size_t>(value); });
+		Measure("events/signal-8-emit-100k", 100, [&](size_t)
+		{
+			for (int i = 0; i < EVENT_EMIT_COUNT; i++) signal(i);
+		});
+
+		// Подписка и отписка в произвольном порядке (ячейки переиспользуются, память после прогрева не выделяется)
+		std::vector<wquery::ConnectionId> ids(EVENT_CONNECTION_COUNT);
+		Measure("events/connect-disconnect-10k", 200, [&](size_t)
+		{
+			for (size_t c = 0; c < EVENT_CONNECTION_COUNT; c++) {
+				ids[c] = signal.Connect([&counter](int value) { counter += static_cast<size_t>(value); });
+			}
+			for (size_t c = 0; c < EVENT_CONNECTION_COUNT; c++) {
+				signal.Disconnect(ids[(c * 7919) % EVENT_CONNECTION_COUNT]);
+			}
+		});
+
+		printf("(counter %zu)\n", counter);
+	}
+}
@@ -0,0 +1,97 @@
+﻿/**
+* \brief Замеры создания формы с 1000 элементов (бинарное описание против кода)
+*/
+
+#include "Benchmark.h"
+
+#define FORM_CONTROLS 1000
+#define FORM_FILE "form-benchmark.wqf"
+
+namespace benchmarks
+{
+	/**
+	* \brief Замеры создания формы с 1000 элементов (бинарное описание против кода)
+	*/
+	void RunFormBenchmarks()
+	{
+		// Текстовое описание: сетка 20x50 кнопок и полей ввода с привязкой, двумя шрифтами и текстом
+		std::string source = "window \"Form benchmark\" size 1600 1000 min 640 480 color 240 240 240 hidden\n"
+			"font regular \"Segoe UI\" 12\n"
+			"font bold \"Segoe UI\" 12 bold\n";
+
+		for (int i = 0; i < FORM_CONTROLS; i++)
+		{
+			const int x = (i % 20) * 80, y = (i / 20) * 20;
+			const bool isButton = (i & 1) == 0;
+			source += isButton ? "button" : "textbox";
+			source += " control" + std::to_string(i) + " \"Item " + std::to_string(i) + "\" at " + std::to_string(x) + " " + std::to_string(y)
+				+ " size 76 18 anchor left top font " + (isButton ? "bold" : "regular") + "\n";
+		}
+
+		std::vector<unsigned char> binary;
+		std::string error;
+		if (!wquery::CompileForm(source, binary, error))
+		{
+			printf("form: compilation failed (%s)\n", error.c_str());
+			return;
+		}
+
+		std::ofstream file(FORM_FILE, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+		file.close();
+
+		Measure("form/compile-1000", 100, [&](size_t)
+		{
+			std::vector<unsigned char> compiled;
+			std::string message;
+			wquery::CompileForm(source, compiled, message);
+		});
+
+		// Создание из файла, отображенного в память: элементы создаются сразу с начальным состоянием
+		Measure("form/load-file-1000", 100, [&](size_t)
+		{
+			wquery::Form form;
+			form.Load(FORM_FILE);
+		});
+
+		Measure("form/load-memory-1000", 100, [&](size_t)
+		{
+			wquery::Form form;
+			form.Load(binary.data(), binary.size());
+		});
+
+		// Тот же набор элементов, созданный кодом: создание по умолчанию и установка каждого свойства отдельно
+		const wquery::FontSettings regular("Segoe UI", 12);
+		const wquery::FontSettings bold("Segoe UI", 12, true);
+
+		Measure("form/code-1000", 100, [&](size_t)
+		{
+			wquery::Window window;
+			window.SetTitle("Form benchmark");
+			window.SetSize({ 1600, 1000 }, true);
+			window.SetMinSizes({ 640, 480 }, true);
+			window.SetBgColor(wquery::ColorRGB(240, 240, 240));
+
+			std::vector<std::unique_ptr<wquery::ControlBase>> controls;
+			controls.reserve(FORM_CONTROLS);
+
+			for (int i = 0; i < FORM_CONTROLS; i++)
+			{
+				const bool isButton = (i & 1) == 0;
+				wquery::ControlBase* control = isButton
+					? static_cast<wquery::ControlBase*>(new wquery::Button(&window))
+					: static_cast<wquery::ControlBase*>(new wquery::TextBox(&window));
+				controls.emplace_back(control);
+
+				control->SetPosition({ (i % 20) * 80, (i / 20) * 20 });
+				control->SetSize({ 76, 18 });
+				control->SetAnchor(wquery::AnchorSettings(true, true));
+				control->SetFont(isButton ? bold : regular);
+				control->SetText("Item " + std::to_string(i));
+			}
+		});
+
+		std::remove(FORM_FILE);
+		printf("(binary size %zu bytes, source size %zu bytes)\n", binary.size(), source.size());
+	}
+}
@@ -0,0 +1,64 @@
+﻿/**
+* \brief Замеры кеша графических объектов (кисти и шрифты) и отложенной перерисовки
+*/
+
+#include "Benchmark.h"
+
+#define SHARED_FONT_CONTROLS 200
+
+namespace benchmarks
+{
+	/**
+	* \brief Замеры кеша графических объектов (200 элементов с одинаковым шрифтом, перерисовка фона)
+	*/
+	void RunGdiBenchmarks()
+	{
+		wquery::GdiCache& cache = wquery::GetGdiCache();
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+
+		wquery::Window window;
+		window.Show();
+
+		std::vector<std::unique_ptr<wquery::Button>> buttons;
+		for (size_t i = 0; i < SHARED_FONT_CONTROLS; i++) {
+			buttons.emplace_back(new wquery::Button(&window));
+		}
+
+		cache.ResetStatistics();
+
+		// Установка одинакового шрифта всем элементам: объект шрифта создается один раз
+		Measure("gdi/set-shared-font", 100, [&](size_t i)
+		{
+			const wquery::FontSettings font("Consolas", 12 + static_cast<unsigned int>(i & 1));
+			for (auto& button : buttons) button->SetFont(font);
+		});
+
+		// Изменение размеров всех элементов и перерисовка в конце итерации: запросы объединяются в одну перерисовку окна
+		wquery::Window::FlushPaint();
+		const wquery::PaintStatistics paintBefore = wquery::Window::GetPaintStatistics();
+		Measure("gdi/property-burst-paint", 1000, [&](size_t i)
+		{
+			const int size = 20 + static_cast<int>(i & 7);
+			for (auto& button : buttons) button->SetSize({ size, size });
+			wquery::Window::FlushPaint();
+		});
+
+		const wquery::PaintStatistics& paintAfter = wquery::Window::GetPaintStatistics();
+		printf("(invalidations %llu, paints %llu, repaints avoided %llu, rects merged %llu)\n",
+			paintAfter.invalidations - paintBefore.invalidations, paintAfter.paints - paintBefore.paints,
+			paintAfter.repaintsAvoided - paintBefore.repaintsAvoided, paintAfter.rectsMerged - paintBefore.rectsMerged);
+
+		// Стирание фона окна: кисть фона берется из кеша однократно
+		Measure("gdi/erase-background", 10000, [&](size_t)
+		{
+			backend.Invalidate(window.GetNativeHandle(), nullptr, true);
+			MSG msg = {};
+			while (backend.PeekNextMessage(&msg)) backend.Dispatch(&msg);
+		});
+
+		const wquery::GdiCacheStatistics statistics = cache.GetStatistics();
+		printf("(font hits %zu, font misses %zu, brush hits %zu, brush misses %zu, live fonts %zu, live brushes %zu, backend objects %zu)\n",
+			statistics.fontHits, statistics.fontMisses, statistics.brushHits, statistics.brushMisses,
+			statistics.liveFonts, statistics.liveBrushes, backend.GetObjectCount());
+	}
+}
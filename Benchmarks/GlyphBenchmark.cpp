@@ -0,0 +1,62 @@
+﻿/**
+* \brief Замеры рисования текста через кеш символов
+*/
+
+#include "Benchmark.h"
+
+#define GLYPH_LABELS 50
+
+namespace benchmarks
+{
+	/**
+	* \brief Замеры рисования текста через кеш символов (перерисовка неизменных надписей, разложение, растеризация)
+	*/
+	void RunGlyphBenchmarks()
+	{
+		wquery::GlyphCache& cache = wquery::GetGlyphCache();
+		const wquery::FontSettings font("Segoe UI", 16);
+
+		wquery::Canvas canvas;
+		canvas.Resize({ 800, 600 });
+		canvas.Clear(wquery::ColorRGB(255, 255, 255));
+
+		// Надписи типичного окна: разные строки, один шрифт
+		std::vector<std::string> labels;
+		for (int i = 0; i < GLYPH_LABELS; i++) labels.push_back("Label #" + std::to_string(i) + ": Value");
+
+		auto drawLabels = [&]()
+		{
+			for (int i = 0; i < GLYPH_LABELS; i++) {
+				canvas.DrawString(labels[i], font, { 10 + (i % 4) * 190, 10 + (i / 4) * 40 }, wquery::ColorRGB(0, 0, 0));
+			}
+		};
+
+		// Перерисовка неизменных надписей: строки и символы берутся из кеша, остаются только наложения масок
+		cache.ResetStatistics();
+		Measure("glyph/labels-redraw", 2000, [&](size_t)
+		{
+			drawLabels();
+		});
+
+		wquery::GlyphCacheStatistics statistics = cache.GetStatistics();
+		printf("  run hits: %zu, run misses: %zu, glyph misses: %zu\n", statistics.runHits, statistics.runMisses, statistics.glyphMisses);
+
+		// Кеш строк на одну запись: каждая надпись заново раскладывается на символы (символы - из атласа)
+		cache.SetRunCapacity(1);
+		Measure("glyph/labels-reshape", 2000, [&](size_t)
+		{
+			drawLabels();
+		});
+		cache.SetRunCapacity(wquery::GlyphCache::DEFAULT_RUN_CAPACITY);
+
+		// Без кеша: атлас создается и символы растеризуются бэкендом при каждом рисовании
+		Measure("glyph/labels-cold", 200, [&](size_t)
+		{
+			cache.Clear();
+			drawLabels();
+		});
+
+		statistics = cache.GetStatistics();
+		printf("  atlases: %zu, atlas bytes: %zu\n", statistics.atlases, statistics.atlasBytes);
+	}
+}
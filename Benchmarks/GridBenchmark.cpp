@@ -0,0 +1,127 @@
+﻿/**
+* \brief Замеры прокрутки таблицы с 10 000 000 строк (время кадра: прокрутка и перерисовка окна)
+*/
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <random>
+
+#define GRID_ROWS 10000000
+#define GRID_FRAMES 1000
+
+namespace benchmarks
+{
+	/**
+	* \brief Прогнать кадры прокрутки и вывести распределение времени кадра
+	* \param name Наименование замера
+	* \param grid Таблица
+	* \param requests Счетчик запросов строк у источника данных
+	* \param scroll Прокрутка перед кадром (принимает номер кадра)
+	*/
+	template <typename F>
+	static void MeasureFrames(const char* name, wquery::Grid& grid, const size_t& requests, F scroll)
+	{
+		std::vector<double> frames(GRID_FRAMES);
+		const size_t requestsBefore = requests;
+
+		for (size_t i = 0; i < GRID_FRAMES; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			scroll(i);
+			wquery::Window::FlushPaint();
+			frames[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		double total = 0.0;
+		for (double frame : frames) total += frame;
+		std::sort(frames.begin(), frames.end());
+
+		printf("%-32s %10d frames  avg %7.3f  p50 %7.3f  p99 %7.3f  max %7.3f ms  (%.1f rows/frame, first row %zu)\n",
+			name, GRID_FRAMES,
+			total / GRID_FRAMES,
+			frames[GRID_FRAMES / 2],
+			frames[GRID_FRAMES * 99 / 100],
+			frames[GRID_FRAMES - 1],
+			static_cast<double>(requests - requestsBefore) / GRID_FRAMES,
+			grid.GetFirstRow());
+
+		Report(name, total / GRID_FRAMES, "ms/frame", GRID_FRAMES);
+		Report((std::string(name) + "/p99").c_str(), frames[GRID_FRAMES * 99 / 100], "ms/frame", GRID_FRAMES);
+	}
+
+	/**
+	* \brief Замеры прокрутки таблицы с 10 000 000 строк (время кадра: прокрутка и перерисовка окна)
+	*/
+	void RunGridBenchmarks()
+	{
+		wquery::Window window;
+		window.SetSize({ 1280, 800 }, true);
+
+		wquery::ControlState state;
+		state.size = { 1280, 800 };
+		wquery::Grid grid(&window, state);
+
+		grid.AddColumn("Id", 100);
+		grid.AddColumn("Symbol", 120);
+		grid.AddColumn("Side", 80);
+		grid.AddColumn("Price", 140);
+		grid.AddColumn("Quantity", 140);
+		grid.AddColumn("Trader", 200);
+
+		// Источник данных формирует строки на лету (как запрос к хранилищу сделок)
+		size_t requests = 0;
+		grid.SetDataSource([&requests](size_t row, std::vector<std::string>& cells)
+		{
+			char buffer[32];
+			requests++;
+
+			snprintf(buffer, sizeof(buffer), "%zu", row);
+			cells[0] = buffer;
+			snprintf(buffer, sizeof(buffer), "SYM%03zu", row % 997);
+			cells[1] = buffer;
+			cells[2] = (row & 1) ? "SELL" : "BUY";
+			snprintf(buffer, sizeof(buffer), "%zu.%02zu", 100 + row % 9000, row % 100);
+			cells[3] = buffer;
+			snprintf(buffer, sizeof(buffer), "%zu", (row * 7919) % 100000);
+			cells[4] = buffer;
+			snprintf(buffer, sizeof(buffer), "trader-%zu", row % 313);
+			cells[5] = buffer;
+		});
+
+		grid.SetRowCount(GRID_ROWS);
+		window.Show();
+		wquery::Window::FlushPaint();
+
+		const size_t visibleRows = grid.GetVisibleRowCount();
+		printf("grid/rows %d, visible %zu\n", GRID_ROWS, visibleRows);
+
+		// Прокрутка на строку (колесо с плавной прокруткой) - запрашивается одна строка на кадр
+		MeasureFrames("grid/scroll-line-top", grid, requests, [&](size_t)
+		{
+			grid.ScrollBy(1);
+		});
+
+		// То же в конце таблицы - время кадра не зависит от положения и кол-ва строк
+		grid.SetFirstRow(GRID_ROWS - visibleRows - GRID_FRAMES);
+		wquery::Window::FlushPaint();
+		MeasureFrames("grid/scroll-line-bottom", grid, requests, [&](size_t)
+		{
+			grid.ScrollBy(1);
+		});
+
+		// Постраничная прокрутка - запрашиваются все видимые строки
+		grid.SetFirstRow(0);
+		wquery::Window::FlushPaint();
+		MeasureFrames("grid/scroll-page", grid, requests, [&](size_t)
+		{
+			grid.ScrollBy(static_cast<long long>(visibleRows));
+		});
+
+		// Переходы в случайные места таблицы (перемещение ползунка)
+		std::mt19937_64 random(42);
+		MeasureFrames("grid/jump-random", grid, requests, [&](size_t)
+		{
+			grid.SetFirstRow(static_cast<size_t>(random() % GRID_ROWS));
+		});
+	}
+}
@@ -0,0 +1,56 @@
+﻿/**
+* \brief Замеры доставки движений мыши (по одному сообщению и с объединением)
+*/
+
+#include "Benchmark.h"
+
+#define INPUT_MOVE_COUNT 10000
+#define INPUT_HANDLER_MICROSECONDS 5
+
+namespace benchmarks
+{
+	/**
+	* \brief Прогнать поток движений мыши через основной цикл
+	* \param coalescing Объединять ли движения
+	*/
+	static void MeasureMouseFlood(bool coalescing)
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+		wquery::Window window;
+		window.SetMouseCoalescing(coalescing);
+
+		// "Дорогой" обработчик (например перерисовка панели рисования), последнее движение закрывает окно
+		const wquery::Vector2D<int> last((INPUT_MOVE_COUNT - 1) % 640, (INPUT_MOVE_COUNT - 1) / 640);
+		size_t handled = 0;
+		window.events.onMouseMove.Connect([&](wquery::Vector2D<int> cursor)
+		{
+			const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(INPUT_HANDLER_MICROSECONDS);
+			while (std::chrono::steady_clock::now() < until) {}
+			handled++;
+
+			if (cursor.X == last.X && cursor.Y == last.Y) backend.SimulateClose(window.GetNativeHandle());
+		});
+
+		for (int i = 0; i < INPUT_MOVE_COUNT; i++) {
+			backend.SimulateMouse(window.GetNativeHandle(), WM_MOUSEMOVE, i % 640, i / 640);
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		wquery::End(wquery::MainLoopType::GET_MSG);
+		const auto end = std::chrono::steady_clock::now();
+
+		const char* name = coalescing ? "input/mouse-flood-coalesced" : "input/mouse-flood-per-message";
+		const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+		printf("%-32s %10d moves %14.2f ms (%zu handler calls)\n", name, INPUT_MOVE_COUNT, milliseconds, handled);
+		Report(name, milliseconds, "ms", INPUT_MOVE_COUNT);
+	}
+
+	/**
+	* \brief Замеры доставки движений мыши (10 000 движений, обработчик 5 мкс, по одному и с объединением)
+	*/
+	void RunInputBenchmarks()
+	{
+		MeasureMouseFlood(false);
+		MeasureMouseFlood(true);
+	}
+}
@@ -0,0 +1,91 @@
+﻿/**
+* \brief Замеры инструментирования (цена обработки сообщения, записи в гистограмму и замера участка)
+* \details Цена обработки сообщения сравнивается между сборками с WQUERY_INSTRUMENTATION и без него,
+* в сборке с инструментированием дополнительно выводится снимок статистики
+*/
+
+#include "Benchmark.h"
+
+#define INSTRUMENTATION_ITERATIONS 1000000
+
+namespace benchmarks
+{
+	/**
+	* \brief Вывести сводку гистограммы
+	* \param name Наименование
+	* \param summary Сводка
+	*/
+	static void PrintSummary(const char* name, const wquery::LatencySummary& summary)
+	{
+		printf("  %-20s %10llu  mean %9.2f  p50 %9.2f  p90 %9.2f  p99 %9.2f  p99.9 %9.2f  max %9.2f us\n",
+			name, summary.count, summary.mean, summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+	}
+
+	/**
+	* \brief Замеры инструментирования (цена обработки сообщения, записи в гистограмму и замера участка)
+	*/
+	void RunInstrumentationBenchmarks()
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+		wquery::Window window;
+		window.SetSize({ 640, 480 }, true);
+		window.Show();
+		wquery::Window::FlushPaint();
+
+		size_t keys = 0;
+		window.events.onKeyDown.Connect([&keys](WPARAM) { keys++; });
+		const HWND hWnd = window.GetNativeHandle();
+
+		printf("instrumentation %s\n", wquery::IsInstrumentationEnabled() ? "enabled" : "disabled");
+		wquery::ResetInstrumentation();
+
+		MSG msg = {};
+		Measure("instrumentation/dispatch-keydown", INSTRUMENTATION_ITERATIONS, [&](size_t)
+		{
+			backend.Post(hWnd, WM_KEYDOWN, 'A', 0);
+			while (backend.PeekNextMessage(&msg)) backend.Dispatch(&msg);
+		});
+
+		Measure("instrumentation/dispatch-mousemove", INSTRUMENTATION_ITERATIONS, [&](size_t i)
+		{
+			backend.Post(hWnd, WM_MOUSEMOVE, 0, MAKELPARAM(i % 640, i % 480));
+			while (backend.PeekNextMessage(&msg)) backend.Dispatch(&msg);
+		});
+
+		// Цена самих средств замера (не зависит от WQUERY_INSTRUMENTATION)
+		wquery::LatencyHistogram histogram;
+		Measure("instrumentation/histogram-record", INSTRUMENTATION_ITERATIONS, [&histogram](size_t i)
+		{
+			histogram.Record((i * 2654435761ull) % 1000000);
+		});
+
+		Measure("instrumentation/section-timer", INSTRUMENTATION_ITERATIONS, [](size_t)
+		{
+			wquery::SectionTimer timer(wquery::INSTRUMENTED_LOOP_CALLBACK);
+		});
+
+		if (!wquery::IsInstrumentationEnabled()) return;
+
+		wquery::InstrumentationSnapshot snapshot;
+		wquery::GetInstrumentationSnapshot(snapshot);
+
+		printf("instrumentation/messages (dispatch time)\n");
+		for (const wquery::MessageStatistics& statistics : snapshot.messages)
+		{
+			const char* name = wquery::GetInstrumentedMessageName(statistics.message);
+			char code[16];
+			snprintf(code, sizeof(code), "0x%04X", statistics.message);
+			PrintSummary(name ? name : code, statistics.dispatch);
+		}
+
+		printf("instrumentation/sections\n");
+		for (unsigned int i = 0; i < wquery::INSTRUMENTED_SECTION_COUNT; i++)
+		{
+			if (snapshot.sections[i].count == 0) continue;
+			PrintSummary(wquery::GetInstrumentedSectionName(static_cast<wquery::InstrumentedSection>(i)), snapshot.sections[i]);
+		}
+
+		printf("instrumentation/input-latency\n");
+		PrintSummary("all input", snapshot.inputLatency);
+	}
+}
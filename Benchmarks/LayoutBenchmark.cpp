@@ -0,0 +1,196 @@
+﻿/**
+* \brief Замеры пересчета раскладки и поиска элемента по точке
+*/
+
+#include "Benchmark.h"
+
+#define CONTROL_COUNT 10000
+
+namespace benchmarks
+{
+	/**
+	* \brief Элемент в представлении "массив структур" (для сравнения с хранилищем геометрии)
+	*/
+	struct ControlRecord
+	{
+		wquery::AnchorSettings anchor;
+		wquery::Vector2D<int> position;
+		wquery::Vector2D<int> size;
+	};
+
+	/**
+	* \brief Объект элемента прежней раскладки: геометрия хранилась в самом объекте элемента, объекты создавались
+	* по отдельности и обходились по списку указателей окна (размер объекта - как у кнопки)
+	*/
+	struct ControlObject
+	{
+		HWND hWnd;
+		wquery::AnchorSettings anchor;
+		wquery::Vector2D<int> position;
+		wquery::Vector2D<int> size;
+		unsigned char state[sizeof(wquery::Button) - sizeof(ControlRecord) - sizeof(HWND)];
+	};
+
+	/**
+	* \brief Привязка i-го элемента (все варианты по кругу)
+	* \param i Номер элемента
+	* \return Параметры привязки
+	*/
+	static wquery::AnchorSettings AnchorFor(size_t i)
+	{
+		return wquery::AnchorSettings((i & 1) != 0, (i & 2) != 0, (i & 4) != 0, (i & 8) != 0);
+	}
+
+	/**
+	* \brief Применить привязку к одному элементу (прежний способ раскладки - отдельно для каждого элемента)
+	* \param anchor Параметры привязки
+	* \param sizingDelta Изменение размеров клиентской области контейнера
+	* \param position Положение элемента (изменяется)
+	* \param size Размеры элемента (изменяются)
+	* \return Изменилось ли положение или размеры
+	*/
+	static bool ApplyAnchor(const wquery::AnchorSettings& anchor, const wquery::Vector2D<int>& sizingDelta, wquery::Vector2D<int>& position, wquery::Vector2D<int>& size)
+	{
+		bool changed = false;
+
+		// Привязка к обеим сторонам растягивает элемент, привязка только к правой (нижней) - перемещает
+		if (anchor.left && anchor.right) {
+			size.X += sizingDelta.X;
+			changed = changed || sizingDelta.X != 0;
+		}
+		else if (anchor.right) {
+			position.X += sizingDelta.X;
+			changed = changed || sizingDelta.X != 0;
+		}
+
+		if (anchor.top && anchor.bottom) {
+			size.Y += sizingDelta.Y;
+			changed = changed || sizingDelta.Y != 0;
+		}
+		else if (anchor.bottom) {
+			position.Y += sizingDelta.Y;
+			changed = changed || sizingDelta.Y != 0;
+		}
+
+		return changed;
+	}
+
+	/**
+	* \brief Замеры пересчета раскладки и поиска элемента по точке (10 000 элементов)
+	*/
+	void RunLayoutBenchmarks()
+	{
+		// Изменение размеров чередуется, чтобы геометрия не "уплывала" между повторениями
+		auto delta = [](size_t i) { return (i & 1) ? wquery::Vector2D<int>(-3, -2) : wquery::Vector2D<int>(3, 2); };
+
+		std::vector<ControlRecord> records(CONTROL_COUNT);
+		for (size_t i = 0; i < records.size(); i++)
+		{
+			records[i].anchor = AnchorFor(i);
+			records[i].position = { static_cast<int>(i % 100) * 8, static_cast<int>(i / 100) * 8 };
+			records[i].size = { 8, 8 };
+		}
+
+		// Прежняя раскладка (до хранилища геометрии): обход объектов элементов по указателям, изменившиеся
+		// прямоугольники собираются в пакет (хендлы, положения, размеры)
+		std::vector<std::unique_ptr<ControlObject>> objects;
+		for (size_t i = 0; i < CONTROL_COUNT; i++)
+		{
+			objects.emplace_back(new ControlObject());
+			objects.back()->anchor = records[i].anchor;
+			objects.back()->position = records[i].position;
+			objects.back()->size = records[i].size;
+		}
+
+		std::vector<HWND> batchHandles;
+		std::vector<wquery::Vector2D<int>> batchPositions;
+		std::vector<wquery::Vector2D<int>> batchSizes;
+		Measure("layout/pointer-chasing", 1000, [&](size_t i)
+		{
+			const wquery::Vector2D<int> sizingDelta = delta(i);
+			batchHandles.clear();
+			batchPositions.clear();
+			batchSizes.clear();
+
+			for (const std::unique_ptr<ControlObject>& object : objects)
+			{
+				wquery::Vector2D<int> position = object->position;
+				wquery::Vector2D<int> size = object->size;
+				if (!ApplyAnchor(object->anchor, sizingDelta, position, size)) continue;
+
+				object->position = position;
+				object->size = size;
+				batchHandles.push_back(object->hWnd);
+				batchPositions.push_back(position);
+				batchSizes.push_back(size);
+			}
+		});
+
+		// Массив структур: тот же результат, что у хранилища геометрии (идентификаторы изменившихся элементов)
+		std::vector<unsigned int> changedRecords;
+		Measure("layout/array-of-structs", 1000, [&](size_t i)
+		{
+			const wquery::Vector2D<int> sizingDelta = delta(i);
+			changedRecords.clear();
+
+			for (size_t id = 0; id < records.size(); id++)
+			{
+				ControlRecord& record = records[id];
+				if (ApplyAnchor(record.anchor, sizingDelta, record.position, record.size)) changedRecords.push_back(static_cast<unsigned int>(id));
+			}
+		});
+
+		// Хранилище геометрии (структура массивов) без обращений к бэкенду
+		wquery::GeometryStore store;
+		std::vector<unsigned int> changed;
+		for (size_t i = 0; i < CONTROL_COUNT; i++)
+		{
+			const unsigned int id = store.Add(nullptr, nullptr, records[i].position, records[i].size);
+			store.SetAnchor(id, records[i].anchor);
+		}
+
+		Measure("layout/geometry-store", 1000, [&](size_t i)
+		{
+			changed.clear();
+			store.Layout(delta(i), changed);
+		});
+
+		// Полный путь: WM_SIZE -> Window::LayoutControls -> пакетное перемещение через бэкенд
+		wquery::Window window;
+		window.SetSize({ 800, 800 }, true);
+
+		std::vector<std::unique_ptr<wquery::Button>> buttons;
+		buttons.reserve(CONTROL_COUNT);
+		for (size_t i = 0; i < CONTROL_COUNT; i++)
+		{
+			buttons.emplace_back(new wquery::Button(&window));
+			buttons.back()->SetPosition(records[i].position);
+			buttons.back()->SetSize(records[i].size);
+			buttons.back()->SetAnchor(records[i].anchor);
+		}
+
+		Measure("layout/window-relayout", 100, [&](size_t i)
+		{
+			const wquery::Vector2D<int> sizingDelta = delta(i);
+			const wquery::Vector2D<int> size = window.GetSize(true);
+			window.SetSize({ size.X + sizingDelta.X, size.Y + sizingDelta.Y }, true);
+		});
+
+		// Поиск элемента по точке (проход по массивам в обратном порядке)
+		size_t hits = 0;
+		Measure("hittest/geometry-store", 10000, [&](size_t i)
+		{
+			const wquery::Vector2D<int> point(static_cast<int>((i * 7919) % 800), static_cast<int>((i * 104729) % 800));
+			if (window.GetControlAt(point)) hits++;
+		});
+
+		// Уничтожение всех элементов в порядке создания (каждое удаление - из начала хранилища геометрии)
+		const auto teardownStart = std::chrono::steady_clock::now();
+		buttons.clear();
+		const double teardown = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - teardownStart).count();
+		printf("%-32s %10u controls %16.3f ms\n", "layout/window-teardown", CONTROL_COUNT, teardown);
+		Report("layout/window-teardown", teardown, "ms", CONTROL_COUNT);
+
+		printf("(changed %zu/%zu/%zu, hits %zu)\n", batchHandles.size(), changedRecords.size(), changed.size(), hits);
+	}
+}
@@ -0,0 +1,155 @@
+﻿/**
+* \brief Замеры потокового журнала (скорость приема строк из фоновых потоков, перерисовки и потолок памяти)
+*/
+
+#include "Benchmark.h"
+#include <thread>
+
+#define LOG_LINES_PER_THREAD 500000
+#define LOG_CONCAT_LINES 5000
+
+namespace benchmarks
+{
+	/**
+	* \brief Прогнать поток строк из нескольких потоков через журнал в цикле с частотой 60 кадров
+	* \param threadCount Кол-во потоков-производителей
+	*/
+	static void MeasureIngest(size_t threadCount)
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+		wquery::Window window;
+		window.SetSize({ 1280, 800 }, true);
+
+		wquery::ControlState state;
+		state.size = { 1280, 800 };
+		wquery::LogView log(&window, state);
+		window.Show();
+		wquery::Window::FlushPaint();
+
+		const unsigned long long total = static_cast<unsigned long long>(threadCount) * LOG_LINES_PER_THREAD;
+		const unsigned long long paintsBefore = wquery::Window::GetPaintStatistics().paints;
+		size_t peakMemory = log.GetMemoryUsage();
+		size_t frames = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> producers;
+		for (size_t t = 0; t < threadCount; t++)
+		{
+			producers.emplace_back([&log, t]()
+			{
+				char buffer[128];
+				for (size_t i = 0; i < LOG_LINES_PER_THREAD; i++)
+				{
+					const int length = snprintf(buffer, sizeof(buffer), "%08zu worker-%02zu INFO request %06zu completed in %zu us\r\n", i, t, (i * 7919) % 1000000, i % 977);
+					log.AppendLine(std::string_view(buffer, static_cast<size_t>(length)));
+				}
+			});
+		}
+
+		// Функция кадра отслеживает память и завершает цикл, когда разобраны все строки
+		wquery::SetFrameLoopSettings(wquery::FrameLoopSettings(60));
+		wquery::End(wquery::MainLoopType::FRAME_PACED, [&](wquery::Window*)
+		{
+			frames++;
+			peakMemory = (std::max)(peakMemory, log.GetMemoryUsage());
+			if (log.GetTotalLineCount() == total) backend.PostQuit(0);
+		});
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for (std::thread& producer : producers) producer.join();
+
+		const unsigned long long paints = wquery::Window::GetPaintStatistics().paints - paintsBefore;
+		printf("log/ingest-%zu-threads %14.0f lines/s %8zu frames %8llu paints %10.0f lines/paint  peak %6.2f MB  (%zu lines kept, %llu dropped)\n",
+			threadCount,
+			static_cast<double>(total) / seconds,
+			frames,
+			paints,
+			static_cast<double>(total) / static_cast<double>((std::max)(paints, 1ull)),
+			static_cast<double>(peakMemory) / (1024.0 * 1024.0),
+			log.GetLineCount(),
+			log.GetDroppedLineCount());
+
+		char name[64];
+		snprintf(name, sizeof(name), "log/ingest-%zu-threads", threadCount);
+		Report(name, static_cast<double>(total) / seconds, "lines/s", static_cast<size_t>(total));
+		snprintf(name, sizeof(name), "log/ingest-%zu-threads/peak-memory", threadCount);
+		Report(name, static_cast<double>(peakMemory) / (1024.0 * 1024.0), "MB");
+	}
+
+	/**
+	* \brief Перегрузка: производители добавляют строки, пока основной цикл не разбирает очередь
+	* \details Входящая очередь ограничена емкостью колец журнала, поэтому память журнала не превышает
+	* потолок, сколько бы строк ни пришло - лишние строки отбрасываются
+	* \param threadCount Кол-во потоков-производителей
+	*/
+	static void MeasureOverload(size_t threadCount)
+	{
+		wquery::Window window;
+		wquery::LogView log(&window);
+
+		const unsigned long long total = static_cast<unsigned long long>(threadCount) * LOG_LINES_PER_THREAD;
+		size_t peakMemory = log.GetMemoryUsage();
+
+		std::vector<std::thread> producers;
+		for (size_t t = 0; t < threadCount; t++)
+		{
+			producers.emplace_back([&log, t]()
+			{
+				char buffer[128];
+				for (size_t i = 0; i < LOG_LINES_PER_THREAD; i++)
+				{
+					const int length = snprintf(buffer, sizeof(buffer), "%08zu worker-%02zu INFO request %06zu completed in %zu us", i, t, (i * 7919) % 1000000, i % 977);
+					log.AppendLine(std::string_view(buffer, static_cast<size_t>(length)));
+				}
+			});
+		}
+
+		for (std::thread& producer : producers) producer.join();
+		peakMemory = (std::max)(peakMemory, log.GetMemoryUsage());
+		const unsigned long long rejected = log.GetDroppedLineCount();
+
+		log.Flush();
+
+		printf("log/overload-%zu-threads  ceiling %6.2f MB  (%llu of %llu lines rejected by the inbox, %zu kept)\n",
+			threadCount,
+			static_cast<double>(peakMemory) / (1024.0 * 1024.0),
+			rejected,
+			total,
+			log.GetLineCount());
+
+		char name[64];
+		snprintf(name, sizeof(name), "log/overload-%zu-threads/ceiling", threadCount);
+		Report(name, static_cast<double>(peakMemory) / (1024.0 * 1024.0), "MB");
+		snprintf(name, sizeof(name), "log/overload-%zu-threads/rejected", threadCount);
+		Report(name, static_cast<double>(rejected), "lines", static_cast<size_t>(total));
+	}
+
+	/**
+	* \brief Замеры потокового журнала (скорость приема строк из фоновых потоков, перерисовки и потолок памяти)
+	*/
+	void RunLogBenchmarks()
+	{
+		MeasureIngest(1);
+		MeasureIngest(4);
+		MeasureOverload(4);
+
+		// Для сравнения: дописывание в поле ввода через чтение и запись всего текста (квадратичная сложность)
+		wquery::Window window;
+		wquery::TextBox textBox(&window);
+		std::string text;
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < LOG_CONCAT_LINES; i++)
+		{
+			textBox.GetText(text);
+			text += "00000000 worker-00 INFO request 000000 completed in 0 us\r\n";
+			textBox.SetText(text);
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		printf("log/textbox-concat-%d %14.0f lines/s  (%.2f MB of text)\n", LOG_CONCAT_LINES,
+			LOG_CONCAT_LINES / seconds, static_cast<double>(text.length()) / (1024.0 * 1024.0));
+		Report("log/textbox-concat", LOG_CONCAT_LINES / seconds, "lines/s", LOG_CONCAT_LINES);
+	}
+}
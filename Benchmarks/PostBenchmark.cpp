@@ -0,0 +1,64 @@
+﻿/**
+* \brief Замеры передачи задач в поток основного цикла
+*/
+
+#include "Benchmark.h"
+#include <thread>
+
+#define POST_TASKS_PER_PRODUCER 200000
+
+namespace benchmarks
+{
+	/**
+	* \brief Передать задачи из нескольких потоков и дождаться их выполнения основным циклом
+	* \param producers Кол-во потоков-производителей
+	*/
+	static void MeasurePost(unsigned int producers)
+	{
+		auto& backend = static_cast<wquery::HeadlessBackend&>(wquery::GetBackend());
+		const size_t total = static_cast<size_t>(producers) * POST_TASKS_PER_PRODUCER;
+
+		wquery::Window window;
+		size_t executed = 0;
+		size_t messages = 0;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> threads;
+		for (unsigned int p = 0; p < producers; p++)
+		{
+			threads.emplace_back([&]()
+			{
+				for (size_t i = 0; i < POST_TASKS_PER_PRODUCER; i++)
+				{
+					wquery::Post([&]()
+					{
+						if (++executed == total) backend.SimulateClose(window.GetNativeHandle());
+					});
+				}
+			});
+		}
+
+		// Кол-во итераций блокирующего цикла равно кол-ву обработанных сообщений (пробуждений)
+		wquery::End(wquery::MainLoopType::GET_MSG, [&](wquery::Window*) { messages++; });
+
+		for (auto& thread : threads) thread.join();
+		const auto end = std::chrono::steady_clock::now();
+
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		char name[64];
+		snprintf(name, sizeof(name), "post/%u-producers", producers);
+		printf("%-32s %10zu tasks %15.2f Mtasks/s (%zu loop messages)\n", name, total, static_cast<double>(total) / seconds / 1e6, messages);
+		Report(name, static_cast<double>(total) / seconds / 1e6, "Mtasks/s", total);
+	}
+
+	/**
+	* \brief Замеры передачи задач в поток основного цикла (1, 4 и 16 потоков-производителей)
+	*/
+	void RunPostBenchmarks()
+	{
+		MeasurePost(1);
+		MeasurePost(4);
+		MeasurePost(16);
+	}
+}
@@ -0,0 +1,84 @@
+﻿#include "Benchmark.h"
+#include <cstring>
+
+/**
+* \brief Группа замеров
+*/
+struct BenchmarkGroup
+{
+	const char* name;                      // Наименование (для выбора в командной строке)
+	void (*run)();                         // Функция замеров
+};
+
+/**
+* \brief Запуск замеров
+* \details Аргументы: наименования групп (без них выполняются все группы) и "--json <файл>" для записи
+* отчета в формате JSON (для сравнения результатов между версиями)
+*/
+int main(int argc, char* argv[])
+{
+	const BenchmarkGroup groups[] = {
+		{ "layout", &benchmarks::RunLayoutBenchmarks },
+		{ "gdi", &benchmarks::RunGdiBenchmarks },
+		{ "text", &benchmarks::RunTextBenchmarks },
+		{ "timers", &benchmarks::RunTimerBenchmarks },
+		{ "post", &benchmarks::RunPostBenchmarks },
+		{ "coroutines", &benchmarks::RunCoroutineBenchmarks },
+		{ "events", &benchmarks::RunEventBenchmarks },
+		{ "input", &benchmarks::RunInputBenchmarks },
+		{ "canvas", &benchmarks::RunCanvasBenchmarks },
+		{ "raster", &benchmarks::RunRasterBenchmarks },
+		{ "glyph", &benchmarks::RunGlyphBenchmarks },
+		{ "form", &benchmarks::RunFormBenchmarks },
+		{ "startup", &benchmarks::RunStartupBenchmarks },
+		{ "windowless", &benchmarks::RunWindowlessBenchmarks },
+		{ "grid", &benchmarks::RunGridBenchmarks },
+		{ "document", &benchmarks::RunDocumentBenchmarks },
+		{ "log", &benchmarks::RunLogBenchmarks },
+		{ "instrumentation", &benchmarks::RunInstrumentationBenchmarks },
+		{ "dispatch", &benchmarks::RunDispatchBenchmarks }
+	};
+
+	const char* reportPath = nullptr;
+	std::vector<const char*> selected;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			reportPath = argv[++i];
+			continue;
+		}
+
+		bool known = false;
+		for (const BenchmarkGroup& group : groups) known = known || strcmp(group.name, argv[i]) == 0;
+
+		if (!known)
+		{
+			printf("Unknown benchmark group: %s\nGroups:", argv[i]);
+			for (const BenchmarkGroup& group : groups) printf(" %s", group.name);
+			printf("\nUsage: Benchmarks [group...] [--json <file>]\n");
+			return 1;
+		}
+
+		selected.push_back(argv[i]);
+	}
+
+	// Headless-бэкенд: 10 000 настоящих окон превысили бы лимит USER-объектов процесса,
+	// к тому же замеряется работа библиотеки, а не оконной системы
+	wquery::SetBackend(std::unique_ptr<wquery::Backend>(new wquery::HeadlessBackend()));
+	wquery::Begin();
+
+	for (const BenchmarkGroup& group : groups)
+	{
+		const bool run = selected.empty() || std::any_of(selected.begin(), selected.end(), [&group](const char* name) { return strcmp(group.name, name) == 0; });
+		if (run) group.run();
+	}
+
+	if (reportPath && !benchmarks::WriteReport(reportPath))
+	{
+		printf("Can't write report: %s\n", reportPath);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+﻿/**
+* \brief Замеры растровых функций (внутренних циклов рисования на холсте)
+*/
+
+#include "Benchmark.h"
+
+// Строка холста 1920 пикселей, 64 строки (буферы помещаются в кеш второго уровня)
+#define RASTER_WIDTH 1920
+#define RASTER_ROWS 64
+
+namespace benchmarks
+{
+	/**
+	* \brief Замеры растровых функций (Мп/с) для каждого поддерживаемого набора инструкций
+	*/
+	void RunRasterBenchmarks()
+	{
+		const size_t count = RASTER_WIDTH * RASTER_ROWS;
+		std::vector<std::uint32_t> target(count, 0x00202020);
+		std::vector<std::uint32_t> sprite(count);
+		std::vector<std::uint32_t> keyed(count);
+		std::vector<unsigned char> mask(count);
+
+		// Спрайт: непрозрачная середина, полупрозрачные края и пустой фон (типичное сглаженное изображение)
+		for (size_t i = 0; i < count; i++)
+		{
+			const size_t x = i % 64;
+			const unsigned char alpha = x < 8 ? 0 : (x < 16 || x >= 56 ? static_cast<unsigned char>(x * 4) : 255);
+			sprite[i] = wquery::ColorRGB(static_cast<unsigned char>(i), 180, 90, alpha).GetPremultiplied();
+			keyed[i] = x < 8 ? 0x00FF00FF : 0x00336699;
+			mask[i] = x < 8 ? 0 : static_cast<unsigned char>(x * 4);
+		}
+
+		const std::uint32_t translucent = wquery::ColorRGB(255, 128, 0, 96).GetPremultiplied();
+		const wquery::RasterKernel initialKernel = wquery::GetRasterKernel();
+		char name[64];
+
+		for (int k = wquery::RASTER_KERNEL_SCALAR; k <= wquery::RASTER_KERNEL_AVX2; k++)
+		{
+			const wquery::RasterKernel kernel = static_cast<wquery::RasterKernel>(k);
+			if (!wquery::SetRasterKernel(kernel)) continue;
+			const char* kernelName = wquery::GetRasterKernelName(kernel);
+
+			snprintf(name, sizeof(name), "raster/fill/%s", kernelName);
+			MeasurePixels(name, 2000, count, [&](size_t i)
+			{
+				for (size_t row = 0; row < RASTER_ROWS; row++) {
+					wquery::FillPixels(target.data() + row * RASTER_WIDTH, RASTER_WIDTH, static_cast<std::uint32_t>(i));
+				}
+			});
+
+			snprintf(name, sizeof(name), "raster/blend-solid/%s", kernelName);
+			MeasurePixels(name, 500, count, [&](size_t)
+			{
+				for (size_t row = 0; row < RASTER_ROWS; row++) {
+					wquery::BlendSolidPixels(target.data() + row * RASTER_WIDTH, RASTER_WIDTH, translucent);
+				}
+			});
+
+			snprintf(name, sizeof(name), "raster/blend-image/%s", kernelName);
+			MeasurePixels(name, 500, count, [&](size_t)
+			{
+				for (size_t row = 0; row < RASTER_ROWS; row++) {
+					wquery::BlendPixels(target.data() + row * RASTER_WIDTH, sprite.data() + row * RASTER_WIDTH, RASTER_WIDTH);
+				}
+			});
+
+			snprintf(name, sizeof(name), "raster/blend-mask/%s", kernelName);
+			MeasurePixels(name, 500, count, [&](size_t)
+			{
+				for (size_t row = 0; row < RASTER_ROWS; row++) {
+					wquery::BlendMaskPixels(target.data() + row * RASTER_WIDTH, mask.data() + row * RASTER_WIDTH, RASTER_WIDTH, translucent);
+				}
+			});
+
+			snprintf(name, sizeof(name), "raster/blit-keyed/%s", kernelName);
+			MeasurePixels(name, 1000, count, [&](size_t)
+			{
+				for (size_t row = 0; row < RASTER_ROWS; row++) {
+					wquery::CopyPixelsKeyed(target.data() + row * RASTER_WIDTH, keyed.data() + row * RASTER_WIDTH, RASTER_WIDTH, 0x00FF00FF);
+				}
+			});
+
+			snprintf(name, sizeof(name), "raster/gradient/%s", kernelName);
+			MeasurePixels(name, 1000, count, [&](size_t)
+			{
+				for (size_t row = 0; row < RASTER_ROWS; row++) {
+					wquery::GradientPixels(target.data() + row * RASTER_WIDTH, RASTER_WIDTH, 0x00103050, 0x00F0D0B0, 0, RASTER_WIDTH);
+				}
+			});
+		}
+
+		wquery::SetRasterKernel(initialKernel);
+	}
+}
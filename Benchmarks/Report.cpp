@@ -0,0 +1,100 @@
+﻿/**
+* \brief Отчет о замерах в формате JSON (для сравнения результатов между версиями)
+*/
+
+#include "Benchmark.h"
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+	/**
+	* \brief Результат замера
+	*/
+	struct ReportEntry
+	{
+		std::string name;                      // Наименование замера
+		double value;                          // Значение
+		std::string unit;                      // Единица измерения
+		size_t iterations;                     // Кол-во повторений (0 - не применимо)
+	};
+
+	/**
+	* \brief Результаты замеров (в порядке выполнения)
+	*/
+	static std::vector<ReportEntry> reportEntries_;
+
+	/**
+	* \brief Записать строку JSON (с экранированием)
+	* \param file Файл
+	* \param text Строка
+	*/
+	static void WriteJsonString(std::ofstream& file, const std::string& text)
+	{
+		file << '"';
+		for (const char symbol : text)
+		{
+			if (symbol == '"' || symbol == '\\') {
+				file << '\\' << symbol;
+			}
+			else if (static_cast<unsigned char>(symbol) < 0x20) {
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(symbol));
+				file << escaped;
+			}
+			else {
+				file << symbol;
+			}
+		}
+		file << '"';
+	}
+
+	/**
+	* \brief Записать результат замера в отчет
+	* \param name Наименование замера
+	* \param value Значение
+	* \param unit Единица измерения
+	* \param iterations Кол-во повторений
+	*/
+	void Report(const char* name, double value, const char* unit, size_t iterations)
+	{
+		reportEntries_.push_back({ name, value, unit, iterations });
+	}
+
+	/**
+	* \brief Записать отчет в файл в формате JSON
+	* \param path Путь к файлу
+	* \return Удалось ли записать файл
+	*/
+	bool WriteReport(const char* path)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file) return false;
+
+		file << "{\n";
+		file << "  \"format\": \"wquery-benchmarks\",\n";
+		file << "  \"version\": 1,\n";
+		file << "  \"instrumentation\": " << (wquery::IsInstrumentationEnabled() ? "true" : "false") << ",\n";
+		file << "  \"results\": [";
+
+		for (size_t i = 0; i < reportEntries_.size(); i++)
+		{
+			const ReportEntry& entry = reportEntries_[i];
+
+			// Значения без JSON-представления (бесконечность, NaN) записываются как null
+			char value[32] = "null";
+			if (std::isfinite(entry.value)) snprintf(value, sizeof(value), "%.6g", entry.value);
+
+			file << (i > 0 ? ",\n" : "\n") << "    { \"name\": ";
+			WriteJsonString(file, entry.name);
+			file << ", \"value\": " << value << ", \"unit\": ";
+			WriteJsonString(file, entry.unit);
+			file << ", \"iterations\": " << entry.iterations << " }";
+		}
+
+		file << "\n  ]\n}\n";
+		return static_cast<bool>(file);
+	}
+}
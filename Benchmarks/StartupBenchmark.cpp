@@ -0,0 +1,86 @@
+﻿/**
+* \brief Замеры запуска окна с 1000 элементов (отложенное создание системных объектов против немедленного)
+*/
+
+#include "Benchmark.h"
+
+#define STARTUP_CONTROLS 1000
+
+namespace benchmarks
+{
+	/**
+	* \brief Создать окно с элементами, настроить его и показать
+	* \param eager Создавать системные объекты сразу (обращением к хендлу после конструирования)
+	*/
+	static void RunStartup(bool eager)
+	{
+		const wquery::FontSettings font("Segoe UI", 12);
+
+		wquery::Window window;
+		if (eager) window.GetNativeHandle();
+
+		window.SetTitle("Startup benchmark");
+		window.SetSize({ 1600, 1000 }, true);
+		window.SetMinSizes({ 640, 480 }, true);
+
+		std::vector<std::unique_ptr<wquery::ControlBase>> controls;
+		controls.reserve(STARTUP_CONTROLS);
+
+		for (int i = 0; i < STARTUP_CONTROLS; i++)
+		{
+			wquery::ControlBase* control = (i & 1) == 0
+				? static_cast<wquery::ControlBase*>(new wquery::Button(&window))
+				: static_cast<wquery::ControlBase*>(new wquery::TextBox(&window));
+			controls.emplace_back(control);
+			if (eager) control->GetNativeHandle();
+
+			control->SetPosition({ (i % 20) * 80, (i / 20) * 20 });
+			control->SetSize({ 76, 18 });
+			control->SetAnchor(wquery::AnchorSettings(true, true, true, false));
+			control->SetFont(font);
+			control->SetText("Item " + std::to_string(i));
+		}
+
+		// Изменение размеров после добавления элементов (раскладка привязанных элементов)
+		window.SetSize({ 1280, 800 }, true);
+
+		window.Show();
+		wquery::Window::FlushPaint();
+	}
+
+	/**
+	* \brief Замеры запуска окна с 1000 элементов (отложенное создание системных объектов против немедленного)
+	*/
+	void RunStartupBenchmarks()
+	{
+		// Все свойства до показа только записываются, системные объекты создаются один раз при показе
+		Measure("startup/deferred-1000", 50, [&](size_t)
+		{
+			RunStartup(false);
+		});
+
+		// Каждое свойство передается уже созданному системному объекту
+		Measure("startup/eager-1000", 50, [&](size_t)
+		{
+			RunStartup(true);
+		});
+
+		// Разбивка одного запуска по этапам (время этапа - без вложенных этапов)
+		wquery::ResetStartupStatistics();
+		RunStartup(false);
+
+		const wquery::StartupStatistics& statistics = wquery::GetStartupStatistics();
+		for (int phase = 0; phase < wquery::STARTUP_PHASE_COUNT; phase++)
+		{
+			const char* phaseName = wquery::GetStartupPhaseName(static_cast<wquery::StartupPhase>(phase));
+			printf("startup/phase/%-24s %8.3f ms (%u)\n", phaseName, statistics.phaseTime[phase], statistics.phaseCount[phase]);
+			Report((std::string("startup/phase/") + phaseName).c_str(), statistics.phaseTime[phase], "ms", statistics.phaseCount[phase]);
+		}
+
+		printf("startup/first-show %8.3f ms, first-paint %8.3f ms\n",
+			statistics.eventTime[wquery::STARTUP_EVENT_FIRST_SHOW],
+			statistics.eventTime[wquery::STARTUP_EVENT_FIRST_PAINT]);
+		Report("startup/first-show", statistics.eventTime[wquery::STARTUP_EVENT_FIRST_SHOW], "ms");
+		Report("startup/first-paint", statistics.eventTime[wquery::STARTUP_EVENT_FIRST_PAINT], "ms");
+	}
+}
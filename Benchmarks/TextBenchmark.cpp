@@ -0,0 +1,107 @@
+﻿/**
+* \brief Замеры перекодирования UTF-8 <-> UTF-16 и функций преобразования строк интерфейса
+*/
+
+#include "Benchmark.h"
+
+#define TEXT_SIZE (1 << 20)
+#define TEXT_CHARACTERS 1024
+
+namespace benchmarks
+{
+	/**
+	* \brief Сформировать текст заданного объема повторением фрагмента
+	* \param fragment Фрагмент (UTF-8)
+	* \return Текст
+	*/
+	static std::string RepeatText(const char* fragment)
+	{
+		std::string text;
+		text.reserve(TEXT_SIZE + 64);
+		while (text.size() < TEXT_SIZE) text.append(fragment);
+		return text;
+	}
+
+	/**
+	* \brief Замеры перекодирования UTF-8 <-> UTF-16 (ГБ/с) для каждого поддерживаемого набора инструкций
+	* и функций преобразования строк интерфейса (StrToWide, WideToStr, CharToWide)
+	*/
+	void RunTextBenchmarks()
+	{
+		struct Sample
+		{
+			const char* name;
+			std::string utf8;
+		};
+
+		const Sample samples[] = {
+			{ "ascii", RepeatText("The quick brown fox jumps over the lazy dog. 0123456789 ") },
+			{ "cyrillic", RepeatText("\xD0\xA1\xD1\x8A\xD0\xB5\xD1\x88\xD1\x8C \xD0\xB6\xD0\xB5 \xD0\xB5\xD1\x89\xD1\x91 \xD1\x8D\xD1\x82\xD0\xB8\xD1\x85 \xD0\xBC\xD1\x8F\xD0\xB3\xD0\xBA\xD0\xB8\xD1\x85 \xD0\xB1\xD1\x83\xD0\xBB\xD0\xBE\xD0\xBA. ") },
+			{ "mixed", RepeatText("Window title: \xD0\x9E\xD0\xBA\xD0\xBD\xD0\xBE \xE2\x80\x94 \xE7\xAA\x97\xE5\x8F\xA3 \xF0\x9F\x98\x80 (c) 2019 darkoffalex; ") }
+		};
+
+		const wquery::UtfKernel initialKernel = wquery::GetUtfKernel();
+		char name[64];
+
+		for (int k = wquery::UTF_KERNEL_SCALAR; k <= wquery::UTF_KERNEL_AVX2; k++)
+		{
+			const wquery::UtfKernel kernel = static_cast<wquery::UtfKernel>(k);
+			if (!wquery::SetUtfKernel(kernel)) continue;
+
+			for (const Sample& sample : samples)
+			{
+				std::u16string utf16;
+				std::string utf8;
+				wquery::Utf8ToUtf16(sample.utf8, utf16);
+
+				// Объем считается по входным данным каждого направления
+				snprintf(name, sizeof(name), "utf8->utf16/%s/%s", sample.name, wquery::GetUtfKernelName(kernel));
+				MeasureThroughput(name, 200, sample.utf8.size(), [&](size_t)
+				{
+					wquery::Utf8ToUtf16(sample.utf8, utf16);
+				});
+
+				snprintf(name, sizeof(name), "utf16->utf8/%s/%s", sample.name, wquery::GetUtfKernelName(kernel));
+				MeasureThroughput(name, 200, utf16.size() * sizeof(char16_t), [&](size_t)
+				{
+					wquery::Utf16ToUtf8(utf16, utf8);
+				});
+			}
+		}
+
+		wquery::SetUtfKernel(initialKernel);
+
+		// Функции преобразования строк интерфейса (короткие строки: заголовки, надписи, текст элементов)
+		const std::string title = "Settings \xE2\x80\x94 \xD0\x9D\xD0\xB0\xD1\x81\xD1\x82\xD1\x80\xD0\xBE\xD0\xB9\xD0\xBA\xD0\xB8 (1/2)";
+		const std::wstring wideTitle = wquery::StrToWide(title, CP_UTF8);
+		size_t converted = 0;
+
+		Measure("text/str-to-wide", 100000, [&](size_t)
+		{
+			converted += wquery::StrToWide(title).size();
+		});
+
+		Measure("text/str-to-wide-utf8", 100000, [&](size_t)
+		{
+			converted += wquery::StrToWide(title, CP_UTF8).size();
+		});
+
+		Measure("text/wide-to-str", 100000, [&](size_t)
+		{
+			converted += wquery::WideToStr(wideTitle).size();
+		});
+
+		Measure("text/wide-to-str-utf8", 100000, [&](size_t)
+		{
+			converted += wquery::WideToStr(wideTitle, CP_UTF8).size();
+		});
+
+		// Посимвольное преобразование (ввод с клавиатуры, WM_CHAR)
+		Measure("text/char-to-wide-1k", 10000, [&](size_t)
+		{
+			for (int c = 0; c < TEXT_CHARACTERS; c++) converted += static_cast<size_t>(wquery::CharToWide(static_cast<char>(32 + c % 95)));
+		});
+
+		printf("(converted %zu)\n", converted);
+	}
+}
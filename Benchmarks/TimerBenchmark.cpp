@@ -0,0 +1,51 @@
+﻿/**
+* \brief Замеры колеса таймеров
+*/
+
+#include "Benchmark.h"
+
+#define TIMER_COUNT 10000
+
+namespace benchmarks
+{
+	/**
+	* \brief Замеры колеса таймеров (запуск, отмена и срабатывание 10 000 таймеров)
+	*/
+	void RunTimerBenchmarks()
+	{
+		wquery::TimerWheel wheel(0);
+		std::vector<wquery::TimerId> ids(TIMER_COUNT);
+		size_t fired = 0;
+
+		// Задержки от миллисекунд до минут (таймеры попадают на разные уровни колеса)
+		std::vector<unsigned long long> delays(TIMER_COUNT);
+		unsigned long long seed = 12345;
+		for (auto& delay : delays) {
+			seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+			delay = 1 + (seed >> 33) % (1u << (4 + (seed >> 20) % 14));
+		}
+
+		Measure("timers/schedule-cancel-10k", 200, [&](size_t)
+		{
+			for (size_t t = 0; t < TIMER_COUNT; t++) {
+				ids[t] = wheel.Schedule(wheel.GetTime() + delays[t], 0, nullptr);
+			}
+			for (size_t t = 0; t < TIMER_COUNT; t++) {
+				wheel.Cancel(ids[t]);
+			}
+		});
+
+		// Запуск и прогон времени до срабатывания всех таймеров
+		Measure("timers/schedule-fire-10k", 20, [&](size_t)
+		{
+			for (size_t t = 0; t < TIMER_COUNT; t++) {
+				wheel.Schedule(wheel.GetTime() + delays[t], 0, [&fired]() { fired++; });
+			}
+			while (wheel.GetCount() > 0) {
+				wheel.Advance(wheel.GetTime() + 16);
+			}
+		});
+
+		printf("(fired %zu, live timers %zu)\n", fired, wheel.GetCount());
+	}
+}
@@ -0,0 +1,78 @@
+﻿/**
+* \brief Замеры окна с 10 000 элементов (элементы без системного окна против обычных)
+*/
+
+#include "Benchmark.h"
+
+#define WINDOWLESS_CONTROLS 10000
+
+namespace benchmarks
+{
+	/**
+	* \brief Создать окно с элементами-индикаторами, показать и перерисовать его
+	* \param windowless Создавать элементы без системного окна
+	* \param handles Кол-во созданных системных объектов (включая само окно)
+	*/
+	static void RunWindowless(bool windowless, size_t& handles)
+	{
+		wquery::Window window;
+		window.SetTitle("Windowless benchmark");
+		window.SetSize({ 1600, 1000 }, true);
+
+		std::vector<std::unique_ptr<wquery::Button>> controls;
+		controls.reserve(WINDOWLESS_CONTROLS);
+
+		wquery::ControlState state;
+		state.size = { 14, 8 };
+		state.text = "";
+		state.windowless = windowless;
+
+		for (int i = 0; i < WINDOWLESS_CONTROLS; i++)
+		{
+			state.position = { (i % 100) * 16, (i / 100) * 10 };
+			controls.emplace_back(new wquery::Button(&window, state));
+		}
+
+		window.Show();
+		wquery::Window::FlushPaint();
+
+		// Изменение состояния части индикаторов (перерисовка только затронутой области)
+		for (int i = 0; i < WINDOWLESS_CONTROLS; i += 97)
+		{
+			controls[i]->SetEnabled(false);
+		}
+		wquery::Window::FlushPaint();
+
+		handles = window.IsCreated() ? 1 : 0;
+		for (const std::unique_ptr<wquery::Button>& control : controls)
+		{
+			if (control->IsCreated()) handles++;
+		}
+
+		// Элементы удаляются с конца (без сдвига идентификаторов остальных элементов окна)
+		while (!controls.empty()) controls.pop_back();
+	}
+
+	/**
+	* \brief Замеры окна с 10 000 элементов (элементы без системного окна против обычных)
+	*/
+	void RunWindowlessBenchmarks()
+	{
+		size_t windowlessHandles = 0;
+		size_t nativeHandles = 0;
+
+		// Элементы рисуются окном в его задний буфер, системный объект - только у окна
+		Measure("windowless/windowless-10000", 10, [&](size_t)
+		{
+			RunWindowless(true, windowlessHandles);
+		});
+
+		// У каждого элемента собственный системный объект
+		Measure("windowless/native-10000", 10, [&](size_t)
+		{
+			RunWindowless(false, nativeHandles);
+		});
+
+		printf("windowless/handles windowless %zu, native %zu\n", windowlessHandles, nativeHandles);
+	}
+}
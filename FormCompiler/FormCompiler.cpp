@@ -0,0 +1,50 @@
+﻿/**
+* \brief Компилятор текстового описания формы в бинарное (\see wquery::CompileForm, wquery::Form)
+* \details Использование: FormCompiler <текстовое описание> <бинарное описание>
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: FormCompiler <source> <output>\n");
+		return 2;
+	}
+
+	std::ifstream input(argv[1], std::ios::binary);
+	if (!input)
+	{
+		fprintf(stderr, "%s: can't open file\n", argv[1]);
+		return 1;
+	}
+
+	std::stringstream source;
+	source << input.rdbuf();
+
+	// Метка порядка байтов UTF-8 в начале описания пропускается
+	std::string text = source.str();
+	if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.erase(0, 3);
+
+	std::vector<unsigned char> binary;
+	std::string error;
+	if (!wquery::CompileForm(text, binary, error))
+	{
+		fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+		return 1;
+	}
+
+	std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+	output.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+	if (!output)
+	{
+		fprintf(stderr, "%s: can't write file\n", argv[2]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,240 @@
+﻿/**
+* \brief Фаззинг перекодирования UTF-8 <-> UTF-16
+* \details Каждый вход перекодируется всеми поддерживаемыми процессором наборами инструкций и сверяется
+* с независимой эталонной реализацией (корректность, результат, обратное перекодирование).
+* При сборке с libFuzzer (-fsanitize=fuzzer -DWQUERY_LIBFUZZER) используется точка входа LLVMFuzzerTestOneInput,
+* иначе собирается самостоятельная программа со своим генератором входных данных:
+* UtfFuzz [кол-во итераций] [начальное значение генератора]
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <random>
+
+/**
+* \brief Эталонное декодирование UTF-8 в последовательность кодовых точек
+* \details Намеренно устроено иначе, чем основная реализация: длина последовательности определяется
+* по первому байту, кодовая точка собирается целиком, затем проверяется минимальное значение для длины
+* \param data Исходные данные
+* \param size Длина
+* \param codePoints Результат
+* \return Корректны ли данные
+*/
+static bool ReferenceDecodeUtf8(const unsigned char* data, size_t size, std::vector<uint32_t>& codePoints)
+{
+	static const uint32_t minimum[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+
+	for (size_t i = 0; i < size;)
+	{
+		const unsigned char lead = data[i];
+		size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+		if (length == 0 || i + length > size) return false;
+
+		uint32_t codePoint = length == 1 ? lead : lead & (0x7F >> length);
+		for (size_t k = 1; k < length; k++)
+		{
+			if ((data[i + k] & 0xC0) != 0x80) return false;
+			codePoint = (codePoint << 6) | (data[i + k] & 0x3F);
+		}
+
+		if (codePoint < minimum[length] || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) return false;
+
+		codePoints.push_back(codePoint);
+		i += length;
+	}
+
+	return true;
+}
+
+/**
+* \brief Эталонное декодирование UTF-16 в последовательность кодовых точек
+* \param data Исходные данные
+* \param size Длина в элементах
+* \param codePoints Результат
+* \return Корректны ли данные
+*/
+static bool ReferenceDecodeUtf16(const char16_t* data, size_t size, std::vector<uint32_t>& codePoints)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		const uint32_t unit = data[i];
+
+		if (unit >= 0xD800 && unit <= 0xDBFF && i + 1 < size && data[i + 1] >= 0xDC00 && data[i + 1] <= 0xDFFF)
+		{
+			codePoints.push_back(0x10000 + ((unit - 0xD800) << 10) + (data[i + 1] - 0xDC00));
+			i++;
+		}
+		else if (unit >= 0xD800 && unit <= 0xDFFF)
+		{
+			return false;
+		}
+		else
+		{
+			codePoints.push_back(unit);
+		}
+	}
+
+	return true;
+}
+
+/**
+* \brief Эталонное кодирование кодовых точек в UTF-16
+* \param codePoints Кодовые точки
+* \return UTF-16 строка
+*/
+static std::u16string ReferenceEncodeUtf16(const std::vector<uint32_t>& codePoints)
+{
+	std::u16string result;
+	for (const uint32_t codePoint : codePoints)
+	{
+		if (codePoint < 0x10000)
+		{
+			result.push_back(static_cast<char16_t>(codePoint));
+		}
+		else
+		{
+			result.push_back(static_cast<char16_t>(0xD800 + ((codePoint - 0x10000) >> 10)));
+			result.push_back(static_cast<char16_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF)));
+		}
+	}
+	return result;
+}
+
+/**
+* \brief Прервать выполнение с сообщением о расхождении
+* \param what Описание
+* \param kernel Набор инструкций
+*/
+static void Fail(const char* what, wquery::UtfKernel kernel)
+{
+	fprintf(stderr, "UTF mismatch (%s): %s\n", wquery::GetUtfKernelName(kernel), what);
+	abort();
+}
+
+/**
+* \brief Проверить один вход (точка входа libFuzzer)
+* \param data Данные
+* \param size Длина в байтах
+* \return 0
+*/
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	// Данные как UTF-8
+	std::vector<uint32_t> codePoints8;
+	const bool valid8 = ReferenceDecodeUtf8(data, size, codePoints8);
+	const std::u16string expected16 = valid8 ? ReferenceEncodeUtf16(codePoints8) : std::u16string();
+
+	// Те же данные как UTF-16 (четное кол-во байт)
+	std::u16string units(size / 2, u'\0');
+	if (!units.empty()) memcpy(&units[0], data, units.size() * 2);
+	std::vector<uint32_t> codePoints16;
+	const bool valid16 = ReferenceDecodeUtf16(units.data(), units.size(), codePoints16);
+
+	const std::string input(reinterpret_cast<const char*>(data), size);
+	const wquery::UtfKernel initialKernel = wquery::GetUtfKernel();
+
+	for (int k = wquery::UTF_KERNEL_SCALAR; k <= wquery::UTF_KERNEL_AVX2; k++)
+	{
+		const wquery::UtfKernel kernel = static_cast<wquery::UtfKernel>(k);
+		if (!wquery::SetUtfKernel(kernel)) continue;
+
+		std::u16string utf16;
+		std::string utf8;
+
+		if (wquery::Utf8ToUtf16(input, utf16) != valid8) Fail("UTF-8 validity", kernel);
+		if (utf16 != expected16) Fail("UTF-8 -> UTF-16 result", kernel);
+		if (valid8 && (!wquery::Utf16ToUtf8(utf16, utf8) || utf8 != input)) Fail("UTF-8 round trip", kernel);
+
+		if (wquery::Utf16ToUtf8(units, utf8) != valid16) Fail("UTF-16 validity", kernel);
+		if (valid16)
+		{
+			std::vector<uint32_t> decoded;
+			if (!ReferenceDecodeUtf8(reinterpret_cast<const unsigned char*>(utf8.data()), utf8.size(), decoded) || decoded != codePoints16) Fail("UTF-16 -> UTF-8 result", kernel);
+			if (!wquery::Utf8ToUtf16(utf8, utf16) || utf16 != units) Fail("UTF-16 round trip", kernel);
+		}
+	}
+
+	wquery::SetUtfKernel(initialKernel);
+	return 0;
+}
+
+#ifndef WQUERY_LIBFUZZER
+
+/**
+* \brief Сгенерировать вход: ASCII-участки в UTF-8 и UTF-16 (включая длинные, для векторных путей),
+* корректные многобайтовые символы, суррогаты в UTF-16 и случайные байты
+* \param random Генератор
+* \param data Результат
+*/
+static void Generate(std::mt19937& random, std::vector<uint8_t>& data)
+{
+	static const char* const samples[] = { "\xD0\x9F\xD1\x80\xD0\xB8", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF", "\xEF\xBF\xBF", "\xF4\x8F\xBF\xBF" };
+	data.clear();
+
+	const int pieces = static_cast<int>(random() % 12);
+	for (int p = 0; p < pieces; p++)
+	{
+		switch (random() % 7)
+		{
+		case 0:
+		case 1:
+		{
+			const size_t run = random() % 80;
+			for (size_t i = 0; i < run; i++) data.push_back(static_cast<uint8_t>(0x20 + random() % 0x5F));
+			break;
+		}
+		case 2:
+		{
+			const char* sample = samples[random() % (sizeof(samples) / sizeof(samples[0]))];
+			data.insert(data.end(), sample, sample + strlen(sample));
+			break;
+		}
+		case 3:
+		{
+			// Элемент UTF-16 (в т.ч. суррогат) в порядке байтов процессора
+			const char16_t unit = static_cast<char16_t>(random() % 2 ? 0xD800 + random() % 0x800 : random() % 0x10000);
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&unit);
+			data.insert(data.end(), bytes, bytes + 2);
+			break;
+		}
+		case 4:
+		{
+			// ASCII-участок в UTF-16 (выравнивание по элементу сохраняется)
+			if (data.size() % 2) data.push_back(static_cast<uint8_t>(0x20 + random() % 0x5F));
+			const size_t run = random() % 80;
+			for (size_t i = 0; i < run; i++)
+			{
+				const char16_t unit = static_cast<char16_t>(random() % 0x80);
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&unit);
+				data.insert(data.end(), bytes, bytes + 2);
+			}
+			break;
+		}
+		default:
+			data.push_back(static_cast<uint8_t>(random()));
+			break;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const unsigned long iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+	const unsigned long seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+
+	std::mt19937 random(static_cast<std::mt19937::result_type>(seed));
+	std::vector<uint8_t> data;
+
+	for (unsigned long i = 0; i < iterations; i++)
+	{
+		Generate(random, data);
+		LLVMFuzzerTestOneInput(data.data(), data.size());
+	}
+
+	printf("%lu inputs checked (best kernel: %s)\n", iterations, wquery::GetUtfKernelName(wquery::GetUtfKernel()));
+	return 0;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/**
+* \brief Проверка задач-сопрограмм: результат ожидаемой задачи и уничтожение задачи во время ее ожидания
+* \details Ожидающая сопрограмма не должна зависать, если ожидаемая задача уничтожена до завершения: она
+* продолжается с исключением std::future_error (broken_promise), а задача дорабатывает сама.
+* Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what)
+{
+	if (!condition) printf("FAILED: %s\n", what);
+	return condition;
+}
+
+/**
+* \brief Задача, завершающаяся в следующем кадре
+* \param finished Признак завершения
+* \return Задача с результатом
+*/
+static wquery::Task<int> Produce(bool& finished)
+{
+	co_await wquery::NextFrame();
+	finished = true;
+	co_return 42;
+}
+
+/**
+* \brief Ожидать задачу, которой владеет внешний код
+* \param task Задача
+* \param result Результат (-1 - задача уничтожена до завершения)
+* \param resumed Признак продолжения после ожидания
+* \return Задача
+*/
+static wquery::Task<> Await(wquery::Task<int>& task, int& result, bool& resumed)
+{
+	try
+	{
+		result = co_await task;
+	}
+	catch (const std::future_error& error)
+	{
+		if (error.code() == std::future_errc::broken_promise) result = -1;
+	}
+
+	resumed = true;
+}
+
+/**
+* \brief Выполнить итерации основного цикла, пока есть ожидающие продолжения сопрограммы
+*/
+static void RunPending()
+{
+	while (wquery::HasPendingCoroutines(true)) wquery::ResumePendingCoroutines(true);
+}
+
+int main()
+{
+	wquery::SetBackend(std::unique_ptr<wquery::Backend>(new wquery::HeadlessBackend()));
+	wquery::Begin();
+
+	bool passed = true;
+
+	// Ожидаемая задача завершается - ожидающая получает результат
+	{
+		bool finished = false, resumed = false;
+		int result = 0;
+
+		wquery::Task<int> task = Produce(finished);
+		wquery::Spawn(Await(task, result, resumed));
+		passed &= Check(!resumed, "awaiter waits for the task");
+
+		RunPending();
+		passed &= Check(finished && resumed && result == 42, "awaiter receives the result");
+	}
+
+	// Ожидаемая задача уничтожена до завершения - ожидающая продолжается с broken_promise, задача дорабатывает
+	{
+		bool finished = false, resumed = false;
+		int result = 0;
+
+		std::optional<wquery::Task<int>> task(Produce(finished));
+		wquery::Spawn(Await(*task, result, resumed));
+
+		task.reset();
+		passed &= Check(!resumed, "destroyed task resumes the awaiter later, not from the destructor");
+
+		RunPending();
+		passed &= Check(resumed && result == -1, "awaiter of a destroyed task resumes with broken_promise");
+		passed &= Check(finished, "destroyed task runs to completion");
+	}
+
+	wquery::RethrowCoroutineException();
+
+	if (passed) printf("All coroutine checks passed\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+/**
+* \brief Проверка форм: компиляция описания, проверка бинарного описания и создание формы
+* \details Поврежденные описания (усеченные таблицы, незавершенная таблица строк, номера шрифтов и смещения строк
+* за пределами таблиц) должны отклоняться при загрузке. Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#define FORM_TEST_FILE "form_test.wqf"
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what)
+{
+	if (!condition) printf("FAILED: %s\n", what);
+	return condition;
+}
+
+/**
+* \brief Текстовое описание проверяемой формы
+*/
+static const char* formSource_ =
+	"# Форма входа\n"
+	"window \"Sign in \\\"test\\\"\" size 400 200 min 300 150 position 10 20 color 1 2 3 closes hidden\n"
+	"font caption \"Tahoma\" 14 bold\n"
+	"font body \"Verdana\" 11 italic\n"
+	"textbox login \"user\" at 10 10 size 200 20 anchor left top right font body\n"
+	"textbox password \"\" at 10 40 size 200 20 password disabled\n"
+	"textbox notes \"line 1\\nline 2\" at 10 70 size 200 60 document anchor left top right bottom\n"
+	"button ok \"OK\" at 220 10 size 80 24 font caption\n"
+	"button - \"Unnamed\" at 220 40 size 80 24 windowless\n";
+
+/**
+* \brief Заголовок бинарного описания (для изменения полей)
+* \param binary Бинарное описание
+* \return Заголовок
+*/
+static wquery::FormHeader& Header(std::vector<unsigned char>& binary)
+{
+	return *reinterpret_cast<wquery::FormHeader*>(binary.data());
+}
+
+/**
+* \brief Запись элемента бинарного описания (для изменения полей)
+* \param binary Бинарное описание
+* \param index Номер элемента
+* \return Запись
+*/
+static wquery::FormControlRecord& Control(std::vector<unsigned char>& binary, size_t index)
+{
+	return reinterpret_cast<wquery::FormControlRecord*>(binary.data() + Header(binary).controlsOffset)[index];
+}
+
+/**
+* \brief Загружается ли измененное описание
+* \param binary Бинарное описание
+* \param change Изменение
+* \return Удалось ли загрузить
+*/
+template <typename Change>
+static bool LoadChanged(std::vector<unsigned char> binary, Change change)
+{
+	change(binary);
+	wquery::Form form;
+	return form.Load(binary.data(), binary.size());
+}
+
+/**
+* \brief Проверить созданную форму
+* \param form Форма
+* \return Пройдены ли проверки
+*/
+static bool CheckForm(const wquery::Form& form)
+{
+	bool passed = true;
+
+	wquery::Window* window = form.GetWindow();
+	if (!Check(window != nullptr, "form has a window")) return false;
+
+	passed &= Check(window->GetTitle() == "Sign in \"test\"", "window title with escapes");
+	passed &= Check(window->GetSize(true).X == 400 && window->GetSize(true).Y == 200, "window client size");
+	passed &= Check(window->GetMinSizes(true).X == 300 && window->GetMinSizes(true).Y == 150, "window min size");
+	passed &= Check(window->IsClosesProgram(), "window closes program");
+	passed &= Check(form.GetControlCount() == 5, "control count");
+
+	wquery::TextBox* login = form.Get<wquery::TextBox>("login");
+	wquery::TextBox* password = form.Get<wquery::TextBox>("password");
+	wquery::TextBox* notes = form.Get<wquery::TextBox>("notes");
+	wquery::Button* ok = form.Get<wquery::Button>("ok");
+
+	if (!Check(login && password && notes && ok, "named controls are found with their types")) return false;
+
+	passed &= Check(form.Get<wquery::Button>("login") == nullptr, "typed lookup rejects another type");
+	passed &= Check(form.Find("-") == nullptr && form.Find("missing") == nullptr, "unnamed and missing controls are not found");
+
+	passed &= Check(login->GetText() == "user", "textbox text");
+	passed &= Check(notes->GetText() == "line 1\nline 2" || notes->GetText() == "line 1\r\nline 2", "document text with escapes");
+	passed &= Check(ok->GetText() == "OK", "button text");
+
+	passed &= Check(login->GetPosition().X == 10 && login->GetPosition().Y == 10, "control position");
+	passed &= Check(ok->GetSize().X == 80 && ok->GetSize().Y == 24, "control size");
+
+	const wquery::AnchorSettings anchor = notes->GetAnchor();
+	passed &= Check(anchor.left && anchor.top && anchor.right && anchor.bottom, "control anchor");
+
+	passed &= Check(!password->IsEnabled() && login->IsEnabled(), "disabled flag");
+
+	// Окно формы скрыто - системные элементы создаются при показе
+	window->Show();
+	passed &= Check(password->IsCreated() && (wquery::GetBackend().GetStyle(password->GetNativeHandle()) & ES_PASSWORD) != 0, "password flag");
+
+	const wquery::FontSettings caption = ok->GetFont();
+	passed &= Check(caption.size == 14 && caption.bold && !caption.italic, "control font from the font table");
+	const wquery::FontSettings body = login->GetFont();
+	passed &= Check(body.size == 11 && !body.bold && body.italic, "second font from the font table");
+
+	return passed;
+}
+
+int main()
+{
+	wquery::SetBackend(std::unique_ptr<wquery::Backend>(new wquery::HeadlessBackend()));
+	wquery::Begin();
+
+	bool passed = true;
+
+	// Компиляция, загрузка из памяти и из файла
+	std::vector<unsigned char> binary;
+	std::string error;
+	if (!Check(wquery::CompileForm(formSource_, binary, error), "form compiles"))
+	{
+		printf("%s\n", error.c_str());
+		return 1;
+	}
+
+	{
+		wquery::Form form;
+		passed &= Check(form.Load(binary.data(), binary.size()), "compiled form loads from memory");
+		passed &= CheckForm(form);
+
+		// Невыровненные данные копируются при загрузке
+		std::vector<unsigned char> shifted(binary.size() + 1);
+		std::memcpy(shifted.data() + 1, binary.data(), binary.size());
+		passed &= Check(form.Load(shifted.data() + 1, binary.size()), "unaligned form loads");
+		passed &= CheckForm(form);
+
+		std::ofstream(FORM_TEST_FILE, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+		passed &= Check(form.Load(FORM_TEST_FILE), "compiled form loads from a file");
+		passed &= CheckForm(form);
+		std::remove(FORM_TEST_FILE);
+
+		passed &= Check(!form.Load(FORM_TEST_FILE) && form.GetWindow() == nullptr, "missing file fails and clears the form");
+	}
+
+	// Ошибки компиляции (с номером строки, если ошибка относится к строке)
+	const char* invalidSources[][2] = {
+		{ "button a \"A\" at 0 0 size 1 1\n", "missing window" },
+		{ "window \"A\" size 1 1\nwindow \"B\" size 1 1\n", "line 2: duplicate window" },
+		{ "window \"A\" size 1 1\nbutton a \"A\" at 0 0 size 1 1 font missing\n", "line 2: unknown font 'missing'" },
+		{ "window \"A\" size 1 1\nbutton a \"A\" at 0 0 size 1 1\nbutton a \"B\" at 0 0 size 1 1\n", "line 3: duplicate control 'a'" },
+		{ "window \"A size 1 1\n", "line 1: unterminated string" },
+		{ "window \"A\" size 1\n", "line 1: expected a number" },
+		{ "window \"A\" size 1 1\nlabel a \"A\" at 0 0 size 1 1\n", "line 2: unknown command 'label'" }
+	};
+
+	for (const auto& invalid : invalidSources)
+	{
+		std::vector<unsigned char> rejected;
+		error.clear();
+		const bool rejectedWithError = !wquery::CompileForm(invalid[0], rejected, error) && error == invalid[1];
+		passed &= Check(rejectedWithError, "invalid source is rejected with an error");
+		if (!rejectedWithError) printf("  expected '%s', got '%s'\n", invalid[1], error.c_str());
+	}
+
+	// Поврежденные описания
+	const wquery::FormHeader header = Header(binary);
+	const std::uint32_t stringsEnd = header.stringsOffset + header.stringsSize;
+
+	for (size_t size = 0; size < binary.size(); size++)
+	{
+		// Усеченный файл: и с исходным размером в заголовке, и с исправленным (таблицы выходят за конец)
+		std::vector<unsigned char> truncated(binary.begin(), binary.begin() + static_cast<std::ptrdiff_t>(size));
+		wquery::Form form;
+		if (!Check(!form.Load(truncated.data(), truncated.size()), "truncated form is rejected")) { passed = false; break; }
+
+		if (size >= sizeof(wquery::FormHeader))
+		{
+			Header(truncated).fileSize = static_cast<std::uint32_t>(size);
+			if (!Check(!form.Load(truncated.data(), truncated.size()), "truncated tables are rejected")) { passed = false; break; }
+		}
+	}
+
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).magic ^= 1; }), "wrong magic is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).version++; }), "wrong version is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { b.push_back(0); }), "file size mismatch is rejected");
+
+	passed &= Check(!LoadChanged(binary, [stringsEnd](std::vector<unsigned char>& b) { b[stringsEnd - 1] = 'x'; }), "unterminated string table is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).stringsSize = 0; }), "empty string table is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).stringsSize++; }), "string table past the end is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).window.title = Header(b).stringsSize; }), "window title past the string table is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Control(b, 0).text = Header(b).stringsSize; }), "control text past the string table is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Control(b, 0).name = 0xFFFFFFFFu; }), "control name past the string table is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { reinterpret_cast<wquery::FormFontRecord*>(b.data() + Header(b).fontsOffset)->family = Header(b).stringsSize; }), "font family past the string table is rejected");
+
+	passed &= Check(LoadChanged(binary, [](std::vector<unsigned char>& b) { Control(b, 0).font = Header(b).fontCount; }), "last font index is accepted");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Control(b, 0).font = Header(b).fontCount + 1; }), "font index past the font table is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Control(b, 0).font = 0xFFFFFFFFu; }), "huge font index is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Control(b, 0).type = 0; }), "unknown control type is rejected");
+
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).controlCount++; }), "control table past the end is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).controlCount = 0xFFFFFFFFu; }), "huge control count is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).fontCount = 0xFFFFFFFFu; }), "huge font count is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).fontsOffset = 0xFFFFFFFCu; }), "font table offset past the end is rejected");
+	passed &= Check(!LoadChanged(binary, [](std::vector<unsigned char>& b) { Header(b).controlsOffset += 2; }), "misaligned control table is rejected");
+
+	// Случайные повреждения заголовка и таблиц: загрузка либо отклоняется, либо создает форму без выхода за описание
+	std::mt19937 random(7);
+	size_t loaded = 0;
+	for (size_t round = 0; round < 2000; round++)
+	{
+		std::vector<unsigned char> corrupted = binary;
+		const size_t changes = 1 + random() % 4;
+		for (size_t i = 0; i < changes; i++) corrupted[random() % stringsEnd] = static_cast<unsigned char>(random());
+
+		wquery::Form form;
+		if (form.Load(corrupted.data(), corrupted.size())) loaded++;
+	}
+	printf("Random corruption: %zu of 2000 forms loaded\n", loaded);
+
+	if (passed) printf("All form checks passed\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+/**
+* \brief Проверка хранилища геометрии: раскладка и список изменившихся элементов после изменения привязок,
+* удаления и уплотнения сверяются с поэлементной моделью
+* \details Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <random>
+
+/**
+* \brief Элемент модели
+*/
+struct ModelControl
+{
+	unsigned char anchor;                      // Привязка (AnchorBits)
+	wquery::Vector2D<int> position;            // Положение
+	wquery::Vector2D<int> size;                // Размеры
+	bool removed;                              // Удален (место до уплотнения)
+};
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what)
+{
+	if (!condition) printf("FAILED: %s\n", what);
+	return condition;
+}
+
+/**
+* \brief Применить раскладку к модели
+* \param model Модель
+* \param delta Изменение размеров контейнера
+* \param changed Идентификаторы изменившихся элементов
+*/
+static void Layout(std::vector<ModelControl>& model, const wquery::Vector2D<int>& delta, std::vector<unsigned int>& changed)
+{
+	for (size_t id = 0; id < model.size(); id++)
+	{
+		ModelControl& control = model[id];
+		const bool left = control.anchor & wquery::ANCHOR_LEFT, right = control.anchor & wquery::ANCHOR_RIGHT;
+		const bool top = control.anchor & wquery::ANCHOR_TOP, bottom = control.anchor & wquery::ANCHOR_BOTTOM;
+
+		if (right) { if (left) control.size.X += delta.X; else control.position.X += delta.X; }
+		if (bottom) { if (top) control.size.Y += delta.Y; else control.position.Y += delta.Y; }
+		if ((right && delta.X != 0) || (bottom && delta.Y != 0)) changed.push_back(static_cast<unsigned int>(id));
+	}
+}
+
+/**
+* \brief Сверить хранилище с моделью
+* \param store Хранилище
+* \param model Модель
+* \return Совпадают ли
+*/
+static bool Matches(const wquery::GeometryStore& store, const std::vector<ModelControl>& model)
+{
+	if (store.GetCount() != model.size()) return false;
+
+	for (unsigned int id = 0; id < model.size(); id++)
+	{
+		if (model[id].removed) continue;
+		if (store.GetPosition(id).X != model[id].position.X || store.GetPosition(id).Y != model[id].position.Y) return false;
+		if (store.GetSize(id).X != model[id].size.X || store.GetSize(id).Y != model[id].size.Y) return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	bool passed = true;
+
+	std::mt19937 random(3);
+	wquery::GeometryStore store;
+	std::vector<ModelControl> model;
+
+	for (size_t step = 0; step < 20000 && passed; step++)
+	{
+		const unsigned int operation = random() % 8;
+
+		if (operation == 0 || model.empty())
+		{
+			const wquery::Vector2D<int> position(static_cast<int>(random() % 500), static_cast<int>(random() % 500));
+			const wquery::Vector2D<int> size(static_cast<int>(random() % 50), static_cast<int>(random() % 50));
+			store.Add(nullptr, nullptr, position, size);
+			model.push_back({ 0, position, size, false });
+		}
+		else if (operation <= 2)
+		{
+			// Изменение привязки (в том числе на ту же самую)
+			const unsigned int id = random() % model.size();
+			if (model[id].removed) continue;
+			const unsigned char anchor = static_cast<unsigned char>(random() % 16);
+			store.SetAnchor(id, wquery::GeometryStore::UnpackAnchor(anchor));
+			model[id].anchor = anchor;
+		}
+		else if (operation == 3)
+		{
+			const unsigned int id = random() % model.size();
+			if (model[id].removed) continue;
+			store.Remove(id);
+			model[id] = { 0, { 0, 0 }, { 0, 0 }, true };
+		}
+		else if (operation == 4 && random() % 8 == 0)
+		{
+			store.Compact();
+			std::vector<ModelControl> kept;
+			for (const ModelControl& control : model) if (!control.removed) kept.push_back(control);
+			model.swap(kept);
+		}
+		else
+		{
+			// Раскладка, в том числе с изменением только одной оси или без изменения
+			const int deltas[] = { 0, 3, -2, 7 };
+			const wquery::Vector2D<int> delta(deltas[random() % 4], deltas[random() % 4]);
+
+			std::vector<unsigned int> changed(1, 12345), expected(1, 12345);
+			const size_t count = store.Layout(delta, changed);
+			Layout(model, delta, expected);
+
+			passed &= Check(changed == expected && count == expected.size() - 1, "layout reports the changed controls in order");
+		}
+
+		passed &= Check(Matches(store, model), "layout moves and stretches controls like the model");
+	}
+
+	if (passed) printf("All geometry store checks passed\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/**
+* \brief Проверка таблицы: переиспользование кольца ячеек видимых строк при прокрутке
+* \details Строка N должна занимать ячейку N % кол-во видимых строк, а при рисовании запрашиваться у источника
+* данных, только если ее ячейка занята другой строкой. Ячейка определяется по адресу массива текста ячеек,
+* который таблица передает источнику данных. Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <random>
+
+#define GRID_TEST_ROWS 1000000
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what)
+{
+	if (!condition) printf("FAILED: %s\n", what);
+	return condition;
+}
+
+/**
+* \brief Запрос строки у источника данных
+*/
+struct RowRequest
+{
+	size_t row;                                // Индекс строки
+	const std::vector<std::string>* cells;     // Массив текста ячеек (определяет ячейку кольца)
+};
+
+/**
+* \brief Модель кольца ячеек
+*/
+struct SlotModel
+{
+	std::vector<size_t> rows;                                  // Строка в ячейке (Grid::NO_ROW - пусто)
+	std::vector<const std::vector<std::string>*> cells;        // Массив текста ячейки (nullptr - еще не встречался)
+	size_t requested = 0;                                      // Кол-во запросов строк при последней сверке
+
+	/**
+	* \brief Сбросить модель (кольцо пересоздано или строки запрашиваются заново)
+	* \param size Кол-во ячеек
+	*/
+	void Reset(size_t size)
+	{
+		rows.assign(size, wquery::Grid::NO_ROW);
+		cells.assign(size, nullptr);
+	}
+};
+
+/**
+* \brief Перерисовать окно и сверить запросы строк с моделью кольца
+* \param grid Таблица
+* \param requests Запросы строк с прошлой сверки (очищаются после сверки)
+* \param model Модель кольца (обновляется)
+* \param what Описание шага
+* \return Пройдены ли проверки
+*/
+static bool Paint(const wquery::Grid& grid, std::vector<RowRequest>& requests, SlotModel& model, const char* what)
+{
+	wquery::Window::FlushPaint();
+
+	const size_t visibleRows = grid.GetVisibleRowCount();
+	if (model.rows.size() != visibleRows) model.Reset(visibleRows);
+
+	// Ожидаются запросы только тех видимых строк, чьи ячейки заняты другими строками
+	const size_t first = grid.GetFirstRow();
+	const size_t last = (std::min)(first + visibleRows, grid.GetRowCount());
+	std::vector<size_t> expected;
+	for (size_t row = first; row < last; row++)
+		if (model.rows[row % visibleRows] != row) expected.push_back(row);
+
+	bool passed = true;
+	std::vector<size_t> requested;
+
+	for (const RowRequest& request : requests)
+	{
+		const size_t slot = request.row % visibleRows;
+		requested.push_back(request.row);
+
+		// Массив ячейки постоянен, пока кольцо не пересоздано: строка попала в ячейку row % visibleRows
+		if (!model.cells[slot]) model.cells[slot] = request.cells;
+		passed &= request.cells == model.cells[slot];
+		model.rows[slot] = request.row;
+	}
+
+	std::sort(requested.begin(), requested.end());
+	passed &= requested == expected;
+
+	// После перерисовки каждая видимая строка занимает свою ячейку
+	for (size_t row = first; row < last; row++) passed &= model.rows[row % visibleRows] == row;
+
+	model.requested = requests.size();
+	requests.clear();
+	if (!passed) printf("  %s: first row %zu, %zu visible, %zu requested, %zu expected\n", what, first, visibleRows, requested.size(), expected.size());
+	return Check(passed, "visible rows are bound to slot row % visibleRows");
+}
+
+int main()
+{
+	wquery::SetBackend(std::unique_ptr<wquery::Backend>(new wquery::HeadlessBackend()));
+	wquery::Begin();
+
+	bool passed = true;
+
+	wquery::Window window;
+	window.SetSize({ 640, 480 }, true);
+
+	wquery::ControlState state;
+	state.size = { 640, 400 };
+	wquery::Grid grid(&window, state);
+	grid.AddColumn("Id", 100);
+	grid.AddColumn("Value", 200);
+
+	std::vector<RowRequest> requests;
+	grid.SetDataSource([&requests](size_t row, std::vector<std::string>& cells)
+	{
+		requests.push_back({ row, &cells });
+		cells[0] = std::to_string(row);
+		cells[1] = "value " + std::to_string(row * 7919);
+	});
+
+	grid.SetRowCount(GRID_TEST_ROWS);
+	window.Show();
+
+	SlotModel model;
+	passed &= Paint(grid, requests, model, "first paint");
+
+	const size_t visibleRows = grid.GetVisibleRowCount();
+	passed &= Check(visibleRows > 2, "grid has several visible rows");
+	passed &= Check(model.requested == visibleRows, "first paint requests every visible row once");
+
+	// Прокрутка на строку и на неполную страницу - запрашиваются только открывшиеся строки
+	grid.ScrollBy(1);
+	passed &= Paint(grid, requests, model, "scroll by one row");
+	passed &= Check(model.requested == 1, "scrolling by one row requests one row");
+
+	grid.ScrollBy(static_cast<long long>(visibleRows) - 1);
+	passed &= Paint(grid, requests, model, "scroll by visibleRows - 1");
+
+	grid.ScrollBy(-3);
+	passed &= Paint(grid, requests, model, "scroll back by three rows");
+	passed &= Check(model.requested == 3, "scrolling back requests only the rows that appeared");
+
+	// Прокрутка больше видимой части - все ячейки переиспользуются для новых строк
+	const long long scrolls[] = {
+		static_cast<long long>(visibleRows) + 1,
+		static_cast<long long>(visibleRows) * 2 + 3,
+		static_cast<long long>(visibleRows) * 7,
+		static_cast<long long>(visibleRows),
+		-static_cast<long long>(visibleRows) - 5,
+		-static_cast<long long>(visibleRows) * 3 + 1
+	};
+
+	for (const long long rows : scrolls)
+	{
+		grid.ScrollBy(rows);
+		passed &= Paint(grid, requests, model, "scroll by more than the viewport");
+		passed &= Check(model.requested == visibleRows, "scrolling past the viewport requests every visible row");
+	}
+
+	// Переходы в случайные места, конец таблицы (последняя строка видна полностью) и начало
+	std::mt19937_64 random(11);
+	for (size_t i = 0; i < 200; i++)
+	{
+		grid.SetFirstRow(static_cast<size_t>(random() % GRID_TEST_ROWS));
+		passed &= Paint(grid, requests, model, "random jump");
+	}
+
+	grid.SetFirstRow(GRID_TEST_ROWS);
+	passed &= Paint(grid, requests, model, "jump to the end");
+	passed &= Check(grid.GetFirstRow() + visibleRows >= GRID_TEST_ROWS, "end of the table is visible");
+
+	grid.SetFirstRow(0);
+	passed &= Paint(grid, requests, model, "jump to the start");
+
+	// Обновление данных - видимые строки запрашиваются заново в тех же ячейках
+	grid.Refresh();
+	model.rows.assign(model.rows.size(), wquery::Grid::NO_ROW);
+	passed &= Paint(grid, requests, model, "refresh");
+	passed &= Check(model.requested == visibleRows, "refresh requests every visible row");
+
+	// Изменение высоты - меняется кол-во видимых строк и соответствие строк ячейкам
+	grid.SetSize({ 640, 250 });
+	model.Reset(0);
+	passed &= Paint(grid, requests, model, "resize");
+	passed &= Check(grid.GetVisibleRowCount() < visibleRows, "resize changes the visible row count");
+
+	for (const long long rows : { 1ll, static_cast<long long>(grid.GetVisibleRowCount()) + 2, -1ll })
+	{
+		grid.ScrollBy(rows);
+		passed &= Paint(grid, requests, model, "scroll after resize");
+	}
+
+	if (passed) printf("All grid checks passed\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+/**
+* \brief Проверка журнала: вытеснение строк из колец, предел входящей очереди и порядок строк при нескольких потоках
+* \details Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <thread>
+
+#define LOG_TEST_THREADS 4
+#define LOG_TEST_MAX_LINES 1000
+#define LOG_TEST_MAX_BYTES (64 * 1024)
+
+// Длина строки "tt nnnnnnnnnnnnn" (поток и порядковый номер)
+#define LOG_TEST_LINE_LENGTH 16
+
+// Заголовок строки во входящей очереди (следующая строка и длина текста)
+#define LOG_TEST_LINE_HEADER (sizeof(void*) + sizeof(size_t))
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what)
+{
+	if (!condition) printf("FAILED: %s\n", what);
+	return condition;
+}
+
+/**
+* \brief Добавить строку с номером потока и порядковым номером
+* \param log Журнал
+* \param thread Номер потока
+* \param index Порядковый номер
+*/
+static void AppendNumbered(wquery::LogView& log, size_t thread, size_t index)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%02zu %013zu", thread, index);
+	log.AppendLine(std::string_view(buffer, LOG_TEST_LINE_LENGTH));
+}
+
+/**
+* \brief Проверить, что строки каждого потока идут в журнале в порядке добавления
+* \param log Журнал
+* \return Выполнено ли условие
+*/
+static bool CheckOrder(const wquery::LogView& log)
+{
+	size_t next[LOG_TEST_THREADS] = {};
+	std::string line;
+
+	for (size_t i = 0; i < log.GetLineCount(); i++)
+	{
+		log.GetLine(i, line);
+		size_t thread = 0, index = 0;
+		if (line.length() != LOG_TEST_LINE_LENGTH || sscanf(line.c_str(), "%zu %zu", &thread, &index) != 2 || thread >= LOG_TEST_THREADS) return false;
+		if (index < next[thread]) return false;
+		next[thread] = index + 1;
+	}
+
+	return true;
+}
+
+/**
+* \brief Один поток: в журнале остаются самые новые строки в порядке добавления
+* \return Пройдены ли проверки
+*/
+static bool TestEviction()
+{
+	bool passed = true;
+
+	wquery::Window window;
+	wquery::LogView log(&window);
+	log.SetCapacity(LOG_TEST_MAX_LINES, LOG_TEST_MAX_BYTES);
+
+	// Ограничивает кол-во строк
+	for (size_t i = 0; i < 5000; i++)
+	{
+		AppendNumbered(log, 0, i);
+		if (i % 100 == 99) log.Flush();
+	}
+
+	passed &= Check(log.GetLineCount() == LOG_TEST_MAX_LINES, "eviction keeps maxLines lines");
+	passed &= Check(log.GetTotalLineCount() == 5000 && log.GetDroppedLineCount() == 5000 - LOG_TEST_MAX_LINES, "eviction counts dropped lines");
+
+	std::string line;
+	char expected[32];
+	for (size_t i = 0; i < log.GetLineCount(); i++)
+	{
+		log.GetLine(i, line);
+		snprintf(expected, sizeof(expected), "%02d %013zu", 0, 5000 - LOG_TEST_MAX_LINES + i);
+		if (line != expected) { passed &= Check(false, "eviction keeps the newest lines in order"); break; }
+	}
+
+	// Ограничивает объем текста (кольцо текста вмещает 250 строк, текст переходит через конец кольца)
+	log.SetCapacity(LOG_TEST_MAX_LINES, 250 * LOG_TEST_LINE_LENGTH + LOG_TEST_LINE_LENGTH / 2);
+	passed &= Check(log.GetLineCount() == 250, "shrinking keeps the lines that fit the text ring");
+
+	for (size_t i = 5000; i < 5333; i++) AppendNumbered(log, 0, i);
+	log.Flush();
+
+	passed &= Check(log.GetLineCount() == 250, "text ring bounds the line count");
+	for (size_t i = 0; i < log.GetLineCount(); i++)
+	{
+		log.GetLine(i, line);
+		snprintf(expected, sizeof(expected), "%02d %013zu", 0, 5333 - 250 + i);
+		if (line != expected) { passed &= Check(false, "text ring keeps the newest lines in order"); break; }
+	}
+
+	return passed;
+}
+
+/**
+* \brief Перегрузка: производители добавляют строки, пока очередь не разбирается - объем очереди ограничен
+* \return Пройдены ли проверки
+*/
+static bool TestInboxBound()
+{
+	bool passed = true;
+
+	wquery::Window window;
+	wquery::LogView log(&window);
+	log.SetCapacity(LOG_TEST_MAX_LINES, LOG_TEST_MAX_BYTES);
+
+	const size_t ringMemory = log.GetMemoryUsage();
+	const size_t maxPendingBytes = LOG_TEST_MAX_BYTES + LOG_TEST_MAX_LINES * LOG_TEST_LINE_HEADER;
+	const size_t lineSize = LOG_TEST_LINE_HEADER + LOG_TEST_LINE_LENGTH;
+	const size_t linesPerThread = 20000;
+
+	std::atomic<size_t> finished(0);
+	std::vector<std::thread> producers;
+	for (size_t t = 0; t < LOG_TEST_THREADS; t++)
+	{
+		producers.emplace_back([&log, &finished, t, linesPerThread]()
+		{
+			for (size_t i = 0; i < linesPerThread; i++) AppendNumbered(log, t, i);
+			finished++;
+		});
+	}
+
+	// Во время добавления очередь может превысить предел только на строки, которые резервируют объем прямо сейчас
+	size_t peakMemory = 0;
+	while (finished < LOG_TEST_THREADS)
+		peakMemory = (std::max)(peakMemory, log.GetMemoryUsage());
+
+	for (std::thread& producer : producers) producer.join();
+	peakMemory = (std::max)(peakMemory, log.GetMemoryUsage());
+
+	passed &= Check(peakMemory <= ringMemory + maxPendingBytes + LOG_TEST_THREADS * lineSize, "memory stays under the ceiling while producing");
+	passed &= Check(log.GetMemoryUsage() <= ringMemory + maxPendingBytes, "pending bytes stay under maxPendingBytes");
+
+	const unsigned long long rejected = log.GetDroppedLineCount();
+	const size_t accepted = LOG_TEST_THREADS * linesPerThread - static_cast<size_t>(rejected);
+	passed &= Check(accepted == maxPendingBytes / lineSize, "inbox accepts lines up to maxPendingBytes");
+
+	passed &= Check(log.Flush() == accepted, "flush drains the accepted lines");
+	passed &= Check(log.GetMemoryUsage() == ringMemory, "flushed inbox holds no memory");
+	passed &= Check(log.GetLineCount() == (std::min)(accepted, static_cast<size_t>(LOG_TEST_MAX_LINES)), "overloaded log keeps maxLines lines");
+	passed &= Check(log.GetTotalLineCount() == LOG_TEST_THREADS * linesPerThread, "rejected lines count as received");
+	passed &= Check(log.GetTotalLineCount() == log.GetLineCount() + log.GetDroppedLineCount(), "kept and dropped lines add up");
+	passed &= Check(CheckOrder(log), "overloaded log keeps per-thread order");
+
+	return passed;
+}
+
+/**
+* \brief Потоковый прием: основной поток разбирает очередь, пока производители добавляют строки
+* \return Пройдены ли проверки
+*/
+static bool TestStreaming()
+{
+	bool passed = true;
+
+	wquery::Window window;
+	wquery::LogView log(&window);
+	log.SetCapacity(LOG_TEST_MAX_LINES, LOG_TEST_MAX_BYTES);
+
+	const size_t ringMemory = log.GetMemoryUsage();
+	const size_t maxPendingBytes = LOG_TEST_MAX_BYTES + LOG_TEST_MAX_LINES * LOG_TEST_LINE_HEADER;
+	const size_t lineSize = LOG_TEST_LINE_HEADER + LOG_TEST_LINE_LENGTH;
+	const size_t linesPerThread = 50000;
+
+	std::vector<std::thread> producers;
+	for (size_t t = 0; t < LOG_TEST_THREADS; t++)
+	{
+		producers.emplace_back([&log, t, linesPerThread]()
+		{
+			for (size_t i = 0; i < linesPerThread; i++) AppendNumbered(log, t, i);
+		});
+	}
+
+	size_t peakMemory = 0;
+	bool ordered = true;
+	while (log.GetTotalLineCount() < LOG_TEST_THREADS * linesPerThread)
+	{
+		peakMemory = (std::max)(peakMemory, log.GetMemoryUsage());
+		log.Flush();
+		ordered &= log.GetLineCount() <= LOG_TEST_MAX_LINES && CheckOrder(log);
+	}
+
+	for (std::thread& producer : producers) producer.join();
+	log.Flush();
+
+	passed &= Check(ordered, "streaming log stays within maxLines and in per-thread order");
+	passed &= Check(peakMemory <= ringMemory + maxPendingBytes + LOG_TEST_THREADS * lineSize, "streaming memory stays under the ceiling");
+	passed &= Check(log.GetLineCount() == LOG_TEST_MAX_LINES, "streaming log keeps maxLines lines");
+	passed &= Check(log.GetTotalLineCount() == log.GetLineCount() + log.GetDroppedLineCount(), "streaming kept and dropped lines add up");
+	passed &= Check(CheckOrder(log), "streaming log keeps per-thread order");
+
+	return passed;
+}
+
+int main()
+{
+	wquery::SetBackend(std::unique_ptr<wquery::Backend>(new wquery::HeadlessBackend()));
+	wquery::Begin();
+
+	bool passed = true;
+	passed &= TestEviction();
+	passed &= TestInboxBound();
+	passed &= TestStreaming();
+
+	if (passed) printf("All log view checks passed\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/**
+* \brief Проверка таблицы фрагментов: случайные вставки и удаления сверяются со строкой-моделью
+* \details Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <random>
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \param step Номер шага
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what, size_t step)
+{
+	if (!condition) printf("FAILED at step %zu: %s\n", step, what);
+	return condition;
+}
+
+/**
+* \brief Сверить документ с моделью (текст, строки, символы)
+* \param table Документ
+* \param model Модель
+* \param step Номер шага
+* \return Совпадает ли документ с моделью
+*/
+static bool Verify(const wquery::PieceTable& table, const std::string& model, size_t step)
+{
+	bool passed = true;
+
+	std::string text;
+	table.GetText(text);
+	passed &= Check(text == model, "text", step);
+	passed &= Check(table.GetLength() == model.size(), "length", step);
+
+	// Начала строк модели
+	std::vector<size_t> lineStarts(1, 0);
+	for (size_t i = 0; i < model.size(); i++)
+		if (model[i] == '\n') lineStarts.push_back(i + 1);
+
+	passed &= Check(table.GetLineCount() == lineStarts.size(), "line count", step);
+
+	for (size_t line = 0; line < lineStarts.size(); line++)
+		passed &= Check(table.GetLineStart(line) == lineStarts[line], "line start", step);
+	passed &= Check(table.GetLineStart(lineStarts.size()) == model.size(), "line start past the last line", step);
+
+	size_t line = 0;
+	for (size_t position = 0; position <= model.size(); position++)
+	{
+		if (line + 1 < lineStarts.size() && lineStarts[line + 1] == position) line++;
+		passed &= Check(table.GetLineAt(position) == line, "line at position", step);
+		if (position < model.size()) passed &= Check(table.GetChar(position) == model[position], "char at position", step);
+	}
+
+	// Строки без перевода строки
+	std::string lineText;
+	for (size_t i = 0; i < lineStarts.size(); i++)
+	{
+		const size_t end = i + 1 < lineStarts.size() ? lineStarts[i + 1] - 1 : model.size();
+		std::string expected = model.substr(lineStarts[i], end - lineStarts[i]);
+		if (!expected.empty() && expected.back() == '\r') expected.pop_back();
+		table.GetLine(i, lineText);
+		passed &= Check(lineText == expected, "line text", step);
+	}
+
+	return passed;
+}
+
+int main()
+{
+	bool passed = true;
+
+	std::mt19937 random(12345);
+	const char alphabet[] = "abc \n\r\xD0\xB6";
+
+	// Случайный фрагмент текста (с переводами строк и многобайтовыми символами)
+	auto randomText = [&random, &alphabet](size_t maxLength)
+	{
+		std::string text(random() % (maxLength + 1), ' ');
+		for (char& c : text) c = alphabet[random() % (sizeof(alphabet) - 1)];
+		return text;
+	};
+
+	std::string model = "first line\nsecond line\r\nthird";
+	wquery::PieceTable table(model);
+	passed &= Verify(table, model, 0);
+
+	size_t typingPosition = static_cast<size_t>(-1);
+
+	for (size_t step = 1; step <= 3000 && passed; step++)
+	{
+		const unsigned int operation = random() % 10;
+
+		if (operation < 3 && typingPosition <= model.size())
+		{
+			// Набор текста сразу за предыдущей вставкой (фрагмент вставки продлевается на месте)
+			const std::string text = randomText(3);
+			table.Insert(typingPosition, text);
+			model.insert(typingPosition, text);
+			typingPosition += text.size();
+		}
+		else if (operation < 7)
+		{
+			const size_t position = random() % (model.size() + 1);
+			const std::string text = randomText(16);
+			table.Insert(position, text);
+			model.insert(position, text);
+			typingPosition = position + text.size();
+		}
+		else if (operation < 9 || model.size() > 4096)
+		{
+			const size_t position = random() % (model.size() + 1);
+			const size_t length = random() % 32;
+			table.Erase(position, length);
+			model.erase(position, (std::min)(length, model.size() - position));
+			typingPosition = static_cast<size_t>(-1);
+		}
+		else if (random() % 50 == 0)
+		{
+			// Замена всего текста (изредка, чтобы дерево успевало вырасти)
+			model = randomText(64);
+			if (random() % 2) table.Assign(model); else table.Assign(std::string(model));
+			typingPosition = static_cast<size_t>(-1);
+		}
+
+		passed &= Verify(table, model, step);
+	}
+
+	// Вставка за концом документа дописывает в конец, удаление за концом ничего не делает
+	table.Insert(model.size() + 100, "tail\n");
+	model += "tail\n";
+	table.Erase(model.size() + 100, 10);
+	passed &= Verify(table, model, 3001);
+
+	table.Erase(0, model.size());
+	model.clear();
+	passed &= Verify(table, model, 3002);
+	passed &= Check(table.GetPieceCount() == 0, "empty document has no pieces", 3002);
+
+	if (passed) printf("All piece table checks passed\n");
+	return passed ? 0 : 1;
+}
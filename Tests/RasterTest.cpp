@@ -0,0 +1,189 @@
+/**
+* \brief Проверка растровых функций: векторные реализации (SSE2, AVX2) побитово совпадают со скалярной
+* \details Каждая функция выполняется на случайных данных (случайная длина и невыровненное начало отрезка) всеми
+* поддерживаемыми наборами инструкций, результат сверяется с результатом скалярной реализации, включая пиксели
+* вокруг отрезка (запись за его границы). Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+#include <random>
+
+#define RASTER_TEST_ROUNDS 3000
+#define RASTER_TEST_MAX_COUNT 300
+#define RASTER_TEST_GUARD 16
+
+/**
+* \brief Входные данные одного прогона
+*/
+struct RasterInput
+{
+	std::vector<std::uint32_t> dst;            // Пиксели (с запасом вокруг отрезка)
+	std::vector<std::uint32_t> src;            // Пиксели источника
+	std::vector<unsigned char> mask;           // Покрытие
+	size_t offset;                             // Начало отрезка в dst (невыровненное)
+	size_t count;                              // Кол-во пикселей
+	std::uint32_t pixel;                       // Пиксель заливки и наложения
+	std::uint32_t key;                         // Ключевой цвет
+	std::uint32_t to;                          // Конечный пиксель градиента
+	size_t gradientOffset;                     // Позиция отрезка в градиенте
+	size_t gradientLength;                     // Длина градиента
+};
+
+/**
+* \brief Растровая операция
+*/
+enum RasterOperation
+{
+	RASTER_OPERATION_FILL,
+	RASTER_OPERATION_BLEND,
+	RASTER_OPERATION_BLEND_SOLID,
+	RASTER_OPERATION_BLEND_MASK,
+	RASTER_OPERATION_COPY_KEYED,
+	RASTER_OPERATION_GRADIENT,
+	RASTER_OPERATION_COUNT
+};
+
+static const char* operationNames_[RASTER_OPERATION_COUNT] = { "FillPixels", "BlendPixels", "BlendSolidPixels", "BlendMaskPixels", "CopyPixelsKeyed", "GradientPixels" };
+
+/**
+* \brief Случайный пиксель (premultiplied или произвольный, с частыми крайними значениями альфа-канала)
+* \param random Генератор
+* \return Пиксель
+*/
+static std::uint32_t RandomPixel(std::mt19937& random)
+{
+	std::uint32_t pixel = static_cast<std::uint32_t>(random());
+
+	switch (random() % 4)
+	{
+	case 0: return pixel | 0xFF000000u;
+	case 1: return pixel & 0x00FFFFFFu;
+	case 2:
+	{
+		// Premultiplied: цветовые каналы не больше альфа-канала
+		const std::uint32_t alpha = pixel >> 24;
+		std::uint32_t result = alpha << 24;
+		for (int shift = 0; shift < 24; shift += 8) result |= (((pixel >> shift) & 0xFF) * alpha / 255) << shift;
+		return result;
+	}
+	default: return pixel;
+	}
+}
+
+/**
+* \brief Сгенерировать входные данные
+* \param random Генератор
+* \param input Входные данные
+*/
+static void Generate(std::mt19937& random, RasterInput& input)
+{
+	input.count = random() % (RASTER_TEST_MAX_COUNT + 1);
+	input.offset = RASTER_TEST_GUARD + random() % 8;
+
+	input.dst.resize(input.offset + input.count + RASTER_TEST_GUARD);
+	input.src.resize(input.dst.size());
+	input.mask.resize(input.dst.size());
+
+	input.pixel = RandomPixel(random);
+	input.key = RandomPixel(random);
+	input.to = RandomPixel(random);
+
+	for (std::uint32_t& pixel : input.dst) pixel = RandomPixel(random);
+
+	// Часть пикселей источника - ключевого цвета (с любым альфа-каналом)
+	for (std::uint32_t& pixel : input.src)
+		pixel = random() % 4 == 0 ? (input.key & 0x00FFFFFFu) | (static_cast<std::uint32_t>(random()) << 24) : RandomPixel(random);
+
+	// Покрытие - сплошные участки (0 и 255) и сглаженные края
+	for (unsigned char& coverage : input.mask)
+	{
+		const unsigned int kind = random() % 4;
+		coverage = kind == 0 ? 0 : kind == 1 ? 255 : static_cast<unsigned char>(random());
+	}
+
+	input.gradientOffset = random() % 64;
+	input.gradientLength = input.gradientOffset + input.count + random() % 64;
+}
+
+/**
+* \brief Выполнить операцию текущим набором инструкций
+* \param operation Операция
+* \param input Входные данные
+* \param dst Пиксели для записи (копия input.dst)
+*/
+static void Run(RasterOperation operation, const RasterInput& input, std::vector<std::uint32_t>& dst)
+{
+	dst = input.dst;
+	std::uint32_t* target = dst.data() + input.offset;
+	const std::uint32_t* source = input.src.data() + input.offset;
+	const unsigned char* mask = input.mask.data() + input.offset;
+
+	switch (operation)
+	{
+	case RASTER_OPERATION_FILL: wquery::FillPixels(target, input.count, input.pixel); break;
+	case RASTER_OPERATION_BLEND: wquery::BlendPixels(target, source, input.count); break;
+	case RASTER_OPERATION_BLEND_SOLID: wquery::BlendSolidPixels(target, input.count, input.pixel); break;
+	case RASTER_OPERATION_BLEND_MASK: wquery::BlendMaskPixels(target, mask, input.count, input.pixel); break;
+	case RASTER_OPERATION_COPY_KEYED: wquery::CopyPixelsKeyed(target, source, input.count, input.key); break;
+	case RASTER_OPERATION_GRADIENT: wquery::GradientPixels(target, input.count, input.pixel, input.to, input.gradientOffset, input.gradientLength); break;
+	default: break;
+	}
+}
+
+int main()
+{
+	bool passed = true;
+
+	const wquery::RasterKernel vectorKernels[] = { wquery::RASTER_KERNEL_SSE2, wquery::RASTER_KERNEL_AVX2 };
+	const wquery::RasterKernel defaultKernel = wquery::GetRasterKernel();
+
+	std::mt19937 random(2024);
+	RasterInput input;
+	std::vector<std::uint32_t> expected, actual;
+	size_t mismatches = 0;
+
+	for (const wquery::RasterKernel kernel : vectorKernels)
+	{
+		if (!wquery::SetRasterKernel(kernel))
+		{
+			printf("Skipped %s: not supported by the processor\n", wquery::GetRasterKernelName(kernel));
+			continue;
+		}
+
+		for (size_t round = 0; round < RASTER_TEST_ROUNDS; round++)
+		{
+			Generate(random, input);
+
+			for (int operation = 0; operation < RASTER_OPERATION_COUNT; operation++)
+			{
+				wquery::SetRasterKernel(wquery::RASTER_KERNEL_SCALAR);
+				Run(static_cast<RasterOperation>(operation), input, expected);
+
+				wquery::SetRasterKernel(kernel);
+				Run(static_cast<RasterOperation>(operation), input, actual);
+
+				if (actual == expected) continue;
+
+				passed = false;
+				if (mismatches++ < 10)
+				{
+					size_t i = 0;
+					while (actual[i] == expected[i]) i++;
+					printf("FAILED: %s (%s) differs from scalar at pixel %zd of %zu: %08X instead of %08X\n",
+						operationNames_[operation],
+						wquery::GetRasterKernelName(kernel),
+						static_cast<ptrdiff_t>(i) - static_cast<ptrdiff_t>(input.offset),
+						input.count,
+						actual[i],
+						expected[i]);
+				}
+			}
+		}
+	}
+
+	wquery::SetRasterKernel(defaultKernel);
+
+	if (passed) printf("All raster kernels match the scalar kernel\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+/**
+* \brief Проверка ревизии текста поля ввода: каждое изменение текста (программное или пользовательское)
+* увеличивает ревизию ровно на 1, в том числе когда системное поле уведомляет о нем через EN_CHANGE
+* \details Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what)
+{
+	if (!condition) printf("FAILED: %s\n", what);
+	return condition;
+}
+
+/**
+* \brief Проверить, что действие увеличивает ревизию текста на 1 и вызывает onChanged (если ожидается)
+* \param textBox Поле
+* \param changes Счетчик вызовов onChanged
+* \param expectedChanges Ожидаемое кол-во вызовов onChanged
+* \param action Действие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+template <typename F>
+static bool CheckRevision(const wquery::TextBox& textBox, const size_t& changes, size_t expectedChanges, F action, const char* what)
+{
+	const unsigned int revision = textBox.GetTextRevision();
+	const size_t before = changes;
+	action();
+	return Check(textBox.GetTextRevision() == revision + 1 && changes - before == expectedChanges, what);
+}
+
+int main()
+{
+	wquery::HeadlessBackend* backend = new wquery::HeadlessBackend();
+	wquery::SetBackend(std::unique_ptr<wquery::Backend>(backend));
+	wquery::Begin();
+
+	bool passed = true;
+
+	wquery::Window window;
+	wquery::TextBox edit(&window);
+	wquery::TextBox document(&window, wquery::ControlState(), wquery::TextBoxMode::DOCUMENT);
+
+	size_t editChanges = 0, documentChanges = 0;
+	edit.events.onChanged.Connect([&editChanges]() { editChanges++; });
+	document.events.onChanged.Connect([&documentChanges]() { documentChanges++; });
+
+	// До создания системного поля текст хранится в элементе, уведомлений нет
+	passed &= CheckRevision(edit, editChanges, 0, [&edit]() { edit.SetText("pending"); }, "pending text bumps the revision once");
+
+	window.Show();
+	passed &= Check(edit.IsCreated(), "edit control is created");
+
+	// Системное поле: запись текста приходит и как SetText, и как EN_CHANGE
+	passed &= CheckRevision(edit, editChanges, 1, [&edit]() { edit.SetText("one"); }, "SetText(const char*) bumps the revision once");
+	passed &= CheckRevision(edit, editChanges, 1, [&edit]() { edit.SetText(std::string_view("two")); }, "SetText(string_view) bumps the revision once");
+	passed &= CheckRevision(edit, editChanges, 1, [&edit]() { edit.SetText(std::u16string_view(u"three")); }, "SetText(u16string_view) bumps the revision once");
+	passed &= CheckRevision(edit, editChanges, 1, [&edit]() { edit.AppendText(" more"); }, "AppendText bumps the revision once");
+	passed &= CheckRevision(edit, editChanges, 1, [&edit, backend]() { backend->SimulateTyping(edit.GetNativeHandle(), "typed"); }, "typing bumps the revision once");
+	passed &= CheckRevision(edit, editChanges, 1, [&edit]() { static_cast<const wquery::ControlBase&>(edit).SetText("base"); }, "ControlBase::SetText bumps the revision once");
+	passed &= Check(edit.GetText() == "base", "edit holds the last text");
+
+	// Документ отмечает изменение сам при правке
+	passed &= CheckRevision(document, documentChanges, 1, [&document]() { document.SetText("document"); }, "document SetText bumps the revision once");
+	passed &= CheckRevision(document, documentChanges, 1, [&document]() { document.InsertText(0, "my "); }, "document InsertText bumps the revision once");
+	passed &= Check(document.GetText() == "my document", "document holds the edited text");
+
+	if (passed) printf("All text box checks passed\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+/**
+* \brief Проверка колеса таймеров: периодический таймер после задержки цикла
+* \details Код возврата 0 - все проверки пройдены
+*/
+
+#include "../WQuery/Include/wquery/wquery.h"
+#include <cstdio>
+
+/**
+* \brief Проверить условие
+* \param condition Условие
+* \param what Описание проверки
+* \return Выполнено ли условие
+*/
+static bool Check(bool condition, const char* what)
+{
+	if (!condition) printf("FAILED: %s\n", what);
+	return condition;
+}
+
+int main()
+{
+	bool passed = true;
+
+	wquery::TimerWheel wheel(0);
+	int calls = 0;
+	const wquery::TimerId id = wheel.Schedule(10, 10, [&calls]() { calls++; });
+
+	// Обычный ход времени - по одному срабатыванию на период
+	for (unsigned long long time = 1; time <= 50; time++) wheel.Advance(time);
+	passed &= Check(calls == 5, "periodic timer fires once per period");
+
+	// Задержка цикла на 10 секунд (1000 периодов) - одно срабатывание, пропущенные периоды не наверстываются
+	calls = 0;
+	passed &= Check(wheel.Advance(10050) == 1, "one timer fired after a stall");
+	passed &= Check(calls == 1, "periodic timer fires once after a stall");
+
+	// Фаза сохраняется: следующее срабатывание - ближайший период после времени продвижения
+	unsigned long long deadline = 0;
+	passed &= Check(wheel.GetNextDeadline(deadline) && deadline == 10060, "next deadline keeps the period phase");
+
+	// Задержка, не кратная периоду
+	calls = 0;
+	wheel.Advance(10095);
+	passed &= Check(calls == 1, "periodic timer fires once after an uneven stall");
+	passed &= Check(wheel.GetNextDeadline(deadline) && deadline == 10100, "next deadline after an uneven stall");
+
+	calls = 0;
+	wheel.Advance(10100);
+	passed &= Check(calls == 1 && wheel.IsActive(id), "periodic timer keeps running after a stall");
+
+	if (passed) printf("All timer wheel checks passed\n");
+	return passed ? 0 : 1;
+}
@@ -18,10 +18,27 @@ namespace wquery
 	{
 	private:
 
+	protected:
+		/**
+		* \brief Нарисовать кнопку без системного окна (фон, рамка и текст по центру)
+		* \param canvas Задний буфер окна
+		* \param rect Прямоугольник кнопки
+		*/
+		void PaintWindowless(Canvas& canvas, const RECT& rect) const override;
+
+		/**
+		* \brief Нажатие на кнопку без системного окна (при отпускании - уведомление BN_CLICKED, как от системной кнопки)
+		* \param message Сообщение мыши
+		*/
+		void HandleWindowlessMouse(UINT message) override;
+
 	public:
+		/**
+		* \brief Набор сигналов для различных событий (\see wquery::Signal)
+		*/
 		struct
 		{
-			std::function<void()> onClicked;
+			Signal<void()> onClicked;
 		} events;
 
 		/**
@@ -30,6 +47,13 @@ namespace wquery
 		*/
 		Button(Window * window);
 
+		/**
+		* \brief Конструктор с начальным состоянием (\see ControlState)
+		* \param window Владеющее окно
+		* \param state Начальное состояние
+		*/
+		Button(Window * window, const ControlState& state);
+
 		/**
 		* \brief Деструктор (унаследован от частично-вирутального)
 		*/
@@ -40,5 +64,17 @@ namespace wquery
 		* \return Строка с именем класса
 		*/
 		std::string GetControlClassName() override;
+
+		/**
+		* \brief Получить тег типа (при первом вызове тип регистрируется вместе с обработчиками уведомлений)
+		* \return Тег типа
+		*/
+		static unsigned int TypeTag();
+
+		/**
+		* \brief Дождаться нажатия (в сопрограмме: co_await button->Clicked())
+		* \return Ожидаемый объект (\see ControlBase::Notified)
+		*/
+		NotificationAwaiter Clicked();
 	};
 }
\ No newline at end of file
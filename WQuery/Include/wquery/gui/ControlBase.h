@@ -11,34 +11,204 @@
 
 #include "../stdafx.h"
 #include "../gui/Window.h"
+#include "../tools/Coroutine.h"
 
 namespace wquery
 {
+	class ControlBase;
+
+	/**
+	* \brief Обработчик уведомления элемента управления (WM_COMMAND с кодом уведомления)
+	* \param control Элемент управления, от которого пришло уведомление
+	* \param wParam Параметр сообщения WM_COMMAND
+	* \param lParam Параметр сообщения WM_COMMAND
+	*/
+	typedef void(*NotificationHandler)(ControlBase * control, WPARAM wParam, LPARAM lParam);
+
+	/**
+	* \brief Начальное состояние элемента управления
+	* \details Применяется при создании элемента: положение, размеры, текст, видимость, доступность и шрифт передаются
+	* системе вместе с созданием (без отдельных вызовов SetPosition, SetSize, SetFont и т.д.)
+	*/
+	struct ControlState
+	{
+		Vector2D<int> position;                // Положение
+		Vector2D<int> size;                    // Размеры
+		std::string_view text;                 // Текст (UTF-8)
+		AnchorSettings anchor;                 // Привязка к сторонам окна
+		const FontSettings* font;              // Шрифт (nullptr - шрифт по умолчанию)
+		bool visible;                          // Видимость
+		bool enabled;                          // Доступность
+		DWORD style;                           // Дополнительные стили элемента (напр. ES_PASSWORD для поля ввода)
+		bool windowless;                       // Элемент без системного окна (\see ControlBase::IsWindowless)
+
+		/**
+		* \brief Конструктор по умолчанию (видимый доступный элемент 150x30 в левом верхнем углу)
+		*/
+		ControlState() :
+			position(0, 0),
+			size(150, 30),
+			font(nullptr),
+			visible(true),
+			enabled(true),
+			style(0),
+			windowless(false) {}
+	};
+
 	class ControlBase
 	{
+		friend class Window;
+		friend class NotificationAwaiter;
+
 	protected:
+		// Свойства элемента, записанные до создания системного элемента (создается вместе с окном, \see Window::Window)
+		struct PendingControl
+		{
+			std::string className;                     // Наименование WinApi класса элемента
+			DWORD style;                               // Стиль (в том числе WS_VISIBLE и WS_DISABLED)
+			PendingText text;                          // Текст
+		};
+
 		// HWBD хендл элемента управления
 		HWND hWnd_;
 
+		// Свойства элемента до создания системного элемента (nullptr - элемент уже создан или не добавлен в окно)
+		std::unique_ptr<PendingControl> pending_;
+
+		// Тег типа элемента (выдается ControlBase::RegisterControlType, используется для диспетчеризации уведомлений)
+		unsigned int typeTag_;
+
 		// Указатель на родительское окно
 		Window * window_;
 
-		// Параметры привязки (якоря) элемента
-		AnchorSettings anchor_;
+		// Идентификатор элемента в хранилище геометрии окна (положение, размеры, привязка и флаги хранятся там)
+		// действителен только если элемент добавлен в окно (window_ не равен nullptr), даже если системный элемент еще не создан
+		unsigned int id_;
 
 		// Хендл кастомного шрифта
 		// по умолчанию он равен nullptr, но будет присвоен при указании кастомного шрифта
 		// чтобы при повторном указании можно было уничтожить объект относящийся к этому хендлу
 		HFONT customFont_;
 
+		// Ревизия текста (увеличивается на 1 при каждом изменении текста, как программном так и пользовательском)
+		mutable unsigned int textRevision_;
+
+		// Сопрограмма, ожидающая уведомления элемента (\see ControlBase::Notified)
+		struct NotificationWaiter
+		{
+			WORD code;                                 // Код уведомления
+			std::coroutine_handle<> coroutine;         // Сопрограмма
+			bool* received;                            // Результат ожидания (в объекте ожидания)
+		};
+
+		// Сопрограммы, ожидающие уведомлений (продолжаются при уведомлении или уничтожении элемента)
+		std::vector<NotificationWaiter> waiters_;
+
+		/**
+		* \brief Запросить отложенную перерисовку области окна, занимаемой элементом (\see Window::Invalidate)
+		*/
+		void InvalidateWindowArea() const;
+
+		/**
+		* \brief Нарисовать элемент без системного окна в заднем буфере окна
+		* \details По умолчанию рисуется только текст (по левому краю, по центру по вертикали).
+		* Отсечение холста уже ограничено областью элемента
+		* \param canvas Задний буфер окна
+		* \param rect Прямоугольник элемента (в координатах клиентской области)
+		*/
+		virtual void PaintWindowless(Canvas& canvas, const RECT& rect) const;
+
+		/**
+		* \brief Обработать нажатие мыши на элементе без системного окна
+		* \details Вызывается окном для доступного элемента: WM_LBUTTONDOWN - при нажатии, WM_LBUTTONUP - только если
+		* кнопка отпущена над тем же элементом, над которым была нажата. По умолчанию ничего не делает
+		* \param message Сообщение (WM_LBUTTONDOWN или WM_LBUTTONUP)
+		*/
+		virtual void HandleWindowlessMouse(UINT message);
+
+		/**
+		* \brief Обработать прокрутку колеса мыши над элементом без системного окна (по умолчанию ничего не делает)
+		* \param delta Величина прокрутки (кратна WHEEL_DELTA, положительная - от пользователя)
+		*/
+		virtual void HandleWindowlessWheel(int delta);
+
+		/**
+		* \brief Обработать ввод с клавиатуры элементом без системного окна (по умолчанию ничего не делает)
+		* \details Ввод получает доступный элемент, на котором последним нажата левая кнопка мыши
+		* \param message Сообщение (WM_KEYDOWN - код клавиши, WM_CHAR - символ UTF-16)
+		* \param code Код клавиши или символ
+		*/
+		virtual void HandleWindowlessKey(UINT message, WPARAM code);
+
+		/**
+		* \brief Получает ли элемент без системного окна ввод с клавиатуры
+		* \return Статус
+		*/
+		bool HasWindowlessFocus() const;
+
+		/**
+		* \brief Рисуется ли элемент только окном (системный элемент не создается даже при обращении к хендлу)
+		* \details По умолчанию нет - элемент без системного окна создает его при первом обращении к хендлу
+		* \return Статус
+		*/
+		virtual bool IsWindowlessOnly() const;
+
+		/**
+		* \brief Получить текст и шрифт для рисования элемента без системного окна
+		* \param text Строка для записи текста (UTF-8)
+		* \param font Параметры шрифта
+		*/
+		void GetPaintText(std::string& text, FontSettings& font) const;
+
+		/**
+		* \brief Зарегистрировать элемент в окне (системный элемент создается сразу, только если окно уже создано)
+		* \param controlClassName Наименование WinApi класса элемента управления
+		* \param dwStyle Стиль элемента
+		* \param position Положение
+		* \param size Размеры
+		* \param text Начальный текст
+		* \param windowless Элемент без системного окна
+		*/
+		void Attach(const std::string& controlClassName, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, std::string_view text, bool windowless);
+
+		/**
+		* \brief Создать системный элемент по записанным свойствам (шрифт отправляется элементу один раз)
+		*/
+		void CreateNative();
+
+		/**
+		* \brief Получить стиль элемента (до создания - записанный)
+		* \return Стиль
+		*/
+		DWORD GetStyle() const;
+
+		/**
+		* \brief Установить стиль элемента (до создания - только записать)
+		* \param dwStyle Стиль
+		*/
+		void SetStyle(DWORD dwStyle) const;
+
 	public:
 		/**
 		* \brief Конструктор элемента управления
 		* \param window Указатель на владеющее окно
+		* \param typeTag Тег типа элемента (\see ControlBase::RegisterControlType)
 		* \param controlClassName Наименовая WinApi класса элемента управления
 		* \param dwStyle Стиль отображения элемента
 		*/
-		ControlBase(Window * window, const std::string& controlClassName, DWORD dwStyle = WS_CHILD | WS_VISIBLE, const Vector2D<int>& defaultSizes = {150,30});
+		ControlBase(Window * window, unsigned int typeTag, const std::string& controlClassName, DWORD dwStyle = WS_CHILD | WS_VISIBLE, const Vector2D<int>& defaultSizes = {150,30});
+
+		/**
+		* \brief Конструктор элемента управления с начальным состоянием
+		* \details Элемент создается сразу в нужном положении, с нужными размерами, текстом, стилем и шрифтом.
+		* Начальный текст не порождает уведомлений об изменении (напр. TextBox::events.onChanged)
+		* \param window Указатель на владеющее окно
+		* \param typeTag Тег типа элемента (\see ControlBase::RegisterControlType)
+		* \param controlClassName Наименовая WinApi класса элемента управления
+		* \param dwStyle Стиль отображения элемента (WS_VISIBLE и WS_DISABLED определяются состоянием)
+		* \param state Начальное состояние
+		*/
+		ControlBase(Window * window, unsigned int typeTag, const std::string& controlClassName, DWORD dwStyle, const ControlState& state);
 
 		/**
 		* \brief Деструктор (вирутальный, уничтожает в том числе и объект-наследник)
@@ -52,29 +222,159 @@ namespace wquery
 		*/
 		virtual std::string GetControlClassName() = 0;
 
+		/**
+		* \brief Получить тег типа элемента
+		* \return Тег типа
+		*/
+		unsigned int GetTypeTag() const;
+
+		/**
+		* \brief Зарегистрировать новый тип элемента управления
+		* \details Вызывается однократно для каждого класса-наследника (обычно при создании первого экземпляра)
+		* \return Тег типа (небольшое целое число, индекс в таблицах диспетчеризации)
+		*/
+		static unsigned int RegisterControlType();
+
+		/**
+		* \brief Зарегистрировать обработчик уведомления для типа элемента
+		* \details Оконная процедура окна при получении WM_COMMAND находит обработчик по коду уведомления
+		* и тегу типа элемента (два обращения по индексу), поэтому новые типы элементов подключаются без
+		* изменения Window::WndProc
+		* \param typeTag Тег типа элемента
+		* \param code Код уведомления (HIWORD(wParam) сообщения WM_COMMAND, напр. BN_CLICKED, EN_CHANGE)
+		* \param handler Обработчик
+		*/
+		static void RegisterNotification(unsigned int typeTag, WORD code, NotificationHandler handler);
+
+		/**
+		* \brief Передать уведомление зарегистрированному обработчику
+		* \param control Элемент управления, от которого пришло уведомление
+		* \param wParam Параметр сообщения WM_COMMAND
+		* \param lParam Параметр сообщения WM_COMMAND
+		* \return Был ли найден обработчик (или ожидающая уведомления сопрограмма)
+		*/
+		static bool DispatchNotification(ControlBase * control, WPARAM wParam, LPARAM lParam);
+
+		/**
+		* \brief Дождаться уведомления элемента (в сопрограмме: co_await control->Notified(code))
+		* \details Сопрограмма продолжается на следующей итерации основного цикла после уведомления. Если элемент
+		* уничтожен раньше - продолжается с результатом false (обращаться к элементу после этого нельзя)
+		* \param code Код уведомления (HIWORD(wParam) сообщения WM_COMMAND)
+		* \return Ожидаемый объект
+		*/
+		NotificationAwaiter Notified(WORD code);
+
 		/**
 		* \brief Получить указатель на владеющее окно
 		* \return Указатель
 		*/
 		Window* GetWindow() const;
 
+		/**
+		* \brief Получить хендл элемента управления (если окно еще не создано - оно создается вместе с элементами)
+		* \return Хендл
+		*/
+		HWND GetNativeHandle() const;
+
+		/**
+		* \brief Создан ли системный элемент
+		* \return Статус
+		*/
+		bool IsCreated() const;
+
+		/**
+		* \brief Является ли элемент элементом без системного окна
+		* \details Такой элемент (ControlState::windowless) не создает системного окна: окно рисует его в своем
+		* заднем буфере и передает ему нажатия мыши, найденные по хранилищу геометрии. Системный элемент создается
+		* только когда он действительно нужен - при обращении к хендлу (напр. поле ввода при получении фокуса), после
+		* чего элемент становится обычным
+		* \return Статус
+		*/
+		bool IsWindowless() const;
+
 		/**
 		* \brief Установить текст элемента управления
 		* \param text Текст
 		*/
 		void SetText(const std::string &text) const;
 
+		/**
+		* \brief Установить текст элемента управления
+		* \param text Текст (нуль-терминированная строка)
+		*/
+		void SetText(const char * text) const;
+
+		/**
+		* \brief Установить текст элемента управления
+		* \param text Текст (представление строки, нуль-терминатор не обязателен)
+		*/
+		void SetText(std::string_view text) const;
+
+		/**
+		* \brief Установить текст элемента управления
+		* \param text Текст в UTF-16 (передается системе без преобразования в ANSI)
+		*/
+		void SetText(std::u16string_view text) const;
+
 		/**
 		* \brief Получить текст элемента управления
 		* \return Текст
 		*/
 		std::string GetText() const;
 
+		/**
+		* \brief Получить текст элемента управления в существующую строку
+		* \details Память строки переиспользуется, при повторных чтениях выделений не происходит
+		* \param text Строка для записи
+		*/
+		void GetText(std::string& text) const;
+
+		/**
+		* \brief Получить текст элемента управления в существующую UTF-16 строку
+		* \param text Строка для записи
+		*/
+		void GetText(std::u16string& text) const;
+
+		/**
+		* \brief Получить текст элемента управления в буфер
+		* \param buffer Буфер (текст обрезается до capacity - 1 символов, всегда завершается нулем)
+		* \param capacity Размер буфера
+		* \return Кол-во записанных символов (без нуль-терминатора)
+		*/
+		size_t GetText(char * buffer, size_t capacity) const;
+
+		/**
+		* \brief Получить текст элемента управления в UTF-16 буфер
+		* \param buffer Буфер (текст обрезается до capacity - 1 символов, всегда завершается нулем)
+		* \param capacity Размер буфера
+		* \return Кол-во записанных символов (без нуль-терминатора)
+		*/
+		size_t GetText(char16_t * buffer, size_t capacity) const;
+
+		/**
+		* \brief Получить длину текста элемента управления
+		* \return Длина (без нуль-терминатора)
+		*/
+		size_t GetTextLength() const;
+
+		/**
+		* \brief Получить ревизию текста
+		* \details Если ревизия не изменилась с прошлого чтения - текст тоже не изменился и читать его повторно не нужно
+		* \return Номер ревизии
+		*/
+		unsigned int GetTextRevision() const;
+
+		/**
+		* \brief Отметить изменение текста (увеличить ревизию)
+		* \details Вызывается классами-наследниками при получении уведомлений об изменении текста пользователем
+		*/
+		void MarkTextChanged() const;
+
 		/**
 		* \brief Установить положение
 		* \param position Положение
 		*/
-		void SetPosition(Vector2D<int> position) const;
+		void SetPosition(Vector2D<int> position);
 
 		/**
 		* \brief Получить положение
@@ -86,7 +386,7 @@ namespace wquery
 		* \brief Установить размеры
 		* \param size Размеры
 		*/
-		void SetSize(Vector2D<int> size) const;
+		void SetSize(Vector2D<int> size);
 
 		/**
 		* \brief Получить размеры
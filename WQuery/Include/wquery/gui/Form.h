@@ -0,0 +1,235 @@
+﻿/**
+* \brief Формы, загружаемые из бинарного описания (интерфейс)
+* \details Описание формы (окно, элементы управления, их положение, размеры, привязка, шрифты и текст) пишется
+* в текстовом виде и компилируется в компактный бинарный файл (\see wquery::CompileForm, утилита FormCompiler).
+* Во время работы файл отображается в память и форма создается за один проход по записям: каждый элемент
+* создается сразу с начальным состоянием (\see ControlState), окно показывается только после создания всех
+* элементов. Записи файла имеют фиксированный размер и выравнивание, поэтому читаются прямо из отображения
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../types/common.h"
+#include "Window.h"
+#include "ControlBase.h"
+
+namespace wquery
+{
+	/*
+	* Б И Н А Р Н Ы Й  Ф О Р М А Т
+	*
+	* Файл: заголовок (FormHeader, включает запись окна), таблица шрифтов (FormFontRecord), таблица элементов
+	* (FormControlRecord), таблица строк (UTF-8 строки с нуль-терминатором подряд, первая - пустая строка).
+	* Все числа - little-endian, все таблицы выровнены по 4 байта. Строки задаются смещением в таблице строк
+	*/
+
+	/**
+	* \brief Сигнатура файла формы ("WQFM")
+	*/
+	const std::uint32_t FORM_MAGIC = 0x4D465157;
+
+	/**
+	* \brief Версия формата
+	*/
+	const std::uint32_t FORM_VERSION = 1;
+
+	/**
+	* \brief Тип элемента управления в описании формы
+	*/
+	enum FormControlType : std::uint32_t
+	{
+		FORM_CONTROL_BUTTON = 1,
+		FORM_CONTROL_TEXTBOX = 2
+	};
+
+	/**
+	* \brief Флаги записей описания формы
+	*/
+	enum FormFlags : std::uint32_t
+	{
+		FORM_FLAG_HIDDEN = 1 << 0,             // Окно или элемент скрыт
+		FORM_FLAG_DISABLED = 1 << 1,           // Элемент недоступен
+		FORM_FLAG_PASSWORD = 1 << 2,           // Поле ввода пароля
+		FORM_FLAG_ANCHOR_LEFT = 1 << 3,        // Привязка к левой стороне
+		FORM_FLAG_ANCHOR_TOP = 1 << 4,         // Привязка к верхней стороне
+		FORM_FLAG_ANCHOR_RIGHT = 1 << 5,       // Привязка к правой стороне
+		FORM_FLAG_ANCHOR_BOTTOM = 1 << 6,      // Привязка к нижней стороне
+		FORM_FLAG_CLOSES_PROGRAM = 1 << 7,     // Закрытие окна завершает программу
+		FORM_FLAG_POSITION = 1 << 8,           // Положение окна задано
+		FORM_FLAG_MIN_SIZE = 1 << 9,           // Минимальные размеры окна заданы
+		FORM_FLAG_MAX_SIZE = 1 << 10,          // Максимальные размеры окна заданы
+		FORM_FLAG_BG_COLOR = 1 << 11,          // Цвет фона окна задан
+		FORM_FLAG_BOLD = 1 << 12,              // Жирный шрифт
+		FORM_FLAG_ITALIC = 1 << 13,            // Курсив
+		FORM_FLAG_WINDOWLESS = 1 << 14,        // Элемент без системного окна (\see ControlBase::IsWindowless)
+		FORM_FLAG_DOCUMENT = 1 << 15           // Поле ввода в режиме документа (\see TextBoxMode::DOCUMENT)
+	};
+
+	/**
+	* \brief Запись окна
+	*/
+	struct FormWindowRecord
+	{
+		std::uint32_t title;                   // Заголовок (смещение строки)
+		std::uint32_t flags;                   // Флаги (FormFlags)
+		std::int32_t x, y;                     // Положение
+		std::int32_t width, height;            // Размеры клиентской области
+		std::int32_t minWidth, minHeight;      // Минимальные размеры клиентской области
+		std::int32_t maxWidth, maxHeight;      // Максимальные размеры клиентской области
+		std::uint32_t bgColor;                 // Цвет фона (0x00RRGGBB)
+	};
+
+	/**
+	* \brief Заголовок файла формы
+	*/
+	struct FormHeader
+	{
+		std::uint32_t magic;                   // Сигнатура (FORM_MAGIC)
+		std::uint32_t version;                 // Версия формата (FORM_VERSION)
+		std::uint32_t fileSize;                // Размер файла
+		std::uint32_t fontCount;               // Кол-во шрифтов
+		std::uint32_t controlCount;            // Кол-во элементов
+		std::uint32_t fontsOffset;             // Смещение таблицы шрифтов от начала файла
+		std::uint32_t controlsOffset;          // Смещение таблицы элементов от начала файла
+		std::uint32_t stringsOffset;           // Смещение таблицы строк от начала файла
+		std::uint32_t stringsSize;             // Размер таблицы строк
+		FormWindowRecord window;               // Окно
+	};
+
+	/**
+	* \brief Запись шрифта
+	*/
+	struct FormFontRecord
+	{
+		std::uint32_t family;                  // Имя семейства (смещение строки)
+		std::uint32_t size;                    // Размер
+		std::uint32_t flags;                   // Флаги (FORM_FLAG_BOLD, FORM_FLAG_ITALIC)
+	};
+
+	/**
+	* \brief Запись элемента управления
+	*/
+	struct FormControlRecord
+	{
+		std::uint32_t type;                    // Тип (FormControlType)
+		std::uint32_t flags;                   // Флаги (FormFlags)
+		std::uint32_t name;                    // Имя для поиска элемента (смещение строки, пустое - без имени)
+		std::uint32_t text;                    // Текст (смещение строки)
+		std::int32_t x, y;                     // Положение
+		std::int32_t width, height;            // Размеры
+		std::uint32_t font;                    // Номер шрифта в таблице + 1 (0 - шрифт по умолчанию)
+	};
+
+	static_assert(sizeof(FormWindowRecord) == 44, "FormWindowRecord layout");
+	static_assert(sizeof(FormHeader) == 80, "FormHeader layout");
+	static_assert(sizeof(FormFontRecord) == 12, "FormFontRecord layout");
+	static_assert(sizeof(FormControlRecord) == 36, "FormControlRecord layout");
+
+	/**
+	* \brief Скомпилировать текстовое описание формы в бинарное
+	* \details Описание состоит из строк вида "команда аргументы параметры", # начинает комментарий до конца строки,
+	* строки в двойных кавычках поддерживают экранирование \\", \\\\, \\n и \\t:
+	*
+	*     window "Заголовок" size 400 200 [min W H] [max W H] [position X Y] [color R G B] [closes] [hidden]
+	*     font ИМЯ "Семейство" РАЗМЕР [bold] [italic]
+	*     button ИМЯ "Текст" at X Y size W H [anchor left top right bottom] [font ИМЯ] [disabled] [hidden] [windowless]
+	*     textbox ИМЯ "Текст" at X Y size W H [password] [document] [anchor ...] [font ИМЯ] [disabled] [hidden] [windowless]
+	*
+	* Команда window обязательна и встречается один раз, шрифт объявляется до использования, имена элементов
+	* уникальны (имя "-" - элемент без имени)
+	* \param source Текстовое описание (UTF-8)
+	* \param binary Бинарное описание (заменяется)
+	* \param error Описание ошибки вида "line N: message" (при неудаче)
+	* \return Удалось ли скомпилировать
+	*/
+	bool CompileForm(std::string_view source, std::vector<unsigned char>& binary, std::string& error);
+
+	class Form
+	{
+	private:
+		std::unique_ptr<Window> window_;                              // Окно
+		std::vector<std::unique_ptr<ControlBase>> controls_;          // Элементы в порядке описания
+		std::map<std::string, ControlBase*, std::less<>> names_;      // Элементы по именам
+
+		/**
+		* \brief Проверить бинарное описание (границы таблиц, строки, номера шрифтов, типы элементов)
+		* \param data Описание (выровнено по 4 байта)
+		* \param size Размер описания
+		* \return Корректно ли описание
+		*/
+		static bool Validate(const unsigned char* data, size_t size);
+
+		/**
+		* \brief Создать окно и элементы по проверенному описанию
+		* \param data Описание
+		*/
+		void Instantiate(const unsigned char* data);
+
+	public:
+		/**
+		* \brief Конструктор (пустая форма)
+		*/
+		Form();
+
+		/**
+		* \brief Деструктор (окно уничтожается вместе со всеми элементами)
+		*/
+		~Form();
+
+		Form(const Form&) = delete;
+		Form& operator=(const Form&) = delete;
+
+		/**
+		* \brief Загрузить форму из файла (файл отображается в память на время загрузки)
+		* \details Ранее загруженная форма уничтожается. Окно показывается, если оно не помечено скрытым
+		* \param path Путь к бинарному описанию (UTF-8)
+		* \return Удалось ли загрузить
+		*/
+		bool Load(const std::string& path);
+
+		/**
+		* \brief Загрузить форму из памяти (напр. из ресурса программы)
+		* \param data Бинарное описание
+		* \param size Размер описания
+		* \return Удалось ли загрузить
+		*/
+		bool Load(const void* data, size_t size);
+
+		/**
+		* \brief Уничтожить форму
+		*/
+		void Clear();
+
+		/**
+		* \brief Получить окно
+		* \return Указатель на окно (nullptr, если форма не загружена)
+		*/
+		Window* GetWindow() const;
+
+		/**
+		* \brief Найти элемент по имени
+		* \param name Имя
+		* \return Указатель на элемент (nullptr, если не найден)
+		*/
+		ControlBase* Find(std::string_view name) const;
+
+		/**
+		* \brief Найти элемент заданного типа по имени
+		* \param name Имя
+		* \return Указатель на элемент (nullptr, если не найден или имеет другой тип)
+		*/
+		template <typename T>
+		T* Get(std::string_view name) const
+		{
+			ControlBase* control = this->Find(name);
+			return control && control->GetTypeTag() == T::TypeTag() ? static_cast<T*>(control) : nullptr;
+		}
+
+		/**
+		* \brief Получить кол-во элементов
+		* \return Кол-во элементов
+		*/
+		size_t GetControlCount() const;
+	};
+}
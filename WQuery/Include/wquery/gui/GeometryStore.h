@@ -0,0 +1,222 @@
+﻿/**
+* \brief Хранилище геометрии элементов управления окна (интерфейс)
+* \details Положения, размеры, привязки и флаги всех элементов окна хранятся в отдельных непрерывных массивах
+* (структура массивов) и адресуются компактным идентификатором элемента (индексом). Раскладка, поиск элемента
+* по точке и изменение размеров проходят по этим массивам последовательно, без обращений к системе
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../types/common.h"
+
+namespace wquery
+{
+	class ControlBase;
+
+	/**
+	* \brief Флаги элемента в хранилище геометрии
+	*/
+	enum GeometryFlags
+	{
+		GEOMETRY_HIDDEN = 1 << 0,              // Элемент невидим (не участвует в поиске по точке)
+		GEOMETRY_DISABLED = 1 << 1,            // Элемент неактивен
+		GEOMETRY_WINDOWLESS = 1 << 2,          // Элемент без системного окна (рисуется и обрабатывает мышь через окно)
+		GEOMETRY_REMOVED = 1 << 3              // Место удаленного элемента (до уплотнения, \see GeometryStore::Compact)
+	};
+
+	/**
+	* \brief Упакованные параметры привязки (якоря)
+	*/
+	enum AnchorBits
+	{
+		ANCHOR_LEFT = 1 << 0,
+		ANCHOR_TOP = 1 << 1,
+		ANCHOR_RIGHT = 1 << 2,
+		ANCHOR_BOTTOM = 1 << 3
+	};
+
+	class GeometryStore
+	{
+	private:
+		std::vector<int> x_;                   // Положение левой стороны
+		std::vector<int> y_;                   // Положение верха
+		std::vector<int> width_;               // Ширина
+		std::vector<int> height_;              // Высота
+		std::vector<unsigned char> anchors_;   // Привязки (AnchorBits)
+		std::vector<unsigned char> flags_;     // Флаги (GeometryFlags)
+		std::vector<HWND> handles_;            // Хендлы элементов
+		std::vector<ControlBase*> owners_;     // Объекты элементов
+		unsigned int removed_ = 0;             // Кол-во мест удаленных элементов
+
+		// Идентификаторы элементов, привязанных к правой стороне, к нижней и к любой из них (по возрастанию) -
+		// это и есть изменившиеся при раскладке элементы, списки пересобираются только после изменения привязок
+		std::vector<unsigned int> anchored_[3];
+		bool anchoredValid_ = true;
+
+		/**
+		* \brief Пересобрать списки элементов, привязанных к правой (нижней) стороне
+		*/
+		void IndexAnchored();
+
+	public:
+		/**
+		* \brief Упаковать параметры привязки в битовую маску
+		* \param anchor Параметры привязки
+		* \return Маска (AnchorBits)
+		*/
+		static unsigned char PackAnchor(const AnchorSettings& anchor);
+
+		/**
+		* \brief Распаковать битовую маску привязки
+		* \param bits Маска (AnchorBits)
+		* \return Параметры привязки
+		*/
+		static AnchorSettings UnpackAnchor(unsigned char bits);
+
+		/**
+		* \brief Добавить элемент
+		* \param owner Объект элемента
+		* \param hWnd Хендл элемента
+		* \param position Положение
+		* \param size Размеры
+		* \param flags Флаги (GeometryFlags)
+		* \return Идентификатор элемента
+		*/
+		unsigned int Add(ControlBase * owner, HWND hWnd, const Vector2D<int>& position, const Vector2D<int>& size, unsigned char flags = 0);
+
+		/**
+		* \brief Удалить элемент
+		* \details Удаление выполняется за O(1): место элемента остается в массивах (скрытым, без объекта и привязки),
+		* идентификаторы остальных элементов не меняются. Места освобождаются уплотнением (\see GeometryStore::Compact)
+		* \param id Идентификатор элемента
+		*/
+		void Remove(unsigned int id);
+
+		/**
+		* \brief Уплотнить хранилище (убрать места удаленных элементов)
+		* \details Порядок элементов сохраняется (от него зависит поиск по точке), идентификаторы элементов
+		* после удаленных уменьшаются. Уплотнение после того, как удаленные составят половину мест, дает
+		* амортизированное O(1) на удаление
+		*/
+		void Compact();
+
+		/**
+		* \brief Кол-во мест удаленных элементов (до уплотнения)
+		* \return Кол-во
+		*/
+		unsigned int GetRemovedCount() const;
+
+		/**
+		* \brief Кол-во элементов (включая места удаленных элементов)
+		* \return Кол-во
+		*/
+		unsigned int GetCount() const;
+
+		/**
+		* \brief Получить объект элемента
+		* \param id Идентификатор элемента
+		* \return Указатель на объект (nullptr для места удаленного элемента)
+		*/
+		ControlBase* GetOwner(unsigned int id) const;
+
+		/**
+		* \brief Получить хендл элемента
+		* \param id Идентификатор элемента
+		* \return Хендл
+		*/
+		HWND GetHandle(unsigned int id) const;
+
+		/**
+		* \brief Установить хендл элемента (при отложенном создании системного элемента)
+		* \param id Идентификатор элемента
+		* \param hWnd Хендл
+		*/
+		void SetHandle(unsigned int id, HWND hWnd);
+
+		/**
+		* \brief Установить положение
+		* \param id Идентификатор элемента
+		* \param position Положение
+		*/
+		void SetPosition(unsigned int id, const Vector2D<int>& position);
+
+		/**
+		* \brief Получить положение
+		* \param id Идентификатор элемента
+		* \return Положение
+		*/
+		Vector2D<int> GetPosition(unsigned int id) const;
+
+		/**
+		* \brief Установить размеры
+		* \param id Идентификатор элемента
+		* \param size Размеры
+		*/
+		void SetSize(unsigned int id, const Vector2D<int>& size);
+
+		/**
+		* \brief Получить размеры
+		* \param id Идентификатор элемента
+		* \return Размеры
+		*/
+		Vector2D<int> GetSize(unsigned int id) const;
+
+		/**
+		* \brief Установить привязку
+		* \param id Идентификатор элемента
+		* \param anchor Параметры привязки
+		*/
+		void SetAnchor(unsigned int id, const AnchorSettings& anchor);
+
+		/**
+		* \brief Получить привязку
+		* \param id Идентификатор элемента
+		* \return Параметры привязки
+		*/
+		AnchorSettings GetAnchor(unsigned int id) const;
+
+		/**
+		* \brief Установить или снять флаг
+		* \param id Идентификатор элемента
+		* \param flag Флаг (GeometryFlags)
+		* \param state Установить (true) или снять (false)
+		*/
+		void SetFlag(unsigned int id, GeometryFlags flag, bool state);
+
+		/**
+		* \brief Установлен ли флаг
+		* \param id Идентификатор элемента
+		* \param flag Флаг (GeometryFlags)
+		* \return Состояние
+		*/
+		bool HasFlag(unsigned int id, GeometryFlags flag) const;
+
+		/**
+		* \brief Пересчитать положения и размеры всех элементов при изменении размеров контейнера
+		* \details Привязка к двум противоположным сторонам растягивает элемент, привязка только к правой (нижней)
+		* стороне перемещает его вместе с этой стороной, в остальных случаях элемент остается на месте
+		* \param sizingDelta Изменение размеров клиентской области контейнера
+		* \param changed Массив, в который дописываются идентификаторы изменившихся элементов
+		* \return Кол-во изменившихся элементов
+		*/
+		size_t Layout(const Vector2D<int>& sizingDelta, std::vector<unsigned int>& changed);
+
+		/**
+		* \brief Найти видимый элемент, содержащий точку
+		* \details При перекрытии выигрывает элемент, добавленный позже
+		* \param point Точка (в координатах клиентской области контейнера)
+		* \return Идентификатор элемента (-1 если не найден)
+		*/
+		int HitTest(const Vector2D<int>& point) const;
+
+		/**
+		* \brief Найти видимые элементы с заданными флагами, пересекающие прямоугольник
+		* \param rect Прямоугольник (в координатах клиентской области контейнера)
+		* \param flags Флаги, которые должны быть установлены у элемента (GeometryFlags)
+		* \param found Массив, в который дописываются идентификаторы (в порядке добавления элементов)
+		* \return Кол-во найденных элементов
+		*/
+		size_t Intersect(const RECT& rect, unsigned char flags, std::vector<unsigned int>& found) const;
+	};
+}
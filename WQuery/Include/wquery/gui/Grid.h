@@ -0,0 +1,287 @@
+﻿/**
+* \brief Класс элемента управления "таблица" с виртуализацией данных (интерфейс)
+* \details Таблица не хранит данных: строки запрашиваются у источника данных только когда они видны,
+* поэтому кол-во строк ограничено лишь типом size_t. Для видимых строк держится кольцо ячеек (строка N
+* занимает ячейку N % кол-во видимых строк) - при прокрутке запрашиваются только вновь открывшиеся строки,
+* а память строк ячеек переиспользуется. Таблица всегда рисуется окном (элемент без системного окна),
+* стоимость прокрутки и перерисовки не зависит от кол-ва строк
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../gui/Window.h"
+#include "../gui/ControlBase.h"
+#include "../tools/Delegate.h"
+
+namespace wquery
+{
+	/**
+	* \brief Источник данных таблицы
+	* \details Заполняет текст ячеек строки (UTF-8). Массив уже содержит по пустой строке на каждый столбец,
+	* строки следует заполнять присваиванием (их память переиспользуется между запросами)
+	*/
+	typedef Delegate<void(size_t row, std::vector<std::string>& cells)> GridDataSource;
+
+	/**
+	* \brief Столбец таблицы
+	*/
+	struct GridColumn
+	{
+		std::string title;                     // Заголовок
+		int width;                             // Ширина (в пикселях)
+	};
+
+	class Grid : public ControlBase
+	{
+	private:
+		// Ячейка кольца видимых строк
+		struct RowSlot
+		{
+			size_t row;                                // Индекс строки в ячейке
+			bool valid;                                // Заполнена ли ячейка (строка row получена от источника)
+			std::vector<std::string> cells;            // Текст ячеек строки
+		};
+
+		// Столбцы
+		std::vector<GridColumn> columns_;
+
+		// Источник данных
+		GridDataSource dataSource_;
+
+		// Кол-во строк
+		size_t rowCount_;
+
+		// Первая видимая строка
+		size_t firstRow_;
+
+		// Выбранная строка (NO_ROW - не выбрана)
+		size_t selectedRow_;
+
+		// Высота строки (и заголовка)
+		int rowHeight_;
+
+		// Остаток прокрутки колесом (меньше одного шага)
+		int wheelRemainder_;
+
+		// Кольцо видимых строк (заполняется при рисовании)
+		mutable std::vector<RowSlot> slots_;
+
+		/**
+		* \brief Получить строку из кольца (при отсутствии - запросить у источника данных)
+		* \param row Индекс строки
+		* \return Ячейка кольца
+		*/
+		const RowSlot& FetchRow(size_t row) const;
+
+		/**
+		* \brief Сбросить заполненность кольца (строки будут запрошены заново)
+		*/
+		void InvalidateSlots() const;
+
+		/**
+		* \brief Получить наибольшую первую видимую строку (последняя строка видна полностью)
+		* \return Индекс строки
+		*/
+		size_t GetMaxFirstRow() const;
+
+		/**
+		* \brief Получить прямоугольник полосы прокрутки
+		* \param rect Прямоугольник таблицы
+		* \return Прямоугольник полосы (пустой - полоса не нужна)
+		*/
+		RECT GetScrollBarRect(const RECT& rect) const;
+
+		/**
+		* \brief Получить прямоугольник ползунка полосы прокрутки
+		* \param bar Прямоугольник полосы
+		* \return Прямоугольник ползунка
+		*/
+		RECT GetScrollThumbRect(const RECT& bar) const;
+
+		/**
+		* \brief Получить прямоугольник таблицы (в координатах клиентской области окна)
+		* \return Прямоугольник
+		*/
+		RECT GetRect() const;
+
+	protected:
+		/**
+		* \brief Нарисовать видимые строки таблицы (запрашиваются только строки, попавшие в область перерисовки)
+		* \param canvas Задний буфер окна
+		* \param rect Прямоугольник таблицы
+		*/
+		void PaintWindowless(Canvas& canvas, const RECT& rect) const override;
+
+		/**
+		* \brief Нажатие на таблицу (выбор строки или перемещение по полосе прокрутки)
+		* \param message Сообщение мыши
+		*/
+		void HandleWindowlessMouse(UINT message) override;
+
+		/**
+		* \brief Прокрутка колесом мыши (три строки на шаг WHEEL_DELTA)
+		* \param delta Величина прокрутки
+		*/
+		void HandleWindowlessWheel(int delta) override;
+
+		/**
+		* \brief Таблица рисуется только окном
+		* \return Статус (всегда true)
+		*/
+		bool IsWindowlessOnly() const override;
+
+	public:
+		/**
+		* \brief Отсутствующая строка (\see Grid::GetSelectedRow, Grid::GetRowAt)
+		*/
+		static constexpr size_t NO_ROW = static_cast<size_t>(-1);
+
+		/**
+		* \brief Набор сигналов для различных событий (\see wquery::Signal)
+		*/
+		struct
+		{
+			Signal<void()> onSelectionChanged;
+		} events;
+
+		/**
+		* \brief Конструктор
+		* \param window Владеющее окно
+		*/
+		Grid(Window * window);
+
+		/**
+		* \brief Конструктор с начальным состоянием (\see ControlState, таблица всегда без системного окна)
+		* \param window Владеющее окно
+		* \param state Начальное состояние
+		*/
+		Grid(Window * window, const ControlState& state);
+
+		/**
+		* \brief Деструктор (унаследован от частично-вирутального)
+		*/
+		~Grid();
+
+		/**
+		* \brief Получение имени класса (переопредление полного виртуального метода)
+		* \return Строка с именем класса
+		*/
+		std::string GetControlClassName() override;
+
+		/**
+		* \brief Получить тег типа (при первом вызове тип регистрируется)
+		* \return Тег типа
+		*/
+		static unsigned int TypeTag();
+
+		/**
+		* \brief Добавить столбец
+		* \param title Заголовок
+		* \param width Ширина
+		*/
+		void AddColumn(const std::string& title, int width);
+
+		/**
+		* \brief Удалить все столбцы
+		*/
+		void ClearColumns();
+
+		/**
+		* \brief Получить кол-во столбцов
+		* \return Кол-во
+		*/
+		size_t GetColumnCount() const;
+
+		/**
+		* \brief Получить столбец
+		* \param index Индекс столбца
+		* \return Ссылка на столбец
+		*/
+		const GridColumn& GetColumn(size_t index) const;
+
+		/**
+		* \brief Установить источник данных (видимые строки будут запрошены заново)
+		* \param dataSource Источник данных
+		*/
+		void SetDataSource(GridDataSource dataSource);
+
+		/**
+		* \brief Установить кол-во строк (видимые строки будут запрошены заново)
+		* \param count Кол-во строк
+		*/
+		void SetRowCount(size_t count);
+
+		/**
+		* \brief Получить кол-во строк
+		* \return Кол-во строк
+		*/
+		size_t GetRowCount() const;
+
+		/**
+		* \brief Установить высоту строки (и заголовка)
+		* \param height Высота
+		*/
+		void SetRowHeight(int height);
+
+		/**
+		* \brief Получить высоту строки
+		* \return Высота
+		*/
+		int GetRowHeight() const;
+
+		/**
+		* \brief Получить кол-во видимых строк (включая видимую частично)
+		* \return Кол-во строк
+		*/
+		size_t GetVisibleRowCount() const;
+
+		/**
+		* \brief Прокрутить таблицу так, чтобы строка была первой видимой (с ограничением по последней строке)
+		* \param row Индекс строки
+		*/
+		void SetFirstRow(size_t row);
+
+		/**
+		* \brief Получить первую видимую строку
+		* \return Индекс строки
+		*/
+		size_t GetFirstRow() const;
+
+		/**
+		* \brief Прокрутить таблицу на заданное кол-во строк
+		* \param rows Кол-во строк (отрицательное - вверх)
+		*/
+		void ScrollBy(long long rows);
+
+		/**
+		* \brief Прокрутить таблицу так, чтобы строка была видна (если она уже видна - ничего не происходит)
+		* \param row Индекс строки
+		*/
+		void ScrollTo(size_t row);
+
+		/**
+		* \brief Выбрать строку (сигнал onSelectionChanged не вызывается)
+		* \param row Индекс строки (NO_ROW - снять выбор)
+		*/
+		void SetSelectedRow(size_t row);
+
+		/**
+		* \brief Получить выбранную строку
+		* \return Индекс строки (NO_ROW - не выбрана)
+		*/
+		size_t GetSelectedRow() const;
+
+		/**
+		* \brief Получить строку в точке
+		* \param point Точка (в координатах клиентской области окна)
+		* \return Индекс строки (NO_ROW - в точке нет строки)
+		*/
+		size_t GetRowAt(const Vector2D<int>& point) const;
+
+		/**
+		* \brief Обновить таблицу (данные изменились - видимые строки будут запрошены заново)
+		*/
+		void Refresh();
+	};
+}
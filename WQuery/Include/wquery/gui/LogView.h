@@ -0,0 +1,292 @@
+﻿/**
+* \brief Класс элемента управления "журнал" - просмотр потока строк (интерфейс)
+* \details Строки хранятся в кольцах фиксированного размера (текст строк и записи строк): новые строки вытесняют
+* самые старые, память журнала не растет со временем работы. Строки можно добавлять из любого потока без
+* блокировок - они попадают во входящую очередь (\see wquery::MpscQueue), которую поток основного цикла
+* разбирает одной задачей (\see wquery::Post) на пакет строк. Разбор только запрашивает перерисовку, поэтому
+* сколько бы строк ни пришло между кадрами, журнал перерисовывается не чаще раза за кадр. Объем входящей очереди
+* ограничен емкостью колец: если основной цикл не успевает разбирать строки, новые строки отбрасываются (и
+* считаются вытесненными), поэтому память журнала ограничена и при перегрузке. Пока журнал прокручен
+* до последней строки, он остается прикрепленным к ней. Журнал всегда рисуется окном (элемент без системного окна)
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../gui/Window.h"
+#include "../gui/ControlBase.h"
+#include "../tools/MpscQueue.h"
+
+namespace wquery
+{
+	class LogView : public ControlBase
+	{
+	private:
+		/**
+		* \brief Строка во входящей очереди (текст - сразу за заголовком, в том же блоке памяти)
+		*/
+		struct PendingLine
+		{
+			std::atomic<PendingLine*> next;        // Следующая (более поздняя) строка
+			size_t length;                         // Длина текста
+		};
+
+		/**
+		* \brief Входящая очередь строк
+		* \details Разделяется с задачей разбора, которая может выполниться после уничтожения журнала
+		*/
+		struct Inbox
+		{
+			MpscQueue<PendingLine> queue;                  // Строки (извлекает только поток основного цикла)
+			std::atomic<bool> drainPending;                // Передана ли задача разбора, которая еще не начала разбор
+			std::atomic<size_t> pendingBytes;              // Объем строк в очереди
+			std::atomic<size_t> maxPendingBytes;           // Наибольший объем строк в очереди
+			std::atomic<unsigned long long> rejectedLines; // Отброшенные строки, еще не учтенные журналом
+			LogView* owner;                                // Журнал (nullptr - уничтожен; только поток основного цикла)
+
+			/**
+			* \brief Конструктор
+			*/
+			Inbox();
+
+			/**
+			* \brief Деструктор (строки, оставшиеся в очереди, освобождаются)
+			*/
+			~Inbox();
+
+			/**
+			* \brief Создать строку очереди
+			* \param text Текст
+			* \return Строка (один блок памяти)
+			*/
+			static PendingLine* Allocate(std::string_view text);
+
+			/**
+			* \brief Освободить строку очереди
+			* \param line Строка
+			*/
+			static void Free(PendingLine* line);
+		};
+
+		/**
+		* \brief Запись строки в кольце
+		*/
+		struct LineEntry
+		{
+			size_t offset;                         // Начало текста в кольце текста (текст может переходить через конец)
+			size_t length;                         // Длина текста
+		};
+
+		// Кольцо текста строк
+		std::vector<char> text_;
+
+		// Кольцо записей строк
+		std::vector<LineEntry> lines_;
+
+		// Индекс самой старой строки в кольце записей
+		size_t firstEntry_;
+
+		// Кол-во строк в журнале
+		size_t lineCount_;
+
+		// Начало текста самой старой строки
+		size_t textStart_;
+
+		// Занятый объем кольца текста
+		size_t textUsed_;
+
+		// Всего принято строк
+		unsigned long long totalLines_;
+
+		// Всего вытеснено строк
+		unsigned long long droppedLines_;
+
+		// Первая видимая строка (индекс от самой старой)
+		size_t firstLine_;
+
+		// Прикреплен ли журнал к последней строке
+		bool pinned_;
+
+		// Остаток прокрутки колесом (меньше одного шага)
+		int wheelRemainder_;
+
+		// Входящая очередь
+		std::shared_ptr<Inbox> inbox_;
+
+		/**
+		* \brief Перенести строку в кольца (самые старые строки вытесняются)
+		* \param text Текст строки
+		* \param length Длина текста
+		* \return Кол-во вытесненных строк
+		*/
+		size_t StoreLine(const char* text, size_t length);
+
+		/**
+		* \brief Получить высоту строки
+		* \return Высота (в пикселях)
+		*/
+		int GetLineHeight() const;
+
+		/**
+		* \brief Получить кол-во строк, видимых полностью (не меньше одной)
+		* \return Кол-во строк
+		*/
+		size_t GetPageLines() const;
+
+		/**
+		* \brief Получить наибольшую первую видимую строку (последняя строка видна внизу)
+		* \return Индекс строки
+		*/
+		size_t GetMaxFirstLine() const;
+
+	protected:
+		/**
+		* \brief Нарисовать видимые строки журнала (только пересекающие область перерисовки)
+		* \param canvas Задний буфер окна
+		* \param rect Прямоугольник журнала
+		*/
+		void PaintWindowless(Canvas& canvas, const RECT& rect) const override;
+
+		/**
+		* \brief Прокрутка колесом мыши (три строки на шаг WHEEL_DELTA)
+		* \param delta Величина прокрутки
+		*/
+		void HandleWindowlessWheel(int delta) override;
+
+		/**
+		* \brief Прокрутка с клавиатуры (стрелки, PageUp, PageDown, Home, End)
+		* \param message Сообщение
+		* \param code Код клавиши или символ
+		*/
+		void HandleWindowlessKey(UINT message, WPARAM code) override;
+
+		/**
+		* \brief Журнал рисуется только окном
+		* \return Статус (всегда true)
+		*/
+		bool IsWindowlessOnly() const override;
+
+	public:
+		/**
+		* \brief Набор сигналов для различных событий (\see wquery::Signal)
+		*/
+		struct
+		{
+			Signal<void(size_t)> onLinesAppended;      // Разобран пакет строк (кол-во строк пакета)
+		} events;
+
+		/**
+		* \brief Конструктор (журнал 300x200 на 50 000 строк и 4 МБ текста)
+		* \param window Владеющее окно
+		*/
+		LogView(Window * window);
+
+		/**
+		* \brief Конструктор с начальным состоянием (\see ControlState, журнал всегда без системного окна)
+		* \param window Владеющее окно
+		* \param state Начальное состояние
+		*/
+		LogView(Window * window, const ControlState& state);
+
+		/**
+		* \brief Деструктор (строки, не разобранные к моменту уничтожения, отбрасываются)
+		*/
+		~LogView();
+
+		/**
+		* \brief Получение имени класса (переопредление полного виртуального метода)
+		* \return Строка с именем класса
+		*/
+		std::string GetControlClassName() override;
+
+		/**
+		* \brief Получить тег типа (при первом вызове тип регистрируется)
+		* \return Тег типа
+		*/
+		static unsigned int TypeTag();
+
+		/**
+		* \brief Добавить строку (из любого потока, без блокировок)
+		* \details Строка появится в журнале после разбора входящей очереди потоком основного цикла. Завершающие
+		* "\r\n" отбрасываются, длинные строки обрезаются (по границе символа UTF-8). Если входящая очередь
+		* заполнена (емкостью колец), строка отбрасывается и считается вытесненной. Журнал должен
+		* существовать, пока другие потоки могут вызывать этот метод
+		* \param line Текст строки (UTF-8)
+		*/
+		void AppendLine(std::string_view line);
+
+		/**
+		* \brief Разобрать входящую очередь немедленно (только поток основного цикла)
+		* \return Кол-во разобранных строк
+		*/
+		size_t Flush();
+
+		/**
+		* \brief Установить емкость журнала (только поток основного цикла, сохраняются самые новые строки)
+		* \details Вместе с емкостью колец меняется и наибольший объем входящей очереди
+		* \param maxLines Наибольшее кол-во строк
+		* \param maxBytes Объем кольца текста (в байтах)
+		*/
+		void SetCapacity(size_t maxLines, size_t maxBytes);
+
+		/**
+		* \brief Удалить все строки
+		*/
+		void Clear();
+
+		/**
+		* \brief Получить кол-во строк в журнале
+		* \return Кол-во строк
+		*/
+		size_t GetLineCount() const;
+
+		/**
+		* \brief Получить строку
+		* \param index Индекс строки (0 - самая старая)
+		* \param text Строка для записи
+		*/
+		void GetLine(size_t index, std::string& text) const;
+
+		/**
+		* \brief Получить кол-во принятых строк (за все время, в том числе отброшенных)
+		* \return Кол-во строк
+		*/
+		unsigned long long GetTotalLineCount() const;
+
+		/**
+		* \brief Получить кол-во вытесненных строк (в том числе отброшенных при заполненной входящей очереди)
+		* \return Кол-во строк
+		*/
+		unsigned long long GetDroppedLineCount() const;
+
+		/**
+		* \brief Получить объем памяти журнала (кольца и строки во входящей очереди)
+		* \return Объем (в байтах)
+		*/
+		size_t GetMemoryUsage() const;
+
+		/**
+		* \brief Прокрутить журнал так, чтобы строка была первой видимой (журнал открепляется от последней строки,
+		* если она перестает быть видна)
+		* \param line Индекс строки
+		*/
+		void SetFirstLine(size_t line);
+
+		/**
+		* \brief Получить первую видимую строку
+		* \return Индекс строки
+		*/
+		size_t GetFirstLine() const;
+
+		/**
+		* \brief Прокрутить журнал до последней строки и прикрепить к ней
+		*/
+		void ScrollToEnd();
+
+		/**
+		* \brief Прикреплен ли журнал к последней строке
+		* \return Статус
+		*/
+		bool IsPinned() const;
+	};
+}
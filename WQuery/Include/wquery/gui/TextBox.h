@@ -11,18 +11,155 @@
 #include "../stdafx.h"
 #include "../gui/Window.h"
 #include "../gui/ControlBase.h"
+#include "../tools/PieceTable.h"
 
 namespace wquery
 {
+	/**
+	* \brief Режим поля ввода
+	*/
+	enum class TextBoxMode
+	{
+		EDIT,                                  // Системное поле ввода (текст хранит система, чтение и запись копируют его целиком)
+		DOCUMENT                               // Документ: текст в таблице фрагментов (\see PieceTable), поле рисуется окном
+	};
+
+	/**
+	* \brief Правка текста документа (\see TextBox::events.onEdited)
+	*/
+	struct TextEdit
+	{
+		size_t position;                       // Смещение правки (в байтах UTF-8)
+		size_t erased;                         // Длина удаленного текста
+		size_t inserted;                       // Длина вставленного текста
+	};
+
 	class TextBox : public ControlBase
 	{
 	private:
+		// Документ (nullptr - системное поле ввода, \see TextBoxMode::DOCUMENT)
+		std::unique_ptr<PieceTable> document_;
+
+		// Первая видимая строка (режим документа)
+		size_t firstLine_;
+
+		// Положение курсора (режим документа, смещение в байтах UTF-8)
+		size_t caret_;
+
+		// Остаток прокрутки колесом (меньше одного шага)
+		int wheelRemainder_;
+
+		// Старшая половина суррогатной пары, ожидающая младшую (ввод символов вне BMP)
+		char16_t highSurrogate_;
+
+		/**
+		* \brief Получить высоту строки документа
+		* \return Высота (в пикселях)
+		*/
+		int GetLineHeight() const;
+
+		/**
+		* \brief Получить кол-во строк документа, видимых полностью (не меньше одной)
+		* \return Кол-во строк
+		*/
+		size_t GetPageLines() const;
+
+		/**
+		* \brief Получить конец строки документа (без перевода строки)
+		* \param line Номер строки
+		* \return Смещение
+		*/
+		size_t GetLineEnd(size_t line) const;
+
+		/**
+		* \brief Получить предыдущее положение курсора (символ UTF-8 или пара "\r\n" целиком)
+		* \param position Положение
+		* \return Предыдущее положение
+		*/
+		size_t StepBack(size_t position) const;
+
+		/**
+		* \brief Получить следующее положение курсора
+		* \param position Положение
+		* \return Следующее положение
+		*/
+		size_t StepForward(size_t position) const;
+
+		/**
+		* \brief Получить положение курсора в точке
+		* \param point Точка (в координатах клиентской области окна)
+		* \return Положение
+		*/
+		size_t GetCaretAt(const Vector2D<int>& point) const;
+
+		/**
+		* \brief Запросить перерисовку строк документа
+		* \param from Первая строка
+		* \param to Строка за последней (SIZE_MAX - до конца поля)
+		*/
+		void InvalidateLines(size_t from, size_t to) const;
+
+		/**
+		* \brief Прокрутить документ так, чтобы курсор был виден
+		*/
+		void EnsureCaretVisible();
+
+		/**
+		* \brief Оповестить о правке (onEdited, затем EN_CHANGE - onChanged и ожидающие сопрограммы)
+		* \param edit Правка
+		*/
+		void NotifyEdited(const TextEdit& edit);
+
+		/**
+		* \brief Заменить участок текста документа (перерисовываются только затронутые строки)
+		* \param position Смещение участка
+		* \param length Длина участка
+		* \param text Новый текст участка
+		*/
+		void ReplaceDocumentText(size_t position, size_t length, std::string_view text);
+
+	protected:
+		/**
+		* \brief Нарисовать поле без системного окна (фон, рамка и текст или символы пароля)
+		* \param canvas Задний буфер окна
+		* \param rect Прямоугольник поля
+		*/
+		void PaintWindowless(Canvas& canvas, const RECT& rect) const override;
+
+		/**
+		* \brief Нажатие на поле без системного окна (создается системное поле ввода и получает фокус)
+		* \param message Сообщение мыши
+		*/
+		void HandleWindowlessMouse(UINT message) override;
+
+		/**
+		* \brief Прокрутка документа колесом мыши (три строки на шаг WHEEL_DELTA)
+		* \param delta Величина прокрутки
+		*/
+		void HandleWindowlessWheel(int delta) override;
+
+		/**
+		* \brief Ввод с клавиатуры в документ (символы, Backspace, Delete, стрелки, Home, End, PageUp, PageDown)
+		* \param message Сообщение
+		* \param code Код клавиши или символ
+		*/
+		void HandleWindowlessKey(UINT message, WPARAM code) override;
+
+		/**
+		* \brief Документ рисуется только окном
+		* \return Статус
+		*/
+		bool IsWindowlessOnly() const override;
 
 	public:
+		/**
+		* \brief Набор сигналов для различных событий (\see wquery::Signal)
+		*/
 		struct
 		{
-			std::function<void()> onChanged;
-			std::function<void()> onClicked;
+			Signal<void()> onChanged;
+			Signal<void()> onClicked;
+			Signal<void(const TextEdit&)> onEdited;     // Только в режиме документа, перед onChanged
 		} events;
 
 		/**
@@ -31,6 +168,24 @@ namespace wquery
 		*/
 		TextBox(Window * window);
 
+		/**
+		* \brief Конструктор с начальным состоянием (\see ControlState)
+		* \param window Владеющее окно
+		* \param state Начальное состояние
+		*/
+		TextBox(Window * window, const ControlState& state);
+
+		/**
+		* \brief Конструктор с начальным состоянием и режимом
+		* \details В режиме документа поле всегда без системного окна: окно рисует только видимые строки, правки
+		* и оповещения о них стоят пропорционально размеру правки, а не документа. Редактирование с клавиатуры -
+		* после нажатия на поле
+		* \param window Владеющее окно
+		* \param state Начальное состояние
+		* \param mode Режим
+		*/
+		TextBox(Window * window, const ControlState& state, TextBoxMode mode);
+
 		/**
 		* \brief Деструктор (унаследован от частично-вирутального)
 		*/
@@ -42,6 +197,18 @@ namespace wquery
 		*/
 		std::string GetControlClassName() override;
 
+		/**
+		* \brief Получить тег типа (при первом вызове тип регистрируется вместе с обработчиками уведомлений)
+		* \return Тег типа
+		*/
+		static unsigned int TypeTag();
+
+		/**
+		* \brief Дождаться изменения текста (в сопрограмме: co_await textBox->Changed())
+		* \return Ожидаемый объект (\see ControlBase::Notified)
+		*/
+		NotificationAwaiter Changed();
+
 		/**
 		 * \brief Стиль поля для ввода пароля (да или нет)
 		 * \param status Статус
@@ -53,5 +220,136 @@ namespace wquery
 		 * \return Статус
 		 */
 		bool IsPassword() const;
+
+		/*
+		* Текст поля. В режиме документа методы работают с документом (текст ControlBase в этом режиме не
+		* используется), поэтому обращаться к тексту такого поля следует через TextBox, а не через ControlBase
+		*/
+
+		/**
+		* \brief Установить текст
+		* \param text Текст
+		*/
+		void SetText(const std::string& text) const;
+
+		/**
+		* \brief Установить текст
+		* \param text Текст (нуль-терминированная строка)
+		*/
+		void SetText(const char* text) const;
+
+		/**
+		* \brief Установить текст
+		* \param text Текст (представление строки)
+		*/
+		void SetText(std::string_view text) const;
+
+		/**
+		* \brief Установить текст
+		* \param text Текст в UTF-16
+		*/
+		void SetText(std::u16string_view text) const;
+
+		/**
+		* \brief Получить текст
+		* \return Текст
+		*/
+		std::string GetText() const;
+
+		/**
+		* \brief Получить текст в существующую строку
+		* \param text Строка для записи
+		*/
+		void GetText(std::string& text) const;
+
+		/**
+		* \brief Получить текст в существующую UTF-16 строку
+		* \param text Строка для записи
+		*/
+		void GetText(std::u16string& text) const;
+
+		/**
+		* \brief Получить текст в буфер
+		* \param buffer Буфер (текст обрезается по границе символа UTF-8, всегда завершается нулем)
+		* \param capacity Размер буфера
+		* \return Кол-во записанных байт (без нуль-терминатора)
+		*/
+		size_t GetText(char* buffer, size_t capacity) const;
+
+		/**
+		* \brief Получить текст в UTF-16 буфер
+		* \param buffer Буфер (текст обрезается до capacity - 1 символов, всегда завершается нулем)
+		* \param capacity Размер буфера
+		* \return Кол-во записанных символов (без нуль-терминатора)
+		*/
+		size_t GetText(char16_t* buffer, size_t capacity) const;
+
+		/**
+		* \brief Получить длину текста
+		* \return Длина (без нуль-терминатора)
+		*/
+		size_t GetTextLength() const;
+
+		/**
+		* \brief Получить режим поля
+		* \return Режим
+		*/
+		TextBoxMode GetMode() const;
+
+		/**
+		* \brief Получить документ (для чтения участков и строк без копирования всего текста)
+		* \return Указатель на документ (nullptr - поле не в режиме документа)
+		*/
+		const PieceTable* GetDocument() const;
+
+		/**
+		* \brief Вставить текст (вне режима документа - через копию всего текста)
+		* \param position Смещение (в байтах UTF-8)
+		* \param text Текст
+		*/
+		void InsertText(size_t position, std::string_view text);
+
+		/**
+		* \brief Удалить участок текста (вне режима документа - через копию всего текста)
+		* \param position Смещение
+		* \param length Длина
+		*/
+		void EraseText(size_t position, size_t length);
+
+		/**
+		* \brief Дописать текст в конец
+		* \param text Текст
+		*/
+		void AppendText(std::string_view text);
+
+		/**
+		* \brief Заменить весь текст (в режиме документа - без копирования строки)
+		* \param text Текст
+		*/
+		void LoadText(std::string&& text);
+
+		/**
+		* \brief Установить положение курсора документа (документ прокручивается так, чтобы курсор был виден)
+		* \param position Смещение
+		*/
+		void SetCaret(size_t position);
+
+		/**
+		* \brief Получить положение курсора документа
+		* \return Смещение
+		*/
+		size_t GetCaret() const;
+
+		/**
+		* \brief Прокрутить документ так, чтобы строка была первой видимой
+		* \param line Номер строки
+		*/
+		void SetFirstLine(size_t line);
+
+		/**
+		* \brief Получить первую видимую строку документа
+		* \return Номер строки
+		*/
+		size_t GetFirstLine() const;
 	};
 }
\ No newline at end of file
@@ -11,42 +11,227 @@
 
 #include "../stdafx.h"
 #include "../types/common.h"
+#include "GeometryStore.h"
+#include "../tools/TimerWheel.h"
+#include "../tools/Signal.h"
+#include "../tools/DirtyRegion.h"
+#include "../tools/Canvas.h"
 
 namespace wquery
 {
+	class ControlBase;
+
+	/**
+	* \brief Текст окна или элемента, ожидающего создания системного объекта
+	* \details Хранится в том виде, в котором был установлен (строка передается системе как есть,
+	* UTF-16 - без преобразования в ANSI), при чтении в другом виде перекодируется как UTF-8
+	*/
+	struct PendingText
+	{
+		std::string text;                  // Текст (если установлен строкой)
+		std::u16string textUtf16;          // Текст (если установлен UTF-16 строкой)
+		bool utf16 = false;                // Текст установлен UTF-16 строкой
+
+		/**
+		* \brief Установить текст
+		* \param value Текст
+		*/
+		void Set(std::string_view value);
+
+		/**
+		* \brief Установить текст
+		* \param value Текст в UTF-16
+		*/
+		void Set(std::u16string_view value);
+
+		/**
+		* \brief Получить текст
+		* \param value Строка для записи
+		*/
+		void Get(std::string& value) const;
+
+		/**
+		* \brief Получить текст
+		* \param value Строка для записи
+		*/
+		void Get(std::u16string& value) const;
+
+		/**
+		* \brief Получить текст, передаваемый при создании системного объекта
+		* \return Нуль-терминированная строка (nullptr - текст пуст или будет установлен после создания)
+		*/
+		const char* GetInitial() const;
+
+		/**
+		* \brief Установить текст созданному объекту (если его нельзя было передать при создании)
+		* \param hWnd Хендл
+		*/
+		void Apply(HWND hWnd) const;
+	};
+
 	class Window
 	{
+		friend class ControlBase;
 
 	private:
+		/**
+		* \brief Свойства окна, записанные до создания системного окна
+		* \details Системное окно создается при первом показе или первом обращении к хендлу, до этого
+		* свойства только запоминаются и передаются системе при создании
+		*/
+		struct PendingWindow
+		{
+			PendingText title;                 // Заголовок
+			Vector2D<int> position;            // Положение
+			DWORD style;                       // Стиль
+			bool closeButtonDisabled;          // Кнопка закрытия недоступна
+			std::string iconFilename;          // Путь к иконке (пустой - иконка не задана)
+			int iconWidth, iconHeight;         // Размеры иконки
+		};
+
 		HWND hWnd_;                         // Хендл окна WinApi
+		std::unique_ptr<PendingWindow> pending_; // Свойства окна до создания (nullptr - окно уже создано)
 		Window * parent_;                   // Указатель на родительский объект (родительское окно)
 		ColorRGB backgroundColor_;          // Цвет фона
+		HBRUSH backgroundBrush_;            // Кисть фона (из общего кеша графических объектов)
 		bool closesProgram_;                // Инициирует ли выход из приложения закрытие данного окна
 
 		Vector2D<int> oldClientAreaSize_;   // Старые размеры (до изменения размеров)
 		Vector2D<int> maxSizes_;            // Максимальные размеры
 		Vector2D<int> minSizes_;            // Минимальные размеры
 
+		GeometryStore controls_;                           // Геометрия элементов управления принадлежащих окну
+		std::vector<unsigned int> layoutChanged_;          // Буфер пакета раскладки: идентификаторы измененных элементов
+		std::vector<HWND> layoutHandles_;                  // Буфер пакета раскладки: хендлы измененных элементов
+		std::vector<Vector2D<int>> layoutPositions_;       // Буфер пакета раскладки: новые положения
+		std::vector<Vector2D<int>> layoutSizes_;           // Буфер пакета раскладки: новые размеры
+
+		unsigned int windowlessCount_;                     // Кол-во элементов без системного окна (рисуются окном)
+		std::vector<unsigned int> paintControls_;          // Буфер перерисовки: элементы без системного окна в области
+		ControlBase * pressedControl_;                     // Элемент без системного окна, над которым нажата кнопка мыши
+		ControlBase * focusedControl_;                     // Элемент без системного окна, получающий ввод с клавиатуры
+
+		bool coalesceMouse_;                               // Движения мыши накапливаются и доставляются пакетом
+		bool mouseQueued_;                                 // Окно в списке окон с накопленными движениями
+		Vector2D<int> cursor_;                             // Последнее известное положение курсора
+		std::vector<MouseSample> mouseSamples_;            // Накопленные движения
+		std::vector<MouseSample> mouseBatch_;              // Доставляемый пакет движений
+
+		DirtyRegion dirty_;                                // Недействительная область, ожидающая конца итерации цикла
+		DirtyRegion paintRegion_;                          // Область текущей (отложенной) перерисовки
+		unsigned int paintRequests_;                       // Кол-во запросов перерисовки с прошлой перерисовки
+		bool paintQueued_;                                 // Окно в списке окон, ожидающих перерисовки
+		bool paintUpdating_;                               // Идет отложенная перерисовка (WM_PAINT вызван ей)
+		Canvas canvas_;                                    // Задний буфер (память выделяется при первом onPaint)
+
+		/**
+		* \brief Создать системное окно по записанным свойствам, затем - системные элементы управления
+		*/
+		void Create();
+
+		/**
+		* \brief Получить разницу между размерами окна и его клиентской области
+		* \return Разница (до создания окна - по стилю окна)
+		*/
+		Vector2D<int> GetFrameDelta() const;
+
+		/**
+		* \brief Изменить размеры клиентской области окна, которое еще не создано (только раскладка элементов)
+		* \param windowSize Новые размеры окна (ограничиваются минимальными и максимальными)
+		*/
+		void ResizePending(const Vector2D<int>& windowSize);
+
+		/**
+		* \brief Зарегистрировать элемент управления (вызывается из конструктора ControlBase)
+		* \param control Указатель на элемент
+		* \param position Начальное положение
+		* \param size Начальные размеры
+		* \param flags Начальные флаги (GeometryFlags)
+		* \return Идентификатор элемента в хранилище геометрии окна
+		*/
+		unsigned int AttachControl(ControlBase * control, const Vector2D<int>& position, const Vector2D<int>& size, unsigned char flags);
+
+		/**
+		* \brief Убрать элемент управления из списка окна (вызывается из деструктора ControlBase)
+		* \param control Указатель на элемент
+		*/
+		void DetachControl(ControlBase * control);
+
+		/**
+		* \brief Доставить накопленные движения мыши окна (если они есть)
+		*/
+		void FlushMouseSamples();
+
+		/**
+		* \brief Выполнить отложенную перерисовку окна (если она запрошена)
+		*/
+		void FlushDirtyRegion();
+
+		/**
+		* \brief Нарисовать область перерисовки в заднем буфере и вывести его на экран (вызывается из WM_PAINT)
+		*/
+		void PaintCanvas();
+
+		/**
+		* \brief Нарисовать элементы без системного окна, пересекающие область перерисовки
+		*/
+		void PaintWindowlessControls();
+
+		/**
+		* \brief Передать нажатие или отпускание левой кнопки мыши элементу без системного окна под курсором
+		* \param message Сообщение (WM_LBUTTONDOWN или WM_LBUTTONUP)
+		*/
+		void RouteWindowlessMouse(UINT message);
+
+		/**
+		* \brief Передать прокрутку колеса мыши элементу без системного окна под курсором
+		* \param delta Величина прокрутки
+		*/
+		void RouteWindowlessWheel(int delta);
+
+		/**
+		* \brief Передать ввод с клавиатуры элементу без системного окна, получившему фокус нажатием
+		* \param message Сообщение (WM_KEYDOWN или WM_CHAR)
+		* \param code Код клавиши или символ (UTF-16)
+		*/
+		void RouteWindowlessKey(UINT message, WPARAM code);
+
+		/**
+		* \brief Рисует ли окно через задний буфер (есть подписчики onPaint или элементы без системного окна)
+		* \return Статус
+		*/
+		bool UsesCanvas() const;
+
 	public:
 
 		/**
-		* \brief Набор функций обратного вызова для различных событий
+		* \brief Набор сигналов для различных событий (подписка: events.onPaint.Connect(...), \see wquery::Signal)
+		* \details Окно закрывается, только если все подписчики onClose вернули true. onPaint получает задний буфер
+		* окна размером с клиентскую область и область перерисовки: накопленную через Window::Invalidate или всю
+		* клиентскую область, если перерисовку вызвала система. Перед вызовом область перерисовки уже залита цветом
+		* фона, а рисование ограничено ее границами; после вызова поверх рисуются элементы без системного окна
+		* (\see ControlBase::IsWindowless), и буфер выводится на экран одним копированием. Пока у onPaint нет
+		* подписчиков и в окне нет элементов без системного окна, буфер не создается и фон окна стирается системной кистью
 		*/
 		struct
 		{
-			std::function<bool()> onClose;
-			std::function<void()> onPaint;
-			std::function<void(unsigned int type, Vector2D<int> newSizes)> onResized;
-			std::function<void(unsigned int code)> onKeyDown;
-			std::function<void(unsigned int code)> onKeyUp;
-			std::function<void(char symbol)> onTyping;
-			std::function<void(Vector2D<int> cursor)> onMouseMove;
-			std::function<void(Vector2D<int> cursor, MouseKeys type)> onMouseKeyDown;
-			std::function<void(Vector2D<int> cursor, MouseKeys type)> onMouseKeyUp;
+			Signal<bool()> onClose;
+			Signal<void(Canvas& canvas, const DirtyRegion& region)> onPaint;
+			Signal<void(unsigned int type, Vector2D<int> newSizes)> onResized;
+			Signal<void(unsigned int code)> onKeyDown;
+			Signal<void(unsigned int code)> onKeyUp;
+			Signal<void(char symbol)> onTyping;
+			Signal<void(Vector2D<int> cursor)> onMouseMove;
+			Signal<void(const std::vector<MouseSample>& samples)> onMouseMoveBatch;
+			Signal<void(Vector2D<int> cursor, MouseKeys type)> onMouseKeyDown;
+			Signal<void(Vector2D<int> cursor, MouseKeys type)> onMouseKeyUp;
 		} events;
 
 		/**
 		* \brief Конструктор
+		* \details Системное окно (и системные элементы управления окна) создается не сразу, а при первом показе
+		* или первом обращении к хендлу (GetNativeHandle, Maximize, Minimize). Свойства, установленные до этого,
+		* только запоминаются и передаются системе при создании (\see wquery::GetStartupStatistics)
 		* \param parent Родительское окно (не обязательно)
 		*/
 		Window(Window * parent = nullptr);
@@ -67,11 +252,17 @@ namespace wquery
 		void Hide() const;
 
 		/**
-		* \brief Получить WinApi хендл окна
+		* \brief Получить WinApi хендл окна (если окно еще не создано - оно создается)
 		* \return Хендл окна
 		*/
 		HWND GetNativeHandle() const;
 
+		/**
+		* \brief Создано ли системное окно
+		* \return Статус
+		*/
+		bool IsCreated() const;
+
 		/**
 		* \brief Получить родительский объект
 		* \return Указатель на родителя
@@ -84,12 +275,42 @@ namespace wquery
 		*/
 		void SetTitle(const std::string& title) const;
 
+		/**
+		* \brief Установка заголовка окна
+		* \param title Заголовок (нуль-терминированная строка)
+		*/
+		void SetTitle(const char * title) const;
+
+		/**
+		* \brief Установка заголовка окна
+		* \param title Заголовок (представление строки)
+		*/
+		void SetTitle(std::string_view title) const;
+
+		/**
+		* \brief Установка заголовка окна
+		* \param title Заголовок в UTF-16
+		*/
+		void SetTitle(std::u16string_view title) const;
+
 		/**
 		* \brief Получение заголовка окна
 		* \return Строка с заголовком
 		*/
 		std::string GetTitle() const;
 
+		/**
+		* \brief Получение заголовка окна в существующую строку (память строки переиспользуется)
+		* \param title Строка для записи
+		*/
+		void GetTitle(std::string& title) const;
+
+		/**
+		* \brief Получение заголовка окна в существующую UTF-16 строку (память строки переиспользуется)
+		* \param title Строка для записи
+		*/
+		void GetTitle(std::u16string& title) const;
+
 		/**
 		* \brief Установка размеров окна
 		* \param size Размеры
@@ -222,12 +443,127 @@ namespace wquery
 		static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
 		/**
-		* \brief Используется для обновление размеров адаптивных (якорных) элементов
-		* \details Метод является callback-ом для перечисления дочерних элементов в момент изменения размера кона
-		* \param hWnd Хендл элемента WinApi
-		* \param lParam Параметр переданный из функции перечисления
+		* \brief Обновление положения и размеров адаптивных (якорных) элементов
+		* \details Новые прямоугольники всех элементов рассчитываются за один проход по закешированным
+		* параметрам (без обращений к системе), после чего изменившиеся элементы перемещаются одним пакетом
+		* и окно перерисовывается однократно. Вызывается при получении WM_SIZE
+		* \param sizingDelta Изменение размеров клиентской области
+		*/
+		void LayoutControls(const Vector2D<int>& sizingDelta);
+
+		/**
+		* \brief Найти элемент управления по точке (без обращений к системе)
+		* \param point Точка в координатах клиентской области
+		* \return Указатель на элемент (nullptr если в точке нет видимого элемента)
+		*/
+		ControlBase* GetControlAt(const Vector2D<int>& point) const;
+
+		/**
+		* \brief Получить хранилище геометрии элементов окна (только для чтения)
+		* \return Ссылка на хранилище
+		*/
+		const GeometryStore& GetControlGeometry() const;
+
+		/**
+		* \brief Запустить однократный таймер окна
+		* \details Таймеры окна останавливаются при его уничтожении (\see wquery::SetTimeout)
+		* \param delay Задержка (мс)
+		* \param callback Функция обратного вызова
+		* \return Идентификатор таймера
+		*/
+		TimerId SetTimeout(unsigned int delay, std::function<void()> callback);
+
+		/**
+		* \brief Запустить периодический таймер окна
+		* \param interval Период (мс)
+		* \param callback Функция обратного вызова
+		* \return Идентификатор таймера
+		*/
+		TimerId SetInterval(unsigned int interval, std::function<void()> callback);
+
+		/**
+		* \brief Остановить таймер
+		* \param id Идентификатор таймера
+		* \return Был ли таймер запущен
+		*/
+		bool CancelTimer(TimerId id);
+
+		/**
+		* \brief Включить или выключить объединение движений мыши
+		* \details Во включенном режиме движения мыши накапливаются и доставляются один раз за кадр цикла
+		* MainLoopType::FRAME_PACED (в остальных циклах - когда очередь сообщений опустела): onMouseMoveBatch
+		* получает все отсчеты с временем получения, onMouseMove - только последнее положение. Перед событиями
+		* кнопок мыши накопленные движения доставляются сразу, поэтому порядок событий сохраняется
+		* \param enabled Состояние
+		*/
+		void SetMouseCoalescing(bool enabled);
+
+		/**
+		* \brief Включено ли объединение движений мыши
+		* \return Состояние
+		*/
+		bool IsMouseCoalescing() const;
+
+		/**
+		* \brief Получить последнее известное положение курсора (в том числе еще не доставленное пакетом)
+		* \return Положение в клиентской области
+		*/
+		Vector2D<int> GetCursorPosition() const;
+
+		/**
+		* \brief Доставить накопленные движения мыши всех окон (вызывается основным циклом)
+		* \return Кол-во окон, которым были доставлены движения
+		*/
+		static size_t FlushMouseInput();
+
+		/**
+		* \brief Есть ли окна с накопленными движениями мыши
 		* \return Состояние
 		*/
-		static BOOL CALLBACK EnumerateResizingControls(HWND hWnd, LPARAM lParam);
+		static bool HasPendingMouseInput();
+
+		/**
+		* \brief Запросить перерисовку всей клиентской области
+		* \details Перерисовка откладывается до конца итерации основного цикла (в цикле MainLoopType::FRAME_PACED -
+		* до кадра), запросы за итерацию объединяются в одну перерисовку
+		*/
+		void Invalidate();
+
+		/**
+		* \brief Запросить перерисовку части клиентской области
+		* \details Прямоугольники запросов за итерацию объединяются в недействительную область (\see wquery::DirtyRegion)
+		* \param rect Прямоугольник в координатах клиентской области
+		*/
+		void Invalidate(const RECT& rect);
+
+		/**
+		* \brief Получить недействительную область, ожидающую перерисовки
+		* \return Ссылка на область
+		*/
+		const DirtyRegion& GetDirtyRegion() const;
+
+		/**
+		* \brief Выполнить отложенные перерисовки всех окон (вызывается основным циклом)
+		* \return Кол-во перерисованных окон
+		*/
+		static size_t FlushPaint();
+
+		/**
+		* \brief Есть ли окна, ожидающие перерисовки
+		* \return Состояние
+		*/
+		static bool HasPendingPaint();
+
+		/**
+		* \brief Получить задний буфер окна (содержит результат последней перерисовки через onPaint)
+		* \return Ссылка на холст
+		*/
+		const Canvas& GetCanvas() const;
+
+		/**
+		* \brief Получить статистику отложенной перерисовки (с момента запуска)
+		* \return Статистика
+		*/
+		static const PaintStatistics& GetPaintStatistics();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,562 @@
+﻿/**
+* \brief Интерфейс платформенного слоя (бэкенда)
+* \details Все обращения окон и элементов управления к оконной системе проходят через этот интерфейс.
+* Реализации: Win32Backend (настоящие окна WinApi) и HeadlessBackend (состояние хранится в памяти,
+* сообщения синтетические, но проходят через ту же оконную процедуру Window::WndProc)
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../types/common.h"
+
+namespace wquery
+{
+	/**
+	* \brief Служебное сообщение пробуждения основного цикла (\see Backend::Wake)
+	*/
+	const UINT WM_WQUERY_WAKE = WM_APP + 0x100;
+
+	/**
+	* \brief Метрики шрифта (в пикселях)
+	*/
+	struct FontMetrics
+	{
+		int ascent;                            // Высота над базовой линией
+		int descent;                           // Глубина под базовой линией
+		int lineHeight;                        // Расстояние между базовыми линиями соседних строк
+	};
+
+	/**
+	* \brief Растеризованный символ (маска покрытия)
+	*/
+	struct GlyphBitmap
+	{
+		int width;                             // Ширина маски
+		int height;                            // Высота маски
+		int left;                              // Смещение левого края маски от начала символа
+		int top;                               // Смещение верхнего края маски вверх от базовой линии
+		int advance;                           // Смещение начала следующего символа
+		std::vector<unsigned char> coverage;   // Покрытие пикселей (0..255, строки сверху вниз, width * height)
+	};
+
+	class Backend
+	{
+	protected:
+		std::function<void()> wakeHandler_;    // Функция, вызываемая в потоке цикла при пробуждении
+
+	public:
+		/**
+		* \brief Деструктор (виртуальный)
+		*/
+		virtual ~Backend() = default;
+
+		/**
+		* \brief Получить наименование бэкенда
+		* \return Строка с именем
+		*/
+		virtual const char* GetName() const = 0;
+
+		/*
+		* И Н И Ц И А Л И З А Ц И Я
+		*/
+
+		/**
+		* \brief Регистрация оконного класса WQuery
+		* \param hInstance Хендл текущего приложения (модуля)
+		* \param wndProc Оконная процедура, которой будут адресованы сообщения окон WQuery
+		* \param bgColor Цвет фона по умолчанию
+		*/
+		virtual void RegisterWindowClass(HINSTANCE hInstance, WNDPROC wndProc, const ColorRGB& bgColor) = 0;
+
+		/**
+		* \brief Получить хендл приложения, переданный при регистрации класса
+		* \return Хендл приложения
+		*/
+		virtual HINSTANCE GetInstance() const = 0;
+
+		/*
+		* С О З Д А Н И Е  И  У Н И Ч Т О Ж Е Н И Е
+		*/
+
+		/**
+		* \brief Создать окно WQuery (окно зарегистрированного класса)
+		* \param parent Хендл родительского окна (может быть nullptr)
+		* \param dwStyle Стиль окна
+		* \param position Положение окна (для дочернего - в клиентской области родителя)
+		* \param size Размеры окна
+		* \param title Заголовок
+		* \return Хендл окна
+		*/
+		virtual HWND CreateWindowHandle(HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* title) = 0;
+
+		/**
+		* \brief Создать дочерний элемент управления
+		* \param className Наименование WinApi класса элемента управления
+		* \param parent Хендл родительского окна
+		* \param dwStyle Стиль элемента
+		* \param position Положение элемента в клиентской области родителя
+		* \param size Размеры элемента
+		* \param text Начальный текст (nullptr - без текста), задается без уведомлений об изменении
+		* \return Хендл элемента
+		*/
+		virtual HWND CreateControlHandle(const std::string& className, HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* text) = 0;
+
+		/**
+		* \brief Уничтожить окно или элемент управления
+		* \param hWnd Хендл
+		*/
+		virtual void DestroyHandle(HWND hWnd) = 0;
+
+		/**
+		* \brief Является ли хендл окном WQuery (а не элементом управления)
+		* \param hWnd Хендл
+		* \return Состояние
+		*/
+		virtual bool IsWindowHandle(HWND hWnd) const = 0;
+
+		/**
+		* \brief Перечислить все дочерние элементы (включая вложенные)
+		* \param hWnd Хендл родителя
+		* \param enumProc Функция обратного вызова
+		* \param lParam Параметр передаваемый в функцию обратного вызова
+		*/
+		virtual void EnumChildren(HWND hWnd, WNDENUMPROC enumProc, LPARAM lParam) = 0;
+
+		/*
+		* С В О Й С Т В А
+		*/
+
+		/**
+		* \brief Записать указатель на объект WQuery в пользовательские данные окна
+		* \param hWnd Хендл
+		* \param data Указатель
+		*/
+		virtual void SetUserData(HWND hWnd, void* data) = 0;
+
+		/**
+		* \brief Получить указатель на объект WQuery из пользовательских данных окна
+		* \param hWnd Хендл
+		* \return Указатель
+		*/
+		virtual void* GetUserData(HWND hWnd) const = 0;
+
+		/**
+		* \brief Установить текст (заголовок) окна или элемента
+		* \param hWnd Хендл
+		* \param text Текст (нуль-терминированная строка)
+		*/
+		virtual void SetText(HWND hWnd, const char* text) = 0;
+
+		/**
+		* \brief Получить длину текста окна или элемента (без нуль-терминатора)
+		* \param hWnd Хендл
+		* \return Длина
+		*/
+		virtual size_t GetTextLength(HWND hWnd) const = 0;
+
+		/**
+		* \brief Получить текст окна или элемента
+		* \param hWnd Хендл
+		* \param buffer Буфер для записи (нуль-терминированная строка)
+		* \param capacity Размер буфера с учетом нуль-терминатора
+		* \return Кол-во записанных символов
+		*/
+		virtual size_t GetText(HWND hWnd, char* buffer, size_t capacity) const = 0;
+
+		/**
+		* \brief Установить текст (заголовок) окна или элемента в UTF-16
+		* \param hWnd Хендл
+		* \param text Текст (нуль-терминированная строка)
+		*/
+		virtual void SetTextUtf16(HWND hWnd, const char16_t* text) = 0;
+
+		/**
+		* \brief Получить длину текста окна или элемента в элементах UTF-16 (без нуль-терминатора)
+		* \param hWnd Хендл
+		* \return Длина
+		*/
+		virtual size_t GetTextLengthUtf16(HWND hWnd) const = 0;
+
+		/**
+		* \brief Получить текст окна или элемента в UTF-16
+		* \param hWnd Хендл
+		* \param buffer Буфер для записи (нуль-терминированная строка)
+		* \param capacity Размер буфера в элементах с учетом нуль-терминатора
+		* \return Кол-во записанных элементов
+		*/
+		virtual size_t GetTextUtf16(HWND hWnd, char16_t* buffer, size_t capacity) const = 0;
+
+		/**
+		* \brief Получить стиль окна или элемента
+		* \param hWnd Хендл
+		* \return Стиль
+		*/
+		virtual DWORD GetStyle(HWND hWnd) const = 0;
+
+		/**
+		* \brief Установить стиль окна или элемента
+		* \param hWnd Хендл
+		* \param dwStyle Стиль
+		*/
+		virtual void SetStyle(HWND hWnd, DWORD dwStyle) = 0;
+
+		/**
+		* \brief Установить состояние (активен/не активен)
+		* \param hWnd Хендл
+		* \param state Состояние
+		*/
+		virtual void Enable(HWND hWnd, bool state) = 0;
+
+		/**
+		* \brief Установить фокус ввода
+		* \param hWnd Хендл
+		*/
+		virtual void SetFocus(HWND hWnd) = 0;
+
+		/**
+		* \brief Получить окно или элемент с фокусом ввода
+		* \return Хендл (nullptr - фокуса нет)
+		*/
+		virtual HWND GetFocus() const = 0;
+
+		/**
+		* \brief Установить иконку окна из файла
+		* \param hWnd Хендл
+		* \param iconFilename Путь к .ico файлу
+		* \param width Ширина иконки
+		* \param height Высота иконки
+		*/
+		virtual void SetIcon(HWND hWnd, const std::string& iconFilename, int width, int height) = 0;
+
+		/**
+		* \brief Установить состояние пункта системного меню окна
+		* \param hWnd Хендл
+		* \param item Идентификатор пункта (напр. SC_CLOSE)
+		* \param enabled Состояние
+		*/
+		virtual void EnableSysMenuItem(HWND hWnd, UINT item, bool enabled) = 0;
+
+		/*
+		* Г Е О М Е Т Р И Я
+		*/
+
+		/**
+		* \brief Изменить положение и/или размеры (аналог SetWindowPos)
+		* \param hWnd Хендл
+		* \param x Положение левой стороны
+		* \param y Положение верха
+		* \param width Ширина
+		* \param height Высота
+		* \param flags Флаги SWP_*
+		*/
+		virtual void SetPos(HWND hWnd, int x, int y, int width, int height, UINT flags) = 0;
+
+		/**
+		* \brief Изменить положение и размеры группы элементов одним пакетом
+		* \details Элементы перемещаются без промежуточной перерисовки, перерисовку следует запросить отдельно \see Redraw
+		* \param handles Хендлы элементов
+		* \param positions Новые положения
+		* \param sizes Новые размеры
+		* \param count Кол-во элементов
+		*/
+		virtual void SetPosBatch(const HWND* handles, const Vector2D<int>* positions, const Vector2D<int>* sizes, size_t count) = 0;
+
+		/**
+		* \brief Получить прямоугольник окна в экранных координатах
+		* \param hWnd Хендл
+		* \param rect Прямоугольник
+		* \return Удалось ли получить
+		*/
+		virtual bool GetWindowRect(HWND hWnd, RECT* rect) const = 0;
+
+		/**
+		* \brief Получить прямоугольник клиентской области
+		* \param hWnd Хендл
+		* \param rect Прямоугольник
+		* \return Удалось ли получить
+		*/
+		virtual bool GetClientRect(HWND hWnd, RECT* rect) const = 0;
+
+		/**
+		* \brief Получить разницу между размерами окна и его клиентской области для стиля (без создания окна)
+		* \param dwStyle Стиль окна
+		* \return Суммарная ширина и высота рамки и заголовка
+		*/
+		virtual Vector2D<int> GetFrameSize(DWORD dwStyle) const = 0;
+
+		/**
+		* \brief Перевести экранные координаты в координаты клиентской области
+		* \param hWnd Хендл
+		* \param point Точка
+		*/
+		virtual void ScreenToClient(HWND hWnd, POINT* point) const = 0;
+
+		/*
+		* О Т О Б Р А Ж Е Н И Е
+		*/
+
+		/**
+		* \brief Изменить состояние отображения (аналог ShowWindow)
+		* \param hWnd Хендл
+		* \param cmdShow Команда SW_*
+		*/
+		virtual void Show(HWND hWnd, int cmdShow) = 0;
+
+		/**
+		* \brief Пометить область как требующую перерисовки
+		* \param hWnd Хендл
+		* \param rect Область (nullptr - вся клиентская область)
+		* \param erase Стирать ли фон
+		*/
+		virtual void Invalidate(HWND hWnd, const RECT* rect, bool erase) = 0;
+
+		/**
+		* \brief Немедленно перерисовать недействительную область
+		* \param hWnd Хендл
+		*/
+		virtual void Update(HWND hWnd) = 0;
+
+		/**
+		* \brief Запросить однократную перерисовку окна вместе со всеми дочерними элементами
+		* \param hWnd Хендл
+		*/
+		virtual void Redraw(HWND hWnd) = 0;
+
+		/**
+		* \brief Залить прямоугольник кистью
+		* \param hdc Контекст устройства
+		* \param rect Прямоугольник
+		* \param hBrush Хендл кисти
+		*/
+		virtual void FillRect(HDC hdc, const RECT* rect, HBRUSH hBrush) = 0;
+
+		/**
+		* \brief Вывести буфер пикселей в недействительную область окна и сделать ее действительной
+		* \details Аналог пары BeginPaint/EndPaint с единственным копированием буфера между ними (при BeginPaint окно
+		* получает WM_ERASEBKGND, если стирание фона было запрошено). Вызывается из обработчика WM_PAINT вместо
+		* обработчика по умолчанию
+		* \param hWnd Хендл
+		* \param pixels Пиксели (0x00RRGGBB, строки сверху вниз, может быть nullptr при нулевых размерах)
+		* \param width Ширина буфера
+		* \param height Высота буфера
+		*/
+		virtual void PresentPixels(HWND hWnd, const std::uint32_t* pixels, int width, int height) = 0;
+
+		/*
+		* Г Р А Ф И Ч Е С К И Е  О Б Ъ Е К Т Ы
+		*/
+
+		/**
+		* \brief Создать кисть сплошной заливки
+		* \param color Цвет
+		* \return Хендл кисти
+		*/
+		virtual HBRUSH CreateBrush(const ColorRGB& color) = 0;
+
+		/**
+		* \brief Создать шрифт
+		* \param font Параметры шрифта
+		* \return Хендл шрифта
+		*/
+		virtual HFONT CreateFontObject(const FontSettings& font) = 0;
+
+		/**
+		* \brief Получить шрифт по умолчанию (системный объект, не удаляется)
+		* \return Хендл шрифта
+		*/
+		virtual HFONT GetDefaultFont() const = 0;
+
+		/**
+		* \brief Получить параметры шрифта
+		* \details Имя семейства шрифтов остается валидным до завершения работы бэкенда
+		* \param hFont Хендл шрифта
+		* \param font Параметры шрифта
+		* \return Удалось ли получить
+		*/
+		virtual bool GetFontSettings(HFONT hFont, FontSettings& font) = 0;
+
+		/**
+		* \brief Получить метрики шрифта
+		* \param hFont Хендл шрифта
+		* \param metrics Метрики
+		* \return Удалось ли получить
+		*/
+		virtual bool GetFontMetrics(HFONT hFont, FontMetrics& metrics) = 0;
+
+		/**
+		* \brief Растеризовать символ (маска покрытия со сглаживанием, без учета цвета)
+		* \details Для символов без изображения (пробел) маска пуста, но смещение advance заполняется
+		* \param hFont Хендл шрифта
+		* \param codePoint Код символа (Unicode)
+		* \param glyph Растеризованный символ
+		* \return Удалось ли растеризовать
+		*/
+		virtual bool RasterizeGlyph(HFONT hFont, char32_t codePoint, GlyphBitmap& glyph) = 0;
+
+		/**
+		* \brief Удалить графический объект (кисть, шрифт)
+		* \param object Хендл объекта
+		*/
+		virtual void DeleteObject(HGDIOBJ object) = 0;
+
+		/*
+		* С О О Б Щ Е Н И Я
+		*/
+
+		/**
+		* \brief Отправить сообщение и дождаться его обработки
+		* \param hWnd Хендл получателя
+		* \param message Идентификатор сообщения
+		* \param wParam Параметр
+		* \param lParam Параметр
+		* \return Результат обработки
+		*/
+		virtual LRESULT Send(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) = 0;
+
+		/**
+		* \brief Поместить сообщение в очередь (потокобезопасно)
+		* \param hWnd Хендл получателя
+		* \param message Идентификатор сообщения
+		* \param wParam Параметр
+		* \param lParam Параметр
+		* \return Удалось ли поместить
+		*/
+		virtual bool Post(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) = 0;
+
+		/**
+		* \brief Обработка сообщения по умолчанию (аналог DefWindowProc)
+		* \param hWnd Хендл получателя
+		* \param message Идентификатор сообщения
+		* \param wParam Параметр
+		* \param lParam Параметр
+		* \return Результат обработки
+		*/
+		virtual LRESULT DefaultProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) = 0;
+
+		/**
+		* \brief Поместить в очередь сообщение о выходе
+		* \param exitCode Код выхода
+		*/
+		virtual void PostQuit(int exitCode) = 0;
+
+		/**
+		* \brief Получить сообщение из очереди (блокирует до получения)
+		* \param msg Структура для записи сообщения
+		* \return false если было получено сообщение WM_QUIT
+		*/
+		virtual bool GetNextMessage(MSG* msg) = 0;
+
+		/**
+		* \brief Получить сообщение из очереди, если оно есть (не блокирует)
+		* \param msg Структура для записи сообщения
+		* \return Было ли получено сообщение
+		*/
+		virtual bool PeekNextMessage(MSG* msg) = 0;
+
+		/**
+		* \brief Ожидать появления сообщения в очереди (не извлекая его)
+		* \param timeoutMicroseconds Максимальное время ожидания в микросекундах (0 - только проверить)
+		* \return Есть ли сообщение (false - время ожидания истекло)
+		*/
+		virtual bool WaitForMessage(unsigned int timeoutMicroseconds) = 0;
+
+		/**
+		* \brief Передать сообщение на обработку (с предварительной трансляцией клавиш)
+		* \param msg Сообщение
+		*/
+		virtual void Dispatch(const MSG* msg) = 0;
+
+		/**
+		* \brief Получить время обрабатываемого сообщения (время постановки в очередь, как GetMessageTime)
+		* \return Время в миллисекундах (по часам GetMessageClock)
+		*/
+		virtual DWORD GetCurrentMessageTime() const = 0;
+
+		/**
+		* \brief Передано ли обрабатываемое сообщение из другого потока через Send (как InSendMessage)
+		* \details Время такого сообщения (GetCurrentMessageTime) - время последнего извлеченного из очереди
+		* сообщения, к нему самому не относящееся
+		* \return Состояние
+		*/
+		virtual bool IsCurrentMessageSent() const = 0;
+
+		/**
+		* \brief Получить текущее время часов сообщений (как GetTickCount)
+		* \return Время в миллисекундах
+		*/
+		virtual DWORD GetMessageClock() const = 0;
+
+		/*
+		* П Р О Б У Ж Д Е Н И Е  Ц И К Л А
+		*/
+
+		/**
+		* \brief Разбудить основной цикл (может вызываться из любого потока)
+		* \details В очередь потока цикла помещается сообщение WM_WQUERY_WAKE, при обработке которого вызывается
+		* функция, заданная SetWakeHandler. Сообщение обрабатывается и во вложенных (модальных) циклах
+		* \return Удалось ли поместить сообщение (напр. до wquery::Begin разбудить цикл может быть нечем)
+		*/
+		virtual bool Wake() = 0;
+
+		/**
+		* \brief Задать функцию, вызываемую в потоке цикла при пробуждении
+		* \param handler Функция
+		*/
+		void SetWakeHandler(std::function<void()> handler);
+
+		/**
+		* \brief Вызвать функцию пробуждения (вызывается реализациями при обработке WM_WQUERY_WAKE)
+		*/
+		void HandleWake();
+
+		/*
+		* Т Е К С Т  (О Б Щ И Е  Р Е А Л И З А Ц И И)
+		*/
+
+		/**
+		* \brief Установить текст из представления строки (не обязательно нуль-терминированного)
+		* \details Текст копируется в переиспользуемый буфер потока, выделения памяти происходят только при росте буфера
+		* \param hWnd Хендл
+		* \param text Текст
+		*/
+		void WriteText(HWND hWnd, std::string_view text);
+
+		/**
+		* \brief Установить текст из представления UTF-16 строки (не обязательно нуль-терминированного)
+		* \param hWnd Хендл
+		* \param text Текст
+		*/
+		void WriteText(HWND hWnd, std::u16string_view text);
+
+		/**
+		* \brief Прочитать текст в строку (память строки переиспользуется, текст записывается прямо в нее)
+		* \param hWnd Хендл
+		* \param text Строка для записи
+		*/
+		void ReadText(HWND hWnd, std::string& text) const;
+
+		/**
+		* \brief Прочитать текст в UTF-16 строку (память строки переиспользуется, текст записывается прямо в нее)
+		* \param hWnd Хендл
+		* \param text Строка для записи
+		*/
+		void ReadText(HWND hWnd, std::u16string& text) const;
+	};
+
+	/**
+	* \brief Установить бэкенд (вызывается до wquery::Begin)
+	* \details Вызывается до того, как другие потоки начнут передавать задачи (\see wquery::Post): замена
+	* бэкенда не синхронизирована с обращениями к нему
+	* \param backend Бэкенд (владение передается библиотеке)
+	*/
+	void SetBackend(std::unique_ptr<Backend> backend);
+
+	/**
+	* \brief Получить текущий бэкенд
+	* \details Если бэкенд не был установлен - создается бэкенд по умолчанию для платформы
+	* (Win32Backend на Windows, HeadlessBackend на остальных). Создание потокобезопасно
+	* \return Ссылка на бэкенд
+	*/
+	Backend& GetBackend();
+}
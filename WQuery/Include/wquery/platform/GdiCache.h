@@ -0,0 +1,108 @@
+﻿/**
+* \brief Кеш графических объектов (интерфейс)
+* \details Кисти и шрифты с одинаковыми параметрами создаются в системе один раз и разделяются всеми
+* пользователями. Каждый хендл имеет счетчик ссылок, объект удаляется когда последний пользователь его освобождает
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../types/common.h"
+
+namespace wquery
+{
+	/**
+	* \brief Статистика кеша графических объектов
+	*/
+	struct GdiCacheStatistics
+	{
+		size_t brushHits;                      // Запросы кисти, обслуженные из кеша
+		size_t brushMisses;                    // Запросы кисти, потребовавшие создания объекта
+		size_t fontHits;                       // Запросы шрифта, обслуженные из кеша
+		size_t fontMisses;                     // Запросы шрифта, потребовавшие создания объекта
+		size_t liveBrushes;                    // Существующие (используемые) кисти
+		size_t liveFonts;                      // Существующие (используемые) шрифты
+	};
+
+	class GdiCache
+	{
+	private:
+		/**
+		* \brief Запись кеша
+		*/
+		struct Entry
+		{
+			HGDIOBJ handle;                    // Хендл объекта
+			size_t references;                 // Кол-во пользователей
+		};
+
+		/**
+		* \brief Ключ шрифта (копия параметров, имя семейства хранится строкой)
+		*/
+		struct FontKey
+		{
+			std::string family;
+			unsigned int size;
+			bool bold;
+			bool italic;
+
+			bool operator<(const FontKey& other) const;
+		};
+
+		std::unordered_map<COLORREF, Entry> brushes_;            // Кисти по цвету
+		std::map<FontKey, Entry> fonts_;                         // Шрифты по параметрам
+		std::unordered_map<std::uintptr_t, COLORREF> brushKeys_; // Обратное соответствие: хендл кисти -> цвет
+		std::unordered_map<std::uintptr_t, FontKey> fontKeys_;   // Обратное соответствие: хендл шрифта -> параметры
+		GdiCacheStatistics statistics_;                          // Статистика
+		mutable std::mutex mutex_;                               // Блокировка
+
+	public:
+		/**
+		* \brief Конструктор
+		*/
+		GdiCache();
+
+		/**
+		* \brief Получить кисть заданного цвета (счетчик ссылок увеличивается)
+		* \param color Цвет
+		* \return Хендл кисти (освобождается через ReleaseBrush)
+		*/
+		HBRUSH AcquireBrush(const ColorRGB& color);
+
+		/**
+		* \brief Освободить кисть (при освобождении последним пользователем объект удаляется)
+		* \param hBrush Хендл кисти, полученный через AcquireBrush
+		*/
+		void ReleaseBrush(HBRUSH hBrush);
+
+		/**
+		* \brief Получить шрифт с заданными параметрами (счетчик ссылок увеличивается)
+		* \param font Параметры шрифта
+		* \return Хендл шрифта (освобождается через ReleaseFont)
+		*/
+		HFONT AcquireFont(const FontSettings& font);
+
+		/**
+		* \brief Освободить шрифт (при освобождении последним пользователем объект удаляется)
+		* \param hFont Хендл шрифта, полученный через AcquireFont
+		*/
+		void ReleaseFont(HFONT hFont);
+
+		/**
+		* \brief Получить статистику
+		* \return Копия статистики
+		*/
+		GdiCacheStatistics GetStatistics() const;
+
+		/**
+		* \brief Сбросить счетчики попаданий и промахов
+		*/
+		void ResetStatistics();
+	};
+
+	/**
+	* \brief Получить общий (на весь процесс) кеш графических объектов
+	* \return Ссылка на кеш
+	*/
+	GdiCache& GetGdiCache();
+}
@@ -0,0 +1,254 @@
+﻿/**
+* \brief Кеш растеризованных символов и строк текста (интерфейс)
+* \details Символы растеризуются бэкендом один раз и упаковываются в атлас - общую маску покрытия для всех
+* символов одного шрифта (семейство, размер, жирность, курсив). Строка текста раскладывается в набор символов
+* атласа с их положением и сводится в общую маску всей строки (TextRun), разложенные строки хранятся в кеше
+* с вытеснением давно не используемых. Повторное рисование неизменной строки не обращается ни к бэкенду, ни
+* к декодированию UTF-8: только поиск строки в кеше и наложение ее маски на холст построчно, одним вызовом
+* растровой функции на строку пикселей (\see Canvas::DrawString). Используется из потока цикла
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../types/common.h"
+#include "Backend.h"
+
+namespace wquery
+{
+	/**
+	* \brief Статистика кеша символов
+	*/
+	struct GlyphCacheStatistics
+	{
+		size_t glyphHits;                      // Символы, найденные в атласе
+		size_t glyphMisses;                    // Символы, потребовавшие растеризации
+		size_t runHits;                        // Строки, найденные в кеше
+		size_t runMisses;                      // Строки, потребовавшие разложения на символы
+		size_t runEvictions;                   // Строки, вытесненные из кеша
+		size_t atlases;                        // Кол-во атласов (шрифтов)
+		size_t atlasBytes;                     // Суммарный размер масок атласов в байтах
+	};
+
+	/**
+	* \brief Символ в атласе
+	*/
+	struct AtlasGlyph
+	{
+		int x, y;                              // Положение маски в атласе
+		int width, height;                     // Размеры маски
+		int left;                              // Смещение левого края маски от начала символа
+		int top;                               // Смещение верхнего края маски вверх от базовой линии
+		int advance;                           // Смещение начала следующего символа
+	};
+
+	class GlyphAtlas
+	{
+	private:
+		FontMetrics metrics_;                                  // Метрики шрифта
+		std::vector<unsigned char> coverage_;                  // Маска покрытия (строки подряд, width_ байт на строку)
+		int width_;                                            // Ширина маски
+		int height_;                                           // Высота маски
+		int shelfX_;                                           // Свободная позиция на текущей полке
+		int shelfY_;                                           // Верхний край текущей полки
+		int shelfHeight_;                                      // Высота текущей полки (самый высокий символ)
+		AtlasGlyph ascii_[128];                                // Символы ASCII (быстрый доступ по коду)
+		bool asciiReady_[128];                                 // Растеризован ли символ ASCII
+		std::unordered_map<char32_t, AtlasGlyph> glyphs_;      // Остальные символы
+
+		/**
+		* \brief Увеличить маску (содержимое сохраняется)
+		* \param width Новая ширина
+		* \param height Новая высота
+		*/
+		void Grow(int width, int height);
+
+	public:
+		/**
+		* \brief Конструктор
+		* \param metrics Метрики шрифта
+		*/
+		explicit GlyphAtlas(const FontMetrics& metrics);
+
+		/**
+		* \brief Найти символ
+		* \details Указатели на символы остаются валидными все время жизни атласа
+		* \param codePoint Код символа
+		* \return Указатель на символ (nullptr, если символ еще не растеризован)
+		*/
+		const AtlasGlyph* Find(char32_t codePoint) const;
+
+		/**
+		* \brief Добавить растеризованный символ (маска копируется на свободное место, атлас растет при нехватке)
+		* \param codePoint Код символа
+		* \param bitmap Растеризованный символ
+		* \return Ссылка на символ в атласе
+		*/
+		const AtlasGlyph& Add(char32_t codePoint, const GlyphBitmap& bitmap);
+
+		/**
+		* \brief Получить метрики шрифта
+		* \return Метрики
+		*/
+		const FontMetrics& GetMetrics() const;
+
+		/**
+		* \brief Получить маску покрытия (указатель меняется при росте атласа)
+		* \return Указатель на первый байт верхней строки
+		*/
+		const unsigned char* GetCoverage() const;
+
+		/**
+		* \brief Получить ширину маски (длину строки в байтах)
+		* \return Ширина
+		*/
+		int GetWidth() const;
+
+		/**
+		* \brief Получить высоту маски
+		* \return Высота
+		*/
+		int GetHeight() const;
+	};
+
+	/**
+	* \brief Разложенная на символы строка текста
+	*/
+	struct TextRun
+	{
+		/**
+		* \brief Символ строки
+		*/
+		struct Glyph
+		{
+			const AtlasGlyph* glyph;           // Символ в атласе
+			int x;                             // Начало символа относительно начала строки
+			int y;                             // Базовая линия относительно базовой линии первой строки текста
+		};
+
+		GlyphAtlas* atlas;                     // Атлас шрифта
+		std::vector<Glyph> glyphs;             // Символы, имеющие изображение (пробелы не входят)
+		Vector2D<int> size;                    // Размеры текста (ширина самой длинной строки, высота всех строк)
+		RECT bounds;                           // Границы маски относительно левого верхнего угла текста
+		std::vector<unsigned char> coverage;   // Маска покрытия всего текста (строки подряд, ширина - по bounds)
+	};
+
+	class GlyphCache
+	{
+	private:
+		/**
+		* \brief Ключ атласа (копия параметров шрифта, имя семейства хранится строкой)
+		*/
+		struct AtlasKey
+		{
+			std::string family;
+			unsigned int size;
+			bool bold;
+			bool italic;
+
+			bool operator<(const AtlasKey& other) const;
+		};
+
+		/**
+		* \brief Атлас шрифта в кеше
+		*/
+		struct AtlasEntry
+		{
+			std::unique_ptr<GlyphAtlas> atlas; // Атлас
+			HFONT hFont;                       // Шрифт (ссылка в кеше графических объектов удерживается, пока жив атлас)
+		};
+
+		/**
+		* \brief Запись кеша строк
+		*/
+		struct RunEntry
+		{
+			std::string key;                   // Ключ: адрес атласа и текст
+			TextRun run;                       // Разложенная строка
+		};
+
+		std::map<AtlasKey, AtlasEntry> atlases_;                                     // Атласы по параметрам шрифта
+		std::list<RunEntry> runs_;                                                   // Строки (в начале - последние использованные)
+		std::unordered_map<std::string_view, std::list<RunEntry>::iterator> runIndex_;// Поиск строки по ключу (ключи хранятся в runs_)
+		size_t runCapacity_;                                                         // Максимальное кол-во строк в кеше
+		AtlasKey lookupAtlas_;                                                       // Ключ для поиска атласа (память переиспользуется)
+		std::string lookupRun_;                                                      // Ключ для поиска строки (память переиспользуется)
+		GlyphCacheStatistics statistics_;                                            // Статистика
+
+		/**
+		* \brief Найти атлас шрифта (создается при первом обращении, вместе с ним запрашивается шрифт)
+		* \param font Параметры шрифта
+		* \return Ссылка на запись атласа
+		*/
+		AtlasEntry& FindAtlas(const FontSettings& font);
+
+		/**
+		* \brief Разложить текст на символы, растеризуя недостающие
+		* \param text Текст (UTF-8, перевод строки начинает новую строку)
+		* \param entry Атлас шрифта
+		* \param run Разложенная строка
+		*/
+		void Shape(std::string_view text, const AtlasEntry& entry, TextRun& run);
+
+		/**
+		* \brief Свести маски символов разложенной строки в общую маску
+		* \param run Разложенная строка
+		*/
+		static void Compose(TextRun& run);
+
+	public:
+		/**
+		* \brief Емкость кеша строк по умолчанию
+		*/
+		static const size_t DEFAULT_RUN_CAPACITY = 1024;
+
+		/**
+		* \brief Конструктор
+		*/
+		GlyphCache();
+
+		/**
+		* \brief Получить атлас шрифта (создается при первом обращении)
+		* \param font Параметры шрифта
+		* \return Ссылка на атлас
+		*/
+		GlyphAtlas& GetAtlas(const FontSettings& font);
+
+		/**
+		* \brief Получить разложенную на символы строку (из кеша либо раскладывается и помещается в кеш)
+		* \details Ссылка остается валидной до следующего вызова GetRun или Clear
+		* \param text Текст (UTF-8, перевод строки начинает новую строку)
+		* \param font Параметры шрифта
+		* \return Ссылка на строку
+		*/
+		const TextRun& GetRun(std::string_view text, const FontSettings& font);
+
+		/**
+		* \brief Установить емкость кеша строк (лишние давно не используемые строки вытесняются)
+		* \param capacity Максимальное кол-во строк (не меньше 1)
+		*/
+		void SetRunCapacity(size_t capacity);
+
+		/**
+		* \brief Удалить все атласы и строки (например, после смены бэкенда), шрифты атласов освобождаются
+		*/
+		void Clear();
+
+		/**
+		* \brief Получить статистику
+		* \return Копия статистики
+		*/
+		GlyphCacheStatistics GetStatistics() const;
+
+		/**
+		* \brief Сбросить счетчики попаданий, промахов и вытеснений
+		*/
+		void ResetStatistics();
+	};
+
+	/**
+	* \brief Получить общий (на весь процесс) кеш символов
+	* \return Ссылка на кеш
+	*/
+	GlyphCache& GetGlyphCache();
+}
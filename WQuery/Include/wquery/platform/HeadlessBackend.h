@@ -0,0 +1,292 @@
+﻿/**
+* \brief Headless-бэкенд (интерфейс)
+* \details Окна и элементы управления существуют только в памяти. Сообщения синтетические, но
+* проходят через ту же очередь и ту же оконную процедуру (Window::WndProc), что и в случае WinApi.
+* Клиентская область окна совпадает с окном целиком (рамок и заголовка нет). Время сообщений
+* берется из виртуальных часов, которые двигаются только явно (AdvanceTime), что делает замеры
+* детерминированными. Бэкенд собирается на любой платформе
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "Backend.h"
+
+namespace wquery
+{
+	class HeadlessBackend : public Backend
+	{
+	public:
+		/**
+		* \brief Состояние окна или элемента управления в памяти
+		*/
+		struct Node
+		{
+			HWND handle;                       // Хендл
+			HWND parent;                       // Хендл родителя
+			std::vector<HWND> children;        // Дочерние элементы
+			std::string className;             // Наименование класса
+			std::string text;                  // Текст (заголовок)
+			DWORD style;                       // Стиль
+			int x, y;                          // Положение относительно клиентской области родителя
+			int width, height;                 // Размеры
+			void* userData;                    // Указатель на объект WQuery
+			HFONT font;                        // Шрифт
+			bool isWindow;                     // Окно WQuery (а не элемент управления)
+			bool minimized;                    // Свернуто
+			bool invalid;                      // Требует перерисовки
+			bool eraseBackground;              // Требует стирания фона при перерисовке
+			RECT invalidBounds;                // Границы недействительной области (пока invalid == true)
+			std::vector<std::uint32_t> surface;// Клиентская область, выведенная PresentPixels (только окна)
+			int surfaceWidth, surfaceHeight;   // Размеры выведенной клиентской области
+			unsigned int presents;             // Кол-во выводов буфера пикселей
+		};
+
+	private:
+		/**
+		* \brief Графический объект (кисть или шрифт)
+		*/
+		struct GdiObject
+		{
+			bool stock;                        // Системный объект (не удаляется)
+			ColorRGB color;                    // Цвет кисти
+			FontSettings font;                 // Параметры шрифта
+		};
+
+		HINSTANCE hInstance_;                                  // Хендл приложения (фиктивный)
+		WNDPROC wndProc_;                                      // Оконная процедура окон WQuery
+		HBRUSH classBrush_;                                    // Кисть фона оконного класса
+
+		std::vector<std::unique_ptr<Node>> nodes_;             // Окна и элементы (индекс = значение хендла - 1)
+		size_t liveNodes_;                                     // Кол-во существующих окон и элементов
+		std::vector<HWND> invalidWindows_;                     // Окна ожидающие WM_PAINT
+		HWND focus_;                                           // Окно или элемент с фокусом ввода
+
+		std::unordered_map<std::uintptr_t, GdiObject> objects_;// Графические объекты
+		std::uintptr_t nextObject_;                            // Значение следующего хендла графического объекта
+		HFONT defaultFont_;                                    // Шрифт по умолчанию
+		std::set<std::string> fontFamilies_;                   // Имена семейств шрифтов (стабильные указатели)
+
+		std::deque<MSG> queue_;                                // Очередь сообщений
+		mutable std::mutex queueMutex_;                        // Блокировка очереди
+		std::condition_variable queueCondition_;               // Ожидание сообщений
+		std::atomic<DWORD> time_;                              // Виртуальное время (мс)
+		DWORD messageTime_;                                    // Время обрабатываемого сообщения (мс)
+
+		/**
+		* \brief Получить узел по хендлу
+		* \param hWnd Хендл
+		* \return Указатель на узел (nullptr если не существует)
+		*/
+		Node* GetNode(HWND hWnd) const;
+
+		/**
+		* \brief Создать узел
+		* \param className Наименование класса
+		* \param parent Хендл родителя
+		* \param dwStyle Стиль
+		* \param size Размеры
+		* \param isWindow Является ли окном WQuery
+		* \return Хендл
+		*/
+		HWND CreateNode(const std::string& className, HWND parent, DWORD dwStyle, const Vector2D<int>& size, bool isWindow);
+
+		/**
+		* \brief Перечислить потомков (рекурсивно)
+		* \param node Узел
+		* \param enumProc Функция обратного вызова
+		* \param lParam Параметр
+		* \return Следует ли продолжать перечисление
+		*/
+		bool EnumNode(const Node* node, WNDENUMPROC enumProc, LPARAM lParam);
+
+		/**
+		* \brief Оконная процедура стандартных элементов управления ("Button", "Edit" и т.д.)
+		* \param node Узел элемента
+		* \param message Идентификатор сообщения
+		* \param wParam Параметр
+		* \param lParam Параметр
+		* \return Результат обработки
+		*/
+		LRESULT ControlProc(Node* node, UINT message, WPARAM wParam, LPARAM lParam);
+
+		/**
+		* \brief Извлечь синтетическое сообщение WM_PAINT для недействительного окна
+		* \param msg Структура для записи сообщения
+		* \return Было ли извлечено сообщение
+		*/
+		bool PopPaintMessage(MSG* msg);
+
+		/**
+		* \brief Создать графический объект
+		* \param object Объект
+		* \return Хендл
+		*/
+		HGDIOBJ CreateObject(const GdiObject& object);
+
+	public:
+		/**
+		* \brief Конструктор
+		*/
+		HeadlessBackend();
+
+		/**
+		* \brief Деструктор
+		*/
+		~HeadlessBackend() override;
+
+		const char* GetName() const override;
+
+		void RegisterWindowClass(HINSTANCE hInstance, WNDPROC wndProc, const ColorRGB& bgColor) override;
+		HINSTANCE GetInstance() const override;
+
+		HWND CreateWindowHandle(HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* title) override;
+		HWND CreateControlHandle(const std::string& className, HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* text) override;
+		void DestroyHandle(HWND hWnd) override;
+		bool IsWindowHandle(HWND hWnd) const override;
+		void EnumChildren(HWND hWnd, WNDENUMPROC enumProc, LPARAM lParam) override;
+
+		void SetUserData(HWND hWnd, void* data) override;
+		void* GetUserData(HWND hWnd) const override;
+		void SetText(HWND hWnd, const char* text) override;
+		size_t GetTextLength(HWND hWnd) const override;
+		size_t GetText(HWND hWnd, char* buffer, size_t capacity) const override;
+		void SetTextUtf16(HWND hWnd, const char16_t* text) override;
+		size_t GetTextLengthUtf16(HWND hWnd) const override;
+		size_t GetTextUtf16(HWND hWnd, char16_t* buffer, size_t capacity) const override;
+		DWORD GetStyle(HWND hWnd) const override;
+		void SetStyle(HWND hWnd, DWORD dwStyle) override;
+		void Enable(HWND hWnd, bool state) override;
+		void SetFocus(HWND hWnd) override;
+		HWND GetFocus() const override;
+		void SetIcon(HWND hWnd, const std::string& iconFilename, int width, int height) override;
+		void EnableSysMenuItem(HWND hWnd, UINT item, bool enabled) override;
+
+		void SetPos(HWND hWnd, int x, int y, int width, int height, UINT flags) override;
+		void SetPosBatch(const HWND* handles, const Vector2D<int>* positions, const Vector2D<int>* sizes, size_t count) override;
+		bool GetWindowRect(HWND hWnd, RECT* rect) const override;
+		bool GetClientRect(HWND hWnd, RECT* rect) const override;
+		Vector2D<int> GetFrameSize(DWORD dwStyle) const override;
+		void ScreenToClient(HWND hWnd, POINT* point) const override;
+
+		void Show(HWND hWnd, int cmdShow) override;
+		void Invalidate(HWND hWnd, const RECT* rect, bool erase) override;
+		void Update(HWND hWnd) override;
+		void Redraw(HWND hWnd) override;
+		void FillRect(HDC hdc, const RECT* rect, HBRUSH hBrush) override;
+		void PresentPixels(HWND hWnd, const std::uint32_t* pixels, int width, int height) override;
+
+		HBRUSH CreateBrush(const ColorRGB& color) override;
+		HFONT CreateFontObject(const FontSettings& font) override;
+		HFONT GetDefaultFont() const override;
+		bool GetFontSettings(HFONT hFont, FontSettings& font) override;
+		bool GetFontMetrics(HFONT hFont, FontMetrics& metrics) override;
+		bool RasterizeGlyph(HFONT hFont, char32_t codePoint, GlyphBitmap& glyph) override;
+		void DeleteObject(HGDIOBJ object) override;
+
+		LRESULT Send(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) override;
+		bool Post(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) override;
+		LRESULT DefaultProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) override;
+		void PostQuit(int exitCode) override;
+		bool GetNextMessage(MSG* msg) override;
+		bool PeekNextMessage(MSG* msg) override;
+		bool WaitForMessage(unsigned int timeoutMicroseconds) override;
+		void Dispatch(const MSG* msg) override;
+		DWORD GetCurrentMessageTime() const override;
+		bool IsCurrentMessageSent() const override;
+		DWORD GetMessageClock() const override;
+		bool Wake() override;
+
+		/*
+		* И Н С П Е К Ц И Я  И  С И М У Л Я Ц И Я
+		*/
+
+		/**
+		* \brief Получить состояние окна или элемента (только для чтения)
+		* \param hWnd Хендл
+		* \return Указатель на узел (nullptr если не существует)
+		*/
+		const Node* FindNode(HWND hWnd) const;
+
+		/**
+		* \brief Кол-во существующих окон и элементов
+		* \return Кол-во
+		*/
+		size_t GetHandleCount() const;
+
+		/**
+		* \brief Кол-во существующих графических объектов (без системных)
+		* \return Кол-во
+		*/
+		size_t GetObjectCount() const;
+
+		/**
+		* \brief Кол-во сообщений в очереди
+		* \return Кол-во
+		*/
+		size_t GetQueueLength() const;
+
+		/**
+		* \brief Получить текущее виртуальное время
+		* \return Время в миллисекундах
+		*/
+		DWORD GetTime() const;
+
+		/**
+		* \brief Сдвинуть виртуальное время
+		* \param milliseconds Кол-во миллисекунд
+		*/
+		void AdvanceTime(DWORD milliseconds);
+
+		/**
+		* \brief Имитировать нажатие на элемент управления (WM_COMMAND с BN_CLICKED родителю)
+		* \param hControl Хендл элемента
+		*/
+		void SimulateClick(HWND hControl);
+
+		/**
+		* \brief Имитировать ввод текста в поле (текст меняется, родитель получает EN_CHANGE)
+		* \param hControl Хендл элемента
+		* \param text Новый текст
+		*/
+		void SimulateTyping(HWND hControl, const std::string& text);
+
+		/**
+		* \brief Имитировать действие мыши (WM_MOUSEMOVE, WM_*BUTTONDOWN, WM_*BUTTONUP)
+		* \param hWnd Хендл окна
+		* \param message Идентификатор сообщения
+		* \param x Положение курсора
+		* \param y Положение курсора
+		*/
+		void SimulateMouse(HWND hWnd, UINT message, int x, int y);
+
+		/**
+		* \brief Имитировать прокрутку колеса мыши (WM_MOUSEWHEEL)
+		* \param hWnd Хендл окна
+		* \param delta Величина прокрутки (кратна WHEEL_DELTA, положительная - от пользователя)
+		*/
+		void SimulateWheel(HWND hWnd, int delta);
+
+		/**
+		* \brief Имитировать нажатие клавиши (WM_KEYDOWN, WM_CHAR для печатных символов, WM_KEYUP)
+		* \param hWnd Хендл окна
+		* \param code Код клавиши
+		* \param symbol Символ (0 - не печатная клавиша)
+		*/
+		void SimulateKey(HWND hWnd, unsigned int code, char symbol = 0);
+
+		/**
+		* \brief Имитировать изменение размеров окна пользователем
+		* \param hWnd Хендл окна
+		* \param width Ширина
+		* \param height Высота
+		*/
+		void SimulateResize(HWND hWnd, int width, int height);
+
+		/**
+		* \brief Имитировать закрытие окна пользователем (WM_CLOSE)
+		* \param hWnd Хендл окна
+		*/
+		void SimulateClose(HWND hWnd);
+	};
+}
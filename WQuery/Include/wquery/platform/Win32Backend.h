@@ -0,0 +1,117 @@
+﻿/**
+* \brief Бэкенд WinApi (интерфейс)
+* \details Реализация платформенного слоя поверх настоящих окон и сообщений WinApi. Доступна только на Windows
+*/
+
+#pragma once
+
+#ifdef _WIN32
+
+#include "../stdafx.h"
+#include "Backend.h"
+
+namespace wquery
+{
+	class Win32Backend : public Backend
+	{
+	private:
+		HINSTANCE hInstance_;                  // Хендл приложения
+		WNDCLASSEX classInfo_;                 // Параметры оконного класса WQuery
+		std::set<std::string> fontFamilies_;   // Имена семейств шрифтов (для стабильных указателей в FontSettings)
+		HANDLE waitTimer_;                     // Таймер ожидания сообщений (WaitForMessage)
+		std::atomic<HWND> wakeWindow_;         // Служебное окно (только для сообщений), принимающее WM_WQUERY_WAKE
+		HDC measureDC_;                        // Контекст в памяти для метрик и растеризации символов (создается при первом обращении)
+
+		/**
+		* \brief Получить контекст в памяти с выбранным шрифтом
+		* \param hFont Хендл шрифта
+		* \return Контекст (nullptr при ошибке создания)
+		*/
+		HDC SelectMeasureFont(HFONT hFont);
+
+		/**
+		* \brief Оконная процедура служебного окна пробуждения
+		* \param hWnd Хендл окна
+		* \param message Сообщение
+		* \param wParam Параметр
+		* \param lParam Параметр
+		* \return Результат обработки
+		*/
+		static LRESULT CALLBACK WakeWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+
+	public:
+		/**
+		* \brief Конструктор
+		*/
+		Win32Backend();
+
+		/**
+		* \brief Деструктор
+		*/
+		~Win32Backend() override;
+
+		const char* GetName() const override;
+
+		void RegisterWindowClass(HINSTANCE hInstance, WNDPROC wndProc, const ColorRGB& bgColor) override;
+		HINSTANCE GetInstance() const override;
+
+		HWND CreateWindowHandle(HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* title) override;
+		HWND CreateControlHandle(const std::string& className, HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* text) override;
+		void DestroyHandle(HWND hWnd) override;
+		bool IsWindowHandle(HWND hWnd) const override;
+		void EnumChildren(HWND hWnd, WNDENUMPROC enumProc, LPARAM lParam) override;
+
+		void SetUserData(HWND hWnd, void* data) override;
+		void* GetUserData(HWND hWnd) const override;
+		void SetText(HWND hWnd, const char* text) override;
+		size_t GetTextLength(HWND hWnd) const override;
+		size_t GetText(HWND hWnd, char* buffer, size_t capacity) const override;
+		void SetTextUtf16(HWND hWnd, const char16_t* text) override;
+		size_t GetTextLengthUtf16(HWND hWnd) const override;
+		size_t GetTextUtf16(HWND hWnd, char16_t* buffer, size_t capacity) const override;
+		DWORD GetStyle(HWND hWnd) const override;
+		void SetStyle(HWND hWnd, DWORD dwStyle) override;
+		void Enable(HWND hWnd, bool state) override;
+		void SetFocus(HWND hWnd) override;
+		HWND GetFocus() const override;
+		void SetIcon(HWND hWnd, const std::string& iconFilename, int width, int height) override;
+		void EnableSysMenuItem(HWND hWnd, UINT item, bool enabled) override;
+
+		void SetPos(HWND hWnd, int x, int y, int width, int height, UINT flags) override;
+		void SetPosBatch(const HWND* handles, const Vector2D<int>* positions, const Vector2D<int>* sizes, size_t count) override;
+		bool GetWindowRect(HWND hWnd, RECT* rect) const override;
+		bool GetClientRect(HWND hWnd, RECT* rect) const override;
+		Vector2D<int> GetFrameSize(DWORD dwStyle) const override;
+		void ScreenToClient(HWND hWnd, POINT* point) const override;
+
+		void Show(HWND hWnd, int cmdShow) override;
+		void Invalidate(HWND hWnd, const RECT* rect, bool erase) override;
+		void Update(HWND hWnd) override;
+		void Redraw(HWND hWnd) override;
+		void FillRect(HDC hdc, const RECT* rect, HBRUSH hBrush) override;
+		void PresentPixels(HWND hWnd, const std::uint32_t* pixels, int width, int height) override;
+
+		HBRUSH CreateBrush(const ColorRGB& color) override;
+		HFONT CreateFontObject(const FontSettings& font) override;
+		HFONT GetDefaultFont() const override;
+		bool GetFontSettings(HFONT hFont, FontSettings& font) override;
+		bool GetFontMetrics(HFONT hFont, FontMetrics& metrics) override;
+		bool RasterizeGlyph(HFONT hFont, char32_t codePoint, GlyphBitmap& glyph) override;
+		void DeleteObject(HGDIOBJ object) override;
+
+		LRESULT Send(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) override;
+		bool Post(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) override;
+		LRESULT DefaultProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) override;
+		void PostQuit(int exitCode) override;
+		bool GetNextMessage(MSG* msg) override;
+		bool PeekNextMessage(MSG* msg) override;
+		bool WaitForMessage(unsigned int timeoutMicroseconds) override;
+		void Dispatch(const MSG* msg) override;
+		DWORD GetCurrentMessageTime() const override;
+		bool IsCurrentMessageSent() const override;
+		DWORD GetMessageClock() const override;
+		bool Wake() override;
+	};
+}
+
+#endif
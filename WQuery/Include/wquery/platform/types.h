@@ -0,0 +1,212 @@
+﻿/**
+* \brief Нативные типы и константы платформы
+* \details На Windows файл просто подключает Windows.h. На остальных платформах (headless-сборка)
+* объявляется минимальное подмножество типов, макросов и констант WinApi, которые используются
+* в интерфейсах и оконной процедуре библиотеки. Значения констант совпадают с WinApi.
+*/
+
+#pragma once
+
+#ifdef _WIN32
+
+#include <Windows.h>
+
+#else
+
+#include <cstdint>
+
+/*
+* Б А З О В Ы Е  Т И П Ы
+*/
+
+#define WQUERY_DECLARE_HANDLE(name) struct name##__; typedef struct name##__ * name
+
+WQUERY_DECLARE_HANDLE(HWND);
+WQUERY_DECLARE_HANDLE(HINSTANCE);
+WQUERY_DECLARE_HANDLE(HBRUSH);
+WQUERY_DECLARE_HANDLE(HFONT);
+WQUERY_DECLARE_HANDLE(HICON);
+WQUERY_DECLARE_HANDLE(HDC);
+
+typedef void* HANDLE;
+typedef void* HGDIOBJ;
+typedef int BOOL;
+typedef std::uint8_t BYTE;
+typedef std::uint16_t WORD;
+typedef std::uint32_t DWORD;
+typedef std::uint32_t UINT;
+typedef std::int32_t LONG;
+typedef std::uintptr_t WPARAM;
+typedef std::intptr_t LPARAM;
+typedef std::intptr_t LRESULT;
+typedef std::intptr_t LONG_PTR;
+typedef DWORD COLORREF;
+
+#define CALLBACK
+#define TRUE 1
+#define FALSE 0
+
+typedef LRESULT(CALLBACK *WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef BOOL(CALLBACK *WNDENUMPROC)(HWND, LPARAM);
+
+struct POINT
+{
+	LONG x;
+	LONG y;
+};
+
+struct RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+struct MSG
+{
+	HWND hwnd;
+	UINT message;
+	WPARAM wParam;
+	LPARAM lParam;
+	DWORD time;
+	POINT pt;
+};
+
+struct MINMAXINFO
+{
+	POINT ptReserved;
+	POINT ptMaxSize;
+	POINT ptMaxPosition;
+	POINT ptMinTrackSize;
+	POINT ptMaxTrackSize;
+};
+
+typedef MINMAXINFO* LPMINMAXINFO;
+
+/*
+* М А К Р О С Ы
+*/
+
+#define LOWORD(l) (static_cast<WORD>(static_cast<std::uintptr_t>(l) & 0xffff))
+#define HIWORD(l) (static_cast<WORD>((static_cast<std::uintptr_t>(l) >> 16) & 0xffff))
+#define MAKELONG(a, b) (static_cast<LONG>(static_cast<DWORD>(static_cast<WORD>(a)) | (static_cast<DWORD>(static_cast<WORD>(b)) << 16)))
+#define MAKELPARAM(l, h) (static_cast<LPARAM>(static_cast<DWORD>(MAKELONG(l, h))))
+#define MAKEWPARAM(l, h) (static_cast<WPARAM>(static_cast<DWORD>(MAKELONG(l, h))))
+#define GET_WHEEL_DELTA_WPARAM(w) (static_cast<short>(HIWORD(w)))
+#define RGB(r, g, b) (static_cast<COLORREF>(static_cast<BYTE>(r) | (static_cast<WORD>(static_cast<BYTE>(g)) << 8) | (static_cast<DWORD>(static_cast<BYTE>(b)) << 16)))
+#define GetRValue(rgb) (static_cast<BYTE>(rgb))
+#define GetGValue(rgb) (static_cast<BYTE>(static_cast<WORD>(rgb) >> 8))
+#define GetBValue(rgb) (static_cast<BYTE>((rgb) >> 16))
+
+/*
+* С О О Б Щ Е Н И Я
+*/
+
+#define WM_NULL             0x0000
+#define WM_CREATE           0x0001
+#define WM_DESTROY          0x0002
+#define WM_MOVE             0x0003
+#define WM_SIZE             0x0005
+#define WM_SETFOCUS         0x0007
+#define WM_KILLFOCUS        0x0008
+#define WM_SETTEXT          0x000C
+#define WM_GETTEXT          0x000D
+#define WM_GETTEXTLENGTH    0x000E
+#define WM_PAINT            0x000F
+#define WM_CLOSE            0x0010
+#define WM_QUIT             0x0012
+#define WM_ERASEBKGND       0x0014
+#define WM_GETMINMAXINFO    0x0024
+#define WM_SETFONT          0x0030
+#define WM_SETICON          0x0080
+#define WM_NCPAINT          0x0085
+#define WM_KEYDOWN          0x0100
+#define WM_KEYUP            0x0101
+#define WM_CHAR             0x0102
+#define WM_COMMAND          0x0111
+#define WM_TIMER            0x0113
+#define WM_MOUSEMOVE        0x0200
+#define WM_LBUTTONDOWN      0x0201
+#define WM_LBUTTONUP        0x0202
+#define WM_RBUTTONDOWN      0x0204
+#define WM_RBUTTONUP        0x0205
+#define WM_MBUTTONDOWN      0x0207
+#define WM_MBUTTONUP        0x0208
+#define WM_MOUSEWHEEL       0x020A
+#define WM_USER             0x0400
+#define WM_APP              0x8000
+
+#define WHEEL_DELTA         120
+
+#define VK_BACK             0x08
+#define VK_TAB              0x09
+#define VK_RETURN           0x0D
+#define VK_PRIOR            0x21
+#define VK_NEXT             0x22
+#define VK_END              0x23
+#define VK_HOME             0x24
+#define VK_LEFT             0x25
+#define VK_UP               0x26
+#define VK_RIGHT            0x27
+#define VK_DOWN             0x28
+#define VK_DELETE           0x2E
+
+#define SIZE_RESTORED       0
+#define SIZE_MINIMIZED      1
+#define SIZE_MAXIMIZED      2
+
+#define BN_CLICKED          0
+#define EN_SETFOCUS         0x0100
+#define EN_KILLFOCUS        0x0200
+#define EN_CHANGE           0x0300
+
+#define EM_SETPASSWORDCHAR  0x00CC
+
+#define ICON_SMALL          0
+#define ICON_BIG            1
+
+/*
+* С Т И Л И  О К О Н
+*/
+
+#define WS_OVERLAPPED       0x00000000L
+#define WS_CHILD            0x40000000L
+#define WS_CHILDWINDOW      WS_CHILD
+#define WS_VISIBLE          0x10000000L
+#define WS_DISABLED         0x08000000L
+#define WS_CAPTION          0x00C00000L
+#define WS_BORDER           0x00800000L
+#define WS_SYSMENU          0x00080000L
+#define WS_THICKFRAME       0x00040000L
+#define WS_SIZEBOX          WS_THICKFRAME
+#define WS_MINIMIZEBOX      0x00020000L
+#define WS_MAXIMIZEBOX      0x00010000L
+#define WS_OVERLAPPEDWINDOW (WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_THICKFRAME | WS_MINIMIZEBOX | WS_MAXIMIZEBOX)
+
+#define ES_PASSWORD         0x0020L
+
+#define SC_CLOSE            0xF060
+
+#define SW_HIDE             0
+#define SW_SHOWNORMAL       1
+#define SW_SHOWMINIMIZED    2
+#define SW_SHOWMAXIMIZED    3
+
+#define SWP_NOSIZE          0x0001
+#define SWP_NOMOVE          0x0002
+#define SWP_NOZORDER        0x0004
+#define SWP_NOREDRAW        0x0008
+#define SWP_NOACTIVATE      0x0010
+#define SWP_ASYNCWINDOWPOS  0x4000
+
+/*
+* К О Д О В Ы Е  С Т Р А Н И Ц Ы
+*/
+
+#define CP_ACP              0
+#define CP_UTF8             65001
+#define MB_PRECOMPOSED      0x00000001
+#define WC_COMPOSITECHECK   0x00000200
+
+#endif
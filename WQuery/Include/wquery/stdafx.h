@@ -1,7 +1,13 @@
 ﻿#pragma once
 
 #include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <new>
+#include <cmath>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <fstream>
@@ -9,8 +15,21 @@
 #include <functional>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <list>
 #include <deque>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <type_traits>
+#include <coroutine>
 
-#include <Windows.h>
\ No newline at end of file
+#include "platform/types.h"
\ No newline at end of file
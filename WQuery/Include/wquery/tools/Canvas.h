@@ -0,0 +1,206 @@
+﻿/**
+* \brief Программная поверхность рисования (интерфейс)
+* \details Холст - 32-битный буфер пикселей (0x00RRGGBB, строки сверху вниз, формат совпадает с 32-битным DIB),
+* в который рисует обработчик Window::events.onPaint. Окно выводит готовый буфер на экран одним копированием
+* (\see Backend::PresentPixels), поэтому промежуточные состояния рисования не видны. Все операции ограничены
+* областью отсечения, полупрозрачные цвета (ColorRGB::A < 255) накладываются на содержимое холста. Внутренние
+* циклы выполняются растровыми функциями (\see wquery::FillPixels и др.). Не зависит от платформы
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "../types/common.h"
+
+namespace wquery
+{
+	/**
+	* \brief Упаковать цвет в пиксель холста
+	* \param color Цвет
+	* \return Пиксель (0x00RRGGBB)
+	*/
+	inline std::uint32_t PackPixel(const ColorRGB& color)
+	{
+		return (static_cast<std::uint32_t>(color.R) << 16) | (static_cast<std::uint32_t>(color.G) << 8) | static_cast<std::uint32_t>(color.B);
+	}
+
+	/**
+	* \brief Распаковать пиксель холста в цвет
+	* \param pixel Пиксель (0x00RRGGBB)
+	* \return Цвет
+	*/
+	inline ColorRGB UnpackPixel(std::uint32_t pixel)
+	{
+		return ColorRGB(static_cast<unsigned char>(pixel >> 16), static_cast<unsigned char>(pixel >> 8), static_cast<unsigned char>(pixel));
+	}
+
+	class Canvas
+	{
+	private:
+		std::vector<std::uint32_t> pixels_;                     // Пиксели (строки подряд, без выравнивания)
+		int width_;                                             // Ширина
+		int height_;                                            // Высота
+		RECT clip_;                                             // Область отсечения (всегда внутри холста)
+
+		/**
+		* \brief Ограничить прямоугольник областью отсечения
+		* \param rect Прямоугольник
+		* \return Пуст ли результат
+		*/
+		bool Clip(RECT& rect) const;
+
+		/**
+		* \brief Получить указатель на пиксель (без проверки границ)
+		* \param x Столбец
+		* \param y Строка
+		* \return Указатель
+		*/
+		std::uint32_t* PixelAt(int x, int y);
+
+	public:
+		/**
+		* \brief Конструктор (пустой холст, память не выделяется)
+		*/
+		Canvas();
+
+		/**
+		* \brief Изменить размеры холста
+		* \details Если размеры не изменились - ничего не происходит. Иначе содержимое холста не определено,
+		* а область отсечения сбрасывается на весь холст. Память переиспользуется, если ее хватает
+		* \param size Новые размеры
+		* \return Изменились ли размеры
+		*/
+		bool Resize(const Vector2D<int>& size);
+
+		/**
+		* \brief Получить размеры
+		* \return Размеры
+		*/
+		Vector2D<int> GetSize() const;
+
+		/**
+		* \brief Получить пиксели (только для чтения)
+		* \return Указатель на первый пиксель верхней строки (nullptr у пустого холста)
+		*/
+		const std::uint32_t* GetPixels() const;
+
+		/**
+		* \brief Получить пиксели
+		* \return Указатель на первый пиксель верхней строки (nullptr у пустого холста)
+		*/
+		std::uint32_t* GetPixels();
+
+		/**
+		* \brief Установить область отсечения
+		* \param rect Прямоугольник (ограничивается размерами холста)
+		*/
+		void SetClip(const RECT& rect);
+
+		/**
+		* \brief Сбросить область отсечения на весь холст
+		*/
+		void ResetClip();
+
+		/**
+		* \brief Получить область отсечения
+		* \return Прямоугольник
+		*/
+		const RECT& GetClip() const;
+
+		/**
+		* \brief Залить область отсечения цветом
+		* \param color Цвет
+		*/
+		void Clear(const ColorRGB& color);
+
+		/**
+		* \brief Установить цвет пикселя
+		* \param x Столбец
+		* \param y Строка
+		* \param color Цвет
+		*/
+		void SetPixel(int x, int y, const ColorRGB& color);
+
+		/**
+		* \brief Получить цвет пикселя
+		* \param x Столбец
+		* \param y Строка
+		* \return Цвет (черный за пределами холста)
+		*/
+		ColorRGB GetPixel(int x, int y) const;
+
+		/**
+		* \brief Залить прямоугольник
+		* \param rect Прямоугольник
+		* \param color Цвет
+		*/
+		void FillRect(const RECT& rect, const ColorRGB& color);
+
+		/**
+		* \brief Нарисовать рамку прямоугольника
+		* \param rect Прямоугольник (рамка лежит внутри него)
+		* \param color Цвет
+		* \param thickness Толщина рамки
+		*/
+		void DrawRect(const RECT& rect, const ColorRGB& color, int thickness = 1);
+
+		/**
+		* \brief Нарисовать отрезок (включая оба конца)
+		* \param from Начало
+		* \param to Конец
+		* \param color Цвет
+		*/
+		void DrawLine(const Vector2D<int>& from, const Vector2D<int>& to, const ColorRGB& color);
+
+		/**
+		* \brief Залить прямоугольник линейным градиентом (непрозрачность цветов не учитывается)
+		* \param rect Прямоугольник
+		* \param from Цвет левого (верхнего) края
+		* \param to Цвет правого (нижнего) края
+		* \param vertical Градиент сверху вниз (иначе слева направо)
+		*/
+		void FillGradient(const RECT& rect, const ColorRGB& from, const ColorRGB& to, bool vertical = false);
+
+		/**
+		* \brief Скопировать изображение на холст
+		* \param pixels Пиксели изображения (0x00RRGGBB, строки сверху вниз)
+		* \param size Размеры изображения
+		* \param position Положение левого верхнего угла на холсте
+		*/
+		void DrawImage(const std::uint32_t* pixels, const Vector2D<int>& size, const Vector2D<int>& position);
+
+		/**
+		* \brief Скопировать изображение на холст, пропуская пиксели ключевого цвета (прозрачный фон)
+		* \param pixels Пиксели изображения (0x00RRGGBB, строки сверху вниз)
+		* \param size Размеры изображения
+		* \param position Положение левого верхнего угла на холсте
+		* \param key Ключевой цвет
+		*/
+		void DrawImageKeyed(const std::uint32_t* pixels, const Vector2D<int>& size, const Vector2D<int>& position, const ColorRGB& key);
+
+		/**
+		* \brief Наложить полупрозрачное изображение на холст
+		* \param pixels Пиксели изображения (0xAARRGGBB, premultiplied, строки сверху вниз)
+		* \param size Размеры изображения
+		* \param position Положение левого верхнего угла на холсте
+		*/
+		void BlendImage(const std::uint32_t* pixels, const Vector2D<int>& size, const Vector2D<int>& position);
+
+		/**
+		* \brief Нарисовать текст (сглаженный, через кеш символов \see wquery::GetGlyphCache)
+		* \param text Текст (UTF-8, перевод строки начинает новую строку)
+		* \param font Параметры шрифта
+		* \param position Положение левого верхнего угла текста (базовая линия ниже на высоту шрифта над ней)
+		* \param color Цвет
+		*/
+		void DrawString(std::string_view text, const FontSettings& font, const Vector2D<int>& position, const ColorRGB& color);
+
+		/**
+		* \brief Измерить текст
+		* \param text Текст (UTF-8, перевод строки начинает новую строку)
+		* \param font Параметры шрифта
+		* \return Размеры (ширина самой длинной строки, высота всех строк)
+		*/
+		static Vector2D<int> MeasureString(std::string_view text, const FontSettings& font);
+	};
+}
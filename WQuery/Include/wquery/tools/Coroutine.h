@@ -0,0 +1,444 @@
+﻿/**
+* \brief Сопрограммы (C++20) для асинхронного кода в потоке основного цикла (интерфейс)
+* \details Многошаговые сценарии записываются одной функцией-сопрограммой вместо цепочки функций обратного
+* вызова. Сопрограмма возвращает Task и запускается через wquery::Spawn (или ожидается другой сопрограммой
+* через co_await). Все ожидаемые объекты продолжают сопрограмму в потоке основного цикла (\see wquery::End):
+* NextFrame - в следующем кадре (или на следующей итерации цикла), Delay - по таймеру, OnWorker - после
+* выполнения функции в рабочем потоке, ControlBase::Notified (Button::Clicked и т.д.) - после уведомления
+* элемента. Кадры сопрограмм выделяются из пула (по классам размеров) и после завершения переиспользуются
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	class ControlBase;
+
+	template <typename T = void>
+	class Task;
+
+	/*
+	* П Л А Н И Р О В Щ И К
+	*/
+
+	/**
+	* \brief Продолжить сопрограмму на следующей итерации основного цикла
+	* \param coroutine Сопрограмма
+	*/
+	void ResumeLater(std::coroutine_handle<> coroutine);
+
+	/**
+	* \brief Продолжить сопрограмму в следующем кадре (в цикле MainLoopType::FRAME_PACED), в остальных
+	* циклах - на следующей итерации
+	* \param coroutine Сопрограмма
+	*/
+	void ResumeNextFrame(std::coroutine_handle<> coroutine);
+
+	/**
+	* \brief Есть ли сопрограммы, ожидающие продолжения на следующей итерации (вызывается основным циклом)
+	* \param frame Учитывать ожидающие следующего кадра
+	* \return Состояние
+	*/
+	bool HasPendingCoroutines(bool frame);
+
+	/**
+	* \brief Продолжить сопрограммы, ожидающие следующей итерации (вызывается основным циклом)
+	* \param frame Продолжить и ожидающие следующего кадра (начался новый кадр)
+	* \return Кол-во продолженных сопрограмм
+	*/
+	size_t ResumePendingCoroutines(bool frame);
+
+	/**
+	* \brief Продолжить сопрограмму в потоке основного цикла (может вызываться из любого потока, \see wquery::Post)
+	* \param coroutine Сопрограмма
+	*/
+	void ResumeOnLoopThread(std::coroutine_handle<> coroutine);
+
+	/**
+	* \brief Запомнить необработанное исключение запущенной через Spawn задачи (кадр задачи уже освобожден)
+	* или задачи, переданной через wquery::Post
+	* \details Исключение пробрасывается из основного цикла (\see wquery::RethrowCoroutineException),
+	* а не из места продолжения задачи (оконной процедуры, таймера, очереди кадра). Из нескольких
+	* исключений до проброса сохраняется первое
+	* \param exception Исключение
+	*/
+	void SetUnhandledCoroutineException(std::exception_ptr exception);
+
+	/**
+	* \brief Пробросить запомненное исключение задачи (вызывается основным циклом между итерациями)
+	*/
+	void RethrowCoroutineException();
+
+	/**
+	* \brief Выполнить функцию в одном из рабочих потоков (пул потоков создается при первом вызове)
+	* \param job Функция
+	*/
+	void RunOnWorker(std::function<void()> job);
+
+	/**
+	* \brief Выделить память под кадр сопрограммы (из пула потока)
+	* \param size Размер
+	* \return Указатель на память
+	*/
+	void* AllocateCoroutineFrame(size_t size);
+
+	/**
+	* \brief Вернуть память кадра сопрограммы в пул потока
+	* \param frame Указатель на память
+	* \param size Размер
+	*/
+	void FreeCoroutineFrame(void* frame, size_t size);
+
+	/*
+	* З А Д А Ч И
+	*/
+
+	/**
+	* \brief Общая часть обещания (promise) задачи
+	*/
+	class TaskPromiseBase
+	{
+	public:
+		std::coroutine_handle<> continuation;  // Ожидающая сопрограмма (продолжается по завершении)
+		bool* abandoned = nullptr;             // Признак ожидающего объекта "задача уничтожена до завершения"
+		std::exception_ptr exception;          // Необработанное исключение
+		bool detached = false;                 // Задача запущена через Spawn (кадр освобождается по завершении)
+
+		/**
+		* \brief Завершающее ожидание: передача управления ожидающей сопрограмме или освобождение кадра
+		* \details Исключение запущенной через Spawn задачи переживает кадр и передается основному циклу
+		*/
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			void await_resume() const noexcept {}
+
+			template <typename P>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<P> coroutine) noexcept
+			{
+				TaskPromiseBase& promise = coroutine.promise();
+				if (promise.continuation) return promise.continuation;
+
+				if (promise.detached)
+				{
+					std::exception_ptr exception = std::move(promise.exception);
+					coroutine.destroy();
+					if (exception) SetUnhandledCoroutineException(std::move(exception));
+				}
+
+				return std::noop_coroutine();
+			}
+		};
+
+		static void* operator new(size_t size) { return AllocateCoroutineFrame(size); }
+		static void operator delete(void* frame, size_t size) { FreeCoroutineFrame(frame, size); }
+
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		FinalAwaiter final_suspend() const noexcept { return {}; }
+
+		/**
+		* \brief Сохранить исключение (ожидающей сопрограмме - при co_await, у запущенной через Spawn задачи -
+		* основному циклу). Исключение не пробрасывается отсюда: иначе задача не дойдет до завершающего
+		* ожидания и ее кадр не будет освобожден
+		*/
+		void unhandled_exception() noexcept
+		{
+			this->exception = std::current_exception();
+		}
+	};
+
+	/**
+	* \brief Обещание задачи с результатом
+	*/
+	template <typename T>
+	class TaskPromise : public TaskPromiseBase
+	{
+	public:
+		std::optional<T> value;                // Результат
+
+		Task<T> get_return_object();
+		void return_value(T result) { this->value.emplace(std::move(result)); }
+
+		T TakeResult()
+		{
+			if (this->exception) std::rethrow_exception(this->exception);
+			return std::move(*this->value);
+		}
+	};
+
+	/**
+	* \brief Обещание задачи без результата
+	*/
+	template <>
+	class TaskPromise<void> : public TaskPromiseBase
+	{
+	public:
+		Task<void> get_return_object();
+		void return_void() const noexcept {}
+
+		void TakeResult()
+		{
+			if (this->exception) std::rethrow_exception(this->exception);
+		}
+	};
+
+	/**
+	* \brief Задача - сопрограмма, возвращающая результат типа T
+	* \details Задача "ленивая": выполнение начинается при ожидании (co_await) или при запуске через Spawn.
+	* Владеет кадром сопрограммы (освобождает его в деструкторе). Кадр приостановленной задачи деструктор
+	* не освобождает: на него ссылаются очереди продолжения (ожидающие уведомления элементов, таймеры, очередь
+	* wquery::Post, очереди итерации и кадра). Такая задача продолжает выполняться как запущенная через Spawn
+	* (результат отбрасывается, необработанное исключение пробрасывается из основного цикла). Если задачу
+	* при этом все еще ожидают, ожидающая сопрограмма продолжается на следующей итерации основного цикла
+	* с исключением std::future_error (std::future_errc::broken_promise)
+	* \tparam T Тип результата
+	*/
+	template <typename T>
+	class Task
+	{
+	public:
+		typedef TaskPromise<T> promise_type;
+
+	private:
+		std::coroutine_handle<promise_type> coroutine_;
+
+	public:
+		explicit Task(std::coroutine_handle<promise_type> coroutine) : coroutine_(coroutine) {}
+		Task(Task&& other) noexcept : coroutine_(std::exchange(other.coroutine_, nullptr)) {}
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task()
+		{
+			if (!this->coroutine_) return;
+
+			// Задача запущена (ее ожидали) и приостановлена - кадр передается ей самой, а ожидающая
+			// сопрограмма (если ее кадр еще существует) продолжается с исключением
+			promise_type& promise = this->coroutine_.promise();
+			if (promise.continuation && !this->coroutine_.done())
+			{
+				std::coroutine_handle<> awaiting = std::exchange(promise.continuation, nullptr);
+				promise.detached = true;
+
+				if (promise.abandoned)
+				{
+					*std::exchange(promise.abandoned, nullptr) = true;
+					ResumeLater(awaiting);
+				}
+
+				return;
+			}
+
+			this->coroutine_.destroy();
+		}
+
+		/**
+		* \brief Ожидание задачи
+		* \details Живет в кадре ожидающей сопрограммы. Если кадр уничтожен во время ожидания, задача
+		* больше не продолжает его (завершение передается пустой сопрограмме)
+		*/
+		class Awaiter
+		{
+		private:
+			std::coroutine_handle<promise_type> coroutine_;
+			bool waiting_;                     // Ожидающая сопрограмма приостановлена
+			bool abandoned_;                   // Задача уничтожена до завершения
+
+		public:
+			explicit Awaiter(std::coroutine_handle<promise_type> coroutine) : coroutine_(coroutine), waiting_(false), abandoned_(false) {}
+			Awaiter(const Awaiter&) = delete;
+			Awaiter& operator=(const Awaiter&) = delete;
+
+			~Awaiter()
+			{
+				if (!this->waiting_ || this->abandoned_) return;
+
+				promise_type& promise = this->coroutine_.promise();
+				promise.continuation = std::noop_coroutine();
+				promise.abandoned = nullptr;
+			}
+
+			bool await_ready() const noexcept
+			{
+				return !this->coroutine_ || this->coroutine_.done();
+			}
+
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+			{
+				promise_type& promise = this->coroutine_.promise();
+				promise.continuation = awaiting;
+				promise.abandoned = &this->abandoned_;
+				this->waiting_ = true;
+				return this->coroutine_;
+			}
+
+			T await_resume()
+			{
+				if (this->abandoned_) throw std::future_error(std::future_errc::broken_promise);
+				this->waiting_ = false;
+				return this->coroutine_.promise().TakeResult();
+			}
+		};
+
+		Awaiter operator co_await() const noexcept
+		{
+			return Awaiter(this->coroutine_);
+		}
+
+		/**
+		* \brief Запустить задачу, передав владение кадром ей самой (кадр освобождается по завершении)
+		*/
+		void Detach()
+		{
+			std::coroutine_handle<promise_type> coroutine = std::exchange(this->coroutine_, nullptr);
+			coroutine.promise().detached = true;
+			coroutine.resume();
+		}
+	};
+
+	template <typename T>
+	Task<T> TaskPromise<T>::get_return_object()
+	{
+		return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+	}
+
+	inline Task<void> TaskPromise<void>::get_return_object()
+	{
+		return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+	}
+
+	/**
+	* \brief Запустить задачу "в фоне" (без ожидания результата)
+	* \details Задача выполняется синхронно до первой точки ожидания, дальше - из основного цикла.
+	* Необработанное исключение задачи пробрасывается из основного цикла (\see wquery::End)
+	* \param task Задача
+	*/
+	template <typename T>
+	void Spawn(Task<T>&& task)
+	{
+		task.Detach();
+	}
+
+	/*
+	* О Ж И Д А Е М Ы Е  О Б Ъ Е К Т Ы
+	*/
+
+	/**
+	* \brief Ожидание следующего кадра
+	*/
+	struct NextFrameAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> coroutine) const { ResumeNextFrame(coroutine); }
+		void await_resume() const noexcept {}
+	};
+
+	/**
+	* \brief Ожидание по таймеру (\see wquery::SetTimeout)
+	*/
+	struct DelayAwaiter
+	{
+		unsigned int delay;                    // Задержка (мс)
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> coroutine) const;
+		void await_resume() const noexcept {}
+	};
+
+	/**
+	* \brief Ожидание выполнения функции в рабочем потоке
+	* \tparam F Тип функции
+	*/
+	template <typename F>
+	class WorkerAwaiter
+	{
+	public:
+		typedef std::invoke_result_t<F> Result;
+
+	private:
+		F function_;
+		std::conditional_t<std::is_void_v<Result>, bool, std::optional<Result>> result_;
+		std::exception_ptr exception_;
+
+	public:
+		explicit WorkerAwaiter(F function) : function_(std::move(function)), result_() {}
+
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> coroutine)
+		{
+			// Объект ожидания живет в кадре сопрограммы, пока она не продолжена, поэтому рабочий поток
+			// пишет результат прямо в него. Продолжение передается в поток цикла через Post
+			RunOnWorker([this, coroutine]()
+			{
+				try
+				{
+					if constexpr (std::is_void_v<Result>) this->function_();
+					else this->result_.emplace(this->function_());
+				}
+				catch (...)
+				{
+					this->exception_ = std::current_exception();
+				}
+
+				ResumeOnLoopThread(coroutine);
+			});
+		}
+
+		Result await_resume()
+		{
+			if (this->exception_) std::rethrow_exception(this->exception_);
+			if constexpr (!std::is_void_v<Result>) return std::move(*this->result_);
+		}
+	};
+
+	/**
+	* \brief Ожидание уведомления элемента управления (\see ControlBase::Notified)
+	*/
+	class NotificationAwaiter
+	{
+	private:
+		ControlBase* control_;                 // Элемент
+		WORD code_;                            // Код уведомления
+		bool received_;                        // Уведомление получено (false - элемент уничтожен)
+
+	public:
+		NotificationAwaiter(ControlBase* control, WORD code) : control_(control), code_(code), received_(false) {}
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> coroutine);
+
+		/**
+		* \brief Результат ожидания
+		* \return Было ли получено уведомление (false - элемент был уничтожен раньше)
+		*/
+		bool await_resume() const noexcept { return this->received_; }
+	};
+
+	/**
+	* \brief Дождаться следующего кадра (или следующей итерации цикла, если он не FRAME_PACED)
+	* \return Ожидаемый объект
+	*/
+	inline NextFrameAwaiter NextFrame() { return {}; }
+
+	/**
+	* \brief Дождаться истечения задержки
+	* \param delay Задержка (мс)
+	* \return Ожидаемый объект
+	*/
+	inline DelayAwaiter Delay(unsigned int delay) { return { delay }; }
+
+	/**
+	* \brief Выполнить функцию в рабочем потоке и вернуться в поток основного цикла
+	* \details Результатом co_await является результат функции (исключение функции пробрасывается)
+	* \param function Функция (не должна обращаться к окнам и элементам управления)
+	* \return Ожидаемый объект
+	*/
+	template <typename F>
+	WorkerAwaiter<std::decay_t<F>> OnWorker(F&& function)
+	{
+		return WorkerAwaiter<std::decay_t<F>>(std::forward<F>(function));
+	}
+}
@@ -0,0 +1,175 @@
+﻿/**
+* \brief Делегат - функция обратного вызова с хранением объекта внутри себя (интерфейс и реализация)
+* \details В отличие от std::function делегат никогда не выделяет память: функциональный объект (лямбда,
+* указатель на функцию) хранится во внутреннем буфере фиксированного размера, а объект, не помещающийся
+* в буфер, приводит к ошибке компиляции (большие данные следует захватывать по указателю или ссылке).
+* Вызов - один косвенный переход
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	/**
+	* \brief Размер внутреннего буфера делегата по умолчанию (лямбда, захватывающая до четырех ссылок или указателей)
+	*/
+	const size_t DELEGATE_STORAGE = 4 * sizeof(void*);
+
+	template <typename Signature, size_t Storage = DELEGATE_STORAGE>
+	class Delegate;
+
+	/**
+	* \brief Делегат
+	* \tparam R Тип результата
+	* \tparam Args Типы аргументов
+	* \tparam Storage Размер внутреннего буфера (байт)
+	*/
+	template <typename R, typename... Args, size_t Storage>
+	class Delegate<R(Args...), Storage>
+	{
+	private:
+		/**
+		* \brief Операции над хранимым объектом
+		*/
+		enum class Operation { MOVE, COPY, DESTROY };
+
+		typedef R(*Invoker)(void* storage, Args... args);
+		typedef void(*Manager)(Operation operation, void* dst, void* src);
+
+		alignas(void*) unsigned char storage_[Storage];   // Хранимый объект
+		Invoker invoke_;                                  // Вызов хранимого объекта (nullptr - делегат пуст)
+		Manager manage_;                                  // Перемещение, копирование и уничтожение (nullptr - тривиальные)
+
+		template <typename F>
+		static R Invoke(void* storage, Args... args)
+		{
+			return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+		}
+
+		template <typename F>
+		static void Manage(Operation operation, void* dst, void* src)
+		{
+			switch (operation)
+			{
+			case Operation::MOVE:
+				new (dst) F(std::move(*static_cast<F*>(src)));
+				static_cast<F*>(src)->~F();
+				break;
+			case Operation::COPY:
+				new (dst) F(*static_cast<const F*>(src));
+				break;
+			case Operation::DESTROY:
+				static_cast<F*>(dst)->~F();
+				break;
+			}
+		}
+
+		void MoveFrom(Delegate& other) noexcept
+		{
+			if (other.manage_) other.manage_(Operation::MOVE, this->storage_, other.storage_);
+			else std::memcpy(this->storage_, other.storage_, Storage);
+
+			this->invoke_ = other.invoke_;
+			this->manage_ = other.manage_;
+			other.invoke_ = nullptr;
+			other.manage_ = nullptr;
+		}
+
+		void CopyFrom(const Delegate& other)
+		{
+			if (other.manage_) other.manage_(Operation::COPY, this->storage_, const_cast<unsigned char*>(other.storage_));
+			else std::memcpy(this->storage_, other.storage_, Storage);
+
+			this->invoke_ = other.invoke_;
+			this->manage_ = other.manage_;
+		}
+
+	public:
+		/**
+		* \brief Помещается ли функциональный объект во внутренний буфер
+		*/
+		template <typename F>
+		static constexpr bool Fits = sizeof(F) <= Storage && alignof(F) <= alignof(void*) && std::is_nothrow_move_constructible_v<F>;
+
+		/**
+		* \brief Пустой делегат
+		*/
+		Delegate() noexcept : storage_(), invoke_(nullptr), manage_(nullptr) {}
+
+		/**
+		* \brief Пустой делегат
+		*/
+		Delegate(std::nullptr_t) noexcept : Delegate() {}
+
+		/**
+		* \brief Делегат, хранящий функциональный объект
+		* \param function Функциональный объект (лямбда, указатель на функцию и т.д.)
+		*/
+		template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Delegate> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>>>
+		Delegate(F&& function) : Delegate()
+		{
+			typedef std::decay_t<F> Function;
+			static_assert(Fits<Function>, "WQuery: Delegate function object is too large (capture large data by pointer or reference)");
+
+			new (this->storage_) Function(std::forward<F>(function));
+			this->invoke_ = &Delegate::Invoke<Function>;
+			if constexpr (!std::is_trivially_copyable_v<Function>) this->manage_ = &Delegate::Manage<Function>;
+		}
+
+		Delegate(Delegate&& other) noexcept : Delegate() { this->MoveFrom(other); }
+		Delegate(const Delegate& other) : Delegate() { this->CopyFrom(other); }
+
+		Delegate& operator=(Delegate&& other) noexcept
+		{
+			if (this != &other) {
+				this->Reset();
+				this->MoveFrom(other);
+			}
+			return *this;
+		}
+
+		Delegate& operator=(const Delegate& other)
+		{
+			if (this != &other) {
+				this->Reset();
+				this->CopyFrom(other);
+			}
+			return *this;
+		}
+
+		~Delegate()
+		{
+			this->Reset();
+		}
+
+		/**
+		* \brief Очистить делегат (уничтожить хранимый объект)
+		*/
+		void Reset() noexcept
+		{
+			if (this->manage_) this->manage_(Operation::DESTROY, this->storage_, nullptr);
+			this->invoke_ = nullptr;
+			this->manage_ = nullptr;
+		}
+
+		/**
+		* \brief Хранит ли делегат функциональный объект
+		*/
+		explicit operator bool() const noexcept
+		{
+			return this->invoke_ != nullptr;
+		}
+
+		/**
+		* \brief Вызвать хранимый объект (делегат не должен быть пуст)
+		* \param args Аргументы
+		* \return Результат
+		*/
+		R operator()(Args... args) const
+		{
+			return this->invoke_(const_cast<unsigned char*>(this->storage_), std::forward<Args>(args)...);
+		}
+	};
+}
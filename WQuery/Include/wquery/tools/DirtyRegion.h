@@ -0,0 +1,85 @@
+﻿/**
+* \brief Недействительная (требующая перерисовки) область окна (интерфейс)
+* \details Область - небольшой набор прямоугольников. Добавляемый прямоугольник поглощается уже имеющимся,
+* если лежит внутри него, поглощает лежащие внутри себя и сливается с пересекающимися или соприкасающимися,
+* если их объединение почти не добавляет лишней площади. При превышении лимита прямоугольник сливается с тем,
+* объединение с которым дает наименьший прирост площади. Не зависит от платформы
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	class DirtyRegion
+	{
+	public:
+		static constexpr size_t MAX_RECTS = 16;                 // Максимальное кол-во прямоугольников области
+
+	private:
+		std::vector<RECT> rects_;                               // Прямоугольники (не вложены друг в друга)
+		RECT bounds_;                                           // Ограничивающий прямоугольник
+		unsigned int merged_;                                   // Кол-во поглощенных и слитых прямоугольников
+
+		/**
+		* \brief Слить прямоугольник с пересекающимися и соприкасающимися, если это выгодно
+		* \param rect Прямоугольник (расширяется при слиянии)
+		*/
+		void Absorb(RECT& rect);
+
+	public:
+		/**
+		* \brief Конструктор (пустая область)
+		*/
+		DirtyRegion();
+
+		/**
+		* \brief Добавить прямоугольник
+		* \param rect Прямоугольник (пустые игнорируются)
+		*/
+		void Add(const RECT& rect);
+
+		/**
+		* \brief Добавить все прямоугольники другой области
+		* \param region Область
+		*/
+		void Add(const DirtyRegion& region);
+
+		/**
+		* \brief Очистить область
+		*/
+		void Clear();
+
+		/**
+		* \brief Пуста ли область
+		* \return Состояние
+		*/
+		bool IsEmpty() const;
+
+		/**
+		* \brief Получить прямоугольники области
+		* \return Ссылка на массив прямоугольников
+		*/
+		const std::vector<RECT>& GetRects() const;
+
+		/**
+		* \brief Получить ограничивающий прямоугольник области
+		* \return Прямоугольник (нулевой, если область пуста)
+		*/
+		RECT GetBounds() const;
+
+		/**
+		* \brief Пересекается ли область с прямоугольником
+		* \param rect Прямоугольник
+		* \return Состояние
+		*/
+		bool Intersects(const RECT& rect) const;
+
+		/**
+		* \brief Кол-во прямоугольников, поглощенных или слитых с момента последней очистки
+		* \return Кол-во
+		*/
+		unsigned int GetMergedCount() const;
+	};
+}
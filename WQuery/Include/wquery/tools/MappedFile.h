@@ -0,0 +1,63 @@
+﻿/**
+* \brief Файл, отображенный в память (интерфейс)
+* \details Файл открывается только для чтения и отображается в адресное пространство процесса целиком. Страницы
+* подгружаются системой при первом обращении, повторное открытие того же файла берет их из файлового кеша
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	class MappedFile
+	{
+	private:
+		const unsigned char* data_;            // Начало отображения (nullptr, если файл не открыт)
+		size_t size_;                          // Размер файла
+
+	public:
+		/**
+		* \brief Конструктор (файл не открыт)
+		*/
+		MappedFile();
+
+		/**
+		* \brief Деструктор (отображение закрывается)
+		*/
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		* \brief Открыть файл и отобразить его в память (ранее открытый файл закрывается)
+		* \param path Путь к файлу (UTF-8)
+		* \return Удалось ли открыть (пустой файл не отображается)
+		*/
+		bool Open(const std::string& path);
+
+		/**
+		* \brief Закрыть отображение
+		*/
+		void Close();
+
+		/**
+		* \brief Открыт ли файл
+		* \return Состояние
+		*/
+		bool IsOpen() const;
+
+		/**
+		* \brief Получить содержимое файла
+		* \return Указатель на первый байт (выровнен по границе страницы, nullptr если файл не открыт)
+		*/
+		const unsigned char* GetData() const;
+
+		/**
+		* \brief Получить размер файла
+		* \return Размер в байтах
+		*/
+		size_t GetSize() const;
+	};
+}
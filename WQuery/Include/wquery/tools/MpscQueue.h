@@ -0,0 +1,102 @@
+﻿/**
+* \brief Интрузивная очередь со многими производителями и одним потребителем (интерфейс и реализация)
+* \details Очередь на односвязном списке (алгоритм Д. Вьюкова): добавление узла - один атомарный обмен указателя
+* головы, без блокировок и повторов. Извлекает узлы только поток-потребитель. Если производитель находится
+* между обменом головы и связыванием узла, извлечение может на мгновение увидеть очередь пустой - такой узел
+* будет извлечен при следующем извлечении. Узел должен иметь поле std::atomic<Node*> next и конструктор
+* по умолчанию (служебный узел хранится в самой очереди). Очередь узлами не владеет: не извлеченные узлы
+* освобождает владелец очереди
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	template <typename Node>
+	class MpscQueue
+	{
+	private:
+		alignas(64) std::atomic<Node*> head_;      // Последний добавленный узел (изменяется производителями)
+		alignas(64) Node* tail_;                   // Следующий извлекаемый узел (изменяется только потребителем)
+		Node stub_;                                // Служебный узел, которым очередь никогда не бывает пуста
+
+	public:
+		/**
+		* \brief Конструктор (пустая очередь)
+		*/
+		MpscQueue() : head_(&stub_), tail_(&stub_)
+		{
+			this->stub_.next.store(nullptr, std::memory_order_relaxed);
+		}
+
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue& operator=(const MpscQueue&) = delete;
+
+		/**
+		* \brief Добавить узел (из любого потока)
+		* \param node Узел
+		*/
+		void Push(Node* node)
+		{
+			node->next.store(nullptr, std::memory_order_relaxed);
+
+			// Обмен головы упорядочивает производителей, после чего предыдущий узел связывается с новым
+			Node* previous = this->head_.exchange(node, std::memory_order_acq_rel);
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		/**
+		* \brief Извлечь узел (только из потока-потребителя)
+		* \return Узел (nullptr если очередь пуста)
+		*/
+		Node* Pop()
+		{
+			Node* tail = this->tail_;
+			Node* next = tail->next.load(std::memory_order_acquire);
+
+			// Служебный узел пропускается
+			if (tail == &this->stub_)
+			{
+				if (!next) return nullptr;
+
+				this->tail_ = next;
+				tail = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+
+			if (next)
+			{
+				this->tail_ = next;
+				return tail;
+			}
+
+			// Узел последний, но производитель уже сменил голову и еще не связал свой узел
+			if (tail != this->head_.load(std::memory_order_acquire)) {
+				return nullptr;
+			}
+
+			// Извлекается последний узел: на его место ставится служебный
+			this->Push(&this->stub_);
+			next = tail->next.load(std::memory_order_acquire);
+
+			if (next)
+			{
+				this->tail_ = next;
+				return tail;
+			}
+
+			return nullptr;
+		}
+
+		/**
+		* \brief Пуста ли очередь (только из потока-потребителя)
+		* \return Состояние
+		*/
+		bool IsEmpty() const
+		{
+			return this->tail_ == &this->stub_ && !this->stub_.next.load(std::memory_order_acquire);
+		}
+	};
+}
@@ -0,0 +1,218 @@
+﻿/**
+* \brief Таблица фрагментов - текстовая модель для больших документов (интерфейс)
+* \details Текст не хранится одной строкой: исходный текст и все вставки лежат в двух буферах, которые только
+* дополняются, а документ - упорядоченная последовательность фрагментов этих буферов. Фрагменты хранятся в
+* декартовом дереве (treap) с неявным ключом, узлы которого содержат суммарные длину и кол-во переводов строк
+* поддерева, поэтому вставка, удаление и поиск по смещению или номеру строки выполняются за O(log n) от кол-ва
+* фрагментов. Положения переводов строк индексируются для каждого буфера (исходный - при загрузке, буфер
+* вставок - по мере вставки), так что правка сканирует только вставленный текст.
+* Текст - в UTF-8, смещения - в байтах, строки разделяются '\n' (завершающий '\r' отбрасывается при чтении строки)
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	class PieceTable
+	{
+	private:
+		/**
+		* \brief Буфер фрагмента
+		*/
+		enum PieceBuffer : unsigned char
+		{
+			PIECE_BUFFER_ORIGINAL,             // Исходный текст
+			PIECE_BUFFER_ADDED,                // Вставки
+			PIECE_BUFFER_COUNT
+		};
+
+		/**
+		* \brief Узел дерева (фрагмент и суммы по поддереву)
+		*/
+		struct Node
+		{
+			unsigned int left;                 // Левый потомок (0 - нет)
+			unsigned int right;                // Правый потомок (0 - нет)
+			unsigned int priority;             // Приоритет (корень поддерева - с наибольшим)
+			unsigned char buffer;              // Буфер фрагмента (PieceBuffer)
+			size_t start;                      // Начало фрагмента в буфере
+			size_t length;                     // Длина фрагмента
+			size_t lineBreaks;                 // Кол-во переводов строк во фрагменте
+			size_t totalLength;                // Длина поддерева
+			size_t totalLineBreaks;            // Кол-во переводов строк поддерева
+		};
+
+		std::string buffers_[PIECE_BUFFER_COUNT];                  // Буферы (только дополняются)
+		std::vector<size_t> lineBreaks_[PIECE_BUFFER_COUNT];       // Положения '\n' в буферах (по возрастанию)
+		std::vector<Node> nodes_;                                  // Узлы (nodes_[0] - пустой узел с нулевыми суммами)
+		std::vector<unsigned int> freeNodes_;                      // Освобожденные узлы
+		unsigned int root_;                                        // Корень дерева (0 - документ пуст)
+		unsigned int seed_;                                        // Состояние генератора приоритетов
+
+		/**
+		* \brief Дописать положения переводов строк в индекс буфера
+		* \param buffer Буфер
+		* \param from Начало просматриваемого участка буфера
+		*/
+		void IndexLineBreaks(unsigned char buffer, size_t from);
+
+		/**
+		* \brief Посчитать переводы строк в участке буфера (по индексу)
+		* \param buffer Буфер
+		* \param start Начало участка
+		* \param length Длина участка
+		* \return Кол-во переводов строк
+		*/
+		size_t CountLineBreaks(unsigned char buffer, size_t start, size_t length) const;
+
+		/**
+		* \brief Создать узел фрагмента
+		* \param buffer Буфер
+		* \param start Начало фрагмента
+		* \param length Длина фрагмента
+		* \return Индекс узла
+		*/
+		unsigned int CreateNode(unsigned char buffer, size_t start, size_t length);
+
+		/**
+		* \brief Освободить узлы поддерева
+		* \param node Корень поддерева
+		*/
+		void FreeTree(unsigned int node);
+
+		/**
+		* \brief Пересчитать суммы узла по потомкам
+		* \param node Узел
+		*/
+		void Update(unsigned int node);
+
+		/**
+		* \brief Разделить поддерево по смещению (фрагмент на границе делится на два)
+		* \param node Корень поддерева
+		* \param position Смещение
+		* \param left Поддерево с текстом до смещения
+		* \param right Поддерево с текстом после смещения
+		*/
+		void Split(unsigned int node, size_t position, unsigned int& left, unsigned int& right);
+
+		/**
+		* \brief Объединить поддеревья (весь текст left раньше текста right)
+		* \param left Левое поддерево
+		* \param right Правое поддерево
+		* \return Корень объединения
+		*/
+		unsigned int Merge(unsigned int left, unsigned int right);
+
+		/**
+		* \brief Дописать текст поддерева в строку
+		* \param node Корень поддерева
+		* \param offset Смещение поддерева в документе
+		* \param from Начало участка
+		* \param to Конец участка
+		* \param text Строка
+		*/
+		void Collect(unsigned int node, size_t offset, size_t from, size_t to, std::string& text) const;
+
+	public:
+		/**
+		* \brief Конструктор (пустой документ)
+		*/
+		PieceTable();
+
+		/**
+		* \brief Конструктор
+		* \param text Исходный текст (копируется)
+		*/
+		explicit PieceTable(std::string_view text);
+
+		/**
+		* \brief Заменить весь текст (исходный текст копируется)
+		* \param text Текст
+		*/
+		void Assign(std::string_view text);
+
+		/**
+		* \brief Заменить весь текст без копирования
+		* \param text Текст (строка перемещается в документ)
+		*/
+		void Assign(std::string&& text);
+
+		/**
+		* \brief Вставить текст (O(log n) + длина вставки)
+		* \details Вставка сразу за предыдущей вставкой (набор текста, дописывание в конец) продлевает ее фрагмент
+		* \param position Смещение (больше длины - в конец)
+		* \param text Текст
+		*/
+		void Insert(size_t position, std::string_view text);
+
+		/**
+		* \brief Удалить участок текста (O(log n) + кол-во удаленных фрагментов)
+		* \param position Смещение
+		* \param length Длина (ограничивается концом документа)
+		*/
+		void Erase(size_t position, size_t length);
+
+		/**
+		* \brief Получить длину текста
+		* \return Длина (в байтах)
+		*/
+		size_t GetLength() const;
+
+		/**
+		* \brief Получить кол-во строк (на одну больше кол-ва переводов строк)
+		* \return Кол-во строк
+		*/
+		size_t GetLineCount() const;
+
+		/**
+		* \brief Получить смещение начала строки
+		* \param line Номер строки (больше последней - длина текста)
+		* \return Смещение
+		*/
+		size_t GetLineStart(size_t line) const;
+
+		/**
+		* \brief Получить номер строки, содержащей смещение
+		* \param position Смещение
+		* \return Номер строки
+		*/
+		size_t GetLineAt(size_t position) const;
+
+		/**
+		* \brief Получить участок текста
+		* \param position Смещение
+		* \param length Длина (ограничивается концом документа)
+		* \param text Строка для записи (память переиспользуется)
+		*/
+		void GetText(size_t position, size_t length, std::string& text) const;
+
+		/**
+		* \brief Получить весь текст
+		* \param text Строка для записи
+		*/
+		void GetText(std::string& text) const;
+
+		/**
+		* \brief Получить строку (без перевода строки)
+		* \param line Номер строки
+		* \param text Строка для записи
+		* \param maxLength Наибольшая длина (длинные строки обрезаются - для вывода достаточно видимой части)
+		*/
+		void GetLine(size_t line, std::string& text, size_t maxLength = static_cast<size_t>(-1)) const;
+
+		/**
+		* \brief Получить символ по смещению
+		* \param position Смещение (меньше длины текста)
+		* \return Символ (байт UTF-8)
+		*/
+		char GetChar(size_t position) const;
+
+		/**
+		* \brief Получить кол-во фрагментов
+		* \return Кол-во фрагментов
+		*/
+		size_t GetPieceCount() const;
+	};
+}
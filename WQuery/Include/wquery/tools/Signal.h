@@ -0,0 +1,317 @@
+﻿/**
+* \brief Сигнал - событие с несколькими подписчиками (интерфейс и реализация)
+* \details Подписчики хранятся делегатами (\see wquery::Delegate) в ячейках общего массива. Подписка
+* возвращает идентификатор (номер ячейки и ее поколение), по которому подписка отменяется за O(1), а
+* освобожденная ячейка переиспользуется следующей подпиской. Пустой сигнал - один указатель, массив ячеек
+* выделяется при первой подписке. Вызов сигнала память не выделяет. Подписка и отписка допускаются в том
+* числе из обработчиков самого сигнала: новые подписчики вызываются начиная со следующего вызова сигнала,
+* отписанные - больше не вызываются (а их обработчики уничтожаются по завершении вызова, поэтому обработчик
+* может отписать сам себя). Обработчик может уничтожить и сам сигнал (например, удалив элемент управления,
+* которому сигнал принадлежит): массив ячеек тогда доживает до конца вызова, а оставшиеся подписчики
+* не вызываются. Сигнал не потокобезопасен и используется из потока основного цикла
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "Delegate.h"
+
+namespace wquery
+{
+	/**
+	* \brief Идентификатор подписки на сигнал (0 - недействительный идентификатор)
+	*/
+	typedef unsigned long long ConnectionId;
+
+	template <typename Signature>
+	class Signal;
+
+	/**
+	* \brief Сигнал
+	* \tparam R Тип результата обработчиков
+	* \tparam Args Типы аргументов
+	*/
+	template <typename R, typename... Args>
+	class Signal<R(Args...)>
+	{
+	public:
+		typedef Delegate<R(Args...)> Handler;
+
+	private:
+		static constexpr unsigned int NONE = 0xFFFFFFFF;      // Пустая ссылка в списке свободных ячеек
+
+		/**
+		* \brief Ячейка подписчика
+		*/
+		struct Slot
+		{
+			Handler handler;                   // Обработчик (пуст, если ячейка свободна)
+			unsigned int generation;           // Поколение (увеличивается при каждой отписке)
+			unsigned int next;                 // Следующая свободная ячейка
+			bool connected;                    // Подписка действительна
+		};
+
+		/**
+		* \brief Подписчики (выделяются при первой подписке)
+		*/
+		struct Table
+		{
+			std::vector<Slot> slots;           // Ячейки
+			std::vector<Slot> pending;         // Ячейки, добавленные во время вызова сигнала
+			std::vector<unsigned int> released; // Ячейки, отписанные во время вызова сигнала
+			unsigned int freeList = NONE;      // Первая свободная ячейка
+			unsigned int count = 0;            // Кол-во подписчиков
+			unsigned int emitting = 0;         // Глубина вложенности вызовов сигнала
+			bool destroyed = false;            // Сигнал уничтожен во время вызова (массив удаляет вызов)
+		};
+
+		std::unique_ptr<Table> table_;
+
+		/**
+		* \brief Получить ячейку по номеру (в том числе добавленную во время вызова)
+		* \param index Номер ячейки
+		* \return Указатель на ячейку (nullptr если ячейки нет)
+		*/
+		Slot* GetSlot(unsigned int index) const
+		{
+			if (index < this->table_->slots.size()) return &this->table_->slots[index];
+
+			index -= static_cast<unsigned int>(this->table_->slots.size());
+			return index < this->table_->pending.size() ? &this->table_->pending[index] : nullptr;
+		}
+
+		/**
+		* \brief Освободить ячейку (уничтожить обработчик и вернуть ячейку в список свободных)
+		* \param table Подписчики
+		* \param index Номер ячейки основного массива
+		*/
+		static void Release(Table& table, unsigned int index)
+		{
+			Slot& slot = table.slots[index];
+			slot.handler.Reset();
+			slot.next = table.freeList;
+			table.freeList = index;
+		}
+
+		/**
+		* \brief Завершить вызов: перенести добавленные ячейки в основной массив, освободить отписанные
+		* \param table Подписчики
+		*/
+		static void FinishEmit(Table& table)
+		{
+			for (Slot& slot : table.pending) table.slots.push_back(std::move(slot));
+			table.pending.clear();
+
+			for (unsigned int index : table.released) Release(table, index);
+			table.released.clear();
+		}
+
+		/**
+		* \brief Отдать массив подписчиков вызову, который сейчас идет (сигнал уничтожается или заменяется)
+		* \details Выполняемый обработчик хранится в массиве, поэтому массив удаляется по завершении вызова
+		*/
+		void DetachTable()
+		{
+			if (!this->table_ || this->table_->emitting == 0) return;
+
+			this->table_->destroyed = true;
+			this->table_.release();
+		}
+
+		/**
+		* \brief Счетчик вложенности вызовов (ячейки не перемещаются, пока идет вызов)
+		* \details Хранит массив, а не сигнал: сигнал может быть уничтожен или перемещен обработчиком
+		*/
+		struct EmitGuard
+		{
+			Table& table;
+
+			explicit EmitGuard(Table& t) : table(t) { table.emitting++; }
+
+			~EmitGuard()
+			{
+				if (--table.emitting > 0) return;
+
+				if (table.destroyed) delete &table;
+				else FinishEmit(table);
+			}
+		};
+
+	public:
+		Signal() = default;
+		Signal(Signal&&) noexcept = default;
+		Signal(const Signal&) = delete;
+		Signal& operator=(const Signal&) = delete;
+
+		/**
+		* \brief Перемещающее присваивание (если заменяемые подписчики вызываются - массив удалит вызов)
+		*/
+		Signal& operator=(Signal&& other) noexcept
+		{
+			if (this != &other)
+			{
+				this->DetachTable();
+				this->table_ = std::move(other.table_);
+			}
+			return *this;
+		}
+
+		/**
+		* \brief Деструктор (если сигнал уничтожается своим обработчиком - массив удалит вызов)
+		*/
+		~Signal()
+		{
+			this->DetachTable();
+		}
+
+		/**
+		* \brief Подписаться на сигнал
+		* \param handler Обработчик (лямбда, указатель на функцию или делегат)
+		* \return Идентификатор подписки
+		*/
+		ConnectionId Connect(Handler handler)
+		{
+			if (!handler) return 0;
+			if (!this->table_) this->table_.reset(new Table());
+
+			Table& table = *this->table_;
+			unsigned int index;
+
+			// Пока идет вызов сигнала, ячейки основного массива не должны перемещаться,
+			// поэтому новая ячейка добавляется в отдельный массив
+			if (table.emitting > 0)
+			{
+				index = static_cast<unsigned int>(table.slots.size() + table.pending.size());
+				table.pending.push_back({ std::move(handler), 0, NONE, true });
+			}
+			else if (table.freeList != NONE)
+			{
+				index = table.freeList;
+				table.freeList = table.slots[index].next;
+				table.slots[index].handler = std::move(handler);
+				table.slots[index].next = NONE;
+				table.slots[index].connected = true;
+			}
+			else
+			{
+				index = static_cast<unsigned int>(table.slots.size());
+				table.slots.push_back({ std::move(handler), 0, NONE, true });
+			}
+
+			table.count++;
+			return (static_cast<ConnectionId>(this->GetSlot(index)->generation) << 32) | (static_cast<ConnectionId>(index) + 1);
+		}
+
+		/**
+		* \brief Отменить подписку
+		* \param id Идентификатор подписки
+		* \return Была ли подписка действительна
+		*/
+		bool Disconnect(ConnectionId id)
+		{
+			if (!this->table_ || id == 0) return false;
+
+			const unsigned int index = static_cast<unsigned int>(id & 0xFFFFFFFF) - 1;
+			const unsigned int generation = static_cast<unsigned int>(id >> 32);
+
+			Slot* slot = this->GetSlot(index);
+			if (!slot || !slot->connected || slot->generation != generation) return false;
+
+			slot->connected = false;
+			slot->generation++;
+			this->table_->count--;
+
+			// Во время вызова обработчик может выполняться прямо сейчас, поэтому он уничтожается по завершении вызова
+			if (this->table_->emitting > 0) this->table_->released.push_back(index);
+			else Release(*this->table_, index);
+
+			return true;
+		}
+
+		/**
+		* \brief Отменить все подписки
+		*/
+		void DisconnectAll()
+		{
+			if (!this->table_) return;
+
+			// Ячейки (и их поколения) сохраняются, чтобы старые идентификаторы не совпали с новыми подписками
+			const unsigned int total = static_cast<unsigned int>(this->table_->slots.size() + this->table_->pending.size());
+			for (unsigned int i = 0; i < total; i++)
+			{
+				Slot* slot = this->GetSlot(i);
+				if (!slot->connected) continue;
+
+				slot->connected = false;
+				slot->generation++;
+
+				if (this->table_->emitting > 0) this->table_->released.push_back(i);
+				else Release(*this->table_, i);
+			}
+
+			this->table_->count = 0;
+		}
+
+		/**
+		* \brief Кол-во подписчиков
+		* \return Кол-во
+		*/
+		size_t GetCount() const
+		{
+			return this->table_ ? this->table_->count : 0;
+		}
+
+		/**
+		* \brief Есть ли подписчики
+		*/
+		explicit operator bool() const
+		{
+			return this->GetCount() > 0;
+		}
+
+		/**
+		* \brief Вызвать всех подписчиков (в порядке подписки, результаты обработчиков отбрасываются)
+		* \param args Аргументы
+		*/
+		void operator()(Args... args)
+		{
+			if (!this->table_ || this->table_->count == 0) return;
+
+			Table& table = *this->table_;
+			EmitGuard guard(table);
+			const size_t total = table.slots.size();
+
+			// После уничтожения сигнала обращаться можно только к массиву (this уже недействителен)
+			for (size_t i = 0; i < total && !table.destroyed; i++)
+			{
+				const Slot& slot = table.slots[i];
+				if (slot.connected) slot.handler(args...);
+			}
+		}
+
+		/**
+		* \brief Вызвать всех подписчиков, возвращающих bool
+		* \details Вызываются все подписчики, даже если кто-то из них уже вернул false
+		* \param args Аргументы
+		* \return Вернули ли все подписчики true (true если подписчиков нет)
+		*/
+		bool All(Args... args)
+		{
+			static_assert(std::is_same_v<R, bool>, "WQuery: Signal::All requires bool handlers");
+			if (!this->table_ || this->table_->count == 0) return true;
+
+			Table& table = *this->table_;
+			EmitGuard guard(table);
+			const size_t total = table.slots.size();
+			bool result = true;
+
+			for (size_t i = 0; i < total && !table.destroyed; i++)
+			{
+				const Slot& slot = table.slots[i];
+				if (slot.connected && !slot.handler(args...)) result = false;
+			}
+
+			return result;
+		}
+	};
+}
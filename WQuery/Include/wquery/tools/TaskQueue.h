@@ -0,0 +1,63 @@
+﻿/**
+* \brief Очередь задач для передачи работы в поток основного цикла (интерфейс)
+* \details Задачи хранятся в очереди со многими производителями и одним потребителем (\see wquery::MpscQueue):
+* добавление задачи - один атомарный обмен указателя головы, без блокировок и повторов. Извлекает задачи
+* только поток основного цикла, пакетами
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+#include "MpscQueue.h"
+
+namespace wquery
+{
+	class TaskQueue
+	{
+	private:
+		/**
+		* \brief Узел очереди
+		*/
+		struct Node
+		{
+			std::atomic<Node*> next;               // Следующий (более поздний) узел
+			std::function<void()> task;            // Задача
+		};
+
+		MpscQueue<Node> queue_;                    // Очередь узлов
+
+	public:
+		/**
+		* \brief Конструктор
+		*/
+		TaskQueue();
+
+		/**
+		* \brief Деструктор (не выполненные задачи уничтожаются без вызова)
+		*/
+		~TaskQueue();
+
+		TaskQueue(const TaskQueue&) = delete;
+		TaskQueue& operator=(const TaskQueue&) = delete;
+
+		/**
+		* \brief Добавить задачу (из любого потока)
+		* \param task Задача
+		*/
+		void Push(std::function<void()> task);
+
+		/**
+		* \brief Извлечь и выполнить задачи (только из потока-потребителя)
+		* \details Исключение задачи пробрасывается, оставшиеся задачи выполняются при следующем вызове
+		* \param maxTasks Максимальное кол-во задач за вызов
+		* \return Кол-во выполненных задач
+		*/
+		size_t Drain(size_t maxTasks);
+
+		/**
+		* \brief Пуста ли очередь (только из потока-потребителя)
+		* \return Состояние
+		*/
+		bool IsEmpty() const;
+	};
+}
@@ -0,0 +1,185 @@
+﻿/**
+* \brief Иерархическое колесо таймеров (интерфейс)
+* \details Таймеры раскладываются по уровням колеса из 64 ячеек: на нулевом уровне ячейка соответствует одной
+* миллисекунде, на каждом следующем - в 64 раза большему интервалу. Добавление и отмена таймера выполняются
+* за O(1) (ячейка - двусвязный список в общем пуле таймеров), при переходе через границу интервала уровня
+* таймеры его текущей ячейки переносятся на нижние уровни. Для каждого уровня хранится битовая маска
+* занятых ячеек, поэтому пустые участки времени пропускаются без перебора ячеек. Колесо не потокобезопасно
+* и используется из потока основного цикла (\see wquery::End)
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	/**
+	* \brief Идентификатор таймера (0 - недействительный идентификатор)
+	*/
+	typedef unsigned long long TimerId;
+
+	class TimerWheel
+	{
+	public:
+		static constexpr unsigned int LEVEL_BITS = 6;                      // Разрядность индекса ячейки
+		static constexpr unsigned int SLOTS = 1u << LEVEL_BITS;            // Кол-во ячеек уровня
+		static constexpr unsigned int LEVELS = 6;                          // Кол-во уровней
+		static constexpr unsigned long long MAX_DELAY =                    // Максимальная задержка (мс, около двух лет)
+			(1ull << (LEVEL_BITS * LEVELS)) - 1;
+
+	private:
+		static constexpr unsigned int NONE = 0xFFFFFFFF;                   // Пустая ссылка в списке
+
+		/**
+		* \brief Таймер в пуле
+		*/
+		struct Timer
+		{
+			unsigned long long expiry;             // Время срабатывания (мс)
+			unsigned long long interval;           // Период повторения (0 - однократный таймер)
+			std::function<void()> callback;        // Функция обратного вызова
+			const void* owner;                     // Владелец (для отмены всех таймеров владельца)
+			unsigned int prev;                     // Предыдущий таймер в ячейке
+			unsigned int next;                     // Следующий таймер в ячейке (или в списке свободных)
+			unsigned int generation;               // Поколение (увеличивается при каждом освобождении)
+			unsigned short cell;                   // Ячейка колеса (уровень * SLOTS + индекс)
+			bool active;                           // Таймер запущен
+		};
+
+		std::vector<Timer> timers_;                // Пул таймеров
+		unsigned int freeList_;                    // Первый свободный таймер пула
+		unsigned int count_;                       // Кол-во запущенных таймеров
+		unsigned int heads_[LEVELS * SLOTS];       // Первые таймеры ячеек
+		unsigned long long occupied_[LEVELS];      // Маски занятых ячеек уровней
+		unsigned long long now_;                   // Текущее время колеса (мс)
+		unsigned long long target_;                // Время, до которого продвигается колесо (мс)
+		std::vector<TimerId> due_;                 // Буфер таймеров, срабатывающих на текущем шаге
+		bool advancing_;                           // Идет обработка сработавших таймеров
+
+		/**
+		* \brief Получить идентификатор таймера пула
+		* \param index Индекс в пуле
+		* \return Идентификатор
+		*/
+		TimerId MakeId(unsigned int index) const;
+
+		/**
+		* \brief Найти запущенный таймер по идентификатору
+		* \param id Идентификатор
+		* \return Индекс в пуле (NONE если таймер не запущен)
+		*/
+		unsigned int Find(TimerId id) const;
+
+		/**
+		* \brief Поместить таймер в ячейку колеса, соответствующую времени его срабатывания
+		* \param index Индекс в пуле
+		*/
+		void Link(unsigned int index);
+
+		/**
+		* \brief Убрать таймер из ячейки колеса
+		* \param index Индекс в пуле
+		*/
+		void Unlink(unsigned int index);
+
+		/**
+		* \brief Освободить таймер (вернуть в список свободных)
+		* \param index Индекс в пуле
+		*/
+		void Release(unsigned int index);
+
+		/**
+		* \brief Перенести таймеры ячейки на нижние уровни
+		* \param cell Ячейка
+		*/
+		void Cascade(unsigned int cell);
+
+		/**
+		* \brief Вызвать таймеры, время которых наступило (таймеры текущей ячейки нулевого уровня)
+		* \details Исключение функции таймера пробрасывается, не вызванные таймеры ячейки остаются запущенными
+		* \return Кол-во вызванных таймеров
+		*/
+		size_t Fire();
+
+	public:
+		/**
+		* \brief Конструктор
+		* \param now Начальное время колеса (мс)
+		*/
+		explicit TimerWheel(unsigned long long now = 0);
+
+		/**
+		* \brief Запустить таймер
+		* \param expiry Время срабатывания (мс, если оно уже наступило - таймер сработает при следующем Advance)
+		* \param interval Период повторения (мс, 0 - однократный таймер)
+		* \param callback Функция обратного вызова
+		* \param owner Владелец (не обязательно, \see TimerWheel::CancelAll)
+		* \return Идентификатор таймера
+		*/
+		TimerId Schedule(unsigned long long expiry, unsigned long long interval, std::function<void()> callback, const void* owner = nullptr);
+
+		/**
+		* \brief Остановить таймер
+		* \details Может вызываться в том числе из функции обратного вызова таймера
+		* \param id Идентификатор
+		* \return Был ли таймер запущен
+		*/
+		bool Cancel(TimerId id);
+
+		/**
+		* \brief Остановить все таймеры владельца
+		* \param owner Владелец
+		* \return Кол-во остановленных таймеров
+		*/
+		size_t CancelAll(const void* owner);
+
+		/**
+		* \brief Запущен ли таймер
+		* \param id Идентификатор
+		* \return Состояние
+		*/
+		bool IsActive(TimerId id) const;
+
+		/**
+		* \brief Кол-во запущенных таймеров
+		* \return Кол-во
+		*/
+		size_t GetCount() const;
+
+		/**
+		* \brief Текущее время колеса
+		* \return Время (мс)
+		*/
+		unsigned long long GetTime() const;
+
+		/**
+		* \brief Получить время срабатывания ближайшего таймера
+		* \param deadline Время срабатывания (мс)
+		* \return Есть ли запущенные таймеры
+		*/
+		bool GetNextDeadline(unsigned long long& deadline) const;
+
+		/**
+		* \brief Продвинуть время колеса, вызывая сработавшие таймеры
+		* \details Периодические таймеры, пропустившие несколько периодов, срабатывают один раз.
+		* Исключение функции таймера прерывает продвижение, но колесо остается пригодным: оставшиеся
+		* таймеры сработают при следующем вызове
+		* \param now Новое время (мс)
+		* \return Кол-во вызванных таймеров
+		*/
+		size_t Advance(unsigned long long now);
+	};
+
+	/**
+	* \brief Получить текущее время для таймеров (монотонное, в миллисекундах)
+	* \return Время
+	*/
+	unsigned long long GetTimerClock();
+
+	/**
+	* \brief Получить общее колесо таймеров основного цикла
+	* \return Ссылка на колесо
+	*/
+	TimerWheel& GetTimerWheel();
+}
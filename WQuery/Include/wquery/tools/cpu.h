@@ -0,0 +1,28 @@
+﻿/**
+* \brief Определение возможностей процессора (интерфейс)
+* \details Используется для выбора реализаций функций на векторных инструкциях (\see wquery::SetUtfKernel,
+* wquery::SetRasterKernel). Не зависит от платформы (на процессорах, отличных от x86, расширения не поддерживаются)
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	/**
+	* \brief Расширение набора инструкций
+	*/
+	enum CpuFeature
+	{
+		CPU_FEATURE_SSE2,
+		CPU_FEATURE_AVX2
+	};
+
+	/**
+	* \brief Поддерживается ли расширение процессором и системой (результат определяется однократно)
+	* \param feature Расширение
+	* \return Состояние
+	*/
+	bool HasCpuFeature(CpuFeature feature);
+}
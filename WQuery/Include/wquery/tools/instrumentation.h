@@ -0,0 +1,260 @@
+﻿/**
+* \brief Инструментирование обработки сообщений (интерфейс)
+* \details Считает обработанные сообщения и время их обработки оконной процедурой (по типу сообщения),
+* время вызова обработчиков событий и этапов основного цикла, а также задержку ввода - время от постановки
+* сообщения клавиатуры или мыши в очередь (время сообщения) до начала его обработки. Время копится
+* в гистограммах с логарифмически-линейными интервалами (как в HDR Histogram: 16 интервалов на каждую
+* степень двойки, погрешность не больше 1/16), запись - несколько атомарных операций без блокировок,
+* поэтому снимок можно получать из любого потока.
+* Инструментирование включается определением WQUERY_INSTRUMENTATION (одинаково для библиотеки и программы),
+* без него точки замера (макросы WQUERY_INSTRUMENT_*) не порождают никакого кода
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	/**
+	* \brief Участок, время выполнения которого замеряется (обработчики событий и этапы основного цикла)
+	* \details Время участка включает вложенные участки (напр. отложенная перерисовка включает событие onPaint)
+	*/
+	enum InstrumentedSection
+	{
+		INSTRUMENTED_EVENT_RESIZED,            // Событие onResized
+		INSTRUMENTED_EVENT_KEY_DOWN,           // Событие onKeyDown
+		INSTRUMENTED_EVENT_KEY_UP,             // Событие onKeyUp
+		INSTRUMENTED_EVENT_TYPING,             // Событие onTyping
+		INSTRUMENTED_EVENT_MOUSE_DOWN,         // Событие onMouseKeyDown
+		INSTRUMENTED_EVENT_MOUSE_UP,           // Событие onMouseKeyUp
+		INSTRUMENTED_EVENT_MOUSE_MOVE,         // События onMouseMove и onMouseMoveBatch
+		INSTRUMENTED_EVENT_PAINT,              // Событие onPaint (вместе с элементами без системного окна)
+		INSTRUMENTED_EVENT_NOTIFICATION,       // Обработчик уведомления элемента управления
+		INSTRUMENTED_LOOP_POSTED_TASKS,        // Выполнение переданных в поток цикла задач
+		INSTRUMENTED_LOOP_TIMERS,              // Вызов сработавших таймеров
+		INSTRUMENTED_LOOP_COROUTINES,          // Продолжение ожидающих сопрограмм
+		INSTRUMENTED_LOOP_PAINT,               // Отложенная перерисовка окон
+		INSTRUMENTED_LOOP_CALLBACK,            // Функция итерации (кадра) основного цикла
+		INSTRUMENTED_SECTION_COUNT
+	};
+
+	/**
+	* \brief Сводка гистограммы (время - в микросекундах)
+	*/
+	struct LatencySummary
+	{
+		unsigned long long count;              // Кол-во замеров
+		double total;                          // Суммарное время
+		double mean;                           // Среднее время
+		double max;                            // Наибольшее время
+		double p50;                            // Медиана
+		double p90;                            // 90-й процентиль
+		double p99;                            // 99-й процентиль
+		double p999;                           // 99.9-й процентиль
+	};
+
+	/**
+	* \brief Статистика сообщения
+	*/
+	struct MessageStatistics
+	{
+		UINT message;                          // Сообщение (WM_USER - все сообщения начиная с WM_USER)
+		LatencySummary dispatch;               // Время обработки оконной процедурой
+		LatencySummary inputLatency;           // Задержка ввода (только сообщения клавиатуры и мыши)
+	};
+
+	/**
+	* \brief Снимок статистики инструментирования
+	*/
+	struct InstrumentationSnapshot
+	{
+		std::vector<MessageStatistics> messages;                // Обработанные сообщения (по возрастанию кода)
+		LatencySummary sections[INSTRUMENTED_SECTION_COUNT];    // Участки
+		LatencySummary inputLatency;                            // Задержка ввода по всем сообщениям
+	};
+
+	class LatencyHistogram
+	{
+	public:
+		/**
+		* \brief Кол-во бит точности (интервалов на степень двойки - 2^SUB_BUCKET_BITS)
+		*/
+		static constexpr unsigned int SUB_BUCKET_BITS = 4;
+
+		/**
+		* \brief Кол-во бит наибольшего значения (большие значения записываются как наибольшее, ~18 минут в нс)
+		*/
+		static constexpr unsigned int VALUE_BITS = 40;
+
+		/**
+		* \brief Кол-во интервалов
+		*/
+		static constexpr unsigned int BUCKET_COUNT = (VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+	private:
+		std::atomic<unsigned long long> buckets_[BUCKET_COUNT];    // Кол-во значений в интервалах (их сумма - кол-во значений)
+		std::atomic<unsigned long long> total_;                     // Сумма значений
+		std::atomic<unsigned long long> max_;                       // Наибольшее значение
+
+		/**
+		* \brief Получить интервал значения
+		* \param value Значение
+		* \return Индекс интервала
+		*/
+		static unsigned int GetBucket(unsigned long long value);
+
+		/**
+		* \brief Получить наибольшее значение интервала
+		* \param bucket Индекс интервала
+		* \return Значение
+		*/
+		static unsigned long long GetBucketLimit(unsigned int bucket);
+
+	public:
+		/**
+		* \brief Конструктор (пустая гистограмма)
+		*/
+		LatencyHistogram();
+
+		LatencyHistogram(const LatencyHistogram&) = delete;
+		LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+		/**
+		* \brief Записать значение (может вызываться из любого потока)
+		* \param nanoseconds Время (нс)
+		*/
+		void Record(unsigned long long nanoseconds);
+
+		/**
+		* \brief Получить сводку (при одновременной записи - приблизительную)
+		* \param summary Сводка (время в микросекундах)
+		*/
+		void Summarize(LatencySummary& summary) const;
+
+		/**
+		* \brief Добавить значения в массив кол-в по интервалам (для сводки по нескольким гистограммам)
+		* \param buckets Массив из BUCKET_COUNT кол-в
+		* \param summary Сводка, в которой накапливаются кол-во, сумма и наибольшее значение
+		*/
+		void Accumulate(unsigned long long* buckets, LatencySummary& summary) const;
+
+		/**
+		* \brief Вычислить процентили сводки по массиву кол-в по интервалам
+		* \param buckets Массив из BUCKET_COUNT кол-в
+		* \param summary Сводка (кол-во, сумма и наибольшее значение уже заполнены)
+		*/
+		static void SummarizeBuckets(const unsigned long long* buckets, LatencySummary& summary);
+
+		/**
+		* \brief Очистить гистограмму
+		*/
+		void Reset();
+	};
+
+	class MessageTimer
+	{
+	private:
+		UINT message_;                                          // Сообщение
+		std::chrono::steady_clock::time_point start_;           // Начало обработки
+
+	public:
+		/**
+		* \brief Начать замер обработки сообщения
+		* \param message Сообщение
+		*/
+		explicit MessageTimer(UINT message) : message_(message), start_(std::chrono::steady_clock::now()) {}
+
+		/**
+		* \brief Завершить замер (время записывается в гистограмму сообщения)
+		*/
+		~MessageTimer();
+
+		MessageTimer(const MessageTimer&) = delete;
+		MessageTimer& operator=(const MessageTimer&) = delete;
+	};
+
+	class SectionTimer
+	{
+	private:
+		InstrumentedSection section_;                           // Участок
+		std::chrono::steady_clock::time_point start_;           // Начало участка
+
+	public:
+		/**
+		* \brief Начать замер участка
+		* \param section Участок
+		*/
+		explicit SectionTimer(InstrumentedSection section) : section_(section), start_(std::chrono::steady_clock::now()) {}
+
+		/**
+		* \brief Завершить замер (время записывается в гистограмму участка)
+		*/
+		~SectionTimer();
+
+		SectionTimer(const SectionTimer&) = delete;
+		SectionTimer& operator=(const SectionTimer&) = delete;
+	};
+
+	/**
+	* \brief Записать задержку ввода обрабатываемого сообщения (сообщения кроме клавиатуры и мыши пропускаются)
+	* \details Задержка - разница часов сообщений бэкенда и времени текущего сообщения (точность - миллисекунда).
+	* Сообщения, переданные из другого потока (\see Backend::IsCurrentMessageSent), пропускаются
+	* \param message Сообщение
+	*/
+	void RecordInputLatency(UINT message);
+
+	/**
+	* \brief Включено ли инструментирование (определен ли WQUERY_INSTRUMENTATION)
+	* \return Статус
+	*/
+	constexpr bool IsInstrumentationEnabled()
+	{
+#ifdef WQUERY_INSTRUMENTATION
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/**
+	* \brief Получить снимок статистики (может вызываться из любого потока)
+	* \param snapshot Снимок (память массива сообщений переиспользуется)
+	*/
+	void GetInstrumentationSnapshot(InstrumentationSnapshot& snapshot);
+
+	/**
+	* \brief Сбросить статистику
+	*/
+	void ResetInstrumentation();
+
+	/**
+	* \brief Получить наименование участка
+	* \param section Участок
+	* \return Наименование
+	*/
+	const char* GetInstrumentedSectionName(InstrumentedSection section);
+
+	/**
+	* \brief Получить наименование сообщения
+	* \param message Сообщение
+	* \return Наименование (nullptr - сообщение неизвестно)
+	*/
+	const char* GetInstrumentedMessageName(UINT message);
+}
+
+/**
+* \brief Точки замера (без WQUERY_INSTRUMENTATION - пустые выражения)
+* \details WQUERY_INSTRUMENT_MESSAGE и WQUERY_INSTRUMENT_SECTION замеряют время до конца текущего блока
+*/
+#ifdef WQUERY_INSTRUMENTATION
+#define WQUERY_INSTRUMENT_JOIN_(a, b) a##b
+#define WQUERY_INSTRUMENT_NAME_(line) WQUERY_INSTRUMENT_JOIN_(wqueryInstrumentation, line)
+#define WQUERY_INSTRUMENT_MESSAGE(message) ::wquery::MessageTimer WQUERY_INSTRUMENT_NAME_(__LINE__)(message)
+#define WQUERY_INSTRUMENT_SECTION(section) ::wquery::SectionTimer WQUERY_INSTRUMENT_NAME_(__LINE__)(::wquery::section)
+#define WQUERY_INSTRUMENT_INPUT(message) ::wquery::RecordInputLatency(message)
+#else
+#define WQUERY_INSTRUMENT_MESSAGE(message) static_cast<void>(0)
+#define WQUERY_INSTRUMENT_SECTION(section) static_cast<void>(0)
+#define WQUERY_INSTRUMENT_INPUT(message) static_cast<void>(0)
+#endif
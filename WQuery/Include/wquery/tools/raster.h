@@ -0,0 +1,101 @@
+﻿/**
+* \brief Растровые функции - внутренние циклы рисования на холсте (интерфейс)
+* \details Функции обрабатывают отрезок строки 32-битных пикселей (0xAARRGGBB): заливка, наложение с альфа-каналом
+* (source-over, источник в premultiplied-форме) и через маску покрытия, копирование с цветовым ключом и градиентная заливка. У каждой
+* функции есть скалярная (эталонная) реализация и реализации на векторных инструкциях (SSE2 или AVX2, выбор при
+* запуске), результаты всех реализаций совпадают побитово. Не зависит от платформы
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	/**
+	* \brief Набор инструкций растровых функций
+	*/
+	enum RasterKernel
+	{
+		RASTER_KERNEL_SCALAR,
+		RASTER_KERNEL_SSE2,
+		RASTER_KERNEL_AVX2
+	};
+
+	/**
+	* \brief Получить текущий набор инструкций
+	* \return Набор инструкций (по умолчанию - лучший из поддерживаемых процессором)
+	*/
+	RasterKernel GetRasterKernel();
+
+	/**
+	* \brief Выбрать набор инструкций (для замеров и сверки реализаций)
+	* \param kernel Набор инструкций
+	* \return Поддерживается ли он процессором (если нет - выбор не меняется)
+	*/
+	bool SetRasterKernel(RasterKernel kernel);
+
+	/**
+	* \brief Получить наименование набора инструкций
+	* \param kernel Набор инструкций
+	* \return Строка ("scalar", "sse2", "avx2")
+	*/
+	const char* GetRasterKernelName(RasterKernel kernel);
+
+	/**
+	* \brief Залить отрезок одним пикселем
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель
+	*/
+	void FillPixels(std::uint32_t* dst, size_t count, std::uint32_t pixel);
+
+	/**
+	* \brief Наложить пиксели источника на отрезок (source-over)
+	* \details dst = src + dst * (255 - src.alpha) / 255 для каждого канала (с округлением и насыщением)
+	* \param dst Пиксели
+	* \param src Пиксели источника (premultiplied: цветовые каналы уже умножены на альфа-канал)
+	* \param count Кол-во пикселей
+	*/
+	void BlendPixels(std::uint32_t* dst, const std::uint32_t* src, size_t count);
+
+	/**
+	* \brief Наложить один полупрозрачный пиксель на весь отрезок (source-over)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	*/
+	void BlendSolidPixels(std::uint32_t* dst, size_t count, std::uint32_t pixel);
+
+	/**
+	* \brief Наложить пиксель на отрезок через маску покрытия (рисование сглаженного текста)
+	* \details Каждый канал пикселя умножается на покрытие (с округлением), результат накладывается как в BlendPixels
+	* \param dst Пиксели
+	* \param mask Покрытие пикселей (0..255)
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	*/
+	void BlendMaskPixels(std::uint32_t* dst, const unsigned char* mask, size_t count, std::uint32_t pixel);
+
+	/**
+	* \brief Скопировать пиксели источника, кроме пикселей ключевого цвета (прозрачного фона спрайта)
+	* \param dst Пиксели
+	* \param src Пиксели источника
+	* \param count Кол-во пикселей
+	* \param key Ключевой цвет (сравниваются только цветовые каналы)
+	*/
+	void CopyPixelsKeyed(std::uint32_t* dst, const std::uint32_t* src, size_t count, std::uint32_t key);
+
+	/**
+	* \brief Залить отрезок линейным градиентом
+	* \details Отрезок - часть градиента длиной length, начинающаяся с его позиции offset (позволяет отсекать
+	* градиент без искажения). Позиция 0 получает цвет from, позиция length - 1 - цвет to
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param from Начальный пиксель
+	* \param to Конечный пиксель
+	* \param offset Позиция первого пикселя отрезка в градиенте
+	* \param length Длина всего градиента
+	*/
+	void GradientPixels(std::uint32_t* dst, size_t count, std::uint32_t from, std::uint32_t to, size_t offset, size_t length);
+}
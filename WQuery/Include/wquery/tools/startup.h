@@ -0,0 +1,96 @@
+﻿/**
+* \brief Замеры времени запуска (интерфейс)
+* \details Время запуска делится на этапы: Begin, конструирование окон и элементов (запись начального состояния)
+* и создание их системных объектов (откладывается до первого показа окна или первого обращения к хендлу).
+* Время этапа считается без вложенных этапов (напр. создание родительского окна при создании дочернего
+* не входит во время дочернего), поэтому сумма по этапам не превышает общего времени. Дополнительно
+* отмечаются первый показ и первая перерисовка окна. Используется из потока цикла
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	/**
+	* \brief Этап запуска
+	*/
+	enum StartupPhase
+	{
+		STARTUP_PHASE_BEGIN,                   // Begin (регистрация класса окон, настройка бэкенда)
+		STARTUP_PHASE_WINDOW_CONSTRUCTION,     // Конструкторы окон
+		STARTUP_PHASE_CONTROL_CONSTRUCTION,    // Конструкторы элементов управления
+		STARTUP_PHASE_WINDOW_CREATION,         // Создание системных окон
+		STARTUP_PHASE_CONTROL_CREATION,        // Создание системных элементов управления
+		STARTUP_PHASE_COUNT
+	};
+
+	/**
+	* \brief Событие запуска (отмечается однократно)
+	*/
+	enum StartupEvent
+	{
+		STARTUP_EVENT_FIRST_SHOW,              // Первый показ окна
+		STARTUP_EVENT_FIRST_PAINT,             // Завершение первой перерисовки окна
+		STARTUP_EVENT_COUNT
+	};
+
+	/**
+	* \brief Статистика запуска
+	*/
+	struct StartupStatistics
+	{
+		double phaseTime[STARTUP_PHASE_COUNT];          // Суммарное время этапа (мс, без вложенных этапов)
+		unsigned int phaseCount[STARTUP_PHASE_COUNT];   // Кол-во выполнений этапа
+		double eventTime[STARTUP_EVENT_COUNT];          // Время события от начала отсчета (мс, отрицательное - еще не было)
+	};
+
+	class StartupTimer
+	{
+	private:
+		StartupPhase phase_;                                   // Этап
+		StartupTimer* outer_;                                  // Объемлющий замер (приостановлен на время этого)
+		std::chrono::steady_clock::time_point start_;          // Начало (или продолжение) замера
+
+	public:
+		/**
+		* \brief Начать замер этапа (объемлющий замер приостанавливается)
+		* \param phase Этап
+		*/
+		explicit StartupTimer(StartupPhase phase);
+
+		/**
+		* \brief Завершить замер (объемлющий замер продолжается)
+		*/
+		~StartupTimer();
+
+		StartupTimer(const StartupTimer&) = delete;
+		StartupTimer& operator=(const StartupTimer&) = delete;
+	};
+
+	/**
+	* \brief Отметить событие запуска (повторные отметки игнорируются)
+	* \param event Событие
+	*/
+	void MarkStartupEvent(StartupEvent event);
+
+	/**
+	* \brief Получить статистику запуска
+	* \details Отсчет идет от первого замера (обычно - начала Begin)
+	* \return Статистика
+	*/
+	const StartupStatistics& GetStartupStatistics();
+
+	/**
+	* \brief Сбросить статистику запуска (отсчет начнется заново со следующего замера)
+	*/
+	void ResetStartupStatistics();
+
+	/**
+	* \brief Получить наименование этапа запуска
+	* \param phase Этап
+	* \return Наименование
+	*/
+	const char* GetStartupPhaseName(StartupPhase phase);
+}
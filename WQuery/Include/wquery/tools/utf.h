@@ -0,0 +1,110 @@
+﻿/**
+* \brief Перекодирование UTF-8 <-> UTF-16 (интерфейс)
+* \details Перекодирование с проверкой корректности входных данных (недопустимые, избыточные и
+* незавершенные последовательности, одиночные суррогаты считаются ошибкой). Участки ASCII-текста
+* обрабатываются векторными инструкциями (SSE2 или AVX2, выбор при запуске), остальное - скалярным кодом.
+* Результат записывается прямо в выходной буфер (строку) без промежуточных копий. Не зависит от платформы
+*/
+
+#pragma once
+
+#include "../stdafx.h"
+
+namespace wquery
+{
+	/**
+	* \brief Значение, возвращаемое функциями перекодирования при некорректных входных данных
+	*/
+	const size_t UTF_INVALID = static_cast<size_t>(-1);
+
+	/**
+	* \brief Набор инструкций, используемый для обработки ASCII-участков
+	*/
+	enum UtfKernel
+	{
+		UTF_KERNEL_SCALAR,
+		UTF_KERNEL_SSE2,
+		UTF_KERNEL_AVX2
+	};
+
+	/**
+	* \brief Получить текущий набор инструкций
+	* \return Набор инструкций (по умолчанию - лучший из поддерживаемых процессором)
+	*/
+	UtfKernel GetUtfKernel();
+
+	/**
+	* \brief Выбрать набор инструкций (для замеров и сверки реализаций)
+	* \param kernel Набор инструкций
+	* \return Поддерживается ли он процессором (если нет - выбор не меняется)
+	*/
+	bool SetUtfKernel(UtfKernel kernel);
+
+	/**
+	* \brief Получить наименование набора инструкций
+	* \param kernel Набор инструкций
+	* \return Строка ("scalar", "sse2", "avx2")
+	*/
+	const char* GetUtfKernelName(UtfKernel kernel);
+
+	/**
+	* \brief Перекодировать UTF-8 в UTF-16
+	* \param src Исходные данные
+	* \param length Длина в байтах
+	* \param dst Выходной буфер (не менее length элементов)
+	* \return Кол-во записанных элементов UTF-16 (UTF_INVALID если данные некорректны)
+	*/
+	size_t Utf8ToUtf16(const char* src, size_t length, char16_t* dst);
+
+	/**
+	* \brief Перекодировать UTF-16 в UTF-8
+	* \param src Исходные данные
+	* \param length Длина в элементах UTF-16
+	* \param dst Выходной буфер (не менее length * 3 байт)
+	* \return Кол-во записанных байт (UTF_INVALID если данные некорректны)
+	*/
+	size_t Utf16ToUtf8(const char16_t* src, size_t length, char* dst);
+
+	/**
+	* \brief Посчитать длину корректной UTF-8 строки в элементах UTF-16 (без перекодирования)
+	* \param src Исходные данные (должны быть корректны)
+	* \param length Длина в байтах
+	* \return Кол-во элементов UTF-16
+	*/
+	size_t Utf16LengthOfUtf8(const char* src, size_t length);
+
+	/**
+	* \brief Перекодировать UTF-8 строку в UTF-16 строку
+	* \param src Исходная строка
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool Utf8ToUtf16(std::string_view src, std::u16string& dst);
+
+	/**
+	* \brief Перекодировать UTF-16 строку в UTF-8 строку
+	* \param src Исходная строка
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool Utf16ToUtf8(std::u16string_view src, std::string& dst);
+
+	/**
+	* \brief Перекодировать UTF-8 в "широкую" строку
+	* \details На Windows wchar_t - элемент UTF-16, на остальных платформах - UTF-32
+	* \param src Исходные данные
+	* \param length Длина в байтах
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool Utf8ToWide(const char* src, size_t length, std::wstring& dst);
+
+	/**
+	* \brief Перекодировать "широкую" строку в UTF-8
+	* \param src Исходные данные
+	* \param length Длина в элементах wchar_t
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool WideToUtf8(const wchar_t* src, size_t length, std::string& dst);
+}
@@ -21,17 +21,28 @@ namespace wquery
 		unsigned char R;
 		unsigned char G;
 		unsigned char B;
+		unsigned char A;
 
 		/**
-		* \brief Конструктор цвета по умолчанию. По умолчанию инициализирует белый цвет
+		* \brief Конструктор цвета по умолчанию. По умолчанию инициализирует белый непрозрачный цвет
 		* \param r Компонента красного цвета
 		* \param g Компонента зеленого цвета
 		* \param b Компонента синего цвета
+		* \param a Непрозрачность (альфа-канал, 255 - непрозрачный). Учитывается только при рисовании на холсте
 		*/
-		ColorRGB(unsigned char r = 255, unsigned char g = 255, unsigned char b = 255);
+		ColorRGB(unsigned char r = 255, unsigned char g = 255, unsigned char b = 255, unsigned char a = 255);
+
+		/**
+		* \brief Получить цвет в premultiplied-форме (цветовые компоненты умножены на непрозрачность)
+		* \details Форма, в которой полупрозрачные цвета и изображения накладываются на холст (\see wquery::BlendPixels)
+		* \return Пиксель 0xAARRGGBB
+		*/
+		std::uint32_t GetPremultiplied() const;
 
 		/**
 		* \brief Получить хендл системной (WinApi) кисти
+		* \details Кисть берется из общего кеша (\see wquery::GdiCache) и должна быть освобождена
+		* через GetGdiCache().ReleaseBrush() когда она больше не нужна
 		* \return Хендл кисти
 		*/
 		HBRUSH GetNativeBrush() const;
@@ -151,7 +162,62 @@ namespace wquery
 	enum MainLoopType
 	{
 		GET_MSG,
-		PEEK_MSG
+		PEEK_MSG,
+		FRAME_PACED
+	};
+
+	/**
+	* \brief Параметры цикла с фиксированной частотой кадров (MainLoopType::FRAME_PACED)
+	* \details Между кадрами цикл спит до начала следующего кадра или до прихода сообщения (сообщения
+	* обрабатываются сразу, функция кадра вызывается только по расписанию). Если несколько кадров подряд
+	* не было ни сообщений, ни запросов кадра (\see wquery::RequestFrame), интервал между кадрами
+	* удваивается вплоть до maxIdleInterval и возвращается к исходному при первой активности
+	*/
+	struct FrameLoopSettings
+	{
+		unsigned int targetFps;                // Целевая частота кадров
+		bool fixedTimestep;                    // Фиксированный шаг (пропущенные кадры наверстываются повторными вызовами)
+		unsigned int maxCatchUpSteps;          // Максимум вызовов за кадр при наверстывании (фиксированный шаг)
+		unsigned int idleFramesBeforeBackoff;  // Кол-во кадров простоя, после которых интервал начинает расти
+		unsigned int maxIdleInterval;          // Максимальный интервал между кадрами при простое (мс)
+
+		/**
+		* \brief Конструктор по умолчанию
+		* \param inTargetFps Целевая частота кадров
+		* \param inFixedTimestep Фиксированный шаг
+		* \param inMaxCatchUpSteps Максимум вызовов за кадр при наверстывании
+		* \param inIdleFramesBeforeBackoff Кол-во кадров простоя до увеличения интервала (0 - не увеличивать)
+		* \param inMaxIdleInterval Максимальный интервал при простое (мс)
+		*/
+		FrameLoopSettings(unsigned int inTargetFps = 60, bool inFixedTimestep = false, unsigned int inMaxCatchUpSteps = 4,
+			unsigned int inIdleFramesBeforeBackoff = 30, unsigned int inMaxIdleInterval = 250);
+	};
+
+	/**
+	* \brief Статистика кадра цикла MainLoopType::FRAME_PACED (все времена в миллисекундах)
+	*/
+	struct FrameStatistics
+	{
+		unsigned long long frameIndex;         // Номер кадра
+		double frameTime;                      // Время от начала предыдущего кадра до начала текущего
+		double dispatchTime;                   // Время обработки сообщений с начала предыдущего кадра
+		double callbackTime;                   // Время исполнения функции кадра
+		double waitTime;                       // Время сна с начала предыдущего кадра
+		double interval;                       // Текущий интервал между кадрами (с учетом простоя)
+		unsigned int messageCount;             // Кол-во обработанных сообщений с начала предыдущего кадра
+		unsigned int steps;                    // Кол-во вызовов функции кадра (больше 1 при наверстывании)
+		bool idle;                             // Кадр считается простоем (не было сообщений и запросов кадра)
+	};
+
+	/**
+	* \brief Статистика отложенной перерисовки окон (\see Window::Invalidate)
+	*/
+	struct PaintStatistics
+	{
+		unsigned long long invalidations;      // Кол-во запросов перерисовки
+		unsigned long long paints;             // Кол-во выполненных перерисовок окон
+		unsigned long long repaintsAvoided;    // Кол-во запросов, выполненных в составе чужой перерисовки
+		unsigned long long rectsMerged;        // Кол-во прямоугольников, поглощенных или слитых в недействительных областях
 	};
 
 	/**
@@ -164,4 +230,13 @@ namespace wquery
 		MIDDLE,
 		RIGHT
 	};
+
+	/**
+	* \brief Отсчет движения мыши (\see Window::SetMouseCoalescing)
+	*/
+	struct MouseSample
+	{
+		Vector2D<int> position;                // Положение курсора в клиентской области
+		unsigned long long time;               // Время получения сообщения (мкс, монотонное)
+	};
 }
\ No newline at end of file
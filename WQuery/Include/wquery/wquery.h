@@ -11,17 +11,39 @@
 
 #include "stdafx.h"
 #include "types/common.h"
+#include "platform/Backend.h"
+#include "platform/GdiCache.h"
+#include "platform/GlyphCache.h"
+#include "platform/HeadlessBackend.h"
+#include "platform/Win32Backend.h"
 #include "gui/Window.h"
 #include "gui/Button.h"
 #include "gui/TextBox.h"
+#include "gui/Grid.h"
+#include "gui/LogView.h"
+#include "gui/Form.h"
 #include "tools/text.h"
+#include "tools/utf.h"
+#include "tools/cpu.h"
 #include "tools/files.h"
+#include "tools/TimerWheel.h"
+#include "tools/TaskQueue.h"
+#include "tools/Coroutine.h"
+#include "tools/Delegate.h"
+#include "tools/Signal.h"
+#include "tools/DirtyRegion.h"
+#include "tools/raster.h"
+#include "tools/Canvas.h"
+#include "tools/MappedFile.h"
+#include "tools/startup.h"
+#include "tools/instrumentation.h"
+#include "tools/PieceTable.h"
 
 namespace wquery
 {
 	/**
 	* \brief Своеобразная "процедурная скобка" с которой начинается взаимодействие с библиотекой
-	* \detail Функция регистрирует оконный клас и производит необходимые манипуляции
+	* \detail Функция регистрирует оконный клас (через текущий бэкенд, \see wquery::SetBackend) и производит необходимые манипуляции
 	* \param hInstance Хендл текущего приложения (модуля)
 	*/
 	void Begin(HINSTANCE hInstance = nullptr);
@@ -30,6 +52,68 @@ namespace wquery
 	* \brief Своеобразная "процедурная скобка" которой оканичнвается взаимодействие с библиотекой
 	* \param loopType Тип цикла, который будет запущен для обработки оконных сообщений \see wquery::MainLoopType
 	* \param afterIterationCallback Функция которая может быть вызвана после исполнения каждой итерации цикла
+	* \details Необработанное исключение задачи, запущенной через Spawn или переданной через Post, пробрасывается из цикла между итерациями
 	*/
 	void End(const MainLoopType loopType = MainLoopType::GET_MSG, std::function<void(Window * pWindow)> afterIterationCallback = nullptr);
+
+	/**
+	* \brief Задать параметры цикла с фиксированной частотой кадров (MainLoopType::FRAME_PACED)
+	* \details Параметры применяются при следующем запуске цикла (вызове End)
+	* \param settings Параметры
+	*/
+	void SetFrameLoopSettings(const FrameLoopSettings& settings);
+
+	/**
+	* \brief Получить параметры цикла с фиксированной частотой кадров
+	* \return Параметры
+	*/
+	const FrameLoopSettings& GetFrameLoopSettings();
+
+	/**
+	* \brief Получить статистику последнего завершенного кадра (MainLoopType::FRAME_PACED)
+	* \return Статистика
+	*/
+	const FrameStatistics& GetFrameStatistics();
+
+	/**
+	* \brief Запросить следующий кадр с полной частотой
+	* \details Кадр, в котором был запрос, не считается простоем. Вызывается из функции кадра, пока
+	* идет анимация, чтобы цикл не увеличивал интервал между кадрами
+	*/
+	void RequestFrame();
+
+	/**
+	* \brief Запустить однократный таймер
+	* \details Таймеры обрабатываются основным циклом (\see wquery::End) в его потоке, при любом типе цикла.
+	* Блокирующий цикл (GET_MSG) просыпается ровно к сроку ближайшего таймера
+	* \param delay Задержка (мс)
+	* \param callback Функция обратного вызова
+	* \return Идентификатор таймера
+	*/
+	TimerId SetTimeout(unsigned int delay, std::function<void()> callback);
+
+	/**
+	* \brief Запустить периодический таймер
+	* \param interval Период (мс)
+	* \param callback Функция обратного вызова
+	* \return Идентификатор таймера
+	*/
+	TimerId SetInterval(unsigned int interval, std::function<void()> callback);
+
+	/**
+	* \brief Остановить таймер
+	* \param id Идентификатор таймера
+	* \return Был ли таймер запущен
+	*/
+	bool CancelTimer(TimerId id);
+
+	/**
+	* \brief Передать задачу на выполнение в поток основного цикла (может вызываться из любого потока)
+	* \details Только в этой задаче фоновый поток может обращаться к окнам и элементам управления. Задачи
+	* выполняются в порядке добавления, пакетами. На пакет задач приходится одно сообщение пробуждения
+	* цикла (\see Backend::Wake), сколько бы задач ни было добавлено до начала его разбора.
+	* Задачи, переданные до вызова Begin, выполняются после него, в основном цикле
+	* \param task Задача
+	*/
+	void Post(std::function<void()> task);
 }
\ No newline at end of file
@@ -8,14 +8,34 @@
 
 #include <wquery/stdafx.h>
 #include <wquery/gui/Button.h>
+#include <wquery/tools/Canvas.h>
 
 namespace wquery
 {
+	/**
+	* \brief Нажатие на кнопку (BN_CLICKED)
+	* \param control Элемент управления
+	* \param wParam Параметр сообщения WM_COMMAND
+	* \param lParam Параметр сообщения WM_COMMAND
+	*/
+	static void ButtonClickedNotification(ControlBase * control, WPARAM, LPARAM)
+	{
+		Button * pButton = static_cast<Button*>(control);
+		if (pButton->events.onClicked) pButton->events.onClicked();
+	}
+
 	/**
 	* \brief Конструктор
 	* \param window Владеющее окно
 	*/
-	Button::Button(Window * window) : ControlBase(window, "Button") {}
+	Button::Button(Window * window) : ControlBase(window, Button::TypeTag(), "Button") {}
+
+	/**
+	* \brief Конструктор с начальным состоянием
+	* \param window Владеющее окно
+	* \param state Начальное состояние
+	*/
+	Button::Button(Window * window, const ControlState& state) : ControlBase(window, Button::TypeTag(), "Button", WS_CHILD, state) {}
 
 	/**
 	* \brief Деструктор (унаследован от частично-вирутального)
@@ -30,4 +50,60 @@ namespace wquery
 	{
 		return "Button";
 	}
+
+	/**
+	* \brief Получить тег типа (при первом вызове тип регистрируется вместе с обработчиками уведомлений)
+	* \return Тег типа
+	*/
+	unsigned int Button::TypeTag()
+	{
+		static const unsigned int typeTag = []()
+		{
+			const unsigned int tag = ControlBase::RegisterControlType();
+			ControlBase::RegisterNotification(tag, BN_CLICKED, &ButtonClickedNotification);
+			return tag;
+		}();
+
+		return typeTag;
+	}
+
+	/**
+	* \brief Дождаться нажатия (в сопрограмме: co_await button->Clicked())
+	* \return Ожидаемый объект (\see ControlBase::Notified)
+	*/
+	NotificationAwaiter Button::Clicked()
+	{
+		return this->Notified(BN_CLICKED);
+	}
+
+	/**
+	* \brief Нарисовать кнопку без системного окна
+	* \param canvas Задний буфер окна
+	* \param rect Прямоугольник кнопки
+	*/
+	void Button::PaintWindowless(Canvas& canvas, const RECT& rect) const
+	{
+		static thread_local std::string text;
+		FontSettings font;
+		this->GetPaintText(text, font);
+
+		const bool enabled = this->IsEnabled();
+		canvas.FillRect(rect, enabled ? ColorRGB(225, 225, 225) : ColorRGB(204, 204, 204));
+		canvas.DrawRect(rect, enabled ? ColorRGB(173, 173, 173) : ColorRGB(191, 191, 191));
+
+		const Vector2D<int> textSize = Canvas::MeasureString(text, font);
+		canvas.DrawString(text, font, {
+			rect.left + (rect.right - rect.left - textSize.X) / 2,
+			rect.top + (rect.bottom - rect.top - textSize.Y) / 2 },
+			enabled ? ColorRGB(0, 0, 0) : ColorRGB(131, 131, 131));
+	}
+
+	/**
+	* \brief Нажатие на кнопку без системного окна
+	* \param message Сообщение мыши
+	*/
+	void Button::HandleWindowlessMouse(UINT message)
+	{
+		if (message == WM_LBUTTONUP) ControlBase::DispatchNotification(this, MAKEWPARAM(0, BN_CLICKED), 0);
+	}
 };
\ No newline at end of file
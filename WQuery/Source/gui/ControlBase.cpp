@@ -1,71 +1,368 @@
 ﻿#include <wquery/stdafx.h>
 #include <wquery/gui/ControlBase.h>
 #include "wquery/tools/text.h"
+#include "wquery/platform/Backend.h"
+#include "wquery/platform/GdiCache.h"
+#include "wquery/tools/startup.h"
+#include "wquery/tools/instrumentation.h"
 
 namespace wquery
 {
 	/**
-	* \brief Глобальный хендл приложения, инициализируется в методе wquery::Begin()
-	* \see wquery.cpp
+	* \brief Кол-во зарегистрированных типов элементов (тег 0 не выдается)
 	*/
-	extern HINSTANCE hInstance_;
+	static unsigned int controlTypeCount_ = 1;
 
 	/**
-	* \brief Глобальная структура параметров оконного класса, инициализируется в методе wquery::Begin()
-	* \see wquery.cpp
+	* \brief Номер строки таблицы обработчиков для каждого кода уведомления (0 - обработчиков нет)
+	* \details Код уведомления - 16-битное значение, поэтому таблица адресуется им напрямую
+	* (статический массив 64 КБ, заполнен нулями до первой регистрации)
 	*/
-	extern WNDCLASSEX classInfo_;
+	static unsigned char notificationSlots_[0xFFFF + 1];
+
+	/**
+	* \brief Таблица обработчиков уведомлений [строка кода уведомления][тег типа элемента]
+	*/
+	static std::vector<std::vector<NotificationHandler>> notificationHandlers_;
 
 	/**
 	* \brief Конструктор элемента управления
 	* \param window Указатель на владеющее окно
+	* \param typeTag Тег типа элемента
 	* \param controlClassName Наименовая WinApi класса элемента управления
 	* \param dwStyle Стиль отображения элемента
 	*/
-	ControlBase::ControlBase(Window* window, const std::string& controlClassName, DWORD dwStyle, const Vector2D<int>& defaultSizes) :
+	ControlBase::ControlBase(Window* window, unsigned int typeTag, const std::string& controlClassName, DWORD dwStyle, const Vector2D<int>& defaultSizes) :
 		hWnd_(nullptr),
+		typeTag_(typeTag),
 		window_(window),
-		anchor_(AnchorSettings(false, false, false, false)),
-	    customFont_(nullptr)
+		id_(0),
+	    customFont_(nullptr),
+		textRevision_(0)
+	{
+		this->Attach(controlClassName, dwStyle, { 0,0 }, defaultSizes, std::string_view(), false);
+	}
+
+	/**
+	* \brief Конструктор элемента управления с начальным состоянием
+	* \param window Указатель на владеющее окно
+	* \param typeTag Тег типа элемента
+	* \param controlClassName Наименовая WinApi класса элемента управления
+	* \param dwStyle Стиль отображения элемента
+	* \param state Начальное состояние
+	*/
+	ControlBase::ControlBase(Window* window, unsigned int typeTag, const std::string& controlClassName, DWORD dwStyle, const ControlState& state) :
+		hWnd_(nullptr),
+		typeTag_(typeTag),
+		window_(window),
+		id_(0),
+		customFont_(nullptr),
+		textRevision_(0)
+	{
+		// Видимость и доступность задаются стилем при создании
+		dwStyle |= state.style;
+		if (state.visible) dwStyle |= WS_VISIBLE; else dwStyle &= ~static_cast<DWORD>(WS_VISIBLE);
+		if (!state.enabled) dwStyle |= WS_DISABLED;
+
+		// Шрифт нужен уже при создании системного элемента (если окно создано, элемент создается сразу)
+		this->customFont_ = state.font ? GetGdiCache().AcquireFont(*state.font) : nullptr;
+
+		// Текст передается при создании: уведомление об изменении не отправляется (объект наследника еще не создан)
+		this->Attach(controlClassName, dwStyle, state.position, state.size, state.text, state.windowless);
+
+		if (!this->window_)
+		{
+			GetGdiCache().ReleaseFont(this->customFont_);
+			this->customFont_ = nullptr;
+			return;
+		}
+
+		this->window_->controls_.SetAnchor(this->id_, state.anchor);
+		if (!state.text.empty()) this->MarkTextChanged();
+	}
+
+	/**
+	* \brief Зарегистрировать элемент в окне (системный элемент создается сразу, только если окно уже создано)
+	* \param controlClassName Наименование WinApi класса элемента управления
+	* \param dwStyle Стиль элемента
+	* \param position Положение
+	* \param size Размеры
+	* \param text Начальный текст
+	* \param windowless Элемент без системного окна
+	*/
+	void ControlBase::Attach(const std::string& controlClassName, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, std::string_view text, bool windowless)
 	{
+		StartupTimer timer(STARTUP_PHASE_CONTROL_CONSTRUCTION);
+
 		// Все элементы управления в WinApi являются окнами, отличаются их классы (controlClassName) и стили.
 		// В системе есть ряд предустановленых классов окон используемых для элементов управления.
 		// Наследуемые от данного класса дочерные классы, в зависимости от своего типа и предназначения, в параметре controlClassName
 		// передают в базовый конструктор (этот) разные наименования WinApi классов окон (напр. Static - для лейбла, Button - для кнопки)
-		if (hInstance_ && this->window_ && this->window_->GetNativeHandle() && !controlClassName.empty())
+		if (!this->window_ || controlClassName.empty())
 		{
-			this->hWnd_ = CreateWindowA(
-				controlClassName.c_str(),
-				NULL,
-				dwStyle,
-				0, 0,
-				defaultSizes.X, defaultSizes.Y,
-				this->window_->GetNativeHandle(),
-				NULL,
-				hInstance_,
-				NULL
-			);
+			this->window_ = nullptr;
+			return;
 		}
 
+		// Зарегистрировать элемент в хранилище геометрии окна (хендл будет записан при создании)
+		unsigned char flags = 0;
+		if (!(dwStyle & WS_VISIBLE)) flags |= GEOMETRY_HIDDEN;
+		if (dwStyle & WS_DISABLED) flags |= GEOMETRY_DISABLED;
+		if (windowless) flags |= GEOMETRY_WINDOWLESS;
+		this->id_ = this->window_->AttachControl(this, position, size, flags);
+
+		// Элемент без системного окна хранит свои свойства так же, как еще не созданный элемент
+		this->pending_.reset(new PendingControl());
+		this->pending_->className = controlClassName;
+		this->pending_->style = dwStyle;
+		this->pending_->text.Set(text);
+
+		// Элемент, добавленный в уже созданное окно, создается сразу (элемент без системного окна - рисуется окном)
+		if (windowless) this->InvalidateWindowArea();
+		else if (this->window_->IsCreated()) this->CreateNative();
+	}
+
+	/**
+	* \brief Создать системный элемент по записанным свойствам
+	*/
+	void ControlBase::CreateNative()
+	{
+		if (!this->pending_) return;
+
+		StartupTimer timer(STARTUP_PHASE_CONTROL_CREATION);
+		const std::unique_ptr<PendingControl> pending = std::move(this->pending_);
+		Backend& backend = GetBackend();
+
+		// Положение и размеры берутся из хранилища геометрии (с учетом раскладки, выполненной до создания)
+		this->hWnd_ = backend.CreateControlHandle(
+			pending->className,
+			this->window_->hWnd_,
+			pending->style,
+			this->window_->controls_.GetPosition(this->id_),
+			this->window_->controls_.GetSize(this->id_),
+			pending->text.GetInitial()
+		);
+
 		// Если элемент был создан
 		if (this->hWnd_)
 		{
 			// В поле GWLP_USERDATA, созданного элемента управления, будет записан указатель на данный объект
 			// Таким образом к объекту можно будет обратиться в оконной процедуре
-			SetWindowLongPtr(this->hWnd_, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+			backend.SetUserData(this->hWnd_, this);
 
-			// Установить шрифт по умолчанию
-			SendMessage(this->hWnd_, WM_SETFONT, reinterpret_cast<WPARAM>(GetStockObject(DEFAULT_GUI_FONT)), MAKELPARAM(TRUE, 0));
+			// Установить шрифт
+			backend.Send(this->hWnd_, WM_SETFONT, reinterpret_cast<WPARAM>(this->customFont_ ? this->customFont_ : backend.GetDefaultFont()), MAKELPARAM(TRUE, 0));
+
+			this->window_->controls_.SetHandle(this->id_, this->hWnd_);
+			pending->text.Apply(this->hWnd_);
+
+			// Элемент без системного окна становится обычным (окно больше не рисует его)
+			if (this->window_->controls_.HasFlag(this->id_, GEOMETRY_WINDOWLESS))
+			{
+				this->window_->controls_.SetFlag(this->id_, GEOMETRY_WINDOWLESS, false);
+				this->window_->windowlessCount_--;
+			}
 		}
 	}
 
+	/**
+	* \brief Нарисовать элемент без системного окна в заднем буфере окна (по умолчанию - только текст)
+	* \param canvas Задний буфер окна
+	* \param rect Прямоугольник элемента (в координатах клиентской области)
+	*/
+	void ControlBase::PaintWindowless(Canvas& canvas, const RECT& rect) const
+	{
+		static thread_local std::string text;
+		FontSettings font;
+		this->GetPaintText(text, font);
+
+		const Vector2D<int> textSize = Canvas::MeasureString(text, font);
+		const ColorRGB color = this->IsEnabled() ? ColorRGB(0, 0, 0) : ColorRGB(109, 109, 109);
+		canvas.DrawString(text, font, { rect.left, rect.top + (rect.bottom - rect.top - textSize.Y) / 2 }, color);
+	}
+
+	/**
+	* \brief Обработать нажатие мыши на элементе без системного окна (по умолчанию ничего не делает)
+	*/
+	void ControlBase::HandleWindowlessMouse(UINT) {}
+
+	/**
+	* \brief Обработать прокрутку колеса мыши над элементом без системного окна (по умолчанию ничего не делает)
+	*/
+	void ControlBase::HandleWindowlessWheel(int) {}
+
+	/**
+	* \brief Рисуется ли элемент только окном
+	* \return Статус
+	*/
+	bool ControlBase::IsWindowlessOnly() const
+	{
+		return false;
+	}
+
+	/**
+	* \brief Обработать ввод с клавиатуры элементом без системного окна (по умолчанию ничего не делает)
+	*/
+	void ControlBase::HandleWindowlessKey(UINT, WPARAM) {}
+
+	/**
+	* \brief Получает ли элемент без системного окна ввод с клавиатуры
+	* \return Статус
+	*/
+	bool ControlBase::HasWindowlessFocus() const
+	{
+		return this->window_ && this->window_->focusedControl_ == this && this->IsWindowless();
+	}
+
+	/**
+	* \brief Получить текст и шрифт для рисования элемента без системного окна
+	* \param text Строка для записи текста (UTF-8)
+	* \param font Параметры шрифта
+	*/
+	void ControlBase::GetPaintText(std::string& text, FontSettings& font) const
+	{
+		if (this->pending_) this->pending_->text.Get(text);
+		else text.clear();
+
+		GetBackend().GetFontSettings(this->customFont_ ? this->customFont_ : GetBackend().GetDefaultFont(), font);
+	}
+
+	/**
+	* \brief Получить стиль элемента (до создания - записанный)
+	* \return Стиль
+	*/
+	DWORD ControlBase::GetStyle() const
+	{
+		if (this->pending_) return this->pending_->style;
+		return this->hWnd_ ? GetBackend().GetStyle(this->hWnd_) : 0;
+	}
+
+	/**
+	* \brief Установить стиль элемента (до создания - только записать)
+	* \param dwStyle Стиль
+	*/
+	void ControlBase::SetStyle(DWORD dwStyle) const
+	{
+		if (this->pending_) this->pending_->style = dwStyle;
+		else if (this->hWnd_) GetBackend().SetStyle(this->hWnd_, dwStyle);
+	}
+
 	/**
 	* \brief Деструктор (вирутальный, уничтожает в том числе и объект-наследник)
 	*/
 	ControlBase::~ControlBase()
 	{
+		if (this->window_)
+		{
+			if (this->IsWindowless()) this->InvalidateWindowArea();
+			this->window_->DetachControl(this);
+		}
+
 		if (this->hWnd_)
-			DestroyWindow(this->hWnd_);
+			GetBackend().DestroyHandle(this->hWnd_);
+
+		// Освобождение кастомного шрифта (объект удаляется, если его больше никто не использует)
+		GetGdiCache().ReleaseFont(this->customFont_);
+
+		// Ожидающие уведомлений сопрограммы продолжаются с отрицательным результатом
+		for (const NotificationWaiter& waiter : this->waiters_)
+		{
+			*waiter.received = false;
+			ResumeLater(waiter.coroutine);
+		}
+	}
+
+	/**
+	* \brief Получить тег типа элемента
+	* \return Тег типа
+	*/
+	unsigned int ControlBase::GetTypeTag() const
+	{
+		return this->typeTag_;
+	}
+
+	/**
+	* \brief Зарегистрировать новый тип элемента управления
+	* \return Тег типа
+	*/
+	unsigned int ControlBase::RegisterControlType()
+	{
+		return controlTypeCount_++;
+	}
+
+	/**
+	* \brief Зарегистрировать обработчик уведомления для типа элемента
+	* \param typeTag Тег типа элемента
+	* \param code Код уведомления
+	* \param handler Обработчик
+	*/
+	void ControlBase::RegisterNotification(unsigned int typeTag, WORD code, NotificationHandler handler)
+	{
+		// Первый обработчик для данного кода - выделить строку таблицы
+		if (notificationSlots_[code] == 0)
+		{
+			if (notificationHandlers_.size() >= 0xFF) {
+				throw std::runtime_error("WQuery: Too many notification codes registered");
+			}
+
+			notificationHandlers_.emplace_back();
+			notificationSlots_[code] = static_cast<unsigned char>(notificationHandlers_.size());
+		}
+
+		std::vector<NotificationHandler>& row = notificationHandlers_[notificationSlots_[code] - 1];
+		if (row.size() <= typeTag) row.resize(typeTag + 1, nullptr);
+		row[typeTag] = handler;
+	}
+
+	/**
+	* \brief Передать уведомление зарегистрированному обработчику
+	* \param control Элемент управления, от которого пришло уведомление
+	* \param wParam Параметр сообщения WM_COMMAND
+	* \param lParam Параметр сообщения WM_COMMAND
+	* \return Был ли найден обработчик (или ожидающая уведомления сопрограмма)
+	*/
+	bool ControlBase::DispatchNotification(ControlBase* control, WPARAM wParam, LPARAM lParam)
+	{
+		if (!control) return false;
+
+		// Ожидающие уведомления сопрограммы только ставятся в очередь (продолжатся после обработчика)
+		const WORD code = HIWORD(wParam);
+		std::vector<NotificationWaiter>& waiters = control->waiters_;
+		size_t remaining = 0;
+
+		for (size_t i = 0; i < waiters.size(); i++)
+		{
+			if (waiters[i].code != code) {
+				waiters[remaining++] = waiters[i];
+				continue;
+			}
+
+			*waiters[i].received = true;
+			ResumeLater(waiters[i].coroutine);
+		}
+
+		const bool awaited = remaining != waiters.size();
+		waiters.resize(remaining);
+
+		const unsigned char slot = notificationSlots_[code];
+		if (slot == 0) return awaited;
+
+		const std::vector<NotificationHandler>& row = notificationHandlers_[slot - 1];
+		if (control->typeTag_ >= row.size() || !row[control->typeTag_]) return awaited;
+
+		WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_NOTIFICATION);
+		row[control->typeTag_](control, wParam, lParam);
+		return true;
+	}
+
+	/**
+	* \brief Дождаться уведомления элемента (в сопрограмме: co_await control->Notified(code))
+	* \param code Код уведомления (HIWORD(wParam) сообщения WM_COMMAND)
+	* \return Ожидаемый объект
+	*/
+	NotificationAwaiter ControlBase::Notified(WORD code)
+	{
+		return NotificationAwaiter(this, code);
 	}
 
 	/**
@@ -77,15 +374,108 @@ namespace wquery
 		return this->window_;
 	}
 
+	/**
+	* \brief Получить хендл элемента управления
+	* \return Хендл
+	*/
+	HWND ControlBase::GetNativeHandle() const
+	{
+		// Элементы создаются вместе с окном, элемент без системного окна - при первом обращении к хендлу
+		if (this->pending_)
+		{
+			this->window_->GetNativeHandle();
+			if (this->pending_ && this->window_->IsCreated() && !this->IsWindowlessOnly()) const_cast<ControlBase*>(this)->CreateNative();
+		}
+
+		return this->hWnd_;
+	}
+
+	/**
+	* \brief Создан ли системный элемент
+	* \return Статус
+	*/
+	bool ControlBase::IsCreated() const
+	{
+		return this->hWnd_ != nullptr;
+	}
+
+	/**
+	* \brief Является ли элемент элементом без системного окна
+	* \return Статус
+	*/
+	bool ControlBase::IsWindowless() const
+	{
+		return this->window_ && this->window_->controls_.HasFlag(this->id_, GEOMETRY_WINDOWLESS);
+	}
+
 	/**
 	* \brief Установить текст элемента управления
 	* \param text Текст
 	*/
 	void ControlBase::SetText(const std::string& text) const
 	{
-		if (this->hWnd_)
+		this->SetText(text.c_str());
+	}
+
+	/**
+	* \brief Установить текст элемента управления
+	* \param text Текст (нуль-терминированная строка)
+	*/
+	void ControlBase::SetText(const char* text) const
+	{
+		if (this->pending_)
+		{
+			this->pending_->text.Set(std::string_view(text ? text : ""));
+			this->MarkTextChanged();
+			if (this->IsWindowless()) this->InvalidateWindowArea();
+		}
+		else if (this->hWnd_)
 		{
-			SetWindowTextA(this->hWnd_, text.c_str());
+			// Системное поле ввода отмечает изменение само (EN_CHANGE приходит во время записи) -
+			// ревизия увеличивается один раз
+			const unsigned int revision = this->textRevision_;
+			GetBackend().SetText(this->hWnd_, text);
+			if (this->textRevision_ == revision) this->MarkTextChanged();
+		}
+	}
+
+	/**
+	* \brief Установить текст элемента управления
+	* \param text Текст (представление строки)
+	*/
+	void ControlBase::SetText(std::string_view text) const
+	{
+		if (this->pending_)
+		{
+			this->pending_->text.Set(text);
+			this->MarkTextChanged();
+			if (this->IsWindowless()) this->InvalidateWindowArea();
+		}
+		else if (this->hWnd_)
+		{
+			const unsigned int revision = this->textRevision_;
+			GetBackend().WriteText(this->hWnd_, text);
+			if (this->textRevision_ == revision) this->MarkTextChanged();
+		}
+	}
+
+	/**
+	* \brief Установить текст элемента управления
+	* \param text Текст в UTF-16
+	*/
+	void ControlBase::SetText(std::u16string_view text) const
+	{
+		if (this->pending_)
+		{
+			this->pending_->text.Set(text);
+			this->MarkTextChanged();
+			if (this->IsWindowless()) this->InvalidateWindowArea();
+		}
+		else if (this->hWnd_)
+		{
+			const unsigned int revision = this->textRevision_;
+			GetBackend().WriteText(this->hWnd_, text);
+			if (this->textRevision_ == revision) this->MarkTextChanged();
 		}
 	}
 
@@ -96,32 +486,149 @@ namespace wquery
 	std::string ControlBase::GetText() const
 	{
 		std::string result;
-		if (this->hWnd_)
+		this->GetText(result);
+		return result;
+	}
+
+	/**
+	* \brief Получить текст элемента управления в существующую строку
+	* \param text Строка для записи
+	*/
+	void ControlBase::GetText(std::string& text) const
+	{
+		if (this->pending_) this->pending_->text.Get(text);
+		else if (this->hWnd_) GetBackend().ReadText(this->hWnd_, text);
+		else text.clear();
+	}
+
+	/**
+	* \brief Получить текст элемента управления в существующую UTF-16 строку
+	* \param text Строка для записи
+	*/
+	void ControlBase::GetText(std::u16string& text) const
+	{
+		if (this->pending_) this->pending_->text.Get(text);
+		else if (this->hWnd_) GetBackend().ReadText(this->hWnd_, text);
+		else text.clear();
+	}
+
+	/**
+	* \brief Получить текст элемента управления в буфер
+	* \param buffer Буфер
+	* \param capacity Размер буфера
+	* \return Кол-во записанных символов (без нуль-терминатора)
+	*/
+	size_t ControlBase::GetText(char* buffer, size_t capacity) const
+	{
+		if (capacity == 0) return 0;
+		if (this->pending_)
+		{
+			static thread_local std::string text;
+			this->pending_->text.Get(text);
+			const size_t length = (std::min)(text.length(), capacity - 1);
+			memcpy(buffer, text.data(), length);
+			buffer[length] = 0;
+			return length;
+		}
+		if (!this->hWnd_)
 		{
-			const unsigned int textLength = GetWindowTextLengthA(this->hWnd_)+1;
-			char * buffer = new char[textLength];
-			GetWindowTextA(this->hWnd_, buffer, textLength);
-			result.append(buffer);
-			delete[] buffer;
+			buffer[0] = 0;
+			return 0;
+		}
+		return GetBackend().GetText(this->hWnd_, buffer, capacity);
+	}
 
+	/**
+	* \brief Получить текст элемента управления в UTF-16 буфер
+	* \param buffer Буфер
+	* \param capacity Размер буфера
+	* \return Кол-во записанных символов (без нуль-терминатора)
+	*/
+	size_t ControlBase::GetText(char16_t* buffer, size_t capacity) const
+	{
+		if (capacity == 0) return 0;
+		if (this->pending_)
+		{
+			static thread_local std::u16string text;
+			this->GetText(text);
+			const size_t length = (std::min)(text.length(), capacity - 1);
+			memcpy(buffer, text.data(), length * sizeof(char16_t));
+			buffer[length] = 0;
+			return length;
 		}
-		return result;
+		if (!this->hWnd_)
+		{
+			buffer[0] = 0;
+			return 0;
+		}
+		return GetBackend().GetTextUtf16(this->hWnd_, buffer, capacity);
+	}
+
+	/**
+	* \brief Получить длину текста элемента управления
+	* \return Длина (без нуль-терминатора)
+	*/
+	size_t ControlBase::GetTextLength() const
+	{
+		if (this->pending_)
+		{
+			if (!this->pending_->text.utf16) return this->pending_->text.text.length();
+
+			static thread_local std::string text;
+			this->pending_->text.Get(text);
+			return text.length();
+		}
+
+		return this->hWnd_ ? GetBackend().GetTextLength(this->hWnd_) : 0;
+	}
+
+	/**
+	* \brief Получить ревизию текста
+	* \return Номер ревизии
+	*/
+	unsigned int ControlBase::GetTextRevision() const
+	{
+		return this->textRevision_;
+	}
+
+	/**
+	* \brief Отметить изменение текста (увеличить ревизию)
+	*/
+	void ControlBase::MarkTextChanged() const
+	{
+		this->textRevision_++;
+	}
+
+	/**
+	* \brief Запросить отложенную перерисовку области окна, занимаемой элементом (\see Window::Invalidate)
+	*/
+	void ControlBase::InvalidateWindowArea() const
+	{
+		const Vector2D<int> position = this->window_->controls_.GetPosition(this->id_);
+		const Vector2D<int> size = this->window_->controls_.GetSize(this->id_);
+		this->window_->Invalidate({ position.X, position.Y, position.X + size.X, position.Y + size.Y });
 	}
 
 	/**
 	* \brief Установить положение
 	* \param position Положение
 	*/
-	void ControlBase::SetPosition(Vector2D<int> position) const
+	void ControlBase::SetPosition(Vector2D<int> position)
 	{
-		if (this->hWnd_) {
-			SetWindowPos(
-				this->hWnd_,                      // WinApi хендл элемента
-				nullptr,                          // Хендл элемента, над которым текущий будет размещен (Z-уровень)
+		if (this->window_) {
+			// Элемент без системного окна перерисовывается окном на прежнем и новом месте
+			const bool windowless = this->IsWindowless();
+			if (windowless) this->InvalidateWindowArea();
+
+			this->window_->controls_.SetPosition(this->id_, position);
+			if (windowless) this->InvalidateWindowArea();
+
+			if (this->hWnd_) GetBackend().SetPos(
+				this->hWnd_,                      // Хендл элемента
 				position.X,                       // Положение левой стороны
 				position.Y,                       // Положение верха
-				NULL,                             // Новая ширина в пикселях (не меняется)
-				NULL,                             // Новая высота в пикселях (не меняется)
+				0,                                // Новая ширина в пикселях (не меняется)
+				0,                                // Новая высота в пикселях (не меняется)
 				SWP_ASYNCWINDOWPOS | SWP_NOSIZE   // Асинхронное изменение (изменяет нить владеющая окном) без смены размера
 			);
 		}
@@ -133,53 +640,34 @@ namespace wquery
 	*/
 	Vector2D<int> ControlBase::GetPosition() const
 	{
-		Vector2D<int> position;
-
-		if (this->hWnd_)
-		{
-			RECT posRect = {};
-			POINT posPoint = {};
-
-			if (GetWindowRect(this->hWnd_, &posRect))
-			{
-				posPoint.x = posRect.left;
-				posPoint.y = posRect.top;
-			}
-
-			if (this->window_ != nullptr && this->window_->GetNativeHandle() != nullptr)
-			{
-				ScreenToClient(this->window_->GetNativeHandle(), &posPoint);
-			}
-
-			position.X = posPoint.x;
-			position.Y = posPoint.y;
-		}
-
-		return position;
+		// Положение берется из хранилища геометрии окна (без обращения к системе)
+		if (this->window_) return this->window_->controls_.GetPosition(this->id_);
+		return {};
 	}
 
 	/**
 	* \brief Установить размеры
 	* \param size Размеры
 	*/
-	void ControlBase::SetSize(Vector2D<int> size) const
+	void ControlBase::SetSize(Vector2D<int> size)
 	{
-		if (this->hWnd_)
+		if (this->window_)
 		{
-			SetWindowPos(
-				this->hWnd_,                      // WinApi хендл элемента
-				nullptr,                          // Хендл элемента, над которым текущий будет размещен (Z-уровень)
-				NULL,                             // Положение левой стороны (не меняется)
-				NULL,                             // Положение верха (не меняется)
+			// Перерисовывается область окна, которую элемент занимал до и после изменения
+			const Vector2D<int> position = this->window_->controls_.GetPosition(this->id_);
+			const Vector2D<int> oldSize = this->window_->controls_.GetSize(this->id_);
+
+			this->window_->controls_.SetSize(this->id_, size);
+			if (this->hWnd_) GetBackend().SetPos(
+				this->hWnd_,                      // Хендл элемента
+				0,                                // Положение левой стороны (не меняется)
+				0,                                // Положение верха (не меняется)
 				size.X,                           // Новая ширина в пикселях
 				size.Y,                           // Новая высота в пикселях
 				SWP_ASYNCWINDOWPOS | SWP_NOMOVE   // Асинхронное изменение (изменяет нить владеющая окном) без смены положения
 			);
 
-			if(this->window_->GetNativeHandle())
-			{
-				UpdateWindow(this->window_->GetNativeHandle());
-			}
+			this->window_->Invalidate({ position.X, position.Y, position.X + (std::max)(oldSize.X, size.X), position.Y + (std::max)(oldSize.Y, size.Y) });
 		}
 	}
 
@@ -189,17 +677,9 @@ namespace wquery
 	*/
 	Vector2D<int> ControlBase::GetSize() const
 	{
-		Vector2D<int> sizes;
-
-		if (this->hWnd_)
-		{
-			RECT rect = {};
-			GetWindowRect(this->hWnd_, &rect);
-			sizes.X = rect.right - rect.left;
-			sizes.Y = rect.bottom - rect.top;
-		}
-
-		return sizes;
+		// Размеры берутся из хранилища геометрии окна (без обращения к системе)
+		if (this->window_) return this->window_->controls_.GetSize(this->id_);
+		return {};
 	}
 
 	/**
@@ -208,7 +688,21 @@ namespace wquery
 	*/
 	void ControlBase::SetEnabled(const bool state) const
 	{
-		if (this->hWnd_) EnableWindow(this->hWnd_, state);
+		if (this->window_)
+		{
+			if (this->pending_)
+			{
+				if (state) this->pending_->style &= ~static_cast<DWORD>(WS_DISABLED);
+				else this->pending_->style |= WS_DISABLED;
+			}
+			else if (this->hWnd_)
+			{
+				GetBackend().Enable(this->hWnd_, state);
+			}
+
+			this->window_->controls_.SetFlag(this->id_, GEOMETRY_DISABLED, !state);
+			if (this->IsWindowless()) this->InvalidateWindowArea();
+		}
 	}
 
 	/**
@@ -217,8 +711,8 @@ namespace wquery
 	*/
 	bool ControlBase::IsEnabled() const
 	{
-		if (!this->hWnd_) return false;
-		return !(GetWindowLong(this->hWnd_, GWL_STYLE) & WS_DISABLED);
+		if (!this->window_) return false;
+		return !this->window_->controls_.HasFlag(this->id_, GEOMETRY_DISABLED);
 	}
 
 	/**
@@ -227,7 +721,7 @@ namespace wquery
 	*/
 	void ControlBase::SetAnchor(const AnchorSettings& anchor)
 	{
-		this->anchor_ = anchor;
+		if (this->window_) this->window_->controls_.SetAnchor(this->id_, anchor);
 	}
 
 	/**
@@ -236,7 +730,8 @@ namespace wquery
 	*/
 	AnchorSettings ControlBase::GetAnchor() const
 	{
-		return this->anchor_;
+		if (this->window_) return this->window_->controls_.GetAnchor(this->id_);
+		return AnchorSettings(false, false, false, false);
 	}
 
 	/**
@@ -245,36 +740,29 @@ namespace wquery
 	*/
 	void ControlBase::SetFont(const FontSettings& font)
 	{
-		if(this->hWnd_)
+		if(this->window_)
 		{
-			// Если кастомный шрифт уже был установлен ранее - следует очистить объект этого шрифта
-			if (this->customFont_) {
-				DeleteObject(this->customFont_);
+			// Получить шрифт из общего кеша (элементы с одинаковыми параметрами шрифта разделяют один объект).
+			// Прежний кастомный шрифт освобождается последним: при повторной установке тех же параметров
+			// объект не будет удален и создан заново, а системный элемент не останется с удаленным шрифтом
+			HFONT previousFont = this->customFont_;
+			this->customFont_ = GetGdiCache().AcquireFont(font);
+
+			// Еще не созданный элемент получит шрифт при создании (элемент без системного окна перерисовывается окном)
+			if (!this->hWnd_)
+			{
+				GetGdiCache().ReleaseFont(previousFont);
+				if (this->IsWindowless()) this->InvalidateWindowArea();
+				return;
 			}
 
-			// Создать новый объект шрифта в памяти и получить его хендл
-			this->customFont_ = CreateFontA(
-				font.size,
-				FALSE,
-				FALSE,
-				FW_DONTCARE,
-				font.bold ? 600 : 1,
-				font.italic,
-				FALSE,
-				FALSE,
-				ANSI_CHARSET,
-				OUT_TT_PRECIS,
-				CLIP_DEFAULT_PRECIS,
-				DEFAULT_QUALITY,
-				DEFAULT_PITCH | FF_DONTCARE,
-				font.fontFamilyName);
-
-			// Отправить сообщение элементу управления о смене шрифта
-			SendMessage(this->hWnd_, WM_SETFONT, reinterpret_cast<WPARAM>(this->customFont_), TRUE);
-
-			// Обновление области элемента управления
-			InvalidateRect(this->hWnd_, nullptr, TRUE);
-			UpdateWindow(this->window_->GetNativeHandle());
+			// Отправить сообщение элементу управления о смене шрифта, после чего прежний шрифт ему больше не нужен
+			GetBackend().Send(this->hWnd_, WM_SETFONT, reinterpret_cast<WPARAM>(this->customFont_), TRUE);
+			GetGdiCache().ReleaseFont(previousFont);
+
+			// Обновление области элемента управления (перерисовка окна откладывается до конца итерации цикла)
+			GetBackend().Invalidate(this->hWnd_, nullptr, TRUE);
+			this->InvalidateWindowArea();
 		}
 	}
 
@@ -288,18 +776,10 @@ namespace wquery
 		FontSettings result;
 
 		// Хендл используемого шрифта (если кастомный шрифт не установлен, значит используется шрифт по умолчанию)
-		HFONT hFont = this->customFont_ ? this->customFont_ : reinterpret_cast<HFONT>(GetStockObject(DEFAULT_GUI_FONT));
-
-		// Структура с информацией о шрифте
-		LOGFONT lf;
+		HFONT hFont = this->customFont_ ? this->customFont_ : GetBackend().GetDefaultFont();
 
-		// Если информация о шрифте была получена - вписать необходимые данные в result
-		if (GetObject(hFont, sizeof(LOGFONT), &lf)) {
-			result.bold = lf.lfWeight >= 600;
-			result.size = static_cast<unsigned int>(lf.lfHeight);
-			result.italic = !!lf.lfItalic;
-			result.fontFamilyName = WideToStr(lf.lfFaceName).c_str();
-		}
+		// Если информация о шрифте была получена - она уже вписана в result
+		GetBackend().GetFontSettings(hFont, result);
 
 		return result;
 	}
@@ -309,20 +789,27 @@ namespace wquery
 	*/
 	void ControlBase::ClearFont()
 	{
-		if (this->hWnd_)
+		if (this->window_)
 		{
-			// Если кастомный шрифт уже был установлен ранее - следует очистить объект этого шрифта
-			if (this->customFont_) {
-				DeleteObject(this->customFont_);
-				this->customFont_ = nullptr;
+			// Кастомный шрифт, установленный ранее, освобождается только после того, как элемент перестал его использовать
+			HFONT previousFont = this->customFont_;
+			this->customFont_ = nullptr;
+
+			// Еще не созданный элемент получит шрифт по умолчанию при создании
+			if (!this->hWnd_)
+			{
+				GetGdiCache().ReleaseFont(previousFont);
+				if (this->IsWindowless()) this->InvalidateWindowArea();
+				return;
 			}
 
 			// Отправить сообщение элементу управления о смене шрифта на шрифт по умочланию
-			SendMessage(this->hWnd_, WM_SETFONT, reinterpret_cast<WPARAM>(GetStockObject(DEFAULT_GUI_FONT)), TRUE);
+			GetBackend().Send(this->hWnd_, WM_SETFONT, reinterpret_cast<WPARAM>(GetBackend().GetDefaultFont()), TRUE);
+			GetGdiCache().ReleaseFont(previousFont);
 
-			// Обновление области элемента управления
-			InvalidateRect(this->hWnd_, nullptr, TRUE);
-			UpdateWindow(this->window_->GetNativeHandle());
+			// Обновление области элемента управления (перерисовка окна откладывается до конца итерации цикла)
+			GetBackend().Invalidate(this->hWnd_, nullptr, TRUE);
+			this->InvalidateWindowArea();
 		}
 	}
 }
@@ -0,0 +1,237 @@
+﻿/**
+* \brief Формы, загружаемые из бинарного описания (реализация загрузки)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/gui/Form.h>
+#include <wquery/gui/Button.h>
+#include <wquery/gui/TextBox.h>
+#include <wquery/tools/MappedFile.h>
+
+namespace wquery
+{
+	/**
+	* \brief Лежит ли таблица внутри описания и выровнена ли она
+	* \param offset Смещение таблицы
+	* \param count Кол-во записей
+	* \param recordSize Размер записи
+	* \param size Размер описания
+	* \return Результат проверки
+	*/
+	static bool IsTableInside(std::uint32_t offset, std::uint32_t count, size_t recordSize, size_t size)
+	{
+		const unsigned long long end = static_cast<unsigned long long>(offset) + static_cast<unsigned long long>(count) * recordSize;
+		return offset % 4 == 0 && end <= size;
+	}
+
+	/**
+	* \brief Конструктор
+	*/
+	Form::Form() = default;
+
+	/**
+	* \brief Деструктор
+	*/
+	Form::~Form()
+	{
+		this->Clear();
+	}
+
+	/**
+	* \brief Проверить бинарное описание
+	* \param data Описание
+	* \param size Размер описания
+	* \return Корректно ли описание
+	*/
+	bool Form::Validate(const unsigned char* data, size_t size)
+	{
+		if (size < sizeof(FormHeader)) return false;
+
+		const FormHeader& header = *reinterpret_cast<const FormHeader*>(data);
+		if (header.magic != FORM_MAGIC || header.version != FORM_VERSION || header.fileSize != size) return false;
+
+		// Таблицы лежат внутри файла, таблица строк непуста и заканчивается нуль-терминатором,
+		// поэтому любое смещение внутри нее указывает на завершенную строку
+		if (!IsTableInside(header.fontsOffset, header.fontCount, sizeof(FormFontRecord), size)) return false;
+		if (!IsTableInside(header.controlsOffset, header.controlCount, sizeof(FormControlRecord), size)) return false;
+		if (!IsTableInside(header.stringsOffset, header.stringsSize, 1, size) || header.stringsSize == 0) return false;
+		if (data[header.stringsOffset + header.stringsSize - 1] != 0) return false;
+
+		if (header.window.title >= header.stringsSize) return false;
+
+		const FormFontRecord* fonts = reinterpret_cast<const FormFontRecord*>(data + header.fontsOffset);
+		for (std::uint32_t i = 0; i < header.fontCount; i++) {
+			if (fonts[i].family >= header.stringsSize) return false;
+		}
+
+		const FormControlRecord* controls = reinterpret_cast<const FormControlRecord*>(data + header.controlsOffset);
+		for (std::uint32_t i = 0; i < header.controlCount; i++)
+		{
+			const FormControlRecord& control = controls[i];
+			if (control.type != FORM_CONTROL_BUTTON && control.type != FORM_CONTROL_TEXTBOX) return false;
+			if (control.name >= header.stringsSize || control.text >= header.stringsSize) return false;
+			if (control.font > header.fontCount) return false;
+		}
+
+		return true;
+	}
+
+	/**
+	* \brief Создать окно и элементы по проверенному описанию
+	* \param data Описание
+	*/
+	void Form::Instantiate(const unsigned char* data)
+	{
+		const FormHeader& header = *reinterpret_cast<const FormHeader*>(data);
+		const FormWindowRecord& record = header.window;
+		const char* strings = reinterpret_cast<const char*>(data + header.stringsOffset);
+
+		// Окно создается скрытым, все свойства задаются до показа
+		this->window_.reset(new Window());
+		this->window_->SetTitle(strings + record.title);
+		this->window_->SetSize({ record.width, record.height }, true);
+		if (record.flags & FORM_FLAG_MIN_SIZE) this->window_->SetMinSizes({ record.minWidth, record.minHeight }, true);
+		if (record.flags & FORM_FLAG_MAX_SIZE) this->window_->SetMaxSizes({ record.maxWidth, record.maxHeight }, true);
+		if (record.flags & FORM_FLAG_POSITION) this->window_->SetPosition({ record.x, record.y });
+		if (record.flags & FORM_FLAG_BG_COLOR) {
+			this->window_->SetBgColor(ColorRGB(static_cast<unsigned char>(record.bgColor >> 16), static_cast<unsigned char>(record.bgColor >> 8), static_cast<unsigned char>(record.bgColor)));
+		}
+		this->window_->SetClosesProgram((record.flags & FORM_FLAG_CLOSES_PROGRAM) != 0);
+
+		// Параметры шрифтов ссылаются на строки описания (кеш графических объектов копирует имя семейства)
+		const FormFontRecord* fontRecords = reinterpret_cast<const FormFontRecord*>(data + header.fontsOffset);
+		std::vector<FontSettings> fonts;
+		fonts.reserve(header.fontCount);
+		for (std::uint32_t i = 0; i < header.fontCount; i++)
+		{
+			const FormFontRecord& font = fontRecords[i];
+			fonts.emplace_back(strings + font.family, font.size, (font.flags & FORM_FLAG_BOLD) != 0, (font.flags & FORM_FLAG_ITALIC) != 0);
+		}
+
+		// Элементы создаются за один проход, каждый - сразу с начальным состоянием
+		const FormControlRecord* controlRecords = reinterpret_cast<const FormControlRecord*>(data + header.controlsOffset);
+		this->controls_.reserve(header.controlCount);
+
+		for (std::uint32_t i = 0; i < header.controlCount; i++)
+		{
+			const FormControlRecord& control = controlRecords[i];
+
+			ControlState state;
+			state.position = { control.x, control.y };
+			state.size = { control.width, control.height };
+			state.text = strings + control.text;
+			state.anchor = AnchorSettings(
+				(control.flags & FORM_FLAG_ANCHOR_LEFT) != 0,
+				(control.flags & FORM_FLAG_ANCHOR_TOP) != 0,
+				(control.flags & FORM_FLAG_ANCHOR_RIGHT) != 0,
+				(control.flags & FORM_FLAG_ANCHOR_BOTTOM) != 0);
+			state.font = control.font ? &fonts[control.font - 1] : nullptr;
+			state.visible = !(control.flags & FORM_FLAG_HIDDEN);
+			state.enabled = !(control.flags & FORM_FLAG_DISABLED);
+			state.windowless = (control.flags & FORM_FLAG_WINDOWLESS) != 0;
+
+			ControlBase* created;
+			if (control.type == FORM_CONTROL_TEXTBOX)
+			{
+				if (control.flags & FORM_FLAG_PASSWORD) state.style |= ES_PASSWORD;
+				created = new TextBox(this->window_.get(), state, (control.flags & FORM_FLAG_DOCUMENT) ? TextBoxMode::DOCUMENT : TextBoxMode::EDIT);
+			}
+			else
+			{
+				created = new Button(this->window_.get(), state);
+			}
+
+			this->controls_.emplace_back(created);
+			if (strings[control.name]) this->names_.emplace(strings + control.name, created);
+		}
+
+		if (!(record.flags & FORM_FLAG_HIDDEN)) this->window_->Show();
+	}
+
+	/**
+	* \brief Загрузить форму из файла
+	* \param path Путь к бинарному описанию (UTF-8)
+	* \return Удалось ли загрузить
+	*/
+	bool Form::Load(const std::string& path)
+	{
+		this->Clear();
+
+		MappedFile file;
+		if (!file.Open(path)) return false;
+
+		// Отображение выровнено по границе страницы - записи читаются на месте
+		if (!Validate(file.GetData(), file.GetSize())) return false;
+
+		this->Instantiate(file.GetData());
+		return true;
+	}
+
+	/**
+	* \brief Загрузить форму из памяти
+	* \param data Бинарное описание
+	* \param size Размер описания
+	* \return Удалось ли загрузить
+	*/
+	bool Form::Load(const void* data, size_t size)
+	{
+		this->Clear();
+		if (!data) return false;
+
+		// Невыровненные данные копируются в выровненный буфер
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		std::vector<std::uint32_t> aligned;
+		if (reinterpret_cast<std::uintptr_t>(bytes) % alignof(FormHeader) != 0)
+		{
+			aligned.resize((size + sizeof(std::uint32_t) - 1) / sizeof(std::uint32_t));
+			std::memcpy(aligned.data(), bytes, size);
+			bytes = reinterpret_cast<const unsigned char*>(aligned.data());
+		}
+
+		if (!Validate(bytes, size)) return false;
+
+		this->Instantiate(bytes);
+		return true;
+	}
+
+	/**
+	* \brief Уничтожить форму
+	*/
+	void Form::Clear()
+	{
+		// Окно уничтожается первым: система уничтожает дочерние элементы вместе с ним,
+		// а объекты элементов после этого не обращаются ни к окну, ни к системе
+		this->window_.reset();
+		this->names_.clear();
+		this->controls_.clear();
+	}
+
+	/**
+	* \brief Получить окно
+	* \return Указатель на окно
+	*/
+	Window* Form::GetWindow() const
+	{
+		return this->window_.get();
+	}
+
+	/**
+	* \brief Найти элемент по имени
+	* \param name Имя
+	* \return Указатель на элемент
+	*/
+	ControlBase* Form::Find(std::string_view name) const
+	{
+		auto it = this->names_.find(name);
+		return it != this->names_.end() ? it->second : nullptr;
+	}
+
+	/**
+	* \brief Получить кол-во элементов
+	* \return Кол-во элементов
+	*/
+	size_t Form::GetControlCount() const
+	{
+		return this->controls_.size();
+	}
+}
@@ -0,0 +1,475 @@
+﻿/**
+* \brief Формы, загружаемые из бинарного описания (реализация компилятора текстового описания)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/gui/Form.h>
+
+namespace wquery
+{
+	/**
+	* \brief Лексема строки описания
+	*/
+	struct FormToken
+	{
+		std::string text;                      // Значение (строка без кавычек и с раскрытым экранированием)
+		bool quoted;                           // Была ли записана в кавычках
+	};
+
+	/**
+	* \brief Состояние компиляции
+	*/
+	class FormBuilder
+	{
+	private:
+		std::vector<FormFontRecord> fonts_;                        // Таблица шрифтов
+		std::vector<FormControlRecord> controls_;                  // Таблица элементов
+		std::string strings_;                                      // Таблица строк
+		std::unordered_map<std::string, std::uint32_t> offsets_;   // Смещения уже добавленных строк
+		std::unordered_map<std::string, std::uint32_t> fontNames_; // Номера шрифтов (+1) по именам
+		std::set<std::string> controlNames_;                       // Имена элементов
+		FormWindowRecord window_;                                  // Окно
+		bool hasWindow_;                                           // Встретилась ли команда window
+
+		std::vector<FormToken> tokens_;                            // Лексемы текущей строки
+		size_t position_;                                          // Номер следующей лексемы
+		std::string error_;                                        // Сообщение об ошибке текущей строки
+
+		/**
+		* \brief Разбить строку на лексемы
+		* \param line Строка
+		* \return Удалось ли разбить (нет незакрытых кавычек)
+		*/
+		bool Tokenize(std::string_view line)
+		{
+			this->tokens_.clear();
+			this->position_ = 0;
+
+			size_t i = 0;
+			while (i < line.size())
+			{
+				const char symbol = line[i];
+				if (symbol == ' ' || symbol == '\t' || symbol == '\r') { i++; continue; }
+				if (symbol == '#') break;
+
+				FormToken token = { std::string(), symbol == '"' };
+
+				if (token.quoted)
+				{
+					for (i++; i < line.size() && line[i] != '"'; i++)
+					{
+						if (line[i] == '\\' && i + 1 < line.size())
+						{
+							const char escaped = line[++i];
+							token.text.push_back(escaped == 'n' ? '\n' : (escaped == 't' ? '\t' : escaped));
+						}
+						else token.text.push_back(line[i]);
+					}
+
+					if (i >= line.size())
+					{
+						this->error_ = "unterminated string";
+						return false;
+					}
+					i++;
+				}
+				else
+				{
+					for (; i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r' && line[i] != '"' && line[i] != '#'; i++) {
+						token.text.push_back(line[i]);
+					}
+				}
+
+				this->tokens_.push_back(std::move(token));
+			}
+
+			return true;
+		}
+
+		/**
+		* \brief Остались ли лексемы
+		* \return Результат
+		*/
+		bool HasToken() const
+		{
+			return this->position_ < this->tokens_.size();
+		}
+
+		/**
+		* \brief Прочитать слово (лексему без кавычек)
+		* \param word Слово
+		* \return Удалось ли прочитать
+		*/
+		bool ReadWord(std::string& word)
+		{
+			if (!this->HasToken() || this->tokens_[this->position_].quoted)
+			{
+				this->error_ = "expected a name";
+				return false;
+			}
+			word = this->tokens_[this->position_++].text;
+			return true;
+		}
+
+		/**
+		* \brief Прочитать строку в кавычках
+		* \param text Строка
+		* \return Удалось ли прочитать
+		*/
+		bool ReadString(std::string& text)
+		{
+			if (!this->HasToken() || !this->tokens_[this->position_].quoted)
+			{
+				this->error_ = "expected a quoted string";
+				return false;
+			}
+			text = this->tokens_[this->position_++].text;
+			return true;
+		}
+
+		/**
+		* \brief Прочитать целое число
+		* \param value Число
+		* \param minimum Минимальное допустимое значение
+		* \param maximum Максимальное допустимое значение
+		* \return Удалось ли прочитать
+		*/
+		bool ReadInt(std::int32_t& value, long long minimum = -1000000, long long maximum = 1000000)
+		{
+			if (!this->HasToken() || this->tokens_[this->position_].quoted)
+			{
+				this->error_ = "expected a number";
+				return false;
+			}
+
+			const std::string& text = this->tokens_[this->position_].text;
+			char* end = nullptr;
+			const long long number = std::strtoll(text.c_str(), &end, 10);
+
+			if (text.empty() || *end != '\0' || number < minimum || number > maximum)
+			{
+				this->error_ = "invalid number '" + text + "'";
+				return false;
+			}
+
+			value = static_cast<std::int32_t>(number);
+			this->position_++;
+			return true;
+		}
+
+		/**
+		* \brief Прочитать пару чисел
+		* \param x Первое число
+		* \param y Второе число
+		* \param minimum Минимальное допустимое значение
+		* \return Удалось ли прочитать
+		*/
+		bool ReadPair(std::int32_t& x, std::int32_t& y, long long minimum = -1000000)
+		{
+			return this->ReadInt(x, minimum) && this->ReadInt(y, minimum);
+		}
+
+		/**
+		* \brief Добавить строку в таблицу строк (одинаковые строки хранятся один раз)
+		* \param text Строка
+		* \return Смещение строки
+		*/
+		std::uint32_t AddString(const std::string& text)
+		{
+			auto it = this->offsets_.find(text);
+			if (it != this->offsets_.end()) return it->second;
+
+			const std::uint32_t offset = static_cast<std::uint32_t>(this->strings_.size());
+			this->strings_.append(text.c_str(), text.size() + 1);
+			this->offsets_.emplace(text, offset);
+			return offset;
+		}
+
+		/**
+		* \brief Разобрать команду window
+		* \return Удалось ли разобрать
+		*/
+		bool ParseWindow()
+		{
+			if (this->hasWindow_)
+			{
+				this->error_ = "duplicate window";
+				return false;
+			}
+
+			std::string title;
+			if (!this->ReadString(title)) return false;
+			this->window_.title = this->AddString(title);
+			this->hasWindow_ = true;
+
+			while (this->HasToken())
+			{
+				std::string option;
+				if (!this->ReadWord(option)) return false;
+
+				if (option == "size") { if (!this->ReadPair(this->window_.width, this->window_.height, 0)) return false; }
+				else if (option == "min") { if (!this->ReadPair(this->window_.minWidth, this->window_.minHeight, 0)) return false; this->window_.flags |= FORM_FLAG_MIN_SIZE; }
+				else if (option == "max") { if (!this->ReadPair(this->window_.maxWidth, this->window_.maxHeight, 0)) return false; this->window_.flags |= FORM_FLAG_MAX_SIZE; }
+				else if (option == "position") { if (!this->ReadPair(this->window_.x, this->window_.y)) return false; this->window_.flags |= FORM_FLAG_POSITION; }
+				else if (option == "color")
+				{
+					std::int32_t r, g, b;
+					if (!this->ReadInt(r, 0, 255) || !this->ReadInt(g, 0, 255) || !this->ReadInt(b, 0, 255)) return false;
+					this->window_.bgColor = (static_cast<std::uint32_t>(r) << 16) | (static_cast<std::uint32_t>(g) << 8) | static_cast<std::uint32_t>(b);
+					this->window_.flags |= FORM_FLAG_BG_COLOR;
+				}
+				else if (option == "closes") this->window_.flags |= FORM_FLAG_CLOSES_PROGRAM;
+				else if (option == "hidden") this->window_.flags |= FORM_FLAG_HIDDEN;
+				else
+				{
+					this->error_ = "unknown window option '" + option + "'";
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/**
+		* \brief Разобрать команду font
+		* \return Удалось ли разобрать
+		*/
+		bool ParseFont()
+		{
+			std::string name, family;
+			std::int32_t size;
+			if (!this->ReadWord(name) || !this->ReadString(family) || !this->ReadInt(size, 1, 1000)) return false;
+
+			if (this->fontNames_.count(name))
+			{
+				this->error_ = "duplicate font '" + name + "'";
+				return false;
+			}
+
+			FormFontRecord font = { this->AddString(family), static_cast<std::uint32_t>(size), 0 };
+
+			while (this->HasToken())
+			{
+				std::string option;
+				if (!this->ReadWord(option)) return false;
+
+				if (option == "bold") font.flags |= FORM_FLAG_BOLD;
+				else if (option == "italic") font.flags |= FORM_FLAG_ITALIC;
+				else
+				{
+					this->error_ = "unknown font option '" + option + "'";
+					return false;
+				}
+			}
+
+			this->fonts_.push_back(font);
+			this->fontNames_.emplace(name, static_cast<std::uint32_t>(this->fonts_.size()));
+			return true;
+		}
+
+		/**
+		* \brief Разобрать команду элемента управления (button, textbox)
+		* \param type Тип элемента
+		* \return Удалось ли разобрать
+		*/
+		bool ParseControl(FormControlType type)
+		{
+			std::string name, text;
+			if (!this->ReadWord(name) || !this->ReadString(text)) return false;
+
+			if (name == "-") name.clear();
+			else if (!this->controlNames_.insert(name).second)
+			{
+				this->error_ = "duplicate control '" + name + "'";
+				return false;
+			}
+
+			FormControlRecord control = {};
+			control.type = type;
+			control.name = this->AddString(name);
+			control.text = this->AddString(text);
+			control.width = 150;
+			control.height = type == FORM_CONTROL_TEXTBOX ? 20 : 30;
+
+			while (this->HasToken())
+			{
+				std::string option;
+				if (!this->ReadWord(option)) return false;
+
+				if (option == "at") { if (!this->ReadPair(control.x, control.y)) return false; }
+				else if (option == "size") { if (!this->ReadPair(control.width, control.height, 0)) return false; }
+				else if (option == "disabled") control.flags |= FORM_FLAG_DISABLED;
+				else if (option == "hidden") control.flags |= FORM_FLAG_HIDDEN;
+				else if (option == "windowless") control.flags |= FORM_FLAG_WINDOWLESS;
+				else if (option == "password" && type == FORM_CONTROL_TEXTBOX) control.flags |= FORM_FLAG_PASSWORD;
+				else if (option == "document" && type == FORM_CONTROL_TEXTBOX) control.flags |= FORM_FLAG_DOCUMENT;
+				else if (option == "font")
+				{
+					std::string fontName;
+					if (!this->ReadWord(fontName)) return false;
+
+					auto it = this->fontNames_.find(fontName);
+					if (it == this->fontNames_.end())
+					{
+						this->error_ = "unknown font '" + fontName + "'";
+						return false;
+					}
+					control.font = it->second;
+				}
+				else if (option == "anchor")
+				{
+					// Стороны перечисляются до следующего параметра
+					while (this->HasToken() && !this->tokens_[this->position_].quoted)
+					{
+						const std::string& side = this->tokens_[this->position_].text;
+						if (side == "left") control.flags |= FORM_FLAG_ANCHOR_LEFT;
+						else if (side == "top") control.flags |= FORM_FLAG_ANCHOR_TOP;
+						else if (side == "right") control.flags |= FORM_FLAG_ANCHOR_RIGHT;
+						else if (side == "bottom") control.flags |= FORM_FLAG_ANCHOR_BOTTOM;
+						else break;
+						this->position_++;
+					}
+				}
+				else
+				{
+					this->error_ = "unknown control option '" + option + "'";
+					return false;
+				}
+			}
+
+			this->controls_.push_back(control);
+			return true;
+		}
+
+	public:
+		/**
+		* \brief Конструктор
+		*/
+		FormBuilder() :
+			window_({}),
+			hasWindow_(false),
+			position_(0)
+		{
+			// Первая строка таблицы - пустая (смещение 0)
+			this->AddString(std::string());
+			this->window_.width = 400;
+			this->window_.height = 300;
+		}
+
+		/**
+		* \brief Разобрать строку описания
+		* \param line Строка
+		* \return Удалось ли разобрать
+		*/
+		bool ParseLine(std::string_view line)
+		{
+			if (!this->Tokenize(line)) return false;
+			if (!this->HasToken()) return true;
+
+			std::string command;
+			if (!this->ReadWord(command))
+			{
+				this->error_ = "expected a command";
+				return false;
+			}
+
+			if (command == "window") return this->ParseWindow();
+			if (command == "font") return this->ParseFont();
+			if (command == "button") return this->ParseControl(FORM_CONTROL_BUTTON);
+			if (command == "textbox") return this->ParseControl(FORM_CONTROL_TEXTBOX);
+
+			this->error_ = "unknown command '" + command + "'";
+			return false;
+		}
+
+		/**
+		* \brief Собрать бинарное описание
+		* \param binary Бинарное описание
+		* \return Удалось ли собрать
+		*/
+		bool Build(std::vector<unsigned char>& binary)
+		{
+			if (!this->hasWindow_)
+			{
+				this->error_ = "missing window";
+				return false;
+			}
+
+			// Таблица строк дополняется нулями до границы 4 байт (последний байт остается нуль-терминатором)
+			while (this->strings_.size() % 4 != 0) this->strings_.push_back('\0');
+
+			const unsigned long long fontsSize = this->fonts_.size() * sizeof(FormFontRecord);
+			const unsigned long long controlsSize = this->controls_.size() * sizeof(FormControlRecord);
+			const unsigned long long total = sizeof(FormHeader) + fontsSize + controlsSize + this->strings_.size();
+
+			if (total > (std::numeric_limits<std::uint32_t>::max)())
+			{
+				this->error_ = "form is too large";
+				return false;
+			}
+
+			FormHeader header = {};
+			header.magic = FORM_MAGIC;
+			header.version = FORM_VERSION;
+			header.fileSize = static_cast<std::uint32_t>(total);
+			header.fontCount = static_cast<std::uint32_t>(this->fonts_.size());
+			header.controlCount = static_cast<std::uint32_t>(this->controls_.size());
+			header.fontsOffset = sizeof(FormHeader);
+			header.controlsOffset = static_cast<std::uint32_t>(header.fontsOffset + fontsSize);
+			header.stringsOffset = static_cast<std::uint32_t>(header.controlsOffset + controlsSize);
+			header.stringsSize = static_cast<std::uint32_t>(this->strings_.size());
+			header.window = this->window_;
+
+			binary.resize(static_cast<size_t>(total));
+			std::memcpy(binary.data(), &header, sizeof(header));
+			if (fontsSize) std::memcpy(binary.data() + header.fontsOffset, this->fonts_.data(), static_cast<size_t>(fontsSize));
+			if (controlsSize) std::memcpy(binary.data() + header.controlsOffset, this->controls_.data(), static_cast<size_t>(controlsSize));
+			std::memcpy(binary.data() + header.stringsOffset, this->strings_.data(), this->strings_.size());
+			return true;
+		}
+
+		/**
+		* \brief Получить сообщение об ошибке
+		* \return Сообщение
+		*/
+		const std::string& GetError() const
+		{
+			return this->error_;
+		}
+	};
+
+	/**
+	* \brief Скомпилировать текстовое описание формы в бинарное
+	* \param source Текстовое описание (UTF-8)
+	* \param binary Бинарное описание
+	* \param error Описание ошибки
+	* \return Удалось ли скомпилировать
+	*/
+	bool CompileForm(std::string_view source, std::vector<unsigned char>& binary, std::string& error)
+	{
+		FormBuilder builder;
+		size_t lineNumber = 0;
+
+		for (size_t start = 0; start <= source.size();)
+		{
+			const size_t end = (std::min)(source.find('\n', start), source.size());
+			lineNumber++;
+
+			if (!builder.ParseLine(source.substr(start, end - start)))
+			{
+				error = "line " + std::to_string(lineNumber) + ": " + builder.GetError();
+				return false;
+			}
+
+			start = end + 1;
+		}
+
+		if (!builder.Build(binary))
+		{
+			error = builder.GetError();
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,372 @@
+﻿/**
+* \brief Хранилище геометрии элементов управления окна (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/gui/GeometryStore.h>
+
+namespace wquery
+{
+	/**
+	* \brief Упаковать параметры привязки в битовую маску
+	* \param anchor Параметры привязки
+	* \return Маска (AnchorBits)
+	*/
+	unsigned char GeometryStore::PackAnchor(const AnchorSettings& anchor)
+	{
+		return static_cast<unsigned char>(
+			(anchor.left ? ANCHOR_LEFT : 0) |
+			(anchor.top ? ANCHOR_TOP : 0) |
+			(anchor.right ? ANCHOR_RIGHT : 0) |
+			(anchor.bottom ? ANCHOR_BOTTOM : 0));
+	}
+
+	/**
+	* \brief Распаковать битовую маску привязки
+	* \param bits Маска (AnchorBits)
+	* \return Параметры привязки
+	*/
+	AnchorSettings GeometryStore::UnpackAnchor(unsigned char bits)
+	{
+		return AnchorSettings(
+			(bits & ANCHOR_LEFT) != 0,
+			(bits & ANCHOR_TOP) != 0,
+			(bits & ANCHOR_RIGHT) != 0,
+			(bits & ANCHOR_BOTTOM) != 0);
+	}
+
+	/**
+	* \brief Добавить элемент
+	* \param owner Объект элемента
+	* \param hWnd Хендл элемента
+	* \param position Положение
+	* \param size Размеры
+	* \param flags Флаги (GeometryFlags)
+	* \return Идентификатор элемента
+	*/
+	unsigned int GeometryStore::Add(ControlBase* owner, HWND hWnd, const Vector2D<int>& position, const Vector2D<int>& size, unsigned char flags)
+	{
+		this->x_.push_back(position.X);
+		this->y_.push_back(position.Y);
+		this->width_.push_back(size.X);
+		this->height_.push_back(size.Y);
+		this->anchors_.push_back(0);
+		this->flags_.push_back(flags);
+		this->handles_.push_back(hWnd);
+		this->owners_.push_back(owner);
+
+		return static_cast<unsigned int>(this->owners_.size() - 1);
+	}
+
+	/**
+	* \brief Удалить элемент (место остается до уплотнения, идентификаторы не меняются)
+	* \param id Идентификатор элемента
+	*/
+	void GeometryStore::Remove(unsigned int id)
+	{
+		// Скрытое место без привязки не попадает ни в раскладку, ни в поиск по точке, ни в перерисовку
+		this->width_[id] = 0;
+		this->height_[id] = 0;
+		this->anchoredValid_ = this->anchoredValid_ && this->anchors_[id] == 0;
+		this->anchors_[id] = 0;
+		this->flags_[id] = GEOMETRY_HIDDEN | GEOMETRY_REMOVED;
+		this->handles_[id] = nullptr;
+		this->owners_[id] = nullptr;
+		this->removed_++;
+	}
+
+	/**
+	* \brief Уплотнить хранилище (порядок элементов сохраняется)
+	*/
+	void GeometryStore::Compact()
+	{
+		if (this->removed_ == 0) return;
+
+		size_t kept = 0;
+		for (size_t i = 0; i < this->owners_.size(); i++)
+		{
+			if (this->flags_[i] & GEOMETRY_REMOVED) continue;
+
+			this->x_[kept] = this->x_[i];
+			this->y_[kept] = this->y_[i];
+			this->width_[kept] = this->width_[i];
+			this->height_[kept] = this->height_[i];
+			this->anchors_[kept] = this->anchors_[i];
+			this->flags_[kept] = this->flags_[i];
+			this->handles_[kept] = this->handles_[i];
+			this->owners_[kept] = this->owners_[i];
+			kept++;
+		}
+
+		this->x_.resize(kept);
+		this->y_.resize(kept);
+		this->width_.resize(kept);
+		this->height_.resize(kept);
+		this->anchors_.resize(kept);
+		this->flags_.resize(kept);
+		this->handles_.resize(kept);
+		this->owners_.resize(kept);
+		this->removed_ = 0;
+		this->anchoredValid_ = false;
+	}
+
+	/**
+	* \brief Пересобрать списки элементов, привязанных к правой (нижней) стороне
+	*/
+	void GeometryStore::IndexAnchored()
+	{
+		for (std::vector<unsigned int>& list : this->anchored_) list.clear();
+
+		for (size_t i = 0; i < this->anchors_.size(); i++)
+		{
+			const unsigned char anchor = this->anchors_[i];
+			if (anchor & ANCHOR_RIGHT) this->anchored_[0].push_back(static_cast<unsigned int>(i));
+			if (anchor & ANCHOR_BOTTOM) this->anchored_[1].push_back(static_cast<unsigned int>(i));
+			if (anchor & (ANCHOR_RIGHT | ANCHOR_BOTTOM)) this->anchored_[2].push_back(static_cast<unsigned int>(i));
+		}
+
+		this->anchoredValid_ = true;
+	}
+
+	/**
+	* \brief Кол-во мест удаленных элементов (до уплотнения)
+	* \return Кол-во
+	*/
+	unsigned int GeometryStore::GetRemovedCount() const
+	{
+		return this->removed_;
+	}
+
+	/**
+	* \brief Кол-во элементов (включая места удаленных элементов)
+	* \return Кол-во
+	*/
+	unsigned int GeometryStore::GetCount() const
+	{
+		return static_cast<unsigned int>(this->owners_.size());
+	}
+
+	/**
+	* \brief Получить объект элемента
+	* \param id Идентификатор элемента
+	* \return Указатель на объект
+	*/
+	ControlBase* GeometryStore::GetOwner(unsigned int id) const
+	{
+		return this->owners_[id];
+	}
+
+	/**
+	* \brief Получить хендл элемента
+	* \param id Идентификатор элемента
+	* \return Хендл
+	*/
+	HWND GeometryStore::GetHandle(unsigned int id) const
+	{
+		return this->handles_[id];
+	}
+
+	/**
+	* \brief Установить хендл элемента
+	* \param id Идентификатор элемента
+	* \param hWnd Хендл
+	*/
+	void GeometryStore::SetHandle(unsigned int id, HWND hWnd)
+	{
+		this->handles_[id] = hWnd;
+	}
+
+	/**
+	* \brief Установить положение
+	* \param id Идентификатор элемента
+	* \param position Положение
+	*/
+	void GeometryStore::SetPosition(unsigned int id, const Vector2D<int>& position)
+	{
+		this->x_[id] = position.X;
+		this->y_[id] = position.Y;
+	}
+
+	/**
+	* \brief Получить положение
+	* \param id Идентификатор элемента
+	* \return Положение
+	*/
+	Vector2D<int> GeometryStore::GetPosition(unsigned int id) const
+	{
+		return { this->x_[id], this->y_[id] };
+	}
+
+	/**
+	* \brief Установить размеры
+	* \param id Идентификатор элемента
+	* \param size Размеры
+	*/
+	void GeometryStore::SetSize(unsigned int id, const Vector2D<int>& size)
+	{
+		this->width_[id] = size.X;
+		this->height_[id] = size.Y;
+	}
+
+	/**
+	* \brief Получить размеры
+	* \param id Идентификатор элемента
+	* \return Размеры
+	*/
+	Vector2D<int> GeometryStore::GetSize(unsigned int id) const
+	{
+		return { this->width_[id], this->height_[id] };
+	}
+
+	/**
+	* \brief Установить привязку
+	* \param id Идентификатор элемента
+	* \param anchor Параметры привязки
+	*/
+	void GeometryStore::SetAnchor(unsigned int id, const AnchorSettings& anchor)
+	{
+		const unsigned char bits = PackAnchor(anchor);
+		if ((bits ^ this->anchors_[id]) & (ANCHOR_RIGHT | ANCHOR_BOTTOM)) this->anchoredValid_ = false;
+		this->anchors_[id] = bits;
+	}
+
+	/**
+	* \brief Получить привязку
+	* \param id Идентификатор элемента
+	* \return Параметры привязки
+	*/
+	AnchorSettings GeometryStore::GetAnchor(unsigned int id) const
+	{
+		return UnpackAnchor(this->anchors_[id]);
+	}
+
+	/**
+	* \brief Установить или снять флаг
+	* \param id Идентификатор элемента
+	* \param flag Флаг (GeometryFlags)
+	* \param state Установить (true) или снять (false)
+	*/
+	void GeometryStore::SetFlag(unsigned int id, GeometryFlags flag, bool state)
+	{
+		if (state) this->flags_[id] |= static_cast<unsigned char>(flag);
+		else this->flags_[id] &= static_cast<unsigned char>(~flag);
+	}
+
+	/**
+	* \brief Установлен ли флаг
+	* \param id Идентификатор элемента
+	* \param flag Флаг (GeometryFlags)
+	* \return Состояние
+	*/
+	bool GeometryStore::HasFlag(unsigned int id, GeometryFlags flag) const
+	{
+		return (this->flags_[id] & flag) != 0;
+	}
+
+	/**
+	* \brief Пересчитать положения и размеры всех элементов при изменении размеров контейнера
+	* \param sizingDelta Изменение размеров клиентской области контейнера
+	* \param changed Массив, в который дописываются идентификаторы изменившихся элементов
+	* \return Кол-во изменившихся элементов
+	*/
+	size_t GeometryStore::Layout(const Vector2D<int>& sizingDelta, std::vector<unsigned int>& changed)
+	{
+		const size_t count = this->owners_.size();
+		const unsigned char * anchors = this->anchors_.data();
+
+		// Копии в локальных переменных: иначе компилятор обязан перечитывать их после каждой записи в массивы
+		const int deltaX = sizingDelta.X;
+		const int deltaY = sizingDelta.Y;
+
+		// Горизонталь и вертикаль обрабатываются отдельными проходами: каждый цикл читает маски привязки
+		// и изменяет только два массива, без ветвлений (хорошо векторизуется компилятором).
+		// Биты привязки превращаются в маски (0 или -1), которые выбирают прибавку: умножение на бит привязки
+		// в SSE2 не векторизуется одной инструкцией (нет 32-битного умножения)
+		if (deltaX != 0)
+		{
+			int * x = this->x_.data();
+			int * width = this->width_.data();
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const int left = -(anchors[i] & ANCHOR_LEFT);
+				const int shift = -((anchors[i] & ANCHOR_RIGHT) >> 2) & deltaX;
+
+				// Привязка к обеим сторонам растягивает элемент, привязка только к правой - перемещает
+				width[i] += shift & left;
+				x[i] += shift & ~left;
+			}
+		}
+
+		if (deltaY != 0)
+		{
+			int * y = this->y_.data();
+			int * height = this->height_.data();
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const int top = -((anchors[i] & ANCHOR_TOP) >> 1);
+				const int shift = -((anchors[i] & ANCHOR_BOTTOM) >> 3) & deltaY;
+
+				height[i] += shift & top;
+				y[i] += shift & ~top;
+			}
+		}
+
+		// Изменившимися считаются элементы, привязанные к правой (нижней) стороне по изменившейся оси -
+		// их списки не зависят от величины изменения и пересобираются только после изменения привязок
+		if (deltaX == 0 && deltaY == 0) return 0;
+		if (!this->anchoredValid_) this->IndexAnchored();
+
+		const std::vector<unsigned int>& anchored = this->anchored_[deltaY == 0 ? 0 : deltaX == 0 ? 1 : 2];
+		changed.insert(changed.end(), anchored.begin(), anchored.end());
+		return anchored.size();
+	}
+
+	/**
+	* \brief Найти видимый элемент, содержащий точку
+	* \param point Точка (в координатах клиентской области контейнера)
+	* \return Идентификатор элемента (-1 если не найден)
+	*/
+	int GeometryStore::HitTest(const Vector2D<int>& point) const
+	{
+		for (size_t i = this->owners_.size(); i-- > 0;)
+		{
+			if (this->flags_[i] & GEOMETRY_HIDDEN) continue;
+
+			if (point.X >= this->x_[i] && point.X < this->x_[i] + this->width_[i] &&
+				point.Y >= this->y_[i] && point.Y < this->y_[i] + this->height_[i])
+			{
+				return static_cast<int>(i);
+			}
+		}
+
+		return -1;
+	}
+
+	/**
+	* \brief Найти видимые элементы с заданными флагами, пересекающие прямоугольник
+	* \param rect Прямоугольник (в координатах клиентской области контейнера)
+	* \param flags Флаги, которые должны быть установлены у элемента (GeometryFlags)
+	* \param found Массив, в который дописываются идентификаторы
+	* \return Кол-во найденных элементов
+	*/
+	size_t GeometryStore::Intersect(const RECT& rect, unsigned char flags, std::vector<unsigned int>& found) const
+	{
+		const size_t before = found.size();
+		const unsigned char mask = static_cast<unsigned char>(flags | GEOMETRY_HIDDEN);
+
+		for (size_t i = 0; i < this->owners_.size(); i++)
+		{
+			if ((this->flags_[i] & mask) != flags) continue;
+
+			if (this->x_[i] < rect.right && this->x_[i] + this->width_[i] > rect.left &&
+				this->y_[i] < rect.bottom && this->y_[i] + this->height_[i] > rect.top)
+			{
+				found.push_back(static_cast<unsigned int>(i));
+			}
+		}
+
+		return found.size() - before;
+	}
+}
@@ -0,0 +1,556 @@
+﻿/**
+* \brief Класс элемента управления "таблица" с виртуализацией данных (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/gui/Grid.h>
+#include <wquery/tools/Canvas.h>
+
+#define GRID_SCROLLBAR_WIDTH 12
+#define GRID_SCROLLTHUMB_MIN 16
+#define GRID_CELL_PADDING 4
+#define GRID_WHEEL_ROWS 3
+
+namespace wquery
+{
+	/**
+	* \brief Начальное состояние таблицы (таблица всегда без системного окна)
+	* \param state Начальное состояние
+	* \return Состояние
+	*/
+	static ControlState GridState(ControlState state)
+	{
+		state.windowless = true;
+		return state;
+	}
+
+	/**
+	* \brief Начальное состояние таблицы по умолчанию (300x200 в левом верхнем углу)
+	* \return Состояние
+	*/
+	static ControlState GridDefaultState()
+	{
+		ControlState state;
+		state.size = { 300, 200 };
+		return GridState(state);
+	}
+
+	/**
+	* \brief Нарисовать текст ячейки (отсечение - пересечение ячейки без отступа справа и текущей области отсечения)
+	* \param canvas Холст
+	* \param clip Текущая область отсечения
+	* \param cell Прямоугольник ячейки
+	* \param text Текст
+	* \param font Шрифт
+	* \param textHeight Высота строки текста
+	* \param color Цвет
+	*/
+	static void DrawCell(Canvas& canvas, const RECT& clip, const RECT& cell, std::string_view text, const FontSettings& font, int textHeight, const ColorRGB& color)
+	{
+		if (text.empty()) return;
+
+		const RECT cellClip = {
+			(std::max)(cell.left, clip.left),
+			(std::max)(cell.top, clip.top),
+			(std::min)(cell.right - GRID_CELL_PADDING, clip.right),
+			(std::min)(cell.bottom, clip.bottom) };
+
+		if (cellClip.left >= cellClip.right || cellClip.top >= cellClip.bottom) return;
+
+		canvas.SetClip(cellClip);
+		canvas.DrawString(text, font, { cell.left + GRID_CELL_PADDING, cell.top + (cell.bottom - cell.top - textHeight) / 2 }, color);
+	}
+
+	/**
+	* \brief Конструктор
+	* \param window Владеющее окно
+	*/
+	Grid::Grid(Window * window) : Grid(window, GridDefaultState()) {}
+
+	/**
+	* \brief Конструктор с начальным состоянием
+	* \param window Владеющее окно
+	* \param state Начальное состояние
+	*/
+	Grid::Grid(Window * window, const ControlState& state) :
+		ControlBase(window, Grid::TypeTag(), "Static", WS_CHILD, GridState(state)),
+		rowCount_(0),
+		firstRow_(0),
+		selectedRow_(NO_ROW),
+		rowHeight_(20),
+		wheelRemainder_(0) {}
+
+	/**
+	* \brief Деструктор (унаследован от частично-вирутального)
+	*/
+	Grid::~Grid() = default;
+
+	/**
+	* \brief Получение имени класса (переопредление полного виртуального метода)
+	* \return Строка с именем класса
+	*/
+	std::string Grid::GetControlClassName()
+	{
+		return "Static";
+	}
+
+	/**
+	* \brief Получить тег типа (при первом вызове тип регистрируется)
+	* \return Тег типа
+	*/
+	unsigned int Grid::TypeTag()
+	{
+		static const unsigned int typeTag = ControlBase::RegisterControlType();
+		return typeTag;
+	}
+
+	/**
+	* \brief Получить строку из кольца (при отсутствии - запросить у источника данных)
+	* \param row Индекс строки
+	* \return Ячейка кольца
+	*/
+	const Grid::RowSlot& Grid::FetchRow(size_t row) const
+	{
+		RowSlot& slot = this->slots_[row % this->slots_.size()];
+
+		if (!slot.valid || slot.row != row)
+		{
+			// Строки ячеек очищаются без освобождения памяти - источник заполняет их заново
+			slot.cells.resize(this->columns_.size());
+			for (std::string& cell : slot.cells) cell.clear();
+
+			if (this->dataSource_) this->dataSource_(row, slot.cells);
+			slot.row = row;
+			slot.valid = true;
+		}
+
+		return slot;
+	}
+
+	/**
+	* \brief Сбросить заполненность кольца
+	*/
+	void Grid::InvalidateSlots() const
+	{
+		for (RowSlot& slot : this->slots_) slot.valid = false;
+	}
+
+	/**
+	* \brief Получить наибольшую первую видимую строку
+	* \return Индекс строки
+	*/
+	size_t Grid::GetMaxFirstRow() const
+	{
+		const int bodyHeight = this->GetSize().Y - 2 - this->rowHeight_;
+		const size_t fullRows = bodyHeight > 0 ? static_cast<size_t>(bodyHeight / this->rowHeight_) : 0;
+
+		if (this->rowCount_ == 0) return 0;
+		return this->rowCount_ > fullRows ? this->rowCount_ - (std::max)(fullRows, static_cast<size_t>(1)) : 0;
+	}
+
+	/**
+	* \brief Получить прямоугольник полосы прокрутки
+	* \param rect Прямоугольник таблицы
+	* \return Прямоугольник полосы
+	*/
+	RECT Grid::GetScrollBarRect(const RECT& rect) const
+	{
+		if (this->GetMaxFirstRow() == 0) return { rect.right - 1, rect.top, rect.right - 1, rect.top };
+		return { rect.right - 1 - GRID_SCROLLBAR_WIDTH, rect.top + 1 + this->rowHeight_, rect.right - 1, rect.bottom - 1 };
+	}
+
+	/**
+	* \brief Получить прямоугольник ползунка полосы прокрутки
+	* \details Положение считается в double - произведение кол-ва строк на высоту полосы может не поместиться в size_t
+	* \param bar Прямоугольник полосы
+	* \return Прямоугольник ползунка
+	*/
+	RECT Grid::GetScrollThumbRect(const RECT& bar) const
+	{
+		const int track = (std::max)(static_cast<int>(bar.bottom - bar.top), 0);
+		const size_t maxFirstRow = this->GetMaxFirstRow();
+		const double visibleRows = static_cast<double>(this->rowCount_ - maxFirstRow);
+
+		int thumb = static_cast<int>(track * visibleRows / static_cast<double>(this->rowCount_));
+		thumb = (std::min)((std::max)(thumb, GRID_SCROLLTHUMB_MIN), track);
+
+		const int offset = maxFirstRow > 0
+			? static_cast<int>((track - thumb) * (std::min)(static_cast<double>(this->firstRow_) / static_cast<double>(maxFirstRow), 1.0))
+			: 0;
+
+		return { bar.left + 2, bar.top + offset, bar.right - 2, bar.top + offset + thumb };
+	}
+
+	/**
+	* \brief Получить прямоугольник таблицы
+	* \return Прямоугольник
+	*/
+	RECT Grid::GetRect() const
+	{
+		const Vector2D<int> position = this->GetPosition();
+		const Vector2D<int> size = this->GetSize();
+		return { position.X, position.Y, position.X + size.X, position.Y + size.Y };
+	}
+
+	/**
+	* \brief Нарисовать видимые строки таблицы
+	* \param canvas Задний буфер окна
+	* \param rect Прямоугольник таблицы
+	*/
+	void Grid::PaintWindowless(Canvas& canvas, const RECT& rect) const
+	{
+		static thread_local std::string text;
+		FontSettings font;
+		this->GetPaintText(text, font);
+
+		const bool enabled = this->IsEnabled();
+		const ColorRGB textColor = enabled ? ColorRGB(0, 0, 0) : ColorRGB(109, 109, 109);
+		const ColorRGB lineColor(240, 240, 240);
+		const RECT clip = canvas.GetClip();
+		const RECT bar = this->GetScrollBarRect(rect);
+		const int textHeight = Canvas::MeasureString("0", font).Y;
+
+		canvas.FillRect(rect, enabled ? ColorRGB(255, 255, 255) : ColorRGB(240, 240, 240));
+
+		// Заголовок
+		const RECT header = { rect.left + 1, rect.top + 1, rect.right - 1, (std::min)(rect.top + 1 + this->rowHeight_, rect.bottom - 1) };
+		canvas.FillRect(header, ColorRGB(240, 240, 240));
+		canvas.DrawLine({ header.left, header.bottom - 1 }, { header.right - 1, header.bottom - 1 }, ColorRGB(213, 213, 213));
+
+		int x = header.left;
+		for (const GridColumn& column : this->columns_)
+		{
+			if (x >= header.right) break;
+			DrawCell(canvas, clip, { x, header.top, x + column.width, header.bottom }, column.title, font, textHeight, textColor);
+			x += column.width;
+		}
+		canvas.SetClip(clip);
+
+		// Кольцо пересоздается при изменении кол-ва видимых строк (меняется соответствие строк ячейкам)
+		const size_t visibleRows = this->GetVisibleRowCount();
+		if (this->slots_.size() != visibleRows)
+		{
+			this->slots_.resize(visibleRows);
+			this->InvalidateSlots();
+		}
+
+		// Строки - только пересекающие область отсечения (при частичной перерисовке запрашивается меньше строк)
+		const int bodyTop = header.bottom;
+		const int bodyBottom = rect.bottom - 1;
+		const int fromY = (std::max)(static_cast<int>(clip.top), bodyTop) - bodyTop;
+		const int toY = (std::min)(static_cast<int>(clip.bottom), bodyBottom) - bodyTop;
+
+		for (size_t i = fromY > 0 ? static_cast<size_t>(fromY / this->rowHeight_) : 0;
+			i < visibleRows && static_cast<int>(i) * this->rowHeight_ < toY; i++)
+		{
+			const size_t row = this->firstRow_ + i;
+			if (row >= this->rowCount_) break;
+
+			const int top = bodyTop + static_cast<int>(i) * this->rowHeight_;
+			const RECT rowRect = { rect.left + 1, top, bar.left, (std::min)(top + this->rowHeight_, bodyBottom) };
+
+			if (row == this->selectedRow_) canvas.FillRect(rowRect, enabled ? ColorRGB(204, 232, 255) : ColorRGB(217, 217, 217));
+			canvas.DrawLine({ rowRect.left, rowRect.bottom - 1 }, { rowRect.right - 1, rowRect.bottom - 1 }, lineColor);
+
+			const RowSlot& slot = this->FetchRow(row);
+			x = rowRect.left;
+			for (size_t c = 0; c < this->columns_.size() && x < rowRect.right; c++)
+			{
+				DrawCell(canvas, clip, { x, rowRect.top, x + this->columns_[c].width, rowRect.bottom }, slot.cells[c], font, textHeight, textColor);
+				x += this->columns_[c].width;
+			}
+			canvas.SetClip(clip);
+		}
+
+		// Разделители столбцов
+		x = rect.left + 1;
+		for (const GridColumn& column : this->columns_)
+		{
+			x += column.width;
+			if (x >= bar.left) break;
+			canvas.DrawLine({ x - 1, header.top }, { x - 1, bodyBottom - 1 }, lineColor);
+		}
+
+		// Полоса прокрутки
+		if (bar.left < bar.right)
+		{
+			canvas.FillRect(bar, ColorRGB(240, 240, 240));
+			canvas.FillRect(this->GetScrollThumbRect(bar), enabled ? ColorRGB(192, 192, 192) : ColorRGB(218, 218, 218));
+		}
+
+		canvas.DrawRect(rect, ColorRGB(122, 122, 122));
+	}
+
+	/**
+	* \brief Нажатие на таблицу
+	* \details Нажатие на полосу прокрутки выше или ниже ползунка переносит ползунок в точку нажатия
+	* (постраничная прокрутка миллионов строк бесполезна)
+	* \param message Сообщение мыши
+	*/
+	void Grid::HandleWindowlessMouse(UINT message)
+	{
+		if (message != WM_LBUTTONDOWN) return;
+
+		const Vector2D<int> point = this->window_->GetCursorPosition();
+		const RECT bar = this->GetScrollBarRect(this->GetRect());
+
+		if (point.X >= bar.left && point.X < bar.right && point.Y >= bar.top && point.Y < bar.bottom)
+		{
+			const RECT thumb = this->GetScrollThumbRect(bar);
+			if (point.Y >= thumb.top && point.Y < thumb.bottom) return;
+
+			const int range = (std::max)(static_cast<int>(bar.bottom - bar.top) - (thumb.bottom - thumb.top), 1);
+			const double position = static_cast<double>(point.Y - bar.top - (thumb.bottom - thumb.top) / 2) / range;
+			this->SetFirstRow(static_cast<size_t>((std::min)((std::max)(position, 0.0), 1.0) * static_cast<double>(this->GetMaxFirstRow())));
+			return;
+		}
+
+		const size_t row = this->GetRowAt(point);
+		if (row != NO_ROW && row != this->selectedRow_)
+		{
+			this->SetSelectedRow(row);
+			if (this->events.onSelectionChanged) this->events.onSelectionChanged();
+		}
+	}
+
+	/**
+	* \brief Прокрутка колесом мыши
+	* \param delta Величина прокрутки
+	*/
+	void Grid::HandleWindowlessWheel(int delta)
+	{
+		// Колеса с высоким разрешением присылают доли шага - они накапливаются
+		this->wheelRemainder_ += delta;
+		const int steps = this->wheelRemainder_ / WHEEL_DELTA;
+		this->wheelRemainder_ -= steps * WHEEL_DELTA;
+
+		if (steps != 0) this->ScrollBy(-static_cast<long long>(steps) * GRID_WHEEL_ROWS);
+	}
+
+	/**
+	* \brief Таблица рисуется только окном
+	* \return Статус
+	*/
+	bool Grid::IsWindowlessOnly() const
+	{
+		return true;
+	}
+
+	/**
+	* \brief Добавить столбец
+	* \param title Заголовок
+	* \param width Ширина
+	*/
+	void Grid::AddColumn(const std::string& title, int width)
+	{
+		this->columns_.push_back({ title, (std::max)(width, 0) });
+		this->Refresh();
+	}
+
+	/**
+	* \brief Удалить все столбцы
+	*/
+	void Grid::ClearColumns()
+	{
+		this->columns_.clear();
+		this->Refresh();
+	}
+
+	/**
+	* \brief Получить кол-во столбцов
+	* \return Кол-во
+	*/
+	size_t Grid::GetColumnCount() const
+	{
+		return this->columns_.size();
+	}
+
+	/**
+	* \brief Получить столбец
+	* \param index Индекс столбца
+	* \return Ссылка на столбец
+	*/
+	const GridColumn& Grid::GetColumn(size_t index) const
+	{
+		return this->columns_[index];
+	}
+
+	/**
+	* \brief Установить источник данных
+	* \param dataSource Источник данных
+	*/
+	void Grid::SetDataSource(GridDataSource dataSource)
+	{
+		this->dataSource_ = std::move(dataSource);
+		this->Refresh();
+	}
+
+	/**
+	* \brief Установить кол-во строк
+	* \param count Кол-во строк
+	*/
+	void Grid::SetRowCount(size_t count)
+	{
+		this->rowCount_ = count;
+		if (this->selectedRow_ != NO_ROW && this->selectedRow_ >= count) this->selectedRow_ = NO_ROW;
+		this->firstRow_ = (std::min)(this->firstRow_, this->GetMaxFirstRow());
+		this->Refresh();
+	}
+
+	/**
+	* \brief Получить кол-во строк
+	* \return Кол-во строк
+	*/
+	size_t Grid::GetRowCount() const
+	{
+		return this->rowCount_;
+	}
+
+	/**
+	* \brief Установить высоту строки
+	* \param height Высота
+	*/
+	void Grid::SetRowHeight(int height)
+	{
+		this->rowHeight_ = (std::max)(height, 1);
+		this->firstRow_ = (std::min)(this->firstRow_, this->GetMaxFirstRow());
+		this->Refresh();
+	}
+
+	/**
+	* \brief Получить высоту строки
+	* \return Высота
+	*/
+	int Grid::GetRowHeight() const
+	{
+		return this->rowHeight_;
+	}
+
+	/**
+	* \brief Получить кол-во видимых строк
+	* \return Кол-во строк
+	*/
+	size_t Grid::GetVisibleRowCount() const
+	{
+		const int bodyHeight = this->GetSize().Y - 2 - this->rowHeight_;
+		return bodyHeight > 0 ? static_cast<size_t>((bodyHeight + this->rowHeight_ - 1) / this->rowHeight_) : 0;
+	}
+
+	/**
+	* \brief Прокрутить таблицу так, чтобы строка была первой видимой
+	* \details Заполненные ячейки кольца сохраняются - будут запрошены только вновь открывшиеся строки
+	* \param row Индекс строки
+	*/
+	void Grid::SetFirstRow(size_t row)
+	{
+		row = (std::min)(row, this->GetMaxFirstRow());
+		if (row == this->firstRow_) return;
+
+		this->firstRow_ = row;
+		if (this->IsWindowless()) this->InvalidateWindowArea();
+	}
+
+	/**
+	* \brief Получить первую видимую строку
+	* \return Индекс строки
+	*/
+	size_t Grid::GetFirstRow() const
+	{
+		return this->firstRow_;
+	}
+
+	/**
+	* \brief Прокрутить таблицу на заданное кол-во строк
+	* \param rows Кол-во строк
+	*/
+	void Grid::ScrollBy(long long rows)
+	{
+		if (rows < 0)
+		{
+			const size_t up = static_cast<size_t>(-rows);
+			this->SetFirstRow(this->firstRow_ > up ? this->firstRow_ - up : 0);
+		}
+		else
+		{
+			const size_t maxFirstRow = this->GetMaxFirstRow();
+			const size_t down = maxFirstRow > this->firstRow_ ? (std::min)(static_cast<size_t>(rows), maxFirstRow - this->firstRow_) : 0;
+			this->SetFirstRow(this->firstRow_ + down);
+		}
+	}
+
+	/**
+	* \brief Прокрутить таблицу так, чтобы строка была видна
+	* \param row Индекс строки
+	*/
+	void Grid::ScrollTo(size_t row)
+	{
+		const int bodyHeight = this->GetSize().Y - 2 - this->rowHeight_;
+		const size_t fullRows = (std::max)(bodyHeight > 0 ? static_cast<size_t>(bodyHeight / this->rowHeight_) : 0, static_cast<size_t>(1));
+
+		if (row < this->firstRow_) this->SetFirstRow(row);
+		else if (row >= this->firstRow_ + fullRows) this->SetFirstRow(row - fullRows + 1);
+	}
+
+	/**
+	* \brief Выбрать строку
+	* \param row Индекс строки
+	*/
+	void Grid::SetSelectedRow(size_t row)
+	{
+		if (row != NO_ROW && row >= this->rowCount_) row = NO_ROW;
+		if (row == this->selectedRow_) return;
+
+		// Перерисовываются только строки прежнего и нового выбора (если они видны)
+		const size_t rows[2] = { this->selectedRow_, row };
+		this->selectedRow_ = row;
+
+		if (!this->IsWindowless()) return;
+
+		const RECT rect = this->GetRect();
+		const size_t visibleRows = this->GetVisibleRowCount();
+		for (size_t changed : rows)
+		{
+			if (changed == NO_ROW || changed < this->firstRow_ || changed >= this->firstRow_ + visibleRows) continue;
+
+			const int top = rect.top + 1 + this->rowHeight_ + static_cast<int>(changed - this->firstRow_) * this->rowHeight_;
+			this->window_->Invalidate({ rect.left, top, rect.right, (std::min)(top + this->rowHeight_, static_cast<int>(rect.bottom)) });
+		}
+	}
+
+	/**
+	* \brief Получить выбранную строку
+	* \return Индекс строки
+	*/
+	size_t Grid::GetSelectedRow() const
+	{
+		return this->selectedRow_;
+	}
+
+	/**
+	* \brief Получить строку в точке
+	* \param point Точка
+	* \return Индекс строки
+	*/
+	size_t Grid::GetRowAt(const Vector2D<int>& point) const
+	{
+		if (!this->window_) return NO_ROW;
+
+		const RECT rect = this->GetRect();
+		const RECT bar = this->GetScrollBarRect(rect);
+		const int bodyTop = rect.top + 1 + this->rowHeight_;
+
+		if (point.X <= rect.left || point.X >= bar.left || point.Y < bodyTop || point.Y >= rect.bottom - 1) return NO_ROW;
+
+		const size_t row = this->firstRow_ + static_cast<size_t>((point.Y - bodyTop) / this->rowHeight_);
+		return row < this->rowCount_ ? row : NO_ROW;
+	}
+
+	/**
+	* \brief Обновить таблицу
+	*/
+	void Grid::Refresh()
+	{
+		this->InvalidateSlots();
+		if (this->IsWindowless()) this->InvalidateWindowArea();
+	}
+}
@@ -0,0 +1,517 @@
+﻿/**
+* \brief Класс элемента управления "журнал" - просмотр потока строк (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/gui/LogView.h>
+#include <wquery/platform/Backend.h>
+#include <wquery/tools/Canvas.h>
+#include <wquery/wquery.h>
+
+#define LOG_VIEW_DEFAULT_LINES 50000
+#define LOG_VIEW_DEFAULT_BYTES (4 * 1024 * 1024)
+#define LOG_VIEW_LINE_LIMIT 1024
+#define LOG_VIEW_PADDING 3
+#define LOG_VIEW_WHEEL_LINES 3
+
+namespace wquery
+{
+	/**
+	* \brief Начальное состояние журнала (журнал всегда без системного окна)
+	* \param state Начальное состояние
+	* \return Состояние
+	*/
+	static ControlState LogViewState(ControlState state)
+	{
+		state.windowless = true;
+		return state;
+	}
+
+	/**
+	* \brief Начальное состояние журнала по умолчанию (300x200 в левом верхнем углу)
+	* \return Состояние
+	*/
+	static ControlState LogViewDefaultState()
+	{
+		ControlState state;
+		state.size = { 300, 200 };
+		return LogViewState(state);
+	}
+
+	/**
+	* \brief Конструктор
+	*/
+	LogView::Inbox::Inbox() :
+		drainPending(false),
+		pendingBytes(0),
+		maxPendingBytes(LOG_VIEW_DEFAULT_BYTES + LOG_VIEW_DEFAULT_LINES * sizeof(PendingLine)),
+		rejectedLines(0),
+		owner(nullptr)
+	{}
+
+	/**
+	* \brief Деструктор
+	*/
+	LogView::Inbox::~Inbox()
+	{
+		while (PendingLine* line = this->queue.Pop()) {
+			Free(line);
+		}
+	}
+
+	/**
+	* \brief Создать строку очереди
+	* \param text Текст
+	* \return Строка
+	*/
+	LogView::PendingLine* LogView::Inbox::Allocate(std::string_view text)
+	{
+		PendingLine* line = new (::operator new(sizeof(PendingLine) + text.length())) PendingLine;
+		line->length = text.length();
+		if (!text.empty()) memcpy(reinterpret_cast<char*>(line + 1), text.data(), text.length());
+		return line;
+	}
+
+	/**
+	* \brief Освободить строку очереди
+	* \param line Строка
+	*/
+	void LogView::Inbox::Free(PendingLine* line)
+	{
+		line->~PendingLine();
+		::operator delete(line);
+	}
+
+	/**
+	* \brief Конструктор
+	* \param window Владеющее окно
+	*/
+	LogView::LogView(Window * window) : LogView(window, LogViewDefaultState()) {}
+
+	/**
+	* \brief Конструктор с начальным состоянием
+	* \param window Владеющее окно
+	* \param state Начальное состояние
+	*/
+	LogView::LogView(Window * window, const ControlState& state) :
+		ControlBase(window, LogView::TypeTag(), "Static", WS_CHILD, LogViewState(state)),
+		text_(LOG_VIEW_DEFAULT_BYTES),
+		lines_(LOG_VIEW_DEFAULT_LINES),
+		firstEntry_(0),
+		lineCount_(0),
+		textStart_(0),
+		textUsed_(0),
+		totalLines_(0),
+		droppedLines_(0),
+		firstLine_(0),
+		pinned_(true),
+		wheelRemainder_(0),
+		inbox_(std::make_shared<Inbox>())
+	{
+		this->inbox_->owner = this;
+	}
+
+	/**
+	* \brief Деструктор
+	* \details Задача разбора, переданная до уничтожения, видит пустого владельца и ничего не делает
+	*/
+	LogView::~LogView()
+	{
+		this->inbox_->owner = nullptr;
+	}
+
+	/**
+	* \brief Получение имени класса (переопредление полного виртуального метода)
+	* \return Строка с именем класса
+	*/
+	std::string LogView::GetControlClassName()
+	{
+		return "Static";
+	}
+
+	/**
+	* \brief Получить тег типа (при первом вызове тип регистрируется)
+	* \return Тег типа
+	*/
+	unsigned int LogView::TypeTag()
+	{
+		static const unsigned int typeTag = ControlBase::RegisterControlType();
+		return typeTag;
+	}
+
+	/**
+	* \brief Перенести строку в кольца
+	* \param text Текст строки
+	* \param length Длина текста
+	* \return Кол-во вытесненных строк
+	*/
+	size_t LogView::StoreLine(const char* text, size_t length)
+	{
+		const size_t capacity = this->text_.size();
+		length = (std::min)(length, capacity);
+
+		// Самые старые строки вытесняются, пока не освободится запись и место для текста
+		size_t dropped = 0;
+		while (this->lineCount_ > 0 && (this->lineCount_ == this->lines_.size() || this->textUsed_ + length > capacity))
+		{
+			const LineEntry& oldest = this->lines_[this->firstEntry_];
+			this->textStart_ = (oldest.offset + oldest.length) % capacity;
+			this->textUsed_ -= oldest.length;
+			this->firstEntry_ = (this->firstEntry_ + 1) % this->lines_.size();
+			this->lineCount_--;
+			dropped++;
+		}
+
+		// Текст пишется за последней строкой, при необходимости - с переходом через конец кольца
+		const size_t offset = (this->textStart_ + this->textUsed_) % capacity;
+		const size_t head = (std::min)(length, capacity - offset);
+		memcpy(this->text_.data() + offset, text, head);
+		memcpy(this->text_.data(), text + head, length - head);
+
+		this->lines_[(this->firstEntry_ + this->lineCount_) % this->lines_.size()] = { offset, length };
+		this->lineCount_++;
+		this->textUsed_ += length;
+		this->totalLines_++;
+		this->droppedLines_ += dropped;
+		return dropped;
+	}
+
+	/**
+	* \brief Получить высоту строки
+	* \return Высота
+	*/
+	int LogView::GetLineHeight() const
+	{
+		FontSettings font;
+		GetBackend().GetFontSettings(this->customFont_ ? this->customFont_ : GetBackend().GetDefaultFont(), font);
+		return (std::max)(Canvas::MeasureString("0", font).Y, 1);
+	}
+
+	/**
+	* \brief Получить кол-во строк, видимых полностью
+	* \return Кол-во строк
+	*/
+	size_t LogView::GetPageLines() const
+	{
+		const int height = this->GetSize().Y - LOG_VIEW_PADDING * 2;
+		return static_cast<size_t>((std::max)(height / this->GetLineHeight(), 1));
+	}
+
+	/**
+	* \brief Получить наибольшую первую видимую строку
+	* \return Индекс строки
+	*/
+	size_t LogView::GetMaxFirstLine() const
+	{
+		const size_t pageLines = this->GetPageLines();
+		return this->lineCount_ > pageLines ? this->lineCount_ - pageLines : 0;
+	}
+
+	/**
+	* \brief Нарисовать видимые строки журнала
+	* \param canvas Задний буфер окна
+	* \param rect Прямоугольник журнала
+	*/
+	void LogView::PaintWindowless(Canvas& canvas, const RECT& rect) const
+	{
+		static thread_local std::string text;
+		FontSettings font;
+		this->GetPaintText(text, font);
+
+		const bool enabled = this->IsEnabled();
+		canvas.FillRect(rect, enabled ? ColorRGB(255, 255, 255) : ColorRGB(240, 240, 240));
+		canvas.DrawRect(rect, ColorRGB(122, 122, 122));
+
+		// Текст отсекается по внутренней части журнала
+		const RECT clip = canvas.GetClip();
+		const RECT inner = {
+			(std::max)(rect.left + 1, clip.left),
+			(std::max)(rect.top + 1, clip.top),
+			(std::min)(rect.right - 1, clip.right),
+			(std::min)(rect.bottom - 1, clip.bottom) };
+
+		if (inner.left >= inner.right || inner.top >= inner.bottom) return;
+		canvas.SetClip(inner);
+
+		const ColorRGB textColor = enabled ? ColorRGB(0, 0, 0) : ColorRGB(109, 109, 109);
+		const int lineHeight = this->GetLineHeight();
+		const int top = rect.top + LOG_VIEW_PADDING;
+
+		for (size_t i = inner.top > top ? static_cast<size_t>((inner.top - top) / lineHeight) : 0;
+			top + static_cast<int>(i) * lineHeight < inner.bottom; i++)
+		{
+			const size_t line = this->firstLine_ + i;
+			if (line >= this->lineCount_) break;
+
+			this->GetLine(line, text);
+			canvas.DrawString(text, font, { rect.left + LOG_VIEW_PADDING, top + static_cast<int>(i) * lineHeight }, textColor);
+		}
+
+		canvas.SetClip(clip);
+	}
+
+	/**
+	* \brief Прокрутка колесом мыши
+	* \param delta Величина прокрутки
+	*/
+	void LogView::HandleWindowlessWheel(int delta)
+	{
+		this->wheelRemainder_ += delta;
+		const int steps = this->wheelRemainder_ / WHEEL_DELTA;
+		this->wheelRemainder_ -= steps * WHEEL_DELTA;
+
+		if (steps > 0) this->SetFirstLine(this->firstLine_ - (std::min)(this->firstLine_, static_cast<size_t>(steps) * LOG_VIEW_WHEEL_LINES));
+		else if (steps < 0) this->SetFirstLine(this->firstLine_ + static_cast<size_t>(-steps) * LOG_VIEW_WHEEL_LINES);
+	}
+
+	/**
+	* \brief Прокрутка с клавиатуры
+	* \param message Сообщение
+	* \param code Код клавиши или символ
+	*/
+	void LogView::HandleWindowlessKey(UINT message, WPARAM code)
+	{
+		if (message != WM_KEYDOWN) return;
+
+		const size_t pageLines = this->GetPageLines();
+		switch (code)
+		{
+		case VK_UP: this->SetFirstLine(this->firstLine_ - (std::min)(this->firstLine_, static_cast<size_t>(1))); break;
+		case VK_DOWN: this->SetFirstLine(this->firstLine_ + 1); break;
+		case VK_PRIOR: this->SetFirstLine(this->firstLine_ - (std::min)(this->firstLine_, pageLines)); break;
+		case VK_NEXT: this->SetFirstLine(this->firstLine_ + pageLines); break;
+		case VK_HOME: this->SetFirstLine(0); break;
+		case VK_END: this->ScrollToEnd(); break;
+		default: break;
+		}
+	}
+
+	/**
+	* \brief Журнал рисуется только окном
+	* \return Статус
+	*/
+	bool LogView::IsWindowlessOnly() const
+	{
+		return true;
+	}
+
+	/**
+	* \brief Добавить строку (из любого потока, без блокировок)
+	* \param line Текст строки (UTF-8)
+	*/
+	void LogView::AppendLine(std::string_view line)
+	{
+		while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.remove_suffix(1);
+
+		if (line.length() > LOG_VIEW_LINE_LIMIT)
+		{
+			size_t length = LOG_VIEW_LINE_LIMIT;
+			while (length > 0 && (static_cast<unsigned char>(line[length]) & 0xC0) == 0x80) length--;
+			line = line.substr(0, length);
+		}
+
+		// Объем резервируется до выделения памяти строки: очередь не превышает предел и при многих производителях
+		const size_t size = sizeof(PendingLine) + line.length();
+		if (this->inbox_->pendingBytes.fetch_add(size, std::memory_order_relaxed) + size > this->inbox_->maxPendingBytes.load(std::memory_order_relaxed))
+		{
+			this->inbox_->pendingBytes.fetch_sub(size, std::memory_order_relaxed);
+			this->inbox_->rejectedLines.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		this->inbox_->queue.Push(Inbox::Allocate(line));
+
+		// Задачу разбора передает только производитель, первым установивший флаг (как в wquery::Post)
+		if (!this->inbox_->drainPending.exchange(true, std::memory_order_acq_rel))
+		{
+			std::shared_ptr<Inbox> inbox = this->inbox_;
+			Post([inbox]()
+			{
+				if (inbox->owner) inbox->owner->Flush();
+			});
+		}
+	}
+
+	/**
+	* \brief Разобрать входящую очередь немедленно
+	* \details Разбор только запрашивает перерисовку - она выполняется один раз за итерацию основного цикла
+	* (в цикле MainLoopType::FRAME_PACED - за кадр), сколько бы пакетов ни было разобрано
+	* \return Кол-во разобранных строк
+	*/
+	size_t LogView::Flush()
+	{
+		// Флаг снимается до разбора: строка, добавленная после этого, снова передаст задачу
+		this->inbox_->drainPending.exchange(false, std::memory_order_acq_rel);
+
+		const size_t firstLine = this->firstLine_;
+		size_t count = 0;
+		size_t dropped = 0;
+
+		while (PendingLine* line = this->inbox_->queue.Pop())
+		{
+			dropped += this->StoreLine(reinterpret_cast<const char*>(line + 1), line->length);
+			this->inbox_->pendingBytes.fetch_sub(sizeof(PendingLine) + line->length, std::memory_order_relaxed);
+			Inbox::Free(line);
+			count++;
+		}
+
+		// Строки, отброшенные при заполненной очереди, учитываются как принятые и вытесненные
+		const unsigned long long rejected = this->inbox_->rejectedLines.exchange(0, std::memory_order_relaxed);
+		this->totalLines_ += rejected;
+		this->droppedLines_ += rejected;
+
+		if (count == 0) return 0;
+
+		// Прикрепленный журнал прокручивается к последней строке, открепленный - остается на тех же строках
+		if (this->pinned_) this->firstLine_ = this->GetMaxFirstLine();
+		else this->firstLine_ -= (std::min)(this->firstLine_, dropped);
+
+		// Перерисовка нужна, если сдвинулись видимые строки или новые строки попали в видимую часть
+		const bool shifted = this->firstLine_ + dropped != firstLine;
+		const bool appearing = this->lineCount_ - (std::min)(count, this->lineCount_) <= this->firstLine_ + this->GetPageLines();
+		if (shifted || appearing) this->InvalidateWindowArea();
+
+		if (this->events.onLinesAppended) this->events.onLinesAppended(count);
+		return count;
+	}
+
+	/**
+	* \brief Установить емкость журнала
+	* \param maxLines Наибольшее кол-во строк
+	* \param maxBytes Объем кольца текста
+	*/
+	void LogView::SetCapacity(size_t maxLines, size_t maxBytes)
+	{
+		std::vector<std::string> lines(this->lineCount_);
+		for (size_t i = 0; i < this->lineCount_; i++) this->GetLine(i, lines[i]);
+
+		const unsigned long long totalLines = this->totalLines_;
+		const unsigned long long droppedLines = this->droppedLines_;
+
+		// Память колец освобождается полностью (а не только очищается)
+		std::vector<char>((std::max)(maxBytes, static_cast<size_t>(1))).swap(this->text_);
+		std::vector<LineEntry>((std::max)(maxLines, static_cast<size_t>(1))).swap(this->lines_);
+		this->inbox_->maxPendingBytes.store(this->text_.size() + this->lines_.size() * sizeof(PendingLine), std::memory_order_relaxed);
+		this->firstEntry_ = 0;
+		this->lineCount_ = 0;
+		this->textStart_ = 0;
+		this->textUsed_ = 0;
+
+		size_t dropped = 0;
+		for (const std::string& line : lines) dropped += this->StoreLine(line.data(), line.length());
+
+		this->totalLines_ = totalLines;
+		this->droppedLines_ = droppedLines + dropped;
+
+		if (this->pinned_) this->firstLine_ = this->GetMaxFirstLine();
+		else this->firstLine_ = (std::min)(this->firstLine_ - (std::min)(this->firstLine_, dropped), this->GetMaxFirstLine());
+		this->InvalidateWindowArea();
+	}
+
+	/**
+	* \brief Удалить все строки
+	*/
+	void LogView::Clear()
+	{
+		this->firstEntry_ = 0;
+		this->lineCount_ = 0;
+		this->textStart_ = 0;
+		this->textUsed_ = 0;
+		this->firstLine_ = 0;
+		this->pinned_ = true;
+		this->InvalidateWindowArea();
+	}
+
+	/**
+	* \brief Получить кол-во строк в журнале
+	* \return Кол-во строк
+	*/
+	size_t LogView::GetLineCount() const
+	{
+		return this->lineCount_;
+	}
+
+	/**
+	* \brief Получить строку
+	* \param index Индекс строки (0 - самая старая)
+	* \param text Строка для записи
+	*/
+	void LogView::GetLine(size_t index, std::string& text) const
+	{
+		text.clear();
+		if (index >= this->lineCount_) return;
+
+		const LineEntry& entry = this->lines_[(this->firstEntry_ + index) % this->lines_.size()];
+		const size_t head = (std::min)(entry.length, this->text_.size() - entry.offset);
+		text.append(this->text_.data() + entry.offset, head);
+		text.append(this->text_.data(), entry.length - head);
+	}
+
+	/**
+	* \brief Получить кол-во принятых строк
+	* \return Кол-во строк
+	*/
+	unsigned long long LogView::GetTotalLineCount() const
+	{
+		return this->totalLines_ + this->inbox_->rejectedLines.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* \brief Получить кол-во вытесненных строк
+	* \return Кол-во строк
+	*/
+	unsigned long long LogView::GetDroppedLineCount() const
+	{
+		return this->droppedLines_ + this->inbox_->rejectedLines.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* \brief Получить объем памяти журнала
+	* \return Объем
+	*/
+	size_t LogView::GetMemoryUsage() const
+	{
+		return this->text_.capacity() + this->lines_.capacity() * sizeof(LineEntry) + this->inbox_->pendingBytes.load(std::memory_order_relaxed);
+	}
+
+	/**
+	* \brief Прокрутить журнал так, чтобы строка была первой видимой
+	* \param line Индекс строки (ограничивается так, чтобы последняя строка была внизу)
+	*/
+	void LogView::SetFirstLine(size_t line)
+	{
+		const size_t maxFirstLine = this->GetMaxFirstLine();
+		line = (std::min)(line, maxFirstLine);
+		this->pinned_ = line == maxFirstLine;
+
+		if (line == this->firstLine_) return;
+		this->firstLine_ = line;
+		this->InvalidateWindowArea();
+	}
+
+	/**
+	* \brief Получить первую видимую строку
+	* \return Индекс строки
+	*/
+	size_t LogView::GetFirstLine() const
+	{
+		return this->firstLine_;
+	}
+
+	/**
+	* \brief Прокрутить журнал до последней строки и прикрепить к ней
+	*/
+	void LogView::ScrollToEnd()
+	{
+		this->SetFirstLine(this->GetMaxFirstLine());
+	}
+
+	/**
+	* \brief Прикреплен ли журнал к последней строке
+	* \return Статус
+	*/
+	bool LogView::IsPinned() const
+	{
+		return this->pinned_;
+	}
+}
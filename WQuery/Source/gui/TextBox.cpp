@@ -8,14 +8,79 @@
 
 #include <wquery/stdafx.h>
 #include <wquery/gui/TextBox.h>
+#include <wquery/platform/Backend.h>
+#include <wquery/tools/Canvas.h>
+#include <wquery/tools/utf.h>
+
+// Наибольшая длина выводимой части строки документа (байт UTF-8: несколько ширин экрана, дальше строка не видна,
+// а маска строки в кеше текста растет с длиной)
+#define TEXTBOX_DOCUMENT_LINE_LIMIT 1024
+
+// Отступ текста документа от рамки
+#define TEXTBOX_DOCUMENT_PADDING 3
 
 namespace wquery
 {
+	/**
+	* \brief Изменение текста в поле (EN_CHANGE)
+	* \param control Элемент управления
+	* \param wParam Параметр сообщения WM_COMMAND
+	* \param lParam Параметр сообщения WM_COMMAND
+	*/
+	static void TextBoxChangedNotification(ControlBase * control, WPARAM, LPARAM)
+	{
+		TextBox * pTextBox = static_cast<TextBox*>(control);
+
+		// Документ отмечает изменение сам при правке (до оповещения), системное поле - только здесь
+		if (pTextBox->GetMode() != TextBoxMode::DOCUMENT) pTextBox->MarkTextChanged();
+		if (pTextBox->events.onChanged) pTextBox->events.onChanged();
+	}
+
+	/**
+	* \brief Состояние поля в режиме документа (без системного окна, текст передается в документ, а не записывается)
+	* \param state Начальное состояние
+	* \return Состояние
+	*/
+	static ControlState DocumentState(const ControlState& state)
+	{
+		ControlState documentState = state;
+		documentState.text = std::string_view();
+		documentState.windowless = true;
+		return documentState;
+	}
+
 	/**
 	* \brief Конструктор
 	* \param window Владеющее окно
 	*/
-	TextBox::TextBox(Window * window) : ControlBase(window, "Edit", WS_CHILD | WS_VISIBLE | WS_BORDER, {150,20}) {}
+	TextBox::TextBox(Window * window) : ControlBase(window, TextBox::TypeTag(), "Edit", WS_CHILD | WS_VISIBLE | WS_BORDER, {150,20}),
+		firstLine_(0),
+		caret_(0),
+		wheelRemainder_(0),
+		highSurrogate_(0) {}
+
+	/**
+	* \brief Конструктор с начальным состоянием
+	* \param window Владеющее окно
+	* \param state Начальное состояние
+	*/
+	TextBox::TextBox(Window * window, const ControlState& state) : TextBox(window, state, TextBoxMode::EDIT) {}
+
+	/**
+	* \brief Конструктор с начальным состоянием и режимом
+	* \param window Владеющее окно
+	* \param state Начальное состояние
+	* \param mode Режим
+	*/
+	TextBox::TextBox(Window * window, const ControlState& state, TextBoxMode mode) :
+		ControlBase(window, TextBox::TypeTag(), "Edit", WS_CHILD | WS_BORDER, mode == TextBoxMode::DOCUMENT ? DocumentState(state) : state),
+		firstLine_(0),
+		caret_(0),
+		wheelRemainder_(0),
+		highSurrogate_(0)
+	{
+		if (mode == TextBoxMode::DOCUMENT) this->document_.reset(new PieceTable(state.text));
+	}
 
 	/**
 	* \brief Деструктор (унаследован от частично-вирутального)
@@ -31,25 +96,48 @@ namespace wquery
 		return "TextBox";
 	}
 
+	/**
+	* \brief Получить тег типа (при первом вызове тип регистрируется вместе с обработчиками уведомлений)
+	* \return Тег типа
+	*/
+	unsigned int TextBox::TypeTag()
+	{
+		static const unsigned int typeTag = []()
+		{
+			const unsigned int tag = ControlBase::RegisterControlType();
+			ControlBase::RegisterNotification(tag, EN_CHANGE, &TextBoxChangedNotification);
+			return tag;
+		}();
+
+		return typeTag;
+	}
+
+	/**
+	* \brief Дождаться изменения текста (в сопрограмме: co_await textBox->Changed())
+	* \return Ожидаемый объект (\see ControlBase::Notified)
+	*/
+	NotificationAwaiter TextBox::Changed()
+	{
+		return this->Notified(EN_CHANGE);
+	}
+
 	/**
 	* \brief Стиль поля для ввода пароля (да или нет)
 	* \param status Статус
 	*/
 	void TextBox::SetIsPassowrd(bool status) const
 	{
+		// До создания элемента стиль только записывается (символ пароля система назначит сама)
+		if (status) this->SetStyle(this->GetStyle() | ES_PASSWORD);
+		else this->SetStyle(this->GetStyle() & ~static_cast<DWORD>(ES_PASSWORD));
+		if (this->IsWindowless()) this->InvalidateWindowArea();
+
 		if(this->hWnd_)
 		{
-			if (status) {
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) | ES_PASSWORD);
-				SendMessage(this->hWnd_, EM_SETPASSWORDCHAR, '*', FALSE);
-			}
-			else {
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) ^ ES_PASSWORD);
-				SendMessage(this->hWnd_, EM_SETPASSWORDCHAR, NULL, FALSE);
-			}
+			GetBackend().Send(this->hWnd_, EM_SETPASSWORDCHAR, status ? '*' : 0, FALSE);
 
-			InvalidateRect(this->hWnd_, nullptr, TRUE);
-			UpdateWindow(this->hWnd_);
+			// Элемент перерисуется сам при обработке очереди сообщений (без немедленной перерисовки)
+			GetBackend().Invalidate(this->hWnd_, nullptr, TRUE);
 		}
 	}
 
@@ -59,9 +147,718 @@ namespace wquery
 	*/
 	bool TextBox::IsPassword() const
 	{
-		if (this->hWnd_)
-			return !!(GetWindowLong(this->hWnd_, GWL_STYLE) & ES_PASSWORD);
+		return !!(this->GetStyle() & ES_PASSWORD);
+	}
+
+	/**
+	* \brief Нарисовать поле без системного окна
+	* \param canvas Задний буфер окна
+	* \param rect Прямоугольник поля
+	*/
+	void TextBox::PaintWindowless(Canvas& canvas, const RECT& rect) const
+	{
+		static thread_local std::string text;
+		FontSettings font;
+		this->GetPaintText(text, font);
+
+		const bool enabled = this->IsEnabled();
+		const ColorRGB textColor = enabled ? ColorRGB(0, 0, 0) : ColorRGB(109, 109, 109);
+
+		if (this->document_)
+		{
+			canvas.FillRect(rect, enabled ? ColorRGB(255, 255, 255) : ColorRGB(240, 240, 240));
+			canvas.DrawRect(rect, ColorRGB(122, 122, 122));
+
+			// Текст отсекается по внутренней части поля
+			const RECT clip = canvas.GetClip();
+			const RECT inner = {
+				(std::max)(rect.left + 1, clip.left),
+				(std::max)(rect.top + 1, clip.top),
+				(std::min)(rect.right - 1, clip.right),
+				(std::min)(rect.bottom - 1, clip.bottom) };
+
+			if (inner.left >= inner.right || inner.top >= inner.bottom) return;
+			canvas.SetClip(inner);
+
+			// Из документа извлекаются только строки, пересекающие область отсечения
+			const int lineHeight = this->GetLineHeight();
+			const int top = rect.top + TEXTBOX_DOCUMENT_PADDING;
+			const int left = rect.left + TEXTBOX_DOCUMENT_PADDING;
+			const size_t lineCount = this->document_->GetLineCount();
+
+			for (size_t i = inner.top > top ? static_cast<size_t>((inner.top - top) / lineHeight) : 0;
+				top + static_cast<int>(i) * lineHeight < inner.bottom; i++)
+			{
+				const size_t line = this->firstLine_ + i;
+				if (line >= lineCount) break;
+
+				this->document_->GetLine(line, text, TEXTBOX_DOCUMENT_LINE_LIMIT);
+				canvas.DrawString(text, font, { left, top + static_cast<int>(i) * lineHeight }, textColor);
+			}
+
+			// Курсор - только у поля, получающего ввод с клавиатуры
+			if (this->HasWindowlessFocus())
+			{
+				const size_t caretLine = this->document_->GetLineAt(this->caret_);
+				if (caretLine >= this->firstLine_)
+				{
+					const size_t lineStart = this->document_->GetLineStart(caretLine);
+					this->document_->GetText(lineStart, (std::min)(this->caret_ - lineStart, static_cast<size_t>(TEXTBOX_DOCUMENT_LINE_LIMIT)), text);
+
+					const int x = left + Canvas::MeasureString(text, font).X;
+					const int y = top + static_cast<int>(caretLine - this->firstLine_) * lineHeight;
+					if (y < inner.bottom) canvas.DrawLine({ x, y }, { x, y + lineHeight - 1 }, textColor);
+				}
+			}
+
+			canvas.SetClip(clip);
+			return;
+		}
+
+		// Вместо текста пароля - по звездочке на каждый символ (байты продолжения UTF-8 не считаются)
+		if (this->IsPassword())
+		{
+			const size_t length = static_cast<size_t>(std::count_if(text.begin(), text.end(), [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }));
+			text.assign(length, '*');
+		}
+
+		canvas.FillRect(rect, enabled ? ColorRGB(255, 255, 255) : ColorRGB(240, 240, 240));
+		canvas.DrawRect(rect, ColorRGB(122, 122, 122));
+
+		const Vector2D<int> textSize = Canvas::MeasureString(text, font);
+		canvas.DrawString(text, font, { rect.left + 3, rect.top + (rect.bottom - rect.top - textSize.Y) / 2 }, textColor);
+	}
+
+	/**
+	* \brief Нажатие на поле без системного окна
+	* \param message Сообщение мыши
+	*/
+	void TextBox::HandleWindowlessMouse(UINT message)
+	{
+		if (message != WM_LBUTTONDOWN) return;
+
+		// Документ редактируется без системного окна - нажатие только переносит курсор (фокус назначает окно)
+		if (this->document_)
+		{
+			this->SetCaret(this->GetCaretAt(this->window_->GetCursorPosition()));
+			return;
+		}
+
+		// Системное поле ввода нужно только для редактирования - оно создается на месте элемента и получает фокус
+		HWND hWnd = this->GetNativeHandle();
+		if (hWnd) GetBackend().SetFocus(hWnd);
+	}
+
+	/**
+	* \brief Прокрутка документа колесом мыши
+	* \param delta Величина прокрутки
+	*/
+	void TextBox::HandleWindowlessWheel(int delta)
+	{
+		if (!this->document_) return;
+
+		this->wheelRemainder_ += delta;
+		const int lines = this->wheelRemainder_ / WHEEL_DELTA * 3;
+		this->wheelRemainder_ %= WHEEL_DELTA;
+		if (lines == 0) return;
 
-		return false;
+		if (lines < 0) this->SetFirstLine(this->firstLine_ + static_cast<size_t>(-lines));
+		else this->SetFirstLine(this->firstLine_ > static_cast<size_t>(lines) ? this->firstLine_ - static_cast<size_t>(lines) : 0);
+	}
+
+	/**
+	* \brief Ввод с клавиатуры в документ
+	* \details Символы приходят в WM_CHAR (Backspace, Enter и Tab - тоже символами), клавиши перемещения
+	* курсора и Delete - в WM_KEYDOWN. Перевод строки вставляется как "\r\n" (как в системном поле ввода)
+	* \param message Сообщение
+	* \param code Код клавиши или символ
+	*/
+	void TextBox::HandleWindowlessKey(UINT message, WPARAM code)
+	{
+		if (!this->document_) return;
+
+		if (message == WM_CHAR)
+		{
+			const char16_t unit = static_cast<char16_t>(code);
+
+			if (unit == VK_BACK)
+			{
+				const size_t from = this->StepBack(this->caret_);
+				if (from < this->caret_) this->EraseText(from, this->caret_ - from);
+			}
+			else if (unit == VK_RETURN)
+			{
+				this->InsertText(this->caret_, "\r\n");
+			}
+			else if (unit >= 0xD800 && unit < 0xDC00)
+			{
+				// Символ вне BMP приходит двумя сообщениями - вставляется после второй половины пары
+				this->highSurrogate_ = unit;
+				return;
+			}
+			else if ((unit >= 0x20 && unit != 0x7F) || unit == VK_TAB)
+			{
+				char16_t units[2];
+				size_t count = 0;
+
+				if (unit >= 0xDC00 && unit < 0xE000)
+				{
+					if (!this->highSurrogate_) return;
+					units[count++] = this->highSurrogate_;
+				}
+				units[count++] = unit;
+				this->highSurrogate_ = 0;
+
+				char utf8[8];
+				const size_t length = Utf16ToUtf8(units, count, utf8);
+				if (length == UTF_INVALID) return;
+				this->InsertText(this->caret_, std::string_view(utf8, length));
+			}
+			else return;
+
+			this->EnsureCaretVisible();
+			return;
+		}
+
+		if (message != WM_KEYDOWN) return;
+
+		const size_t line = this->document_->GetLineAt(this->caret_);
+		size_t targetLine = line;
+
+		switch (code)
+		{
+		case VK_LEFT:
+			this->SetCaret(this->StepBack(this->caret_));
+			return;
+		case VK_RIGHT:
+			this->SetCaret(this->StepForward(this->caret_));
+			return;
+		case VK_HOME:
+			this->SetCaret(this->document_->GetLineStart(line));
+			return;
+		case VK_END:
+			this->SetCaret(this->GetLineEnd(line));
+			return;
+		case VK_DELETE:
+		{
+			const size_t to = this->StepForward(this->caret_);
+			if (to > this->caret_) this->EraseText(this->caret_, to - this->caret_);
+			this->EnsureCaretVisible();
+			return;
+		}
+		case VK_UP:
+			targetLine = line > 0 ? line - 1 : 0;
+			break;
+		case VK_DOWN:
+			targetLine = line + 1;
+			break;
+		case VK_PRIOR:
+			targetLine = line > this->GetPageLines() ? line - this->GetPageLines() : 0;
+			this->SetFirstLine(this->firstLine_ > this->GetPageLines() ? this->firstLine_ - this->GetPageLines() : 0);
+			break;
+		case VK_NEXT:
+			targetLine = line + this->GetPageLines();
+			this->SetFirstLine(this->firstLine_ + this->GetPageLines());
+			break;
+		default:
+			return;
+		}
+
+		// Вертикальное перемещение сохраняет смещение от начала строки (в пределах целевой строки)
+		targetLine = (std::min)(targetLine, this->document_->GetLineCount() - 1);
+		if (targetLine == line) return;
+
+		const size_t targetStart = this->document_->GetLineStart(targetLine);
+		this->SetCaret((std::min)(targetStart + (this->caret_ - this->document_->GetLineStart(line)), this->GetLineEnd(targetLine)));
+	}
+
+	/**
+	* \brief Документ рисуется только окном
+	* \return Статус
+	*/
+	bool TextBox::IsWindowlessOnly() const
+	{
+		return this->document_ != nullptr;
+	}
+
+	/**
+	* \brief Заменить участок текста документа
+	* \details Курсор после участка сдвигается вместе с текстом, курсор внутри удаленного участка переносится
+	* в его начало. Если кол-во строк не изменилось, перерисовывается только строка правки
+	* \param position Смещение участка
+	* \param length Длина участка
+	* \param text Новый текст участка
+	*/
+	void TextBox::ReplaceDocumentText(size_t position, size_t length, std::string_view text)
+	{
+		const size_t total = this->document_->GetLength();
+		position = (std::min)(position, total);
+		length = (std::min)(length, total - position);
+
+		const size_t lineCount = this->document_->GetLineCount();
+		const size_t line = this->document_->GetLineAt(position);
+
+		this->document_->Erase(position, length);
+		this->document_->Insert(position, text);
+		this->MarkTextChanged();
+
+		if (this->caret_ >= position + length) this->caret_ = this->caret_ - length + text.length();
+		else if (this->caret_ > position) this->caret_ = position;
+		this->firstLine_ = (std::min)(this->firstLine_, this->document_->GetLineCount() - 1);
+
+		const bool singleLine = lineCount == this->document_->GetLineCount() && text.find('\n') == std::string_view::npos;
+		this->InvalidateLines(line, singleLine ? line + 1 : SIZE_MAX);
+
+		this->NotifyEdited({ position, length, text.length() });
+	}
+
+	/**
+	* \brief Получить высоту строки документа
+	* \return Высота
+	*/
+	int TextBox::GetLineHeight() const
+	{
+		FontSettings font;
+		GetBackend().GetFontSettings(this->customFont_ ? this->customFont_ : GetBackend().GetDefaultFont(), font);
+		return (std::max)(Canvas::MeasureString("0", font).Y, 1);
+	}
+
+	/**
+	* \brief Получить кол-во строк документа, видимых полностью
+	* \return Кол-во строк
+	*/
+	size_t TextBox::GetPageLines() const
+	{
+		const int height = this->GetSize().Y - TEXTBOX_DOCUMENT_PADDING * 2;
+		return static_cast<size_t>((std::max)(height / this->GetLineHeight(), 1));
+	}
+
+	/**
+	* \brief Получить конец строки документа
+	* \param line Номер строки
+	* \return Смещение
+	*/
+	size_t TextBox::GetLineEnd(size_t line) const
+	{
+		if (line + 1 >= this->document_->GetLineCount()) return this->document_->GetLength();
+
+		const size_t start = this->document_->GetLineStart(line);
+		size_t end = this->document_->GetLineStart(line + 1) - 1;
+		if (end > start && this->document_->GetChar(end - 1) == '\r') end--;
+		return end;
+	}
+
+	/**
+	* \brief Получить предыдущее положение курсора
+	* \param position Положение
+	* \return Предыдущее положение
+	*/
+	size_t TextBox::StepBack(size_t position) const
+	{
+		if (position == 0) return 0;
+
+		size_t previous = position - 1;
+		if (this->document_->GetChar(previous) == '\n' && previous > 0 && this->document_->GetChar(previous - 1) == '\r') return previous - 1;
+
+		while (previous > 0 && (static_cast<unsigned char>(this->document_->GetChar(previous)) & 0xC0) == 0x80) previous--;
+		return previous;
+	}
+
+	/**
+	* \brief Получить следующее положение курсора
+	* \param position Положение
+	* \return Следующее положение
+	*/
+	size_t TextBox::StepForward(size_t position) const
+	{
+		const size_t length = this->document_->GetLength();
+		if (position >= length) return length;
+
+		if (this->document_->GetChar(position) == '\r' && position + 1 < length && this->document_->GetChar(position + 1) == '\n') return position + 2;
+
+		size_t next = position + 1;
+		while (next < length && (static_cast<unsigned char>(this->document_->GetChar(next)) & 0xC0) == 0x80) next++;
+		return next;
+	}
+
+	/**
+	* \brief Получить положение курсора в точке
+	* \details Ширина начала строки растет с кол-вом символов, поэтому ближайшая к точке граница символов
+	* ищется двоичным поиском (измеряется O(log n) начал видимой части строки)
+	* \param point Точка (в координатах клиентской области окна)
+	* \return Положение
+	*/
+	size_t TextBox::GetCaretAt(const Vector2D<int>& point) const
+	{
+		static thread_local std::string text;
+		static thread_local std::vector<size_t> boundaries;
+
+		FontSettings font;
+		this->GetPaintText(text, font);
+
+		const Vector2D<int> position = this->GetPosition();
+		const int lineHeight = this->GetLineHeight();
+		const int y = point.Y - position.Y - TEXTBOX_DOCUMENT_PADDING;
+		const size_t line = (std::min)(this->firstLine_ + static_cast<size_t>(y > 0 ? y / lineHeight : 0), this->document_->GetLineCount() - 1);
+
+		this->document_->GetLine(line, text, TEXTBOX_DOCUMENT_LINE_LIMIT);
+
+		boundaries.clear();
+		for (size_t i = 0; i <= text.length(); i++)
+		{
+			if (i == text.length() || (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) boundaries.push_back(i);
+		}
+
+		// Последняя граница, начало строки до которой не шире точки
+		const int x = point.X - position.X - TEXTBOX_DOCUMENT_PADDING;
+		size_t low = 0;
+		size_t high = boundaries.size() - 1;
+		while (low < high)
+		{
+			const size_t middle = (low + high + 1) / 2;
+			if (Canvas::MeasureString(std::string_view(text.data(), boundaries[middle]), font).X <= x) low = middle;
+			else high = middle - 1;
+		}
+
+		// Ближайшая из двух соседних границ
+		if (low + 1 < boundaries.size())
+		{
+			const int before = Canvas::MeasureString(std::string_view(text.data(), boundaries[low]), font).X;
+			const int after = Canvas::MeasureString(std::string_view(text.data(), boundaries[low + 1]), font).X;
+			if (after - x < x - before) low++;
+		}
+
+		return this->document_->GetLineStart(line) + boundaries[low];
+	}
+
+	/**
+	* \brief Запросить перерисовку строк документа
+	* \param from Первая строка
+	* \param to Строка за последней
+	*/
+	void TextBox::InvalidateLines(size_t from, size_t to) const
+	{
+		if (!this->IsWindowless() || to <= this->firstLine_) return;
+
+		const Vector2D<int> position = this->GetPosition();
+		const Vector2D<int> size = this->GetSize();
+		const int lineHeight = this->GetLineHeight();
+		const size_t visible = static_cast<size_t>(size.Y / lineHeight) + 1;
+
+		from = (std::max)(from, this->firstLine_) - this->firstLine_;
+		if (from > visible) return;
+
+		RECT rect = { position.X, position.Y + TEXTBOX_DOCUMENT_PADDING + static_cast<int>(from) * lineHeight, position.X + size.X, position.Y + size.Y };
+		if (to - this->firstLine_ <= visible)
+		{
+			rect.bottom = (std::min)(rect.bottom, position.Y + TEXTBOX_DOCUMENT_PADDING + static_cast<int>(to - this->firstLine_) * lineHeight);
+		}
+
+		if (rect.top < rect.bottom) this->window_->Invalidate(rect);
+	}
+
+	/**
+	* \brief Прокрутить документ так, чтобы курсор был виден
+	*/
+	void TextBox::EnsureCaretVisible()
+	{
+		const size_t line = this->document_->GetLineAt(this->caret_);
+		const size_t pageLines = this->GetPageLines();
+
+		if (line < this->firstLine_) this->SetFirstLine(line);
+		else if (line >= this->firstLine_ + pageLines) this->SetFirstLine(line - pageLines + 1);
+	}
+
+	/**
+	* \brief Оповестить о правке
+	* \param edit Правка
+	*/
+	void TextBox::NotifyEdited(const TextEdit& edit)
+	{
+		if (this->events.onEdited) this->events.onEdited(edit);
+		ControlBase::DispatchNotification(this, MAKEWPARAM(0, EN_CHANGE), 0);
+	}
+
+	/**
+	* \brief Установить текст
+	* \param text Текст
+	*/
+	void TextBox::SetText(const std::string& text) const
+	{
+		this->SetText(std::string_view(text));
+	}
+
+	/**
+	* \brief Установить текст
+	* \param text Текст (нуль-терминированная строка)
+	*/
+	void TextBox::SetText(const char* text) const
+	{
+		if (this->document_) const_cast<TextBox*>(this)->ReplaceDocumentText(0, this->document_->GetLength(), text ? text : "");
+		else ControlBase::SetText(text);
+	}
+
+	/**
+	* \brief Установить текст
+	* \param text Текст (представление строки)
+	*/
+	void TextBox::SetText(std::string_view text) const
+	{
+		if (this->document_) const_cast<TextBox*>(this)->ReplaceDocumentText(0, this->document_->GetLength(), text);
+		else ControlBase::SetText(text);
+	}
+
+	/**
+	* \brief Установить текст
+	* \param text Текст в UTF-16
+	*/
+	void TextBox::SetText(std::u16string_view text) const
+	{
+		if (!this->document_)
+		{
+			ControlBase::SetText(text);
+			return;
+		}
+
+		static thread_local std::string utf8;
+		Utf16ToUtf8(text, utf8);
+		const_cast<TextBox*>(this)->ReplaceDocumentText(0, this->document_->GetLength(), utf8);
+	}
+
+	/**
+	* \brief Получить текст
+	* \return Текст
+	*/
+	std::string TextBox::GetText() const
+	{
+		std::string result;
+		this->GetText(result);
+		return result;
+	}
+
+	/**
+	* \brief Получить текст в существующую строку
+	* \param text Строка для записи
+	*/
+	void TextBox::GetText(std::string& text) const
+	{
+		if (this->document_) this->document_->GetText(text);
+		else ControlBase::GetText(text);
+	}
+
+	/**
+	* \brief Получить текст в существующую UTF-16 строку
+	* \param text Строка для записи
+	*/
+	void TextBox::GetText(std::u16string& text) const
+	{
+		if (!this->document_)
+		{
+			ControlBase::GetText(text);
+			return;
+		}
+
+		static thread_local std::string utf8;
+		this->document_->GetText(utf8);
+		Utf8ToUtf16(utf8, text);
+	}
+
+	/**
+	* \brief Получить текст в буфер
+	* \param buffer Буфер
+	* \param capacity Размер буфера
+	* \return Кол-во записанных байт (без нуль-терминатора)
+	*/
+	size_t TextBox::GetText(char* buffer, size_t capacity) const
+	{
+		if (!this->document_ || capacity == 0) return ControlBase::GetText(buffer, capacity);
+
+		// Из документа читается только помещающийся в буфер участок. Если он обрезан внутри символа UTF-8
+		// (следующий байт - продолжение последовательности), конец переносится на начало этого символа
+		size_t length = (std::min)(capacity - 1, this->document_->GetLength());
+		if (length < this->document_->GetLength())
+		{
+			while (length > 0 && (static_cast<unsigned char>(this->document_->GetChar(length)) & 0xC0) == 0x80) length--;
+		}
+
+		static thread_local std::string text;
+		this->document_->GetText(0, length, text);
+		memcpy(buffer, text.data(), text.length());
+		buffer[text.length()] = 0;
+		return text.length();
+	}
+
+	/**
+	* \brief Получить текст в UTF-16 буфер
+	* \param buffer Буфер
+	* \param capacity Размер буфера
+	* \return Кол-во записанных символов (без нуль-терминатора)
+	*/
+	size_t TextBox::GetText(char16_t* buffer, size_t capacity) const
+	{
+		if (!this->document_ || capacity == 0) return ControlBase::GetText(buffer, capacity);
+
+		static thread_local std::u16string text;
+		this->GetText(text);
+		const size_t length = (std::min)(text.length(), capacity - 1);
+		memcpy(buffer, text.data(), length * sizeof(char16_t));
+		buffer[length] = 0;
+		return length;
+	}
+
+	/**
+	* \brief Получить длину текста
+	* \return Длина (без нуль-терминатора)
+	*/
+	size_t TextBox::GetTextLength() const
+	{
+		return this->document_ ? this->document_->GetLength() : ControlBase::GetTextLength();
+	}
+
+	/**
+	* \brief Получить режим поля
+	* \return Режим
+	*/
+	TextBoxMode TextBox::GetMode() const
+	{
+		return this->document_ ? TextBoxMode::DOCUMENT : TextBoxMode::EDIT;
+	}
+
+	/**
+	* \brief Получить документ
+	* \return Указатель на документ (nullptr - поле не в режиме документа)
+	*/
+	const PieceTable* TextBox::GetDocument() const
+	{
+		return this->document_.get();
+	}
+
+	/**
+	* \brief Вставить текст
+	* \param position Смещение
+	* \param text Текст
+	*/
+	void TextBox::InsertText(size_t position, std::string_view text)
+	{
+		if (this->document_)
+		{
+			this->ReplaceDocumentText(position, 0, text);
+			return;
+		}
+
+		std::string content;
+		this->GetText(content);
+		content.insert((std::min)(position, content.length()), text);
+		this->SetText(content);
+	}
+
+	/**
+	* \brief Удалить участок текста
+	* \param position Смещение
+	* \param length Длина
+	*/
+	void TextBox::EraseText(size_t position, size_t length)
+	{
+		if (this->document_)
+		{
+			this->ReplaceDocumentText(position, length, std::string_view());
+			return;
+		}
+
+		std::string content;
+		this->GetText(content);
+		if (position >= content.length()) return;
+		content.erase(position, length);
+		this->SetText(content);
+	}
+
+	/**
+	* \brief Дописать текст в конец
+	* \param text Текст
+	*/
+	void TextBox::AppendText(std::string_view text)
+	{
+		this->InsertText(SIZE_MAX, text);
+	}
+
+	/**
+	* \brief Заменить весь текст
+	* \param text Текст
+	*/
+	void TextBox::LoadText(std::string&& text)
+	{
+		if (!this->document_)
+		{
+			this->SetText(text);
+			return;
+		}
+
+		const TextEdit edit = { 0, this->document_->GetLength(), text.length() };
+		this->document_->Assign(std::move(text));
+		this->MarkTextChanged();
+
+		this->caret_ = 0;
+		this->firstLine_ = 0;
+		if (this->IsWindowless()) this->InvalidateWindowArea();
+
+		this->NotifyEdited(edit);
+	}
+
+	/**
+	* \brief Установить положение курсора документа
+	* \param position Смещение (внутри символа UTF-8 или пары "\r\n" - переносится на его начало)
+	*/
+	void TextBox::SetCaret(size_t position)
+	{
+		if (!this->document_) return;
+
+		position = (std::min)(position, this->document_->GetLength());
+		if (position > 0 && position < this->document_->GetLength())
+		{
+			if (this->document_->GetChar(position) == '\n' && this->document_->GetChar(position - 1) == '\r') position--;
+			while (position > 0 && (static_cast<unsigned char>(this->document_->GetChar(position)) & 0xC0) == 0x80) position--;
+		}
+
+		// Перерисовываются строки старого и нового положения курсора
+		const size_t oldLine = this->document_->GetLineAt(this->caret_);
+		this->caret_ = position;
+		const size_t newLine = this->document_->GetLineAt(position);
+
+		this->InvalidateLines(oldLine, oldLine + 1);
+		if (newLine != oldLine) this->InvalidateLines(newLine, newLine + 1);
+		this->EnsureCaretVisible();
+	}
+
+	/**
+	* \brief Получить положение курсора документа
+	* \return Смещение
+	*/
+	size_t TextBox::GetCaret() const
+	{
+		return this->caret_;
+	}
+
+	/**
+	* \brief Прокрутить документ так, чтобы строка была первой видимой
+	* \param line Номер строки (ограничивается последней строкой)
+	*/
+	void TextBox::SetFirstLine(size_t line)
+	{
+		if (!this->document_) return;
+
+		line = (std::min)(line, this->document_->GetLineCount() - 1);
+		if (line == this->firstLine_) return;
+
+		this->firstLine_ = line;
+		if (this->IsWindowless()) this->InvalidateWindowArea();
+	}
+
+	/**
+	* \brief Получить первую видимую строку документа
+	* \return Номер строки
+	*/
+	size_t TextBox::GetFirstLine() const
+	{
+		return this->firstLine_;
 	}
 };
\ No newline at end of file
@@ -10,26 +10,113 @@
 #include <wquery/stdafx.h>
 #include <wquery/gui/Window.h>
 #include <wquery/gui/ControlBase.h>
-#include <wquery/gui/Button.h>
-#include <wquery/gui/TextBox.h>
 #include <wquery/tools/text.h>
+#include <wquery/tools/utf.h>
+#include <wquery/tools/startup.h>
+#include <wquery/tools/instrumentation.h>
+#include <wquery/platform/Backend.h>
+#include <wquery/platform/GdiCache.h>
 
 #define DEFAULT_WINDOW_W 350
 #define DEFAULT_WINDOW_H 200
+#define DEFAULT_WINDOW_TITLE "WQueryWindow"
 
 namespace wquery
 {
 	/**
-	* \brief Глобальный хендл приложения, инициализируется в методе wquery::Begin()
-	* \see wquery.cpp
+	* \brief Окна с накопленными движениями мыши (в порядке первого движения)
 	*/
-	extern HINSTANCE hInstance_;
+	static std::vector<Window*> mouseInputWindows_;
 
 	/**
-	* \brief Глобальная структура параметров оконного класса, инициализируется в методе wquery::Begin()
-	* \see wquery.cpp
+	* \brief Окна, ожидающие отложенной перерисовки (в порядке первого запроса)
 	*/
-	extern WNDCLASSEX classInfo_;
+	static std::vector<Window*> paintWindows_;
+
+	/**
+	* \brief Статистика отложенной перерисовки
+	*/
+	static PaintStatistics paintStatistics_ = {};
+
+	/**
+	* \brief Получить время для отсчетов движения мыши
+	* \return Время (мкс, монотонное)
+	*/
+	static unsigned long long GetMouseClock()
+	{
+		return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	/**
+	* \brief Получить положение курсора из параметра сообщения мыши
+	* \param lParam Параметр сообщения
+	* \return Положение в клиентской области
+	*/
+	static Vector2D<int> GetMousePosition(LPARAM lParam)
+	{
+		return Vector2D<int>(static_cast<int>(LOWORD(lParam)), static_cast<int>(HIWORD(lParam)));
+	}
+
+	/**
+	* \brief Установить текст
+	* \param value Текст
+	*/
+	void PendingText::Set(std::string_view value)
+	{
+		this->text.assign(value.data(), value.size());
+		this->textUtf16.clear();
+		this->utf16 = false;
+	}
+
+	/**
+	* \brief Установить текст
+	* \param value Текст в UTF-16
+	*/
+	void PendingText::Set(std::u16string_view value)
+	{
+		this->textUtf16.assign(value.data(), value.size());
+		this->text.clear();
+		this->utf16 = true;
+	}
+
+	/**
+	* \brief Получить текст
+	* \param value Строка для записи
+	*/
+	void PendingText::Get(std::string& value) const
+	{
+		if (!this->utf16) value.assign(this->text);
+		else if (!Utf16ToUtf8(this->textUtf16, value)) value.clear();
+	}
+
+	/**
+	* \brief Получить текст
+	* \param value Строка для записи
+	*/
+	void PendingText::Get(std::u16string& value) const
+	{
+		if (this->utf16) value.assign(this->textUtf16);
+		else if (!Utf8ToUtf16(this->text, value)) value.clear();
+	}
+
+	/**
+	* \brief Получить текст, передаваемый при создании системного объекта
+	* \return Нуль-терминированная строка (nullptr - текст пуст или будет установлен после создания)
+	*/
+	const char* PendingText::GetInitial() const
+	{
+		return (this->utf16 || this->text.empty()) ? nullptr : this->text.c_str();
+	}
+
+	/**
+	* \brief Установить текст созданному объекту (если его нельзя было передать при создании)
+	* \param hWnd Хендл
+	*/
+	void PendingText::Apply(HWND hWnd) const
+	{
+		if (this->utf16 && !this->textUtf16.empty()) GetBackend().WriteText(hWnd, std::u16string_view(this->textUtf16));
+	}
 
 	/**
 	* \brief Конструктор
@@ -37,47 +124,173 @@ namespace wquery
 	*/
 	Window::Window(Window * parent) :
 		hWnd_(nullptr),
+		pending_(new PendingWindow()),
 		parent_(parent),
 		backgroundColor_(ColorRGB(240, 240, 240)),
+		backgroundBrush_(nullptr),
 		closesProgram_(true),
 		oldClientAreaSize_({ 0,0 }),
 		maxSizes_({ 0,0 }),
-		minSizes_({ 0,0 })
-	{
-		// Создание окна WinApi
-		// Принадлежность и стиль окна меняются в зависимости от того
-		// передан ли указатель на родительский объект (родительское окно)
-		this->hWnd_ = CreateWindow(
-			classInfo_.lpszClassName,
-			L"WQueryWindow",
-			(this->parent_ && this->parent_->hWnd_ ? (WS_OVERLAPPED | WS_CAPTION | WS_CHILDWINDOW | WS_SYSMENU) : WS_OVERLAPPEDWINDOW),
-			0, 0,
-			DEFAULT_WINDOW_W, DEFAULT_WINDOW_H,
-			(this->parent_ && this->parent_->hWnd_ ? this->parent_->hWnd_ : NULL),
-			NULL,
-			hInstance_,
-			NULL);
-
-		// Если окно было создано
-		if (this->hWnd_)
+		minSizes_({ 0,0 }),
+		windowlessCount_(0),
+		pressedControl_(nullptr),
+		focusedControl_(nullptr),
+		coalesceMouse_(false),
+		mouseQueued_(false),
+		cursor_({ 0,0 }),
+		paintRequests_(0),
+		paintQueued_(false),
+		paintUpdating_(false)
+	{
+		StartupTimer timer(STARTUP_PHASE_WINDOW_CONSTRUCTION);
+
+		// Системное окно создается позже (\see Window::Create), здесь только запоминаются его начальные свойства.
+		// Стиль окна меняется в зависимости от того, передан ли указатель на родительский объект (родительское окно)
+		this->pending_->title.Set(DEFAULT_WINDOW_TITLE);
+		this->pending_->position = { 0,0 };
+		this->pending_->style = this->parent_ ? (WS_OVERLAPPED | WS_CAPTION | WS_CHILDWINDOW | WS_SYSMENU) : WS_OVERLAPPEDWINDOW;
+		this->pending_->closeButtonDisabled = false;
+		this->pending_->iconWidth = 16;
+		this->pending_->iconHeight = 16;
+
+		// "Старые размеры" клиентской области - размеры, которые она получит при создании окна
+		const Vector2D<int> frame = GetBackend().GetFrameSize(this->pending_->style);
+		this->oldClientAreaSize_ = {
+			(std::max)(DEFAULT_WINDOW_W - frame.X, 0),
+			(std::max)(DEFAULT_WINDOW_H - frame.Y, 0)
+		};
+	}
+
+	/**
+	* \brief Создать системное окно по записанным свойствам, затем - системные элементы управления
+	*/
+	void Window::Create()
+	{
+		if (!this->pending_) return;
+
+		StartupTimer timer(STARTUP_PHASE_WINDOW_CREATION);
+		const std::unique_ptr<PendingWindow> pending = std::move(this->pending_);
+		Backend& backend = GetBackend();
+
+		// Родительское окно должно быть создано раньше дочернего
+		HWND parent = this->parent_ ? this->parent_->GetNativeHandle() : nullptr;
+
+		// Окно создается сразу с нужным положением, размерами и заголовком (без последующих SetPos и SetText)
+		this->hWnd_ = backend.CreateWindowHandle(
+			parent,
+			pending->style,
+			pending->position,
+			this->oldClientAreaSize_ + backend.GetFrameSize(pending->style),
+			pending->title.GetInitial());
+
+		if (!this->hWnd_) return;
+
+		// В поле GWLP_USERDATA, в созданном окне, будет записан указатель на данный объект
+		// Таким образом к объекту можно будет обратиться в оконной процедуре
+		backend.SetUserData(this->hWnd_, this);
+
+		pending->title.Apply(this->hWnd_);
+		if (pending->closeButtonDisabled) backend.EnableSysMenuItem(this->hWnd_, SC_CLOSE, false);
+		if (!pending->iconFilename.empty()) backend.SetIcon(this->hWnd_, pending->iconFilename, pending->iconWidth, pending->iconHeight);
+
+		// Система может скорректировать размеры окна - тогда элементы раскладываются по фактической клиентской области
+		RECT clientRect = {};
+		if (backend.GetClientRect(this->hWnd_, &clientRect))
 		{
-			// В поле GWLP_USERDATA, в созданном окне, будет записан указатель на данный объект
-			// Таким образом к объекту можно будет обратиться в оконной процедуре
-			SetWindowLongPtr(this->hWnd_, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+			const Vector2D<int> clientSize(clientRect.right - clientRect.left, clientRect.bottom - clientRect.top);
+			this->LayoutControls(clientSize - this->oldClientAreaSize_);
+			this->oldClientAreaSize_ = clientSize;
+		}
 
-			// Установить "старые размеры" клиенсткой области
-			this->oldClientAreaSize_ = this->GetSize(true);
+		// Элементы управления создаются в порядке добавления (сразу с итоговыми положением и размерами),
+		// элементы без системного окна остаются без него
+		for (unsigned int id = 0; id < this->controls_.GetCount(); id++)
+		{
+			ControlBase * control = this->controls_.GetOwner(id);
+			if (control && control->pending_ && !this->controls_.HasFlag(id, GEOMETRY_WINDOWLESS)) control->CreateNative();
 		}
 	}
 
+	/**
+	* \brief Получить разницу между размерами окна и его клиентской области
+	* \return Разница (до создания окна - по стилю окна)
+	*/
+	Vector2D<int> Window::GetFrameDelta() const
+	{
+		if (this->pending_) return GetBackend().GetFrameSize(this->pending_->style);
+
+		RECT windowRect = {};
+		RECT clientRect = {};
+
+		if (this->hWnd_ && GetBackend().GetWindowRect(this->hWnd_, &windowRect) && GetBackend().GetClientRect(this->hWnd_, &clientRect))
+		{
+			return {
+				(windowRect.right - windowRect.left) - (clientRect.right - clientRect.left),
+				(windowRect.bottom - windowRect.top) - (clientRect.bottom - clientRect.top)
+			};
+		}
+
+		return { 0,0 };
+	}
+
+	/**
+	* \brief Изменить размеры клиентской области окна, которое еще не создано (только раскладка элементов)
+	* \param windowSize Новые размеры окна (ограничиваются минимальными и максимальными)
+	*/
+	void Window::ResizePending(const Vector2D<int>& windowSize)
+	{
+		// Ограничения те же, что и при изменении размеров созданного окна (\see WM_GETMINMAXINFO)
+		Vector2D<int> size((std::max)(windowSize.X, this->minSizes_.X), (std::max)(windowSize.Y, this->minSizes_.Y));
+
+		if (this->maxSizes_.X > 0 && this->maxSizes_.Y > 0 &&
+			this->maxSizes_.X >= this->minSizes_.X &&
+			this->maxSizes_.Y >= this->minSizes_.Y)
+		{
+			size.X = (std::min)(size.X, this->maxSizes_.X);
+			size.Y = (std::min)(size.Y, this->maxSizes_.Y);
+		}
+
+		const Vector2D<int> frame = this->GetFrameDelta();
+		const Vector2D<int> clientSize((std::max)(size.X - frame.X, 0), (std::max)(size.Y - frame.Y, 0));
+
+		this->LayoutControls(clientSize - this->oldClientAreaSize_);
+		this->oldClientAreaSize_ = clientSize;
+	}
+
 	/**
 	* \brief Деструктор. Уничтожение окна
 	*/
 	Window::~Window()
 	{
-		// Уничтожение окна WinApi
+		// Элементы управления уничтожаются системой вместе с окном,
+		// а их объекты (если они переживут окно) больше не должны к нему обращаться
+		for (unsigned int id = 0; id < this->controls_.GetCount(); id++) {
+			ControlBase * control = this->controls_.GetOwner(id);
+			if (!control) continue;
+
+			control->window_ = nullptr;
+			control->hWnd_ = nullptr;
+			control->pending_.reset();
+		}
+
+		// Уничтожение окна
 		if (this->hWnd_) {
-			DestroyWindow(this->hWnd_);
+			GetBackend().DestroyHandle(this->hWnd_);
+		}
+
+		// Освобождение кисти фона
+		GetGdiCache().ReleaseBrush(this->backgroundBrush_);
+
+		// Остановка таймеров окна (их функции обычно обращаются к окну)
+		GetTimerWheel().CancelAll(this);
+
+		// Накопленные движения мыши больше не доставляются
+		if (this->mouseQueued_) {
+			mouseInputWindows_.erase(std::find(mouseInputWindows_.begin(), mouseInputWindows_.end(), this));
+		}
+
+		if (this->paintQueued_) {
+			paintWindows_.erase(std::find(paintWindows_.begin(), paintWindows_.end(), this));
 		}
 	}
 
@@ -86,9 +299,13 @@ namespace wquery
 	*/
 	void Window::Show() const
 	{
+		// Окно (и его элементы) создается при первом показе
+		if (this->pending_) const_cast<Window*>(this)->Create();
+
 		if (this->hWnd_) {
-			ShowWindow(this->hWnd_, SW_SHOWNORMAL);
-			UpdateWindow(this->hWnd_);
+			GetBackend().Show(this->hWnd_, SW_SHOWNORMAL);
+			MarkStartupEvent(STARTUP_EVENT_FIRST_SHOW);
+			GetBackend().Update(this->hWnd_);
 		}
 	}
 
@@ -97,9 +314,10 @@ namespace wquery
 	*/
 	void Window::Hide() const
 	{
+		// Еще не созданное окно и так не видимо
 		if (this->hWnd_) {
-			ShowWindow(this->hWnd_, SW_HIDE);
-			UpdateWindow(this->hWnd_);
+			GetBackend().Show(this->hWnd_, SW_HIDE);
+			GetBackend().Update(this->hWnd_);
 		}
 	}
 
@@ -109,9 +327,19 @@ namespace wquery
 	*/
 	HWND Window::GetNativeHandle() const
 	{
+		if (this->pending_) const_cast<Window*>(this)->Create();
 		return this->hWnd_;
 	}
 
+	/**
+	* \brief Создано ли системное окно
+	* \return Статус
+	*/
+	bool Window::IsCreated() const
+	{
+		return this->hWnd_ != nullptr;
+	}
+
 	/**
 	* \brief Получить родительский объект
 	* \return Указатель на родителя
@@ -127,7 +355,37 @@ namespace wquery
 	*/
 	void Window::SetTitle(const std::string& title) const
 	{
-		if (this->hWnd_) SetWindowTextA(this->hWnd_, title.c_str());
+		this->SetTitle(title.c_str());
+	}
+
+	/**
+	* \brief Установка заголовка окна
+	* \param title Заголовок (нуль-терминированная строка)
+	*/
+	void Window::SetTitle(const char* title) const
+	{
+		if (this->pending_) this->pending_->title.Set(std::string_view(title ? title : ""));
+		else if (this->hWnd_) GetBackend().SetText(this->hWnd_, title);
+	}
+
+	/**
+	* \brief Установка заголовка окна
+	* \param title Заголовок (представление строки)
+	*/
+	void Window::SetTitle(std::string_view title) const
+	{
+		if (this->pending_) this->pending_->title.Set(title);
+		else if (this->hWnd_) GetBackend().WriteText(this->hWnd_, title);
+	}
+
+	/**
+	* \brief Установка заголовка окна
+	* \param title Заголовок в UTF-16
+	*/
+	void Window::SetTitle(std::u16string_view title) const
+	{
+		if (this->pending_) this->pending_->title.Set(title);
+		else if (this->hWnd_) GetBackend().WriteText(this->hWnd_, title);
 	}
 
 	/**
@@ -137,18 +395,32 @@ namespace wquery
 	std::string Window::GetTitle() const
 	{
 		std::string result;
-		if (this->hWnd_)
-		{
-			const unsigned int textLength = GetWindowTextLengthA(this->hWnd_) + 1;
-			char * buffer = new char[textLength];
-			GetWindowTextA(this->hWnd_, buffer, textLength);
-			result.append(buffer);
-			delete[] buffer;
-
-		}
+		this->GetTitle(result);
 		return result;
 	}
 
+	/**
+	* \brief Получение заголовка окна в существующую строку
+	* \param title Строка для записи
+	*/
+	void Window::GetTitle(std::string& title) const
+	{
+		if (this->pending_) this->pending_->title.Get(title);
+		else if (this->hWnd_) GetBackend().ReadText(this->hWnd_, title);
+		else title.clear();
+	}
+
+	/**
+	* \brief Получение заголовка окна в существующую UTF-16 строку
+	* \param title Строка для записи
+	*/
+	void Window::GetTitle(std::u16string& title) const
+	{
+		if (this->pending_) this->pending_->title.Get(title);
+		else if (this->hWnd_) GetBackend().ReadText(this->hWnd_, title);
+		else title.clear();
+	}
+
 	/**
 	* \brief Установка размеров окна
 	* \param size Размеры
@@ -156,32 +428,25 @@ namespace wquery
 	*/
 	void Window::SetSize(const Vector2D<int>& size, const bool clientArea) const
 	{
-		if (this->hWnd_)
-		{
-			// Разница медлу размерами клиенской области и окна в целом
-			auto deltaWidth = 0, deltaHeight = 0;
+		// Разница медлу размерами клиенской области и окна в целом
+		// (нужна только если размер должен вычисляться по размеру клиенской области)
+		const Vector2D<int> delta = clientArea ? this->GetFrameDelta() : Vector2D<int>(0, 0);
 
-			// Если размер должен вычисляться по размеру клиенской области
-			// то нужно получить разницу между размерами оконной и клиенской области
-			if (clientArea)
-			{
-				RECT windowRect = {};
-				RECT clientRect = {};
-
-				if (GetWindowRect(this->hWnd_, &windowRect) && GetClientRect(this->hWnd_, &clientRect))
-				{
-					deltaWidth = (windowRect.right - windowRect.left) - (clientRect.right - clientRect.left);
-					deltaHeight = (windowRect.bottom - windowRect.top) - (clientRect.bottom - clientRect.top);
-				}
-			}
+		// До создания окна меняется только раскладка элементов (окно будет создано уже с новыми размерами)
+		if (this->pending_)
+		{
+			const_cast<Window*>(this)->ResizePending(size + delta);
+			return;
+		}
 
-			SetWindowPos(
+		if (this->hWnd_)
+		{
+			GetBackend().SetPos(
 				this->hWnd_,                      // Хендл окна
-				nullptr,                          // Хендл окна, над которым окно будет размещено (Z-уровень)
-				NULL,                             // Положение левой стороны окна (не меняется)
-				NULL,                             // Положение верха окна (не меняется)
-				size.X + deltaWidth,              // Новая ширина окна в пикселях
-				size.Y + deltaHeight,             // Новая высота окна в пикселях
+				0,                                // Положение левой стороны окна (не меняется)
+				0,                                // Положение верха окна (не меняется)
+				size.X + delta.X,                 // Новая ширина окна в пикселях
+				size.Y + delta.Y,                 // Новая высота окна в пикселях
 				SWP_ASYNCWINDOWPOS | SWP_NOMOVE   // Асинхронное изменение (изменяет нить владеющая окном) без смены положения
 			);
 		}
@@ -196,17 +461,23 @@ namespace wquery
 	{
 		Vector2D<int> sizes;
 
+		// До создания окна размеры клиентской области известны из раскладки
+		if (this->pending_)
+		{
+			return clientArea ? this->oldClientAreaSize_ : this->oldClientAreaSize_ + this->GetFrameDelta();
+		}
+
 		if (this->hWnd_)
 		{
 			RECT rect = {};
 
 			if (clientArea)
 			{
-				GetClientRect(this->hWnd_, &rect);
+				GetBackend().GetClientRect(this->hWnd_, &rect);
 			}
 			else
 			{
-				GetWindowRect(this->hWnd_, &rect);
+				GetBackend().GetWindowRect(this->hWnd_, &rect);
 			}
 
 			sizes.X = rect.right - rect.left;
@@ -222,14 +493,16 @@ namespace wquery
 	*/
 	void Window::SetPosition(const Vector2D<int>& position) const
 	{
-		if (this->hWnd_) {
-			SetWindowPos(
+		if (this->pending_) {
+			this->pending_->position = position;
+		}
+		else if (this->hWnd_) {
+			GetBackend().SetPos(
 				this->hWnd_,                      // Хендл окна
-				nullptr,                          // Хендл окна, над которым окно будет размещено (Z-уровень)
 				position.X,                       // Положение левой стороны окна
 				position.Y,                       // Положение верха окна
-				NULL,                             // Новая ширина окна в пикселях (не меняется)
-				NULL,                             // Новая высота окна в пикселях (не меняется)
+				0,                                // Новая ширина окна в пикселях (не меняется)
+				0,                                // Новая высота окна в пикселях (не меняется)
 				SWP_ASYNCWINDOWPOS | SWP_NOSIZE   // Асинхронное изменение (изменяет нить владеющая окном) без смены размера
 			);
 		}
@@ -244,12 +517,20 @@ namespace wquery
 	{
 		Vector2D<int> position;
 
+		// Положение дочернего окна задается относительно родителя, поэтому экранное положение
+		// известно только после создания окна
+		if (this->pending_)
+		{
+			if (relative || !this->parent_) return this->pending_->position;
+			const_cast<Window*>(this)->Create();
+		}
+
 		if (this->hWnd_)
 		{
 			RECT posRect = {};
 			POINT posPoint = {};
 
-			if (GetWindowRect(this->hWnd_, &posRect))
+			if (GetBackend().GetWindowRect(this->hWnd_, &posRect))
 			{
 				posPoint.x = posRect.left;
 				posPoint.y = posRect.top;
@@ -257,7 +538,7 @@ namespace wquery
 
 			if (relative && this->parent_ != nullptr && this->parent_->hWnd_ != nullptr)
 			{
-				ScreenToClient(this->parent_->hWnd_, &posPoint);
+				GetBackend().ScreenToClient(this->parent_->hWnd_, &posPoint);
 			}
 
 			position.X = posPoint.x;
@@ -275,12 +556,11 @@ namespace wquery
 	{
 		this->backgroundColor_ = color;
 
-		if (this->hWnd_)
-		{
-			RECT clientAreaRect;
-			GetClientRect(this->hWnd_, &clientAreaRect);
-			InvalidateRect(this->hWnd_, &clientAreaRect, true);
-		}
+		// Кисть прежнего цвета освобождается, новая будет получена из кеша при следующем стирании фона
+		GetGdiCache().ReleaseBrush(this->backgroundBrush_);
+		this->backgroundBrush_ = nullptr;
+
+		this->Invalidate();
 	}
 
 	/**
@@ -317,29 +597,13 @@ namespace wquery
 	*/
 	void Window::SetMaxSizes(const Vector2D<int>& sizes, const bool clientArea)
 	{
-		if (this->hWnd_)
-		{
-			// Разница между размерами клиенской области и окна в целом
-			auto deltaWidth = 0, deltaHeight = 0;
-
-			// Если размер должен вычисляться по размеру клиенской области
-			// то нужно получить разницу между размерами оконной и клиенской области
-			if (clientArea)
-			{
-				RECT windowRect = {};
-				RECT clientRect = {};
-
-				if (GetWindowRect(this->hWnd_, &windowRect) && GetClientRect(this->hWnd_, &clientRect))
-				{
-					deltaWidth = (windowRect.right - windowRect.left) - (clientRect.right - clientRect.left);
-					deltaHeight = (windowRect.bottom - windowRect.top) - (clientRect.bottom - clientRect.top);
-				}
-			}
+		// Разница между размерами клиенской области и окна в целом
+		// (нужна только если размер должен вычисляться по размеру клиенской области)
+		const Vector2D<int> delta = clientArea ? this->GetFrameDelta() : Vector2D<int>(0, 0);
 
-			// Установить размер с учетом разницы между размером окна и размером кл. области
-			this->maxSizes_.X = sizes.X + deltaWidth;
-			this->maxSizes_.Y = sizes.Y + deltaHeight;
-		}
+		// Установить размер с учетом разницы между размером окна и размером кл. области
+		this->maxSizes_.X = sizes.X + delta.X;
+		this->maxSizes_.Y = sizes.Y + delta.Y;
 	}
 
 	/**
@@ -350,21 +614,8 @@ namespace wquery
 	Vector2D<int> Window::GetMaxSizes(const bool clientArea) const
 	{
 		// Разница между размерами клиенской области и окна в целом
-		auto deltaWidth = 0, deltaHeight = 0;
-
-		// Если размер должен вычисляться по размеру клиенской области
-		// то нужно получить разницу между размерами оконной и клиенской области
-		if (clientArea && this->hWnd_)
-		{
-			RECT windowRect = {};
-			RECT clientRect = {};
-
-			if (GetWindowRect(this->hWnd_, &windowRect) && GetClientRect(this->hWnd_, &clientRect))
-			{
-				deltaWidth = (windowRect.right - windowRect.left) - (clientRect.right - clientRect.left);
-				deltaHeight = (windowRect.bottom - windowRect.top) - (clientRect.bottom - clientRect.top);
-			}
-		}
+		// (нужна только если запрашивается размер клиенской области)
+		const Vector2D<int> delta = clientArea ? this->GetFrameDelta() : Vector2D<int>(0, 0);
 
 		// Вернуть раземр с учетом разницы между клиентской областью или окном
 		// Если clientArea было установлено в true, значит запрашивается размер клиенсткой
@@ -372,8 +623,8 @@ namespace wquery
 		// окна целиком был установлен через set-функцию, из-за чего возможно отрицательное значение.
 		// Чтобы этого избежать - используется max между полученым значением и нулем
 		return{
-			max(this->maxSizes_.X - deltaWidth,0),
-			max(this->maxSizes_.Y - deltaHeight,0)
+			(std::max)(this->maxSizes_.X - delta.X,0),
+			(std::max)(this->maxSizes_.Y - delta.Y,0)
 		};
 	}
 
@@ -384,29 +635,13 @@ namespace wquery
 	*/
 	void Window::SetMinSizes(const Vector2D<int>& sizes, const bool clientArea)
 	{
-		if (this->hWnd_)
-		{
-			// Разница между размерами клиенской области и окна в целом
-			auto deltaWidth = 0, deltaHeight = 0;
-
-			// Если размер должен вычисляться по размеру клиенской области
-			// то нужно получить разницу между размерами оконной и клиенской области
-			if (clientArea)
-			{
-				RECT windowRect = {};
-				RECT clientRect = {};
-
-				if (GetWindowRect(this->hWnd_, &windowRect) && GetClientRect(this->hWnd_, &clientRect))
-				{
-					deltaWidth = (windowRect.right - windowRect.left) - (clientRect.right - clientRect.left);
-					deltaHeight = (windowRect.bottom - windowRect.top) - (clientRect.bottom - clientRect.top);
-				}
-			}
+		// Разница между размерами клиенской области и окна в целом
+		// (нужна только если размер должен вычисляться по размеру клиенской области)
+		const Vector2D<int> delta = clientArea ? this->GetFrameDelta() : Vector2D<int>(0, 0);
 
-			// Установить размер с учетом разницы между размером окна и размером кл. области
-			this->minSizes_.X = sizes.X + deltaWidth;
-			this->minSizes_.Y = sizes.Y + deltaHeight;
-		}
+		// Установить размер с учетом разницы между размером окна и размером кл. области
+		this->minSizes_.X = sizes.X + delta.X;
+		this->minSizes_.Y = sizes.Y + delta.Y;
 	}
 
 	/**
@@ -417,21 +652,8 @@ namespace wquery
 	Vector2D<int> Window::GetMinSizes(const bool clientArea) const
 	{
 		// Разница между размерами клиенской области и окна в целом
-		auto deltaWidth = 0, deltaHeight = 0;
-
-		// Если размер должен вычисляться по размеру клиенской области
-		// то нужно получить разницу между размерами оконной и клиенской области
-		if (clientArea && this->hWnd_)
-		{
-			RECT windowRect = {};
-			RECT clientRect = {};
-
-			if (GetWindowRect(this->hWnd_, &windowRect) && GetClientRect(this->hWnd_, &clientRect))
-			{
-				deltaWidth = (windowRect.right - windowRect.left) - (clientRect.right - clientRect.left);
-				deltaHeight = (windowRect.bottom - windowRect.top) - (clientRect.bottom - clientRect.top);
-			}
-		}
+		// (нужна только если запрашивается размер клиенской области)
+		const Vector2D<int> delta = clientArea ? this->GetFrameDelta() : Vector2D<int>(0, 0);
 
 		// Вернуть раземр с учетом разницы между клиентской областью или окном
 		// Если clientArea было установлено в true, значит запрашивается размер клиенсткой
@@ -439,8 +661,8 @@ namespace wquery
 		// окна целиком был установлен через set-функцию, из-за чего возможно отрицательное значение.
 		// Чтобы этого избежать - используется max между полученым значением и нулем
 		return{
-			max(this->minSizes_.X - deltaWidth,0),
-			max(this->minSizes_.Y - deltaHeight,0)
+			(std::max)(this->minSizes_.X - delta.X,0),
+			(std::max)(this->minSizes_.Y - delta.Y,0)
 		};
 	}
 
@@ -450,12 +672,13 @@ namespace wquery
 	*/
 	void Window::SetCloseButtonStatus(const bool enabled) const
 	{
-		if (this->hWnd_)
+		if (this->pending_)
 		{
-			if (!enabled)
-				EnableMenuItem(GetSystemMenu(this->hWnd_, FALSE), SC_CLOSE, MF_BYCOMMAND | MF_DISABLED | MF_GRAYED);
-			else
-				EnableMenuItem(GetSystemMenu(this->hWnd_, FALSE), SC_CLOSE, MF_BYCOMMAND | MF_ENABLED);
+			this->pending_->closeButtonDisabled = !enabled;
+		}
+		else if (this->hWnd_)
+		{
+			GetBackend().EnableSysMenuItem(this->hWnd_, SC_CLOSE, enabled);
 		}
 	}
 
@@ -465,12 +688,19 @@ namespace wquery
 	*/
 	void Window::SetMinimizeButtonStatus(const bool enabled) const
 	{
-		if (this->hWnd_)
+		if (this->pending_)
+		{
+			if (!enabled)
+				this->pending_->style &= ~static_cast<DWORD>(WS_MINIMIZEBOX);
+			else
+				this->pending_->style |= WS_MINIMIZEBOX;
+		}
+		else if (this->hWnd_)
 		{
 			if (!enabled)
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) & ~WS_MINIMIZEBOX);
+				GetBackend().SetStyle(this->hWnd_, GetBackend().GetStyle(this->hWnd_) & ~WS_MINIMIZEBOX);
 			else
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) | WS_MINIMIZEBOX);
+				GetBackend().SetStyle(this->hWnd_, GetBackend().GetStyle(this->hWnd_) | WS_MINIMIZEBOX);
 		}
 	}
 
@@ -480,12 +710,19 @@ namespace wquery
 	*/
 	void Window::SetMaximizeButtonStatus(const bool enabled) const
 	{
-		if (this->hWnd_)
+		if (this->pending_)
 		{
 			if (!enabled)
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) & ~WS_MAXIMIZEBOX);
+				this->pending_->style &= ~static_cast<DWORD>(WS_MAXIMIZEBOX);
 			else
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) | WS_MAXIMIZEBOX);
+				this->pending_->style |= WS_MAXIMIZEBOX;
+		}
+		else if (this->hWnd_)
+		{
+			if (!enabled)
+				GetBackend().SetStyle(this->hWnd_, GetBackend().GetStyle(this->hWnd_) & ~WS_MAXIMIZEBOX);
+			else
+				GetBackend().SetStyle(this->hWnd_, GetBackend().GetStyle(this->hWnd_) | WS_MAXIMIZEBOX);
 		}
 	}
 
@@ -495,12 +732,19 @@ namespace wquery
 	*/
 	void Window::SetSysMenuStatus(const bool visible) const
 	{
-		if (this->hWnd_)
+		if (this->pending_)
 		{
 			if (!visible)
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) & ~(WS_CAPTION | WS_SIZEBOX));
+				this->pending_->style &= ~static_cast<DWORD>(WS_CAPTION | WS_SIZEBOX);
 			else
-				SetWindowLong(this->hWnd_, GWL_STYLE, GetWindowLong(this->hWnd_, GWL_STYLE) | WS_CAPTION | WS_SIZEBOX);
+				this->pending_->style |= WS_CAPTION | WS_SIZEBOX;
+		}
+		else if (this->hWnd_)
+		{
+			if (!visible)
+				GetBackend().SetStyle(this->hWnd_, GetBackend().GetStyle(this->hWnd_) & ~(WS_CAPTION | WS_SIZEBOX));
+			else
+				GetBackend().SetStyle(this->hWnd_, GetBackend().GetStyle(this->hWnd_) | WS_CAPTION | WS_SIZEBOX);
 		}
 
 	}
@@ -513,13 +757,15 @@ namespace wquery
 	*/
 	void Window::SetIcon(const std::string& iconFilename, int width, int height) const
 	{
-		if(this->hWnd_)
+		if (this->pending_)
 		{
-			HANDLE icon = LoadImageA(nullptr, iconFilename.c_str(), IMAGE_ICON, width, height, LR_LOADFROMFILE);
-			if (icon)
-			{
-				SendMessageA(this->hWnd_, WM_SETICON, ICON_BIG, reinterpret_cast<LPARAM>(icon));
-			}
+			this->pending_->iconFilename = iconFilename;
+			this->pending_->iconWidth = width;
+			this->pending_->iconHeight = height;
+		}
+		else if(this->hWnd_)
+		{
+			GetBackend().SetIcon(this->hWnd_, iconFilename, width, height);
 		}
 	}
 
@@ -528,8 +774,10 @@ namespace wquery
 	*/
 	void Window::Maximize() const
 	{
+		if (this->pending_) const_cast<Window*>(this)->Create();
+
 		if (this->hWnd_)
-			ShowWindow(this->hWnd_, SW_SHOWMAXIMIZED);
+			GetBackend().Show(this->hWnd_, SW_SHOWMAXIMIZED);
 	}
 
 	/**
@@ -537,8 +785,10 @@ namespace wquery
 	*/
 	void Window::Minimize() const
 	{
+		if (this->pending_) const_cast<Window*>(this)->Create();
+
 		if (this->hWnd_)
-			ShowWindow(this->hWnd_, SW_SHOWMINIMIZED);
+			GetBackend().Show(this->hWnd_, SW_SHOWMINIMIZED);
 	}
 
 
@@ -552,61 +802,49 @@ namespace wquery
 	*/
 	LRESULT Window::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 	{
+		// Платформенный слой (WinApi или headless)
+		Backend& backend = GetBackend();
+
 		// Получить указатель на wQuery объект
-		Window * window = reinterpret_cast<Window*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+		Window * window = reinterpret_cast<Window*>(backend.GetUserData(hWnd));
+
+		// Замер обработки сообщения и задержки ввода (только с WQUERY_INSTRUMENTATION)
+		WQUERY_INSTRUMENT_MESSAGE(message);
+		WQUERY_INSTRUMENT_INPUT(message);
 
 		// Основной swicth-case оконной процедуры
 		switch (message)
 		{
 		case WM_COMMAND:
-			if(HIWORD(wParam) == EN_CHANGE)
-			{
-				HWND controlHwnd = reinterpret_cast<HWND>(lParam);
-				ControlBase * pControl = reinterpret_cast<ControlBase*>(GetWindowLongPtr(controlHwnd, GWLP_USERDATA));
-
-				if (pControl)
-				{
-					const std::string className = pControl->GetControlClassName();
-
-					if (className == "TextBox")
-					{
-						TextBox * pTextBox = dynamic_cast<TextBox*>(pControl);
-						if (pTextBox->events.onChanged) pTextBox->events.onChanged();
-					}
-				}
-			}
-			else
+			// Уведомление от элемента управления (lParam - хендл элемента, у меню и акселераторов он нулевой)
+			// передается обработчику, зарегистрированному для кода уведомления и типа элемента
+			if (lParam)
 			{
 				HWND controlHwnd = reinterpret_cast<HWND>(lParam);
-				ControlBase * pControl = reinterpret_cast<ControlBase*>(GetWindowLongPtr(controlHwnd, GWLP_USERDATA));
-
-				if (pControl)
-				{
-					const std::string className = pControl->GetControlClassName();
-
-					if (className == "Button")
-					{
-						Button * pButton = dynamic_cast<Button*>(pControl);
-						if (pButton->events.onClicked) pButton->events.onClicked();
-					}
-				}
+				ControlBase * pControl = reinterpret_cast<ControlBase*>(backend.GetUserData(controlHwnd));
+				ControlBase::DispatchNotification(pControl, wParam, lParam);
 			}
 			break;
 
 		case WM_DESTROY:
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_ERASEBKGND:
+			// Окно, рисующее через задний буфер, стирает фон в буфере (стирание на экране вызвало бы мерцание)
+			if (window && window->UsesCanvas()) return 1;
+
 			if (window)
 			{
 				RECT clientAreaRect;
-				GetClientRect(hWnd, &clientAreaRect);
-				FillRect(reinterpret_cast<HDC>(wParam), &clientAreaRect, window->backgroundColor_.GetNativeBrush());
+				backend.GetClientRect(hWnd, &clientAreaRect);
+				// Кисть фона запрашивается у кеша однократно и хранится до смены цвета или уничтожения окна
+				if (!window->backgroundBrush_) window->backgroundBrush_ = window->backgroundColor_.GetNativeBrush();
+				backend.FillRect(reinterpret_cast<HDC>(wParam), &clientAreaRect, window->backgroundBrush_);
 			}
 			break;
 
 		case WM_NCPAINT:
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_SIZE:
 			if (window)
@@ -616,103 +854,163 @@ namespace wquery
 					auto const type = static_cast<unsigned int>(wParam);
 					const Vector2D<int> newSizes(static_cast<unsigned int>(LOWORD(lParam)), static_cast<unsigned int>(HIWORD(lParam)));
 
+					WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_RESIZED);
 					window->events.onResized(type, newSizes);
 				}
 
-				Vector2D<int> sizingDelta((LOWORD(lParam)) - window->oldClientAreaSize_.X, (HIWORD(lParam)) - window->oldClientAreaSize_.Y);
-				EnumChildWindows(window->hWnd_, Window::EnumerateResizingControls, reinterpret_cast<LPARAM>(&sizingDelta));
+				// При сворачивании клиентская область становится нулевой - раскладка не пересчитывается,
+				// чтобы после разворачивания элементы вернулись точно на свои места
+				if (wParam != SIZE_MINIMIZED)
+				{
+					Vector2D<int> sizingDelta((LOWORD(lParam)) - window->oldClientAreaSize_.X, (HIWORD(lParam)) - window->oldClientAreaSize_.Y);
+					window->LayoutControls(sizingDelta);
 
-				window->oldClientAreaSize_ = Vector2D<int>(
-					static_cast<unsigned int>(LOWORD(lParam)),
-					static_cast<unsigned int>(HIWORD(lParam)));
+					window->oldClientAreaSize_ = Vector2D<int>(
+						static_cast<unsigned int>(LOWORD(lParam)),
+						static_cast<unsigned int>(HIWORD(lParam)));
+				}
 			}
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_KEYDOWN:
 			if (window && window->events.onKeyDown)
 			{
+				WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_KEY_DOWN);
 				window->events.onKeyDown(wParam);
 			}
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			if (window) window->RouteWindowlessKey(message, wParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_KEYUP:
 			if (window && window->events.onKeyUp)
 			{
+				WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_KEY_UP);
 				window->events.onKeyUp(wParam);
 			}
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_CHAR:
 			if (window && window->events.onTyping)
 			{
+				WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_TYPING);
 				window->events.onTyping(wquery::WideToChar(wParam));
 			}
+			if (window) window->RouteWindowlessKey(message, wParam);
 			return 0;
 
 		case WM_LBUTTONDOWN:
 		case WM_MBUTTONDOWN:
 		case WM_RBUTTONDOWN:
-			if (window && window->events.onMouseKeyDown)
+			if (window)
 			{
-				Vector2D<int> position;
-				position.X = static_cast<int>(LOWORD(lParam));
-				position.Y = static_cast<int>(HIWORD(lParam));
+				// Накопленные движения доставляются раньше нажатия
+				window->FlushMouseSamples();
+				window->cursor_ = GetMousePosition(lParam);
+
+				if (window->events.onMouseKeyDown)
+				{
+					MouseKeys keyType;
+					if (message == WM_LBUTTONDOWN) keyType = MouseKeys::LEFT;
+					else if (message == WM_MBUTTONDOWN) keyType = MouseKeys::MIDDLE;
+					else keyType = MouseKeys::RIGHT;
 
-				MouseKeys keyType;
-				if (message == WM_LBUTTONDOWN) keyType = MouseKeys::LEFT;
-				else if (message == WM_MBUTTONDOWN) keyType = MouseKeys::MIDDLE;
-				else keyType = MouseKeys::RIGHT;
+					WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_MOUSE_DOWN);
+					window->events.onMouseKeyDown(window->cursor_, keyType);
+				}
 
-				window->events.onMouseKeyDown(position, keyType);
+				if (message == WM_LBUTTONDOWN) window->RouteWindowlessMouse(message);
 			}
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_LBUTTONUP:
 		case WM_MBUTTONUP:
 		case WM_RBUTTONUP:
-			if (window && window->events.onMouseKeyUp)
+			if (window)
 			{
-				Vector2D<int> position;
-				position.X = static_cast<int>(LOWORD(lParam));
-				position.Y = static_cast<int>(HIWORD(lParam));
+				window->FlushMouseSamples();
+				window->cursor_ = GetMousePosition(lParam);
+
+				if (window->events.onMouseKeyUp)
+				{
+					MouseKeys keyType;
+					if (message == WM_LBUTTONUP) keyType = MouseKeys::LEFT;
+					else if (message == WM_MBUTTONUP) keyType = MouseKeys::MIDDLE;
+					else keyType = MouseKeys::RIGHT;
 
-				MouseKeys keyType;
-				if (message == WM_LBUTTONDOWN) keyType = MouseKeys::LEFT;
-				else if (message == WM_MBUTTONDOWN) keyType = MouseKeys::MIDDLE;
-				else keyType = MouseKeys::RIGHT;
+					WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_MOUSE_UP);
+					window->events.onMouseKeyUp(window->cursor_, keyType);
+				}
 
-				window->events.onMouseKeyUp(position, keyType);
+				if (message == WM_LBUTTONUP) window->RouteWindowlessMouse(message);
 			}
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
+
+		case WM_MOUSEWHEEL:
+			if (window)
+			{
+				// Положение в сообщении - экранное, элемент ищется по последнему известному положению курсора
+				window->RouteWindowlessWheel(GET_WHEEL_DELTA_WPARAM(wParam));
+			}
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_MOUSEMOVE:
-			if (window && window->events.onMouseMove)
+			if (window)
 			{
-				Vector2D<int> position;
-				position.X = static_cast<int>(LOWORD(lParam));
-				position.Y = static_cast<int>(HIWORD(lParam));
-				window->events.onMouseMove(position);
+				window->cursor_ = GetMousePosition(lParam);
+
+				// В режиме объединения движение только запоминается (доставляется пакетом из основного цикла)
+				if (window->coalesceMouse_)
+				{
+					if (!window->mouseQueued_) {
+						mouseInputWindows_.push_back(window);
+						window->mouseQueued_ = true;
+					}
+
+					window->mouseSamples_.push_back({ window->cursor_, GetMouseClock() });
+				}
+				else if (window->events.onMouseMove)
+				{
+					WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_MOUSE_MOVE);
+					window->events.onMouseMove(window->cursor_);
+				}
 			}
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_PAINT:
-			if (window && window->events.onPaint)
+			if (window)
 			{
-				window->events.onPaint();
+				// Перерисовка, вызванная системой (а не отложенной перерисовкой окна), охватывает всю клиентскую область
+				if (!window->paintUpdating_ || window->paintRegion_.IsEmpty())
+				{
+					RECT clientAreaRect;
+					backend.GetClientRect(hWnd, &clientAreaRect);
+					window->paintRegion_.Clear();
+					window->paintRegion_.Add(clientAreaRect);
+				}
+
+				if (window->UsesCanvas())
+				{
+					window->PaintCanvas();
+					MarkStartupEvent(STARTUP_EVENT_FIRST_PAINT);
+					return 0;
+				}
+
+				window->paintRegion_.Clear();
+
+				const LRESULT result = backend.DefaultProc(hWnd, message, wParam, lParam);
+				MarkStartupEvent(STARTUP_EVENT_FIRST_PAINT);
+				return result;
 			}
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 
 		case WM_CLOSE:
 			if (window)
 			{
-				if (window->events.onClose)
-				{
-					if (!window->events.onClose()) return 0;
-				}
+				if (!window->events.onClose.All()) return 0;
 
-				if (window->closesProgram_) PostQuitMessage(0);
+				if (window->closesProgram_) backend.PostQuit(0);
 			}
-			ShowWindow(hWnd, SW_HIDE);
+			backend.Show(hWnd, SW_HIDE);
 			break;
 
 		case WM_GETMINMAXINFO:
@@ -733,68 +1031,465 @@ namespace wquery
 			break;
 
 		default:
-			return DefWindowProc(hWnd, message, wParam, lParam);
+			return backend.DefaultProc(hWnd, message, wParam, lParam);
 		}
 
 		return 0;
 	}
 
 	/**
-	* \brief Используется для обновление размеров адаптивных (якорных) элементов
-	* \details Метод является callback-ом для перечисления дочерних элементов в момент изменения размера кона
-	* \param hWnd Хендл элемента WinApi
-	* \param lParam Параметр переданный из функции перечисления
+	* \brief Обновление положения и размеров адаптивных (якорных) элементов
+	* \param sizingDelta Изменение размеров клиентской области
+	*/
+	void Window::LayoutControls(const Vector2D<int>& sizingDelta)
+	{
+		if (sizingDelta.X == 0 && sizingDelta.Y == 0) return;
+
+		// Буферы пакета переиспользуются между вызовами (без выделения памяти при каждом WM_SIZE)
+		this->layoutChanged_.clear();
+		this->layoutHandles_.clear();
+		this->layoutPositions_.clear();
+		this->layoutSizes_.clear();
+
+		// Новые прямоугольники считаются проходом по массивам хранилища геометрии
+		this->controls_.Layout(sizingDelta, this->layoutChanged_);
+
+		for (unsigned int id : this->layoutChanged_)
+		{
+			// Еще не созданный элемент будет создан сразу с новыми положением и размерами
+			HWND handle = this->controls_.GetHandle(id);
+			if (!handle) continue;
+
+			this->layoutHandles_.push_back(handle);
+			this->layoutPositions_.push_back(this->controls_.GetPosition(id));
+			this->layoutSizes_.push_back(this->controls_.GetSize(id));
+		}
+
+		// Применение всех изменений одним пакетом и однократная перерисовка
+		if (!this->layoutHandles_.empty())
+		{
+			GetBackend().SetPosBatch(this->layoutHandles_.data(), this->layoutPositions_.data(), this->layoutSizes_.data(), this->layoutHandles_.size());
+			GetBackend().Redraw(this->hWnd_);
+		}
+
+		// Элементы без системного окна перерисовываются окном (отложенно, вместе с остальными запросами итерации)
+		if (this->windowlessCount_ > 0 && this->layoutHandles_.size() != this->layoutChanged_.size())
+		{
+			this->Invalidate();
+		}
+	}
+
+	/**
+	* \brief Найти элемент управления по точке (без обращений к системе)
+	* \param point Точка в координатах клиентской области
+	* \return Указатель на элемент (nullptr если в точке нет видимого элемента)
+	*/
+	ControlBase* Window::GetControlAt(const Vector2D<int>& point) const
+	{
+		const int id = this->controls_.HitTest(point);
+		return id >= 0 ? this->controls_.GetOwner(static_cast<unsigned int>(id)) : nullptr;
+	}
+
+	/**
+	* \brief Получить хранилище геометрии элементов окна (только для чтения)
+	* \return Ссылка на хранилище
+	*/
+	const GeometryStore& Window::GetControlGeometry() const
+	{
+		return this->controls_;
+	}
+
+	/**
+	* \brief Запустить однократный таймер окна
+	* \param delay Задержка (мс)
+	* \param callback Функция обратного вызова
+	* \return Идентификатор таймера
+	*/
+	TimerId Window::SetTimeout(unsigned int delay, std::function<void()> callback)
+	{
+		return GetTimerWheel().Schedule(GetTimerClock() + delay, 0, std::move(callback), this);
+	}
+
+	/**
+	* \brief Запустить периодический таймер окна
+	* \param interval Период (мс)
+	* \param callback Функция обратного вызова
+	* \return Идентификатор таймера
+	*/
+	TimerId Window::SetInterval(unsigned int interval, std::function<void()> callback)
+	{
+		return GetTimerWheel().Schedule(GetTimerClock() + interval, (std::max)(interval, 1u), std::move(callback), this);
+	}
+
+	/**
+	* \brief Остановить таймер
+	* \param id Идентификатор таймера
+	* \return Был ли таймер запущен
+	*/
+	bool Window::CancelTimer(TimerId id)
+	{
+		return GetTimerWheel().Cancel(id);
+	}
+
+	/**
+	* \brief Включить или выключить объединение движений мыши
+	* \param enabled Состояние
+	*/
+	void Window::SetMouseCoalescing(bool enabled)
+	{
+		this->coalesceMouse_ = enabled;
+		if (!enabled) this->FlushMouseSamples();
+	}
+
+	/**
+	* \brief Включено ли объединение движений мыши
 	* \return Состояние
 	*/
-	BOOL Window::EnumerateResizingControls(HWND hWnd, LPARAM lParam)
+	bool Window::IsMouseCoalescing() const
+	{
+		return this->coalesceMouse_;
+	}
+
+	/**
+	* \brief Получить последнее известное положение курсора (в том числе еще не доставленное пакетом)
+	* \return Положение в клиентской области
+	*/
+	Vector2D<int> Window::GetCursorPosition() const
+	{
+		return this->cursor_;
+	}
+
+	/**
+	* \brief Доставить накопленные движения мыши окна (если они есть)
+	*/
+	void Window::FlushMouseSamples()
 	{
-		// Наименование класса элемента управления (строка на 255 символов)
-		char className[255];
+		if (!this->mouseQueued_) return;
 
-		// Если удалось получить наименование класса
-		if (GetClassNameA(hWnd, className, 255))
+		mouseInputWindows_.erase(std::find(mouseInputWindows_.begin(), mouseInputWindows_.end(), this));
+		this->mouseQueued_ = false;
+
+		// Пакет обменивается с буфером накопления: движения, пришедшие во время доставки, попадут в следующий пакет
+		this->mouseBatch_.swap(this->mouseSamples_);
+		this->mouseSamples_.clear();
+
+		if (!this->mouseBatch_.empty())
+		{
+			WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_MOUSE_MOVE);
+			this->events.onMouseMoveBatch(this->mouseBatch_);
+			this->events.onMouseMove(this->mouseBatch_.back().position);
+		}
+	}
+
+	/**
+	* \brief Доставить накопленные движения мыши всех окон (вызывается основным циклом)
+	* \return Кол-во окон, которым были доставлены движения
+	*/
+	size_t Window::FlushMouseInput()
+	{
+		size_t count = 0;
+
+		// Обработчики могут уничтожать окна (окно при этом убирается из списка), поэтому список не перебирается,
+		// а каждый раз берется первое окно
+		while (!mouseInputWindows_.empty())
 		{
-			// Интерпретировать значение lParam как указатель на Vector2D<int>* (дельта смены размеров)
-			Vector2D<int>* sizingDelta = reinterpret_cast<Vector2D<int>*>(lParam);
+			mouseInputWindows_.front()->FlushMouseSamples();
+			count++;
+		}
+
+		return count;
+	}
+
+	/**
+	* \brief Есть ли окна с накопленными движениями мыши
+	* \return Состояние
+	*/
+	bool Window::HasPendingMouseInput()
+	{
+		return !mouseInputWindows_.empty();
+	}
+
+	/**
+	* \brief Запросить перерисовку всей клиентской области
+	*/
+	void Window::Invalidate()
+	{
+		if (!this->hWnd_) return;
+
+		RECT clientAreaRect;
+		GetBackend().GetClientRect(this->hWnd_, &clientAreaRect);
+		this->Invalidate(clientAreaRect);
+	}
 
-			// Если это не окно
-			if (strcmp(className, "WQueryWndClass") != 0)
+	/**
+	* \brief Запросить перерисовку части клиентской области
+	* \param rect Прямоугольник в координатах клиентской области
+	*/
+	void Window::Invalidate(const RECT& rect)
+	{
+		if (!this->hWnd_) return;
+
+		this->dirty_.Add(rect);
+		this->paintRequests_++;
+		paintStatistics_.invalidations++;
+
+		if (!this->paintQueued_) {
+			paintWindows_.push_back(this);
+			this->paintQueued_ = true;
+		}
+	}
+
+	/**
+	* \brief Получить недействительную область, ожидающую перерисовки
+	* \return Ссылка на область
+	*/
+	const DirtyRegion& Window::GetDirtyRegion() const
+	{
+		return this->dirty_;
+	}
+
+	/**
+	* \brief Выполнить отложенную перерисовку окна (если она запрошена)
+	*/
+	void Window::FlushDirtyRegion()
+	{
+		if (!this->paintQueued_) return;
+
+		paintWindows_.erase(std::find(paintWindows_.begin(), paintWindows_.end(), this));
+		this->paintQueued_ = false;
+
+		paintStatistics_.paints++;
+		paintStatistics_.repaintsAvoided += this->paintRequests_ - 1;
+		paintStatistics_.rectsMerged += this->dirty_.GetMergedCount();
+		this->paintRequests_ = 0;
+
+		// Область передается системе и сразу перерисовывается (один WM_PAINT на все запросы итерации)
+		this->paintRegion_.Add(this->dirty_);
+		this->dirty_.Clear();
+
+		for (const RECT& rect : this->paintRegion_.GetRects()) {
+			GetBackend().Invalidate(this->hWnd_, &rect, true);
+		}
+
+		this->paintUpdating_ = true;
+		GetBackend().Update(this->hWnd_);
+		this->paintUpdating_ = false;
+	}
+
+	/**
+	* \brief Выполнить отложенные перерисовки всех окон (вызывается основным циклом)
+	* \return Кол-во перерисованных окон
+	*/
+	size_t Window::FlushPaint()
+	{
+		if (paintWindows_.empty()) return 0;
+
+		WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_LOOP_PAINT);
+		size_t count = 0;
+
+		// Обработчики перерисовки могут уничтожать окна, поэтому каждый раз берется первое окно списка.
+		// Перерисовки, запрошенные самими обработчиками, выполняются в следующей итерации
+		for (size_t remaining = paintWindows_.size(); remaining > 0 && !paintWindows_.empty(); remaining--)
+		{
+			paintWindows_.front()->FlushDirtyRegion();
+			count++;
+		}
+
+		return count;
+	}
+
+	/**
+	* \brief Есть ли окна, ожидающие перерисовки
+	* \return Состояние
+	*/
+	bool Window::HasPendingPaint()
+	{
+		return !paintWindows_.empty();
+	}
+
+	/**
+	* \brief Нарисовать область перерисовки в заднем буфере и вывести его на экран
+	*/
+	void Window::PaintCanvas()
+	{
+		Backend& backend = GetBackend();
+
+		RECT clientAreaRect;
+		backend.GetClientRect(this->hWnd_, &clientAreaRect);
+
+		// Буфер меняет размеры только вслед за клиентской областью, после чего его содержимое не определено
+		// и перерисовывается целиком
+		const Vector2D<int> size(clientAreaRect.right - clientAreaRect.left, clientAreaRect.bottom - clientAreaRect.top);
+		if (this->canvas_.Resize(size))
+		{
+			this->paintRegion_.Clear();
+			this->paintRegion_.Add(clientAreaRect);
+		}
+
+		if (this->canvas_.GetPixels())
+		{
+			// Стирание фона в буфере (только области перерисовки)
+			for (const RECT& rect : this->paintRegion_.GetRects()) {
+				this->canvas_.FillRect(rect, this->backgroundColor_);
+			}
+
+			this->canvas_.SetClip(this->paintRegion_.GetBounds());
 			{
-				// Получить указатель на wQuery объект через значение GWLP_USERDATA у элемента
-				ControlBase * pControl = reinterpret_cast<ControlBase*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+				WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_EVENT_PAINT);
+				this->events.onPaint(this->canvas_, this->paintRegion_);
+				if (this->windowlessCount_ > 0) this->PaintWindowlessControls();
+			}
+			this->canvas_.ResetClip();
+		}
 
-				// Исходные размеры и положение элемента
-				Vector2D<int> sizes = pControl->GetSize();
-				Vector2D<int> position = pControl->GetPosition();
+		const Vector2D<int> canvasSize = this->canvas_.GetSize();
+		backend.PresentPixels(this->hWnd_, this->canvas_.GetPixels(), canvasSize.X, canvasSize.Y);
+		this->paintRegion_.Clear();
+	}
 
-				// Если есть якорь для левого и правого края одновременно - элемент растягивается (меняется размер)
-				if (pControl->GetAnchor().left && pControl->GetAnchor().right)
-				{
-					sizes.X += sizingDelta->X;
-				}
-				// Если есть якорь только правого края - элемент перемещается вместе с краем
-				else if (pControl->GetAnchor().right)
-				{
-					position.X += sizingDelta->X;
-				}
+	/**
+	* \brief Нарисовать элементы без системного окна, пересекающие область перерисовки
+	*/
+	void Window::PaintWindowlessControls()
+	{
+		// Элементы в области находятся проходом по массивам хранилища геометрии (буфер переиспользуется)
+		const RECT bounds = this->paintRegion_.GetBounds();
+		this->paintControls_.clear();
+		this->controls_.Intersect(bounds, GEOMETRY_WINDOWLESS, this->paintControls_);
 
-				// Если есть якорь для верха и низа - элемент растягивается (по вертикали, меняется размер)
-				if(pControl->GetAnchor().top && pControl->GetAnchor().bottom)
-				{
-					sizes.Y += sizingDelta->Y;
-				}
-				// Если есть якорь только для низа - элемент перемещается вместе с низом
-				else if(pControl->GetAnchor().bottom)
-				{
-					position.Y += sizingDelta->Y;
-				}
+		for (unsigned int id : this->paintControls_)
+		{
+			const Vector2D<int> position = this->controls_.GetPosition(id);
+			const Vector2D<int> size = this->controls_.GetSize(id);
+			const RECT rect = { position.X, position.Y, position.X + size.X, position.Y + size.Y };
+
+			// Рисование ограничено пересечением области элемента и области перерисовки
+			this->canvas_.SetClip({
+				(std::max)(rect.left, bounds.left),
+				(std::max)(rect.top, bounds.top),
+				(std::min)(rect.right, bounds.right),
+				(std::min)(rect.bottom, bounds.bottom) });
+
+			this->controls_.GetOwner(id)->PaintWindowless(this->canvas_, rect);
+		}
+	}
 
-				// Установка новых параметров
-				pControl->SetSize(sizes);
-				pControl->SetPosition(position);
+	/**
+	* \brief Передать нажатие или отпускание левой кнопки мыши элементу без системного окна под курсором
+	* \param message Сообщение (WM_LBUTTONDOWN или WM_LBUTTONUP)
+	*/
+	void Window::RouteWindowlessMouse(UINT message)
+	{
+		ControlBase * control = this->windowlessCount_ > 0 ? this->GetControlAt(this->cursor_) : nullptr;
+		if (control && !control->IsWindowless()) control = nullptr;
+
+		if (message == WM_LBUTTONDOWN)
+		{
+			this->pressedControl_ = control;
+
+			// Нажатие передает фокус клавиатуры (окну - чтобы ввод не уходил системному элементу)
+			ControlBase * focused = control && control->IsEnabled() ? control : nullptr;
+			if (focused != this->focusedControl_)
+			{
+				if (this->focusedControl_ && this->focusedControl_->IsWindowless()) this->focusedControl_->InvalidateWindowArea();
+				if (focused) focused->InvalidateWindowArea();
+				this->focusedControl_ = focused;
 			}
+			if (focused) GetBackend().SetFocus(this->hWnd_);
+		}
+		else
+		{
+			// Отпускание засчитывается только над тем же элементом, над которым кнопка была нажата
+			if (control != this->pressedControl_) control = nullptr;
+			this->pressedControl_ = nullptr;
+		}
+
+		if (control && control->IsEnabled()) control->HandleWindowlessMouse(message);
+	}
+
+	/**
+	* \brief Передать прокрутку колеса мыши элементу без системного окна под курсором
+	* \param delta Величина прокрутки
+	*/
+	void Window::RouteWindowlessWheel(int delta)
+	{
+		ControlBase * control = this->windowlessCount_ > 0 ? this->GetControlAt(this->cursor_) : nullptr;
+		if (control && control->IsWindowless() && control->IsEnabled()) control->HandleWindowlessWheel(delta);
+	}
 
+	/**
+	* \brief Передать ввод с клавиатуры элементу без системного окна, получившему фокус нажатием
+	* \param message Сообщение
+	* \param code Код клавиши или символ
+	*/
+	void Window::RouteWindowlessKey(UINT message, WPARAM code)
+	{
+		ControlBase * control = this->focusedControl_;
+		if (control && control->IsWindowless() && control->IsEnabled()) control->HandleWindowlessKey(message, code);
+	}
+
+	/**
+	* \brief Рисует ли окно через задний буфер
+	* \return Статус
+	*/
+	bool Window::UsesCanvas() const
+	{
+		return this->windowlessCount_ > 0 || this->events.onPaint;
+	}
+
+	/**
+	* \brief Получить задний буфер окна
+	* \return Ссылка на холст
+	*/
+	const Canvas& Window::GetCanvas() const
+	{
+		return this->canvas_;
+	}
+
+	/**
+	* \brief Получить статистику отложенной перерисовки (с момента запуска)
+	* \return Статистика
+	*/
+	const PaintStatistics& Window::GetPaintStatistics()
+	{
+		return paintStatistics_;
+	}
+
+	/**
+	* \brief Зарегистрировать элемент управления
+	* \param control Указатель на элемент
+	* \param position Начальное положение
+	* \param size Начальные размеры
+	* \param flags Начальные флаги (GeometryFlags)
+	* \return Идентификатор элемента в хранилище геометрии окна
+	*/
+	unsigned int Window::AttachControl(ControlBase* control, const Vector2D<int>& position, const Vector2D<int>& size, unsigned char flags)
+	{
+		if (flags & GEOMETRY_WINDOWLESS) this->windowlessCount_++;
+		return this->controls_.Add(control, control->hWnd_, position, size, flags);
+	}
+
+	/**
+	* \brief Убрать элемент управления из списка окна
+	* \param control Указатель на элемент
+	*/
+	void Window::DetachControl(ControlBase* control)
+	{
+		const unsigned int id = control->id_;
+		if (this->controls_.HasFlag(id, GEOMETRY_WINDOWLESS)) this->windowlessCount_--;
+		if (this->pressedControl_ == control) this->pressedControl_ = nullptr;
+		if (this->focusedControl_ == control) this->focusedControl_ = nullptr;
+		this->controls_.Remove(id);
+
+		// Места удаленных элементов убираются, когда их становится больше половины (уничтожение всех
+		// элементов формы - O(n), а не O(n^2)). После уплотнения идентификаторы элементов следует обновить
+		if (this->controls_.GetRemovedCount() * 2 > this->controls_.GetCount())
+		{
+			this->controls_.Compact();
+
+			for (unsigned int i = 0; i < this->controls_.GetCount(); i++) {
+				this->controls_.GetOwner(i)->id_ = i;
+			}
 		}
-		return TRUE;
 	}
 }
\ No newline at end of file
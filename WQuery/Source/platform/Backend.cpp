@@ -0,0 +1,115 @@
+﻿/**
+* \brief Выбор платформенного слоя (бэкенда)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/platform/Backend.h>
+#include <wquery/platform/HeadlessBackend.h>
+#include <wquery/platform/Win32Backend.h>
+
+namespace wquery
+{
+	/**
+	* \brief Задать функцию, вызываемую в потоке цикла при пробуждении
+	* \param handler Функция
+	*/
+	void Backend::SetWakeHandler(std::function<void()> handler)
+	{
+		this->wakeHandler_ = std::move(handler);
+	}
+
+	/**
+	* \brief Вызвать функцию пробуждения
+	*/
+	void Backend::HandleWake()
+	{
+		if (this->wakeHandler_) this->wakeHandler_();
+	}
+
+	/**
+	* \brief Установить текст из представления строки
+	* \param hWnd Хендл
+	* \param text Текст
+	*/
+	void Backend::WriteText(HWND hWnd, std::string_view text)
+	{
+		static thread_local std::string terminated;
+		terminated.assign(text.data(), text.size());
+		this->SetText(hWnd, terminated.c_str());
+	}
+
+	/**
+	* \brief Установить текст из представления UTF-16 строки
+	* \param hWnd Хендл
+	* \param text Текст
+	*/
+	void Backend::WriteText(HWND hWnd, std::u16string_view text)
+	{
+		static thread_local std::u16string terminated;
+		terminated.assign(text.data(), text.size());
+		this->SetTextUtf16(hWnd, terminated.c_str());
+	}
+
+	/**
+	* \brief Прочитать текст в строку
+	* \param hWnd Хендл
+	* \param text Строка для записи
+	*/
+	void Backend::ReadText(HWND hWnd, std::string& text) const
+	{
+		// Запись идет прямо в строку (включая нуль-терминатор на месте text[size()]), затем размер уточняется
+		const size_t length = this->GetTextLength(hWnd);
+		text.resize(length);
+		text.resize(length ? this->GetText(hWnd, &text[0], length + 1) : 0);
+	}
+
+	/**
+	* \brief Прочитать текст в UTF-16 строку
+	* \param hWnd Хендл
+	* \param text Строка для записи
+	*/
+	void Backend::ReadText(HWND hWnd, std::u16string& text) const
+	{
+		const size_t length = this->GetTextLengthUtf16(hWnd);
+		text.resize(length);
+		text.resize(length ? this->GetTextUtf16(hWnd, &text[0], length + 1) : 0);
+	}
+
+	/**
+	* \brief Текущий бэкенд, устанавливается через wquery::SetBackend() либо создается при первом обращении
+	*/
+	static std::unique_ptr<Backend> backend_;
+
+	/**
+	* \brief Создание бэкенда по умолчанию (однократное: GetBackend вызывается и из рабочих потоков через wquery::Post)
+	*/
+	static std::once_flag defaultBackendCreated_;
+
+	/**
+	* \brief Установить бэкенд (вызывается до wquery::Begin)
+	* \param backend Бэкенд (владение передается библиотеке)
+	*/
+	void SetBackend(std::unique_ptr<Backend> backend)
+	{
+		backend_ = std::move(backend);
+	}
+
+	/**
+	* \brief Получить текущий бэкенд
+	* \return Ссылка на бэкенд
+	*/
+	Backend& GetBackend()
+	{
+		std::call_once(defaultBackendCreated_, []()
+		{
+			if (backend_) return;
+#ifdef _WIN32
+			backend_.reset(new Win32Backend());
+#else
+			backend_.reset(new HeadlessBackend());
+#endif
+		});
+
+		return *backend_;
+	}
+}
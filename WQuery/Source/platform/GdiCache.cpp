@@ -0,0 +1,171 @@
+﻿/**
+* \brief Кеш графических объектов (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/platform/GdiCache.h>
+#include <wquery/platform/Backend.h>
+
+namespace wquery
+{
+	/**
+	* \brief Оператор сравнения (для упорядоченного словаря)
+	* \param other Другой ключ
+	* \return Меньше ли данный ключ
+	*/
+	bool GdiCache::FontKey::operator<(const FontKey& other) const
+	{
+		if (this->size != other.size) return this->size < other.size;
+		if (this->bold != other.bold) return this->bold < other.bold;
+		if (this->italic != other.italic) return this->italic < other.italic;
+		return this->family < other.family;
+	}
+
+	/**
+	* \brief Конструктор
+	*/
+	GdiCache::GdiCache() :statistics_({})
+	{}
+
+	/**
+	* \brief Получить кисть заданного цвета (счетчик ссылок увеличивается)
+	* \param color Цвет
+	* \return Хендл кисти (освобождается через ReleaseBrush)
+	*/
+	HBRUSH GdiCache::AcquireBrush(const ColorRGB& color)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+
+		const COLORREF key = color.GetNativeColorRef();
+		auto it = this->brushes_.find(key);
+
+		if (it != this->brushes_.end())
+		{
+			it->second.references++;
+			this->statistics_.brushHits++;
+			return reinterpret_cast<HBRUSH>(it->second.handle);
+		}
+
+		HBRUSH hBrush = GetBackend().CreateBrush(color);
+		this->statistics_.brushMisses++;
+
+		if (hBrush)
+		{
+			this->brushes_[key] = { hBrush, 1 };
+			this->brushKeys_[reinterpret_cast<std::uintptr_t>(hBrush)] = key;
+			this->statistics_.liveBrushes++;
+		}
+
+		return hBrush;
+	}
+
+	/**
+	* \brief Освободить кисть (при освобождении последним пользователем объект удаляется)
+	* \param hBrush Хендл кисти, полученный через AcquireBrush
+	*/
+	void GdiCache::ReleaseBrush(HBRUSH hBrush)
+	{
+		if (!hBrush) return;
+
+		std::lock_guard<std::mutex> lock(this->mutex_);
+
+		auto keyIt = this->brushKeys_.find(reinterpret_cast<std::uintptr_t>(hBrush));
+		if (keyIt == this->brushKeys_.end()) return;
+
+		auto it = this->brushes_.find(keyIt->second);
+		if (--it->second.references == 0)
+		{
+			GetBackend().DeleteObject(hBrush);
+			this->brushes_.erase(it);
+			this->brushKeys_.erase(keyIt);
+			this->statistics_.liveBrushes--;
+		}
+	}
+
+	/**
+	* \brief Получить шрифт с заданными параметрами (счетчик ссылок увеличивается)
+	* \param font Параметры шрифта
+	* \return Хендл шрифта (освобождается через ReleaseFont)
+	*/
+	HFONT GdiCache::AcquireFont(const FontSettings& font)
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+
+		const FontKey key = { font.fontFamilyName ? font.fontFamilyName : "", font.size, font.bold, font.italic };
+		auto it = this->fonts_.find(key);
+
+		if (it != this->fonts_.end())
+		{
+			it->second.references++;
+			this->statistics_.fontHits++;
+			return reinterpret_cast<HFONT>(it->second.handle);
+		}
+
+		HFONT hFont = GetBackend().CreateFontObject(font);
+		this->statistics_.fontMisses++;
+
+		if (hFont)
+		{
+			this->fonts_[key] = { hFont, 1 };
+			this->fontKeys_[reinterpret_cast<std::uintptr_t>(hFont)] = key;
+			this->statistics_.liveFonts++;
+		}
+
+		return hFont;
+	}
+
+	/**
+	* \brief Освободить шрифт (при освобождении последним пользователем объект удаляется)
+	* \param hFont Хендл шрифта, полученный через AcquireFont
+	*/
+	void GdiCache::ReleaseFont(HFONT hFont)
+	{
+		if (!hFont) return;
+
+		std::lock_guard<std::mutex> lock(this->mutex_);
+
+		auto keyIt = this->fontKeys_.find(reinterpret_cast<std::uintptr_t>(hFont));
+		if (keyIt == this->fontKeys_.end()) return;
+
+		auto it = this->fonts_.find(keyIt->second);
+		if (--it->second.references == 0)
+		{
+			GetBackend().DeleteObject(hFont);
+			this->fonts_.erase(it);
+			this->fontKeys_.erase(keyIt);
+			this->statistics_.liveFonts--;
+		}
+	}
+
+	/**
+	* \brief Получить статистику
+	* \return Копия статистики
+	*/
+	GdiCacheStatistics GdiCache::GetStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		return this->statistics_;
+	}
+
+	/**
+	* \brief Сбросить счетчики попаданий и промахов
+	*/
+	void GdiCache::ResetStatistics()
+	{
+		std::lock_guard<std::mutex> lock(this->mutex_);
+		this->statistics_.brushHits = 0;
+		this->statistics_.brushMisses = 0;
+		this->statistics_.fontHits = 0;
+		this->statistics_.fontMisses = 0;
+	}
+
+	/**
+	* \brief Получить общий (на весь процесс) кеш графических объектов
+	* \return Ссылка на кеш
+	*/
+	GdiCache& GetGdiCache()
+	{
+		static GdiCache cache;
+		return cache;
+	}
+}
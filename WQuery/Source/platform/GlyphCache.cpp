@@ -0,0 +1,475 @@
+﻿/**
+* \brief Кеш растеризованных символов и строк текста (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/platform/GlyphCache.h>
+#include <wquery/platform/GdiCache.h>
+
+// Начальная ширина маски атласа
+#define GLYPH_ATLAS_WIDTH 256
+
+// Начальная высота маски атласа
+#define GLYPH_ATLAS_HEIGHT 64
+
+// Промежуток между масками символов в атласе
+#define GLYPH_ATLAS_PADDING 1
+
+namespace wquery
+{
+	/**
+	* \brief Прочитать символ из UTF-8 строки (некорректная последовательность - символ U+FFFD длиной в байт)
+	* \param text Текст
+	* \param position Позиция начала символа (сдвигается на следующий символ)
+	* \return Код символа
+	*/
+	static char32_t DecodeUtf8(std::string_view text, size_t& position)
+	{
+		const unsigned char lead = static_cast<unsigned char>(text[position]);
+		size_t length = 0;
+		char32_t codePoint = 0;
+
+		if (lead < 0x80) { position++; return lead; }
+		else if ((lead & 0xE0) == 0xC0) { length = 2; codePoint = lead & 0x1F; }
+		else if ((lead & 0xF0) == 0xE0) { length = 3; codePoint = lead & 0x0F; }
+		else if ((lead & 0xF8) == 0xF0) { length = 4; codePoint = lead & 0x07; }
+
+		if (length == 0 || position + length > text.size())
+		{
+			position++;
+			return 0xFFFD;
+		}
+
+		for (size_t i = 1; i < length; i++)
+		{
+			const unsigned char next = static_cast<unsigned char>(text[position + i]);
+			if ((next & 0xC0) != 0x80)
+			{
+				position++;
+				return 0xFFFD;
+			}
+			codePoint = (codePoint << 6) | (next & 0x3F);
+		}
+
+		position += length;
+		return codePoint;
+	}
+
+	/*
+	* А Т Л А С
+	*/
+
+	/**
+	* \brief Конструктор
+	* \param metrics Метрики шрифта
+	*/
+	GlyphAtlas::GlyphAtlas(const FontMetrics& metrics) :
+		metrics_(metrics),
+		coverage_(static_cast<size_t>(GLYPH_ATLAS_WIDTH) * GLYPH_ATLAS_HEIGHT, 0),
+		width_(GLYPH_ATLAS_WIDTH),
+		height_(GLYPH_ATLAS_HEIGHT),
+		shelfX_(0),
+		shelfY_(0),
+		shelfHeight_(0),
+		ascii_(),
+		asciiReady_()
+	{}
+
+	/**
+	* \brief Увеличить маску
+	* \param width Новая ширина
+	* \param height Новая высота
+	*/
+	void GlyphAtlas::Grow(const int width, const int height)
+	{
+		// Только высота - строки остаются на месте, новые дописываются в конец
+		if (width == this->width_)
+		{
+			this->coverage_.resize(static_cast<size_t>(width) * height, 0);
+			this->height_ = height;
+			return;
+		}
+
+		std::vector<unsigned char> coverage(static_cast<size_t>(width) * height, 0);
+		for (int y = 0; y < this->height_; y++) {
+			std::memcpy(coverage.data() + static_cast<size_t>(width) * y, this->coverage_.data() + static_cast<size_t>(this->width_) * y, static_cast<size_t>(this->width_));
+		}
+
+		this->coverage_.swap(coverage);
+		this->width_ = width;
+		this->height_ = height;
+	}
+
+	/**
+	* \brief Найти символ
+	* \param codePoint Код символа
+	* \return Указатель на символ (nullptr, если символ еще не растеризован)
+	*/
+	const AtlasGlyph* GlyphAtlas::Find(const char32_t codePoint) const
+	{
+		if (codePoint < 128) return this->asciiReady_[codePoint] ? &this->ascii_[codePoint] : nullptr;
+
+		auto it = this->glyphs_.find(codePoint);
+		return it != this->glyphs_.end() ? &it->second : nullptr;
+	}
+
+	/**
+	* \brief Добавить растеризованный символ
+	* \param codePoint Код символа
+	* \param bitmap Растеризованный символ
+	* \return Ссылка на символ в атласе
+	*/
+	const AtlasGlyph& GlyphAtlas::Add(const char32_t codePoint, const GlyphBitmap& bitmap)
+	{
+		AtlasGlyph glyph = { 0, 0, bitmap.width, bitmap.height, bitmap.left, bitmap.top, bitmap.advance };
+
+		if (bitmap.width > 0 && bitmap.height > 0)
+		{
+			// Символ шире атласа - атлас расширяется (на практике только для очень крупных шрифтов)
+			if (bitmap.width + GLYPH_ATLAS_PADDING > this->width_) {
+				this->Grow(bitmap.width + GLYPH_ATLAS_PADDING, this->height_);
+			}
+
+			// Полка заполнена - начинается новая под ней
+			if (this->shelfX_ + bitmap.width + GLYPH_ATLAS_PADDING > this->width_)
+			{
+				this->shelfY_ += this->shelfHeight_;
+				this->shelfX_ = 0;
+				this->shelfHeight_ = 0;
+			}
+
+			// Не хватает высоты - высота удваивается
+			int height = this->height_;
+			while (this->shelfY_ + bitmap.height + GLYPH_ATLAS_PADDING > height) height *= 2;
+			if (height != this->height_) this->Grow(this->width_, height);
+
+			glyph.x = this->shelfX_;
+			glyph.y = this->shelfY_;
+
+			for (int y = 0; y < bitmap.height; y++)
+			{
+				std::memcpy(
+					this->coverage_.data() + static_cast<size_t>(this->width_) * (glyph.y + y) + glyph.x,
+					bitmap.coverage.data() + static_cast<size_t>(bitmap.width) * y,
+					static_cast<size_t>(bitmap.width));
+			}
+
+			this->shelfX_ += bitmap.width + GLYPH_ATLAS_PADDING;
+			this->shelfHeight_ = (std::max)(this->shelfHeight_, bitmap.height + GLYPH_ATLAS_PADDING);
+		}
+
+		if (codePoint < 128)
+		{
+			this->ascii_[codePoint] = glyph;
+			this->asciiReady_[codePoint] = true;
+			return this->ascii_[codePoint];
+		}
+
+		return this->glyphs_[codePoint] = glyph;
+	}
+
+	/**
+	* \brief Получить метрики шрифта
+	* \return Метрики
+	*/
+	const FontMetrics& GlyphAtlas::GetMetrics() const
+	{
+		return this->metrics_;
+	}
+
+	/**
+	* \brief Получить маску покрытия
+	* \return Указатель на первый байт верхней строки
+	*/
+	const unsigned char* GlyphAtlas::GetCoverage() const
+	{
+		return this->coverage_.data();
+	}
+
+	/**
+	* \brief Получить ширину маски
+	* \return Ширина
+	*/
+	int GlyphAtlas::GetWidth() const
+	{
+		return this->width_;
+	}
+
+	/**
+	* \brief Получить высоту маски
+	* \return Высота
+	*/
+	int GlyphAtlas::GetHeight() const
+	{
+		return this->height_;
+	}
+
+	/*
+	* К Е Ш
+	*/
+
+	/**
+	* \brief Оператор сравнения (для упорядоченного словаря)
+	* \param other Другой ключ
+	* \return Меньше ли данный ключ
+	*/
+	bool GlyphCache::AtlasKey::operator<(const AtlasKey& other) const
+	{
+		if (this->size != other.size) return this->size < other.size;
+		if (this->bold != other.bold) return this->bold < other.bold;
+		if (this->italic != other.italic) return this->italic < other.italic;
+		return this->family < other.family;
+	}
+
+	/**
+	* \brief Конструктор
+	*/
+	GlyphCache::GlyphCache() :
+		runCapacity_(DEFAULT_RUN_CAPACITY),
+		lookupAtlas_({ std::string(), 0, false, false }),
+		statistics_({})
+	{}
+
+	/**
+	* \brief Найти атлас шрифта
+	* \details Шрифт удерживается все время жизни атласа: иначе при растеризации новых символов шрифт, которым
+	* больше никто не пользуется, создавался бы и удалялся заново
+	* \param font Параметры шрифта
+	* \return Ссылка на запись атласа
+	*/
+	GlyphCache::AtlasEntry& GlyphCache::FindAtlas(const FontSettings& font)
+	{
+		this->lookupAtlas_.family.assign(font.fontFamilyName ? font.fontFamilyName : "");
+		this->lookupAtlas_.size = font.size;
+		this->lookupAtlas_.bold = font.bold;
+		this->lookupAtlas_.italic = font.italic;
+
+		auto it = this->atlases_.find(this->lookupAtlas_);
+		if (it != this->atlases_.end()) return it->second;
+
+		// Метрики запрашиваются один раз при создании атласа
+		FontMetrics metrics = {};
+		HFONT hFont = GetGdiCache().AcquireFont(font);
+		if (hFont) GetBackend().GetFontMetrics(hFont, metrics);
+
+		AtlasEntry& entry = this->atlases_[this->lookupAtlas_];
+		entry.atlas.reset(new GlyphAtlas(metrics));
+		entry.hFont = hFont;
+		this->statistics_.atlases++;
+		this->statistics_.atlasBytes += static_cast<size_t>(entry.atlas->GetWidth() * entry.atlas->GetHeight());
+		return entry;
+	}
+
+	/**
+	* \brief Получить атлас шрифта
+	* \param font Параметры шрифта
+	* \return Ссылка на атлас
+	*/
+	GlyphAtlas& GlyphCache::GetAtlas(const FontSettings& font)
+	{
+		return *this->FindAtlas(font).atlas;
+	}
+
+	/**
+	* \brief Разложить текст на символы, растеризуя недостающие
+	* \param text Текст
+	* \param entry Атлас шрифта
+	* \param run Разложенная строка
+	*/
+	void GlyphCache::Shape(std::string_view text, const AtlasEntry& entry, TextRun& run)
+	{
+		GlyphAtlas& atlas = *entry.atlas;
+		const FontMetrics& metrics = atlas.GetMetrics();
+		const int atlasBytes = atlas.GetWidth() * atlas.GetHeight();
+		GlyphBitmap bitmap = {};
+		int x = 0, y = 0;
+
+		run.atlas = &atlas;
+		run.glyphs.clear();
+		run.size = Vector2D<int>(0, metrics.lineHeight);
+
+		for (size_t position = 0; position < text.size();)
+		{
+			const char32_t codePoint = DecodeUtf8(text, position);
+
+			if (codePoint == U'\n')
+			{
+				x = 0;
+				y += metrics.lineHeight;
+				run.size.Y += metrics.lineHeight;
+				continue;
+			}
+
+			const AtlasGlyph* glyph = atlas.Find(codePoint);
+
+			if (glyph) this->statistics_.glyphHits++;
+			else
+			{
+				this->statistics_.glyphMisses++;
+
+				if (!entry.hFont || !GetBackend().RasterizeGlyph(entry.hFont, codePoint, bitmap)) bitmap = {};
+				glyph = &atlas.Add(codePoint, bitmap);
+			}
+
+			if (glyph->width > 0) run.glyphs.push_back({ glyph, x, y });
+			x += glyph->advance;
+			run.size.X = (std::max)(run.size.X, x);
+		}
+
+		this->statistics_.atlasBytes += static_cast<size_t>(atlas.GetWidth() * atlas.GetHeight() - atlasBytes);
+
+		Compose(run);
+	}
+
+	/**
+	* \brief Свести маски символов разложенной строки в общую маску
+	* \param run Разложенная строка
+	*/
+	void GlyphCache::Compose(TextRun& run)
+	{
+		const int ascent = run.atlas->GetMetrics().ascent;
+		run.bounds = { 0, 0, 0, 0 };
+		run.coverage.clear();
+
+		if (run.glyphs.empty()) return;
+
+		// Границы - объединение масок всех символов (маски курсива и выносных элементов могут выходить за ячейку)
+		run.bounds = { (std::numeric_limits<LONG>::max)(), (std::numeric_limits<LONG>::max)(), (std::numeric_limits<LONG>::min)(), (std::numeric_limits<LONG>::min)() };
+		for (const TextRun::Glyph& item : run.glyphs)
+		{
+			const int left = item.x + item.glyph->left;
+			const int top = ascent + item.y - item.glyph->top;
+			run.bounds.left = (std::min)(run.bounds.left, static_cast<LONG>(left));
+			run.bounds.top = (std::min)(run.bounds.top, static_cast<LONG>(top));
+			run.bounds.right = (std::max)(run.bounds.right, static_cast<LONG>(left + item.glyph->width));
+			run.bounds.bottom = (std::max)(run.bounds.bottom, static_cast<LONG>(top + item.glyph->height));
+		}
+
+		const size_t pitch = static_cast<size_t>(run.bounds.right - run.bounds.left);
+		run.coverage.assign(pitch * static_cast<size_t>(run.bounds.bottom - run.bounds.top), 0);
+
+		// Перекрывающиеся маски соседних символов объединяются по максимуму покрытия
+		const unsigned char* source = run.atlas->GetCoverage();
+		const size_t sourcePitch = static_cast<size_t>(run.atlas->GetWidth());
+
+		for (const TextRun::Glyph& item : run.glyphs)
+		{
+			const AtlasGlyph& glyph = *item.glyph;
+			const int left = item.x + glyph.left - run.bounds.left;
+			const int top = ascent + item.y - glyph.top - run.bounds.top;
+
+			for (int y = 0; y < glyph.height; y++)
+			{
+				const unsigned char* from = source + sourcePitch * (glyph.y + y) + glyph.x;
+				unsigned char* to = run.coverage.data() + pitch * (top + y) + left;
+				for (int x = 0; x < glyph.width; x++) to[x] = (std::max)(to[x], from[x]);
+			}
+		}
+	}
+
+	/**
+	* \brief Получить разложенную на символы строку
+	* \param text Текст
+	* \param font Параметры шрифта
+	* \return Ссылка на строку
+	*/
+	const TextRun& GlyphCache::GetRun(std::string_view text, const FontSettings& font)
+	{
+		const AtlasEntry& atlas = this->FindAtlas(font);
+
+		// Ключ - адрес атласа (однозначно задает шрифт) и текст
+		const GlyphAtlas* atlasAddress = atlas.atlas.get();
+		this->lookupRun_.assign(reinterpret_cast<const char*>(&atlasAddress), sizeof(atlasAddress));
+		this->lookupRun_.append(text.data(), text.size());
+
+		auto it = this->runIndex_.find(this->lookupRun_);
+		if (it != this->runIndex_.end())
+		{
+			this->statistics_.runHits++;
+			this->runs_.splice(this->runs_.begin(), this->runs_, it->second);
+			return it->second->run;
+		}
+
+		this->statistics_.runMisses++;
+
+		// Вытесняется самая давно использованная строка, ее память переиспользуется
+		if (this->runs_.size() >= this->runCapacity_)
+		{
+			this->runIndex_.erase(this->runs_.back().key);
+			this->runs_.splice(this->runs_.begin(), this->runs_, std::prev(this->runs_.end()));
+			this->statistics_.runEvictions++;
+		}
+		else
+		{
+			this->runs_.emplace_front();
+		}
+
+		RunEntry& entry = this->runs_.front();
+		entry.key.assign(this->lookupRun_);
+		this->Shape(text, atlas, entry.run);
+		this->runIndex_.emplace(entry.key, this->runs_.begin());
+
+		return entry.run;
+	}
+
+	/**
+	* \brief Установить емкость кеша строк
+	* \param capacity Максимальное кол-во строк
+	*/
+	void GlyphCache::SetRunCapacity(const size_t capacity)
+	{
+		this->runCapacity_ = (std::max)(capacity, static_cast<size_t>(1));
+
+		while (this->runs_.size() > this->runCapacity_)
+		{
+			this->runIndex_.erase(this->runs_.back().key);
+			this->runs_.pop_back();
+			this->statistics_.runEvictions++;
+		}
+	}
+
+	/**
+	* \brief Удалить все атласы и строки
+	*/
+	void GlyphCache::Clear()
+	{
+		this->runIndex_.clear();
+		this->runs_.clear();
+
+		for (auto& atlas : this->atlases_) GetGdiCache().ReleaseFont(atlas.second.hFont);
+		this->atlases_.clear();
+		this->statistics_.atlases = 0;
+		this->statistics_.atlasBytes = 0;
+	}
+
+	/**
+	* \brief Получить статистику
+	* \return Копия статистики
+	*/
+	GlyphCacheStatistics GlyphCache::GetStatistics() const
+	{
+		return this->statistics_;
+	}
+
+	/**
+	* \brief Сбросить счетчики попаданий, промахов и вытеснений
+	*/
+	void GlyphCache::ResetStatistics()
+	{
+		this->statistics_.glyphHits = 0;
+		this->statistics_.glyphMisses = 0;
+		this->statistics_.runHits = 0;
+		this->statistics_.runMisses = 0;
+		this->statistics_.runEvictions = 0;
+	}
+
+	/**
+	* \brief Получить общий (на весь процесс) кеш символов
+	* \return Ссылка на кеш
+	*/
+	GlyphCache& GetGlyphCache()
+	{
+		static GlyphCache cache;
+		return cache;
+	}
+}
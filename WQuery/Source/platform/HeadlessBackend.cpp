@@ -0,0 +1,1298 @@
+﻿/**
+* \brief Headless-бэкенд (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/platform/HeadlessBackend.h>
+#include <wquery/tools/utf.h>
+
+// Максимальный размер окна, который сообщается оконной процедуре в WM_GETMINMAXINFO
+#define HEADLESS_MAX_TRACK_SIZE 100000
+
+namespace wquery
+{
+	/**
+	* \brief Встроенный растровый шрифт 5x7 для символов ASCII 0x20..0x7E
+	* \details Каждый символ - 5 столбцов слева направо, младший бит столбца - верхняя строка. Шрифт заменяет
+	* системную растеризацию, поэтому результаты рисования текста одинаковы на любой машине
+	*/
+	static const unsigned char headlessFont_[95][5] = {
+		{0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+		{0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+		{0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x14,0x08,0x3E,0x08,0x14}, {0x08,0x08,0x3E,0x08,0x08},
+		{0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+		{0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+		{0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+		{0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+		{0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+		{0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+		{0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x01,0x01}, {0x3E,0x41,0x41,0x51,0x32},
+		{0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+		{0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x04,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+		{0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+		{0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F},
+		{0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+		{0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+		{0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+		{0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x08,0x14,0x54,0x54,0x3C},
+		{0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x00,0x7F,0x10,0x28,0x44},
+		{0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+		{0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+		{0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+		{0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+		{0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x08,0x04,0x08,0x10,0x08}
+	};
+
+	/**
+	* \brief Столбцы символа встроенного шрифта (отсутствующие символы - пустой прямоугольник)
+	*/
+	static const unsigned char headlessMissingGlyph_[5] = { 0x7F,0x41,0x41,0x41,0x7F };
+
+	/**
+	* \brief Получить масштаб встроенного шрифта (ячейка 6x8 пикселей на единицу масштаба)
+	* \param font Параметры шрифта
+	* \return Масштаб
+	*/
+	static int GetHeadlessFontScale(const FontSettings& font)
+	{
+		return (std::max)(1, static_cast<int>((font.size + 4) / 8));
+	}
+
+	/**
+	* \brief Конструктор
+	*/
+	HeadlessBackend::HeadlessBackend() :
+		hInstance_(nullptr),
+		wndProc_(nullptr),
+		classBrush_(nullptr),
+		liveNodes_(0),
+		focus_(nullptr),
+		nextObject_(1),
+		defaultFont_(nullptr),
+		time_(0),
+		messageTime_(0)
+	{
+		// Шрифт по умолчанию - системный объект, существует все время жизни бэкенда
+		GdiObject stockFont = {};
+		stockFont.stock = true;
+		stockFont.font = FontSettings("Segoe UI", 15);
+		this->defaultFont_ = reinterpret_cast<HFONT>(this->CreateObject(stockFont));
+	}
+
+	/**
+	* \brief Деструктор
+	*/
+	HeadlessBackend::~HeadlessBackend() = default;
+
+	/**
+	* \brief Получить узел по хендлу
+	* \param hWnd Хендл
+	* \return Указатель на узел (nullptr если не существует)
+	*/
+	HeadlessBackend::Node* HeadlessBackend::GetNode(HWND hWnd) const
+	{
+		const auto index = reinterpret_cast<std::uintptr_t>(hWnd);
+		if (index == 0 || index > this->nodes_.size()) return nullptr;
+		return this->nodes_[index - 1].get();
+	}
+
+	/**
+	* \brief Создать узел
+	* \param className Наименование класса
+	* \param parent Хендл родителя
+	* \param dwStyle Стиль
+	* \param size Размеры
+	* \param isWindow Является ли окном WQuery
+	* \return Хендл
+	*/
+	HWND HeadlessBackend::CreateNode(const std::string& className, HWND parent, DWORD dwStyle, const Vector2D<int>& size, bool isWindow)
+	{
+		// Как и в WinApi - дочерний элемент не может существовать без родителя
+		Node* parentNode = this->GetNode(parent);
+		if (parent && !parentNode) return nullptr;
+		if ((dwStyle & WS_CHILD) && !parentNode) return nullptr;
+
+		std::unique_ptr<Node> node(new Node());
+		node->handle = reinterpret_cast<HWND>(static_cast<std::uintptr_t>(this->nodes_.size() + 1));
+		node->parent = parent;
+		node->className = className;
+		node->style = dwStyle;
+		node->x = 0;
+		node->y = 0;
+		node->width = size.X;
+		node->height = size.Y;
+		node->userData = nullptr;
+		node->font = nullptr;
+		node->isWindow = isWindow;
+		node->minimized = false;
+		node->invalid = false;
+		node->eraseBackground = false;
+
+		if (parentNode) {
+			parentNode->children.push_back(node->handle);
+		}
+
+		HWND handle = node->handle;
+		this->nodes_.push_back(std::move(node));
+		this->liveNodes_++;
+		return handle;
+	}
+
+	/**
+	* \brief Перечислить потомков (рекурсивно)
+	* \param node Узел
+	* \param enumProc Функция обратного вызова
+	* \param lParam Параметр
+	* \return Следует ли продолжать перечисление
+	*/
+	bool HeadlessBackend::EnumNode(const Node* node, WNDENUMPROC enumProc, LPARAM lParam)
+	{
+		// Копия списка, поскольку функция обратного вызова может уничтожать элементы
+		const std::vector<HWND> children = node->children;
+
+		for (HWND child : children)
+		{
+			const Node* childNode = this->GetNode(child);
+			if (!childNode) continue;
+
+			if (!enumProc(child, lParam)) return false;
+			if (!this->EnumNode(childNode, enumProc, lParam)) return false;
+		}
+
+		return true;
+	}
+
+	/**
+	* \brief Оконная процедура стандартных элементов управления
+	* \param node Узел элемента
+	* \param message Идентификатор сообщения
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Результат обработки
+	*/
+	LRESULT HeadlessBackend::ControlProc(Node* node, UINT message, WPARAM wParam, LPARAM lParam)
+	{
+		switch (message)
+		{
+		case WM_SETTEXT:
+			node->text = lParam ? reinterpret_cast<const char*>(lParam) : "";
+
+			// Поле ввода, как и в WinApi, уведомляет родителя о смене текста
+			if (node->className == "Edit" && node->parent) {
+				this->Send(node->parent, WM_COMMAND, MAKEWPARAM(0, EN_CHANGE), reinterpret_cast<LPARAM>(node->handle));
+			}
+			return TRUE;
+
+		case WM_SETFONT:
+			node->font = reinterpret_cast<HFONT>(wParam);
+			if (LOWORD(lParam)) node->invalid = true;
+			return 0;
+
+		default:
+			return 0;
+		}
+	}
+
+	/**
+	* \brief Извлечь синтетическое сообщение WM_PAINT для недействительного окна
+	* \param msg Структура для записи сообщения
+	* \return Было ли извлечено сообщение
+	*/
+	bool HeadlessBackend::PopPaintMessage(MSG* msg)
+	{
+		while (!this->invalidWindows_.empty())
+		{
+			HWND hWnd = this->invalidWindows_.back();
+			this->invalidWindows_.pop_back();
+
+			const Node* node = this->GetNode(hWnd);
+			if (node && node->invalid)
+			{
+				*msg = {};
+				msg->hwnd = hWnd;
+				msg->message = WM_PAINT;
+				msg->time = this->time_;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	* \brief Создать графический объект
+	* \param object Объект
+	* \return Хендл
+	*/
+	HGDIOBJ HeadlessBackend::CreateObject(const GdiObject& object)
+	{
+		const std::uintptr_t handle = this->nextObject_++;
+		this->objects_[handle] = object;
+		return reinterpret_cast<HGDIOBJ>(handle);
+	}
+
+	/**
+	* \brief Получить наименование бэкенда
+	* \return Строка с именем
+	*/
+	const char* HeadlessBackend::GetName() const
+	{
+		return "Headless";
+	}
+
+	/**
+	* \brief Регистрация оконного класса WQuery
+	* \param hInstance Хендл приложения (в headless-режиме не используется)
+	* \param wndProc Оконная процедура
+	* \param bgColor Цвет фона по умолчанию
+	*/
+	void HeadlessBackend::RegisterWindowClass(HINSTANCE hInstance, WNDPROC wndProc, const ColorRGB& bgColor)
+	{
+		// Класс уже зарегистрирован
+		if (this->wndProc_) return;
+
+		this->hInstance_ = hInstance ? hInstance : reinterpret_cast<HINSTANCE>(static_cast<std::uintptr_t>(1));
+		this->wndProc_ = wndProc;
+		this->classBrush_ = this->CreateBrush(bgColor);
+	}
+
+	/**
+	* \brief Получить хендл приложения
+	* \return Хендл приложения
+	*/
+	HINSTANCE HeadlessBackend::GetInstance() const
+	{
+		return this->hInstance_;
+	}
+
+	/**
+	* \brief Создать окно WQuery
+	* \param parent Хендл родительского окна (может быть nullptr)
+	* \param dwStyle Стиль окна
+	* \param position Положение окна
+	* \param size Размеры окна
+	* \param title Заголовок
+	* \return Хендл окна
+	*/
+	HWND HeadlessBackend::CreateWindowHandle(HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* title)
+	{
+		if (!this->wndProc_) return nullptr;
+
+		HWND hWnd = this->CreateNode("WQueryWndClass", parent, dwStyle, size, true);
+		Node* node = this->GetNode(hWnd);
+		if (node)
+		{
+			node->x = position.X;
+			node->y = position.Y;
+			node->text = title ? title : "";
+		}
+
+		return hWnd;
+	}
+
+	/**
+	* \brief Создать дочерний элемент управления
+	* \param className Наименование класса элемента управления
+	* \param parent Хендл родительского окна
+	* \param dwStyle Стиль элемента
+	* \param position Положение элемента
+	* \param size Размеры элемента
+	* \param text Начальный текст (nullptr - без текста)
+	* \return Хендл элемента
+	*/
+	HWND HeadlessBackend::CreateControlHandle(const std::string& className, HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* text)
+	{
+		if (!this->wndProc_) return nullptr;
+
+		HWND hWnd = this->CreateNode(className, parent, dwStyle, size, false);
+		Node* node = this->GetNode(hWnd);
+		if (node)
+		{
+			node->x = position.X;
+			node->y = position.Y;
+			if (text) node->text = text;
+		}
+
+		return hWnd;
+	}
+
+	/**
+	* \brief Уничтожить окно или элемент управления (вместе с дочерними)
+	* \param hWnd Хендл
+	*/
+	void HeadlessBackend::DestroyHandle(HWND hWnd)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return;
+
+		// Сначала уничтожаются дочерние элементы
+		const std::vector<HWND> children = node->children;
+		for (HWND child : children) {
+			this->DestroyHandle(child);
+		}
+
+		if (node->isWindow) {
+			this->Send(hWnd, WM_DESTROY, 0, 0);
+		}
+
+		// Убрать элемент из списка родителя
+		Node* parentNode = this->GetNode(node->parent);
+		if (parentNode)
+		{
+			auto& siblings = parentNode->children;
+			siblings.erase(std::remove(siblings.begin(), siblings.end(), hWnd), siblings.end());
+		}
+
+		this->nodes_[reinterpret_cast<std::uintptr_t>(hWnd) - 1].reset();
+		this->liveNodes_--;
+	}
+
+	/**
+	* \brief Является ли хендл окном WQuery
+	* \param hWnd Хендл
+	* \return Состояние
+	*/
+	bool HeadlessBackend::IsWindowHandle(HWND hWnd) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		return node && node->isWindow;
+	}
+
+	/**
+	* \brief Перечислить все дочерние элементы (включая вложенные)
+	* \param hWnd Хендл родителя
+	* \param enumProc Функция обратного вызова
+	* \param lParam Параметр передаваемый в функцию обратного вызова
+	*/
+	void HeadlessBackend::EnumChildren(HWND hWnd, WNDENUMPROC enumProc, LPARAM lParam)
+	{
+		const Node* node = this->GetNode(hWnd);
+		if (node) this->EnumNode(node, enumProc, lParam);
+	}
+
+	/**
+	* \brief Записать указатель на объект WQuery
+	* \param hWnd Хендл
+	* \param data Указатель
+	*/
+	void HeadlessBackend::SetUserData(HWND hWnd, void* data)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (node) node->userData = data;
+	}
+
+	/**
+	* \brief Получить указатель на объект WQuery
+	* \param hWnd Хендл
+	* \return Указатель
+	*/
+	void* HeadlessBackend::GetUserData(HWND hWnd) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		return node ? node->userData : nullptr;
+	}
+
+	/**
+	* \brief Установить текст окна или элемента (через WM_SETTEXT, как и в WinApi)
+	* \param hWnd Хендл
+	* \param text Текст
+	*/
+	void HeadlessBackend::SetText(HWND hWnd, const char* text)
+	{
+		this->Send(hWnd, WM_SETTEXT, 0, reinterpret_cast<LPARAM>(text));
+	}
+
+	/**
+	* \brief Получить длину текста окна или элемента
+	* \param hWnd Хендл
+	* \return Длина
+	*/
+	size_t HeadlessBackend::GetTextLength(HWND hWnd) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		return node ? node->text.length() : 0;
+	}
+
+	/**
+	* \brief Получить текст окна или элемента
+	* \param hWnd Хендл
+	* \param buffer Буфер для записи
+	* \param capacity Размер буфера с учетом нуль-терминатора
+	* \return Кол-во записанных символов
+	*/
+	size_t HeadlessBackend::GetText(HWND hWnd, char* buffer, size_t capacity) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		if (!node || capacity == 0) return 0;
+
+		const size_t length = (std::min)(node->text.length(), capacity - 1);
+		memcpy(buffer, node->text.data(), length);
+		buffer[length] = '\0';
+		return length;
+	}
+
+	/**
+	* \brief Установить текст окна или элемента в UTF-16 (текст хранится в UTF-8)
+	* \param hWnd Хендл
+	* \param text Текст
+	*/
+	void HeadlessBackend::SetTextUtf16(HWND hWnd, const char16_t* text)
+	{
+		// Буфер перекодирования переиспользуется между вызовами
+		static thread_local std::string utf8;
+		if (!Utf16ToUtf8(std::u16string_view(text ? text : u""), utf8)) utf8.clear();
+		this->SetText(hWnd, utf8.c_str());
+	}
+
+	/**
+	* \brief Получить длину текста окна или элемента в элементах UTF-16
+	* \param hWnd Хендл
+	* \return Длина
+	*/
+	size_t HeadlessBackend::GetTextLengthUtf16(HWND hWnd) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		return node ? Utf16LengthOfUtf8(node->text.data(), node->text.length()) : 0;
+	}
+
+	/**
+	* \brief Получить текст окна или элемента в UTF-16
+	* \param hWnd Хендл
+	* \param buffer Буфер для записи
+	* \param capacity Размер буфера в элементах с учетом нуль-терминатора
+	* \return Кол-во записанных элементов
+	*/
+	size_t HeadlessBackend::GetTextUtf16(HWND hWnd, char16_t* buffer, size_t capacity) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		if (!node || capacity == 0) return 0;
+
+		// Если буфер вмещает наихудший случай - перекодирование идет прямо в него,
+		// иначе через переиспользуемый буфер с последующим усечением (как GetWindowTextW)
+		size_t length;
+		if (capacity > node->text.length())
+		{
+			length = Utf8ToUtf16(node->text.data(), node->text.length(), buffer);
+			if (length == UTF_INVALID) length = 0;
+		}
+		else
+		{
+			static thread_local std::u16string utf16;
+			if (!Utf8ToUtf16(node->text, utf16)) utf16.clear();
+			length = (std::min)(utf16.length(), capacity - 1);
+			memcpy(buffer, utf16.data(), length * sizeof(char16_t));
+		}
+
+		buffer[length] = u'\0';
+		return length;
+	}
+
+	/**
+	* \brief Получить стиль окна или элемента
+	* \param hWnd Хендл
+	* \return Стиль
+	*/
+	DWORD HeadlessBackend::GetStyle(HWND hWnd) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		return node ? node->style : 0;
+	}
+
+	/**
+	* \brief Установить стиль окна или элемента
+	* \param hWnd Хендл
+	* \param dwStyle Стиль
+	*/
+	void HeadlessBackend::SetStyle(HWND hWnd, DWORD dwStyle)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (node) node->style = dwStyle;
+	}
+
+	/**
+	* \brief Установить состояние (активен/не активен)
+	* \param hWnd Хендл
+	* \param state Состояние
+	*/
+	void HeadlessBackend::Enable(HWND hWnd, bool state)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return;
+
+		if (state) node->style &= ~static_cast<DWORD>(WS_DISABLED);
+		else node->style |= WS_DISABLED;
+	}
+
+	/**
+	* \brief Установить фокус ввода (только запоминается, сообщения о смене фокуса не отправляются)
+	* \param hWnd Хендл
+	*/
+	void HeadlessBackend::SetFocus(HWND hWnd)
+	{
+		if (this->GetNode(hWnd)) this->focus_ = hWnd;
+	}
+
+	/**
+	* \brief Получить окно или элемент с фокусом ввода
+	* \return Хендл (nullptr - фокуса нет или он был у уничтоженного узла)
+	*/
+	HWND HeadlessBackend::GetFocus() const
+	{
+		return this->GetNode(this->focus_) ? this->focus_ : nullptr;
+	}
+
+	/**
+	* \brief Установить иконку окна (в headless-режиме иконок нет)
+	*/
+	void HeadlessBackend::SetIcon(HWND, const std::string&, int, int) {}
+
+	/**
+	* \brief Установить состояние пункта системного меню (в headless-режиме меню нет)
+	*/
+	void HeadlessBackend::EnableSysMenuItem(HWND, UINT, bool) {}
+
+	/**
+	* \brief Изменить положение и/или размеры
+	* \details Для окон WQuery, как и в WinApi, размер ограничивается через WM_GETMINMAXINFO,
+	* а после изменения размера окну отправляется WM_SIZE
+	* \param hWnd Хендл
+	* \param x Положение левой стороны
+	* \param y Положение верха
+	* \param width Ширина
+	* \param height Высота
+	* \param flags Флаги SWP_*
+	*/
+	void HeadlessBackend::SetPos(HWND hWnd, int x, int y, int width, int height, UINT flags)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return;
+
+		if (!(flags & SWP_NOMOVE))
+		{
+			node->x = x;
+			node->y = y;
+		}
+
+		if (!(flags & SWP_NOSIZE))
+		{
+			if (node->isWindow)
+			{
+				MINMAXINFO info = {};
+				info.ptMaxTrackSize.x = HEADLESS_MAX_TRACK_SIZE;
+				info.ptMaxTrackSize.y = HEADLESS_MAX_TRACK_SIZE;
+				this->Send(hWnd, WM_GETMINMAXINFO, 0, reinterpret_cast<LPARAM>(&info));
+
+				width = (std::max)(static_cast<int>(info.ptMinTrackSize.x), (std::min)(width, static_cast<int>(info.ptMaxTrackSize.x)));
+				height = (std::max)(static_cast<int>(info.ptMinTrackSize.y), (std::min)(height, static_cast<int>(info.ptMaxTrackSize.y)));
+			}
+
+			const bool changed = node->width != width || node->height != height;
+			node->width = (std::max)(width, 0);
+			node->height = (std::max)(height, 0);
+
+			if (changed && node->isWindow && !node->minimized)
+			{
+				this->Send(hWnd, WM_SIZE, SIZE_RESTORED, MAKELPARAM(node->width, node->height));
+
+				// Как у класса окон WQuery (CS_HREDRAW | CS_VREDRAW) - изменение размеров перерисовывает окно целиком
+				this->Invalidate(hWnd, nullptr, true);
+			}
+		}
+	}
+
+	/**
+	* \brief Изменить положение и размеры группы элементов одним пакетом
+	* \param handles Хендлы элементов
+	* \param positions Новые положения
+	* \param sizes Новые размеры
+	* \param count Кол-во элементов
+	*/
+	void HeadlessBackend::SetPosBatch(const HWND* handles, const Vector2D<int>* positions, const Vector2D<int>* sizes, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			this->SetPos(handles[i], positions[i].X, positions[i].Y, sizes[i].X, sizes[i].Y, SWP_NOZORDER | SWP_NOACTIVATE);
+		}
+	}
+
+	/**
+	* \brief Получить прямоугольник окна в экранных координатах
+	* \param hWnd Хендл
+	* \param rect Прямоугольник
+	* \return Удалось ли получить
+	*/
+	bool HeadlessBackend::GetWindowRect(HWND hWnd, RECT* rect) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		if (!node) return false;
+
+		POINT origin = { node->x, node->y };
+		for (const Node* parent = this->GetNode(node->parent); parent; parent = this->GetNode(parent->parent))
+		{
+			origin.x += parent->x;
+			origin.y += parent->y;
+		}
+
+		rect->left = origin.x;
+		rect->top = origin.y;
+		rect->right = origin.x + node->width;
+		rect->bottom = origin.y + node->height;
+		return true;
+	}
+
+	/**
+	* \brief Получить прямоугольник клиентской области (совпадает с размерами окна)
+	* \param hWnd Хендл
+	* \param rect Прямоугольник
+	* \return Удалось ли получить
+	*/
+	bool HeadlessBackend::GetClientRect(HWND hWnd, RECT* rect) const
+	{
+		const Node* node = this->GetNode(hWnd);
+		if (!node) return false;
+
+		rect->left = 0;
+		rect->top = 0;
+		rect->right = node->minimized ? 0 : node->width;
+		rect->bottom = node->minimized ? 0 : node->height;
+		return true;
+	}
+
+	/**
+	* \brief Получить разницу между размерами окна и клиентской области (рамки нет, всегда нулевая)
+	* \return Размеры рамки
+	*/
+	Vector2D<int> HeadlessBackend::GetFrameSize(DWORD) const
+	{
+		return { 0, 0 };
+	}
+
+	/**
+	* \brief Перевести экранные координаты в координаты клиентской области
+	* \param hWnd Хендл
+	* \param point Точка
+	*/
+	void HeadlessBackend::ScreenToClient(HWND hWnd, POINT* point) const
+	{
+		RECT rect = {};
+		if (this->GetWindowRect(hWnd, &rect))
+		{
+			point->x -= rect.left;
+			point->y -= rect.top;
+		}
+	}
+
+	/**
+	* \brief Изменить состояние отображения
+	* \details Сворачивание и разворачивание сопровождается WM_SIZE, как и в WinApi
+	* \param hWnd Хендл
+	* \param cmdShow Команда SW_*
+	*/
+	void HeadlessBackend::Show(HWND hWnd, int cmdShow)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return;
+
+		if (cmdShow == SW_HIDE)
+		{
+			node->style &= ~static_cast<DWORD>(WS_VISIBLE);
+			return;
+		}
+
+		node->style |= WS_VISIBLE;
+		const bool wasMinimized = node->minimized;
+		node->minimized = cmdShow == SW_SHOWMINIMIZED;
+
+		if (node->isWindow)
+		{
+			if (node->minimized && !wasMinimized) {
+				this->Send(hWnd, WM_SIZE, SIZE_MINIMIZED, 0);
+			}
+			else if (!node->minimized && (wasMinimized || cmdShow == SW_SHOWMAXIMIZED)) {
+				this->Send(hWnd, WM_SIZE, cmdShow == SW_SHOWMAXIMIZED ? SIZE_MAXIMIZED : SIZE_RESTORED, MAKELPARAM(node->width, node->height));
+			}
+
+			this->Invalidate(hWnd, nullptr, true);
+		}
+	}
+
+	/**
+	* \brief Пометить окно как требующее перерисовки
+	* \param hWnd Хендл
+	* \param rect Область (в headless-режиме запоминаются только ее границы)
+	* \param erase Стирать ли фон
+	*/
+	void HeadlessBackend::Invalidate(HWND hWnd, const RECT* rect, bool erase)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return;
+
+		if (!node->invalid && node->isWindow) {
+			this->invalidWindows_.push_back(hWnd);
+		}
+
+		const RECT area = rect ? *rect : RECT{ 0, 0, node->width, node->height };
+		if (!node->invalid) {
+			node->invalidBounds = area;
+		}
+		else {
+			node->invalidBounds.left = (std::min)(node->invalidBounds.left, area.left);
+			node->invalidBounds.top = (std::min)(node->invalidBounds.top, area.top);
+			node->invalidBounds.right = (std::max)(node->invalidBounds.right, area.right);
+			node->invalidBounds.bottom = (std::max)(node->invalidBounds.bottom, area.bottom);
+		}
+
+		node->invalid = true;
+		node->eraseBackground = node->eraseBackground || erase;
+	}
+
+	/**
+	* \brief Немедленно перерисовать окно (если оно недействительно)
+	* \param hWnd Хендл
+	*/
+	void HeadlessBackend::Update(HWND hWnd)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node || !node->invalid) return;
+
+		if (node->isWindow) this->Send(hWnd, WM_PAINT, 0, 0);
+		else node->invalid = false;
+	}
+
+	/**
+	* \brief Запросить однократную перерисовку окна вместе со всеми дочерними элементами
+	* \param hWnd Хендл
+	*/
+	void HeadlessBackend::Redraw(HWND hWnd)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return;
+
+		for (HWND child : node->children)
+		{
+			Node* childNode = this->GetNode(child);
+			if (childNode && !childNode->isWindow) childNode->invalid = true;
+		}
+
+		this->Invalidate(hWnd, nullptr, true);
+	}
+
+	/**
+	* \brief Залить прямоугольник кистью (в headless-режиме поверхности для рисования нет)
+	*/
+	void HeadlessBackend::FillRect(HDC, const RECT*, HBRUSH) {}
+
+	/**
+	* \brief Вывести буфер пикселей в окно (буфер копируется в поверхность узла, \see HeadlessBackend::FindNode)
+	* \param hWnd Хендл
+	* \param pixels Пиксели
+	* \param width Ширина буфера
+	* \param height Высота буфера
+	*/
+	void HeadlessBackend::PresentPixels(HWND hWnd, const std::uint32_t* pixels, const int width, const int height)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return;
+
+		// Аналог BeginPaint - стирание фона и снятие признака недействительности
+		if (node->eraseBackground)
+		{
+			node->eraseBackground = false;
+			this->Send(hWnd, WM_ERASEBKGND, 0, 0);
+		}
+		node->invalid = false;
+		node->presents++;
+
+		const size_t count = pixels ? static_cast<size_t>((std::max)(width, 0)) * (std::max)(height, 0) : 0;
+
+		// Как и у контекста BeginPaint, копирование ограничено недействительной областью
+		// (если размеры поверхности не изменились)
+		if (count && width == node->surfaceWidth && height == node->surfaceHeight)
+		{
+			const LONG left = (std::max)(node->invalidBounds.left, static_cast<LONG>(0));
+			const LONG top = (std::max)(node->invalidBounds.top, static_cast<LONG>(0));
+			const LONG right = (std::min)(node->invalidBounds.right, static_cast<LONG>(width));
+			const LONG bottom = (std::min)(node->invalidBounds.bottom, static_cast<LONG>(height));
+
+			for (LONG y = top; left < right && y < bottom; y++)
+			{
+				const size_t offset = static_cast<size_t>(y) * width + left;
+				std::memcpy(node->surface.data() + offset, pixels + offset, (right - left) * sizeof(std::uint32_t));
+			}
+			return;
+		}
+
+		node->surface.assign(pixels, pixels + count);
+		node->surfaceWidth = count ? width : 0;
+		node->surfaceHeight = count ? height : 0;
+	}
+
+	/**
+	* \brief Создать кисть сплошной заливки
+	* \param color Цвет
+	* \return Хендл кисти
+	*/
+	HBRUSH HeadlessBackend::CreateBrush(const ColorRGB& color)
+	{
+		GdiObject object = {};
+		object.color = color;
+		return reinterpret_cast<HBRUSH>(this->CreateObject(object));
+	}
+
+	/**
+	* \brief Создать шрифт
+	* \param font Параметры шрифта
+	* \return Хендл шрифта
+	*/
+	HFONT HeadlessBackend::CreateFontObject(const FontSettings& font)
+	{
+		GdiObject object = {};
+		object.font = font;
+		object.font.fontFamilyName = this->fontFamilies_.insert(font.fontFamilyName ? font.fontFamilyName : "").first->c_str();
+		return reinterpret_cast<HFONT>(this->CreateObject(object));
+	}
+
+	/**
+	* \brief Получить шрифт по умолчанию
+	* \return Хендл шрифта
+	*/
+	HFONT HeadlessBackend::GetDefaultFont() const
+	{
+		return this->defaultFont_;
+	}
+
+	/**
+	* \brief Получить параметры шрифта
+	* \param hFont Хендл шрифта
+	* \param font Параметры шрифта
+	* \return Удалось ли получить
+	*/
+	bool HeadlessBackend::GetFontSettings(HFONT hFont, FontSettings& font)
+	{
+		auto it = this->objects_.find(reinterpret_cast<std::uintptr_t>(hFont));
+		if (it == this->objects_.end()) return false;
+
+		font = it->second.font;
+		return true;
+	}
+
+	/**
+	* \brief Получить метрики шрифта (встроенный растровый шрифт, масштабированный по размеру)
+	* \param hFont Хендл шрифта
+	* \param metrics Метрики
+	* \return Удалось ли получить
+	*/
+	bool HeadlessBackend::GetFontMetrics(HFONT hFont, FontMetrics& metrics)
+	{
+		auto it = this->objects_.find(reinterpret_cast<std::uintptr_t>(hFont));
+		if (it == this->objects_.end()) return false;
+
+		const int scale = GetHeadlessFontScale(it->second.font);
+		metrics.ascent = 7 * scale;
+		metrics.descent = scale;
+		metrics.lineHeight = 8 * scale;
+		return true;
+	}
+
+	/**
+	* \brief Растеризовать символ встроенным растровым шрифтом
+	* \details Полужирный шрифт дублирует каждый столбец со сдвигом на пиксель, курсив сдвигает строки вправо
+	* пропорционально высоте над базовой линией
+	* \param hFont Хендл шрифта
+	* \param codePoint Код символа
+	* \param glyph Растеризованный символ
+	* \return Удалось ли растеризовать
+	*/
+	bool HeadlessBackend::RasterizeGlyph(HFONT hFont, char32_t codePoint, GlyphBitmap& glyph)
+	{
+		auto it = this->objects_.find(reinterpret_cast<std::uintptr_t>(hFont));
+		if (it == this->objects_.end()) return false;
+
+		const FontSettings& font = it->second.font;
+		const int scale = GetHeadlessFontScale(font);
+		const unsigned char* columns = codePoint >= 0x20 && codePoint <= 0x7E ? headlessFont_[codePoint - 0x20] : headlessMissingGlyph_;
+
+		glyph.advance = 6 * scale;
+		glyph.left = 0;
+		glyph.top = 7 * scale;
+
+		// Пробел - только смещение
+		if (codePoint == U' ')
+		{
+			glyph.width = glyph.height = 0;
+			glyph.coverage.clear();
+			return true;
+		}
+
+		const int height = 7 * scale;
+		const int slant = font.italic ? (height - 1) / 4 : 0;
+		glyph.width = 5 * scale + (font.bold ? 1 : 0) + slant;
+		glyph.height = height;
+		glyph.coverage.assign(static_cast<size_t>(glyph.width) * glyph.height, 0);
+
+		for (int y = 0; y < height; y++)
+		{
+			unsigned char* row = glyph.coverage.data() + static_cast<size_t>(glyph.width) * y;
+			const int shift = font.italic ? (height - 1 - y) / 4 : 0;
+
+			for (int x = 0; x < 5 * scale; x++)
+			{
+				if (!(columns[x / scale] & (1 << (y / scale)))) continue;
+				row[x + shift] = 255;
+				if (font.bold) row[x + shift + 1] = 255;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	* \brief Удалить графический объект (системные объекты не удаляются)
+	* \param object Хендл объекта
+	*/
+	void HeadlessBackend::DeleteObject(HGDIOBJ object)
+	{
+		auto it = this->objects_.find(reinterpret_cast<std::uintptr_t>(object));
+		if (it != this->objects_.end() && !it->second.stock) {
+			this->objects_.erase(it);
+		}
+	}
+
+	/**
+	* \brief Отправить сообщение и дождаться его обработки
+	* \details Окна WQuery обрабатываются зарегистрированной оконной процедурой,
+	* элементы управления - встроенной процедурой бэкенда
+	* \param hWnd Хендл получателя
+	* \param message Идентификатор сообщения
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Результат обработки
+	*/
+	LRESULT HeadlessBackend::Send(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return 0;
+
+		if (node->isWindow) {
+			return this->wndProc_(hWnd, message, wParam, lParam);
+		}
+
+		return this->ControlProc(node, message, wParam, lParam);
+	}
+
+	/**
+	* \brief Поместить сообщение в очередь (потокобезопасно)
+	* \param hWnd Хендл получателя
+	* \param message Идентификатор сообщения
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Удалось ли поместить
+	*/
+	bool HeadlessBackend::Post(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+	{
+		MSG msg = {};
+		msg.hwnd = hWnd;
+		msg.message = message;
+		msg.wParam = wParam;
+		msg.lParam = lParam;
+		msg.time = this->time_;
+
+		{
+			std::lock_guard<std::mutex> lock(this->queueMutex_);
+			this->queue_.push_back(msg);
+		}
+
+		this->queueCondition_.notify_one();
+		return true;
+	}
+
+	/**
+	* \brief Обработка сообщения по умолчанию
+	* \param hWnd Хендл получателя
+	* \param message Идентификатор сообщения
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Результат обработки
+	*/
+	LRESULT HeadlessBackend::DefaultProc(HWND hWnd, UINT message, WPARAM, LPARAM lParam)
+	{
+		Node* node = this->GetNode(hWnd);
+		if (!node) return 0;
+
+		switch (message)
+		{
+		case WM_SETTEXT:
+			node->text = lParam ? reinterpret_cast<const char*>(lParam) : "";
+			return TRUE;
+
+		case WM_PAINT:
+			// Аналог BeginPaint/EndPaint - стирание фона и снятие признака недействительности
+			if (node->eraseBackground)
+			{
+				node->eraseBackground = false;
+				this->Send(hWnd, WM_ERASEBKGND, 0, 0);
+			}
+			node->invalid = false;
+			return 0;
+
+		default:
+			return 0;
+		}
+	}
+
+	/**
+	* \brief Поместить в очередь сообщение о выходе
+	* \param exitCode Код выхода
+	*/
+	void HeadlessBackend::PostQuit(int exitCode)
+	{
+		this->Post(nullptr, WM_QUIT, static_cast<WPARAM>(exitCode), 0);
+	}
+
+	/**
+	* \brief Получить сообщение из очереди (блокирует до получения)
+	* \details Как и в WinApi, WM_PAINT генерируется только когда очередь пуста
+	* \param msg Структура для записи сообщения
+	* \return false если было получено сообщение WM_QUIT
+	*/
+	bool HeadlessBackend::GetNextMessage(MSG* msg)
+	{
+		while (true)
+		{
+			if (this->PeekNextMessage(msg)) {
+				return msg->message != WM_QUIT;
+			}
+
+			std::unique_lock<std::mutex> lock(this->queueMutex_);
+			this->queueCondition_.wait(lock, [this]() { return !this->queue_.empty(); });
+		}
+	}
+
+	/**
+	* \brief Получить сообщение из очереди, если оно есть
+	* \param msg Структура для записи сообщения
+	* \return Было ли получено сообщение
+	*/
+	bool HeadlessBackend::PeekNextMessage(MSG* msg)
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->queueMutex_);
+			if (!this->queue_.empty())
+			{
+				*msg = this->queue_.front();
+				this->queue_.pop_front();
+				return true;
+			}
+		}
+
+		return this->PopPaintMessage(msg);
+	}
+
+	/**
+	* \brief Ожидать появления сообщения в очереди (ожидание идет в реальном времени, а не в виртуальном)
+	* \param timeoutMicroseconds Максимальное время ожидания в микросекундах (0 - только проверить)
+	* \return Есть ли сообщение (false - время ожидания истекло)
+	*/
+	bool HeadlessBackend::WaitForMessage(unsigned int timeoutMicroseconds)
+	{
+		// Очередь WM_PAINT пополняется только из потока цикла, блокировка для нее не нужна
+		if (!this->invalidWindows_.empty()) {
+			return true;
+		}
+
+		std::unique_lock<std::mutex> lock(this->queueMutex_);
+		return this->queueCondition_.wait_for(lock, std::chrono::microseconds(timeoutMicroseconds), [this]() { return !this->queue_.empty(); });
+	}
+
+	/**
+	* \brief Передать сообщение на обработку
+	* \param msg Сообщение
+	*/
+	void HeadlessBackend::Dispatch(const MSG* msg)
+	{
+		// Время вложенного сообщения (обработанного во время другого) восстанавливается после него
+		const DWORD outerTime = this->messageTime_;
+		this->messageTime_ = msg->time;
+
+		if (msg->hwnd) {
+			this->Send(msg->hwnd, msg->message, msg->wParam, msg->lParam);
+		}
+		else if (msg->message == WM_WQUERY_WAKE) {
+			this->HandleWake();
+		}
+
+		this->messageTime_ = outerTime;
+	}
+
+	/**
+	* \brief Получить время обрабатываемого сообщения
+	* \return Время в миллисекундах (виртуальное)
+	*/
+	DWORD HeadlessBackend::GetCurrentMessageTime() const
+	{
+		return this->messageTime_;
+	}
+
+	/**
+	* \brief Передано ли обрабатываемое сообщение из другого потока
+	* \return Всегда false (Send выполняется в вызывающем потоке, как SendMessage внутри одного потока)
+	*/
+	bool HeadlessBackend::IsCurrentMessageSent() const
+	{
+		return false;
+	}
+
+	/**
+	* \brief Получить текущее время часов сообщений
+	* \return Виртуальное время в миллисекундах
+	*/
+	DWORD HeadlessBackend::GetMessageClock() const
+	{
+		return this->time_;
+	}
+
+	/**
+	* \brief Разбудить основной цикл (сообщение без адресата, обрабатывается в Dispatch)
+	* \return Удалось ли поместить сообщение
+	*/
+	bool HeadlessBackend::Wake()
+	{
+		return this->Post(nullptr, WM_WQUERY_WAKE, 0, 0);
+	}
+
+	/**
+	* \brief Получить состояние окна или элемента
+	* \param hWnd Хендл
+	* \return Указатель на узел (nullptr если не существует)
+	*/
+	const HeadlessBackend::Node* HeadlessBackend::FindNode(HWND hWnd) const
+	{
+		return this->GetNode(hWnd);
+	}
+
+	/**
+	* \brief Кол-во существующих окон и элементов
+	* \return Кол-во
+	*/
+	size_t HeadlessBackend::GetHandleCount() const
+	{
+		return this->liveNodes_;
+	}
+
+	/**
+	* \brief Кол-во существующих графических объектов (без системных)
+	* \return Кол-во
+	*/
+	size_t HeadlessBackend::GetObjectCount() const
+	{
+		size_t count = 0;
+		for (const auto& object : this->objects_) {
+			if (!object.second.stock) count++;
+		}
+		return count;
+	}
+
+	/**
+	* \brief Кол-во сообщений в очереди
+	* \return Кол-во
+	*/
+	size_t HeadlessBackend::GetQueueLength() const
+	{
+		std::lock_guard<std::mutex> lock(this->queueMutex_);
+		return this->queue_.size();
+	}
+
+	/**
+	* \brief Получить текущее виртуальное время
+	* \return Время в миллисекундах
+	*/
+	DWORD HeadlessBackend::GetTime() const
+	{
+		return this->time_;
+	}
+
+	/**
+	* \brief Сдвинуть виртуальное время
+	* \param milliseconds Кол-во миллисекунд
+	*/
+	void HeadlessBackend::AdvanceTime(DWORD milliseconds)
+	{
+		this->time_ += milliseconds;
+	}
+
+	/**
+	* \brief Имитировать нажатие на элемент управления
+	* \param hControl Хендл элемента
+	*/
+	void HeadlessBackend::SimulateClick(HWND hControl)
+	{
+		const Node* node = this->GetNode(hControl);
+		if (node && node->parent) {
+			this->Post(node->parent, WM_COMMAND, MAKEWPARAM(0, BN_CLICKED), reinterpret_cast<LPARAM>(hControl));
+		}
+	}
+
+	/**
+	* \brief Имитировать ввод текста в поле
+	* \param hControl Хендл элемента
+	* \param text Новый текст
+	*/
+	void HeadlessBackend::SimulateTyping(HWND hControl, const std::string& text)
+	{
+		this->SetText(hControl, text.c_str());
+	}
+
+	/**
+	* \brief Имитировать действие мыши
+	* \param hWnd Хендл окна
+	* \param message Идентификатор сообщения
+	* \param x Положение курсора
+	* \param y Положение курсора
+	*/
+	void HeadlessBackend::SimulateMouse(HWND hWnd, UINT message, int x, int y)
+	{
+		this->Post(hWnd, message, 0, MAKELPARAM(x, y));
+	}
+
+	/**
+	* \brief Имитировать прокрутку колеса мыши
+	* \param hWnd Хендл окна
+	* \param delta Величина прокрутки
+	*/
+	void HeadlessBackend::SimulateWheel(HWND hWnd, int delta)
+	{
+		this->Post(hWnd, WM_MOUSEWHEEL, MAKEWPARAM(0, delta), 0);
+	}
+
+	/**
+	* \brief Имитировать нажатие клавиши
+	* \param hWnd Хендл окна
+	* \param code Код клавиши
+	* \param symbol Символ (0 - не печатная клавиша)
+	*/
+	void HeadlessBackend::SimulateKey(HWND hWnd, unsigned int code, char symbol)
+	{
+		this->Post(hWnd, WM_KEYDOWN, code, 0);
+		if (symbol) this->Post(hWnd, WM_CHAR, static_cast<unsigned char>(symbol), 0);
+		this->Post(hWnd, WM_KEYUP, code, 0);
+	}
+
+	/**
+	* \brief Имитировать изменение размеров окна пользователем
+	* \param hWnd Хендл окна
+	* \param width Ширина
+	* \param height Высота
+	*/
+	void HeadlessBackend::SimulateResize(HWND hWnd, int width, int height)
+	{
+		this->SetPos(hWnd, 0, 0, width, height, SWP_NOMOVE);
+	}
+
+	/**
+	* \brief Имитировать закрытие окна пользователем
+	* \param hWnd Хендл окна
+	*/
+	void HeadlessBackend::SimulateClose(HWND hWnd)
+	{
+		this->Post(hWnd, WM_CLOSE, 0, 0);
+	}
+}
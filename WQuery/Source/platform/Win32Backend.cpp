@@ -0,0 +1,888 @@
+﻿/**
+* \brief Бэкенд WinApi (реализация)
+* \details Тонкая обертка над функциями WinApi. Все функции системы вызываются с явным "::",
+* поскольку методы бэкенда повторяют их имена
+*/
+
+#include <wquery/stdafx.h>
+
+#ifdef _WIN32
+
+#include <wquery/platform/Win32Backend.h>
+#include <wquery/tools/text.h>
+
+// Флаг таймера высокого разрешения (отсутствует в заголовках SDK до версии 10.0.17134)
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace wquery
+{
+	/**
+	* \brief Наименование оконного класса WQuery
+	*/
+	static const wchar_t * windowClassName = L"WQueryWndClass";
+
+	/**
+	* \brief Наименование класса служебного окна пробуждения
+	*/
+	static const wchar_t * wakeWindowClassName = L"WQueryWakeWndClass";
+
+	/**
+	* \brief Конструктор
+	*/
+	Win32Backend::Win32Backend() :
+		hInstance_(nullptr),
+		classInfo_({}),
+		waitTimer_(nullptr),
+		wakeWindow_(nullptr),
+		measureDC_(nullptr)
+	{}
+
+	/**
+	* \brief Деструктор
+	*/
+	Win32Backend::~Win32Backend()
+	{
+		if (this->waitTimer_) ::CloseHandle(this->waitTimer_);
+		if (this->wakeWindow_.load()) ::DestroyWindow(this->wakeWindow_.load());
+		if (this->measureDC_) ::DeleteDC(this->measureDC_);
+	}
+
+	/**
+	* \brief Получить наименование бэкенда
+	* \return Строка с именем
+	*/
+	const char* Win32Backend::GetName() const
+	{
+		return "Win32";
+	}
+
+	/**
+	* \brief Регистрация оконного класса WQuery
+	* \param hInstance Хендл текущего приложения (модуля)
+	* \param wndProc Оконная процедура
+	* \param bgColor Цвет фона по умолчанию
+	*/
+	void Win32Backend::RegisterWindowClass(HINSTANCE hInstance, WNDPROC wndProc, const ColorRGB& bgColor)
+	{
+		// Служебное окно пробуждения создается в потоке, вызвавшем Begin (потоке основного цикла).
+		// Окно "только для сообщений" (HWND_MESSAGE) невидимо и не участвует в перечислении окон
+		if (!this->wakeWindow_.load())
+		{
+			const HINSTANCE wakeInstance = hInstance ? hInstance : GetModuleHandle(nullptr);
+
+			WNDCLASSEXW wakeClassInfo = {};
+			if (!GetClassInfoExW(wakeInstance, wakeWindowClassName, &wakeClassInfo))
+			{
+				wakeClassInfo.cbSize = sizeof(WNDCLASSEXW);
+				wakeClassInfo.hInstance = wakeInstance;
+				wakeClassInfo.lpszClassName = wakeWindowClassName;
+				wakeClassInfo.lpfnWndProc = Win32Backend::WakeWndProc;
+				RegisterClassExW(&wakeClassInfo);
+			}
+
+			// Окно публикуется после установки данных: Wake может вызываться из других потоков
+			const HWND wakeWindow = CreateWindowExW(0, wakeWindowClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, wakeInstance, nullptr);
+			if (wakeWindow) SetWindowLongPtr(wakeWindow, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+			this->wakeWindow_.store(wakeWindow, std::memory_order_release);
+		}
+
+		// Попопытаться получить информацию об уже зарегистрированном классе
+		// окон WQuery. Если удалось - прервать выполнение (класс зарегистрирован)
+		WNDCLASSEX registeredClassInfo = {};
+		if (GetClassInfoEx(hInstance, windowClassName, &registeredClassInfo)) {
+			return;
+		}
+
+		// Если хендл приложения не был передан - использовать хендл по умолчанию
+		this->hInstance_ = hInstance ? hInstance : GetModuleHandle(nullptr);
+
+		// Описать новый класс окон при помощи структуры
+		this->classInfo_ = {};
+		this->classInfo_.cbSize = sizeof(WNDCLASSEX);
+		this->classInfo_.style = CS_HREDRAW | CS_VREDRAW;
+		this->classInfo_.cbClsExtra = 0;
+		this->classInfo_.cbWndExtra = 0;
+		this->classInfo_.hInstance = this->hInstance_;
+		this->classInfo_.hIcon = LoadIcon(hInstance, IDI_APPLICATION);
+		this->classInfo_.hCursor = LoadCursor(nullptr, IDC_ARROW);
+		this->classInfo_.hbrBackground = this->CreateBrush(bgColor);
+		this->classInfo_.lpszMenuName = nullptr;
+		this->classInfo_.lpszClassName = windowClassName;
+		this->classInfo_.hIconSm = LoadIcon(hInstance, IDI_APPLICATION);
+		this->classInfo_.lpfnWndProc = wndProc;
+
+		// Регистрация класса окна
+		if (!RegisterClassEx(&this->classInfo_)) {
+			throw std::runtime_error("Can't register new class");
+		}
+	}
+
+	/**
+	* \brief Получить хендл приложения
+	* \return Хендл приложения
+	*/
+	HINSTANCE Win32Backend::GetInstance() const
+	{
+		return this->hInstance_;
+	}
+
+	/**
+	* \brief Создать окно WQuery
+	* \param parent Хендл родительского окна (может быть nullptr)
+	* \param dwStyle Стиль окна
+	* \param position Положение окна
+	* \param size Размеры окна
+	* \param title Заголовок
+	* \return Хендл окна
+	*/
+	HWND Win32Backend::CreateWindowHandle(HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* title)
+	{
+		if (!this->hInstance_) return nullptr;
+
+		// Заголовок в ANSI кодировке (как и в SetWindowTextA)
+		std::wstring wideTitle;
+		if (title && *title)
+		{
+			const int length = MultiByteToWideChar(CP_ACP, 0, title, -1, nullptr, 0);
+			if (length > 0)
+			{
+				wideTitle.resize(static_cast<size_t>(length));
+				MultiByteToWideChar(CP_ACP, 0, title, -1, &wideTitle[0], length);
+				wideTitle.resize(static_cast<size_t>(length - 1));
+			}
+		}
+
+		return CreateWindow(
+			this->classInfo_.lpszClassName,
+			wideTitle.c_str(),
+			dwStyle,
+			position.X, position.Y,
+			size.X, size.Y,
+			parent,
+			NULL,
+			this->hInstance_,
+			NULL);
+	}
+
+	/**
+	* \brief Создать дочерний элемент управления
+	* \param className Наименование WinApi класса элемента управления
+	* \param parent Хендл родительского окна
+	* \param dwStyle Стиль элемента
+	* \param position Положение элемента
+	* \param size Размеры элемента
+	* \param text Начальный текст (nullptr - без текста)
+	* \return Хендл элемента
+	*/
+	HWND Win32Backend::CreateControlHandle(const std::string& className, HWND parent, DWORD dwStyle, const Vector2D<int>& position, const Vector2D<int>& size, const char* text)
+	{
+		if (!this->hInstance_) return nullptr;
+
+		return CreateWindowA(
+			className.c_str(),
+			text,
+			dwStyle,
+			position.X, position.Y,
+			size.X, size.Y,
+			parent,
+			NULL,
+			this->hInstance_,
+			NULL);
+	}
+
+	/**
+	* \brief Уничтожить окно или элемент управления
+	* \param hWnd Хендл
+	*/
+	void Win32Backend::DestroyHandle(HWND hWnd)
+	{
+		DestroyWindow(hWnd);
+	}
+
+	/**
+	* \brief Является ли хендл окном WQuery
+	* \param hWnd Хендл
+	* \return Состояние
+	*/
+	bool Win32Backend::IsWindowHandle(HWND hWnd) const
+	{
+		char className[255];
+		return GetClassNameA(hWnd, className, 255) && strcmp(className, "WQueryWndClass") == 0;
+	}
+
+	/**
+	* \brief Перечислить все дочерние элементы (включая вложенные)
+	* \param hWnd Хендл родителя
+	* \param enumProc Функция обратного вызова
+	* \param lParam Параметр передаваемый в функцию обратного вызова
+	*/
+	void Win32Backend::EnumChildren(HWND hWnd, WNDENUMPROC enumProc, LPARAM lParam)
+	{
+		EnumChildWindows(hWnd, enumProc, lParam);
+	}
+
+	/**
+	* \brief Записать указатель на объект WQuery в поле GWLP_USERDATA
+	* \param hWnd Хендл
+	* \param data Указатель
+	*/
+	void Win32Backend::SetUserData(HWND hWnd, void* data)
+	{
+		SetWindowLongPtr(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(data));
+	}
+
+	/**
+	* \brief Получить указатель на объект WQuery из поля GWLP_USERDATA
+	* \param hWnd Хендл
+	* \return Указатель
+	*/
+	void* Win32Backend::GetUserData(HWND hWnd) const
+	{
+		return hWnd ? reinterpret_cast<void*>(GetWindowLongPtr(hWnd, GWLP_USERDATA)) : nullptr;
+	}
+
+	/**
+	* \brief Установить текст окна или элемента
+	* \param hWnd Хендл
+	* \param text Текст
+	*/
+	void Win32Backend::SetText(HWND hWnd, const char* text)
+	{
+		SetWindowTextA(hWnd, text);
+	}
+
+	/**
+	* \brief Получить длину текста окна или элемента
+	* \param hWnd Хендл
+	* \return Длина
+	*/
+	size_t Win32Backend::GetTextLength(HWND hWnd) const
+	{
+		return static_cast<size_t>(GetWindowTextLengthA(hWnd));
+	}
+
+	/**
+	* \brief Получить текст окна или элемента
+	* \param hWnd Хендл
+	* \param buffer Буфер для записи
+	* \param capacity Размер буфера с учетом нуль-терминатора
+	* \return Кол-во записанных символов
+	*/
+	size_t Win32Backend::GetText(HWND hWnd, char* buffer, size_t capacity) const
+	{
+		return static_cast<size_t>(GetWindowTextA(hWnd, buffer, static_cast<int>(capacity)));
+	}
+
+	/**
+	* \brief Установить текст окна или элемента в UTF-16
+	* \param hWnd Хендл
+	* \param text Текст
+	*/
+	void Win32Backend::SetTextUtf16(HWND hWnd, const char16_t* text)
+	{
+		// На Windows wchar_t - элемент UTF-16
+		SetWindowTextW(hWnd, reinterpret_cast<const wchar_t*>(text));
+	}
+
+	/**
+	* \brief Получить длину текста окна или элемента в элементах UTF-16
+	* \param hWnd Хендл
+	* \return Длина
+	*/
+	size_t Win32Backend::GetTextLengthUtf16(HWND hWnd) const
+	{
+		return static_cast<size_t>(GetWindowTextLengthW(hWnd));
+	}
+
+	/**
+	* \brief Получить текст окна или элемента в UTF-16
+	* \param hWnd Хендл
+	* \param buffer Буфер для записи
+	* \param capacity Размер буфера в элементах с учетом нуль-терминатора
+	* \return Кол-во записанных элементов
+	*/
+	size_t Win32Backend::GetTextUtf16(HWND hWnd, char16_t* buffer, size_t capacity) const
+	{
+		return static_cast<size_t>(GetWindowTextW(hWnd, reinterpret_cast<wchar_t*>(buffer), static_cast<int>(capacity)));
+	}
+
+	/**
+	* \brief Получить стиль окна или элемента
+	* \param hWnd Хендл
+	* \return Стиль
+	*/
+	DWORD Win32Backend::GetStyle(HWND hWnd) const
+	{
+		return static_cast<DWORD>(GetWindowLong(hWnd, GWL_STYLE));
+	}
+
+	/**
+	* \brief Установить стиль окна или элемента
+	* \param hWnd Хендл
+	* \param dwStyle Стиль
+	*/
+	void Win32Backend::SetStyle(HWND hWnd, DWORD dwStyle)
+	{
+		SetWindowLong(hWnd, GWL_STYLE, static_cast<LONG>(dwStyle));
+	}
+
+	/**
+	* \brief Установить состояние (активен/не активен)
+	* \param hWnd Хендл
+	* \param state Состояние
+	*/
+	void Win32Backend::Enable(HWND hWnd, bool state)
+	{
+		EnableWindow(hWnd, state);
+	}
+
+	/**
+	* \brief Установить фокус ввода
+	* \param hWnd Хендл
+	*/
+	void Win32Backend::SetFocus(HWND hWnd)
+	{
+		::SetFocus(hWnd);
+	}
+
+	/**
+	* \brief Получить окно или элемент с фокусом ввода
+	* \return Хендл
+	*/
+	HWND Win32Backend::GetFocus() const
+	{
+		return ::GetFocus();
+	}
+
+	/**
+	* \brief Установить иконку окна из файла
+	* \param hWnd Хендл
+	* \param iconFilename Путь к .ico файлу
+	* \param width Ширина иконки
+	* \param height Высота иконки
+	*/
+	void Win32Backend::SetIcon(HWND hWnd, const std::string& iconFilename, int width, int height)
+	{
+		HANDLE icon = LoadImageA(nullptr, iconFilename.c_str(), IMAGE_ICON, width, height, LR_LOADFROMFILE);
+		if (icon)
+		{
+			SendMessageA(hWnd, WM_SETICON, ICON_BIG, reinterpret_cast<LPARAM>(icon));
+		}
+	}
+
+	/**
+	* \brief Установить состояние пункта системного меню окна
+	* \param hWnd Хендл
+	* \param item Идентификатор пункта
+	* \param enabled Состояние
+	*/
+	void Win32Backend::EnableSysMenuItem(HWND hWnd, UINT item, bool enabled)
+	{
+		if (!enabled)
+			EnableMenuItem(GetSystemMenu(hWnd, FALSE), item, MF_BYCOMMAND | MF_DISABLED | MF_GRAYED);
+		else
+			EnableMenuItem(GetSystemMenu(hWnd, FALSE), item, MF_BYCOMMAND | MF_ENABLED);
+	}
+
+	/**
+	* \brief Изменить положение и/или размеры
+	* \param hWnd Хендл
+	* \param x Положение левой стороны
+	* \param y Положение верха
+	* \param width Ширина
+	* \param height Высота
+	* \param flags Флаги SWP_*
+	*/
+	void Win32Backend::SetPos(HWND hWnd, int x, int y, int width, int height, UINT flags)
+	{
+		SetWindowPos(hWnd, nullptr, x, y, width, height, flags);
+	}
+
+	/**
+	* \brief Изменить положение и размеры группы элементов одним пакетом
+	* \details Используется механизм DeferWindowPos - все элементы перемещаются за одно обращение к системе
+	* \param handles Хендлы элементов
+	* \param positions Новые положения
+	* \param sizes Новые размеры
+	* \param count Кол-во элементов
+	*/
+	void Win32Backend::SetPosBatch(const HWND* handles, const Vector2D<int>* positions, const Vector2D<int>* sizes, size_t count)
+	{
+		if (count == 0) return;
+
+		const UINT flags = SWP_NOZORDER | SWP_NOACTIVATE | SWP_NOREDRAW;
+		HDWP hdwp = BeginDeferWindowPos(static_cast<int>(count));
+
+		for (size_t i = 0; i < count && hdwp; i++) {
+			hdwp = DeferWindowPos(hdwp, handles[i], nullptr, positions[i].X, positions[i].Y, sizes[i].X, sizes[i].Y, flags);
+		}
+
+		// Если пакет не удалось сформировать (не хватило памяти) - элементы перемещаются по одному
+		if (!hdwp || !EndDeferWindowPos(hdwp))
+		{
+			for (size_t i = 0; i < count; i++) {
+				SetWindowPos(handles[i], nullptr, positions[i].X, positions[i].Y, sizes[i].X, sizes[i].Y, flags);
+			}
+		}
+	}
+
+	/**
+	* \brief Получить прямоугольник окна в экранных координатах
+	* \param hWnd Хендл
+	* \param rect Прямоугольник
+	* \return Удалось ли получить
+	*/
+	bool Win32Backend::GetWindowRect(HWND hWnd, RECT* rect) const
+	{
+		return !!::GetWindowRect(hWnd, rect);
+	}
+
+	/**
+	* \brief Получить прямоугольник клиентской области
+	* \param hWnd Хендл
+	* \param rect Прямоугольник
+	* \return Удалось ли получить
+	*/
+	bool Win32Backend::GetClientRect(HWND hWnd, RECT* rect) const
+	{
+		return !!::GetClientRect(hWnd, rect);
+	}
+
+	/**
+	* \brief Получить разницу между размерами окна и клиентской области для стиля
+	* \param dwStyle Стиль окна
+	* \return Суммарная ширина и высота рамки и заголовка
+	*/
+	Vector2D<int> Win32Backend::GetFrameSize(DWORD dwStyle) const
+	{
+		RECT rect = { 0, 0, 0, 0 };
+		if (!AdjustWindowRectEx(&rect, dwStyle, FALSE, 0)) return { 0, 0 };
+		return { rect.right - rect.left, rect.bottom - rect.top };
+	}
+
+	/**
+	* \brief Перевести экранные координаты в координаты клиентской области
+	* \param hWnd Хендл
+	* \param point Точка
+	*/
+	void Win32Backend::ScreenToClient(HWND hWnd, POINT* point) const
+	{
+		::ScreenToClient(hWnd, point);
+	}
+
+	/**
+	* \brief Изменить состояние отображения
+	* \param hWnd Хендл
+	* \param cmdShow Команда SW_*
+	*/
+	void Win32Backend::Show(HWND hWnd, int cmdShow)
+	{
+		ShowWindow(hWnd, cmdShow);
+	}
+
+	/**
+	* \brief Пометить область как требующую перерисовки
+	* \param hWnd Хендл
+	* \param rect Область (nullptr - вся клиентская область)
+	* \param erase Стирать ли фон
+	*/
+	void Win32Backend::Invalidate(HWND hWnd, const RECT* rect, bool erase)
+	{
+		InvalidateRect(hWnd, rect, erase);
+	}
+
+	/**
+	* \brief Немедленно перерисовать недействительную область
+	* \param hWnd Хендл
+	*/
+	void Win32Backend::Update(HWND hWnd)
+	{
+		UpdateWindow(hWnd);
+	}
+
+	/**
+	* \brief Запросить однократную перерисовку окна вместе со всеми дочерними элементами
+	* \param hWnd Хендл
+	*/
+	void Win32Backend::Redraw(HWND hWnd)
+	{
+		RedrawWindow(hWnd, nullptr, nullptr, RDW_INVALIDATE | RDW_ERASE | RDW_ALLCHILDREN);
+	}
+
+	/**
+	* \brief Залить прямоугольник кистью
+	* \param hdc Контекст устройства
+	* \param rect Прямоугольник
+	* \param hBrush Хендл кисти
+	*/
+	void Win32Backend::FillRect(HDC hdc, const RECT* rect, HBRUSH hBrush)
+	{
+		::FillRect(hdc, rect, hBrush);
+	}
+
+	/**
+	* \brief Вывести буфер пикселей в недействительную область окна
+	* \param hWnd Хендл
+	* \param pixels Пиксели
+	* \param width Ширина буфера
+	* \param height Высота буфера
+	*/
+	void Win32Backend::PresentPixels(HWND hWnd, const std::uint32_t* pixels, const int width, const int height)
+	{
+		PAINTSTRUCT ps;
+		HDC hdc = BeginPaint(hWnd, &ps);
+
+		if (pixels && width > 0 && height > 0)
+		{
+			// Отрицательная высота - строки сверху вниз, как в буфере холста
+			BITMAPINFO bitmapInfo = {};
+			bitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+			bitmapInfo.bmiHeader.biWidth = width;
+			bitmapInfo.bmiHeader.biHeight = -height;
+			bitmapInfo.bmiHeader.biPlanes = 1;
+			bitmapInfo.bmiHeader.biBitCount = 32;
+			bitmapInfo.bmiHeader.biCompression = BI_RGB;
+
+			// Контекст BeginPaint отсечен недействительной областью, поэтому копируется только она
+			SetDIBitsToDevice(hdc, 0, 0, width, height, 0, 0, 0, height, pixels, &bitmapInfo, DIB_RGB_COLORS);
+		}
+
+		EndPaint(hWnd, &ps);
+	}
+
+	/**
+	* \brief Создать кисть сплошной заливки
+	* \param color Цвет
+	* \return Хендл кисти
+	*/
+	HBRUSH Win32Backend::CreateBrush(const ColorRGB& color)
+	{
+		return CreateSolidBrush(color.GetNativeColorRef());
+	}
+
+	/**
+	* \brief Создать шрифт
+	* \param font Параметры шрифта
+	* \return Хендл шрифта
+	*/
+	HFONT Win32Backend::CreateFontObject(const FontSettings& font)
+	{
+		return CreateFontA(
+			font.size,
+			FALSE,
+			FALSE,
+			FW_DONTCARE,
+			font.bold ? 600 : 1,
+			font.italic,
+			FALSE,
+			FALSE,
+			ANSI_CHARSET,
+			OUT_TT_PRECIS,
+			CLIP_DEFAULT_PRECIS,
+			DEFAULT_QUALITY,
+			DEFAULT_PITCH | FF_DONTCARE,
+			font.fontFamilyName);
+	}
+
+	/**
+	* \brief Получить шрифт по умолчанию
+	* \return Хендл шрифта
+	*/
+	HFONT Win32Backend::GetDefaultFont() const
+	{
+		return reinterpret_cast<HFONT>(GetStockObject(DEFAULT_GUI_FONT));
+	}
+
+	/**
+	* \brief Получить параметры шрифта
+	* \param hFont Хендл шрифта
+	* \param font Параметры шрифта
+	* \return Удалось ли получить
+	*/
+	bool Win32Backend::GetFontSettings(HFONT hFont, FontSettings& font)
+	{
+		// Структура с информацией о шрифте
+		LOGFONT lf;
+
+		// Если информация о шрифте была получена - вписать необходимые данные
+		if (GetObject(hFont, sizeof(LOGFONT), &lf))
+		{
+			font.bold = lf.lfWeight >= 600;
+			font.size = static_cast<unsigned int>(lf.lfHeight);
+			font.italic = !!lf.lfItalic;
+			font.fontFamilyName = this->fontFamilies_.insert(WideToStr(lf.lfFaceName)).first->c_str();
+			return true;
+		}
+
+		return false;
+	}
+
+	/**
+	* \brief Получить контекст в памяти с выбранным шрифтом
+	* \param hFont Хендл шрифта
+	* \return Контекст
+	*/
+	HDC Win32Backend::SelectMeasureFont(HFONT hFont)
+	{
+		if (!this->measureDC_) this->measureDC_ = ::CreateCompatibleDC(nullptr);
+		if (this->measureDC_) ::SelectObject(this->measureDC_, hFont);
+		return this->measureDC_;
+	}
+
+	/**
+	* \brief Получить метрики шрифта
+	* \param hFont Хендл шрифта
+	* \param metrics Метрики
+	* \return Удалось ли получить
+	*/
+	bool Win32Backend::GetFontMetrics(HFONT hFont, FontMetrics& metrics)
+	{
+		HDC hdc = this->SelectMeasureFont(hFont);
+		TEXTMETRICW tm;
+
+		if (!hdc || !::GetTextMetricsW(hdc, &tm)) return false;
+
+		metrics.ascent = tm.tmAscent;
+		metrics.descent = tm.tmDescent;
+		metrics.lineHeight = tm.tmHeight + tm.tmExternalLeading;
+		return true;
+	}
+
+	/**
+	* \brief Растеризовать символ
+	* \param hFont Хендл шрифта
+	* \param codePoint Код символа
+	* \param glyph Растеризованный символ
+	* \return Удалось ли растеризовать
+	*/
+	bool Win32Backend::RasterizeGlyph(HFONT hFont, char32_t codePoint, GlyphBitmap& glyph)
+	{
+		HDC hdc = this->SelectMeasureFont(hFont);
+		if (!hdc || codePoint > 0xFFFF) return false;
+
+		const MAT2 identity = { {0, 1}, {0, 0}, {0, 0}, {0, 1} };
+		const UINT character = static_cast<UINT>(codePoint);
+		GLYPHMETRICS gm;
+
+		// Маска GGO_GRAY8_BITMAP - 65 уровней покрытия (0..64), строки выровнены по 4 байта
+		const DWORD size = ::GetGlyphOutlineW(hdc, character, GGO_GRAY8_BITMAP, &gm, 0, nullptr, &identity);
+		if (size == GDI_ERROR) return false;
+
+		glyph.advance = gm.gmCellIncX;
+		glyph.left = gm.gmptGlyphOrigin.x;
+		glyph.top = gm.gmptGlyphOrigin.y;
+
+		// Символ без изображения (пробел) - только смещение
+		if (size == 0)
+		{
+			glyph.width = glyph.height = 0;
+			glyph.coverage.clear();
+			return true;
+		}
+
+		std::vector<unsigned char> buffer(size);
+		if (::GetGlyphOutlineW(hdc, character, GGO_GRAY8_BITMAP, &gm, size, buffer.data(), &identity) == GDI_ERROR) return false;
+
+		glyph.width = static_cast<int>(gm.gmBlackBoxX);
+		glyph.height = static_cast<int>(gm.gmBlackBoxY);
+		glyph.coverage.resize(static_cast<size_t>(glyph.width) * glyph.height);
+
+		const size_t pitch = (static_cast<size_t>(glyph.width) + 3) & ~static_cast<size_t>(3);
+		for (int y = 0; y < glyph.height; y++)
+		{
+			const unsigned char* row = buffer.data() + pitch * y;
+			unsigned char* out = glyph.coverage.data() + static_cast<size_t>(glyph.width) * y;
+			for (int x = 0; x < glyph.width; x++) out[x] = static_cast<unsigned char>((row[x] * 255 + 32) / 64);
+		}
+
+		return true;
+	}
+
+	/**
+	* \brief Удалить графический объект
+	* \param object Хендл объекта
+	*/
+	void Win32Backend::DeleteObject(HGDIOBJ object)
+	{
+		::DeleteObject(object);
+	}
+
+	/**
+	* \brief Отправить сообщение и дождаться его обработки
+	* \param hWnd Хендл получателя
+	* \param message Идентификатор сообщения
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Результат обработки
+	*/
+	LRESULT Win32Backend::Send(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+	{
+		return SendMessage(hWnd, message, wParam, lParam);
+	}
+
+	/**
+	* \brief Поместить сообщение в очередь
+	* \param hWnd Хендл получателя
+	* \param message Идентификатор сообщения
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Удалось ли поместить
+	*/
+	bool Win32Backend::Post(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+	{
+		return !!PostMessage(hWnd, message, wParam, lParam);
+	}
+
+	/**
+	* \brief Обработка сообщения по умолчанию
+	* \param hWnd Хендл получателя
+	* \param message Идентификатор сообщения
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Результат обработки
+	*/
+	LRESULT Win32Backend::DefaultProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+	{
+		return DefWindowProc(hWnd, message, wParam, lParam);
+	}
+
+	/**
+	* \brief Поместить в очередь сообщение о выходе
+	* \param exitCode Код выхода
+	*/
+	void Win32Backend::PostQuit(int exitCode)
+	{
+		PostQuitMessage(exitCode);
+	}
+
+	/**
+	* \brief Получить сообщение из очереди (блокирует до получения)
+	* \param msg Структура для записи сообщения
+	* \return false если было получено сообщение WM_QUIT
+	*/
+	bool Win32Backend::GetNextMessage(MSG* msg)
+	{
+		return ::GetMessage(msg, nullptr, 0, 0) > 0;
+	}
+
+	/**
+	* \brief Получить сообщение из очереди, если оно есть
+	* \param msg Структура для записи сообщения
+	* \return Было ли получено сообщение
+	*/
+	bool Win32Backend::PeekNextMessage(MSG* msg)
+	{
+		return !!::PeekMessage(msg, nullptr, 0, 0, PM_REMOVE);
+	}
+
+	/**
+	* \brief Ожидать появления сообщения в очереди
+	* \details Таймаут MsgWaitForMultipleObjectsEx округляется до кванта системного таймера (обычно 15.6 мс),
+	* поэтому для точного пробуждения используется ожидаемый таймер высокого разрешения (Windows 10 1803+).
+	* На старых системах он недоступен, и используется обычный таймер
+	* \param timeoutMicroseconds Максимальное время ожидания в микросекундах (0 - только проверить)
+	* \return Есть ли сообщение (false - время ожидания истекло)
+	*/
+	bool Win32Backend::WaitForMessage(unsigned int timeoutMicroseconds)
+	{
+		if (timeoutMicroseconds == 0) {
+			return ::MsgWaitForMultipleObjectsEx(0, nullptr, 0, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_OBJECT_0;
+		}
+
+		if (!this->waitTimer_)
+		{
+			this->waitTimer_ = ::CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+			if (!this->waitTimer_) this->waitTimer_ = ::CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+		}
+
+		if (this->waitTimer_)
+		{
+			// Отрицательное значение - относительное время в интервалах по 100 нс
+			LARGE_INTEGER dueTime;
+			dueTime.QuadPart = -static_cast<LONGLONG>(timeoutMicroseconds) * 10;
+
+			if (::SetWaitableTimer(this->waitTimer_, &dueTime, 0, nullptr, nullptr, FALSE))
+			{
+				const DWORD result = ::MsgWaitForMultipleObjectsEx(1, &this->waitTimer_, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+				if (result != WAIT_OBJECT_0) ::CancelWaitableTimer(this->waitTimer_);
+				return result == WAIT_OBJECT_0 + 1;
+			}
+		}
+
+		return ::MsgWaitForMultipleObjectsEx(0, nullptr, (timeoutMicroseconds + 999) / 1000, QS_ALLINPUT, MWMO_INPUTAVAILABLE) == WAIT_OBJECT_0;
+	}
+
+	/**
+	* \brief Передать сообщение на обработку
+	* \param msg Сообщение
+	*/
+	void Win32Backend::Dispatch(const MSG* msg)
+	{
+		TranslateMessage(msg);
+		::DispatchMessage(msg);
+	}
+
+	/**
+	* \brief Получить время обрабатываемого сообщения
+	* \return Время в миллисекундах (последнего сообщения, извлеченного GetMessage или PeekMessage)
+	*/
+	DWORD Win32Backend::GetCurrentMessageTime() const
+	{
+		return static_cast<DWORD>(::GetMessageTime());
+	}
+
+	/**
+	* \brief Передано ли обрабатываемое сообщение из другого потока
+	* \return Состояние (InSendMessage)
+	*/
+	bool Win32Backend::IsCurrentMessageSent() const
+	{
+		return ::InSendMessage() != FALSE;
+	}
+
+	/**
+	* \brief Получить текущее время часов сообщений
+	* \return Время в миллисекундах (с запуска системы)
+	*/
+	DWORD Win32Backend::GetMessageClock() const
+	{
+		return ::GetTickCount();
+	}
+
+	/**
+	* \brief Разбудить основной цикл
+	* \details Сообщение адресуется служебному окну, а не потоку (PostThreadMessage): сообщения потока
+	* теряются во вложенных циклах (перетаскивание окна, MessageBox), а сообщения окна доставляются и там.
+	* Служебное окно создается в Begin (в потоке цикла), до этого пробуждение не удается
+	* \return Удалось ли поместить сообщение
+	*/
+	bool Win32Backend::Wake()
+	{
+		const HWND wakeWindow = this->wakeWindow_.load(std::memory_order_acquire);
+		return wakeWindow && PostMessageW(wakeWindow, WM_WQUERY_WAKE, 0, 0) != FALSE;
+	}
+
+	/**
+	* \brief Оконная процедура служебного окна пробуждения
+	* \param hWnd Хендл окна
+	* \param message Сообщение
+	* \param wParam Параметр
+	* \param lParam Параметр
+	* \return Результат обработки
+	*/
+	LRESULT CALLBACK Win32Backend::WakeWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+	{
+		if (message == WM_WQUERY_WAKE)
+		{
+			Win32Backend* backend = reinterpret_cast<Win32Backend*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+			if (backend) backend->HandleWake();
+			return 0;
+		}
+
+		return DefWindowProcW(hWnd, message, wParam, lParam);
+	}
+}
+
+#endif
@@ -0,0 +1,388 @@
+﻿/**
+* \brief Программная поверхность рисования (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/Canvas.h>
+#include <wquery/tools/raster.h>
+#include <wquery/platform/GlyphCache.h>
+
+namespace wquery
+{
+	/**
+	* \brief Конструктор (пустой холст, память не выделяется)
+	*/
+	Canvas::Canvas() :width_(0), height_(0), clip_({ 0, 0, 0, 0 }) {}
+
+	/**
+	* \brief Ограничить прямоугольник областью отсечения
+	* \param rect Прямоугольник
+	* \return Пуст ли результат
+	*/
+	bool Canvas::Clip(RECT& rect) const
+	{
+		rect.left = (std::max)(rect.left, this->clip_.left);
+		rect.top = (std::max)(rect.top, this->clip_.top);
+		rect.right = (std::min)(rect.right, this->clip_.right);
+		rect.bottom = (std::min)(rect.bottom, this->clip_.bottom);
+		return rect.left >= rect.right || rect.top >= rect.bottom;
+	}
+
+	/**
+	* \brief Получить указатель на пиксель (без проверки границ)
+	* \param x Столбец
+	* \param y Строка
+	* \return Указатель
+	*/
+	std::uint32_t* Canvas::PixelAt(const int x, const int y)
+	{
+		return this->pixels_.data() + static_cast<size_t>(y) * this->width_ + x;
+	}
+
+	/**
+	* \brief Изменить размеры холста
+	* \param size Новые размеры
+	* \return Изменились ли размеры
+	*/
+	bool Canvas::Resize(const Vector2D<int>& size)
+	{
+		const int width = (std::max)(size.X, 0);
+		const int height = (std::max)(size.Y, 0);
+		if (width == this->width_ && height == this->height_) return false;
+
+		// При уменьшении вектор память не освобождает, поэтому колебания размеров окна не приводят к выделениям
+		this->pixels_.resize(static_cast<size_t>(width) * height);
+		this->width_ = width;
+		this->height_ = height;
+		this->ResetClip();
+		return true;
+	}
+
+	/**
+	* \brief Получить размеры
+	* \return Размеры
+	*/
+	Vector2D<int> Canvas::GetSize() const
+	{
+		return { this->width_, this->height_ };
+	}
+
+	/**
+	* \brief Получить пиксели (только для чтения)
+	* \return Указатель на первый пиксель верхней строки
+	*/
+	const std::uint32_t* Canvas::GetPixels() const
+	{
+		return this->pixels_.empty() ? nullptr : this->pixels_.data();
+	}
+
+	/**
+	* \brief Получить пиксели
+	* \return Указатель на первый пиксель верхней строки
+	*/
+	std::uint32_t* Canvas::GetPixels()
+	{
+		return this->pixels_.empty() ? nullptr : this->pixels_.data();
+	}
+
+	/**
+	* \brief Установить область отсечения
+	* \param rect Прямоугольник (ограничивается размерами холста)
+	*/
+	void Canvas::SetClip(const RECT& rect)
+	{
+		this->clip_.left = std::clamp<LONG>(rect.left, 0, this->width_);
+		this->clip_.top = std::clamp<LONG>(rect.top, 0, this->height_);
+		this->clip_.right = std::clamp<LONG>(rect.right, this->clip_.left, this->width_);
+		this->clip_.bottom = std::clamp<LONG>(rect.bottom, this->clip_.top, this->height_);
+	}
+
+	/**
+	* \brief Сбросить область отсечения на весь холст
+	*/
+	void Canvas::ResetClip()
+	{
+		this->clip_ = { 0, 0, this->width_, this->height_ };
+	}
+
+	/**
+	* \brief Получить область отсечения
+	* \return Прямоугольник
+	*/
+	const RECT& Canvas::GetClip() const
+	{
+		return this->clip_;
+	}
+
+	/**
+	* \brief Залить область отсечения цветом
+	* \param color Цвет
+	*/
+	void Canvas::Clear(const ColorRGB& color)
+	{
+		this->FillRect(this->clip_, color);
+	}
+
+	/**
+	* \brief Установить цвет пикселя
+	* \param x Столбец
+	* \param y Строка
+	* \param color Цвет
+	*/
+	void Canvas::SetPixel(const int x, const int y, const ColorRGB& color)
+	{
+		if (x < this->clip_.left || x >= this->clip_.right || y < this->clip_.top || y >= this->clip_.bottom) return;
+
+		if (color.A == 255) *this->PixelAt(x, y) = PackPixel(color);
+		else BlendSolidPixels(this->PixelAt(x, y), 1, color.GetPremultiplied());
+	}
+
+	/**
+	* \brief Получить цвет пикселя
+	* \param x Столбец
+	* \param y Строка
+	* \return Цвет (черный за пределами холста)
+	*/
+	ColorRGB Canvas::GetPixel(const int x, const int y) const
+	{
+		if (x < 0 || x >= this->width_ || y < 0 || y >= this->height_) return ColorRGB(0, 0, 0);
+		return UnpackPixel(this->pixels_[static_cast<size_t>(y) * this->width_ + x]);
+	}
+
+	/**
+	* \brief Залить прямоугольник
+	* \param rect Прямоугольник
+	* \param color Цвет
+	*/
+	void Canvas::FillRect(const RECT& rect, const ColorRGB& color)
+	{
+		RECT clipped = rect;
+		if (color.A == 0 || this->Clip(clipped)) return;
+
+		const size_t length = static_cast<size_t>(clipped.right - clipped.left);
+
+		if (color.A == 255)
+		{
+			const std::uint32_t pixel = PackPixel(color);
+			for (int y = clipped.top; y < clipped.bottom; y++) FillPixels(this->PixelAt(clipped.left, y), length, pixel);
+		}
+		else
+		{
+			const std::uint32_t pixel = color.GetPremultiplied();
+			for (int y = clipped.top; y < clipped.bottom; y++) BlendSolidPixels(this->PixelAt(clipped.left, y), length, pixel);
+		}
+	}
+
+	/**
+	* \brief Нарисовать рамку прямоугольника
+	* \param rect Прямоугольник (рамка лежит внутри него)
+	* \param color Цвет
+	* \param thickness Толщина рамки
+	*/
+	void Canvas::DrawRect(const RECT& rect, const ColorRGB& color, const int thickness)
+	{
+		if (thickness <= 0 || rect.left >= rect.right || rect.top >= rect.bottom) return;
+
+		// Рамка толще половины прямоугольника заполняет его целиком
+		if (thickness * 2 >= rect.right - rect.left || thickness * 2 >= rect.bottom - rect.top) {
+			this->FillRect(rect, color);
+			return;
+		}
+
+		this->FillRect({ rect.left, rect.top, rect.right, rect.top + thickness }, color);
+		this->FillRect({ rect.left, rect.bottom - thickness, rect.right, rect.bottom }, color);
+		this->FillRect({ rect.left, rect.top + thickness, rect.left + thickness, rect.bottom - thickness }, color);
+		this->FillRect({ rect.right - thickness, rect.top + thickness, rect.right, rect.bottom - thickness }, color);
+	}
+
+	/**
+	* \brief Нарисовать отрезок (включая оба конца)
+	* \param from Начало
+	* \param to Конец
+	* \param color Цвет
+	*/
+	void Canvas::DrawLine(const Vector2D<int>& from, const Vector2D<int>& to, const ColorRGB& color)
+	{
+		// Горизонтальные и вертикальные отрезки (самые частые - разделители, рамки) заливаются как прямоугольники
+		if (from.Y == to.Y) {
+			this->FillRect({ (std::min)(from.X, to.X), from.Y, (std::max)(from.X, to.X) + 1, from.Y + 1 }, color);
+			return;
+		}
+
+		if (from.X == to.X) {
+			this->FillRect({ from.X, (std::min)(from.Y, to.Y), from.X + 1, (std::max)(from.Y, to.Y) + 1 }, color);
+			return;
+		}
+
+		// Алгоритм Брезенхема
+		if (color.A == 0) return;
+		const bool opaque = color.A == 255;
+		const std::uint32_t pixel = opaque ? PackPixel(color) : color.GetPremultiplied();
+		const int dx = std::abs(to.X - from.X);
+		const int dy = -std::abs(to.Y - from.Y);
+		const int stepX = from.X < to.X ? 1 : -1;
+		const int stepY = from.Y < to.Y ? 1 : -1;
+
+		int x = from.X;
+		int y = from.Y;
+		int error = dx + dy;
+
+		while (true)
+		{
+			if (x >= this->clip_.left && x < this->clip_.right && y >= this->clip_.top && y < this->clip_.bottom)
+			{
+				if (opaque) *this->PixelAt(x, y) = pixel;
+				else BlendSolidPixels(this->PixelAt(x, y), 1, pixel);
+			}
+
+			if (x == to.X && y == to.Y) break;
+
+			const int error2 = error * 2;
+			if (error2 >= dy) { error += dy; x += stepX; }
+			if (error2 <= dx) { error += dx; y += stepY; }
+		}
+	}
+
+	/**
+	* \brief Залить прямоугольник линейным градиентом
+	* \param rect Прямоугольник
+	* \param from Цвет левого (верхнего) края
+	* \param to Цвет правого (нижнего) края
+	* \param vertical Градиент сверху вниз
+	*/
+	void Canvas::FillGradient(const RECT& rect, const ColorRGB& from, const ColorRGB& to, const bool vertical)
+	{
+		RECT clipped = rect;
+		if (this->Clip(clipped)) return;
+
+		const std::uint32_t first = PackPixel(from);
+		const std::uint32_t last = PackPixel(to);
+		const size_t length = static_cast<size_t>(clipped.right - clipped.left);
+
+		// Отсеченная часть градиента рассчитывается со смещением от края исходного прямоугольника
+		if (vertical)
+		{
+			const size_t height = static_cast<size_t>(rect.bottom - rect.top);
+			for (int y = clipped.top; y < clipped.bottom; y++)
+			{
+				std::uint32_t pixel;
+				GradientPixels(&pixel, 1, first, last, static_cast<size_t>(y - rect.top), height);
+				FillPixels(this->PixelAt(clipped.left, y), length, pixel);
+			}
+		}
+		else
+		{
+			const size_t width = static_cast<size_t>(rect.right - rect.left);
+			for (int y = clipped.top; y < clipped.bottom; y++) {
+				GradientPixels(this->PixelAt(clipped.left, y), length, first, last, static_cast<size_t>(clipped.left - rect.left), width);
+			}
+		}
+	}
+
+	/**
+	* \brief Скопировать изображение на холст
+	* \param pixels Пиксели изображения (0x00RRGGBB, строки сверху вниз)
+	* \param size Размеры изображения
+	* \param position Положение левого верхнего угла на холсте
+	*/
+	void Canvas::DrawImage(const std::uint32_t* pixels, const Vector2D<int>& size, const Vector2D<int>& position)
+	{
+		if (!pixels) return;
+
+		RECT target = { position.X, position.Y, position.X + size.X, position.Y + size.Y };
+		if (this->Clip(target)) return;
+
+		const int length = target.right - target.left;
+		for (int y = target.top; y < target.bottom; y++)
+		{
+			const std::uint32_t* source = pixels + static_cast<size_t>(y - position.Y) * size.X + (target.left - position.X);
+			std::memcpy(this->PixelAt(target.left, y), source, length * sizeof(std::uint32_t));
+		}
+	}
+
+	/**
+	* \brief Скопировать изображение на холст, пропуская пиксели ключевого цвета
+	* \param pixels Пиксели изображения (0x00RRGGBB, строки сверху вниз)
+	* \param size Размеры изображения
+	* \param position Положение левого верхнего угла на холсте
+	* \param key Ключевой цвет
+	*/
+	void Canvas::DrawImageKeyed(const std::uint32_t* pixels, const Vector2D<int>& size, const Vector2D<int>& position, const ColorRGB& key)
+	{
+		if (!pixels) return;
+
+		RECT target = { position.X, position.Y, position.X + size.X, position.Y + size.Y };
+		if (this->Clip(target)) return;
+
+		const size_t length = static_cast<size_t>(target.right - target.left);
+		const std::uint32_t keyPixel = PackPixel(key);
+
+		for (int y = target.top; y < target.bottom; y++)
+		{
+			const std::uint32_t* source = pixels + static_cast<size_t>(y - position.Y) * size.X + (target.left - position.X);
+			CopyPixelsKeyed(this->PixelAt(target.left, y), source, length, keyPixel);
+		}
+	}
+
+	/**
+	* \brief Наложить полупрозрачное изображение на холст
+	* \param pixels Пиксели изображения (0xAARRGGBB, premultiplied, строки сверху вниз)
+	* \param size Размеры изображения
+	* \param position Положение левого верхнего угла на холсте
+	*/
+	void Canvas::BlendImage(const std::uint32_t* pixels, const Vector2D<int>& size, const Vector2D<int>& position)
+	{
+		if (!pixels) return;
+
+		RECT target = { position.X, position.Y, position.X + size.X, position.Y + size.Y };
+		if (this->Clip(target)) return;
+
+		const size_t length = static_cast<size_t>(target.right - target.left);
+		for (int y = target.top; y < target.bottom; y++)
+		{
+			const std::uint32_t* source = pixels + static_cast<size_t>(y - position.Y) * size.X + (target.left - position.X);
+			BlendPixels(this->PixelAt(target.left, y), source, length);
+		}
+	}
+
+	/**
+	* \brief Нарисовать текст
+	* \param text Текст
+	* \param font Параметры шрифта
+	* \param position Положение левого верхнего угла текста
+	* \param color Цвет
+	*/
+	void Canvas::DrawString(std::string_view text, const FontSettings& font, const Vector2D<int>& position, const ColorRGB& color)
+	{
+		if (text.empty() || color.A == 0) return;
+
+		const TextRun& run = GetGlyphCache().GetRun(text, font);
+		const int left = position.X + run.bounds.left;
+		const int top = position.Y + run.bounds.top;
+		const size_t pitch = static_cast<size_t>(run.bounds.right - run.bounds.left);
+
+		RECT target = { left, top, position.X + run.bounds.right, position.Y + run.bounds.bottom };
+		if (this->Clip(target)) return;
+
+		// Маска всей строки накладывается одним вызовом растровой функции на строку пикселей
+		const std::uint32_t pixel = color.GetPremultiplied();
+		const size_t length = static_cast<size_t>(target.right - target.left);
+
+		for (int y = target.top; y < target.bottom; y++)
+		{
+			const unsigned char* mask = run.coverage.data() + pitch * (y - top) + (target.left - left);
+			BlendMaskPixels(this->PixelAt(target.left, y), mask, length, pixel);
+		}
+	}
+
+	/**
+	* \brief Измерить текст
+	* \param text Текст
+	* \param font Параметры шрифта
+	* \return Размеры
+	*/
+	Vector2D<int> Canvas::MeasureString(std::string_view text, const FontSettings& font)
+	{
+		return GetGlyphCache().GetRun(text, font).size;
+	}
+}
@@ -0,0 +1,307 @@
+﻿/**
+* \brief Сопрограммы (C++20) для асинхронного кода в потоке основного цикла (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/wquery.h>
+
+namespace wquery
+{
+	/**
+	* \brief Шаг классов размеров пула кадров (байт)
+	*/
+	static const size_t frameSizeStep = 64;
+
+	/**
+	* \brief Кол-во классов размеров пула кадров (кадры больше frameSizeStep * frameSizeClasses выделяются напрямую)
+	*/
+	static const size_t frameSizeClasses = 32;
+
+	/**
+	* \brief Пул кадров сопрограмм потока
+	* \details Освобожденный кадр становится узлом списка свободных кадров своего класса размера. Память
+	* возвращается системе только при завершении потока
+	*/
+	class FramePool
+	{
+	private:
+		struct FreeFrame
+		{
+			FreeFrame* next;
+		};
+
+		FreeFrame* free_[frameSizeClasses] = {};
+
+	public:
+		~FramePool()
+		{
+			for (FreeFrame* head : this->free_)
+			{
+				while (head) {
+					FreeFrame* next = head->next;
+					::operator delete(head);
+					head = next;
+				}
+			}
+		}
+
+		void* Allocate(size_t size)
+		{
+			const size_t sizeClass = (size + frameSizeStep - 1) / frameSizeStep;
+			if (sizeClass == 0 || sizeClass > frameSizeClasses) return ::operator new(size);
+
+			FreeFrame*& head = this->free_[sizeClass - 1];
+			if (!head) return ::operator new(sizeClass * frameSizeStep);
+
+			FreeFrame* frame = head;
+			head = frame->next;
+			return frame;
+		}
+
+		void Free(void* frame, size_t size)
+		{
+			const size_t sizeClass = (size + frameSizeStep - 1) / frameSizeStep;
+			if (sizeClass == 0 || sizeClass > frameSizeClasses) {
+				::operator delete(frame);
+				return;
+			}
+
+			FreeFrame* node = static_cast<FreeFrame*>(frame);
+			node->next = this->free_[sizeClass - 1];
+			this->free_[sizeClass - 1] = node;
+		}
+	};
+
+	/**
+	* \brief Получить пул кадров текущего потока
+	* \return Ссылка на пул
+	*/
+	static FramePool& GetFramePool()
+	{
+		thread_local FramePool pool;
+		return pool;
+	}
+
+	/**
+	* \brief Пул рабочих потоков (\see wquery::OnWorker)
+	*/
+	class WorkerPool
+	{
+	private:
+		std::vector<std::thread> threads_;
+		std::deque<std::function<void()>> jobs_;
+		std::mutex mutex_;
+		std::condition_variable available_;
+		bool stopping_ = false;
+
+		void Run()
+		{
+			while (true)
+			{
+				std::function<void()> job;
+
+				{
+					std::unique_lock<std::mutex> lock(this->mutex_);
+					this->available_.wait(lock, [this]() { return this->stopping_ || !this->jobs_.empty(); });
+					if (this->jobs_.empty()) return;
+
+					job = std::move(this->jobs_.front());
+					this->jobs_.pop_front();
+				}
+
+				job();
+			}
+		}
+
+	public:
+		WorkerPool()
+		{
+			const unsigned int count = (std::max)(std::thread::hardware_concurrency(), 2u);
+			for (unsigned int i = 0; i < count; i++) {
+				this->threads_.emplace_back(&WorkerPool::Run, this);
+			}
+		}
+
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex_);
+				this->stopping_ = true;
+			}
+
+			this->available_.notify_all();
+			for (std::thread& thread : this->threads_) thread.join();
+		}
+
+		void Push(std::function<void()> job)
+		{
+			{
+				std::lock_guard<std::mutex> lock(this->mutex_);
+				this->jobs_.push_back(std::move(job));
+			}
+
+			this->available_.notify_one();
+		}
+	};
+
+	/**
+	* \brief Сопрограммы, ожидающие следующей итерации основного цикла
+	*/
+	static std::vector<std::coroutine_handle<>> readyCoroutines_;
+
+	/**
+	* \brief Сопрограммы, ожидающие следующего кадра
+	*/
+	static std::vector<std::coroutine_handle<>> frameCoroutines_;
+
+	/**
+	* \brief Буфер продолжаемых сопрограмм (обменивается с очередями, чтобы не выделять память на каждой итерации)
+	*/
+	static std::vector<std::coroutine_handle<>> resumingCoroutines_;
+
+	/**
+	* \brief Необработанное исключение запущенной через Spawn задачи (ожидает проброса основным циклом)
+	*/
+	static std::exception_ptr unhandledException_;
+
+	/**
+	* \brief Продолжить сопрограммы очереди (продолженные сопрограммы могут снова встать в очередь)
+	* \param queue Очередь
+	* \return Кол-во продолженных сопрограмм
+	*/
+	static size_t ResumeQueue(std::vector<std::coroutine_handle<>>& queue)
+	{
+		if (queue.empty()) return 0;
+
+		WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_LOOP_COROUTINES);
+		resumingCoroutines_.swap(queue);
+		for (std::coroutine_handle<> coroutine : resumingCoroutines_) coroutine.resume();
+
+		const size_t count = resumingCoroutines_.size();
+		resumingCoroutines_.clear();
+		return count;
+	}
+
+	/**
+	* \brief Продолжить сопрограмму на следующей итерации основного цикла
+	* \param coroutine Сопрограмма
+	*/
+	void ResumeLater(std::coroutine_handle<> coroutine)
+	{
+		readyCoroutines_.push_back(coroutine);
+	}
+
+	/**
+	* \brief Продолжить сопрограмму в следующем кадре (в цикле MainLoopType::FRAME_PACED), в остальных
+	* циклах - на следующей итерации
+	* \param coroutine Сопрограмма
+	*/
+	void ResumeNextFrame(std::coroutine_handle<> coroutine)
+	{
+		frameCoroutines_.push_back(coroutine);
+
+		// Ожидающая кадра сопрограмма - активность (кадр не должен откладываться как при простое)
+		RequestFrame();
+	}
+
+	/**
+	* \brief Есть ли сопрограммы, ожидающие продолжения на следующей итерации (вызывается основным циклом)
+	* \param frame Учитывать ожидающие следующего кадра
+	* \return Состояние
+	*/
+	bool HasPendingCoroutines(bool frame)
+	{
+		return !readyCoroutines_.empty() || (frame && !frameCoroutines_.empty());
+	}
+
+	/**
+	* \brief Продолжить сопрограммы, ожидающие следующей итерации (вызывается основным циклом)
+	* \param frame Продолжить и ожидающие следующего кадра (начался новый кадр)
+	* \return Кол-во продолженных сопрограмм
+	*/
+	size_t ResumePendingCoroutines(bool frame)
+	{
+		size_t count = ResumeQueue(readyCoroutines_);
+		if (frame) count += ResumeQueue(frameCoroutines_);
+		return count;
+	}
+
+	/**
+	* \brief Продолжить сопрограмму в потоке основного цикла (может вызываться из любого потока, \see wquery::Post)
+	* \param coroutine Сопрограмма
+	*/
+	void ResumeOnLoopThread(std::coroutine_handle<> coroutine)
+	{
+		Post([coroutine]() { coroutine.resume(); });
+	}
+
+	/**
+	* \brief Запомнить необработанное исключение запущенной через Spawn задачи
+	* \param exception Исключение
+	*/
+	void SetUnhandledCoroutineException(std::exception_ptr exception)
+	{
+		if (unhandledException_) return;
+		unhandledException_ = std::move(exception);
+
+		// Пустая задача будит основной цикл, если он ждет сообщения
+		Post([]() {});
+	}
+
+	/**
+	* \brief Пробросить запомненное исключение задачи
+	*/
+	void RethrowCoroutineException()
+	{
+		if (!unhandledException_) return;
+		std::rethrow_exception(std::exchange(unhandledException_, nullptr));
+	}
+
+	/**
+	* \brief Выполнить функцию в одном из рабочих потоков (пул потоков создается при первом вызове)
+	* \param job Функция
+	*/
+	void RunOnWorker(std::function<void()> job)
+	{
+		static WorkerPool pool;
+		pool.Push(std::move(job));
+	}
+
+	/**
+	* \brief Выделить память под кадр сопрограммы (из пула потока)
+	* \param size Размер
+	* \return Указатель на память
+	*/
+	void* AllocateCoroutineFrame(size_t size)
+	{
+		return GetFramePool().Allocate(size);
+	}
+
+	/**
+	* \brief Вернуть память кадра сопрограммы в пул потока
+	* \param frame Указатель на память
+	* \param size Размер
+	*/
+	void FreeCoroutineFrame(void* frame, size_t size)
+	{
+		GetFramePool().Free(frame, size);
+	}
+
+	/**
+	* \brief Запустить таймер, продолжающий сопрограмму
+	* \param coroutine Сопрограмма
+	*/
+	void DelayAwaiter::await_suspend(std::coroutine_handle<> coroutine) const
+	{
+		SetTimeout(this->delay, [coroutine]() { coroutine.resume(); });
+	}
+
+	/**
+	* \brief Встать в очередь ожидающих уведомления элемента
+	* \param coroutine Сопрограмма
+	*/
+	void NotificationAwaiter::await_suspend(std::coroutine_handle<> coroutine)
+	{
+		this->control_->waiters_.push_back({ this->code_, coroutine, &this->received_ });
+	}
+}
@@ -0,0 +1,214 @@
+﻿/**
+* \brief Недействительная (требующая перерисовки) область окна (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/DirtyRegion.h>
+
+namespace wquery
+{
+	/**
+	* \brief Площадь прямоугольника
+	* \param rect Прямоугольник
+	* \return Площадь
+	*/
+	static long long Area(const RECT& rect)
+	{
+		return static_cast<long long>(rect.right - rect.left) * static_cast<long long>(rect.bottom - rect.top);
+	}
+
+	/**
+	* \brief Объединение (ограничивающий прямоугольник) двух прямоугольников
+	* \param a Первый прямоугольник
+	* \param b Второй прямоугольник
+	* \return Объединение
+	*/
+	static RECT Union(const RECT& a, const RECT& b)
+	{
+		return { (std::min)(a.left, b.left), (std::min)(a.top, b.top), (std::max)(a.right, b.right), (std::max)(a.bottom, b.bottom) };
+	}
+
+	/**
+	* \brief Лежит ли прямоугольник внутри другого
+	* \param outer Внешний прямоугольник
+	* \param inner Внутренний прямоугольник
+	* \return Состояние
+	*/
+	static bool Contains(const RECT& outer, const RECT& inner)
+	{
+		return inner.left >= outer.left && inner.top >= outer.top && inner.right <= outer.right && inner.bottom <= outer.bottom;
+	}
+
+	/**
+	* \brief Пересекаются или соприкасаются ли прямоугольники
+	* \param a Первый прямоугольник
+	* \param b Второй прямоугольник
+	* \return Состояние
+	*/
+	static bool Touches(const RECT& a, const RECT& b)
+	{
+		return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+	}
+
+	/**
+	* \brief Конструктор (пустая область)
+	*/
+	DirtyRegion::DirtyRegion() :
+		bounds_({ 0,0,0,0 }),
+		merged_(0)
+	{
+		this->rects_.reserve(MAX_RECTS);
+	}
+
+	/**
+	* \brief Слить прямоугольник с пересекающимися и соприкасающимися, если это выгодно
+	* \param rect Прямоугольник (расширяется при слиянии)
+	*/
+	void DirtyRegion::Absorb(RECT& rect)
+	{
+		// Слияние расширяет прямоугольник, поэтому проход повторяется, пока что-то сливается
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+
+			for (size_t i = 0; i < this->rects_.size();)
+			{
+				const RECT& other = this->rects_[i];
+				const RECT merged = Union(rect, other);
+
+				// Сливаются прямоугольники, объединение которых не больше чем на четверть превышает сумму их площадей
+				const long long sum = Area(rect) + Area(other);
+				if (Contains(rect, other) || (Touches(rect, other) && Area(merged) * 4 <= sum * 5))
+				{
+					rect = merged;
+					this->rects_[i] = this->rects_.back();
+					this->rects_.pop_back();
+					this->merged_++;
+					changed = true;
+					continue;
+				}
+
+				i++;
+			}
+		}
+	}
+
+	/**
+	* \brief Добавить прямоугольник
+	* \param rect Прямоугольник (пустые игнорируются)
+	*/
+	void DirtyRegion::Add(const RECT& rect)
+	{
+		if (rect.right <= rect.left || rect.bottom <= rect.top) return;
+
+		this->bounds_ = this->rects_.empty() ? rect : Union(this->bounds_, rect);
+
+		for (const RECT& existing : this->rects_)
+		{
+			if (Contains(existing, rect)) {
+				this->merged_++;
+				return;
+			}
+		}
+
+		RECT added = rect;
+		this->Absorb(added);
+
+		// Лимит исчерпан - прямоугольник сливается с тем, с которым прирост площади наименьший
+		if (this->rects_.size() >= MAX_RECTS)
+		{
+			size_t best = 0;
+			long long bestGrowth = (std::numeric_limits<long long>::max)();
+
+			for (size_t i = 0; i < this->rects_.size(); i++)
+			{
+				const long long growth = Area(Union(added, this->rects_[i])) - Area(this->rects_[i]) - Area(added);
+				if (growth < bestGrowth) {
+					bestGrowth = growth;
+					best = i;
+				}
+			}
+
+			added = Union(added, this->rects_[best]);
+			this->rects_[best] = this->rects_.back();
+			this->rects_.pop_back();
+			this->merged_++;
+			this->Absorb(added);
+		}
+
+		this->rects_.push_back(added);
+	}
+
+	/**
+	* \brief Добавить все прямоугольники другой области
+	* \param region Область
+	*/
+	void DirtyRegion::Add(const DirtyRegion& region)
+	{
+		for (const RECT& rect : region.rects_) this->Add(rect);
+	}
+
+	/**
+	* \brief Очистить область
+	*/
+	void DirtyRegion::Clear()
+	{
+		this->rects_.clear();
+		this->bounds_ = { 0,0,0,0 };
+		this->merged_ = 0;
+	}
+
+	/**
+	* \brief Пуста ли область
+	* \return Состояние
+	*/
+	bool DirtyRegion::IsEmpty() const
+	{
+		return this->rects_.empty();
+	}
+
+	/**
+	* \brief Получить прямоугольники области
+	* \return Ссылка на массив прямоугольников
+	*/
+	const std::vector<RECT>& DirtyRegion::GetRects() const
+	{
+		return this->rects_;
+	}
+
+	/**
+	* \brief Получить ограничивающий прямоугольник области
+	* \return Прямоугольник (нулевой, если область пуста)
+	*/
+	RECT DirtyRegion::GetBounds() const
+	{
+		return this->bounds_;
+	}
+
+	/**
+	* \brief Пересекается ли область с прямоугольником
+	* \param rect Прямоугольник
+	* \return Состояние
+	*/
+	bool DirtyRegion::Intersects(const RECT& rect) const
+	{
+		for (const RECT& existing : this->rects_)
+		{
+			if (existing.left < rect.right && rect.left < existing.right && existing.top < rect.bottom && rect.top < existing.bottom) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	* \brief Кол-во прямоугольников, поглощенных или слитых с момента последней очистки
+	* \return Кол-во
+	*/
+	unsigned int DirtyRegion::GetMergedCount() const
+	{
+		return this->merged_;
+	}
+}
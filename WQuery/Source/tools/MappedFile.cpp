@@ -0,0 +1,126 @@
+﻿/**
+* \brief Файл, отображенный в память (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/MappedFile.h>
+#include <wquery/tools/utf.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace wquery
+{
+	/**
+	* \brief Конструктор
+	*/
+	MappedFile::MappedFile() :
+		data_(nullptr),
+		size_(0)
+	{}
+
+	/**
+	* \brief Деструктор
+	*/
+	MappedFile::~MappedFile()
+	{
+		this->Close();
+	}
+
+	/**
+	* \brief Открыть файл и отобразить его в память
+	* \param path Путь к файлу (UTF-8)
+	* \return Удалось ли открыть
+	*/
+	bool MappedFile::Open(const std::string& path)
+	{
+		this->Close();
+
+#ifdef _WIN32
+		std::wstring widePath;
+		if (!Utf8ToWide(path.data(), path.size(), widePath)) return false;
+
+		HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size = {};
+		HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0 && static_cast<unsigned long long>(size.QuadPart) <= (std::numeric_limits<size_t>::max)()
+			? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+			: nullptr;
+
+		// Представление удерживает отображение, поэтому хендлы файла и отображения можно закрыть сразу
+		const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+
+		if (!view) return false;
+		this->data_ = static_cast<const unsigned char*>(view);
+		this->size_ = static_cast<size_t>(size.QuadPart);
+#else
+		const int descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0) return false;
+
+		struct stat info = {};
+		void* view = fstat(descriptor, &info) == 0 && info.st_size > 0
+			? mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0)
+			: MAP_FAILED;
+
+		// Отображение остается действительным после закрытия дескриптора
+		close(descriptor);
+
+		if (view == MAP_FAILED) return false;
+		this->data_ = static_cast<const unsigned char*>(view);
+		this->size_ = static_cast<size_t>(info.st_size);
+#endif
+
+		return true;
+	}
+
+	/**
+	* \brief Закрыть отображение
+	*/
+	void MappedFile::Close()
+	{
+		if (!this->data_) return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(this->data_);
+#else
+		munmap(const_cast<unsigned char*>(this->data_), this->size_);
+#endif
+
+		this->data_ = nullptr;
+		this->size_ = 0;
+	}
+
+	/**
+	* \brief Открыт ли файл
+	* \return Состояние
+	*/
+	bool MappedFile::IsOpen() const
+	{
+		return this->data_ != nullptr;
+	}
+
+	/**
+	* \brief Получить содержимое файла
+	* \return Указатель на первый байт
+	*/
+	const unsigned char* MappedFile::GetData() const
+	{
+		return this->data_;
+	}
+
+	/**
+	* \brief Получить размер файла
+	* \return Размер в байтах
+	*/
+	size_t MappedFile::GetSize() const
+	{
+		return this->size_;
+	}
+}
@@ -0,0 +1,507 @@
+﻿/**
+* \brief Таблица фрагментов - текстовая модель для больших документов (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/PieceTable.h>
+
+namespace wquery
+{
+	/**
+	* \brief Конструктор (пустой документ)
+	*/
+	PieceTable::PieceTable() :
+		nodes_(1, Node()),
+		root_(0),
+		seed_(2463534242u) {}
+
+	/**
+	* \brief Конструктор
+	* \param text Исходный текст
+	*/
+	PieceTable::PieceTable(std::string_view text) : PieceTable()
+	{
+		this->Assign(text);
+	}
+
+	/**
+	* \brief Заменить весь текст (исходный текст копируется)
+	* \param text Текст
+	*/
+	void PieceTable::Assign(std::string_view text)
+	{
+		this->Assign(std::string(text));
+	}
+
+	/**
+	* \brief Заменить весь текст без копирования
+	* \param text Текст
+	*/
+	void PieceTable::Assign(std::string&& text)
+	{
+		this->buffers_[PIECE_BUFFER_ORIGINAL] = std::move(text);
+		this->buffers_[PIECE_BUFFER_ADDED].clear();
+		this->lineBreaks_[PIECE_BUFFER_ORIGINAL].clear();
+		this->lineBreaks_[PIECE_BUFFER_ADDED].clear();
+		this->nodes_.resize(1);
+		this->freeNodes_.clear();
+
+		this->IndexLineBreaks(PIECE_BUFFER_ORIGINAL, 0);
+
+		const size_t length = this->buffers_[PIECE_BUFFER_ORIGINAL].length();
+		this->root_ = length > 0 ? this->CreateNode(PIECE_BUFFER_ORIGINAL, 0, length) : 0;
+	}
+
+	/**
+	* \brief Дописать положения переводов строк в индекс буфера
+	* \param buffer Буфер
+	* \param from Начало просматриваемого участка буфера
+	*/
+	void PieceTable::IndexLineBreaks(unsigned char buffer, size_t from)
+	{
+		const std::string& text = this->buffers_[buffer];
+		std::vector<size_t>& lineBreaks = this->lineBreaks_[buffer];
+
+		const char* begin = text.data();
+		const char* end = begin + text.length();
+		for (const char* p = begin + from; p < end; p++)
+		{
+			p = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+			if (!p) break;
+			lineBreaks.push_back(static_cast<size_t>(p - begin));
+		}
+	}
+
+	/**
+	* \brief Посчитать переводы строк в участке буфера
+	* \param buffer Буфер
+	* \param start Начало участка
+	* \param length Длина участка
+	* \return Кол-во переводов строк
+	*/
+	size_t PieceTable::CountLineBreaks(unsigned char buffer, size_t start, size_t length) const
+	{
+		const std::vector<size_t>& lineBreaks = this->lineBreaks_[buffer];
+		const auto first = std::lower_bound(lineBreaks.begin(), lineBreaks.end(), start);
+		const auto last = std::lower_bound(first, lineBreaks.end(), start + length);
+		return static_cast<size_t>(last - first);
+	}
+
+	/**
+	* \brief Создать узел фрагмента
+	* \param buffer Буфер
+	* \param start Начало фрагмента
+	* \param length Длина фрагмента
+	* \return Индекс узла
+	*/
+	unsigned int PieceTable::CreateNode(unsigned char buffer, size_t start, size_t length)
+	{
+		// Приоритеты - xorshift32 (детерминированно, без зависимости от глобального генератора)
+		this->seed_ ^= this->seed_ << 13;
+		this->seed_ ^= this->seed_ >> 17;
+		this->seed_ ^= this->seed_ << 5;
+
+		unsigned int node;
+		if (!this->freeNodes_.empty())
+		{
+			node = this->freeNodes_.back();
+			this->freeNodes_.pop_back();
+		}
+		else
+		{
+			node = static_cast<unsigned int>(this->nodes_.size());
+			this->nodes_.emplace_back();
+		}
+
+		Node& created = this->nodes_[node];
+		created.left = 0;
+		created.right = 0;
+		created.priority = this->seed_;
+		created.buffer = buffer;
+		created.start = start;
+		created.length = length;
+		created.lineBreaks = this->CountLineBreaks(buffer, start, length);
+		created.totalLength = length;
+		created.totalLineBreaks = created.lineBreaks;
+		return node;
+	}
+
+	/**
+	* \brief Освободить узлы поддерева
+	* \param node Корень поддерева
+	*/
+	void PieceTable::FreeTree(unsigned int node)
+	{
+		if (!node) return;
+
+		// Обход без рекурсии - свободный список служит стеком (узлы выше отметки еще не обработаны)
+		size_t pending = this->freeNodes_.size();
+		this->freeNodes_.push_back(node);
+
+		while (pending < this->freeNodes_.size())
+		{
+			const Node& current = this->nodes_[this->freeNodes_[pending++]];
+			if (current.left) this->freeNodes_.push_back(current.left);
+			if (current.right) this->freeNodes_.push_back(current.right);
+		}
+	}
+
+	/**
+	* \brief Пересчитать суммы узла по потомкам
+	* \param node Узел
+	*/
+	void PieceTable::Update(unsigned int node)
+	{
+		Node& current = this->nodes_[node];
+		const Node& left = this->nodes_[current.left];
+		const Node& right = this->nodes_[current.right];
+		current.totalLength = left.totalLength + current.length + right.totalLength;
+		current.totalLineBreaks = left.totalLineBreaks + current.lineBreaks + right.totalLineBreaks;
+	}
+
+	/**
+	* \brief Разделить поддерево по смещению
+	* \details Индексы узлов сохраняются в локальных переменных - создание узла может переместить массив узлов
+	* \param node Корень поддерева
+	* \param position Смещение
+	* \param left Поддерево с текстом до смещения
+	* \param right Поддерево с текстом после смещения
+	*/
+	void PieceTable::Split(unsigned int node, size_t position, unsigned int& left, unsigned int& right)
+	{
+		if (!node)
+		{
+			left = right = 0;
+			return;
+		}
+
+		const size_t leftLength = this->nodes_[this->nodes_[node].left].totalLength;
+		const size_t pieceLength = this->nodes_[node].length;
+		unsigned int first, second;
+
+		if (position <= leftLength)
+		{
+			this->Split(this->nodes_[node].left, position, first, second);
+			this->nodes_[node].left = second;
+			this->Update(node);
+			left = first;
+			right = node;
+		}
+		else if (position >= leftLength + pieceLength)
+		{
+			this->Split(this->nodes_[node].right, position - leftLength - pieceLength, first, second);
+			this->nodes_[node].right = first;
+			this->Update(node);
+			left = node;
+			right = second;
+		}
+		else
+		{
+			// Смещение внутри фрагмента - хвост фрагмента становится новым узлом, который присоединяется
+			// к правому поддереву слиянием (так сохраняется порядок приоритетов)
+			const size_t offset = position - leftLength;
+			const unsigned int tail = this->CreateNode(this->nodes_[node].buffer, this->nodes_[node].start + offset, pieceLength - offset);
+
+			Node& current = this->nodes_[node];
+			const unsigned int rightTree = current.right;
+			current.right = 0;
+			current.length = offset;
+			current.lineBreaks -= this->nodes_[tail].lineBreaks;
+			this->Update(node);
+
+			left = node;
+			right = this->Merge(tail, rightTree);
+		}
+	}
+
+	/**
+	* \brief Объединить поддеревья
+	* \param left Левое поддерево
+	* \param right Правое поддерево
+	* \return Корень объединения
+	*/
+	unsigned int PieceTable::Merge(unsigned int left, unsigned int right)
+	{
+		if (!left) return right;
+		if (!right) return left;
+
+		if (this->nodes_[left].priority > this->nodes_[right].priority)
+		{
+			const unsigned int merged = this->Merge(this->nodes_[left].right, right);
+			this->nodes_[left].right = merged;
+			this->Update(left);
+			return left;
+		}
+
+		const unsigned int merged = this->Merge(left, this->nodes_[right].left);
+		this->nodes_[right].left = merged;
+		this->Update(right);
+		return right;
+	}
+
+	/**
+	* \brief Вставить текст
+	* \param position Смещение
+	* \param text Текст
+	*/
+	void PieceTable::Insert(size_t position, std::string_view text)
+	{
+		if (text.empty()) return;
+		position = (std::min)(position, this->GetLength());
+
+		std::string& added = this->buffers_[PIECE_BUFFER_ADDED];
+		const size_t start = added.length();
+		added.append(text.data(), text.length());
+		this->IndexLineBreaks(PIECE_BUFFER_ADDED, start);
+
+		unsigned int left, right;
+		this->Split(this->root_, position, left, right);
+
+		// Последний фрагмент левой части заканчивается там же, где буфер вставок - он продлевается
+		// (суммы пересчитываются вдоль правой ветви, O(log n))
+		unsigned int last = left;
+		while (last && this->nodes_[last].right) last = this->nodes_[last].right;
+
+		if (last && this->nodes_[last].buffer == PIECE_BUFFER_ADDED && this->nodes_[last].start + this->nodes_[last].length == start)
+		{
+			const size_t lineBreaks = this->CountLineBreaks(PIECE_BUFFER_ADDED, start, text.length());
+			for (unsigned int node = left; node; node = this->nodes_[node].right)
+			{
+				Node& current = this->nodes_[node];
+				if (node == last)
+				{
+					current.length += text.length();
+					current.lineBreaks += lineBreaks;
+				}
+				current.totalLength += text.length();
+				current.totalLineBreaks += lineBreaks;
+			}
+		}
+		else
+		{
+			left = this->Merge(left, this->CreateNode(PIECE_BUFFER_ADDED, start, text.length()));
+		}
+
+		this->root_ = this->Merge(left, right);
+	}
+
+	/**
+	* \brief Удалить участок текста
+	* \param position Смещение
+	* \param length Длина
+	*/
+	void PieceTable::Erase(size_t position, size_t length)
+	{
+		const size_t total = this->GetLength();
+		if (position >= total || length == 0) return;
+		length = (std::min)(length, total - position);
+
+		unsigned int left, middle, right;
+		this->Split(this->root_, position, left, middle);
+		this->Split(middle, length, middle, right);
+		this->FreeTree(middle);
+		this->root_ = this->Merge(left, right);
+	}
+
+	/**
+	* \brief Получить длину текста
+	* \return Длина
+	*/
+	size_t PieceTable::GetLength() const
+	{
+		return this->nodes_[this->root_].totalLength;
+	}
+
+	/**
+	* \brief Получить кол-во строк
+	* \return Кол-во строк
+	*/
+	size_t PieceTable::GetLineCount() const
+	{
+		return this->nodes_[this->root_].totalLineBreaks + 1;
+	}
+
+	/**
+	* \brief Получить смещение начала строки
+	* \details Спуск по дереву к узлу с line-ым переводом строки, внутри фрагмента - поиск по индексу буфера
+	* \param line Номер строки
+	* \return Смещение
+	*/
+	size_t PieceTable::GetLineStart(size_t line) const
+	{
+		if (line == 0) return 0;
+		if (line > this->nodes_[this->root_].totalLineBreaks) return this->GetLength();
+
+		size_t remaining = line;
+		size_t offset = 0;
+		unsigned int node = this->root_;
+
+		while (node)
+		{
+			const Node& current = this->nodes_[node];
+			const Node& left = this->nodes_[current.left];
+
+			if (remaining <= left.totalLineBreaks)
+			{
+				node = current.left;
+				continue;
+			}
+
+			remaining -= left.totalLineBreaks;
+			offset += left.totalLength;
+
+			if (remaining <= current.lineBreaks)
+			{
+				const std::vector<size_t>& lineBreaks = this->lineBreaks_[current.buffer];
+				const auto first = std::lower_bound(lineBreaks.begin(), lineBreaks.end(), current.start);
+				return offset + (*(first + static_cast<std::ptrdiff_t>(remaining - 1)) - current.start) + 1;
+			}
+
+			remaining -= current.lineBreaks;
+			offset += current.length;
+			node = current.right;
+		}
+
+		return this->GetLength();
+	}
+
+	/**
+	* \brief Получить номер строки, содержащей смещение
+	* \param position Смещение
+	* \return Номер строки
+	*/
+	size_t PieceTable::GetLineAt(size_t position) const
+	{
+		size_t line = 0;
+		unsigned int node = this->root_;
+
+		while (node)
+		{
+			const Node& current = this->nodes_[node];
+			const Node& left = this->nodes_[current.left];
+
+			if (position < left.totalLength)
+			{
+				node = current.left;
+				continue;
+			}
+
+			position -= left.totalLength;
+			line += left.totalLineBreaks;
+
+			if (position < current.length) return line + this->CountLineBreaks(current.buffer, current.start, position);
+
+			position -= current.length;
+			line += current.lineBreaks;
+			node = current.right;
+		}
+
+		return line;
+	}
+
+	/**
+	* \brief Дописать текст поддерева в строку
+	* \param node Корень поддерева
+	* \param offset Смещение поддерева в документе
+	* \param from Начало участка
+	* \param to Конец участка
+	* \param text Строка
+	*/
+	void PieceTable::Collect(unsigned int node, size_t offset, size_t from, size_t to, std::string& text) const
+	{
+		// Поддеревья вне участка пропускаются целиком - O(log n + кол-во фрагментов участка)
+		if (!node || offset >= to || offset + this->nodes_[node].totalLength <= from) return;
+
+		const Node& current = this->nodes_[node];
+		this->Collect(current.left, offset, from, to, text);
+
+		const size_t pieceOffset = offset + this->nodes_[current.left].totalLength;
+		const size_t begin = (std::max)(pieceOffset, from);
+		const size_t end = (std::min)(pieceOffset + current.length, to);
+		if (begin < end) text.append(this->buffers_[current.buffer], current.start + (begin - pieceOffset), end - begin);
+
+		this->Collect(current.right, pieceOffset + current.length, from, to, text);
+	}
+
+	/**
+	* \brief Получить участок текста
+	* \param position Смещение
+	* \param length Длина
+	* \param text Строка для записи
+	*/
+	void PieceTable::GetText(size_t position, size_t length, std::string& text) const
+	{
+		text.clear();
+
+		const size_t total = this->GetLength();
+		if (position >= total) return;
+		length = (std::min)(length, total - position);
+
+		text.reserve(length);
+		this->Collect(this->root_, 0, position, position + length, text);
+	}
+
+	/**
+	* \brief Получить весь текст
+	* \param text Строка для записи
+	*/
+	void PieceTable::GetText(std::string& text) const
+	{
+		this->GetText(0, this->GetLength(), text);
+	}
+
+	/**
+	* \brief Получить строку (без перевода строки)
+	* \param line Номер строки
+	* \param text Строка для записи
+	* \param maxLength Наибольшая длина
+	*/
+	void PieceTable::GetLine(size_t line, std::string& text, size_t maxLength) const
+	{
+		const size_t start = this->GetLineStart(line);
+		const size_t end = line + 1 < this->GetLineCount() ? this->GetLineStart(line + 1) : this->GetLength();
+		this->GetText(start, (std::min)(end - start, maxLength), text);
+
+		if (!text.empty() && text.back() == '\n') text.pop_back();
+		if (!text.empty() && text.back() == '\r') text.pop_back();
+	}
+
+	/**
+	* \brief Получить символ по смещению
+	* \param position Смещение
+	* \return Символ
+	*/
+	char PieceTable::GetChar(size_t position) const
+	{
+		unsigned int node = this->root_;
+
+		while (node)
+		{
+			const Node& current = this->nodes_[node];
+			const size_t leftLength = this->nodes_[current.left].totalLength;
+
+			if (position < leftLength)
+			{
+				node = current.left;
+				continue;
+			}
+
+			position -= leftLength;
+			if (position < current.length) return this->buffers_[current.buffer][current.start + position];
+
+			position -= current.length;
+			node = current.right;
+		}
+
+		return 0;
+	}
+
+	/**
+	* \brief Получить кол-во фрагментов
+	* \return Кол-во фрагментов
+	*/
+	size_t PieceTable::GetPieceCount() const
+	{
+		return this->nodes_.size() - 1 - this->freeNodes_.size();
+	}
+}
@@ -0,0 +1,66 @@
+﻿/**
+* \brief Очередь задач для передачи работы в поток основного цикла (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/TaskQueue.h>
+
+namespace wquery
+{
+	/**
+	* \brief Конструктор
+	*/
+	TaskQueue::TaskQueue() = default;
+
+	/**
+	* \brief Деструктор
+	*/
+	TaskQueue::~TaskQueue()
+	{
+		while (Node* node = this->queue_.Pop()) {
+			delete node;
+		}
+	}
+
+	/**
+	* \brief Добавить задачу (из любого потока)
+	* \param task Задача
+	*/
+	void TaskQueue::Push(std::function<void()> task)
+	{
+		Node* node = new Node();
+		node->task = std::move(task);
+		this->queue_.Push(node);
+	}
+
+	/**
+	* \brief Извлечь и выполнить задачи (только из потока-потребителя)
+	* \param maxTasks Максимальное кол-во задач за вызов
+	* \return Кол-во выполненных задач
+	*/
+	size_t TaskQueue::Drain(size_t maxTasks)
+	{
+		size_t executed = 0;
+
+		while (executed < maxTasks)
+		{
+			// Узел освобождается и тогда, когда задача выбрасывает исключение
+			std::unique_ptr<Node> node(this->queue_.Pop());
+			if (!node) break;
+
+			if (node->task) node->task();
+			executed++;
+		}
+
+		return executed;
+	}
+
+	/**
+	* \brief Пуста ли очередь (только из потока-потребителя)
+	* \return Состояние
+	*/
+	bool TaskQueue::IsEmpty() const
+	{
+		return this->queue_.IsEmpty();
+	}
+}
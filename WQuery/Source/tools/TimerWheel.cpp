@@ -0,0 +1,484 @@
+﻿/**
+* \brief Иерархическое колесо таймеров (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/TimerWheel.h>
+#include <wquery/tools/instrumentation.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace wquery
+{
+	/**
+	* \brief Ячейка таймера, не находящегося в колесе (срабатывающего прямо сейчас)
+	*/
+	static const unsigned short UNLINKED_CELL = 0xFFFF;
+
+	/**
+	* \brief Номер младшего установленного бита
+	* \param mask Маска (не нулевая)
+	* \return Номер бита
+	*/
+	static unsigned int LowestBit(unsigned long long mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return static_cast<unsigned int>(index);
+#else
+		return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif
+	}
+
+	/**
+	* \brief Маска ячеек уровня, следующих за текущей
+	* \param occupied Маска занятых ячеек
+	* \param current Индекс текущей ячейки
+	* \return Маска занятых ячеек после текущей
+	*/
+	static unsigned long long LaterCells(unsigned long long occupied, unsigned int current)
+	{
+		return current == TimerWheel::SLOTS - 1 ? 0 : occupied & (~0ull << (current + 1));
+	}
+
+	/**
+	* \brief Конструктор
+	* \param now Начальное время колеса (мс)
+	*/
+	TimerWheel::TimerWheel(unsigned long long now) :
+		freeList_(NONE),
+		count_(0),
+		heads_(),
+		occupied_(),
+		now_(now),
+		target_(now),
+		advancing_(false)
+	{
+		std::fill(std::begin(this->heads_), std::end(this->heads_), NONE);
+	}
+
+	/**
+	* \brief Получить идентификатор таймера пула
+	* \param index Индекс в пуле
+	* \return Идентификатор
+	*/
+	TimerId TimerWheel::MakeId(unsigned int index) const
+	{
+		return (static_cast<TimerId>(this->timers_[index].generation) << 32) | (static_cast<TimerId>(index) + 1);
+	}
+
+	/**
+	* \brief Найти запущенный таймер по идентификатору
+	* \param id Идентификатор
+	* \return Индекс в пуле (NONE если таймер не запущен)
+	*/
+	unsigned int TimerWheel::Find(TimerId id) const
+	{
+		const unsigned long long position = id & 0xFFFFFFFFull;
+		if (position == 0 || position > this->timers_.size()) return NONE;
+
+		const unsigned int index = static_cast<unsigned int>(position - 1);
+		const Timer& timer = this->timers_[index];
+		return timer.active && timer.generation == static_cast<unsigned int>(id >> 32) ? index : NONE;
+	}
+
+	/**
+	* \brief Поместить таймер в ячейку колеса, соответствующую времени его срабатывания
+	* \details Уровень определяется старшей группой разрядов, в которой время срабатывания отличается от
+	* текущего времени колеса. Таймеры дальше последнего уровня попадают в его ячейки "по модулю" и
+	* переносятся вниз при следующем обороте верхнего уровня (до срабатывания)
+	* \param index Индекс в пуле
+	*/
+	void TimerWheel::Link(unsigned int index)
+	{
+		Timer& timer = this->timers_[index];
+
+		unsigned int level = 0;
+		while (level < LEVELS - 1 && (timer.expiry >> (LEVEL_BITS * (level + 1))) != (this->now_ >> (LEVEL_BITS * (level + 1)))) {
+			level++;
+		}
+
+		const unsigned int slot = static_cast<unsigned int>(timer.expiry >> (LEVEL_BITS * level)) & (SLOTS - 1);
+		const unsigned int cell = level * SLOTS + slot;
+
+		timer.cell = static_cast<unsigned short>(cell);
+		timer.prev = NONE;
+		timer.next = this->heads_[cell];
+		if (timer.next != NONE) this->timers_[timer.next].prev = index;
+
+		this->heads_[cell] = index;
+		this->occupied_[level] |= 1ull << slot;
+	}
+
+	/**
+	* \brief Убрать таймер из ячейки колеса
+	* \param index Индекс в пуле
+	*/
+	void TimerWheel::Unlink(unsigned int index)
+	{
+		Timer& timer = this->timers_[index];
+		if (timer.cell == UNLINKED_CELL) return;
+
+		if (timer.prev != NONE) this->timers_[timer.prev].next = timer.next;
+		else this->heads_[timer.cell] = timer.next;
+
+		if (timer.next != NONE) this->timers_[timer.next].prev = timer.prev;
+
+		if (this->heads_[timer.cell] == NONE) {
+			this->occupied_[timer.cell / SLOTS] &= ~(1ull << (timer.cell % SLOTS));
+		}
+
+		timer.cell = UNLINKED_CELL;
+	}
+
+	/**
+	* \brief Освободить таймер (вернуть в список свободных)
+	* \param index Индекс в пуле
+	*/
+	void TimerWheel::Release(unsigned int index)
+	{
+		Timer& timer = this->timers_[index];
+		timer.active = false;
+		timer.callback = nullptr;
+		timer.owner = nullptr;
+		timer.generation++;
+		timer.next = this->freeList_;
+
+		this->freeList_ = index;
+		this->count_--;
+	}
+
+	/**
+	* \brief Перенести таймеры ячейки на нижние уровни
+	* \param cell Ячейка
+	*/
+	void TimerWheel::Cascade(unsigned int cell)
+	{
+		const unsigned long long bit = 1ull << (cell % SLOTS);
+		if (!(this->occupied_[cell / SLOTS] & bit)) return;
+
+		unsigned int index = this->heads_[cell];
+		this->heads_[cell] = NONE;
+		this->occupied_[cell / SLOTS] &= ~bit;
+
+		while (index != NONE)
+		{
+			const unsigned int next = this->timers_[index].next;
+			this->Link(index);
+			index = next;
+		}
+	}
+
+	/**
+	* \brief Вызвать таймеры, время которых наступило (таймеры текущей ячейки нулевого уровня)
+	* \return Кол-во вызванных таймеров
+	*/
+	size_t TimerWheel::Fire()
+	{
+		const unsigned int cell = static_cast<unsigned int>(this->now_) & (SLOTS - 1);
+		if (!(this->occupied_[0] & (1ull << cell))) return 0;
+
+		// Ячейка отсоединяется целиком до вызовов: функции таймеров могут запускать и отменять любые таймеры.
+		// Запоминаются идентификаторы, а не индексы - отмененный таймер мог освободить место для нового
+		this->due_.clear();
+		for (unsigned int index = this->heads_[cell]; index != NONE; index = this->timers_[index].next)
+		{
+			this->due_.push_back(this->MakeId(index));
+			this->timers_[index].cell = UNLINKED_CELL;
+		}
+
+		this->heads_[cell] = NONE;
+		this->occupied_[0] &= ~(1ull << cell);
+
+		// Если функция таймера выбросит исключение, колесо остается согласованным: функция возвращается
+		// периодическому таймеру, а еще не вызванные таймеры ячейки возвращаются в колесо и сработают
+		// при следующем продвижении (иначе они остались бы отсоединенными навсегда)
+		struct FireGuard
+		{
+			TimerWheel& wheel;
+			size_t position;                       // Вызываемый таймер буфера
+			std::function<void()> callback;        // Функция вызываемого таймера
+
+			~FireGuard()
+			{
+				if (this->position >= this->wheel.due_.size()) return;
+
+				const unsigned int current = this->wheel.Find(this->wheel.due_[this->position]);
+				if (current != NONE && !this->wheel.timers_[current].callback) {
+					this->wheel.timers_[current].callback = std::move(this->callback);
+				}
+
+				for (size_t i = this->position + 1; i < this->wheel.due_.size(); i++)
+				{
+					const unsigned int index = this->wheel.Find(this->wheel.due_[i]);
+					if (index == NONE || this->wheel.timers_[index].cell != UNLINKED_CELL) continue;
+
+					this->wheel.timers_[index].expiry = this->wheel.now_ + 1;
+					this->wheel.Link(index);
+				}
+
+				this->wheel.due_.clear();
+			}
+		} guard{ *this, 0, nullptr };
+
+		size_t fired = 0;
+		for (; guard.position < this->due_.size(); guard.position++)
+		{
+			const TimerId id = this->due_[guard.position];
+			const unsigned int index = this->Find(id);
+			if (index == NONE) continue;
+
+			Timer& timer = this->timers_[index];
+			guard.callback = std::move(timer.callback);
+
+			// Периодический таймер перезапускается до вызова (функция может его отменить).
+			// Пропущенные периоды не наверстываются: следующее срабатывание - первый период после времени,
+			// до которого продвигается колесо (а не после текущего шага), поэтому за один Advance таймер
+			// срабатывает не более одного раза
+			if (timer.interval > 0)
+			{
+				const unsigned long long missed = this->target_ > timer.expiry ? (this->target_ - timer.expiry) / timer.interval : 0;
+				timer.expiry += timer.interval * (missed + 1);
+				this->Link(index);
+			}
+			else
+			{
+				this->Release(index);
+			}
+
+			fired++;
+			if (guard.callback) guard.callback();
+
+			// Функция возвращается периодическому таймеру, если он не был отменен во время вызова
+			const unsigned int after = this->Find(id);
+			if (after != NONE) this->timers_[after].callback = std::move(guard.callback);
+			guard.callback = nullptr;
+		}
+
+		return fired;
+	}
+
+	/**
+	* \brief Запустить таймер
+	* \param expiry Время срабатывания (мс)
+	* \param interval Период повторения (мс, 0 - однократный таймер)
+	* \param callback Функция обратного вызова
+	* \param owner Владелец
+	* \return Идентификатор таймера
+	*/
+	TimerId TimerWheel::Schedule(unsigned long long expiry, unsigned long long interval, std::function<void()> callback, const void* owner)
+	{
+		unsigned int index = this->freeList_;
+		if (index != NONE)
+		{
+			this->freeList_ = this->timers_[index].next;
+		}
+		else
+		{
+			index = static_cast<unsigned int>(this->timers_.size());
+			this->timers_.emplace_back();
+			this->timers_[index].generation = 0;
+		}
+
+		// Текущая миллисекунда колеса уже обработана, поэтому раньше следующей таймер сработать не может
+		Timer& timer = this->timers_[index];
+		timer.expiry = (std::min)((std::max)(expiry, this->now_ + 1), this->now_ + MAX_DELAY);
+		timer.interval = (std::min)(interval, MAX_DELAY);
+		timer.callback = std::move(callback);
+		timer.owner = owner;
+		timer.active = true;
+
+		this->count_++;
+		this->Link(index);
+
+		return this->MakeId(index);
+	}
+
+	/**
+	* \brief Остановить таймер
+	* \param id Идентификатор
+	* \return Был ли таймер запущен
+	*/
+	bool TimerWheel::Cancel(TimerId id)
+	{
+		const unsigned int index = this->Find(id);
+		if (index == NONE) return false;
+
+		this->Unlink(index);
+		this->Release(index);
+		return true;
+	}
+
+	/**
+	* \brief Остановить все таймеры владельца
+	* \param owner Владелец
+	* \return Кол-во остановленных таймеров
+	*/
+	size_t TimerWheel::CancelAll(const void* owner)
+	{
+		size_t cancelled = 0;
+
+		for (unsigned int index = 0; index < this->timers_.size(); index++)
+		{
+			if (this->timers_[index].active && this->timers_[index].owner == owner)
+			{
+				this->Unlink(index);
+				this->Release(index);
+				cancelled++;
+			}
+		}
+
+		return cancelled;
+	}
+
+	/**
+	* \brief Запущен ли таймер
+	* \param id Идентификатор
+	* \return Состояние
+	*/
+	bool TimerWheel::IsActive(TimerId id) const
+	{
+		return this->Find(id) != NONE;
+	}
+
+	/**
+	* \brief Кол-во запущенных таймеров
+	* \return Кол-во
+	*/
+	size_t TimerWheel::GetCount() const
+	{
+		return this->count_;
+	}
+
+	/**
+	* \brief Текущее время колеса
+	* \return Время (мс)
+	*/
+	unsigned long long TimerWheel::GetTime() const
+	{
+		return this->now_;
+	}
+
+	/**
+	* \brief Получить время срабатывания ближайшего таймера
+	* \param deadline Время срабатывания (мс)
+	* \return Есть ли запущенные таймеры
+	*/
+	bool TimerWheel::GetNextDeadline(unsigned long long& deadline) const
+	{
+		if (this->count_ == 0) return false;
+
+		// Все таймеры уровня срабатывают раньше таймеров следующего уровня, а внутри уровня ячейки упорядочены
+		// по времени. Значит ближайший таймер - в первой занятой ячейке после текущей на самом нижнем уровне
+		for (unsigned int level = 0; level < LEVELS; level++)
+		{
+			const unsigned int current = static_cast<unsigned int>(this->now_ >> (LEVEL_BITS * level)) & (SLOTS - 1);
+			const unsigned long long later = LaterCells(this->occupied_[level], current);
+			if (!later) continue;
+
+			const unsigned int slot = LowestBit(later);
+
+			// На нулевом уровне ячейка соответствует ровно одной миллисекунде
+			if (level == 0)
+			{
+				deadline = (this->now_ & ~static_cast<unsigned long long>(SLOTS - 1)) + slot;
+				return true;
+			}
+
+			deadline = ~0ull;
+			for (unsigned int index = this->heads_[level * SLOTS + slot]; index != NONE; index = this->timers_[index].next) {
+				deadline = (std::min)(deadline, this->timers_[index].expiry);
+			}
+			return true;
+		}
+
+		// Остались только таймеры за пределами оборота верхнего уровня (или срабатывающие прямо сейчас)
+		deadline = ~0ull;
+		for (const Timer& timer : this->timers_) {
+			if (timer.active) deadline = (std::min)(deadline, timer.expiry);
+		}
+		return true;
+	}
+
+	/**
+	* \brief Продвинуть время колеса, вызывая сработавшие таймеры
+	* \param now Новое время (мс)
+	* \return Кол-во вызванных таймеров
+	*/
+	size_t TimerWheel::Advance(unsigned long long now)
+	{
+		// Повторный вход (из функции таймера) не допускается - время продвигается только внешним циклом
+		if (this->advancing_) return 0;
+		this->advancing_ = true;
+
+		// Флаг сбрасывается и при исключении из функции таймера - иначе колесо больше не продвинется
+		struct AdvanceGuard
+		{
+			bool& advancing;
+			~AdvanceGuard() { this->advancing = false; }
+		} guard{ this->advancing_ };
+
+		WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_LOOP_TIMERS);
+
+		size_t fired = 0;
+		this->target_ = (std::max)(now, this->now_);
+
+		while (this->now_ < now)
+		{
+			// Следующая миллисекунда, в которой есть работа: занятая ячейка нулевого уровня
+			// или граница его оборота (перенос таймеров с верхних уровней)
+			const unsigned int current = static_cast<unsigned int>(this->now_) & (SLOTS - 1);
+			const unsigned long long later = LaterCells(this->occupied_[0], current);
+			const unsigned long long next = later
+				? (this->now_ & ~static_cast<unsigned long long>(SLOTS - 1)) + LowestBit(later)
+				: (this->now_ | (SLOTS - 1)) + 1;
+
+			if (next > now) {
+				this->now_ = now;
+				break;
+			}
+
+			this->now_ = next;
+
+			// На границе оборота переносятся ячейки всех уровней, чей оборот тоже завершился (сверху вниз)
+			if ((this->now_ & (SLOTS - 1)) == 0)
+			{
+				unsigned int level = 1;
+				while (level < LEVELS - 1 && ((this->now_ >> (LEVEL_BITS * level)) & (SLOTS - 1)) == 0) {
+					level++;
+				}
+
+				for (; level > 0; level--) {
+					this->Cascade(level * SLOTS + (static_cast<unsigned int>(this->now_ >> (LEVEL_BITS * level)) & (SLOTS - 1)));
+				}
+			}
+
+			fired += this->Fire();
+		}
+
+		return fired;
+	}
+
+	/**
+	* \brief Получить текущее время для таймеров (монотонное, в миллисекундах)
+	* \return Время
+	*/
+	unsigned long long GetTimerClock()
+	{
+		return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	/**
+	* \brief Получить общее колесо таймеров основного цикла
+	* \return Ссылка на колесо
+	*/
+	TimerWheel& GetTimerWheel()
+	{
+		static TimerWheel wheel(GetTimerClock());
+		return wheel;
+	}
+}
@@ -0,0 +1,90 @@
+﻿/**
+* \brief Определение возможностей процессора (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/cpu.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WQUERY_CPU_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace wquery
+{
+	/**
+	* \brief Поддерживаемые расширения
+	*/
+	struct CpuFeatures
+	{
+		bool sse2 = false;
+		bool avx2 = false;
+	};
+
+	/**
+	* \brief Определить расширения, поддерживаемые процессором и системой
+	* \return Расширения
+	*/
+	static CpuFeatures DetectCpuFeatures()
+	{
+		CpuFeatures features;
+
+#ifdef WQUERY_CPU_X86
+		int info[4] = {};
+#ifdef _MSC_VER
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+		__cpuid(info, 1);
+#else
+		unsigned int a, b, c, d;
+		__cpuid(0, a, b, c, d);
+		const int maxLeaf = static_cast<int>(a);
+		__cpuid(1, a, b, c, d);
+		info[2] = static_cast<int>(c);
+		info[3] = static_cast<int>(d);
+#endif
+		features.sse2 = (info[3] & (1 << 26)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+
+		// AVX2 доступен если его поддерживает процессор и система сохраняет YMM-регистры (XCR0 биты 1 и 2)
+		if (osxsave && maxLeaf >= 7)
+		{
+#ifdef _MSC_VER
+			const unsigned long long xcr0 = _xgetbv(0);
+			__cpuidex(info, 7, 0);
+			const int ebx = info[1];
+#else
+			unsigned int xcrLow, xcrHigh;
+			__asm__("xgetbv" : "=a"(xcrLow), "=d"(xcrHigh) : "c"(0));
+			const unsigned long long xcr0 = xcrLow;
+			__cpuid_count(7, 0, a, b, c, d);
+			const int ebx = static_cast<int>(b);
+#endif
+			features.avx2 = (xcr0 & 0x6) == 0x6 && (ebx & (1 << 5)) != 0;
+		}
+#endif
+
+		return features;
+	}
+
+	/**
+	* \brief Поддерживается ли расширение процессором и системой
+	* \param feature Расширение
+	* \return Состояние
+	*/
+	bool HasCpuFeature(CpuFeature feature)
+	{
+		static const CpuFeatures features = DetectCpuFeatures();
+
+		switch (feature)
+		{
+		case CPU_FEATURE_SSE2: return features.sse2;
+		case CPU_FEATURE_AVX2: return features.avx2;
+		default: return false;
+		}
+	}
+}
@@ -10,8 +10,13 @@
 #include <wquery/stdafx.h>
 #include <wquery/tools/files.h>
 
+#ifdef _WIN32
 #include <Shlwapi.h>
 #pragma comment(lib, "shlwapi.lib")
+#else
+#include <unistd.h>
+#include <climits>
+#endif
 
 namespace wquery
 {
@@ -21,11 +26,18 @@ namespace wquery
 	*/
 	std::string GetExeDir()
 	{
+#ifdef _WIN32
 		char path[MAX_PATH] = {};
 		GetModuleFileNameA(NULL, path, MAX_PATH);
 		PathRemoveFileSpecA(path);
 		PathAddBackslashA(path);
 		return std::string(path);
+#else
+		char path[PATH_MAX] = {};
+		const ssize_t length = readlink("/proc/self/exe", path, PATH_MAX - 1);
+		std::string result(path, length > 0 ? static_cast<size_t>(length) : 0);
+		return result.substr(0, result.find_last_of('/') + 1);
+#endif
 	}
 
 	/**
@@ -35,9 +47,16 @@ namespace wquery
 	*/
 	std::string GetWorkingDir()
 	{
+#ifdef _WIN32
 		char path[MAX_PATH] = {};
 		GetCurrentDirectoryA(MAX_PATH, path);
 		PathAddBackslashA(path);
 		return std::string(path);
+#else
+		char path[PATH_MAX] = {};
+		std::string result(getcwd(path, PATH_MAX) ? path : "");
+		if (result.empty() || result.back() != '/') result.push_back('/');
+		return result;
+#endif
 	}
 }
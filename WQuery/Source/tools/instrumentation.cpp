@@ -0,0 +1,371 @@
+﻿/**
+* \brief Инструментирование обработки сообщений (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/instrumentation.h>
+#include <wquery/platform/Backend.h>
+
+#include <bit>
+
+namespace wquery
+{
+	/**
+	* \brief Кол-во ячеек сообщений (сообщения начиная с WM_USER делят последнюю ячейку)
+	*/
+	static const UINT instrumentedMessageSlots = WM_USER + 1;
+
+	/**
+	* \brief Диапазоны сообщений клавиатуры и мыши (WM_KEYFIRST - WM_KEYLAST, WM_MOUSEFIRST - WM_MOUSELAST)
+	*/
+	static const UINT firstKeyMessage = 0x0100;
+	static const UINT lastKeyMessage = 0x0109;
+	static const UINT firstMouseMessage = 0x0200;
+	static const UINT lastMouseMessage = 0x020E;
+
+	/**
+	* \brief Гистограммы (создаются при первой записи и живут до завершения программы)
+	*/
+	static std::atomic<LatencyHistogram*> dispatchHistograms_[instrumentedMessageSlots];
+	static std::atomic<LatencyHistogram*> inputHistograms_[instrumentedMessageSlots];
+	static std::atomic<LatencyHistogram*> sectionHistograms_[INSTRUMENTED_SECTION_COUNT];
+
+	/**
+	* \brief Получить гистограмму ячейки (при отсутствии - создать)
+	* \details Одновременное создание из нескольких потоков разрешается обменом: проигравший поток удаляет свою
+	* \param slot Ячейка
+	* \return Гистограмма
+	*/
+	static LatencyHistogram& AcquireHistogram(std::atomic<LatencyHistogram*>& slot)
+	{
+		LatencyHistogram* histogram = slot.load(std::memory_order_acquire);
+		if (histogram) return *histogram;
+
+		LatencyHistogram* created = new LatencyHistogram();
+		if (slot.compare_exchange_strong(histogram, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+			return *created;
+		}
+
+		delete created;
+		return *histogram;
+	}
+
+	/**
+	* \brief Получить ячейку сообщения
+	* \param message Сообщение
+	* \return Индекс ячейки
+	*/
+	static UINT GetMessageSlot(UINT message)
+	{
+		return (std::min)(message, static_cast<UINT>(WM_USER));
+	}
+
+	/**
+	* \brief Время от начала замера
+	* \param start Начало замера
+	* \return Время (нс)
+	*/
+	static unsigned long long GetElapsedNanoseconds(const std::chrono::steady_clock::time_point& start)
+	{
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+
+	/**
+	* \brief Конструктор
+	*/
+	LatencyHistogram::LatencyHistogram()
+	{
+		this->Reset();
+	}
+
+	/**
+	* \brief Получить интервал значения
+	* \details Значения меньше 2^(SUB_BUCKET_BITS + 1) занимают по интервалу, далее каждая степень двойки
+	* делится на 2^SUB_BUCKET_BITS равных интервалов
+	* \param value Значение
+	* \return Индекс интервала
+	*/
+	unsigned int LatencyHistogram::GetBucket(unsigned long long value)
+	{
+		if (value < (2ull << SUB_BUCKET_BITS)) return static_cast<unsigned int>(value);
+
+		const unsigned int shift = static_cast<unsigned int>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+		return (shift << SUB_BUCKET_BITS) + static_cast<unsigned int>(value >> shift);
+	}
+
+	/**
+	* \brief Получить наибольшее значение интервала
+	* \param bucket Индекс интервала
+	* \return Значение
+	*/
+	unsigned long long LatencyHistogram::GetBucketLimit(unsigned int bucket)
+	{
+		if (bucket < (2u << SUB_BUCKET_BITS)) return bucket;
+
+		const unsigned int shift = (bucket >> SUB_BUCKET_BITS) - 1;
+		const unsigned long long mantissa = (bucket & ((1u << SUB_BUCKET_BITS) - 1)) + (1ull << SUB_BUCKET_BITS);
+		return ((mantissa + 1) << shift) - 1;
+	}
+
+	/**
+	* \brief Записать значение
+	* \param nanoseconds Время (нс)
+	*/
+	void LatencyHistogram::Record(unsigned long long nanoseconds)
+	{
+		const unsigned long long value = (std::min)(nanoseconds, (1ull << VALUE_BITS) - 1);
+		this->buckets_[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+		this->total_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+		unsigned long long max = this->max_.load(std::memory_order_relaxed);
+		while (nanoseconds > max && !this->max_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {}
+	}
+
+	/**
+	* \brief Получить сводку
+	* \param summary Сводка (время в микросекундах)
+	*/
+	void LatencyHistogram::Summarize(LatencySummary& summary) const
+	{
+		unsigned long long buckets[BUCKET_COUNT] = {};
+		summary = {};
+		this->Accumulate(buckets, summary);
+		SummarizeBuckets(buckets, summary);
+	}
+
+	/**
+	* \brief Добавить значения в массив кол-в по интервалам
+	* \param buckets Массив из BUCKET_COUNT кол-в
+	* \param summary Сводка, в которой накапливаются кол-во, сумма и наибольшее значение
+	*/
+	void LatencyHistogram::Accumulate(unsigned long long* buckets, LatencySummary& summary) const
+	{
+		for (unsigned int i = 0; i < BUCKET_COUNT; i++) {
+			buckets[i] += this->buckets_[i].load(std::memory_order_relaxed);
+		}
+
+		summary.total += static_cast<double>(this->total_.load(std::memory_order_relaxed)) / 1000.0;
+		summary.max = (std::max)(summary.max, static_cast<double>(this->max_.load(std::memory_order_relaxed)) / 1000.0);
+	}
+
+	/**
+	* \brief Вычислить процентили сводки по массиву кол-в по интервалам
+	* \details Кол-во значений - сумма кол-в по интервалам. Процентиль - наибольшее значение интервала, но не больше наибольшего значения
+	* \param buckets Массив из BUCKET_COUNT кол-в
+	* \param summary Сводка
+	*/
+	void LatencyHistogram::SummarizeBuckets(const unsigned long long* buckets, LatencySummary& summary)
+	{
+		summary.count = 0;
+		for (unsigned int i = 0; i < BUCKET_COUNT; i++) summary.count += buckets[i];
+
+		summary.mean = summary.p50 = summary.p90 = summary.p99 = summary.p999 = 0.0;
+		if (summary.count == 0) return;
+
+		summary.mean = summary.total / static_cast<double>(summary.count);
+
+		const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+		double* const targets[] = { &summary.p50, &summary.p90, &summary.p99, &summary.p999 };
+
+		unsigned long long seen = 0;
+		unsigned int bucket = 0;
+
+		for (size_t i = 0; i < std::size(quantiles); i++)
+		{
+			const auto rank = (std::max)(static_cast<unsigned long long>(std::ceil(quantiles[i] * static_cast<double>(summary.count))), 1ull);
+
+			while (bucket < BUCKET_COUNT && seen + buckets[bucket] < rank) {
+				seen += buckets[bucket++];
+			}
+
+			const double limit = static_cast<double>(GetBucketLimit((std::min)(bucket, BUCKET_COUNT - 1))) / 1000.0;
+			*targets[i] = summary.max > 0.0 ? (std::min)(limit, summary.max) : limit;
+		}
+	}
+
+	/**
+	* \brief Очистить гистограмму
+	*/
+	void LatencyHistogram::Reset()
+	{
+		for (auto& bucket : this->buckets_) bucket.store(0, std::memory_order_relaxed);
+		this->total_.store(0, std::memory_order_relaxed);
+		this->max_.store(0, std::memory_order_relaxed);
+	}
+
+	/**
+	* \brief Завершить замер обработки сообщения
+	*/
+	MessageTimer::~MessageTimer()
+	{
+		AcquireHistogram(dispatchHistograms_[GetMessageSlot(this->message_)]).Record(GetElapsedNanoseconds(this->start_));
+	}
+
+	/**
+	* \brief Завершить замер участка
+	*/
+	SectionTimer::~SectionTimer()
+	{
+		AcquireHistogram(sectionHistograms_[this->section_]).Record(GetElapsedNanoseconds(this->start_));
+	}
+
+	/**
+	* \brief Записать задержку ввода обрабатываемого сообщения
+	* \param message Сообщение
+	*/
+	void RecordInputLatency(UINT message)
+	{
+		const bool input = (message >= firstKeyMessage && message <= lastKeyMessage) ||
+			(message >= firstMouseMessage && message <= lastMouseMessage);
+		if (!input) return;
+
+		// Сообщение, переданное из другого потока, не стояло в очереди: время сообщения - время последнего
+		// извлеченного из очереди, и разница с часами была бы задержкой чужого сообщения
+		Backend& backend = GetBackend();
+		if (backend.IsCurrentMessageSent()) return;
+
+		// Часы 32-битные и переполняются, разница считается по модулю. "Отрицательная" разница (время
+		// сообщения позже часов, например, у синтезированного сообщения) не является задержкой
+		const DWORD elapsed = backend.GetMessageClock() - backend.GetCurrentMessageTime();
+		if (elapsed >= 0x80000000u) return;
+
+		AcquireHistogram(inputHistograms_[GetMessageSlot(message)]).Record(static_cast<unsigned long long>(elapsed) * 1000000ull);
+	}
+
+	/**
+	* \brief Получить снимок статистики
+	* \param snapshot Снимок
+	*/
+	void GetInstrumentationSnapshot(InstrumentationSnapshot& snapshot)
+	{
+		snapshot.messages.clear();
+		snapshot.inputLatency = {};
+
+		std::vector<unsigned long long> inputBuckets(LatencyHistogram::BUCKET_COUNT, 0);
+
+		for (UINT slot = 0; slot < instrumentedMessageSlots; slot++)
+		{
+			const LatencyHistogram* dispatch = dispatchHistograms_[slot].load(std::memory_order_acquire);
+			const LatencyHistogram* input = inputHistograms_[slot].load(std::memory_order_acquire);
+			if (!dispatch && !input) continue;
+
+			MessageStatistics statistics = {};
+			statistics.message = slot;
+			if (dispatch) dispatch->Summarize(statistics.dispatch);
+
+			if (input)
+			{
+				input->Summarize(statistics.inputLatency);
+				input->Accumulate(inputBuckets.data(), snapshot.inputLatency);
+			}
+
+			// Сообщения, не приходившие после сброса, в снимок не попадают
+			if (statistics.dispatch.count > 0 || statistics.inputLatency.count > 0) {
+				snapshot.messages.push_back(statistics);
+			}
+		}
+
+		LatencyHistogram::SummarizeBuckets(inputBuckets.data(), snapshot.inputLatency);
+
+		for (unsigned int i = 0; i < INSTRUMENTED_SECTION_COUNT; i++)
+		{
+			const LatencyHistogram* section = sectionHistograms_[i].load(std::memory_order_acquire);
+			snapshot.sections[i] = {};
+			if (section) section->Summarize(snapshot.sections[i]);
+		}
+	}
+
+	/**
+	* \brief Сбросить статистику
+	*/
+	void ResetInstrumentation()
+	{
+		for (UINT slot = 0; slot < instrumentedMessageSlots; slot++)
+		{
+			if (LatencyHistogram* dispatch = dispatchHistograms_[slot].load(std::memory_order_acquire)) dispatch->Reset();
+			if (LatencyHistogram* input = inputHistograms_[slot].load(std::memory_order_acquire)) input->Reset();
+		}
+
+		for (auto& section : sectionHistograms_)
+		{
+			if (LatencyHistogram* histogram = section.load(std::memory_order_acquire)) histogram->Reset();
+		}
+	}
+
+	/**
+	* \brief Получить наименование участка
+	* \param section Участок
+	* \return Наименование
+	*/
+	const char* GetInstrumentedSectionName(InstrumentedSection section)
+	{
+		static const char* const names[INSTRUMENTED_SECTION_COUNT] = {
+			"onResized",
+			"onKeyDown",
+			"onKeyUp",
+			"onTyping",
+			"onMouseKeyDown",
+			"onMouseKeyUp",
+			"onMouseMove",
+			"onPaint",
+			"notification",
+			"posted tasks",
+			"timers",
+			"coroutines",
+			"paint flush",
+			"loop callback"
+		};
+
+		return section < INSTRUMENTED_SECTION_COUNT ? names[section] : "";
+	}
+
+	/**
+	* \brief Получить наименование сообщения
+	* \param message Сообщение
+	* \return Наименование (nullptr - сообщение неизвестно)
+	*/
+	const char* GetInstrumentedMessageName(UINT message)
+	{
+#define WQUERY_MESSAGE_NAME(name) case name: return #name;
+
+		if (message >= WM_USER) return "WM_USER+";
+
+		switch (message)
+		{
+			WQUERY_MESSAGE_NAME(WM_CREATE)
+			WQUERY_MESSAGE_NAME(WM_DESTROY)
+			WQUERY_MESSAGE_NAME(WM_MOVE)
+			WQUERY_MESSAGE_NAME(WM_SIZE)
+			WQUERY_MESSAGE_NAME(WM_SETFOCUS)
+			WQUERY_MESSAGE_NAME(WM_KILLFOCUS)
+			WQUERY_MESSAGE_NAME(WM_SETTEXT)
+			WQUERY_MESSAGE_NAME(WM_GETTEXT)
+			WQUERY_MESSAGE_NAME(WM_GETTEXTLENGTH)
+			WQUERY_MESSAGE_NAME(WM_PAINT)
+			WQUERY_MESSAGE_NAME(WM_CLOSE)
+			WQUERY_MESSAGE_NAME(WM_ERASEBKGND)
+			WQUERY_MESSAGE_NAME(WM_GETMINMAXINFO)
+			WQUERY_MESSAGE_NAME(WM_SETFONT)
+			WQUERY_MESSAGE_NAME(WM_SETICON)
+			WQUERY_MESSAGE_NAME(WM_NCPAINT)
+			WQUERY_MESSAGE_NAME(WM_KEYDOWN)
+			WQUERY_MESSAGE_NAME(WM_KEYUP)
+			WQUERY_MESSAGE_NAME(WM_CHAR)
+			WQUERY_MESSAGE_NAME(WM_COMMAND)
+			WQUERY_MESSAGE_NAME(WM_TIMER)
+			WQUERY_MESSAGE_NAME(WM_MOUSEMOVE)
+			WQUERY_MESSAGE_NAME(WM_LBUTTONDOWN)
+			WQUERY_MESSAGE_NAME(WM_LBUTTONUP)
+			WQUERY_MESSAGE_NAME(WM_RBUTTONDOWN)
+			WQUERY_MESSAGE_NAME(WM_RBUTTONUP)
+			WQUERY_MESSAGE_NAME(WM_MBUTTONDOWN)
+			WQUERY_MESSAGE_NAME(WM_MBUTTONUP)
+			WQUERY_MESSAGE_NAME(WM_MOUSEWHEEL)
+		default:
+			return nullptr;
+		}
+
+#undef WQUERY_MESSAGE_NAME
+	}
+}
@@ -0,0 +1,748 @@
+﻿/**
+* \brief Растровые функции - внутренние циклы рисования на холсте (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/raster.h>
+#include <wquery/tools/cpu.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WQUERY_RASTER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define WQUERY_TARGET_AVX2
+#else
+#define WQUERY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace wquery
+{
+	/*
+	* О П Р Е Д Е Л Е Н И Е  Н А Б О Р А  И Н С Т Р У К Ц И Й
+	*/
+
+	/**
+	* \brief Определить лучший набор инструкций, поддерживаемый процессором и системой
+	* \return Набор инструкций
+	*/
+	static RasterKernel DetectRasterKernel()
+	{
+		if (HasCpuFeature(CPU_FEATURE_AVX2)) return RASTER_KERNEL_AVX2;
+		if (HasCpuFeature(CPU_FEATURE_SSE2)) return RASTER_KERNEL_SSE2;
+		return RASTER_KERNEL_SCALAR;
+	}
+
+	/**
+	* \brief Лучший поддерживаемый набор инструкций
+	*/
+	static const RasterKernel supportedKernel_ = DetectRasterKernel();
+
+	/**
+	* \brief Текущий набор инструкций
+	*/
+	static RasterKernel kernel_ = supportedKernel_;
+
+	/**
+	* \brief Получить текущий набор инструкций
+	* \return Набор инструкций
+	*/
+	RasterKernel GetRasterKernel()
+	{
+		return kernel_;
+	}
+
+	/**
+	* \brief Выбрать набор инструкций
+	* \param kernel Набор инструкций
+	* \return Поддерживается ли он процессором
+	*/
+	bool SetRasterKernel(RasterKernel kernel)
+	{
+		if (kernel > supportedKernel_) return false;
+		kernel_ = kernel;
+		return true;
+	}
+
+	/**
+	* \brief Получить наименование набора инструкций
+	* \param kernel Набор инструкций
+	* \return Строка
+	*/
+	const char* GetRasterKernelName(RasterKernel kernel)
+	{
+		switch (kernel)
+		{
+		case RASTER_KERNEL_SSE2: return "sse2";
+		case RASTER_KERNEL_AVX2: return "avx2";
+		default: return "scalar";
+		}
+	}
+
+	/*
+	* С К А Л Я Р Н Ы Е  Р Е А Л И З А Ц И И  (Э Т А Л О Н)
+	*/
+
+	/**
+	* \brief Умножить каналы пикселя на коэффициент с делением на 255 и округлением
+	* \details Для каждого канала v = channel * factor + 128, результат (v + (v >> 8)) >> 8 (точно для всех значений).
+	* Каналы обрабатываются парами (R и B, A и G) в 16-битных половинах 32-битного числа: промежуточные значения
+	* не превышают 16 бит, поэтому половины не влияют друг на друга
+	* \param pixel Пиксель
+	* \param factor Коэффициент (0..255)
+	* \return Результат
+	*/
+	static inline std::uint32_t ScalePixel(const std::uint32_t pixel, const std::uint32_t factor)
+	{
+		std::uint32_t rb = (pixel & 0x00FF00FF) * factor + 0x00800080;
+		std::uint32_t ag = ((pixel >> 8) & 0x00FF00FF) * factor + 0x00800080;
+		rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+		ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+		return rb | ag;
+	}
+
+	/**
+	* \brief Наложить пиксель (source-over)
+	* \param dst Пиксель назначения
+	* \param src Пиксель источника (premultiplied)
+	* \return Результат
+	*/
+	static inline std::uint32_t BlendPixel(const std::uint32_t dst, const std::uint32_t src)
+	{
+		const std::uint32_t scaled = ScalePixel(dst, 255 - (src >> 24));
+		std::uint32_t rb = (src & 0x00FF00FF) + (scaled & 0x00FF00FF);
+		std::uint32_t ag = ((src >> 8) & 0x00FF00FF) + ((scaled >> 8) & 0x00FF00FF);
+
+		// Насыщение: переполненные каналы (бит 8 половины) заполняются единицами
+		rb |= (rb & 0x01000100) - ((rb & 0x01000100) >> 8);
+		ag |= (ag & 0x01000100) - ((ag & 0x01000100) >> 8);
+		return (rb & 0x00FF00FF) | ((ag & 0x00FF00FF) << 8);
+	}
+
+	/**
+	* \brief Параметры градиента в фиксированной точке (16.16) для каждого канала
+	*/
+	struct GradientSteps
+	{
+		std::int32_t value[4];   // Значение канала в первом пикселе отрезка (с учетом округления)
+		std::int32_t step[4];    // Приращение канала на пиксель
+	};
+
+	/**
+	* \brief Рассчитать параметры градиента
+	* \param from Начальный пиксель
+	* \param to Конечный пиксель
+	* \param offset Позиция первого пикселя отрезка в градиенте
+	* \param length Длина всего градиента
+	* \return Параметры
+	*/
+	static GradientSteps GetGradientSteps(const std::uint32_t from, const std::uint32_t to, const size_t offset, const size_t length)
+	{
+		GradientSteps steps = {};
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			const long long first = (from >> (c * 8)) & 0xFF;
+			const long long last = (to >> (c * 8)) & 0xFF;
+			const long long step = length > 1 ? ((last - first) * 65536) / static_cast<long long>(length - 1) : 0;
+
+			steps.step[c] = static_cast<std::int32_t>(step);
+			steps.value[c] = static_cast<std::int32_t>(first * 65536 + 32768 + step * static_cast<long long>(offset));
+		}
+
+		return steps;
+	}
+
+	/**
+	* \brief Собрать пиксель градиента из значений каналов
+	* \param steps Параметры градиента
+	* \param index Номер пикселя в отрезке
+	* \return Пиксель
+	*/
+	static inline std::uint32_t GradientPixel(const GradientSteps& steps, const std::int32_t index)
+	{
+		std::uint32_t result = 0;
+		for (unsigned int c = 0; c < 4; c++) {
+			result |= static_cast<std::uint32_t>((steps.value[c] + steps.step[c] * index) >> 16) << (c * 8);
+		}
+		return result;
+	}
+
+	/**
+	* \brief Наложить пиксели источника (скалярная реализация)
+	* \param dst Пиксели
+	* \param src Пиксели источника
+	* \param count Кол-во пикселей
+	*/
+	static void BlendPixelsScalar(std::uint32_t* dst, const std::uint32_t* src, const size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const std::uint32_t pixel = src[i];
+			if ((pixel >> 24) == 255) dst[i] = pixel;
+			else if (pixel != 0) dst[i] = BlendPixel(dst[i], pixel);
+		}
+	}
+
+#ifdef WQUERY_RASTER_X86
+	/*
+	* В Е К Т О Р Н Ы Е  Р Е А Л И З А Ц И И  (S S E 2)
+	*/
+
+	/**
+	* \brief Наложить 4 пикселя источника (формула совпадает со скалярной BlendPixel)
+	* \param dst Пиксели назначения
+	* \param src Пиксели источника (premultiplied)
+	* \return Результат
+	*/
+	static inline __m128i BlendSse2(const __m128i dst, const __m128i src)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(128);
+		const __m128i full = _mm_set1_epi16(255);
+
+		// Каналы расширяются до 16 бит, альфа-канал каждого пикселя размножается на все его каналы
+		const __m128i srcLow = _mm_unpacklo_epi8(src, zero);
+		const __m128i srcHigh = _mm_unpackhi_epi8(src, zero);
+		const __m128i inverseLow = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcLow, 0xFF), 0xFF));
+		const __m128i inverseHigh = _mm_sub_epi16(full, _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcHigh, 0xFF), 0xFF));
+
+		__m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inverseLow), round);
+		__m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inverseHigh), round);
+		low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+		return _mm_adds_epu8(src, _mm_packus_epi16(low, high));
+	}
+
+	/**
+	* \brief Умножить каналы 4 пикселей на покрытие (формула совпадает со скалярной ScalePixel)
+	* \param pixel Пиксель во всех 4 позициях
+	* \param coverage Покрытие каждого пикселя, размноженное на все его каналы (байты)
+	* \return Результат
+	*/
+	static inline __m128i ScaleSse2(const __m128i pixel, const __m128i coverage)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i round = _mm_set1_epi16(128);
+
+		__m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixel, zero), _mm_unpacklo_epi8(coverage, zero)), round);
+		__m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixel, zero), _mm_unpackhi_epi8(coverage, zero)), round);
+		low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+		high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+		return _mm_packus_epi16(low, high);
+	}
+
+	/**
+	* \brief Залить отрезок (SSE2)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель
+	* \return Кол-во обработанных пикселей (кратно 4)
+	*/
+	static size_t FillPixelsSse2(std::uint32_t* dst, const size_t count, const std::uint32_t pixel)
+	{
+		const __m128i value = _mm_set1_epi32(static_cast<int>(pixel));
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Наложить пиксели источника (SSE2)
+	* \param dst Пиксели
+	* \param src Пиксели источника
+	* \param count Кол-во пикселей
+	* \return Кол-во обработанных пикселей (кратно 4)
+	*/
+	static size_t BlendPixelsSse2(std::uint32_t* dst, const std::uint32_t* src, const size_t count)
+	{
+		const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+			// Блоки целиком непрозрачных и целиком пустых пикселей (самые частые в спрайтах) не смешиваются
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(source, alphaMask), alphaMask)) == 0xFFFF) {
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), source);
+				continue;
+			}
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(source, zero)) == 0xFFFF) continue;
+
+			const __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), BlendSse2(target, source));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Наложить один пиксель на отрезок (SSE2)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	* \return Кол-во обработанных пикселей (кратно 4)
+	*/
+	static size_t BlendSolidPixelsSse2(std::uint32_t* dst, const size_t count, const std::uint32_t pixel)
+	{
+		const __m128i source = _mm_set1_epi32(static_cast<int>(pixel));
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), BlendSse2(target, source));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Наложить пиксель через маску покрытия (SSE2)
+	* \param dst Пиксели
+	* \param mask Покрытие пикселей
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	* \return Кол-во обработанных пикселей (кратно 4)
+	*/
+	static size_t BlendMaskPixelsSse2(std::uint32_t* dst, const unsigned char* mask, const size_t count, const std::uint32_t pixel)
+	{
+		const __m128i source = _mm_set1_epi32(static_cast<int>(pixel));
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			std::uint32_t coverage;
+			std::memcpy(&coverage, mask + i, sizeof(coverage));
+
+			// Пустые участки (промежутки между штрихами символов) пропускаются
+			if (coverage == 0) continue;
+
+			// Покрытие каждого пикселя размножается на 4 байта: m0 m0 m0 m0 m1 m1 m1 m1 ...
+			__m128i spread = _mm_cvtsi32_si128(static_cast<int>(coverage));
+			spread = _mm_unpacklo_epi8(spread, spread);
+			spread = _mm_unpacklo_epi16(spread, spread);
+
+			const __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), BlendSse2(target, ScaleSse2(source, spread)));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Скопировать пиксели, кроме ключевого цвета (SSE2)
+	* \param dst Пиксели
+	* \param src Пиксели источника
+	* \param count Кол-во пикселей
+	* \param key Ключевой цвет
+	* \return Кол-во обработанных пикселей (кратно 4)
+	*/
+	static size_t CopyPixelsKeyedSse2(std::uint32_t* dst, const std::uint32_t* src, const size_t count, const std::uint32_t key)
+	{
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i keyValue = _mm_set1_epi32(static_cast<int>(key & 0x00FFFFFF));
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+			const __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(source, colorMask), keyValue);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(_mm_and_si128(keep, target), _mm_andnot_si128(keep, source)));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Залить отрезок градиентом (SSE2)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param steps Параметры градиента
+	* \return Кол-во обработанных пикселей (кратно 4)
+	*/
+	static size_t GradientPixelsSse2(std::uint32_t* dst, const size_t count, const GradientSteps& steps)
+	{
+		__m128i value[4];
+		__m128i step[4];
+
+		// Каждый канал - отдельный вектор значений 4 соседних пикселей
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			const std::int32_t v = steps.value[c];
+			const std::int32_t s = steps.step[c];
+			value[c] = _mm_setr_epi32(v, v + s, v + s * 2, v + s * 3);
+			step[c] = _mm_set1_epi32(s * 4);
+		}
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i pixels = _mm_srli_epi32(value[0], 16);
+			pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_srli_epi32(value[1], 16), 8));
+			pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_srli_epi32(value[2], 16), 16));
+			pixels = _mm_or_si128(pixels, _mm_slli_epi32(_mm_srli_epi32(value[3], 16), 24));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pixels);
+
+			for (unsigned int c = 0; c < 4; c++) value[c] = _mm_add_epi32(value[c], step[c]);
+		}
+
+		return i;
+	}
+
+	/*
+	* В Е К Т О Р Н Ы Е  Р Е А Л И З А Ц И И  (A V X 2)
+	*/
+
+	/**
+	* \brief Наложить 8 пикселей источника (формула совпадает со скалярной BlendPixel)
+	* \param dst Пиксели назначения
+	* \param src Пиксели источника (premultiplied)
+	* \return Результат
+	*/
+	WQUERY_TARGET_AVX2 static inline __m256i BlendAvx2(const __m256i dst, const __m256i src)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i round = _mm256_set1_epi16(128);
+		const __m256i full = _mm256_set1_epi16(255);
+
+		const __m256i srcLow = _mm256_unpacklo_epi8(src, zero);
+		const __m256i srcHigh = _mm256_unpackhi_epi8(src, zero);
+		const __m256i inverseLow = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcLow, 0xFF), 0xFF));
+		const __m256i inverseHigh = _mm256_sub_epi16(full, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(srcHigh, 0xFF), 0xFF));
+
+		__m256i low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), inverseLow), round);
+		__m256i high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), inverseHigh), round);
+		low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+		high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+		// Распаковка и упаковка идут внутри 128-битных половин, поэтому порядок пикселей сохраняется
+		return _mm256_adds_epu8(src, _mm256_packus_epi16(low, high));
+	}
+
+	/**
+	* \brief Умножить каналы 8 пикселей на покрытие (формула совпадает со скалярной ScalePixel)
+	* \param pixel Пиксель во всех 8 позициях
+	* \param coverage Покрытие каждого пикселя, размноженное на все его каналы (байты)
+	* \return Результат
+	*/
+	WQUERY_TARGET_AVX2 static inline __m256i ScaleAvx2(const __m256i pixel, const __m256i coverage)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i round = _mm256_set1_epi16(128);
+
+		__m256i low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pixel, zero), _mm256_unpacklo_epi8(coverage, zero)), round);
+		__m256i high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pixel, zero), _mm256_unpackhi_epi8(coverage, zero)), round);
+		low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+		high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+		return _mm256_packus_epi16(low, high);
+	}
+
+	/**
+	* \brief Залить отрезок (AVX2)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель
+	* \return Кол-во обработанных пикселей (кратно 8)
+	*/
+	WQUERY_TARGET_AVX2 static size_t FillPixelsAvx2(std::uint32_t* dst, const size_t count, const std::uint32_t pixel)
+	{
+		const __m256i value = _mm256_set1_epi32(static_cast<int>(pixel));
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), value);
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Наложить пиксели источника (AVX2)
+	* \param dst Пиксели
+	* \param src Пиксели источника
+	* \param count Кол-во пикселей
+	* \return Кол-во обработанных пикселей (кратно 8)
+	*/
+	WQUERY_TARGET_AVX2 static size_t BlendPixelsAvx2(std::uint32_t* dst, const std::uint32_t* src, const size_t count)
+	{
+		const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+		const __m256i zero = _mm256_setzero_si256();
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i source = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+			if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(source, alphaMask), alphaMask)) == -1) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), source);
+				continue;
+			}
+			if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(source, zero)) == -1) continue;
+
+			const __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), BlendAvx2(target, source));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Наложить один пиксель на отрезок (AVX2)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	* \return Кол-во обработанных пикселей (кратно 8)
+	*/
+	WQUERY_TARGET_AVX2 static size_t BlendSolidPixelsAvx2(std::uint32_t* dst, const size_t count, const std::uint32_t pixel)
+	{
+		const __m256i source = _mm256_set1_epi32(static_cast<int>(pixel));
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), BlendAvx2(target, source));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Наложить пиксель через маску покрытия (AVX2)
+	* \param dst Пиксели
+	* \param mask Покрытие пикселей
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	* \return Кол-во обработанных пикселей (кратно 8)
+	*/
+	WQUERY_TARGET_AVX2 static size_t BlendMaskPixelsAvx2(std::uint32_t* dst, const unsigned char* mask, const size_t count, const std::uint32_t pixel)
+	{
+		const __m256i source = _mm256_set1_epi32(static_cast<int>(pixel));
+		const __m256i spread = _mm256_setr_epi8(
+			0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12,
+			0, 0, 0, 0, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12);
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i coverage = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask + i));
+			if (_mm_testz_si128(coverage, coverage)) continue;
+
+			// Покрытие расширяется до 32 бит на пиксель и размножается на все его байты
+			const __m256i expanded = _mm256_shuffle_epi8(_mm256_cvtepu8_epi32(coverage), spread);
+			const __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), BlendAvx2(target, ScaleAvx2(source, expanded)));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Скопировать пиксели, кроме ключевого цвета (AVX2)
+	* \param dst Пиксели
+	* \param src Пиксели источника
+	* \param count Кол-во пикселей
+	* \param key Ключевой цвет
+	* \return Кол-во обработанных пикселей (кратно 8)
+	*/
+	WQUERY_TARGET_AVX2 static size_t CopyPixelsKeyedAvx2(std::uint32_t* dst, const std::uint32_t* src, const size_t count, const std::uint32_t key)
+	{
+		const __m256i colorMask = _mm256_set1_epi32(0x00FFFFFF);
+		const __m256i keyValue = _mm256_set1_epi32(static_cast<int>(key & 0x00FFFFFF));
+		size_t i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i source = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			const __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+			const __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(source, colorMask), keyValue);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_blendv_epi8(source, target, keep));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Залить отрезок градиентом (AVX2)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param steps Параметры градиента
+	* \return Кол-во обработанных пикселей (кратно 8)
+	*/
+	WQUERY_TARGET_AVX2 static size_t GradientPixelsAvx2(std::uint32_t* dst, const size_t count, const GradientSteps& steps)
+	{
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		__m256i value[4];
+		__m256i step[4];
+
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			value[c] = _mm256_add_epi32(_mm256_set1_epi32(steps.value[c]), _mm256_mullo_epi32(_mm256_set1_epi32(steps.step[c]), lanes));
+			step[c] = _mm256_set1_epi32(steps.step[c] * 8);
+		}
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256i pixels = _mm256_srli_epi32(value[0], 16);
+			pixels = _mm256_or_si256(pixels, _mm256_slli_epi32(_mm256_srli_epi32(value[1], 16), 8));
+			pixels = _mm256_or_si256(pixels, _mm256_slli_epi32(_mm256_srli_epi32(value[2], 16), 16));
+			pixels = _mm256_or_si256(pixels, _mm256_slli_epi32(_mm256_srli_epi32(value[3], 16), 24));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), pixels);
+
+			for (unsigned int c = 0; c < 4; c++) value[c] = _mm256_add_epi32(value[c], step[c]);
+		}
+
+		return i;
+	}
+#endif
+
+	/*
+	* О Б Щ И Е  Ф У Н К Ц И И  (В Ы Б О Р  Р Е А Л И З А Ц И И)
+	*/
+
+	/**
+	* \brief Залить отрезок одним пикселем
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель
+	*/
+	void FillPixels(std::uint32_t* dst, const size_t count, const std::uint32_t pixel)
+	{
+		size_t done = 0;
+
+#ifdef WQUERY_RASTER_X86
+		if (kernel_ == RASTER_KERNEL_AVX2) done = FillPixelsAvx2(dst, count, pixel);
+		else if (kernel_ == RASTER_KERNEL_SSE2) done = FillPixelsSse2(dst, count, pixel);
+#endif
+
+		for (size_t i = done; i < count; i++) dst[i] = pixel;
+	}
+
+	/**
+	* \brief Наложить пиксели источника на отрезок (source-over)
+	* \param dst Пиксели
+	* \param src Пиксели источника (premultiplied)
+	* \param count Кол-во пикселей
+	*/
+	void BlendPixels(std::uint32_t* dst, const std::uint32_t* src, const size_t count)
+	{
+		size_t done = 0;
+
+#ifdef WQUERY_RASTER_X86
+		if (kernel_ == RASTER_KERNEL_AVX2) done = BlendPixelsAvx2(dst, src, count);
+		else if (kernel_ == RASTER_KERNEL_SSE2) done = BlendPixelsSse2(dst, src, count);
+#endif
+
+		BlendPixelsScalar(dst + done, src + done, count - done);
+	}
+
+	/**
+	* \brief Наложить один полупрозрачный пиксель на весь отрезок (source-over)
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	*/
+	void BlendSolidPixels(std::uint32_t* dst, const size_t count, const std::uint32_t pixel)
+	{
+		// Непрозрачный пиксель - обычная заливка, пустой - ничего не меняет
+		if ((pixel >> 24) == 255) {
+			FillPixels(dst, count, pixel);
+			return;
+		}
+		if (pixel == 0) return;
+
+		size_t done = 0;
+
+#ifdef WQUERY_RASTER_X86
+		if (kernel_ == RASTER_KERNEL_AVX2) done = BlendSolidPixelsAvx2(dst, count, pixel);
+		else if (kernel_ == RASTER_KERNEL_SSE2) done = BlendSolidPixelsSse2(dst, count, pixel);
+#endif
+
+		for (size_t i = done; i < count; i++) dst[i] = BlendPixel(dst[i], pixel);
+	}
+
+	/**
+	* \brief Наложить пиксель на отрезок через маску покрытия
+	* \param dst Пиксели
+	* \param mask Покрытие пикселей (0..255)
+	* \param count Кол-во пикселей
+	* \param pixel Пиксель (premultiplied)
+	*/
+	void BlendMaskPixels(std::uint32_t* dst, const unsigned char* mask, const size_t count, const std::uint32_t pixel)
+	{
+		if (pixel == 0) return;
+
+		size_t done = 0;
+
+#ifdef WQUERY_RASTER_X86
+		if (kernel_ == RASTER_KERNEL_AVX2) done = BlendMaskPixelsAvx2(dst, mask, count, pixel);
+		else if (kernel_ == RASTER_KERNEL_SSE2) done = BlendMaskPixelsSse2(dst, mask, count, pixel);
+#endif
+
+		// Полное покрытие непрозрачным цветом (внутренние пиксели штрихов) - простая запись
+		const bool opaque = (pixel >> 24) == 255;
+
+		for (size_t i = done; i < count; i++)
+		{
+			if (mask[i] == 0) continue;
+			dst[i] = mask[i] == 255 && opaque ? pixel : BlendPixel(dst[i], ScalePixel(pixel, mask[i]));
+		}
+	}
+
+	/**
+	* \brief Скопировать пиксели источника, кроме пикселей ключевого цвета
+	* \param dst Пиксели
+	* \param src Пиксели источника
+	* \param count Кол-во пикселей
+	* \param key Ключевой цвет
+	*/
+	void CopyPixelsKeyed(std::uint32_t* dst, const std::uint32_t* src, const size_t count, const std::uint32_t key)
+	{
+		size_t done = 0;
+
+#ifdef WQUERY_RASTER_X86
+		if (kernel_ == RASTER_KERNEL_AVX2) done = CopyPixelsKeyedAvx2(dst, src, count, key);
+		else if (kernel_ == RASTER_KERNEL_SSE2) done = CopyPixelsKeyedSse2(dst, src, count, key);
+#endif
+
+		for (size_t i = done; i < count; i++) {
+			if ((src[i] ^ key) & 0x00FFFFFF) dst[i] = src[i];
+		}
+	}
+
+	/**
+	* \brief Залить отрезок линейным градиентом
+	* \param dst Пиксели
+	* \param count Кол-во пикселей
+	* \param from Начальный пиксель
+	* \param to Конечный пиксель
+	* \param offset Позиция первого пикселя отрезка в градиенте
+	* \param length Длина всего градиента
+	*/
+	void GradientPixels(std::uint32_t* dst, const size_t count, const std::uint32_t from, const std::uint32_t to, const size_t offset, const size_t length)
+	{
+		const GradientSteps steps = GetGradientSteps(from, to, offset, length);
+		size_t done = 0;
+
+#ifdef WQUERY_RASTER_X86
+		if (kernel_ == RASTER_KERNEL_AVX2) done = GradientPixelsAvx2(dst, count, steps);
+		else if (kernel_ == RASTER_KERNEL_SSE2) done = GradientPixelsSse2(dst, count, steps);
+#endif
+
+		for (size_t i = done; i < count; i++) dst[i] = GradientPixel(steps, static_cast<std::int32_t>(i));
+	}
+}
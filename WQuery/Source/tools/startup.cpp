@@ -0,0 +1,121 @@
+﻿/**
+* \brief Замеры времени запуска (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/startup.h>
+
+namespace wquery
+{
+	typedef std::chrono::steady_clock StartupClock;
+	typedef std::chrono::duration<double, std::milli> StartupMilliseconds;
+
+	/**
+	* \brief Статистика запуска
+	*/
+	static StartupStatistics startupStatistics_ = { {}, {}, { -1.0, -1.0 } };
+
+	/**
+	* \brief Начало отсчета (время первого замера)
+	*/
+	static StartupClock::time_point startupOrigin_;
+
+	/**
+	* \brief Начат ли отсчет
+	*/
+	static bool startupStarted_ = false;
+
+	/**
+	* \brief Текущий (самый вложенный) замер
+	*/
+	static StartupTimer* activeStartupTimer_ = nullptr;
+
+	/**
+	* \brief Начать замер этапа
+	* \param phase Этап
+	*/
+	StartupTimer::StartupTimer(StartupPhase phase) :
+		phase_(phase),
+		outer_(activeStartupTimer_),
+		start_(StartupClock::now())
+	{
+		if (!startupStarted_)
+		{
+			startupOrigin_ = this->start_;
+			startupStarted_ = true;
+		}
+
+		if (this->outer_) {
+			startupStatistics_.phaseTime[this->outer_->phase_] += StartupMilliseconds(this->start_ - this->outer_->start_).count();
+		}
+
+		activeStartupTimer_ = this;
+	}
+
+	/**
+	* \brief Завершить замер
+	*/
+	StartupTimer::~StartupTimer()
+	{
+		const StartupClock::time_point now = StartupClock::now();
+		startupStatistics_.phaseTime[this->phase_] += StartupMilliseconds(now - this->start_).count();
+		startupStatistics_.phaseCount[this->phase_]++;
+
+		activeStartupTimer_ = this->outer_;
+		if (this->outer_) this->outer_->start_ = now;
+	}
+
+	/**
+	* \brief Отметить событие запуска
+	* \param event Событие
+	*/
+	void MarkStartupEvent(StartupEvent event)
+	{
+		if (startupStatistics_.eventTime[event] >= 0.0) return;
+
+		const StartupClock::time_point now = StartupClock::now();
+		if (!startupStarted_)
+		{
+			startupOrigin_ = now;
+			startupStarted_ = true;
+		}
+
+		startupStatistics_.eventTime[event] = StartupMilliseconds(now - startupOrigin_).count();
+	}
+
+	/**
+	* \brief Получить статистику запуска
+	* \return Статистика
+	*/
+	const StartupStatistics& GetStartupStatistics()
+	{
+		return startupStatistics_;
+	}
+
+	/**
+	* \brief Сбросить статистику запуска
+	*/
+	void ResetStartupStatistics()
+	{
+		startupStatistics_ = { {}, {}, { -1.0, -1.0 } };
+		startupStarted_ = false;
+	}
+
+	/**
+	* \brief Получить наименование этапа запуска
+	* \param phase Этап
+	* \return Наименование
+	*/
+	const char* GetStartupPhaseName(StartupPhase phase)
+	{
+		switch (phase)
+		{
+		case STARTUP_PHASE_BEGIN: return "begin";
+		case STARTUP_PHASE_WINDOW_CONSTRUCTION: return "window-construction";
+		case STARTUP_PHASE_CONTROL_CONSTRUCTION: return "control-construction";
+		case STARTUP_PHASE_WINDOW_CREATION: return "window-creation";
+		case STARTUP_PHASE_CONTROL_CREATION: return "control-creation";
+		default: return "unknown";
+		}
+	}
+}
@@ -9,6 +9,7 @@
 
 #include <wquery/stdafx.h>
 #include <wquery/tools/text.h>
+#include <wquery/tools/utf.h>
 
 namespace wquery
 {
@@ -22,10 +23,29 @@ namespace wquery
 	std::wstring StrToWide(const std::string& str, const UINT codePage, const DWORD dwFlags)
 	{
 		std::wstring result;
-		wchar_t* newString = new wchar_t[str.length() + 1];
-		MultiByteToWideChar(codePage, dwFlags, str.c_str(), static_cast<int>(str.length()) + 1, newString, static_cast<int>(str.length()) + 1);
-		result.append(newString);
-		delete[] newString;
+		if (str.empty()) return result;
+
+#ifdef _WIN32
+		// UTF-8 перекодируется собственными средствами (без обращения к системе)
+		if (codePage == CP_UTF8 && Utf8ToWide(str.data(), str.size(), result)) return result;
+
+		// Размер результата запрашивается у системы, затем запись идет прямо в строку.
+		// Для UTF-8 (некорректные данные) флаги должны быть нулевыми - система заменит ошибочные символы
+		const DWORD flags = codePage == CP_UTF8 ? 0 : dwFlags;
+		const int required = MultiByteToWideChar(codePage, flags, str.data(), static_cast<int>(str.size()), nullptr, 0);
+		if (required > 0)
+		{
+			result.resize(static_cast<size_t>(required));
+			MultiByteToWideChar(codePage, flags, str.data(), static_cast<int>(str.size()), &result[0], required);
+		}
+#else
+		// Вне Windows кодовых страниц нет - текст считается UTF-8, некорректные данные расширяются побайтно
+		if (!Utf8ToWide(str.data(), str.size(), result))
+		{
+			result.resize(str.size());
+			for (size_t i = 0; i < str.size(); i++) result[i] = CharToWide(str[i], codePage, dwFlags);
+		}
+#endif
 		return result;
 	}
 
@@ -39,10 +59,29 @@ namespace wquery
 	std::string WideToStr(const std::wstring& wstr, const UINT codePage, const DWORD dwFlags)
 	{
 		std::string result;
-		char* newString = new char[wstr.length() + 1];
-		WideCharToMultiByte(codePage, dwFlags, wstr.c_str(), static_cast<int>(wstr.length()) + 1, newString, static_cast<int>(wstr.length()) + 1, NULL, FALSE);
-		result.append(newString);
-		delete[] newString;
+		if (wstr.empty()) return result;
+
+#ifdef _WIN32
+		// UTF-8 перекодируется собственными средствами (без обращения к системе)
+		if (codePage == CP_UTF8 && WideToUtf8(wstr.data(), wstr.size(), result)) return result;
+
+		// Размер результата запрашивается у системы, затем запись идет прямо в строку.
+		// Для UTF-8 флаги должны быть нулевыми
+		const DWORD flags = codePage == CP_UTF8 ? 0 : dwFlags;
+		const int required = WideCharToMultiByte(codePage, flags, wstr.data(), static_cast<int>(wstr.size()), nullptr, 0, NULL, FALSE);
+		if (required > 0)
+		{
+			result.resize(static_cast<size_t>(required));
+			WideCharToMultiByte(codePage, flags, wstr.data(), static_cast<int>(wstr.size()), &result[0], required, NULL, FALSE);
+		}
+#else
+		// Вне Windows кодовых страниц нет - текст перекодируется в UTF-8, некорректные данные сужаются побайтно
+		if (!WideToUtf8(wstr.data(), wstr.size(), result))
+		{
+			result.resize(wstr.size());
+			for (size_t i = 0; i < wstr.size(); i++) result[i] = WideToChar(wstr[i], codePage, dwFlags);
+		}
+#endif
 		return result;
 	}
 
@@ -53,11 +92,15 @@ namespace wquery
 	* \param dwFlags Тип конвертации (как конвертировать простые символы в составные)
 	* \return UTF-16 строка
 	*/
-	wchar_t CharToWide(char symbol, const UINT codePage, const DWORD dwFlags)
+	wchar_t CharToWide(char symbol, [[maybe_unused]] const UINT codePage, [[maybe_unused]] const DWORD dwFlags)
 	{
+#ifdef _WIN32
 		wchar_t newChar;
 		MultiByteToWideChar(codePage, dwFlags, &symbol, 1, &newChar, 1);
 		return newChar;
+#else
+		return static_cast<wchar_t>(static_cast<unsigned char>(symbol));
+#endif
 	}
 
 	/**
@@ -67,10 +110,14 @@ namespace wquery
 	* \param dwFlags Тип конвертации (как конвертировать составные символы в простые)
 	* \return UTF-8 строка
 	*/
-	char WideToChar(wchar_t wsymbol, const UINT codePage, const DWORD dwFlags)
+	char WideToChar(wchar_t wsymbol, [[maybe_unused]] const UINT codePage, [[maybe_unused]] const DWORD dwFlags)
 	{
+#ifdef _WIN32
 		char newChar;
 		WideCharToMultiByte(codePage, dwFlags, &wsymbol, 1, &newChar, 1, NULL, FALSE);
 		return newChar;
+#else
+		return wsymbol < 0x100 ? static_cast<char>(wsymbol) : '?';
+#endif
 	}
 }
@@ -0,0 +1,507 @@
+﻿/**
+* \brief Перекодирование UTF-8 <-> UTF-16 (реализация)
+*/
+
+#include <wquery/stdafx.h>
+#include <wquery/tools/utf.h>
+#include <wquery/tools/cpu.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WQUERY_UTF_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define WQUERY_TARGET_AVX2
+#else
+#define WQUERY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace wquery
+{
+	/*
+	* О П Р Е Д Е Л Е Н И Е  Н А Б О Р А  И Н С Т Р У К Ц И Й
+	*/
+
+	/**
+	* \brief Определить лучший набор инструкций, поддерживаемый процессором и системой
+	* \return Набор инструкций
+	*/
+	static UtfKernel DetectUtfKernel()
+	{
+		if (HasCpuFeature(CPU_FEATURE_AVX2)) return UTF_KERNEL_AVX2;
+		if (HasCpuFeature(CPU_FEATURE_SSE2)) return UTF_KERNEL_SSE2;
+		return UTF_KERNEL_SCALAR;
+	}
+
+	/**
+	* \brief Лучший поддерживаемый набор инструкций
+	*/
+	static const UtfKernel supportedKernel_ = DetectUtfKernel();
+
+	/**
+	* \brief Текущий набор инструкций
+	*/
+	static UtfKernel kernel_ = supportedKernel_;
+
+	/**
+	* \brief Получить текущий набор инструкций
+	* \return Набор инструкций
+	*/
+	UtfKernel GetUtfKernel()
+	{
+		return kernel_;
+	}
+
+	/**
+	* \brief Выбрать набор инструкций
+	* \param kernel Набор инструкций
+	* \return Поддерживается ли он процессором
+	*/
+	bool SetUtfKernel(UtfKernel kernel)
+	{
+		if (kernel > supportedKernel_) return false;
+		kernel_ = kernel;
+		return true;
+	}
+
+	/**
+	* \brief Получить наименование набора инструкций
+	* \param kernel Набор инструкций
+	* \return Строка
+	*/
+	const char* GetUtfKernelName(UtfKernel kernel)
+	{
+		switch (kernel)
+		{
+		case UTF_KERNEL_SSE2: return "sse2";
+		case UTF_KERNEL_AVX2: return "avx2";
+		default: return "scalar";
+		}
+	}
+
+	/*
+	* В Е К Т О Р Н Ы Е  У Ч А С Т К И  (A S C I I)
+	*/
+
+#ifdef WQUERY_UTF_X86
+	/**
+	* \brief Расширить ASCII-байты до 16-битных элементов блоками по 16 байт (SSE2)
+	* \param src Исходные данные
+	* \param length Длина
+	* \param dst Выходной буфер
+	* \return Кол-во обработанных байт (обработка прекращается на первом блоке с не-ASCII байтом)
+	*/
+	template <typename Unit>
+	static size_t WidenAsciiSse2(const unsigned char* src, size_t length, Unit* dst)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+
+		for (; i + 16 <= length; i += 16)
+		{
+			const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			if (_mm_movemask_epi8(bytes) != 0) break;
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(bytes, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(bytes, zero));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Расширить ASCII-байты до 16-битных элементов блоками по 32 байта (AVX2)
+	* \param src Исходные данные
+	* \param length Длина
+	* \param dst Выходной буфер
+	* \return Кол-во обработанных байт
+	*/
+	template <typename Unit>
+	WQUERY_TARGET_AVX2 static size_t WidenAsciiAvx2(const unsigned char* src, size_t length, Unit* dst)
+	{
+		size_t i = 0;
+
+		for (; i + 32 <= length; i += 32)
+		{
+			const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			if (_mm256_movemask_epi8(bytes) != 0) break;
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Сузить 16-битные ASCII-элементы до байтов блоками по 16 элементов (SSE2)
+	* \param src Исходные данные
+	* \param length Длина в элементах
+	* \param dst Выходной буфер
+	* \return Кол-во обработанных элементов (обработка прекращается на первом блоке с не-ASCII элементом)
+	*/
+	template <typename Unit>
+	static size_t NarrowAsciiSse2(const Unit* src, size_t length, unsigned char* dst)
+	{
+		const __m128i mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+
+		for (; i + 16 <= length; i += 16)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+			const __m128i high = _mm_and_si128(_mm_or_si128(a, b), mask);
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF) break;
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+		}
+
+		return i;
+	}
+
+	/**
+	* \brief Сузить 16-битные ASCII-элементы до байтов блоками по 32 элемента (AVX2)
+	* \param src Исходные данные
+	* \param length Длина в элементах
+	* \param dst Выходной буфер
+	* \return Кол-во обработанных элементов
+	*/
+	template <typename Unit>
+	WQUERY_TARGET_AVX2 static size_t NarrowAsciiAvx2(const Unit* src, size_t length, unsigned char* dst)
+	{
+		const __m256i mask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+		size_t i = 0;
+
+		for (; i + 32 <= length; i += 32)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16));
+			if (!_mm256_testz_si256(_mm256_or_si256(a, b), mask)) break;
+
+			// Упаковка работает в пределах 128-битных половин, порядок восстанавливается перестановкой
+			const __m256i packed = _mm256_packus_epi16(a, b);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(packed, 0xD8));
+		}
+
+		return i;
+	}
+#endif
+
+	/**
+	* \brief Обработать ASCII-участок в начале данных текущим набором инструкций (UTF-8 -> UTF-16)
+	* \param src Исходные данные
+	* \param length Длина
+	* \param dst Выходной буфер
+	* \return Кол-во обработанных байт
+	*/
+	template <typename Unit>
+	static size_t WidenAscii(const unsigned char* src, size_t length, Unit* dst)
+	{
+#ifdef WQUERY_UTF_X86
+		if (sizeof(Unit) == 2)
+		{
+			if (kernel_ == UTF_KERNEL_AVX2) return WidenAsciiAvx2(src, length, dst);
+			if (kernel_ == UTF_KERNEL_SSE2) return WidenAsciiSse2(src, length, dst);
+		}
+#endif
+		return 0;
+	}
+
+	/**
+	* \brief Обработать ASCII-участок в начале данных текущим набором инструкций (UTF-16 -> UTF-8)
+	* \param src Исходные данные
+	* \param length Длина в элементах
+	* \param dst Выходной буфер
+	* \return Кол-во обработанных элементов
+	*/
+	template <typename Unit>
+	static size_t NarrowAscii(const Unit* src, size_t length, unsigned char* dst)
+	{
+#ifdef WQUERY_UTF_X86
+		if (sizeof(Unit) == 2)
+		{
+			if (kernel_ == UTF_KERNEL_AVX2) return NarrowAsciiAvx2(src, length, dst);
+			if (kernel_ == UTF_KERNEL_SSE2) return NarrowAsciiSse2(src, length, dst);
+		}
+#endif
+		return 0;
+	}
+
+	/*
+	* П Е Р Е К О Д И Р О В А Н И Е
+	*/
+
+	/**
+	* \brief Перекодировать UTF-8 в UTF-16 (элемент 2 байта) или UTF-32 (элемент 4 байта)
+	* \param src Исходные данные
+	* \param length Длина в байтах
+	* \param dst Выходной буфер (не менее length элементов)
+	* \return Кол-во записанных элементов (UTF_INVALID если данные некорректны)
+	*/
+	template <typename Unit>
+	static size_t DecodeUtf8(const char* src, size_t length, Unit* dst)
+	{
+		const unsigned char * s = reinterpret_cast<const unsigned char*>(src);
+		size_t i = 0;
+		size_t o = 0;
+
+		while (i < length)
+		{
+			// Векторная обработка ASCII-участка (позиции входа и выхода совпадают со сдвигом o - i)
+			const size_t ascii = WidenAscii(s + i, length - i, dst + o);
+			i += ascii;
+			o += ascii;
+
+			// Скалярная обработка до конца блока, на котором остановилась векторная часть
+			const size_t stop = (std::min)(length, i + 32);
+
+			while (i < stop)
+			{
+				const unsigned int b0 = s[i];
+
+				if (b0 < 0x80)
+				{
+					dst[o++] = static_cast<Unit>(b0);
+					i++;
+					continue;
+				}
+
+				unsigned int codePoint;
+				size_t sequence;
+
+				// Первый байт определяет длину последовательности, допустимые диапазоны второго байта
+				// исключают избыточные (overlong) формы, суррогаты и значения больше U+10FFFF
+				if (b0 < 0xC2) return UTF_INVALID;
+				if (b0 < 0xE0)
+				{
+					if (i + 1 >= length || (s[i + 1] & 0xC0) != 0x80) return UTF_INVALID;
+					codePoint = ((b0 & 0x1F) << 6) | (s[i + 1] & 0x3F);
+					sequence = 2;
+				}
+				else if (b0 < 0xF0)
+				{
+					if (i + 2 >= length) return UTF_INVALID;
+					const unsigned int b1 = s[i + 1];
+					const unsigned int low = b0 == 0xE0 ? 0xA0 : 0x80;
+					const unsigned int high = b0 == 0xED ? 0x9F : 0xBF;
+					if (b1 < low || b1 > high || (s[i + 2] & 0xC0) != 0x80) return UTF_INVALID;
+					codePoint = ((b0 & 0x0F) << 12) | ((b1 & 0x3F) << 6) | (s[i + 2] & 0x3F);
+					sequence = 3;
+				}
+				else if (b0 < 0xF5)
+				{
+					if (i + 3 >= length) return UTF_INVALID;
+					const unsigned int b1 = s[i + 1];
+					const unsigned int low = b0 == 0xF0 ? 0x90 : 0x80;
+					const unsigned int high = b0 == 0xF4 ? 0x8F : 0xBF;
+					if (b1 < low || b1 > high || (s[i + 2] & 0xC0) != 0x80 || (s[i + 3] & 0xC0) != 0x80) return UTF_INVALID;
+					codePoint = ((b0 & 0x07) << 18) | ((b1 & 0x3F) << 12) | ((s[i + 2] & 0x3F) << 6) | (s[i + 3] & 0x3F);
+					sequence = 4;
+				}
+				else
+				{
+					return UTF_INVALID;
+				}
+
+				// Символы вне базовой плоскости в UTF-16 записываются суррогатной парой
+				if (sizeof(Unit) == 2 && codePoint >= 0x10000)
+				{
+					codePoint -= 0x10000;
+					dst[o++] = static_cast<Unit>(0xD800 | (codePoint >> 10));
+					dst[o++] = static_cast<Unit>(0xDC00 | (codePoint & 0x3FF));
+				}
+				else
+				{
+					dst[o++] = static_cast<Unit>(codePoint);
+				}
+
+				i += sequence;
+			}
+		}
+
+		return o;
+	}
+
+	/**
+	* \brief Перекодировать UTF-16 (элемент 2 байта) или UTF-32 (элемент 4 байта) в UTF-8
+	* \param src Исходные данные
+	* \param length Длина в элементах
+	* \param dst Выходной буфер (не менее length * 3 байт)
+	* \return Кол-во записанных байт (UTF_INVALID если данные некорректны)
+	*/
+	template <typename Unit>
+	static size_t EncodeUtf8(const Unit* src, size_t length, char* dst)
+	{
+		unsigned char * d = reinterpret_cast<unsigned char*>(dst);
+		size_t i = 0;
+		size_t o = 0;
+
+		while (i < length)
+		{
+			const size_t ascii = NarrowAscii(src + i, length - i, d + o);
+			i += ascii;
+			o += ascii;
+
+			const size_t stop = (std::min)(length, i + 32);
+
+			while (i < stop)
+			{
+				unsigned int codePoint = static_cast<unsigned int>(src[i]);
+
+				if (codePoint < 0x80)
+				{
+					d[o++] = static_cast<unsigned char>(codePoint);
+					i++;
+					continue;
+				}
+
+				if (codePoint < 0x800)
+				{
+					d[o++] = static_cast<unsigned char>(0xC0 | (codePoint >> 6));
+					d[o++] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+					i++;
+					continue;
+				}
+
+				if ((codePoint & 0xFFFFF800) == 0xD800)
+				{
+					// Суррогат допустим только в UTF-16 и только как старшая часть пары с последующей младшей
+					if (sizeof(Unit) != 2 || codePoint > 0xDBFF || i + 1 >= length) return UTF_INVALID;
+					const unsigned int low = static_cast<unsigned int>(src[i + 1]);
+					if ((low & 0xFFFFFC00) != 0xDC00) return UTF_INVALID;
+
+					codePoint = 0x10000 + (((codePoint & 0x3FF) << 10) | (low & 0x3FF));
+					i++;
+				}
+				else if (codePoint > 0x10FFFF)
+				{
+					return UTF_INVALID;
+				}
+
+				if (codePoint < 0x10000)
+				{
+					d[o++] = static_cast<unsigned char>(0xE0 | (codePoint >> 12));
+					d[o++] = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+					d[o++] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+				}
+				else
+				{
+					d[o++] = static_cast<unsigned char>(0xF0 | (codePoint >> 18));
+					d[o++] = static_cast<unsigned char>(0x80 | ((codePoint >> 12) & 0x3F));
+					d[o++] = static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F));
+					d[o++] = static_cast<unsigned char>(0x80 | (codePoint & 0x3F));
+				}
+
+				i++;
+			}
+		}
+
+		return o;
+	}
+
+	/**
+	* \brief Перекодировать UTF-8 в UTF-16
+	* \param src Исходные данные
+	* \param length Длина в байтах
+	* \param dst Выходной буфер (не менее length элементов)
+	* \return Кол-во записанных элементов UTF-16 (UTF_INVALID если данные некорректны)
+	*/
+	size_t Utf8ToUtf16(const char* src, size_t length, char16_t* dst)
+	{
+		return DecodeUtf8(src, length, dst);
+	}
+
+	/**
+	* \brief Перекодировать UTF-16 в UTF-8
+	* \param src Исходные данные
+	* \param length Длина в элементах UTF-16
+	* \param dst Выходной буфер (не менее length * 3 байт)
+	* \return Кол-во записанных байт (UTF_INVALID если данные некорректны)
+	*/
+	size_t Utf16ToUtf8(const char16_t* src, size_t length, char* dst)
+	{
+		return EncodeUtf8(src, length, dst);
+	}
+
+	/**
+	* \brief Посчитать длину корректной UTF-8 строки в элементах UTF-16 (без перекодирования)
+	* \param src Исходные данные (должны быть корректны)
+	* \param length Длина в байтах
+	* \return Кол-во элементов UTF-16
+	*/
+	size_t Utf16LengthOfUtf8(const char* src, size_t length)
+	{
+		const unsigned char * s = reinterpret_cast<const unsigned char*>(src);
+		size_t units = 0;
+
+		// Каждый байт, кроме байтов продолжения, начинает символ; 4-байтовые символы занимают суррогатную пару
+		for (size_t i = 0; i < length; i++)
+		{
+			units += (s[i] & 0xC0) != 0x80;
+			units += s[i] >= 0xF0;
+		}
+
+		return units;
+	}
+
+	/**
+	* \brief Перекодировать UTF-8 строку в UTF-16 строку
+	* \param src Исходная строка
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool Utf8ToUtf16(std::string_view src, std::u16string& dst)
+	{
+		// Строка получает наибольший возможный размер, запись идет прямо в нее, затем размер уточняется
+		dst.resize(src.size());
+		const size_t written = DecodeUtf8(src.data(), src.size(), &dst[0]);
+		dst.resize(written != UTF_INVALID ? written : 0);
+		return written != UTF_INVALID;
+	}
+
+	/**
+	* \brief Перекодировать UTF-16 строку в UTF-8 строку
+	* \param src Исходная строка
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool Utf16ToUtf8(std::u16string_view src, std::string& dst)
+	{
+		dst.resize(src.size() * 3);
+		const size_t written = EncodeUtf8(src.data(), src.size(), &dst[0]);
+		dst.resize(written != UTF_INVALID ? written : 0);
+		return written != UTF_INVALID;
+	}
+
+	/**
+	* \brief Перекодировать UTF-8 в "широкую" строку
+	* \param src Исходные данные
+	* \param length Длина в байтах
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool Utf8ToWide(const char* src, size_t length, std::wstring& dst)
+	{
+		dst.resize(length);
+		const size_t written = DecodeUtf8(src, length, &dst[0]);
+		dst.resize(written != UTF_INVALID ? written : 0);
+		return written != UTF_INVALID;
+	}
+
+	/**
+	* \brief Перекодировать "широкую" строку в UTF-8
+	* \param src Исходные данные
+	* \param length Длина в элементах wchar_t
+	* \param dst Результирующая строка (при ошибке - пустая)
+	* \return Корректны ли исходные данные
+	*/
+	bool WideToUtf8(const wchar_t* src, size_t length, std::string& dst)
+	{
+		// В UTF-32 один элемент может занимать 4 байта UTF-8, в UTF-16 - не более 3 (4 байта на пару)
+		dst.resize(length * (sizeof(wchar_t) == 2 ? 3 : 4));
+		const size_t written = EncodeUtf8(src, length, &dst[0]);
+		dst.resize(written != UTF_INVALID ? written : 0);
+		return written != UTF_INVALID;
+	}
+}
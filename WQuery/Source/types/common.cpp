@@ -8,6 +8,7 @@
 
 #include <wquery/stdafx.h>
 #include <wquery/types/common.h>
+#include <wquery/platform/GdiCache.h>
 
 namespace wquery
 {
@@ -20,8 +21,25 @@ namespace wquery
 	* \param r Компонента красного цвета
 	* \param g Компонента зеленого цвета
 	* \param b Компонента синего цвета
+	* \param a Непрозрачность
 	*/
-	ColorRGB::ColorRGB(const unsigned char r, const unsigned char g, const unsigned char b) :R(r), G(g), B(b) {}
+	ColorRGB::ColorRGB(const unsigned char r, const unsigned char g, const unsigned char b, const unsigned char a) :R(r), G(g), B(b), A(a) {}
+
+	/**
+	* \brief Получить цвет в premultiplied-форме
+	* \return Пиксель 0xAARRGGBB
+	*/
+	std::uint32_t ColorRGB::GetPremultiplied() const
+	{
+		// Умножение с делением на 255 и округлением (как в растровых функциях)
+		const auto multiply = [this](unsigned char component) -> std::uint32_t
+		{
+			const std::uint32_t value = static_cast<std::uint32_t>(component) * this->A + 128;
+			return (value + (value >> 8)) >> 8;
+		};
+
+		return (static_cast<std::uint32_t>(this->A) << 24) | (multiply(this->R) << 16) | (multiply(this->G) << 8) | multiply(this->B);
+	}
 
 	/**
 	* \brief Получить хендл системной (Winapi) кисти
@@ -29,7 +47,7 @@ namespace wquery
 	*/
 	HBRUSH ColorRGB::GetNativeBrush() const
 	{
-		return CreateSolidBrush(RGB(this->R, this->G, this->B));
+		return GetGdiCache().AcquireBrush(*this);
 	}
 
 	/**
@@ -63,4 +81,24 @@ namespace wquery
 	{
 		return this->left || this->bottom || this->right || this->top;
 	}
+
+	/*
+	* Ц И К Л  С  Ф И К С И Р О В А Н Н О Й  Ч А С Т О Т О Й  К А Д Р О В
+	*/
+
+	/**
+	* \brief Конструктор по умолчанию
+	* \param inTargetFps Целевая частота кадров
+	* \param inFixedTimestep Фиксированный шаг
+	* \param inMaxCatchUpSteps Максимум вызовов за кадр при наверстывании
+	* \param inIdleFramesBeforeBackoff Кол-во кадров простоя до увеличения интервала (0 - не увеличивать)
+	* \param inMaxIdleInterval Максимальный интервал при простое (мс)
+	*/
+	FrameLoopSettings::FrameLoopSettings(unsigned int inTargetFps, bool inFixedTimestep, unsigned int inMaxCatchUpSteps,
+		unsigned int inIdleFramesBeforeBackoff, unsigned int inMaxIdleInterval) :
+		targetFps(inTargetFps),
+		fixedTimestep(inFixedTimestep),
+		maxCatchUpSteps(inMaxCatchUpSteps),
+		idleFramesBeforeBackoff(inIdleFramesBeforeBackoff),
+		maxIdleInterval(inMaxIdleInterval) {}
 }
@@ -12,54 +12,313 @@
 namespace wquery
 {
 	/**
-	* \brief Глобальный хендл приложения, инициализируется в методе wquery::Begin()
-	* \see wquery.cpp
+	* \brief Параметры цикла с фиксированной частотой кадров
 	*/
-	HINSTANCE hInstance_;
+	static FrameLoopSettings frameLoopSettings_;
 
 	/**
-	* \brief Глобальная структура параметров оконного класса, инициализируется в методе wquery::Begin()
-	* \see wquery.cpp
+	* \brief Статистика последнего завершенного кадра
 	*/
-	WNDCLASSEX classInfo_;
+	static FrameStatistics frameStatistics_ = {};
+
+	/**
+	* \brief Был ли запрошен кадр с полной частотой (\see wquery::RequestFrame)
+	*/
+	static std::atomic<bool> frameRequested_(false);
+
+	/**
+	* \brief Остаток ожидания кадра (мкс), который проводится в активном ожидании, а не во сне
+	* \details Пробуждение из сна запаздывает на величину порядка сотни микросекунд
+	*/
+	static const unsigned int frameSpinMicroseconds = 250;
+
+	/**
+	* \brief Задачи, переданные в поток основного цикла (\see wquery::Post)
+	*/
+	static TaskQueue postedTasks_;
+
+	/**
+	* \brief Отправлено ли сообщение пробуждения, разбор по которому еще не начался
+	*/
+	static std::atomic<bool> wakePending_(false);
+
+	/**
+	* \brief Максимальное кол-во задач, выполняемых за одно пробуждение
+	* \details Оставшиеся задачи выполняются после следующего пробуждения, чтобы поток задач не задерживал
+	* обработку сообщений окон
+	*/
+	static const size_t postedTaskBatch = 1024;
+
+	/**
+	* \brief Разбудить основной цикл для разбора переданных задач, если пробуждение еще не отправлено
+	* \details Сообщение пробуждения посылает только поток, первым установивший флаг. Если сообщение
+	* поместить не удалось (до Begin у бэкенда может не быть получателя), флаг снимается - иначе
+	* последующие задачи никогда не разбудили бы цикл
+	*/
+	static void WakeLoop()
+	{
+		if (wakePending_.exchange(true, std::memory_order_acq_rel)) return;
+
+		if (!GetBackend().Wake()) {
+			wakePending_.store(false, std::memory_order_release);
+		}
+	}
+
+	/**
+	* \brief Выполнить пакет переданных задач (вызывается бэкендом в потоке цикла при пробуждении)
+	*/
+	static void RunPostedTasks()
+	{
+		// Флаг снимается до разбора: задача, добавленная после этого, снова разбудит цикл.
+		// Обмен (а не запись) синхронизируется с обменом в Post, поэтому задачи, добавленные
+		// до снятия флага, гарантированно видны при разборе
+		wakePending_.exchange(false, std::memory_order_acq_rel);
+
+		WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_LOOP_POSTED_TASKS);
+
+		// Исключение задачи не должно выйти за пределы функции пробуждения: она вызывается из оконной
+		// процедуры системы. Оно пробрасывается основным циклом, как исключение задачи сопрограммы,
+		// а оставшиеся задачи выполняются после следующего пробуждения
+		bool rearm;
+		try {
+			rearm = postedTasks_.Drain(postedTaskBatch) == postedTaskBatch;
+		}
+		catch (...) {
+			SetUnhandledCoroutineException(std::current_exception());
+			rearm = true;
+		}
+
+		if (rearm && !postedTasks_.IsEmpty()) {
+			WakeLoop();
+		}
+	}
+
+	/**
+	* \brief Получить окно WQuery, которому (или элементу которого) было адресовано сообщение
+	* \details Данные пользователя элемента управления указывают на ControlBase, а не на Window, а адресат
+	* может быть уже уничтожен к моменту вызова (тогда данных у хендла нет)
+	* \param backend Платформенный слой
+	* \param hWnd Хендл адресата сообщения
+	* \return Указатель на окно (nullptr если окна нет)
+	*/
+	static Window* GetMessageWindow(Backend& backend, HWND hWnd)
+	{
+		void* data = hWnd ? backend.GetUserData(hWnd) : nullptr;
+		if (!data) return nullptr;
+
+		if (backend.IsWindowHandle(hWnd)) return static_cast<Window*>(data);
+		return static_cast<ControlBase*>(data)->GetWindow();
+	}
+
+	/**
+	* \brief Вызывать таймеры, пока в очереди не появится сообщение (или пока не появятся готовые к продолжению сопрограммы)
+	* \param backend Платформенный слой
+	* \return Есть ли запущенные таймеры или готовые сопрограммы (если нет - функция возвращается сразу,
+	* не дожидаясь сообщения)
+	*/
+	static bool WaitForMessageOrTimers(Backend& backend)
+	{
+		TimerWheel& timers = GetTimerWheel();
+		unsigned long long deadline;
+
+		// Перерисовки, запрошенные функциями таймеров, выполняются сразу после их вызова
+		timers.Advance(GetTimerClock());
+		Window::FlushPaint();
+
+		while (!HasPendingCoroutines(true) && timers.GetNextDeadline(deadline))
+		{
+			const unsigned long long now = GetTimerClock();
+			const unsigned long long timeout = deadline > now ? (deadline - now) * 1000 : 0;
+
+			if (backend.WaitForMessage(static_cast<unsigned int>((std::min<unsigned long long>)(timeout, 0xFFFFFFFFull)))) {
+				return true;
+			}
+
+			timers.Advance(GetTimerClock());
+			Window::FlushPaint();
+		}
+
+		return HasPendingCoroutines(true) || timers.GetCount() > 0;
+	}
+
+	/**
+	* \brief Цикл с фиксированной частотой кадров
+	* \param backend Платформенный слой
+	* \param frameCallback Функция кадра
+	*/
+	static void RunFramePacedLoop(Backend& backend, const std::function<void(Window * pWindow)>& frameCallback)
+	{
+		typedef std::chrono::steady_clock Clock;
+		typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+		const FrameLoopSettings settings = frameLoopSettings_;
+		const Clock::duration baseInterval = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(1.0 / (std::max)(settings.targetFps, 1u)));
+		const Clock::duration maxIdleInterval = (std::max)(baseInterval,
+			std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(settings.maxIdleInterval)));
+		const Clock::duration spin = std::chrono::microseconds(frameSpinMicroseconds);
+
+		Clock::duration interval = baseInterval;
+		Clock::time_point lastFrame = Clock::now();
+		Clock::time_point deadline = lastFrame;
+
+		// Накопленные с начала предыдущего кадра значения
+		Clock::duration dispatchTime(0);
+		Clock::duration waitTime(0);
+		unsigned int messageCount = 0;
+		unsigned int idleFrames = 0;
+		HWND lastTarget = nullptr;
+
+		frameStatistics_ = {};
+		frameRequested_ = false;
+		MSG msg = {};
+
+		TimerWheel& timers = GetTimerWheel();
+		unsigned long long timerDeadline = 0;
+
+		while (true)
+		{
+			// Сообщения обрабатываются сразу по приходу, но не дольше чем до начала кадра
+			// (непрерывный поток сообщений, например движений мыши, не должен задерживать кадры)
+			const Clock::time_point dispatchStart = Clock::now();
+			bool quit = false;
+
+			while (backend.PeekNextMessage(&msg))
+			{
+				if (msg.message == WM_QUIT) {
+					quit = true;
+					break;
+				}
+
+				backend.Dispatch(&msg);
+				lastTarget = msg.hwnd;
+				messageCount++;
+
+				if (Clock::now() >= deadline) {
+					break;
+				}
+			}
+
+			// Сработавшие таймеры, как и сообщения, считаются активностью (кадр не считается простоем)
+			if (timers.Advance(GetTimerClock()) > 0) {
+				frameRequested_ = true;
+			}
+
+			// Сопрограммы, ожидающие следующей итерации, продолжаются сразу (ожидающие кадра - в начале кадра)
+			ResumePendingCoroutines(false);
+			RethrowCoroutineException();
+
+			Clock::time_point now = Clock::now();
+			dispatchTime += now - dispatchStart;
+
+			if (quit) {
+				break;
+			}
+
+			// Сообщения после простоя возвращают исходный интервал, не дожидаясь отложенного кадра
+			if (messageCount > 0 && interval != baseInterval)
+			{
+				interval = baseInterval;
+				deadline = (std::min)(deadline, lastFrame + baseInterval);
+			}
+
+			if (now >= deadline)
+			{
+				const bool active = messageCount > 0 || frameRequested_.exchange(false);
+				idleFrames = active ? 0 : idleFrames + 1;
+				if (active) interval = baseInterval;
+
+				// При фиксированном шаге пропущенные кадры наверстываются (но не более maxCatchUpSteps за раз)
+				unsigned int steps = 1;
+				if (settings.fixedTimestep)
+				{
+					const auto behind = static_cast<unsigned long long>((now - deadline) / interval);
+					steps = static_cast<unsigned int>((std::min<unsigned long long>)(behind + 1, (std::max)(settings.maxCatchUpSteps, 1u)));
+				}
+
+				const Clock::time_point callbackStart = Clock::now();
+				Window::FlushMouseInput();
+				ResumePendingCoroutines(true);
+				if (frameCallback)
+				{
+					Window* pWindow = GetMessageWindow(backend, lastTarget);
+					WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_LOOP_CALLBACK);
+					for (unsigned int i = 0; i < steps; i++) frameCallback(pWindow);
+				}
+				Window::FlushPaint();
+				const Clock::time_point callbackEnd = Clock::now();
+
+				frameStatistics_.frameIndex++;
+				frameStatistics_.frameTime = Milliseconds(now - lastFrame).count();
+				frameStatistics_.dispatchTime = Milliseconds(dispatchTime).count();
+				frameStatistics_.callbackTime = Milliseconds(callbackEnd - callbackStart).count();
+				frameStatistics_.waitTime = Milliseconds(waitTime).count();
+				frameStatistics_.interval = Milliseconds(interval).count();
+				frameStatistics_.messageCount = messageCount;
+				frameStatistics_.steps = steps;
+				frameStatistics_.idle = !active;
+
+				// Расписание следующего кадра считается от запланированного времени, а не от фактического,
+				// чтобы частота не "плыла". Если отставание не наверстать - оно отбрасывается
+				deadline += interval * steps;
+				if (deadline <= now) deadline = now + interval;
+
+				// При затянувшемся простое интервал удваивается вплоть до максимального
+				if (settings.idleFramesBeforeBackoff > 0 && idleFrames >= settings.idleFramesBeforeBackoff)
+				{
+					const Clock::duration backoff = (std::min)(interval * 2, maxIdleInterval);
+					deadline += backoff - interval;
+					interval = backoff;
+				}
+
+				lastFrame = now;
+				lastTarget = nullptr;
+				dispatchTime = waitTime = Clock::duration(0);
+				messageCount = 0;
+				now = callbackEnd;
+			}
+
+			// Сон до начала кадра или до прихода сообщения. Последние микросекунды ожидания проводятся
+			// в активном ожидании, поскольку пробуждение из сна неточно
+			// Сон прерывается и к сроку ближайшего таймера
+			Clock::time_point wakeup = deadline;
+			if (timers.GetNextDeadline(timerDeadline)) {
+				wakeup = (std::min)(wakeup, Clock::time_point(std::chrono::milliseconds(timerDeadline)));
+			}
+
+			if (now < wakeup && !HasPendingCoroutines(false))
+			{
+				const Clock::duration remaining = wakeup - now;
+
+				if (remaining > spin) {
+					const auto timeout = std::chrono::duration_cast<std::chrono::microseconds>(remaining - spin);
+					backend.WaitForMessage(static_cast<unsigned int>(timeout.count()));
+				}
+				else if (!backend.WaitForMessage(0)) {
+					std::this_thread::yield();
+				}
+
+				waitTime += Clock::now() - now;
+			}
+		}
+	}
 
 	/**
 	* \brief Своеобразная "процедурная скобка" с которой начинается взаимодействие с библиотекой
-	* \detail Функция регистрирует оконный клас и производит необходимые манипуляции
+	* \detail Функция регистрирует оконный клас (через текущий бэкенд) и производит необходимые манипуляции
 	* \param hInstance Хендл текущего приложения (модуля)
 	*/
 	void Begin(HINSTANCE hInstance)
 	{
-		const wchar_t * windowClassName = L"WQueryWndClass";
+		StartupTimer timer(STARTUP_PHASE_BEGIN);
 
-		// Попопытаться получить информацию об уже зарегистрированном классе
-		// окон WQuery. Если удалось - прервать выполнение (класс зарегистрирован)
-		WNDCLASSEX registeredClassInfo = {};
-		if (GetClassInfoEx(hInstance, windowClassName, &registeredClassInfo)) {
-			return;
-		}
+		GetBackend().RegisterWindowClass(hInstance, wquery::Window::WndProc, wquery::ColorRGB(240, 240, 240));
+		GetBackend().SetWakeHandler(&RunPostedTasks);
 
-		// Если хендл приложения не был передан - использовать хендл по умолчанию
-		hInstance_ = hInstance ? hInstance : GetModuleHandle(nullptr);
-
-		// Описать новый класс окон при помощи структуры
-		classInfo_ = {};
-		classInfo_.cbSize = sizeof(WNDCLASSEX);
-		classInfo_.style = CS_HREDRAW | CS_VREDRAW;
-		classInfo_.cbClsExtra = 0;
-		classInfo_.cbWndExtra = 0;
-		classInfo_.hInstance = hInstance_;
-		classInfo_.hIcon = LoadIcon(hInstance, IDI_APPLICATION);
-		classInfo_.hCursor = LoadCursor(nullptr, IDC_ARROW);
-		classInfo_.hbrBackground = wquery::ColorRGB(240, 240, 240).GetNativeBrush();
-		classInfo_.lpszMenuName = nullptr;
-		classInfo_.lpszClassName = windowClassName;
-		classInfo_.hIconSm = LoadIcon(hInstance, IDI_APPLICATION);
-		classInfo_.lpfnWndProc = wquery::Window::WndProc;
-
-		// Регистрация класса окна
-		if (!RegisterClassEx(&classInfo_)) {
-			throw std::runtime_error("Can't register new class");
+		// Задачи, переданные до Begin, могли не разбудить цикл (получателя пробуждения еще не было)
+		wakePending_.store(false, std::memory_order_release);
+		if (!postedTasks_.IsEmpty()) {
+			WakeLoop();
 		}
 	}
 
@@ -70,27 +329,52 @@ namespace wquery
 	*/
 	void End(const MainLoopType loopType, std::function<void(Window * pWindow)> afterIterationCallback)
 	{
+		// Платформенный слой, через который идет работа с очередью сообщений
+		Backend& backend = GetBackend();
+
 		// Структура с информацией о сообщении
 		MSG msg = {};
 
 		// В зависимости от типа основного цикла использованы разные подходы
 		// Если тип GET_MSG - будет реализован блокирующий подход (цикл приостанавливается до получения след. сообщения)
 		// Если тип PEEK_MSG - цикл постоянно работает и проверяет сообщения (перенаправляя окну в случае получения)
+		// Если тип FRAME_PACED - цикл спит до следующего кадра или сообщения, функция вызывается раз в кадр
 		switch (loopType)
 		{
 		case MainLoopType::GET_MSG:
-			while (GetMessage(&msg, nullptr, 0, 0))
+			while (true)
 			{
+				// Сопрограммы, вставшие в очередь при обработке предыдущего сообщения. Исключение задачи,
+				// запущенной через Spawn, пробрасывается здесь - между итерациями, а не из места ее продолжения
+				ResumePendingCoroutines(true);
+				RethrowCoroutineException();
+
+				// Накопленные движения мыши доставляются, когда очередь сообщений опустела
+				if (Window::HasPendingMouseInput() && !backend.WaitForMessage(0)) {
+					Window::FlushMouseInput();
+				}
+
+				// Перерисовки, запрошенные при обработке предыдущего сообщения, объединяются в одну на окно
+				Window::FlushPaint();
+
+				// Пока запущены таймеры, ожидание сообщения прерывается к сроку ближайшего из них
+				// (и сообщение извлекается без блокировки), без таймеров - обычное блокирующее ожидание
+				if (WaitForMessageOrTimers(backend)) {
+					if (!backend.PeekNextMessage(&msg)) continue;
+				}
+				else if (!backend.GetNextMessage(&msg)) {
+					break;
+				}
+
 				if (msg.message == WM_QUIT) {
 					break;
 				}
 
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
+				backend.Dispatch(&msg);
 
 				if (afterIterationCallback) {
-					Window* pWindow = reinterpret_cast<Window*>(GetWindowLongPtr(msg.hwnd, GWLP_USERDATA));
-					afterIterationCallback(pWindow);
+					WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_LOOP_CALLBACK);
+					afterIterationCallback(GetMessageWindow(backend, msg.hwnd));
 				}
 			}
 			break;
@@ -98,20 +382,113 @@ namespace wquery
 		case MainLoopType::PEEK_MSG:
 			while (true)
 			{
-				if (msg.message == WM_QUIT) {
-					break;
-				}
+				// Если сообщения не было, окна у итерации нет (а не окно давно обработанного сообщения)
+				HWND target = nullptr;
 
-				if (PeekMessage(&msg, nullptr, 0, 0, true)) {
-					TranslateMessage(&msg);
-					DispatchMessage(&msg);
+				if (backend.PeekNextMessage(&msg))
+				{
+					if (msg.message == WM_QUIT) {
+						break;
+					}
+
+					backend.Dispatch(&msg);
+					target = msg.hwnd;
 				}
 
+				GetTimerWheel().Advance(GetTimerClock());
+				ResumePendingCoroutines(true);
+				RethrowCoroutineException();
+				if (!target) Window::FlushMouseInput();
+
 				if (afterIterationCallback) {
-					Window* pWindow = reinterpret_cast<Window*>(GetWindowLongPtr(msg.hwnd, GWLP_USERDATA));
-					afterIterationCallback(pWindow);
+					WQUERY_INSTRUMENT_SECTION(INSTRUMENTED_LOOP_CALLBACK);
+					afterIterationCallback(GetMessageWindow(backend, target));
 				}
+
+				Window::FlushPaint();
 			}
+			break;
+
+		case MainLoopType::FRAME_PACED:
+			RunFramePacedLoop(backend, afterIterationCallback);
+			break;
 		}
 	}
+
+	/**
+	* \brief Задать параметры цикла с фиксированной частотой кадров
+	* \param settings Параметры
+	*/
+	void SetFrameLoopSettings(const FrameLoopSettings& settings)
+	{
+		frameLoopSettings_ = settings;
+	}
+
+	/**
+	* \brief Получить параметры цикла с фиксированной частотой кадров
+	* \return Параметры
+	*/
+	const FrameLoopSettings& GetFrameLoopSettings()
+	{
+		return frameLoopSettings_;
+	}
+
+	/**
+	* \brief Получить статистику последнего завершенного кадра
+	* \return Статистика
+	*/
+	const FrameStatistics& GetFrameStatistics()
+	{
+		return frameStatistics_;
+	}
+
+	/**
+	* \brief Запросить следующий кадр с полной частотой
+	*/
+	void RequestFrame()
+	{
+		frameRequested_ = true;
+	}
+
+	/**
+	* \brief Запустить однократный таймер
+	* \param delay Задержка (мс)
+	* \param callback Функция обратного вызова
+	* \return Идентификатор таймера
+	*/
+	TimerId SetTimeout(unsigned int delay, std::function<void()> callback)
+	{
+		return GetTimerWheel().Schedule(GetTimerClock() + delay, 0, std::move(callback));
+	}
+
+	/**
+	* \brief Запустить периодический таймер
+	* \param interval Период (мс)
+	* \param callback Функция обратного вызова
+	* \return Идентификатор таймера
+	*/
+	TimerId SetInterval(unsigned int interval, std::function<void()> callback)
+	{
+		return GetTimerWheel().Schedule(GetTimerClock() + interval, (std::max)(interval, 1u), std::move(callback));
+	}
+
+	/**
+	* \brief Остановить таймер
+	* \param id Идентификатор таймера
+	* \return Был ли таймер запущен
+	*/
+	bool CancelTimer(TimerId id)
+	{
+		return GetTimerWheel().Cancel(id);
+	}
+
+	/**
+	* \brief Передать задачу на выполнение в поток основного цикла
+	* \param task Задача
+	*/
+	void Post(std::function<void()> task)
+	{
+		postedTasks_.Push(std::move(task));
+		WakeLoop();
+	}
 }
\ No newline at end of file